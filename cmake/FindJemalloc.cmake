@@ -0,0 +1,23 @@
+# Locate jemalloc
+# This module defines
+#  JEMALLOC_FOUND
+#  JEMALLOC_LIBRARIES
+#  JEMALLOC_INCLUDE_DIR, where to find jemalloc/jemalloc.h
+
+find_path(JEMALLOC_INCLUDE_DIR jemalloc/jemalloc.h
+  HINTS
+    ENV JEMALLOC_DIR
+  PATH_SUFFIXES include
+)
+
+find_library(JEMALLOC_LIBRARIES
+  NAMES jemalloc
+  HINTS
+    ENV JEMALLOC_DIR
+  PATH_SUFFIXES lib
+)
+
+include(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(Jemalloc REQUIRED_VARS JEMALLOC_LIBRARIES JEMALLOC_INCLUDE_DIR)
+
+mark_as_advanced(JEMALLOC_INCLUDE_DIR JEMALLOC_LIBRARIES)
@@ -8,7 +8,14 @@ local function ServerSave()
 
 		saveServer()
 
-		if configManager.getBoolean(configKeys.SERVER_SAVE_CLEAN_MAP) then cleanMap() end
+		if configManager.getBoolean(configKeys.SERVER_SAVE_CLEAN_MAP) then
+			-- with the players still in, spread the clean so the game does not freeze
+			if closeAtServerSave then
+				cleanMap()
+			else
+				Game.startMapClean()
+			end
+		end
 
 		if closeAtServerSave then Game.setGameState(GAME_STATE_NORMAL) end
 	end
@@ -5,9 +5,19 @@ Quest = {}
 Quest.__index = Quest
 
 function Quest:register()
+	-- a script that runs again replaces its quests and keeps their ids
+	local oldMissions = {}
 	self.id = #quests + 1
+	for id, quest in ipairs(quests) do
+		if quest.name == self.name then
+			self.id = id
+			for _, mission in pairs(quest.missions) do oldMissions[#oldMissions + 1] = mission.id end
+			break
+		end
+	end
+
 	for _, mission in pairs(self.missions) do
-		mission.id = #missions + 1
+		mission.id = table.remove(oldMissions, 1) or #missions + 1
 		mission.questId = self.id
 		missions[mission.id] = setmetatable(mission, Mission)
 	end
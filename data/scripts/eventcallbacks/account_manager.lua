@@ -178,6 +178,7 @@ local function CreateCharacter(character, IP)
 		                          CHARACTER_DEFAULT.SKILL, CHARACTER_DEFAULT.SKILL,
 		                          CHARACTER_DEFAULT.SKILL))
 	if dbResult then
+		Game.clearLoginCache()
 		if not CREATE_CHARACTER_TABLE[IP] then
 			CREATE_CHARACTER_TABLE[IP] = timeNow + CREATE_CHARACTER_EXHAUST
 		end
@@ -469,6 +470,7 @@ local function banIp(player, days, reason)
 		         "INSERT INTO `ip_bans` (`ip`, `reason`, `banned_at`, `expires_at`, `banned_by`) VALUES (%d, %s, %d, %d, %d)",
 		         ip, db.escapeString(reason), timeNow, timeNow + (days * 86400),
 		         player:getGuid()))
+	Game.clearLoginCache()
 	return true
 end
 
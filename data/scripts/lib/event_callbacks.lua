@@ -102,7 +102,8 @@ local function register(self, triggerIndex)
 	events.maxn = #events + 1
 	events[events.maxn] = {
 		callback = callback,
-		triggerIndex = tonumber(triggerIndex) or 0
+		triggerIndex = tonumber(triggerIndex) or 0,
+		file = getLoadingScriptFile()
 	}
 
 	table.sort(events,
@@ -116,6 +117,20 @@ Event = setmetatable({
 	clear = function(self)
 		EventData = {}
 		for i = 1, autoID do EventData[i] = {maxn = 0} end
+	end,
+
+	-- drops the callbacks registered by file, so running it again does not add them twice
+	clearFile = function(self, file)
+		for i = 1, autoID do
+			local kept = {maxn = 0}
+			for _, event in ipairs(EventData[i]) do
+				if event.file ~= file then
+					kept.maxn = kept.maxn + 1
+					kept[kept.maxn] = event
+				end
+			end
+			EventData[i] = kept
+		end
 	end
 }, {
 	__call = function(self) return setmetatable({register = register}, EventMeta) end,
@@ -161,3 +176,6 @@ hasEvent = setmetatable({}, {
 
 -- For compatibility with the previous version.
 EventCallback = Event()
+
+-- called by /reload scripts before a changed file runs again and after a file was removed
+function onUnloadScriptFile(file) Event:clearFile(file) end
@@ -5,13 +5,7 @@ combat:setParameter(COMBAT_PARAM_DISPEL, CONDITION_PARALYZE)
 combat:setParameter(COMBAT_PARAM_TARGETCASTERORTOPMOST, true)
 combat:setParameter(COMBAT_PARAM_AGGRESSIVE, false)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 3.2) + 20
-	local max = (level / 5) + (magicLevel * 5.4) + 40
-	return min, max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 3.2, base = 20}, {level = 0.2, magicLevel = 5.4, base = 40})
 
 local spell = Spell(SPELL_RUNE)
 
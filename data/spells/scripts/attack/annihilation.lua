@@ -5,12 +5,6 @@ combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_WEAPONTYPE)
 combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setParameter(COMBAT_PARAM_USECHARGES, true)
 
-local function callback(player, skill, attack, factor)
-	local min = (player:getLevel() / 5) + (skill * attack * 0.06) + 13
-	local max = (player:getLevel() / 5) + (skill * attack * 0.14) + 34
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.SKILLVALUE, callback)
+combat:setLinearFormula({level = 0.2, skillAttack = 0.06, base = 13}, {level = 0.2, skillAttack = 0.14, base = 34})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -4,13 +4,7 @@ combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ICEAREA)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_ICE)
 combat:setArea(createCombatArea(AREA_CIRCLE3X3))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.2) + 7
-	local max = (level / 5) + (magicLevel * 2.85) + 16
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.2, base = 7}, {level = 0.2, magicLevel = 2.85, base = 16})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
@@ -5,12 +5,6 @@ combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setParameter(COMBAT_PARAM_USECHARGES, true)
 combat:setArea(createCombatArea(AREA_SQUARE1X1))
 
-local function callback(player, skill, attack, factor)
-	local min = (player:getLevel() / 5) + (skill * attack * 0.03) + 7
-	local max = (player:getLevel() / 5) + (skill * attack * 0.05) + 11
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.SKILLVALUE, callback)
+combat:setLinearFormula({level = 0.2, skillAttack = 0.03, base = 7}, {level = 0.2, skillAttack = 0.05, base = 11})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
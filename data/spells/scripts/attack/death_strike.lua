@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_DEATHDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_MORTAREA)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_DEATH)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.4) + 8
-	local max = (level / 5) + (magicLevel * 2.2) + 14
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.4, base = 8}, {level = 0.2, magicLevel = 2.2, base = 14})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
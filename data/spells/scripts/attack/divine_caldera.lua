@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_HOLYDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_HOLYAREA)
 combat:setArea(createCombatArea(AREA_CIRCLE3X3))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 5) + 25
-	local max = (level / 5) + (magicLevel * 6.2) + 45
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 5, base = 25}, {level = 0.2, magicLevel = 6.2, base = 45})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
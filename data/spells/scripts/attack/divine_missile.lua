@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_HOLYDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_HOLYDAMAGE)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_SMALLHOLY)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.9) + 8
-	local max = (level / 5) + (magicLevel * 3) + 18
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.9, base = 8}, {level = 0.2, magicLevel = 3, base = 18})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_ENERGYDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ENERGYHIT)
 combat:setArea(createCombatArea(AREA_BEAM5, AREADIAGONAL_BEAM5))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.8) + 11
-	local max = (level / 5) + (magicLevel * 3) + 19
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.8, base = 11}, {level = 0.2, magicLevel = 3, base = 19})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
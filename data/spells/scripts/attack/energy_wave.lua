@@ -4,12 +4,6 @@ combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ENERGYAREA)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_ENERGY)
 combat:setArea(createCombatArea(AREA_SQUAREWAVE5, AREADIAGONAL_SQUAREWAVE5))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 4.5) + 20
-	local max = (level / 5) + (magicLevel * 7.6) + 48
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 4.5, base = 20}, {level = 0.2, magicLevel = 7.6, base = 48})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
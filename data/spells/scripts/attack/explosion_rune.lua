@@ -5,13 +5,7 @@ combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_EXPLOSION)
 combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setArea(createCombatArea(AREA_CROSS1X1))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.6) + 9
-	local max = (level / 5) + (magicLevel * 3.2) + 19
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.6, base = 9}, {level = 0.2, magicLevel = 3.2, base = 19})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
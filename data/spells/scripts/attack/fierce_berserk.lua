@@ -5,12 +5,6 @@ combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setParameter(COMBAT_PARAM_USECHARGES, true)
 combat:setArea(createCombatArea(AREA_SQUARE1X1))
 
-local function callback(player, skill, attack, factor)
-	local min = (player:getLevel() / 5) + (skill * attack * 0.06) + 13
-	local max = (player:getLevel() / 5) + (skill * attack * 0.11) + 27
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.SKILLVALUE, callback)
+combat:setLinearFormula({level = 0.2, skillAttack = 0.06, base = 13}, {level = 0.2, skillAttack = 0.11, base = 27})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -3,13 +3,7 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_FIREDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_FIREATTACK)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_FIRE)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.8) + 12
-	local max = (level / 5) + (magicLevel * 3) + 17
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.8, base = 12}, {level = 0.2, magicLevel = 3, base = 17})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
@@ -5,12 +5,6 @@ combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setParameter(COMBAT_PARAM_USECHARGES, true)
 combat:setArea(createCombatArea(AREA_WAVE6, AREADIAGONAL_WAVE6))
 
-local function callback(player, skill, attack, factor)
-	local min = (player:getLevel() / 5) + (skill * attack * 0.04) + 11
-	local max = (player:getLevel() / 5) + (skill * attack * 0.08) + 21
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.SKILLVALUE, callback)
+combat:setLinearFormula({level = 0.2, skillAttack = 0.04, base = 11}, {level = 0.2, skillAttack = 0.08, base = 21})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_ENERGYDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ENERGYAREA)
 combat:setArea(createCombatArea(AREA_BEAM8))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 3.6) + 22
-	local max = (level / 5) + (magicLevel * 6) + 37
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 3.6, base = 22}, {level = 0.2, magicLevel = 6, base = 37})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -5,12 +5,6 @@ combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setParameter(COMBAT_PARAM_USECHARGES, true)
 combat:setArea(createCombatArea(AREA_CIRCLE3X3))
 
-local function callback(player, skill, attack, factor)
-	local min = (player:getLevel() / 5) + (skill * attack * 0.02) + 4
-	local max = (player:getLevel() / 5) + (skill * attack * 0.03) + 6
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.SKILLVALUE, callback)
+combat:setLinearFormula({level = 0.2, skillAttack = 0.02, base = 4}, {level = 0.2, skillAttack = 0.03, base = 6})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
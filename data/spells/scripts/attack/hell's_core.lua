@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_FIREDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_FIREAREA)
 combat:setArea(createCombatArea(AREA_CIRCLE5X5))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 8) + 50
-	local max = (level / 5) + (magicLevel * 12) + 75
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 8, base = 50}, {level = 0.2, magicLevel = 12, base = 75})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -3,13 +3,7 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_HOLYDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_HOLYAREA)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_HOLY)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 1.8) + 11
-	local max = (level / 5) + (magicLevel * 3.8) + 23
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 1.8, base = 11}, {level = 0.2, magicLevel = 3.8, base = 23})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
@@ -3,13 +3,7 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_ENERGYDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ENERGYHIT)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_ENERGY)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 0.4) + 3
-	local max = (level / 5) + (magicLevel * 0.8) + 5
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 0.4, base = 3}, {level = 0.2, magicLevel = 0.8, base = 5})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_ICEDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ICEATTACK)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_SMALLICE)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 2.8) + 16
-	local max = (level / 5) + (magicLevel * 4.4) + 28
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 2.8, base = 16}, {level = 0.2, magicLevel = 4.4, base = 28})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
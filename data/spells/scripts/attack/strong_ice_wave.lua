@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_ICEDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_ICEAREA)
 combat:setArea(createCombatArea(AREA_WAVE3))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 4.5) + 20
-	local max = (level / 5) + (magicLevel * 7.6) + 48
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 4.5, base = 20}, {level = 0.2, magicLevel = 7.6, base = 48})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -3,13 +3,7 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_DEATHDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_MORTAREA)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_SUDDENDEATH)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 4.3) + 32
-	local max = (level / 5) + (magicLevel * 7.4) + 48
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 4.3, base = 32}, {level = 0.2, magicLevel = 7.4, base = 48})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_EARTHDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_SMALLPLANTS)
 combat:setArea(createCombatArea(AREA_SQUAREWAVE5, AREADIAGONAL_SQUAREWAVE5))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 3.25) + 5
-	local max = (level / 5) + (magicLevel * 6.75) + 30
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 3.25, base = 5}, {level = 0.2, magicLevel = 6.75, base = 30})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
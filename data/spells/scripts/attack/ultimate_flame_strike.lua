@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_FIREDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_FIREATTACK)
 combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_FIRE)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 4.5) + 35
-	local max = (level / 5) + (magicLevel * 7.3) + 55
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 4.5, base = 35}, {level = 0.2, magicLevel = 7.3, base = 55})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
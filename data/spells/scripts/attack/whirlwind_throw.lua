@@ -5,12 +5,6 @@ combat:setParameter(COMBAT_PARAM_DISTANCEEFFECT, CONST_ANI_WEAPONTYPE)
 combat:setParameter(COMBAT_PARAM_BLOCKARMOR, true)
 combat:setParameter(COMBAT_PARAM_USECHARGES, true)
 
-local function callback(player, skill, attack, factor)
-	local min = (player:getLevel() / 5) + (skill * attack * 0.01) + 1
-	local max = (player:getLevel() / 5) + (skill * attack * 0.03) + 6
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.SKILLVALUE, callback)
+combat:setLinearFormula({level = 0.2, skillAttack = 0.01, base = 1}, {level = 0.2, skillAttack = 0.03, base = 6})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -3,12 +3,6 @@ combat:setParameter(COMBAT_PARAM_TYPE, COMBAT_EARTHDAMAGE)
 combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_SMALLPLANTS)
 combat:setArea(createCombatArea(AREA_CIRCLE6X6))
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 3) + 32
-	local max = (level / 5) + (magicLevel * 9) + 40
-	return -min, -max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 3, base = 32}, {level = 0.2, magicLevel = 9, base = 40})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
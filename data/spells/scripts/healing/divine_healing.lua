@@ -4,12 +4,6 @@ combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_MAGIC_BLUE)
 combat:setParameter(COMBAT_PARAM_DISPEL, CONDITION_PARALYZE)
 combat:setParameter(COMBAT_PARAM_AGGRESSIVE, false)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 6.9) + 40
-	local max = (level / 5) + (magicLevel * 13.2) + 82
-	return min, max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 6.9, base = 40}, {level = 0.2, magicLevel = 13.2, base = 82})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -4,13 +4,7 @@ combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_MAGIC_GREEN)
 combat:setParameter(COMBAT_PARAM_DISPEL, CONDITION_PARALYZE)
 combat:setParameter(COMBAT_PARAM_AGGRESSIVE, false)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 6.3) + 45
-	local max = (level / 5) + (magicLevel * 14.4) + 90
-	return min, max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 6.3, base = 45}, {level = 0.2, magicLevel = 14.4, base = 90})
 
 function onCastSpell(creature, variant)
 	creature:getPosition():sendMagicEffect(CONST_ME_MAGIC_BLUE)
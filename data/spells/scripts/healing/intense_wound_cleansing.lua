@@ -4,12 +4,6 @@ combat:setParameter(COMBAT_PARAM_EFFECT, CONST_ME_MAGIC_BLUE)
 combat:setParameter(COMBAT_PARAM_DISPEL, CONDITION_PARALYZE)
 combat:setParameter(COMBAT_PARAM_AGGRESSIVE, false)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 70) + 438
-	local max = (level / 5) + (magicLevel * 92) + 544
-	return min, max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 70, base = 438}, {level = 0.2, magicLevel = 92, base = 544})
 
 function onCastSpell(creature, variant) return combat:execute(creature, variant) end
@@ -5,13 +5,7 @@ combat:setParameter(COMBAT_PARAM_DISPEL, CONDITION_PARALYZE)
 combat:setParameter(COMBAT_PARAM_TARGETCASTERORTOPMOST, true)
 combat:setParameter(COMBAT_PARAM_AGGRESSIVE, false)
 
-local function callback(player, level, magicLevel)
-	local min = (level / 5) + (magicLevel * 7.3) + 42
-	local max = (level / 5) + (magicLevel * 12.4) + 90
-	return min, max
-end
-
-combat:setCallback(CallBackParam.LEVELMAGICVALUE, callback)
+combat:setLinearFormula({level = 0.2, magicLevel = 7.3, base = 42}, {level = 0.2, magicLevel = 12.4, base = 90})
 
 function onCastSpell(creature, variant, isHotkey)
 	return combat:execute(creature, variant)
@@ -26,6 +26,7 @@ function onSay(player, words, param)
 		"INSERT INTO `account_bans` (`account_id`, `reason`, `banned_at`, `expires_at`, `banned_by`) VALUES (" ..
 			accountId .. ", " .. db.escapeString(reason) .. ", " .. timeNow .. ", " ..
 			timeNow + (banDays * 86400) .. ", " .. player:getGuid() .. ")")
+	Game.clearLoginCache()
 
 	local target = Player(name)
 	if target then
@@ -0,0 +1,37 @@
+local fmt = string.format
+
+local types = {"map", "creatures", "effects", "text", "stats", "items", "other"}
+
+function onSay(player, words, param)
+	local target = param == "" and player or Player(param)
+	if not target then
+		player:sendCancelMessage("A player with that name is not online.")
+		return false
+	end
+
+	local stats = target:getSentStats()
+	if not stats then
+		player:sendCancelMessage("That player has no client.")
+		return false
+	end
+
+	local total = 0
+	for _, name in ipairs(types) do
+		total = total + stats.bytes[name]
+	end
+
+	local rate = {}
+	for i, bytes in ipairs(stats.rate) do
+		rate[i] = math.floor(bytes / 1024)
+	end
+
+	local desc = {fmt("Sent to %s: %d KB\nKB/s over the last %d seconds: %s\n", target:getName(),
+		math.floor(total / 1024), #rate, table.concat(rate, " "))}
+	for _, name in ipairs(types) do
+		local bytes = stats.bytes[name]
+		desc[#desc + 1] = fmt("%s: %d KB (%d%%)", name, math.floor(bytes / 1024),
+			total > 0 and math.floor(bytes * 100 / total) or 0)
+	end
+	player:popupFYI(table.concat(desc, "\n"))
+	return false
+end
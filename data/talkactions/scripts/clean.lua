@@ -1,9 +1,31 @@
 function onSay(player, words, param)
-	local itemCount = cleanMap()
-	if itemCount > 0 then
+	local progress = Game.getMapCleanProgress()
+	if progress.running then
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, string.format(
+			                       "Cleaning the map: %d of %d tiles, %d items removed in %.1f seconds.",
+			                       progress.tilesDone, progress.tiles, progress.items, progress.duration / 1000))
+		return false
+	end
+
+	if param == "now" then
+		local itemCount = cleanMap()
+		if itemCount > 0 then
+			player:sendTextMessage(MESSAGE_STATUS_WARNING,
+			                       "Cleaned " .. itemCount .. " item" ..
+				                       (itemCount > 1 and "s" or "") .. " from the map.")
+		end
+		return false
+	end
+
+	Game.startMapClean()
+	progress = Game.getMapCleanProgress()
+	if progress.running then
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, string.format(
+			                       "Cleaning %d tiles, say %s again to see the progress.", progress.tiles, words))
+	else
 		player:sendTextMessage(MESSAGE_STATUS_WARNING,
-		                       "Cleaned " .. itemCount .. " item" ..
-			                       (itemCount > 1 and "s" or "") .. " from the map.")
+		                       "Cleaned " .. progress.items .. " item" ..
+			                       (progress.items ~= 1 and "s" or "") .. " from the map.")
 	end
 	return false
 end
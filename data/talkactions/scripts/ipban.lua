@@ -31,6 +31,7 @@ function onSay(player, words, param)
 		"INSERT INTO `ip_bans` (`ip`, `reason`, `banned_at`, `expires_at`, `banned_by`) VALUES (" ..
 			targetIp .. ", '', " .. timeNow .. ", " .. timeNow + (ipBanDays * 86400) ..
 			", " .. player:getGuid() .. ")")
+	Game.clearLoginCache()
 	player:sendTextMessage(MESSAGE_EVENT_ADVANCE,
 	                       targetName .. "  has been IP banned.")
 	return false
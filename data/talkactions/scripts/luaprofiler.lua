@@ -0,0 +1,41 @@
+local fmt = string.format
+
+function onSay(player, words, param)
+	local params = param:split(" ")
+	local action = params[1] or ""
+
+	if action == "start" then
+		Game.setLuaProfilerEnabled(true)
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Lua profiler started.")
+	elseif action == "stop" then
+		Game.setLuaProfilerEnabled(false)
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Lua profiler stopped.")
+	elseif action == "reset" then
+		Game.getLuaProfilerStats(true)
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Lua profiler reset.")
+	elseif action == "dump" then
+		local path = params[2] or "data/logs/luaprofiler.folded"
+		local file = io.open(path, "w")
+		if not file then
+			player:sendCancelMessage(fmt("Could not open %s.", path))
+			return false
+		end
+
+		file:write(Game.getLuaProfilerDump())
+		file:close()
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, fmt("Lua profile written to %s.", path))
+	else
+		local state = Game.isLuaProfilerEnabled() and "running" or "stopped"
+		local desc = {fmt("Lua profiler is %s, top scripts by self time:\n", state)}
+		for i, entry in ipairs(Game.getLuaProfilerStats()) do
+			if i > 15 then
+				break
+			end
+
+			desc[#desc + 1] = fmt("%s (%s)\n  %d calls, self %d ms, total %d ms", entry.file, entry.interface,
+				entry.count, math.floor(entry.selfTime / 1000), math.floor(entry.totalTime / 1000))
+		end
+		player:popupFYI(table.concat(desc, "\n"))
+	end
+	return false
+end
@@ -0,0 +1,32 @@
+local fmt = string.format
+
+local subsystemOrder = {"tiles", "items", "containers", "creatures", "conditions", "network_buffers",
+	"database_results", "lua"}
+
+local function kib(bytes)
+	return math.floor(bytes / 1024)
+end
+
+function onSay(player, words, param)
+	if param == "purge" then
+		local purged = Game.purgeAllocator()
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, fmt("Allocator purged, %d KiB returned to the system.",
+			kib(purged)))
+		return false
+	end
+
+	local allocator = Game.getAllocatorStats()
+	local desc = {
+		fmt("Allocator %s: %d KiB allocated, %d KiB held, %d KiB resident\n", allocator.allocator,
+			kib(allocator.allocated), kib(allocator.held), kib(allocator.resident)),
+		"Live memory by subsystem:"
+	}
+
+	local stats = Game.getMemoryStats()
+	for _, name in ipairs(subsystemOrder) do
+		local usage = stats[name]
+		desc[#desc + 1] = fmt("%s: %d objects, %d KiB", name, usage.objects, kib(usage.bytes))
+	end
+	player:popupFYI(table.concat(desc, "\n"))
+	return false
+end
@@ -0,0 +1,63 @@
+local fmt = string.format
+
+local function sortedOpcodes(values, key)
+	local opcodes = {}
+	for opcode in pairs(values) do
+		opcodes[#opcodes + 1] = opcode
+	end
+	table.sort(opcodes, function(a, b) return key(a) > key(b) end)
+	return opcodes
+end
+
+function onSay(player, words, param)
+	local stats = Game.getPacketStats()
+	local function averageTime(opcode)
+		local entry = stats[opcode]
+		return entry and entry.executionTime / entry.count or 0
+	end
+
+	if param == "" then
+		local desc = {"Client packets by dispatcher time:\n"}
+		for i, opcode in ipairs(sortedOpcodes(stats, function(opcode) return stats[opcode].executionTime end)) do
+			if i > 15 then
+				break
+			end
+
+			local entry = stats[opcode]
+			desc[#desc + 1] = fmt("0x%02X: %d packets, %d KB, %d ms, avg %d us, wait avg %d us", opcode, entry.count,
+				math.floor(entry.bytes / 1024), math.floor(entry.executionTime / 1000), math.floor(averageTime(opcode)),
+				math.floor(entry.waitTime / entry.count))
+		end
+		player:popupFYI(table.concat(desc, "\n"))
+		return false
+	end
+
+	local target = Player(param)
+	if not target then
+		player:sendCancelMessage("A player with that name is not online.")
+		return false
+	end
+
+	local clientStats = target:getPacketStats()
+	if not clientStats then
+		player:sendCancelMessage("That player has no client.")
+		return false
+	end
+
+	-- the cost of a player is estimated from the average time every opcode takes across all players
+	local opcodes = clientStats.opcodes
+	local function estimatedTime(opcode) return opcodes[opcode] * averageTime(opcode) end
+
+	local desc = {fmt("Packets of %s, %d KB received.\nLast %d seconds: %s\n", target:getName(),
+		math.floor(clientStats.bytes / 1024), #clientStats.rate, table.concat(clientStats.rate, " "))}
+	for i, opcode in ipairs(sortedOpcodes(opcodes, estimatedTime)) do
+		if i > 15 then
+			break
+		end
+
+		desc[#desc + 1] = fmt("0x%02X: %d packets, about %d ms", opcode, opcodes[opcode],
+			math.floor(estimatedTime(opcode) / 1000))
+	end
+	player:popupFYI(table.concat(desc, "\n"))
+	return false
+end
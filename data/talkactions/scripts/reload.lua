@@ -66,12 +66,35 @@ function onSay(player, words, param)
 	-- call to Event.onReload
 	if hasEvent.onReload then Event.onReload(player, reloadType) end
 
-	-- need to clear EventCallback.data or we end up having duplicated events on /reload scripts
-	if table.contains({RELOAD_TYPE_SCRIPTS, RELOAD_TYPE_ALL}, reloadType) then
+	-- need to clear EventCallback.data or we end up having duplicated events on /reload all
+	-- /reload scripts only runs the changed files again and drops what they registered before by itself
+	if reloadType == RELOAD_TYPE_ALL then
 		Event:clear()
 		Game.clearQuests()
 	end
 
+	-- items and monsters are read in the background, the server keeps running meanwhile
+	if table.contains({RELOAD_TYPE_ITEMS, RELOAD_TYPE_MONSTERS}, reloadType) then
+		local playerId = player:getId()
+		local started = Game.reload(reloadType, function(reloaded)
+			local target = Player(playerId)
+			if not target then return end
+
+			if not reloaded then
+				target:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, string.format("Failed to reload %s.", paramToLower))
+			else
+				target:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, string.format("Reloaded %s.", paramToLower))
+			end
+		end)
+
+		if not started then
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Another reload is still running.")
+		else
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, string.format("Reloading %s.", paramToLower))
+		end
+		return false
+	end
+
 	local description = {}
 	local reloaded, scriptsLib = Game.reload(reloadType)
 	if reloadType == RELOAD_TYPE_GLOBAL then
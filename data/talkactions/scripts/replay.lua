@@ -0,0 +1,22 @@
+local fmt = string.format
+
+function onSay(player, words, param)
+	local params = param:split(" ")
+	local action = params[1] or ""
+
+	if action == "start" then
+		local path = params[2] or "data/logs/replay.bin"
+		if Game.startReplayRecording(path) then
+			player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, fmt("Recording a replay to %s.", path))
+		else
+			player:sendCancelMessage(fmt("Could not record to %s.", path))
+		end
+	elseif action == "stop" then
+		local records = Game.stopReplayRecording()
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, fmt("Replay recording stopped, %d records written.", records))
+	else
+		local state = Game.isRecordingReplay() and "A replay is being recorded." or "No replay is being recorded."
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, state .. " Usage: /replay start [file] | stop")
+	end
+	return false
+end
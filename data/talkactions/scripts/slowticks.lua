@@ -0,0 +1,35 @@
+local fmt = string.format
+
+local phaseOrder = {"creatures", "decay", "spawns", "raids", "packets", "network", "database", "scripts", "other"}
+
+function onSay(player, words, param)
+	if param == "clear" then
+		Game.getSlowTicks(true)
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "Slow ticks cleared.")
+		return false
+	end
+
+	local ticks = Game.getSlowTicks()
+	if #ticks == 0 then
+		player:sendTextMessage(MESSAGE_STATUS_CONSOLE_BLUE, "No slow ticks recorded.")
+		return false
+	end
+
+	local now = os.mtime()
+	local desc = {fmt("Last %d slow ticks, newest first:\n", #ticks)}
+	for i = #ticks, 1, -1 do
+		local tick = ticks[i]
+		local phases = {}
+		for _, name in ipairs(phaseOrder) do
+			local time = tick.phases[name]
+			if time >= 1000 then
+				phases[#phases + 1] = fmt("%s %d ms", name, math.floor(time / 1000))
+			end
+		end
+
+		desc[#desc + 1] = fmt("%d s ago: busy %d ms, %d tasks, lua %d ms\n  %s", math.floor((now - tick.start) / 1000),
+			math.floor(tick.busy / 1000), tick.tasks, math.floor(tick.luaTime / 1000), table.concat(phases, ", "))
+	end
+	player:popupFYI(table.concat(desc, "\n"))
+	return false
+end
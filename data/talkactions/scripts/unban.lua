@@ -7,7 +7,8 @@ function onSay(player, words, param)
 	db.asyncQuery("DELETE FROM `account_bans` WHERE `account_id` = " ..
 		              result.getNumber(resultId, "account_id"))
 	db.asyncQuery("DELETE FROM `ip_bans` WHERE `ip` = " ..
-		              result.getNumber(resultId, "lastip"))
+		              result.getNumber(resultId, "lastip"),
+	              function() Game.clearLoginCache() end)
 	result.free(resultId)
 	player:sendTextMessage(MESSAGE_EVENT_ADVANCE, param .. " has been unbanned.")
 	return false
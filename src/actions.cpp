@@ -21,24 +21,16 @@ Actions::Actions() : scriptInterface("Action Interface") { scriptInterface.initS
 
 Actions::~Actions() { clear(false); }
 
-void Actions::clearMap(ActionUseMap& map, bool fromLua)
+void Actions::clearMap(ActionUseMap& map, const EventFilter& filter)
 {
-	for (auto it = map.begin(); it != map.end();) {
-		if (fromLua == it->second.fromLua) {
-			it = map.erase(it);
-		} else {
-			++it;
-		}
-	}
+	map.eraseIf([&filter](const Action& action) { return filter(action); });
 }
 
-void Actions::clear(bool fromLua)
+void Actions::removeEvents(const EventFilter& filter)
 {
-	clearMap(useItemMap, fromLua);
-	clearMap(uniqueItemMap, fromLua);
-	clearMap(actionItemMap, fromLua);
-
-	reInitState(fromLua);
+	clearMap(useItemMap, filter);
+	clearMap(uniqueItemMap, filter);
+	clearMap(actionItemMap, filter);
 }
 
 LuaScriptInterface& Actions::getScriptInterface() { return scriptInterface; }
@@ -256,22 +248,19 @@ ReturnValue Actions::canUseFar(const Creature* creature, const Position& toPos,
 Action* Actions::getAction(const Item* item)
 {
 	if (item->hasAttribute(ITEM_ATTRIBUTE_UNIQUEID)) {
-		auto it = uniqueItemMap.find(item->getUniqueId());
-		if (it != uniqueItemMap.end()) {
-			return &it->second;
+		if (Action* action = uniqueItemMap.find(item->getUniqueId())) {
+			return action;
 		}
 	}
 
 	if (item->hasAttribute(ITEM_ATTRIBUTE_ACTIONID)) {
-		auto it = actionItemMap.find(item->getActionId());
-		if (it != actionItemMap.end()) {
-			return &it->second;
+		if (Action* action = actionItemMap.find(item->getActionId())) {
+			return action;
 		}
 	}
 
-	auto it = useItemMap.find(item->getID());
-	if (it != useItemMap.end()) {
-		return &it->second;
+	if (Action* action = useItemMap.find(item->getID())) {
+		return action;
 	}
 
 	// rune items
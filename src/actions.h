@@ -6,6 +6,7 @@
 
 #include "baseevents.h"
 #include "enums.h"
+#include "idmap.h"
 #include "luascript.h"
 
 class Action;
@@ -95,7 +96,6 @@ public:
 	ReturnValue canUseFar(const Creature* creature, const Position& toPos, bool checkLineOfSight, bool checkFloor);
 
 	bool registerLuaEvent(Action* event);
-	void clear(bool fromLua) override final;
 
 private:
 	ReturnValue internalUseItem(Player* player, const Position& pos, uint8_t index, Item* item, bool isHotkey);
@@ -105,13 +105,14 @@ private:
 	Event_ptr getEvent(std::string_view nodeName) override;
 	bool registerEvent(Event_ptr event, const pugi::xml_node& node) override;
 
-	using ActionUseMap = std::map<uint16_t, Action>;
+	using ActionUseMap = IdMap<Action>;
 	ActionUseMap useItemMap;
 	ActionUseMap uniqueItemMap;
 	ActionUseMap actionItemMap;
 
 	Action* getAction(const Item* item);
-	void clearMap(ActionUseMap& map, bool fromLua);
+	void clearMap(ActionUseMap& map, const EventFilter& filter);
+	void removeEvents(const EventFilter& filter) override final;
 
 	LuaScriptInterface scriptInterface;
 };
@@ -0,0 +1,272 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "adler32.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ADLER32_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define ADLER32_NEON
+#include <arm_neon.h>
+#endif
+
+#if defined(ADLER32_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ADLER32_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define ADLER32_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ADLER32_TARGET_SSSE3
+#define ADLER32_TARGET_AVX2
+#endif
+
+namespace adler32 {
+
+namespace {
+
+constexpr uint32_t BASE = 65521;
+// most bytes summed before the sums have to be reduced so they do not overflow 32 bits
+constexpr size_t NMAX = 5552;
+// shorter inputs are summed faster by the plain loop, the vector setup and the reduction cost more than they save
+constexpr size_t MIN_VECTOR_LENGTH = 32;
+
+// every implementation sums whole vectors of a block and leaves the remaining bytes to this
+uint32_t update(uint32_t s1, uint32_t s2, const uint8_t* data, size_t length)
+{
+	while (length > 0) {
+		size_t blockLength = std::min(length, NMAX);
+		length -= blockLength;
+
+		do {
+			s1 += *data++;
+			s2 += s1;
+		} while (--blockLength);
+
+		s1 %= BASE;
+		s2 %= BASE;
+	}
+	return (s2 << 16) | s1;
+}
+
+#ifdef ADLER32_X86
+// for a vector of n bytes s2 grows by n times s1 before it plus the bytes weighted n down to 1, the s1 of every
+// vector is summed up in vs1Before and multiplied once per block
+ADLER32_TARGET_SSSE3 uint32_t sum(__m128i v)
+{
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+	v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(v));
+}
+
+ADLER32_TARGET_SSSE3 uint32_t checksumSsse3(const uint8_t* data, size_t length)
+{
+	const __m128i weights = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m128i ones = _mm_set1_epi16(1);
+	const __m128i zero = _mm_setzero_si128();
+
+	if (length < MIN_VECTOR_LENGTH) {
+		return update(1, 0, data, length);
+	}
+
+	uint32_t s1 = 1, s2 = 0;
+	while (length >= 16) {
+		const size_t vectors = std::min(length, NMAX) / 16;
+		length -= vectors * 16;
+
+		__m128i vs1 = _mm_cvtsi32_si128(static_cast<int>(s1));
+		__m128i vs2 = _mm_cvtsi32_si128(static_cast<int>(s2));
+		__m128i vs1Before = zero;
+		for (size_t i = 0; i < vectors; ++i) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+			data += 16;
+
+			vs1Before = _mm_add_epi32(vs1Before, vs1);
+			vs1 = _mm_add_epi32(vs1, _mm_sad_epu8(v, zero));
+			vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(_mm_maddubs_epi16(v, weights), ones));
+		}
+		vs2 = _mm_add_epi32(vs2, _mm_slli_epi32(vs1Before, 4));
+
+		s1 = sum(vs1) % BASE;
+		s2 = sum(vs2) % BASE;
+	}
+	return update(s1, s2, data, length);
+}
+
+ADLER32_TARGET_AVX2 uint32_t sum(__m256i v)
+{
+	__m128i half = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+	half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+	return static_cast<uint32_t>(_mm_cvtsi128_si32(half));
+}
+
+ADLER32_TARGET_AVX2 uint32_t checksumAvx2(const uint8_t* data, size_t length)
+{
+	const __m256i weights = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15,
+	                                         14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1);
+	const __m256i ones = _mm256_set1_epi16(1);
+	const __m256i zero = _mm256_setzero_si256();
+
+	if (length < MIN_VECTOR_LENGTH) {
+		return update(1, 0, data, length);
+	}
+
+	uint32_t s1 = 1, s2 = 0;
+	while (length >= 32) {
+		const size_t vectors = std::min(length, NMAX) / 32;
+		length -= vectors * 32;
+
+		__m256i vs1 = _mm256_setr_epi32(static_cast<int>(s1), 0, 0, 0, 0, 0, 0, 0);
+		__m256i vs2 = _mm256_setr_epi32(static_cast<int>(s2), 0, 0, 0, 0, 0, 0, 0);
+		__m256i vs1Before = zero;
+		for (size_t i = 0; i < vectors; ++i) {
+			const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+			data += 32;
+
+			vs1Before = _mm256_add_epi32(vs1Before, vs1);
+			vs1 = _mm256_add_epi32(vs1, _mm256_sad_epu8(v, zero));
+			vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(_mm256_maddubs_epi16(v, weights), ones));
+		}
+		vs2 = _mm256_add_epi32(vs2, _mm256_slli_epi32(vs1Before, 5));
+
+		s1 = sum(vs1) % BASE;
+		s2 = sum(vs2) % BASE;
+	}
+	return update(s1, s2, data, length);
+}
+
+bool hasSsse3()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 9)) != 0;
+#else
+	return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+bool hasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	__cpuid(info, 1);
+	// the os has to save the ymm registers too
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef ADLER32_NEON
+// the same sums as the x86 versions, with widening pairwise adds instead of sad and maddubs
+uint32_t checksumNeon(const uint8_t* data, size_t length)
+{
+	static const uint8_t weights[16] = {16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1};
+	const uint8x8_t lowWeights = vld1_u8(weights);
+	const uint8x8_t highWeights = vld1_u8(weights + 8);
+
+	if (length < MIN_VECTOR_LENGTH) {
+		return update(1, 0, data, length);
+	}
+
+	uint32_t s1 = 1, s2 = 0;
+	while (length >= 16) {
+		const size_t vectors = std::min(length, NMAX) / 16;
+		length -= vectors * 16;
+
+		uint32x4_t vs1 = vsetq_lane_u32(s1, vdupq_n_u32(0), 0);
+		uint32x4_t vs2 = vsetq_lane_u32(s2, vdupq_n_u32(0), 0);
+		uint32x4_t vs1Before = vdupq_n_u32(0);
+		for (size_t i = 0; i < vectors; ++i) {
+			const uint8x16_t v = vld1q_u8(data);
+			data += 16;
+
+			vs1Before = vaddq_u32(vs1Before, vs1);
+			vs1 = vpadalq_u16(vs1, vpaddlq_u8(v));
+			uint16x8_t weighted = vmull_u8(vget_low_u8(v), lowWeights);
+			weighted = vmlal_u8(weighted, vget_high_u8(v), highWeights);
+			vs2 = vpadalq_u16(vs2, weighted);
+		}
+		vs2 = vaddq_u32(vs2, vshlq_n_u32(vs1Before, 4));
+
+		s1 = vaddvq_u32(vs1) % BASE;
+		s2 = vaddvq_u32(vs2) % BASE;
+	}
+	return update(s1, s2, data, length);
+}
+#endif
+
+backend getBestBackend()
+{
+#ifdef ADLER32_X86
+	if (hasAvx2()) {
+		return backend::avx2;
+	}
+	return hasSsse3() ? backend::ssse3 : backend::scalar;
+#elif defined(ADLER32_NEON)
+	return backend::neon;
+#else
+	return backend::scalar;
+#endif
+}
+
+} // namespace
+
+uint32_t checksum(const uint8_t* data, size_t length)
+{
+	static const backend best = getBestBackend();
+	return checksum(best, data, length);
+}
+
+bool is_supported(backend b)
+{
+	switch (b) {
+		case backend::scalar:
+			return true;
+#ifdef ADLER32_X86
+		case backend::ssse3:
+			return hasSsse3();
+		case backend::avx2:
+			return hasAvx2();
+#endif
+#ifdef ADLER32_NEON
+		case backend::neon:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+uint32_t checksum(backend b, const uint8_t* data, size_t length)
+{
+	switch (b) {
+#ifdef ADLER32_X86
+		case backend::ssse3:
+			return checksumSsse3(data, length);
+		case backend::avx2:
+			return checksumAvx2(data, length);
+#endif
+#ifdef ADLER32_NEON
+		case backend::neon:
+			return checksumNeon(data, length);
+#endif
+		default:
+			return update(1, 0, data, length);
+	}
+}
+
+} // namespace adler32
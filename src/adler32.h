@@ -0,0 +1,26 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_ADLER32_H
+#define FS_ADLER32_H
+
+namespace adler32 {
+
+// use the fastest implementation the cpu supports, picked on first use
+uint32_t checksum(const uint8_t* data, size_t length);
+
+// explicit implementations, for tests and benchmarks
+enum class backend
+{
+	scalar,
+	ssse3,
+	avx2,
+	neon,
+};
+
+bool is_supported(backend b);
+uint32_t checksum(backend b, const uint8_t* data, size_t length);
+
+} // namespace adler32
+
+#endif // FS_ADLER32_H
@@ -5,20 +5,30 @@
 
 #include "ban.h"
 
+#include "configmanager.h"
 #include "connection.h"
 #include "database.h"
 #include "databasetasks.h"
 #include "tools.h"
 
+extern ConfigManager g_config;
+
 bool Ban::acceptConnection(const uint32_t clientIP)
 {
-	std::lock_guard<std::recursive_mutex> lockClass(lock);
+	Shard& shard = shards[clientIP % shards.size()];
+	std::lock_guard<std::mutex> lockClass(shard.lock);
 
 	uint64_t currentTime = OTSYS_TIME();
 
-	auto it = ipConnectMap.find(clientIP);
-	if (it == ipConnectMap.end()) {
-		ipConnectMap.emplace(clientIP, ConnectBlock(currentTime, 0, 1));
+	auto it = shard.connectBlocks.find(clientIP);
+	if (it == shard.connectBlocks.end()) {
+		if (shard.connectBlocks.size() >= MAX_TRACKED_IPS_PER_SHARD) {
+			// an address neither blocked nor seen in the last 5 seconds starts over anyway
+			std::erase_if(shard.connectBlocks, [=](const auto& entry) {
+				return entry.second.blockTime <= currentTime && currentTime - entry.second.lastAttempt > 5000;
+			});
+		}
+		shard.connectBlocks.emplace(clientIP, ConnectBlock(currentTime, 0, 1));
 		return true;
 	}
 
@@ -44,64 +54,160 @@ bool Ban::acceptConnection(const uint32_t clientIP)
 	return true;
 }
 
-bool IOBan::isAccountBanned(uint32_t accountId, BanInfo& banInfo)
+namespace {
+
+// ban status by account id or ip, an empty ban means none was found
+struct CachedBan
+{
+	std::optional<BanInfo> ban;
+	int64_t expiresAt;
+};
+
+using BanCache = std::unordered_map<uint32_t, CachedBan>;
+
+constexpr size_t MAX_CACHED_BANS = 4096;
+
+BanCache accountBanCache;
+std::mutex banCacheLock;
+
+// every ip ban, replaced as a whole by loadIpBans
+using IpBans = std::unordered_map<uint32_t, BanInfo>;
+std::atomic<std::shared_ptr<const IpBans>> ipBans;
+
+template <typename Query>
+bool getCachedBan(BanCache& cache, uint32_t key, BanInfo& banInfo, Query&& query)
+{
+	const int64_t cacheTime = g_config[ConfigKeysInteger::LOGIN_CACHE_TIME] * 1000;
+	if (cacheTime <= 0) {
+		return query(banInfo);
+	}
+
+	{
+		std::lock_guard<std::mutex> lockClass(banCacheLock);
+		auto it = cache.find(key);
+		if (it != cache.end() && OTSYS_TIME() < it->second.expiresAt) {
+			const auto& ban = it->second.ban;
+			if (!ban) {
+				return false;
+			}
+
+			// an expired ban goes back to the query, which moves it out of the way
+			if (ban->expiresAt == 0 || time(nullptr) <= ban->expiresAt) {
+				banInfo = *ban;
+				return true;
+			}
+		}
+	}
+
+	std::optional<BanInfo> ban;
+	if (query(banInfo)) {
+		ban = banInfo;
+	}
+
+	const int64_t now = OTSYS_TIME();
+	std::lock_guard<std::mutex> lockClass(banCacheLock);
+	if (cache.size() >= MAX_CACHED_BANS) {
+		std::erase_if(cache, [=](const auto& it) { return now >= it.second.expiresAt; });
+	}
+	cache.insert_or_assign(key, CachedBan{ban, now + cacheTime});
+	return ban.has_value();
+}
+
+bool queryAccountBan(uint32_t accountId, BanInfo& banInfo)
 {
 	Database& db = Database::getInstance();
 
-	DBResult_ptr result = db.storeQuery(fmt::format(
-	    "SELECT `reason`, `expires_at`, `banned_at`, `banned_by`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `account_bans` WHERE `account_id` = {:d}",
-	    accountId));
-	if (!result) {
+	auto result = db.prepare(
+	    "SELECT `reason`, `expires_at`, `banned_at`, `banned_by`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `account_bans` WHERE `account_id` = ?");
+	if (!result->query(accountId)) {
 		return false;
 	}
 
-	int64_t expiresAt = result->getNumber<int64_t>("expires_at");
+	int64_t expiresAt = result->getNumber<int64_t>(1);
 	if (expiresAt != 0 && time(nullptr) > expiresAt) {
 		// Move the ban to history if it has expired
 		g_databaseTasks.addTask(fmt::format(
 		    "INSERT INTO `account_ban_history` (`account_id`, `reason`, `banned_at`, `expired_at`, `banned_by`) VALUES ({:d}, {:s}, {:d}, {:d}, {:d})",
-		    accountId, db.escapeString(result->getString("reason")), result->getNumber<time_t>("banned_at"), expiresAt,
-		    result->getNumber<uint32_t>("banned_by")));
+		    accountId, db.escapeString(result->getString(0)), result->getNumber<time_t>(2), expiresAt,
+		    result->getNumber<uint32_t>(3)));
 		g_databaseTasks.addTask(fmt::format("DELETE FROM `account_bans` WHERE `account_id` = {:d}", accountId));
 		return false;
 	}
 
 	banInfo.expiresAt = expiresAt;
-	banInfo.reason = result->getString("reason");
-	banInfo.bannedBy = result->getString("name");
+	banInfo.reason = result->getString(0);
+	banInfo.bannedBy = result->getString(4);
 	return true;
 }
 
+} // namespace
+
+bool IOBan::isAccountBanned(uint32_t accountId, BanInfo& banInfo)
+{
+	return getCachedBan(accountBanCache, accountId, banInfo,
+	                    [=](BanInfo& info) { return queryAccountBan(accountId, info); });
+}
+
 bool IOBan::isIpBanned(const uint32_t clientIP, BanInfo& banInfo)
 {
 	if (clientIP == 0) {
 		return false;
 	}
 
-	Database& db = Database::getInstance();
+	auto bans = ipBans.load();
+	if (!bans) {
+		return false;
+	}
 
-	DBResult_ptr result = db.storeQuery(fmt::format(
-	    "SELECT `reason`, `expires_at`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `ip_bans` WHERE `ip` = {:d}",
-	    clientIP));
-	if (!result) {
+	auto it = bans->find(clientIP);
+	if (it == bans->end()) {
 		return false;
 	}
 
-	int64_t expiresAt = result->getNumber<int64_t>("expires_at");
-	if (expiresAt != 0 && time(nullptr) > expiresAt) {
-		g_databaseTasks.addTask(fmt::format("DELETE FROM `ip_bans` WHERE `ip` = {:d}", clientIP));
+	// expired bans are deleted by the next load
+	const BanInfo& ban = it->second;
+	if (ban.expiresAt != 0 && time(nullptr) > ban.expiresAt) {
 		return false;
 	}
 
-	banInfo.expiresAt = expiresAt;
-	banInfo.reason = result->getString("reason");
-	banInfo.bannedBy = result->getString("name");
+	banInfo = ban;
+	return true;
+}
+
+bool IOBan::loadIpBans(Database& db)
+{
+	if (!db.executeQuery(
+	        fmt::format("DELETE FROM `ip_bans` WHERE `expires_at` != 0 AND `expires_at` < {:d}", time(nullptr)))) {
+		return false;
+	}
+
+	auto bans = std::make_shared<IpBans>();
+	DBResult_ptr result = db.storeQuery(
+	    "SELECT `ip`, `reason`, `expires_at`, (SELECT `name` FROM `players` WHERE `id` = `banned_by`) AS `name` FROM `ip_bans`");
+	if (result) {
+		do {
+			BanInfo& banInfo = (*bans)[result->getNumber<uint32_t>("ip")];
+			banInfo.expiresAt = result->getNumber<time_t>("expires_at");
+			banInfo.reason = result->getString("reason");
+			banInfo.bannedBy = result->getString("name");
+		} while (result->next());
+	}
+
+	ipBans.store(std::move(bans));
 	return true;
 }
 
+void IOBan::clearCache()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(banCacheLock);
+		accountBanCache.clear();
+	}
+
+	g_databaseTasks.addJob([](Database& db) { IOBan::loadIpBans(db); });
+}
+
 bool IOBan::isPlayerNamelocked(uint32_t playerId)
 {
-	return Database::getInstance()
-	    .storeQuery(fmt::format("SELECT 1 FROM `player_namelocks` WHERE `player_id` = {:d}", playerId))
-	    .get();
+	return Database::getInstance().prepare("SELECT 1 FROM `player_namelocks` WHERE `player_id` = ?")->query(playerId);
 }
@@ -6,6 +6,8 @@
 
 #include "connection.h"
 
+class Database;
+
 struct BanInfo
 {
 	std::string bannedBy;
@@ -24,16 +26,23 @@ struct ConnectBlock
 	uint32_t count;
 };
 
-using IpConnectMap = std::map<uint32_t, ConnectBlock>;
-
+// connection attempts per address, spread over shards with a lock each so accepts from different addresses rarely
+// wait on each other
 class Ban
 {
 public:
 	bool acceptConnection(const uint32_t clientIP);
 
 private:
-	IpConnectMap ipConnectMap;
-	std::recursive_mutex lock;
+	static constexpr size_t MAX_TRACKED_IPS_PER_SHARD = 1024;
+
+	struct Shard
+	{
+		std::unordered_map<uint32_t, ConnectBlock> connectBlocks;
+		std::mutex lock;
+	};
+
+	std::array<Shard, 16> shards;
 };
 
 class IOBan
@@ -41,6 +50,10 @@ class IOBan
 public:
 	static bool isAccountBanned(uint32_t accountId, BanInfo& banInfo);
 	static bool isIpBanned(const uint32_t clientIP, BanInfo& banInfo);
+	// replaces the ip bans isIpBanned answers from with the ones in the database
+	static bool loadIpBans(Database& db);
+	// drops the account bans kept by isAccountBanned and reloads the ip bans
+	static void clearCache();
 	static bool isPlayerNamelocked(uint32_t playerId);
 };
 
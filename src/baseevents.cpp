@@ -80,6 +80,17 @@ void BaseEvents::reInitState(bool fromLua)
 	}
 }
 
+void BaseEvents::clear(bool fromLua)
+{
+	removeEvents([fromLua](const Event& event) { return fromLua == event.fromLua; });
+	reInitState(fromLua);
+}
+
+void BaseEvents::clearScriptFile(std::string_view scriptFile)
+{
+	removeEvents([scriptFile](const Event& event) { return event.fromLua && event.scriptFile == scriptFile; });
+}
+
 Event::Event(LuaScriptInterface* interface) : scriptInterface(interface) {}
 
 bool Event::checkScript(std::string_view basePath, std::string_view scriptsName, std::string_view scriptFile) const
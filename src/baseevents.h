@@ -26,6 +26,8 @@ public:
 
 	bool scripted = false;
 	bool fromLua = false;
+	// the revscript file that created the event, empty for events from xml
+	std::string scriptFile;
 
 	int32_t getScriptId() { return scriptId; }
 
@@ -47,12 +49,19 @@ public:
 	bool isLoaded() const { return loaded; }
 	void reInitState(bool fromLua);
 
+	void clear(bool fromLua);
+	// removes the events the revscript file registered, running the file again registers them anew
+	void clearScriptFile(std::string_view scriptFile);
+
+protected:
+	using EventFilter = std::function<bool(const Event&)>;
+
 private:
 	virtual LuaScriptInterface& getScriptInterface() = 0;
 	virtual std::string_view getScriptBaseName() const = 0;
 	virtual Event_ptr getEvent(std::string_view nodeName) = 0;
 	virtual bool registerEvent(Event_ptr event, const pugi::xml_node& node) = 0;
-	virtual void clear(bool) = 0;
+	virtual void removeEvents(const EventFilter& filter) = 0;
 
 	bool loaded = false;
 };
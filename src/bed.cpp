@@ -8,8 +8,87 @@
 #include "game.h"
 #include "iologindata.h"
 #include "scheduler.h"
+#include "vocation.h"
 
 extern Game g_game;
+extern Vocations g_vocations;
+
+namespace {
+
+// health and mana the regeneration condition gives for the time slept, the ticks used for it are taken off
+int32_t useRegeneration(Condition& condition, uint32_t sleptTime)
+{
+	if (condition.getTicks() == -1) {
+		return sleptTime / 30;
+	}
+
+	const int32_t regen = std::min<int32_t>(condition.getTicks() / 1000, sleptTime) / 30;
+	condition.setTicks(condition.getTicks() - regen * 30000);
+	return regen;
+}
+
+int32_t getSoulRegeneration(uint32_t sleptTime) { return sleptTime / (60 * 15); }
+
+// the row version of BedItem::regeneratePlayer, health and mana stop at the maximum without equipment bonuses
+void regenerateOfflinePlayer(Database& db, uint32_t guid, uint32_t sleptTime,
+                             const std::map<uint16_t, uint8_t>& soulMax)
+{
+	DBResult_ptr result = db.storeQuery(fmt::format(
+	    "SELECT `vocation`, `health`, `healthmax`, `mana`, `manamax`, `soul`, `conditions` FROM `players` WHERE `id` = {:d}",
+	    guid));
+	if (!result) {
+		return;
+	}
+
+	int32_t health = result->getNumber<int32_t>("health");
+	int32_t mana = result->getNumber<int32_t>("mana");
+	int32_t soul = result->getNumber<int32_t>("soul");
+
+	auto attributes = result->getString("conditions");
+	PropStream propStream;
+	propStream.init(attributes.data(), attributes.size());
+
+	std::vector<Condition_ptr> conditions;
+	for (Condition_ptr condition = Condition::createCondition(propStream); condition;
+	     condition = Condition::createCondition(propStream)) {
+		if (condition->unserialize(propStream)) {
+			conditions.push_back(std::move(condition));
+		}
+	}
+
+	for (auto it = conditions.begin(), end = conditions.end(); it != end; ++it) {
+		Condition& condition = **it;
+		if (condition.getType() != CONDITION_REGENERATION || condition.getId() != CONDITIONID_DEFAULT ||
+		    condition.getSubId() != 0) {
+			continue;
+		}
+
+		const int32_t regen = useRegeneration(condition, sleptTime);
+		health += std::min<int32_t>(regen, std::max<int32_t>(result->getNumber<int32_t>("healthmax") - health, 0));
+		mana += std::min<int32_t>(regen, std::max<int32_t>(result->getNumber<int32_t>("manamax") - mana, 0));
+		if (condition.getTicks() == 0) {
+			conditions.erase(it);
+		}
+		break;
+	}
+
+	auto it = soulMax.find(result->getNumber<uint16_t>("vocation"));
+	if (it != soulMax.end()) {
+		soul += std::min<int32_t>(getSoulRegeneration(sleptTime), std::max<int32_t>(it->second - soul, 0));
+	}
+
+	PropWriteStream propWriteStream;
+	for (const Condition_ptr& condition : conditions) {
+		condition->serialize(propWriteStream);
+		propWriteStream.write<uint8_t>(CONDITIONATTR_END);
+	}
+
+	db.executeQuery(fmt::format(
+	    "UPDATE `players` SET `health` = {:d}, `mana` = {:d}, `soul` = {:d}, `conditions` = {:s} WHERE `id` = {:d}",
+	    health, mana, soul, db.escapeString(propWriteStream.getStream()), guid));
+}
+
+} // namespace
 
 BedItem::BedItem(uint16_t id) : Item(id) { internalRemoveSleeper(); }
 
@@ -166,11 +245,17 @@ void BedItem::wakeUp(Player* player)
 
 	if (sleeperGUID != 0) {
 		if (!player) {
-			Player regenPlayer(nullptr);
-			if (IOLoginData::loadPlayerById(&regenPlayer, sleeperGUID)) {
-				regeneratePlayer(&regenPlayer);
-				IOLoginData::savePlayer(&regenPlayer);
+			// only the rows the regeneration changes are rewritten, vocations are read here and not on the job
+			std::map<uint16_t, uint8_t> soulMax;
+			for (const auto& [vocationId, vocation] : g_vocations.getVocations()) {
+				soulMax.emplace(vocationId, vocation.getSoulMax());
 			}
+
+			const uint32_t sleptTime = time(nullptr) - sleepStart;
+			IOLoginData::updateOfflinePlayer(
+			    sleeperGUID, [guid = sleeperGUID, sleptTime, soulMax = std::move(soulMax)](Database& db) {
+				    regenerateOfflinePlayer(db, guid, sleptTime, soulMax);
+			    });
 		} else {
 			regeneratePlayer(player);
 			g_game.addCreatureHealth(player);
@@ -203,25 +288,16 @@ void BedItem::regeneratePlayer(Player* player) const
 
 	Condition* condition = player->getCondition(CONDITION_REGENERATION, CONDITIONID_DEFAULT);
 	if (condition) {
-		uint32_t regen;
-		if (condition->getTicks() != -1) {
-			regen = std::min<int32_t>((condition->getTicks() / 1000), sleptTime) / 30;
-			const int32_t newRegenTicks = condition->getTicks() - (regen * 30000);
-			if (newRegenTicks <= 0) {
-				player->removeCondition(condition);
-			} else {
-				condition->setTicks(newRegenTicks);
-			}
-		} else {
-			regen = sleptTime / 30;
+		const int32_t regen = useRegeneration(*condition, sleptTime);
+		if (condition->getTicks() == 0) {
+			player->removeCondition(condition);
 		}
 
 		player->changeHealth(regen, false);
 		player->changeMana(regen);
 	}
 
-	const int32_t soulRegen = sleptTime / (60 * 15);
-	player->changeSoul(soulRegen);
+	player->changeSoul(getSoulRegeneration(sleptTime));
 }
 
 void BedItem::updateAppearance(const Player* player)
@@ -0,0 +1,61 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../adler32.h"
+
+namespace {
+
+// most client packets and creature updates are a few dozen bytes, a map description burst a few kilobytes
+constexpr size_t MESSAGE_SIZES[] = {16, 64, 256, 1024, 8192};
+constexpr size_t TOTAL_BYTES = 256 * 1024 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+const char* getBackendName(adler32::backend b)
+{
+	switch (b) {
+		case adler32::backend::scalar:
+			return "scalar";
+		case adler32::backend::ssse3:
+			return "ssse3";
+		case adler32::backend::avx2:
+			return "avx2";
+		case adler32::backend::neon:
+			return "neon";
+	}
+	return "unknown";
+}
+
+} // namespace
+
+int main()
+{
+	for (size_t size : MESSAGE_SIZES) {
+		std::vector<uint8_t> data(size);
+		for (size_t i = 0; i < size; ++i) {
+			data[i] = static_cast<uint8_t>(i * 131);
+		}
+
+		for (auto b : {adler32::backend::scalar, adler32::backend::ssse3, adler32::backend::avx2,
+		               adler32::backend::neon}) {
+			if (!adler32::is_supported(b)) {
+				continue;
+			}
+
+			uint32_t checksum = 0;
+			auto start = Clock::now();
+			for (size_t done = 0; done < TOTAL_BYTES; done += size) {
+				// the previous result feeds the data so the loop is not optimized away
+				data[0] = static_cast<uint8_t>(checksum);
+				checksum = adler32::checksum(b, data.data(), data.size());
+			}
+			const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+			std::cout << getBackendName(b) << " " << size << " byte messages: " << (TOTAL_BYTES * 1000.0 / time)
+			          << " MB/s (checksum " << checksum << ")" << std::endl;
+		}
+	}
+	return 0;
+}
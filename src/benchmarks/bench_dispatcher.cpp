@@ -0,0 +1,69 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../tasks.h"
+
+#include <numeric>
+
+namespace {
+
+constexpr size_t PRODUCERS = 8;
+constexpr size_t TASKS_PER_PRODUCER = 200000;
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+int main()
+{
+	Dispatcher dispatcher;
+	dispatcher.start();
+
+	std::atomic<size_t> executed{0};
+	std::vector<std::vector<uint32_t>> latencies(PRODUCERS);
+	std::vector<std::thread> producers;
+	producers.reserve(PRODUCERS);
+
+	const auto start = Clock::now();
+	for (size_t i = 0; i < PRODUCERS; ++i) {
+		producers.emplace_back([&, &samples = latencies[i]]() {
+			samples.reserve(TASKS_PER_PRODUCER);
+			for (size_t n = 0; n < TASKS_PER_PRODUCER; ++n) {
+				const auto enqueueStart = Clock::now();
+				dispatcher.addTask([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); });
+				samples.push_back(static_cast<uint32_t>(
+				    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - enqueueStart).count()));
+			}
+		});
+	}
+
+	for (auto& producer : producers) {
+		producer.join();
+	}
+
+	while (executed.load(std::memory_order_relaxed) != PRODUCERS * TASKS_PER_PRODUCER) {
+		std::this_thread::yield();
+	}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+
+	dispatcher.shutdown();
+	dispatcher.join();
+
+	std::vector<uint32_t> all;
+	all.reserve(PRODUCERS * TASKS_PER_PRODUCER);
+	for (const auto& samples : latencies) {
+		all.insert(all.end(), samples.begin(), samples.end());
+	}
+	std::sort(all.begin(), all.end());
+
+	auto percentile = [&all](double p) { return all[static_cast<size_t>(p * (all.size() - 1))]; };
+	const uint64_t total = std::accumulate(all.begin(), all.end(), uint64_t{0});
+
+	std::cout << "Dispatcher::addTask with " << PRODUCERS << " producers, " << all.size() << " tasks in " << elapsed
+	          << " ms\n"
+	          << "enqueue latency (ns): mean " << total / all.size() << ", p50 " << percentile(0.50) << ", p99 "
+	          << percentile(0.99) << ", p99.9 " << percentile(0.999) << ", max " << all.back() << std::endl;
+	return 0;
+}
@@ -0,0 +1,59 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../item.h"
+
+namespace {
+
+constexpr size_t ITEMS = 100'000;
+constexpr size_t ROUNDS = 20;
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+int main()
+{
+	std::vector<ItemAttributes> attributes(ITEMS);
+	uint64_t checksum = 0;
+
+	// a decaying item with a few of the usual attributes, the way corpses and quest rewards look
+	auto start = Clock::now();
+	for (size_t round = 0; round < ROUNDS; ++round) {
+		for (size_t i = 0; i < ITEMS; ++i) {
+			ItemAttributes& item = attributes[i];
+			item.setActionId(static_cast<uint16_t>(round + i));
+			item.setCharges(static_cast<uint16_t>(i));
+			item.setCorpseOwner(static_cast<uint32_t>(i));
+			item.setDuration(static_cast<int32_t>(round * 1000));
+			item.setDecaying(DECAYING_TRUE);
+		}
+	}
+	const auto setTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (size_t round = 0; round < ROUNDS; ++round) {
+		for (const ItemAttributes& item : attributes) {
+			checksum += item.getActionId() + item.getCharges() + item.getCorpseOwner() + item.getDuration() +
+			            item.getDecaying() + item.getUniqueId();
+		}
+	}
+	const auto getTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (size_t i = 0; i < ITEMS; ++i) {
+		attributes[i].setText("Property of the king.");
+		checksum += attributes[i].getText().size();
+	}
+	const auto textTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	const size_t calls = ITEMS * ROUNDS;
+	std::cout << "ItemAttributes, " << ITEMS << " items\n"
+	          << "set 5 attributes: " << static_cast<double>(setTime) / calls << " ns/item\n"
+	          << "get 6 attributes: " << static_cast<double>(getTime) / calls << " ns/item\n"
+	          << "set and get text: " << static_cast<double>(textTime) / ITEMS << " ns/item\n"
+	          << "checksum " << checksum << std::endl;
+	return 0;
+}
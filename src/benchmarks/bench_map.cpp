@@ -0,0 +1,92 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../game.h"
+#include "../monster.h"
+#include "../monsters.h"
+
+extern Game g_game;
+
+namespace {
+
+// a 256x256 hunting ground with scattered walls and a few thousand monsters, always built from the same seed
+constexpr uint16_t AREA_X = 1000;
+constexpr uint16_t AREA_Y = 1000;
+constexpr uint16_t AREA_SIZE = 256;
+constexpr uint8_t AREA_Z = 7;
+constexpr uint32_t WALL_PERCENT = 10;
+constexpr size_t MONSTERS = 4000;
+constexpr size_t QUERIES = 1'000'000;
+
+using Clock = std::chrono::steady_clock;
+
+Position randomPosition(std::mt19937& rng, uint16_t margin)
+{
+	std::uniform_int_distribution<uint16_t> offset(margin, AREA_SIZE - 1 - margin);
+	return Position(AREA_X + offset(rng), AREA_Y + offset(rng), AREA_Z);
+}
+
+} // namespace
+
+int main()
+{
+	Map& map = g_game.map;
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<uint32_t> percent(0, 99);
+
+	for (uint16_t y = 0; y < AREA_SIZE; ++y) {
+		for (uint16_t x = 0; x < AREA_SIZE; ++x) {
+			const Position pos(AREA_X + x, AREA_Y + y, AREA_Z);
+			map.setTile(pos, new DynamicTile(pos.x, pos.y, pos.z));
+
+			uint8_t walkFlags = TILEWALK_GROUND;
+			if (percent(rng) < WALL_PERCENT) {
+				walkFlags |= TILEWALK_BLOCKED | TILEWALK_BLOCKPROJECTILE;
+			}
+			map.setTileWalkFlags(pos, walkFlags);
+		}
+	}
+
+	// the monsters stand on tiles without ground, so they skip the usual placement checks
+	MonsterType monsterType;
+	for (size_t i = 0; i < MONSTERS; ++i) {
+		Monster* monster = new Monster(&monsterType);
+		monster->incrementReferenceCounter();
+		map.placeCreature(randomPosition(rng, 0), monster, false, true);
+	}
+
+	std::vector<std::pair<Position, Position>> sightPairs;
+	sightPairs.reserve(QUERIES);
+	std::uniform_int_distribution<int32_t> offsetX(-Map::maxClientViewportX, Map::maxClientViewportX);
+	std::uniform_int_distribution<int32_t> offsetY(-Map::maxClientViewportY, Map::maxClientViewportY);
+	for (size_t i = 0; i < QUERIES; ++i) {
+		const Position from = randomPosition(rng, Map::maxClientViewportX);
+		const Position to(from.x + offsetX(rng), from.y + offsetY(rng), from.z);
+		sightPairs.emplace_back(from, to);
+	}
+
+	size_t checksum = 0;
+
+	auto start = Clock::now();
+	for (const auto& [from, to] : sightPairs) {
+		checksum += map.isSightClear(from, to, true);
+	}
+	const auto sightTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (const auto& [from, to] : sightPairs) {
+		SpectatorVec spectators;
+		map.getSpectators(spectators, from);
+		checksum += spectators.size();
+	}
+	const auto spectatorTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	std::cout << "Map, " << AREA_SIZE << "x" << AREA_SIZE << " tiles, " << WALL_PERCENT << "% walls, " << MONSTERS
+	          << " monsters, " << QUERIES << " queries\n"
+	          << "isSightClear: " << static_cast<double>(sightTime) / QUERIES << " ns/query\n"
+	          << "getSpectators: " << static_cast<double>(spectatorTime) / QUERIES << " ns/query\n"
+	          << "checksum " << checksum << std::endl;
+	return 0;
+}
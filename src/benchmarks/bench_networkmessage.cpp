@@ -0,0 +1,54 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../networkmessage.h"
+#include "../position.h"
+
+namespace {
+
+// roughly a creature move: a few opcodes, ids, a position and a name
+constexpr size_t MESSAGES = 5'000'000;
+constexpr std::string_view NAME = "Demon Skeleton";
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+int main()
+{
+	NetworkMessage msg;
+	uint64_t checksum = 0;
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < MESSAGES; ++i) {
+		msg.reset();
+		msg.addByte(0x6D);
+		msg.add<uint32_t>(static_cast<uint32_t>(i));
+		msg.addPosition(Position(1000 + (i & 0xFF), 1000, 7));
+		msg.add<uint16_t>(0x61);
+		msg.addString(NAME);
+		msg.addByte(100);
+		checksum += msg.getLength();
+	}
+	const auto addTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (size_t i = 0; i < MESSAGES; ++i) {
+		msg.setBufferPosition(0);
+		checksum += msg.getByte();
+		checksum += msg.get<uint32_t>();
+		checksum += msg.getPosition().x;
+		checksum += msg.get<uint16_t>();
+		checksum += msg.getString().size();
+		checksum += msg.getByte();
+	}
+	const auto getTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	std::cout << "NetworkMessage, " << MESSAGES << " messages of " << msg.getLength() << " bytes\n"
+	          << "add: " << static_cast<double>(addTime) / MESSAGES << " ns/message\n"
+	          << "get: " << static_cast<double>(getTime) / MESSAGES << " ns/message\n"
+	          << "checksum " << checksum << std::endl;
+	return 0;
+}
@@ -0,0 +1,102 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../fileloader.h"
+
+namespace {
+
+// an item record as the player and house savers write it: id, count, a few attributes and a text
+constexpr size_t ITEMS = 2'000'000;
+constexpr std::string_view TEXT = "Hic sunt dracones.";
+// a depot sized save: every item goes through a cleared stream and is copied out as its own attribute blob
+constexpr size_t SAVES = 10'000;
+constexpr size_t ITEMS_PER_SAVE = 400;
+
+using Clock = std::chrono::steady_clock;
+
+void writeItem(PropWriteStream& writer, size_t i)
+{
+	writer.write<uint16_t>(static_cast<uint16_t>(2000 + (i & 0x3FF)));
+	writer.write<uint8_t>(static_cast<uint8_t>(i));
+	writer.write<uint8_t>(22); // action id
+	writer.write<uint16_t>(1000);
+	if ((i & 7) == 0) {
+		writer.write<uint8_t>(6); // text
+		writer.writeString(TEXT);
+	}
+	writer.write<uint8_t>(0); // end of attributes
+}
+
+// nanoseconds per item of SAVES saves, with a stream per save or one kept across them
+int64_t timeSaves(bool reuse, uint64_t& checksum)
+{
+	PropWriteStream kept;
+	auto start = Clock::now();
+	for (size_t save = 0; save < SAVES; ++save) {
+		std::optional<PropWriteStream> fresh;
+		PropWriteStream& writer = reuse ? kept : fresh.emplace();
+
+		std::vector<std::string> blobs;
+		blobs.reserve(ITEMS_PER_SAVE);
+		for (size_t i = 0; i < ITEMS_PER_SAVE; ++i) {
+			writer.clear();
+			writeItem(writer, save + i);
+			blobs.emplace_back(writer.getStream());
+		}
+		checksum += blobs.back().size();
+	}
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count() /
+	       static_cast<int64_t>(SAVES * ITEMS_PER_SAVE);
+}
+
+} // namespace
+
+int main()
+{
+	PropWriteStream writer;
+	uint64_t checksum = 0;
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < ITEMS; ++i) {
+		writer.write<uint16_t>(static_cast<uint16_t>(2000 + (i & 0x3FF)));
+		writer.write<uint8_t>(static_cast<uint8_t>(i));
+		writer.write<uint8_t>(22); // action id
+		writer.write<uint16_t>(1000);
+		writer.write<uint8_t>(6); // text
+		writer.writeString(TEXT);
+		writer.write<uint8_t>(0); // end of attributes
+	}
+	const auto writeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	const std::string_view stream = writer.getStream();
+	PropStream reader;
+	reader.init(stream.data(), stream.size());
+
+	start = Clock::now();
+	for (size_t i = 0; i < ITEMS; ++i) {
+		uint16_t id, actionId;
+		uint8_t count, attribute;
+		reader.read(id);
+		reader.read(count);
+		reader.read(attribute);
+		reader.read(actionId);
+		reader.read(attribute);
+		const auto [text, ok] = reader.readString();
+		reader.read(attribute);
+		checksum += id + count + actionId + text.size() + ok;
+	}
+	const auto readTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	const int64_t freshTime = timeSaves(false, checksum);
+	const int64_t reusedTime = timeSaves(true, checksum);
+
+	std::cout << "PropWriteStream/PropStream, " << ITEMS << " item records, " << stream.size() / 1024 << " KB\n"
+	          << "write: " << static_cast<double>(writeTime) / ITEMS << " ns/item\n"
+	          << "read: " << static_cast<double>(readTime) / ITEMS << " ns/item\n"
+	          << SAVES << " saves of " << ITEMS_PER_SAVE << " items, stream per save: " << freshTime
+	          << " ns/item, kept stream: " << reusedTime << " ns/item\n"
+	          << "checksum " << checksum << std::endl;
+	return 0;
+}
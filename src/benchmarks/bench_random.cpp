@@ -0,0 +1,59 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../tools.h"
+
+#include <numeric>
+
+namespace {
+
+constexpr size_t DRAWS = 50'000'000;
+constexpr size_t BATCH = 256;
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+void run(const char* name, F&& draw)
+{
+	int64_t sum = 0;
+	const auto start = Clock::now();
+	for (size_t i = 0; i < DRAWS; ++i) {
+		sum += draw(static_cast<int32_t>(i & 0xFF));
+	}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	// the sum keeps the draws from being optimized out
+	std::cout << name << ": " << static_cast<double>(elapsed) / DRAWS << " ns per value (checksum " << sum << ")"
+	          << std::endl;
+}
+
+} // namespace
+
+int main()
+{
+	// what uniform_random did before
+	std::mt19937 mt(std::random_device{}());
+	std::uniform_int_distribution<int32_t> distribution;
+	run("mt19937 + uniform_int_distribution", [&](int32_t max) {
+		return distribution(mt, std::uniform_int_distribution<int32_t>::param_type(0, max + 100));
+	});
+
+	run("uniform_random", [](int32_t max) { return uniform_random(0, max + 100); });
+
+	std::array<int32_t, BATCH> values;
+	int64_t sum = 0;
+	const auto start = Clock::now();
+	for (size_t i = 0; i < DRAWS / BATCH; ++i) {
+		uniform_random(0, 355, values);
+		sum += std::accumulate(values.begin(), values.end(), int64_t{0});
+	}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	std::cout << "uniform_random batches of " << BATCH << ": "
+	          << static_cast<double>(elapsed) / (DRAWS / BATCH * BATCH) << " ns per value (checksum " << sum << ")"
+	          << std::endl;
+
+	run("normal_random", [](int32_t max) { return normal_random(0, max + 100); });
+	return 0;
+}
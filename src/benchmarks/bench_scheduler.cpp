@@ -0,0 +1,56 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../scheduler.h"
+
+namespace {
+
+// creature thinks, decays and conditions are mostly added and stopped again long before they are due
+constexpr size_t EVENTS = 1'000'000;
+constexpr uint32_t MAX_DELAY = 10 * 60 * 1000;
+
+using Clock = std::chrono::steady_clock;
+
+} // namespace
+
+int main()
+{
+	Scheduler scheduler;
+	scheduler.start();
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<uint32_t> delays(SCHEDULER_MINTICKS, MAX_DELAY);
+	std::vector<uint32_t> delay(EVENTS);
+	for (uint32_t& value : delay) {
+		// far enough out that none comes due while the benchmark runs
+		value = MAX_DELAY + delays(rng);
+	}
+
+	std::vector<uint32_t> eventIds;
+	eventIds.reserve(EVENTS);
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < EVENTS; ++i) {
+		eventIds.push_back(scheduler.addEvent(createSchedulerTask(delay[i], []() {})));
+	}
+	const auto addTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	// stopped in a different order than added, like events cancelled by unrelated creatures
+	std::shuffle(eventIds.begin(), eventIds.end(), rng);
+
+	start = Clock::now();
+	for (uint32_t eventId : eventIds) {
+		scheduler.stopEvent(eventId);
+	}
+	const auto stopTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	scheduler.shutdown();
+	scheduler.join();
+
+	std::cout << "Scheduler, " << EVENTS << " events\n"
+	          << "addEvent: " << static_cast<double>(addTime) / EVENTS << " ns/event\n"
+	          << "stopEvent: " << static_cast<double>(stopTime) / EVENTS << " ns/event" << std::endl;
+	return 0;
+}
@@ -0,0 +1,76 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../spectators.h"
+
+namespace {
+
+// a depot crowd: everyone stands within one screen, so a step changes only a few spectators at the edges
+constexpr size_t CROWD_SIZE = 200;
+constexpr size_t EDGE_CHANGES = 8;
+constexpr size_t MOVES = 20000;
+
+using Clock = std::chrono::steady_clock;
+
+struct FakeCreature
+{
+	alignas(Creature*) char padding[64];
+};
+
+// the merge SpectatorVec used to do, kept here as the reference point
+void linearMerge(std::vector<Creature*>& out, const std::vector<Creature*>& in)
+{
+	for (Creature* spectator : in) {
+		if (std::find(out.begin(), out.end(), spectator) == out.end()) {
+			out.push_back(spectator);
+		}
+	}
+}
+
+} // namespace
+
+int main()
+{
+	std::vector<FakeCreature> creatures(CROWD_SIZE + EDGE_CHANGES);
+	std::vector<Creature*> pointers;
+	pointers.reserve(creatures.size());
+	for (FakeCreature& creature : creatures) {
+		pointers.push_back(reinterpret_cast<Creature*>(&creature));
+	}
+
+	std::mt19937 rng(1234);
+	std::vector<Creature*> oldPos(pointers.begin(), pointers.begin() + CROWD_SIZE);
+	std::vector<Creature*> newPos(pointers.begin() + EDGE_CHANGES, pointers.end());
+	std::shuffle(oldPos.begin(), oldPos.end(), rng);
+	std::shuffle(newPos.begin(), newPos.end(), rng);
+
+	size_t checksum = 0;
+
+	auto start = Clock::now();
+	for (size_t i = 0; i < MOVES; ++i) {
+		std::vector<Creature*> spectators;
+		spectators.reserve(32);
+		spectators.insert(spectators.end(), oldPos.begin(), oldPos.end());
+		linearMerge(spectators, newPos);
+		checksum += spectators.size();
+	}
+	const auto linearTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	start = Clock::now();
+	for (size_t i = 0; i < MOVES; ++i) {
+		SpectatorVec spectators, newPosSpectators;
+		spectators.addSpectators(oldPos);
+		newPosSpectators.addSpectators(newPos);
+		spectators.addSpectators(newPosSpectators);
+		checksum += spectators.size();
+	}
+	const auto mergeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+	std::cout << "SpectatorVec merge of two " << CROWD_SIZE << " creature screens, " << MOVES << " moves\n"
+	          << "linear find merge: " << linearTime / MOVES << " ns/move\n"
+	          << "SpectatorVec::addSpectators: " << mergeTime / MOVES << " ns/move\n"
+	          << "checksum " << checksum << std::endl;
+	return 0;
+}
@@ -0,0 +1,69 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../tasks.h"
+
+namespace {
+
+constexpr size_t TASKS = 5'000'000;
+
+using Clock = std::chrono::steady_clock;
+
+std::atomic<uint64_t> allocations{0};
+
+struct Connection
+{
+	uint64_t packets = 0;
+};
+
+// what most game tasks capture, a shared_ptr and a few ids
+template <typename Func>
+void run(const char* name)
+{
+	auto connection = std::make_shared<Connection>();
+	uint32_t playerId = 0x10000000, creatureId = 0x40000000;
+
+	// the pooled Task nodes are allocated once here and reused after
+	for (size_t i = 0; i < 1000; ++i) {
+		delete new Task(Func{[connection, playerId, creatureId]() { connection->packets += playerId ^ creatureId; }});
+	}
+
+	const uint64_t allocationsBefore = allocations;
+	const auto start = Clock::now();
+	for (size_t i = 0; i < TASKS; ++i) {
+		Task* task = new Task(Func{[connection, playerId, creatureId, i]() { connection->packets += playerId ^ i; }});
+		(*task)();
+		delete task;
+	}
+	const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+	const uint64_t taskAllocations = allocations - allocationsBefore;
+
+	std::cout << name << ": " << static_cast<double>(elapsed) / TASKS << " ns/task, "
+	          << static_cast<double>(taskAllocations) / TASKS << " allocations/task, "
+	          << static_cast<uint64_t>(taskAllocations * 1e9 / elapsed) << " allocations/s" << std::endl;
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+	++allocations;
+	if (void* p = std::malloc(size)) {
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+int main()
+{
+	std::cout << "Task creation, " << TASKS << " tasks capturing a shared_ptr and three ids\n";
+	// the std::function is moved into the TaskFunc, so it still allocates the way the task did before
+	run<std::function<void()>>("std::function");
+	run<TaskFunc>("TaskFunc");
+	return 0;
+}
@@ -0,0 +1,56 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "../xtea.h"
+
+namespace {
+
+// a map description burst is a few kilobytes, most creature updates are far smaller
+constexpr size_t MESSAGE_SIZES[] = {64, 512, 8192};
+constexpr size_t TOTAL_BYTES = 64 * 1024 * 1024;
+
+using Clock = std::chrono::steady_clock;
+
+const char* getBackendName(xtea::backend b)
+{
+	switch (b) {
+		case xtea::backend::scalar:
+			return "scalar";
+		case xtea::backend::sse2:
+			return "sse2";
+		case xtea::backend::avx2:
+			return "avx2";
+		case xtea::backend::neon:
+			return "neon";
+	}
+	return "unknown";
+}
+
+} // namespace
+
+int main()
+{
+	const auto k = xtea::expand_key({0xdeadbeef, 0xcafebabe, 0x8badf00d, 0xfeedface});
+
+	for (size_t size : MESSAGE_SIZES) {
+		std::vector<uint8_t> data(size, 0x5a);
+		for (auto b : {xtea::backend::scalar, xtea::backend::sse2, xtea::backend::avx2, xtea::backend::neon}) {
+			if (!xtea::is_supported(b)) {
+				continue;
+			}
+
+			auto start = Clock::now();
+			for (size_t done = 0; done < TOTAL_BYTES; done += size) {
+				xtea::encrypt(b, data.data(), data.size(), k);
+			}
+			const auto time = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+
+			std::cout << getBackendName(b) << " " << size << " byte messages: "
+			          << (TOTAL_BYTES * 1000.0 / time) << " MB/s (checksum " << static_cast<int>(data[0]) << ")"
+			          << std::endl;
+		}
+	}
+	return 0;
+}
@@ -107,8 +107,11 @@ bool ChatChannel::talk(const Player& fromPlayer, SpeakClasses type, std::string_
 		return false;
 	}
 
+	// the message is the same for every user
+	NetworkMessage msg;
+	ProtocolGame::buildToChannel(msg, &fromPlayer, type, text, id);
 	for (const auto& it : users) {
-		it.second->sendToChannel(&fromPlayer, type, text, id);
+		it.second->sendSharedMessage(msg);
 	}
 	return true;
 }
@@ -10,7 +10,8 @@
 class Party;
 class Player;
 
-using UsersMap = std::map<uint32_t, Player*>;
+// kept sorted in one block, channels are iterated on every message far more often than users join or leave
+using UsersMap = boost::container::flat_map<uint32_t, Player*>;
 using InvitedMap = std::map<uint32_t, const Player*>;
 
 class ChatChannel
@@ -9,6 +9,7 @@
 #include "events.h"
 #include "game.h"
 #include "matrixarea.h"
+#include "movement.h"
 #include "weapons.h"
 
 extern Game g_game;
@@ -16,31 +17,44 @@ extern Weapons* g_weapons;
 extern ConfigManager g_config;
 extern Events* g_events;
 
-std::vector<Tile*> getList(const MatrixArea& area, const Position& targetPos, const Direction dir)
+std::vector<Tile*> getList(const AreaCombat::CompiledArea& area, const Position& targetPos, const Direction dir)
 {
 	auto casterPos = getNextPosition(dir, targetPos);
 
 	std::vector<Tile*> vec;
+	vec.reserve(area.size());
+
+	for (const AreaCombat::Offset& offset : area) {
+		Position tmpPos(static_cast<uint16_t>(targetPos.x + offset.x), static_cast<uint16_t>(targetPos.y + offset.y),
+		                targetPos.z);
+		if (g_game.isSightClear(casterPos, tmpPos, true)) {
+			Tile* tile = g_game.map.getTile(tmpPos);
+			if (!tile) {
+				tile = new StaticTile(tmpPos.x, tmpPos.y, tmpPos.z);
+				g_game.map.setTile(tmpPos, tile);
+			}
+			vec.push_back(tile);
+		}
+	}
+	return vec;
+}
 
-	auto& center = area.getCenter();
+AreaCombat::CompiledArea compileArea(const MatrixArea& area)
+{
+	AreaCombat::CompiledArea offsets;
 
-	Position tmpPos(targetPos.x - center.first, targetPos.y - center.second, targetPos.z);
-	for (uint32_t row = 0; row < area.getRows(); ++row, ++tmpPos.y) {
-		for (uint32_t col = 0; col < area.getCols(); ++col, ++tmpPos.x) {
+	auto& center = area.getCenter();
+	const int32_t centerX = center.first;
+	const int32_t centerY = center.second;
+	for (uint32_t row = 0; row < area.getRows(); ++row) {
+		for (uint32_t col = 0; col < area.getCols(); ++col) {
 			if (area(row, col)) {
-				if (g_game.isSightClear(casterPos, tmpPos, true)) {
-					Tile* tile = g_game.map.getTile(tmpPos);
-					if (!tile) {
-						tile = new StaticTile(tmpPos.x, tmpPos.y, tmpPos.z);
-						g_game.map.setTile(tmpPos, tile);
-					}
-					vec.push_back(tile);
-				}
+				offsets.push_back({static_cast<int16_t>(static_cast<int32_t>(col) - centerX),
+				                   static_cast<int16_t>(static_cast<int32_t>(row) - centerY)});
 			}
 		}
-		tmpPos.x -= static_cast<uint16_t>(area.getCols());
 	}
-	return vec;
+	return offsets;
 }
 
 std::vector<Tile*> getCombatArea(const Position& centerPos, const Position& targetPos, const AreaCombat* area)
@@ -73,7 +87,9 @@ CombatDamage Combat::getCombatDamage(Creature* creature, Creature* target) const
 		if (creature->getCombatValues(min, max)) {
 			damage.primary.value = normal_random(min, max);
 		} else if (Player* player = creature->getPlayer()) {
-			if (params.valueCallback) {
+			if (linearFormula) {
+				linearFormula->getMinMaxValues(player, params.combatType == COMBAT_HEALING, damage);
+			} else if (params.valueCallback) {
 				params.valueCallback->getMinMaxValues(player, damage);
 			} else if (formulaType == COMBAT_FORMULA_LEVELMAGIC) {
 				int32_t levelFormula = player->getLevel() * 2 + player->getMagicLevel() * 3;
@@ -261,6 +277,9 @@ ReturnValue Combat::canDoCombat(Creature* caster, Tile* tile, bool aggressive)
 		return RETURNVALUE_ACTIONNOTPERMITTEDINPROTECTIONZONE;
 	}
 
+	if (!g_events->hasHandler<EventInfoId::CREATURE_ON_AREA_COMBAT>()) {
+		return RETURNVALUE_NOERROR;
+	}
 	return g_events->eventCreatureOnAreaCombat(caster, tile, aggressive);
 }
 
@@ -369,6 +388,10 @@ ReturnValue Combat::canDoCombat(Creature* attacker, Creature* target)
 			}
 		}
 	}
+
+	if (!g_events->hasHandler<EventInfoId::CREATURE_ON_TARGET_COMBAT>()) {
+		return RETURNVALUE_NOERROR;
+	}
 	return g_events->eventCreatureOnTargetCombat(attacker, target);
 }
 
@@ -931,6 +954,9 @@ void Combat::doAreaCombat(Creature* caster, const Position& position, const Area
 
 	postCombatEffects(caster, position, params);
 
+	// the fields and corpses created on every tile fire their move events once the whole area is done
+	MoveEventBatch moveEventBatch;
+
 	std::vector<Creature*> toDamageCreatures;
 	toDamageCreatures.reserve(100);
 
@@ -966,13 +992,12 @@ void Combat::doAreaCombat(Creature* caster, const Position& position, const Area
 		}
 	}
 
-	CombatDamage leechCombat;
-	leechCombat.origin = ORIGIN_NONE;
-	leechCombat.leeched = true;
-
+	// the damage of every target only depends on the caster and the target, so it is settled in one pass before
+	// the hits, which have side effects, are applied
+	std::vector<CombatDamage> targetDamages;
+	targetDamages.reserve(toDamageCreatures.size());
 	for (Creature* creature : toDamageCreatures) {
-		CombatDamage damageCopy = damage; // we cannot avoid copying here, because we don't know if it's player combat
-		                                  // or not, so we can't modify the initial damage.
+		CombatDamage& damageCopy = targetDamages.emplace_back(damage);
 		bool playerCombatReduced = false;
 		if ((damageCopy.primary.value < 0 || damageCopy.secondary.value < 0) && caster) {
 			Player* targetPlayer = creature->getPlayer();
@@ -987,6 +1012,25 @@ void Combat::doAreaCombat(Creature* caster, const Position& position, const Area
 		if (damageCopy.critical) {
 			damageCopy.primary.value += playerCombatReduced ? criticalPrimary / 2 : criticalPrimary;
 			damageCopy.secondary.value += playerCombatReduced ? criticalSecondary / 2 : criticalSecondary;
+		}
+	}
+
+	// neither does the leech of the caster
+	const bool canLeech =
+	    casterPlayer && !damage.leeched && damage.primary.type != COMBAT_HEALING && damage.origin != ORIGIN_CONDITION;
+	const uint16_t lifeLeechChance = canLeech ? casterPlayer->getSpecialSkill(SPECIALSKILL_LIFELEECHCHANCE) : 0;
+	const uint16_t lifeLeechSkill = canLeech ? casterPlayer->getSpecialSkill(SPECIALSKILL_LIFELEECHAMOUNT) : 0;
+	const uint16_t manaLeechChance = canLeech ? casterPlayer->getSpecialSkill(SPECIALSKILL_MANALEECHCHANCE) : 0;
+	const uint16_t manaLeechSkill = canLeech ? casterPlayer->getSpecialSkill(SPECIALSKILL_MANALEECHAMOUNT) : 0;
+
+	CombatDamage leechCombat;
+	leechCombat.origin = ORIGIN_NONE;
+	leechCombat.leeched = true;
+
+	for (size_t i = 0; i < toDamageCreatures.size(); ++i) {
+		Creature* creature = toDamageCreatures[i];
+		CombatDamage& damageCopy = targetDamages[i];
+		if (damageCopy.critical) {
 			g_game.addMagicEffect(creature->getPosition(), CONST_ME_BLOODYSTEPS);
 		}
 
@@ -1018,13 +1062,12 @@ void Combat::doAreaCombat(Creature* caster, const Position& position, const Area
 
 			int32_t totalDamage = std::abs(damageCopy.primary.value + damageCopy.secondary.value);
 
-			if (casterPlayer && !damage.leeched && damage.primary.type != COMBAT_HEALING &&
-			    damage.origin != ORIGIN_CONDITION) {
+			if (canLeech) {
 				int32_t targetsCount = toDamageCreatures.size();
 
 				if (casterPlayer->getHealth() < casterPlayer->getMaxHealth()) {
-					uint16_t chance = casterPlayer->getSpecialSkill(SPECIALSKILL_LIFELEECHCHANCE);
-					uint16_t skill = casterPlayer->getSpecialSkill(SPECIALSKILL_LIFELEECHAMOUNT);
+					uint16_t chance = lifeLeechChance;
+					uint16_t skill = lifeLeechSkill;
 					if (chance > 0 && skill > 0 && normal_random(1, 100) <= chance) {
 						leechCombat.primary.value =
 						    std::ceil(totalDamage * ((skill / 100.) + ((targetsCount - 1) * ((skill / 100.) / 10.))) /
@@ -1035,8 +1078,8 @@ void Combat::doAreaCombat(Creature* caster, const Position& position, const Area
 				}
 
 				if (casterPlayer->getMana() < casterPlayer->getMaxMana()) {
-					uint16_t chance = casterPlayer->getSpecialSkill(SPECIALSKILL_MANALEECHCHANCE);
-					uint16_t skill = casterPlayer->getSpecialSkill(SPECIALSKILL_MANALEECHAMOUNT);
+					uint16_t chance = manaLeechChance;
+					uint16_t skill = manaLeechSkill;
 					if (chance > 0 && skill > 0 && normal_random(1, 100) <= chance) {
 						leechCombat.primary.value =
 						    std::ceil(totalDamage * ((skill / 100.) + ((targetsCount - 1) * ((skill / 100.) / 10.))) /
@@ -1062,6 +1105,43 @@ void Combat::doAreaCombat(Creature* caster, const Position& position, const Area
 
 //**********************************************************//
 
+void CombatFormula::getMinMaxValues(Player* player, bool healing, CombatDamage& damage) const
+{
+	int32_t skill = 0;
+	int32_t attackValue = 0;
+	if (min.skill != 0 || min.attack != 0 || min.skillAttack != 0 || max.skill != 0 || max.attack != 0 ||
+	    max.skillAttack != 0) {
+		// the same weapon values the skill callback is given
+		Item* tool = player->getWeapon();
+		const Weapon* weapon = g_weapons->getWeapon(tool);
+		Item* item = nullptr;
+
+		attackValue = 7;
+		if (weapon) {
+			attackValue = tool->getAttack();
+			if (tool->getWeaponType() == WEAPON_AMMO) {
+				item = player->getWeapon(true);
+				if (item) {
+					attackValue += item->getAttack();
+				}
+			}
+
+			damage.secondary.type = weapon->getElementType();
+			damage.secondary.value = weapon->getElementDamage(player, nullptr, tool);
+		}
+		skill = player->getWeaponSkill(item ? item : tool);
+	}
+
+	const int32_t level = player->getLevel();
+	const int32_t magicLevel = player->getMagicLevel();
+	auto evaluate = [=](const Coefficients& c) {
+		const double value = c.level * level + c.magicLevel * magicLevel + c.skill * skill + c.attack * attackValue +
+		                     c.skillAttack * skill * attackValue + c.base;
+		return static_cast<int32_t>(healing ? value : -value);
+	};
+	damage.primary.value = normal_random(evaluate(min), evaluate(max));
+}
+
 void ValueCallback::getMinMaxValues(Player* player, CombatDamage& damage) const
 {
 	// onGetPlayerMinMaxValues(...)
@@ -1220,7 +1300,7 @@ void TargetCallback::onTargetCombat(Creature* creature, Creature* target) const
 	scriptInterface->resetScriptEnv();
 }
 
-const MatrixArea& AreaCombat::getArea(const Position& centerPos, const Position& targetPos) const
+const AreaCombat::CompiledArea& AreaCombat::getArea(const Position& centerPos, const Position& targetPos) const
 {
 	int32_t dx = targetPos.getOffsetX(centerPos);
 	int32_t dy = targetPos.getOffsetY(centerPos);
@@ -1250,7 +1330,7 @@ const MatrixArea& AreaCombat::getArea(const Position& centerPos, const Position&
 
 	if (dir >= areas.size()) {
 		// this should not happen. it means we forgot to call setupArea.
-		static MatrixArea empty;
+		static const CompiledArea empty;
 		return empty;
 	}
 	return areas[dir];
@@ -1263,10 +1343,10 @@ void AreaCombat::setupArea(const std::vector<uint32_t>& vec, uint32_t rows)
 		areas.resize(4);
 	}
 
-	areas[DIRECTION_EAST] = area.rotate90();
-	areas[DIRECTION_SOUTH] = area.rotate180();
-	areas[DIRECTION_WEST] = area.rotate270();
-	areas[DIRECTION_NORTH] = std::move(area);
+	areas[DIRECTION_EAST] = compileArea(area.rotate90());
+	areas[DIRECTION_SOUTH] = compileArea(area.rotate180());
+	areas[DIRECTION_WEST] = compileArea(area.rotate270());
+	areas[DIRECTION_NORTH] = compileArea(area);
 }
 
 void AreaCombat::setupArea(int32_t length, int32_t spread)
@@ -1367,10 +1447,10 @@ void AreaCombat::setupExtArea(const std::vector<uint32_t>& vec, uint32_t rows)
 	hasExtArea = true;
 	auto area = createArea(vec, rows);
 	areas.resize(8);
-	areas[DIRECTION_NORTHEAST] = area.mirror();
-	areas[DIRECTION_SOUTHWEST] = area.flip();
-	areas[DIRECTION_SOUTHEAST] = area.rotate180();
-	areas[DIRECTION_NORTHWEST] = std::move(area);
+	areas[DIRECTION_NORTHEAST] = compileArea(area.mirror());
+	areas[DIRECTION_SOUTHWEST] = compileArea(area.flip());
+	areas[DIRECTION_SOUTHEAST] = compileArea(area.rotate180());
+	areas[DIRECTION_NORTHWEST] = compileArea(area);
 }
 
 //**********************************************************//
@@ -30,6 +30,27 @@ private:
 	formulaType_t type;
 };
 
+// min and max of a combat as linear functions of the caster, set up once by the script and evaluated without lua
+struct CombatFormula
+{
+	struct Coefficients
+	{
+		double level = 0.0;
+		double magicLevel = 0.0;
+		double skill = 0.0;
+		double attack = 0.0;
+		// weapon skill times attack value, how most weapon spells scale
+		double skillAttack = 0.0;
+		double base = 0.0;
+	};
+
+	// the values are amounts, they are turned into damage unless the combat heals
+	void getMinMaxValues(Player* player, bool healing, CombatDamage& damage) const;
+
+	Coefficients min;
+	Coefficients max;
+};
+
 class TileCallback final : public CallBack
 {
 public:
@@ -70,15 +91,23 @@ struct CombatParams
 class AreaCombat
 {
 public:
+	// the cells of an area for one direction as offsets from the target in row order, compiled when it is set up
+	struct Offset
+	{
+		int16_t x;
+		int16_t y;
+	};
+	using CompiledArea = std::vector<Offset>;
+
 	void setupArea(const std::vector<uint32_t>& vec, uint32_t rows);
 	void setupArea(int32_t length, int32_t spread);
 	void setupArea(int32_t radius);
 	void setupAreaRing(int32_t ring);
 	void setupExtArea(const std::vector<uint32_t>& vec, uint32_t rows);
-	const MatrixArea& getArea(const Position& centerPos, const Position& targetPos) const;
+	const CompiledArea& getArea(const Position& centerPos, const Position& targetPos) const;
 
 private:
-	std::vector<MatrixArea> areas;
+	std::vector<CompiledArea> areas;
 	bool hasExtArea = false;
 };
 
@@ -122,6 +151,8 @@ public:
 	void addCondition(const Condition* condition) { params.conditionList.emplace_front(condition); }
 	void clearConditions() { params.conditionList.clear(); }
 	void setPlayerCombatValues(formulaType_t formulaType, double mina, double minb, double maxa, double maxb);
+	// takes precedence over a value callback
+	void setLinearFormula(const CombatFormula& formula) { linearFormula = formula; }
 	void postCombatEffects(Creature* caster, const Position& pos) const { postCombatEffects(caster, pos, params); }
 
 	void setOrigin(CombatOrigin origin) { params.origin = origin; }
@@ -140,6 +171,7 @@ private:
 	double minb = 0.0;
 	double maxa = 0.0;
 	double maxb = 0.0;
+	std::optional<CombatFormula> linearFormula;
 
 	std::unique_ptr<AreaCombat> area;
 };
@@ -7,10 +7,23 @@
 
 #include "configmanager.h"
 #include "game.h"
+#include "memorystats.h"
 
 extern Game g_game;
 extern ConfigManager g_config;
 
+void* Condition::operator new(size_t size)
+{
+	MemoryStats::allocated(MEMORY_CONDITIONS, size);
+	return ::operator new(size);
+}
+
+void Condition::operator delete(void* p, size_t size)
+{
+	MemoryStats::freed(MEMORY_CONDITIONS, size);
+	::operator delete(p);
+}
+
 bool Condition::setParam(ConditionParam_t param, int32_t value)
 {
 	switch (param) {
@@ -44,7 +57,7 @@ int32_t Condition::getParam(ConditionParam_t param) const
 {
 	switch (param) {
 		case CONDITION_PARAM_TICKS:
-			return ticks;
+			return getTicks();
 
 		case CONDITION_PARAM_BUFF_SPELL:
 			return isBuff ? 1 : 0;
@@ -150,7 +163,7 @@ void Condition::serialize(PropWriteStream& propWriteStream)
 	propWriteStream.write<uint32_t>(id);
 
 	propWriteStream.write<uint8_t>(CONDITIONATTR_TICKS);
-	propWriteStream.write<uint32_t>(ticks);
+	propWriteStream.write<uint32_t>(getTicks());
 
 	propWriteStream.write<uint8_t>(CONDITIONATTR_ISBUFF);
 	propWriteStream.write<uint8_t>(isBuff);
@@ -177,6 +190,15 @@ void Condition::setEndTime(int64_t newEndTime)
 	}
 }
 
+int32_t Condition::getTicks() const
+{
+	// only ticking conditions count their ticks down, derive what is left of the others from their end time
+	if (ticks > 0 && endTime != 0 && !isTicking()) {
+		return static_cast<int32_t>(std::clamp<int64_t>(endTime - OTSYS_TIME(), 0, ticks));
+	}
+	return ticks;
+}
+
 void Condition::setTicks(int32_t newTicks)
 {
 	ticks = newTicks;
@@ -79,6 +79,10 @@ public:
 	{}
 	virtual ~Condition() = default;
 
+	// accounted in the memory stats
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	virtual bool startCondition(Creature* creature);
 	virtual bool executeCondition(Creature* creature, int32_t interval);
 	virtual void endCondition(Creature* creature) = 0;
@@ -92,8 +96,10 @@ public:
 	ConditionType_t getType() const { return conditionType; }
 	int64_t getEndTime() const { return endTime; }
 	void setEndTime(int64_t newEndTime);
-	int32_t getTicks() const { return ticks; }
+	int32_t getTicks() const;
 	void setTicks(int32_t newTicks);
+	// conditions that do work on every think, the others only need executing once they run out
+	virtual bool isTicking() const { return false; }
 	bool isAggressive() const { return aggressive; }
 
 	static Condition* createCondition(ConditionId_t id, ConditionType_t type, int32_t ticks, int32_t param = 0,
@@ -198,6 +204,7 @@ public:
 
 	void addCondition(Creature* creature, const Condition* condition) override;
 	bool executeCondition(Creature* creature, int32_t interval) override;
+	bool isTicking() const override { return true; }
 
 	bool setParam(ConditionParam_t param, int32_t value) override;
 	int32_t getParam(ConditionParam_t param) const override;
@@ -230,6 +237,7 @@ public:
 
 	void addCondition(Creature* creature, const Condition* condition) override;
 	bool executeCondition(Creature* creature, int32_t interval) override;
+	bool isTicking() const override { return true; }
 
 	bool setParam(ConditionParam_t param, int32_t value) override;
 	int32_t getParam(ConditionParam_t param) const override;
@@ -273,6 +281,7 @@ public:
 
 	bool startCondition(Creature* creature) override;
 	bool executeCondition(Creature* creature, int32_t interval) override;
+	bool isTicking() const override { return true; }
 	void endCondition(Creature* creature) override;
 	void addCondition(Creature* creature, const Condition* condition) override;
 	uint32_t getIcons() const override;
@@ -308,7 +317,7 @@ private:
 
 	bool init();
 
-	std::list<IntervalInfo> damageList;
+	std::deque<IntervalInfo> damageList;
 
 	bool getNextDamage(int32_t& damage);
 	bool doDamage(Creature* creature, int32_t healthChange);
@@ -386,6 +395,7 @@ public:
 
 	bool startCondition(Creature* creature) override;
 	bool executeCondition(Creature* creature, int32_t interval) override;
+	bool isTicking() const override { return true; }
 	void endCondition(Creature* creature) override;
 	void addCondition(Creature* creature, const Condition* condition) override;
 
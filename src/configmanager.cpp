@@ -7,6 +7,7 @@
 #include "configmanager.h"
 
 #include "game.h"
+#include "logger.h"
 #include "monster.h"
 #include "pugicast.h"
 
@@ -83,7 +84,11 @@ bool getGlobalBoolean(lua_State* L, const char* identifier, const bool defaultVa
 
 } // namespace
 
-ConfigManager::ConfigManager() { strings[ConfigKeysString::CONFIG_FILE] = "config.lua"; }
+ConfigManager::ConfigManager()
+{
+	strings[ConfigKeysString::CONFIG_FILE] = "config.lua";
+	integers[ConfigKeysInteger::REPLAY_SPEED] = 1;
+}
 
 namespace {
 
@@ -170,6 +175,9 @@ bool ConfigManager::load()
 	if (!loaded) { // info that must be loaded one time (unless we reset the modules involved)
 		booleans[ConfigKeysBoolean::BIND_ONLY_GLOBAL_ADDRESS] = getGlobalBoolean(L, "bindOnlyGlobalAddress", false);
 		booleans[ConfigKeysBoolean::OPTIMIZE_DATABASE] = getGlobalBoolean(L, "startupDatabaseOptimization", true);
+		booleans[ConfigKeysBoolean::MAP_CHUNKED_STORAGE] = getGlobalBoolean(L, "useChunkedMapStorage", false);
+		booleans[ConfigKeysBoolean::MAP_PAGED_STORAGE] = getGlobalBoolean(L, "mapPagedStorage", false);
+		booleans[ConfigKeysBoolean::SHARE_STATIC_TILE_ITEMS] = getGlobalBoolean(L, "shareStaticTileItems", false);
 
 		if (strings[ConfigKeysString::IP] == "") {
 			strings[ConfigKeysString::IP] = getGlobalString(L, "ip", "127.0.0.1");
@@ -240,6 +248,13 @@ bool ConfigManager::load()
 	booleans[ConfigKeysBoolean::REMOVE_ON_DESPAWN] = getGlobalBoolean(L, "removeOnDespawn", true);
 	booleans[ConfigKeysBoolean::MONSTER_OVERSPAWN] = getGlobalBoolean(L, "monsterOverspawn", false);
 	booleans[ConfigKeysBoolean::ACCOUNT_MANAGER] = getGlobalBoolean(L, "accountManager", true);
+	booleans[ConfigKeysBoolean::BATCH_EFFECTS] = getGlobalBoolean(L, "batchEffects", true);
+	booleans[ConfigKeysBoolean::MAP_CACHE] = getGlobalBoolean(L, "mapCache", false);
+	booleans[ConfigKeysBoolean::NPCS_SLEEP_WITHOUT_PLAYERS] = getGlobalBoolean(L, "npcsSleepWithoutPlayers", true);
+	booleans[ConfigKeysBoolean::NPC_SEPARATE_LUA_STATE] = getGlobalBoolean(L, "separateNpcLuaState", false);
+	booleans[ConfigKeysBoolean::COALESCE_HEALTH_UPDATES] = getGlobalBoolean(L, "coalesceHealthUpdates", true);
+	booleans[ConfigKeysBoolean::COMPACT_HOUSE_ITEMS] = getGlobalBoolean(L, "compactHouseItems", false);
+	booleans[ConfigKeysBoolean::SERVE_LOGIN] = getGlobalBoolean(L, "serveLogin", true);
 
 	strings[ConfigKeysString::DEFAULT_PRIORITY] = getGlobalString(L, "defaultPriority", "high");
 	strings[ConfigKeysString::SERVER_NAME] = getGlobalString(L, "serverName", "");
@@ -249,6 +264,14 @@ bool ConfigManager::load()
 	strings[ConfigKeysString::LOCATION] = getGlobalString(L, "location", "");
 	strings[ConfigKeysString::MOTD] = getGlobalString(L, "motd", "");
 	strings[ConfigKeysString::WORLD_TYPE] = getGlobalString(L, "worldType", "pvp");
+	strings[ConfigKeysString::HANDOVER_SOCKET] = getGlobalString(L, "handoverSocket", "");
+	strings[ConfigKeysString::DISPATCHER_CPUS] = getGlobalString(L, "dispatcherCpus", "");
+	strings[ConfigKeysString::SCHEDULER_CPUS] = getGlobalString(L, "schedulerCpus", "");
+	strings[ConfigKeysString::DATABASE_CPUS] = getGlobalString(L, "databaseCpus", "");
+	strings[ConfigKeysString::NETWORK_CPUS] = getGlobalString(L, "networkCpus", "");
+	strings[ConfigKeysString::JOB_CPUS] = getGlobalString(L, "jobCpus", "");
+	strings[ConfigKeysString::LOG_LEVEL] = getGlobalString(L, "logLevel", "info");
+	strings[ConfigKeysString::LOG_FORMAT] = getGlobalString(L, "logFormat", "text");
 
 	Monster::despawnRange = getGlobalInteger(L, "deSpawnRange", 2);
 	Monster::despawnRadius = getGlobalInteger(L, "deSpawnRadius", 50);
@@ -305,6 +328,30 @@ bool ConfigManager::load()
 	    getGlobalInteger(L, "RANGE_USE_ITEM_EX_INTERVAL", RANGE_USE_ITEM_EX_INTERVAL);
 	integers[ConfigKeysInteger::RANGE_ROTATE_ITEM_INTERVAL] =
 	    getGlobalInteger(L, "RANGE_ROTATE_ITEM_INTERVAL", RANGE_ROTATE_ITEM_INTERVAL);
+	integers[ConfigKeysInteger::DISPATCHER_STATS_LOG_INTERVAL] = getGlobalInteger(L, "dispatcherStatsLogInterval", 0);
+	integers[ConfigKeysInteger::JOB_THREADS] =
+	    getGlobalInteger(L, "jobThreads", getGlobalInteger(L, "pathfindingThreads", 0));
+	integers[ConfigKeysInteger::NETWORK_THREADS] = getGlobalInteger(L, "networkThreads", 1);
+	integers[ConfigKeysInteger::DATABASE_THREADS] = getGlobalInteger(L, "databaseThreads", 1);
+	integers[ConfigKeysInteger::LUA_GC_STEP_BUDGET] = getGlobalInteger(L, "luaGcStepBudget", 0);
+	integers[ConfigKeysInteger::LOGIN_CACHE_TIME] = getGlobalInteger(L, "loginCacheTime", 30);
+	integers[ConfigKeysInteger::SLOW_TICK_THRESHOLD] = getGlobalInteger(L, "slowTickThreshold", 50);
+	integers[ConfigKeysInteger::METRICS_PORT] = getGlobalInteger(L, "metricsProtocolPort", 0);
+	integers[ConfigKeysInteger::MAP_CLEAN_TILES_PER_TICK] = getGlobalInteger(L, "mapCleanTilesPerTick", 500);
+	integers[ConfigKeysInteger::MAP_PAGE_IDLE_TIME] = getGlobalInteger(L, "mapPageIdleTime", 300);
+	integers[ConfigKeysInteger::OVERLOAD_EFFECTS_LAG] = getGlobalInteger(L, "overloadCoalesceEffectsLag", 20);
+	integers[ConfigKeysInteger::OVERLOAD_MONSTER_THINK_LAG] = getGlobalInteger(L, "overloadSlowMonsterThinkLag", 40);
+	integers[ConfigKeysInteger::OVERLOAD_SAVES_LAG] = getGlobalInteger(L, "overloadDeferSavesLag", 80);
+	integers[ConfigKeysInteger::OVERLOAD_GLOBALEVENTS_LAG] =
+	    getGlobalInteger(L, "overloadThrottleGlobalEventsLag", 150);
+	integers[ConfigKeysInteger::MONSTER_FULL_THINK_DISTANCE] = getGlobalInteger(L, "monsterFullThinkDistance", 7);
+	integers[ConfigKeysInteger::FLOW_FIELD_CHASERS] = getGlobalInteger(L, "flowFieldChasers", 4);
+	integers[ConfigKeysInteger::MAX_FOLLOW_REPLANS] = getGlobalInteger(L, "maxFollowReplansPerCheck", 30);
+	integers[ConfigKeysInteger::SEND_QUEUE_SOFT_LIMIT] = getGlobalInteger(L, "sendQueueSoftLimit", 256);
+	integers[ConfigKeysInteger::SEND_QUEUE_HARD_LIMIT] = getGlobalInteger(L, "sendQueueHardLimit", 4096);
+	integers[ConfigKeysInteger::SLOW_QUERY_TIME] = getGlobalInteger(L, "slowQueryTime", 200);
+	integers[ConfigKeysInteger::ROLLING_SAVE_INTERVAL] = getGlobalInteger(L, "rollingSaveInterval", 0);
+	integers[ConfigKeysInteger::LOG_REPEAT_LIMIT] = getGlobalInteger(L, "logRepeatLimit", 5);
 
 	expStages = loadXMLStages();
 	if (expStages.empty()) {
@@ -319,6 +366,7 @@ bool ConfigManager::load()
 	loaded = true;
 	lua_close(L);
 
+	Logger::configure();
 	return true;
 }
 
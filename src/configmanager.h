@@ -46,6 +46,17 @@ enum class ConfigKeysBoolean
 	REMOVE_ON_DESPAWN,
 	MONSTER_OVERSPAWN,
 	ACCOUNT_MANAGER,
+	MAP_CHUNKED_STORAGE,
+	BATCH_EFFECTS,
+	MAP_CACHE,
+	NPCS_SLEEP_WITHOUT_PLAYERS,
+	NPC_SEPARATE_LUA_STATE,
+	COALESCE_HEALTH_UPDATES,
+	MAP_PAGED_STORAGE,
+	SHARE_STATIC_TILE_ITEMS,
+	COMPACT_HOUSE_ITEMS,
+	SERVE_LOGIN,
+	HANDOVER,
 
 	LAST /* this must be the last one */
 };
@@ -70,6 +81,15 @@ enum class ConfigKeysString
 	DEFAULT_PRIORITY,
 	MAP_AUTHOR,
 	CONFIG_FILE,
+	REPLAY_FILE,
+	HANDOVER_SOCKET,
+	DISPATCHER_CPUS,
+	SCHEDULER_CPUS,
+	DATABASE_CPUS,
+	NETWORK_CPUS,
+	JOB_CPUS,
+	LOG_LEVEL,
+	LOG_FORMAT,
 
 	LAST /* this must be the last one */
 };
@@ -126,6 +146,29 @@ enum class ConfigKeysInteger
 	RANGE_USE_ITEM_INTERVAL,
 	RANGE_USE_ITEM_EX_INTERVAL,
 	RANGE_ROTATE_ITEM_INTERVAL,
+	DISPATCHER_STATS_LOG_INTERVAL,
+	JOB_THREADS,
+	NETWORK_THREADS,
+	DATABASE_THREADS,
+	LUA_GC_STEP_BUDGET,
+	LOGIN_CACHE_TIME,
+	SLOW_TICK_THRESHOLD,
+	METRICS_PORT,
+	REPLAY_SPEED,
+	MAP_CLEAN_TILES_PER_TICK,
+	MAP_PAGE_IDLE_TIME,
+	OVERLOAD_EFFECTS_LAG,
+	OVERLOAD_MONSTER_THINK_LAG,
+	OVERLOAD_SAVES_LAG,
+	OVERLOAD_GLOBALEVENTS_LAG,
+	MONSTER_FULL_THINK_DISTANCE,
+	FLOW_FIELD_CHASERS,
+	MAX_FOLLOW_REPLANS,
+	SEND_QUEUE_SOFT_LIMIT,
+	SEND_QUEUE_HARD_LIMIT,
+	SLOW_QUERY_TIME,
+	ROLLING_SAVE_INTERVAL,
+	LOG_REPEAT_LIMIT,
 
 	LAST /* this must be the last one */
 };
@@ -6,6 +6,7 @@
 #include "connection.h"
 
 #include "configmanager.h"
+#include "metrics.h"
 #include "outputmessage.h"
 #include "protocol.h"
 #include "scheduler.h"
@@ -13,36 +14,85 @@
 
 extern ConfigManager g_config;
 
+void ConnectionManager::addShard(boost::asio::io_service& service)
+{
+	if (!getShard(service)) {
+		shards.emplace_back(std::make_unique<Shard>(service));
+	}
+}
+
+ConnectionManager::Shard* ConnectionManager::getShard(boost::asio::io_service& service) const
+{
+	// one shard per network thread, a handful at most
+	for (const auto& shard : shards) {
+		if (&shard->service == &service) {
+			return shard.get();
+		}
+	}
+	return nullptr;
+}
+
 Connection_ptr ConnectionManager::createConnection(boost::asio::io_service& io_service,
                                                    ConstServicePort_ptr servicePort)
 {
-	std::lock_guard<std::mutex> lockClass(connectionManagerLock);
+	Shard* shard = getShard(io_service);
+	assert(shard);
 
 	auto connection = std::make_shared<Connection>(io_service, servicePort);
-	connections.insert(connection);
+	connection->shard = shard;
+
+	std::lock_guard<std::mutex> lockClass(shard->lock);
+	shard->connections.insert(connection);
 	return connection;
 }
 
 void ConnectionManager::releaseConnection(const Connection_ptr& connection)
 {
-	std::lock_guard<std::mutex> lockClass(connectionManagerLock);
-
-	connections.erase(connection);
+	Shard* shard = connection->shard;
+	std::lock_guard<std::mutex> lockClass(shard->lock);
+	shard->connections.erase(connection);
 }
 
 void ConnectionManager::closeAll()
 {
-	std::lock_guard<std::mutex> lockClass(connectionManagerLock);
+	for (const auto& shard : shards) {
+		std::lock_guard<std::mutex> lockClass(shard->lock);
+
+		for (const auto& connection : shard->connections) {
+			try {
+				boost::system::error_code error;
+				connection->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
+				connection->socket.close(error);
+			} catch (boost::system::system_error&) {
+			}
+		}
+		shard->connections.clear();
+	}
+}
 
-	for (const auto& connection : connections) {
-		try {
-			boost::system::error_code error;
-			connection->socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
-			connection->socket.close(error);
-		} catch (boost::system::system_error&) {
+void ConnectionManager::closeIdleConnections(boost::asio::io_service& service)
+{
+	Shard* shard = getShard(service);
+	if (!shard) {
+		return;
+	}
+
+	const int64_t now = Connection::getSteadySeconds();
+
+	std::vector<Connection_ptr> idleConnections;
+	{
+		std::lock_guard<std::mutex> lockClass(shard->lock);
+		for (const auto& connection : shard->connections) {
+			if (now - connection->lastReceived >= CONNECTION_READ_TIMEOUT) {
+				idleConnections.push_back(connection);
+			}
 		}
 	}
-	connections.clear();
+
+	// closing releases the connection, which takes the lock again
+	for (const auto& connection : idleConnections) {
+		connection->close(Connection::FORCE_CLOSE);
+	}
 }
 
 // Connection
@@ -58,11 +108,12 @@ void Connection::close(bool force)
 	}
 	closed = true;
 
-	if (protocol) {
+	if (protocol && !rawStream) {
+		TaskOriginScope originScope{makeTaskOrigin(TASK_ORIGIN_NETWORK)};
 		g_dispatcher.addTask([protocol = protocol]() { protocol->release(); });
 	}
 
-	if (messageQueue.empty() || force) {
+	if (writingQueue.empty() || force) {
 		closeSocket();
 	} else {
 		// will be closed by the destructor or onWriteOperation
@@ -73,7 +124,6 @@ void Connection::closeSocket()
 {
 	if (socket.is_open()) {
 		try {
-			readTimer.cancel();
 			writeTimer.cancel();
 			boost::system::error_code error;
 			socket.shutdown(boost::asio::ip::tcp::socket::shutdown_both, error);
@@ -89,7 +139,17 @@ Connection::~Connection() { closeSocket(); }
 void Connection::accept(Protocol_ptr protocol)
 {
 	this->protocol = protocol;
-	g_dispatcher.addTask([=]() { protocol->onConnect(); });
+	if (protocol->isRawStream()) {
+		std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+		rawStream = true;
+		readRaw();
+		return;
+	}
+
+	{
+		TaskOriginScope originScope{makeTaskOrigin(TASK_ORIGIN_NETWORK)};
+		g_dispatcher.addTask([=]() { protocol->onConnect(); });
+	}
 
 	accept();
 }
@@ -97,30 +157,26 @@ void Connection::accept(Protocol_ptr protocol)
 void Connection::accept()
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
-	try {
-		readTimer.expires_from_now(std::chrono::seconds(CONNECTION_READ_TIMEOUT));
-		readTimer.async_wait(
-		    [thisPtr = std::weak_ptr<Connection>(shared_from_this())](const boost::system::error_code& error) {
-			    Connection::handleTimeout(thisPtr, error);
-		    });
+	read();
+}
 
-		// Read size of the first packet
-		boost::asio::async_read(
-		    socket, boost::asio::buffer(msg.getBuffer(), NetworkMessage::HEADER_LENGTH),
-		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
-			    thisPtr->parseHeader(error);
+void Connection::read()
+{
+	try {
+		socket.async_read_some(
+		    boost::asio::buffer(readBuffer.data() + readEnd, readBuffer.size() - readEnd),
+		    [thisPtr = shared_from_this()](const boost::system::error_code& error, size_t bytes_transferred) {
+			    thisPtr->onRead(error, bytes_transferred);
 		    });
 	} catch (boost::system::system_error& e) {
-		std::cout << "[Network error - Connection::accept] " << e.what() << std::endl;
+		std::cout << "[Network error - Connection::read] " << e.what() << std::endl;
 		close(FORCE_CLOSE);
 	}
 }
 
-void Connection::parseHeader(const boost::system::error_code& error)
+void Connection::onRead(const boost::system::error_code& error, size_t size)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
-	readTimer.cancel();
-
 	if (error) {
 		close(FORCE_CLOSE);
 		return;
@@ -128,49 +184,81 @@ void Connection::parseHeader(const boost::system::error_code& error)
 		return;
 	}
 
-	uint32_t timePassed = std::max<uint32_t>(1, (time(nullptr) - timeConnected) + 1);
-	if ((++packetsSent / timePassed) > g_config[ConfigKeysInteger::MAX_PACKETS_PER_SECOND]) {
-		std::cout << convertIPToString(getIP()) << " disconnected for exceeding packet per second limit." << std::endl;
-		close();
-		return;
+	lastReceived = getSteadySeconds();
+	metrics::bytesReceived.add(size);
+
+	readEnd += size;
+	if (parsePackets()) {
+		read();
 	}
+}
 
-	if (timePassed > 2) {
-		timeConnected = time(nullptr);
-		packetsSent = 0;
+bool Connection::parsePackets()
+{
+	while (readEnd - readStart >= NetworkMessage::HEADER_LENGTH) {
+		const uint8_t* packet = readBuffer.data() + readStart;
+		const uint16_t size = static_cast<uint16_t>(packet[0] | packet[1] << 8);
+		if (size == 0 || size >= NETWORKMESSAGE_MAXSIZE - 16) {
+			close(FORCE_CLOSE);
+			return false;
+		}
+
+		const size_t packetSize = NetworkMessage::HEADER_LENGTH + size;
+		const size_t received = std::min(packetSize, readEnd - readStart);
+		if (received < packetSize && packetSize <= readBuffer.size()) {
+			// the rest comes with the next read
+			break;
+		}
+
+		if (!checkPacketRate()) {
+			return false;
+		}
+
+		// the message may read up to the initial buffer position past its length
+		msg.reserve(packetSize + NetworkMessage::INITIAL_BUFFER_POSITION);
+		msg.setLength(packetSize);
+		msg.getBodyBuffer();
+		std::memcpy(msg.getBuffer(), packet, received);
+		readStart += received;
+
+		if (received < packetSize) {
+			readStart = readEnd = 0;
+			readPacketBody(received);
+			return false;
+		}
+
+		if (!parsePacket()) {
+			return false;
+		}
 	}
 
-	uint16_t size = msg.getLengthHeader();
-	if (size == 0 || size >= NETWORKMESSAGE_MAXSIZE - 16) {
-		close(FORCE_CLOSE);
-		return;
+	// a partial packet moves to the front, so the next read has room for the rest of it
+	if (readStart != 0) {
+		std::memmove(readBuffer.data(), readBuffer.data() + readStart, readEnd - readStart);
+		readEnd -= readStart;
+		readStart = 0;
 	}
+	return true;
+}
 
+void Connection::readPacketBody(size_t received)
+{
 	try {
-		readTimer.expires_from_now(std::chrono::seconds(CONNECTION_READ_TIMEOUT));
-		readTimer.async_wait(
-		    [thisPtr = std::weak_ptr<Connection>(shared_from_this())](const boost::system::error_code& error) {
-			    Connection::handleTimeout(thisPtr, error);
-		    });
-
-		// Read packet content
-		msg.setLength(size + NetworkMessage::HEADER_LENGTH);
 		boost::asio::async_read(
-		    socket, boost::asio::buffer(msg.getBodyBuffer(), size),
-		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
-			    thisPtr->parsePacket(error);
+		    socket, boost::asio::buffer(msg.getBuffer() + received, msg.getLength() - received),
+		    [thisPtr = shared_from_this()](const boost::system::error_code& error, size_t bytes_transferred) {
+			    metrics::bytesReceived.add(bytes_transferred);
+			    thisPtr->onReadPacketBody(error);
 		    });
 	} catch (boost::system::system_error& e) {
-		std::cout << "[Network error - Connection::parseHeader] " << e.what() << std::endl;
+		std::cout << "[Network error - Connection::readPacketBody] " << e.what() << std::endl;
 		close(FORCE_CLOSE);
 	}
 }
 
-void Connection::parsePacket(const boost::system::error_code& error)
+void Connection::onReadPacketBody(const boost::system::error_code& error)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
-	readTimer.cancel();
-
 	if (error) {
 		close(FORCE_CLOSE);
 		return;
@@ -178,6 +266,30 @@ void Connection::parsePacket(const boost::system::error_code& error)
 		return;
 	}
 
+	lastReceived = getSteadySeconds();
+	if (parsePacket()) {
+		read();
+	}
+}
+
+bool Connection::checkPacketRate()
+{
+	uint32_t timePassed = std::max<uint32_t>(1, (time(nullptr) - timeConnected) + 1);
+	if ((++packetsSent / timePassed) > g_config[ConfigKeysInteger::MAX_PACKETS_PER_SECOND]) {
+		std::cout << convertIPToString(getIP()) << " disconnected for exceeding packet per second limit." << std::endl;
+		close();
+		return false;
+	}
+
+	if (timePassed > 2) {
+		timeConnected = time(nullptr);
+		packetsSent = 0;
+	}
+	return true;
+}
+
+bool Connection::parsePacket()
+{
 	// Check packet checksum
 	uint32_t checksum;
 	int32_t len = msg.getLength() - msg.getBufferPosition() - NetworkMessage::CHECKSUM_LENGTH;
@@ -203,7 +315,7 @@ void Connection::parsePacket(const boost::system::error_code& error)
 			protocol = service_port->make_protocol(recvChecksum == checksum, msg, shared_from_this());
 			if (!protocol) {
 				close(FORCE_CLOSE);
-				return;
+				return false;
 			}
 		} else {
 			msg.skipBytes(1); // Skip protocol ID
@@ -213,26 +325,41 @@ void Connection::parsePacket(const boost::system::error_code& error)
 	} else {
 		protocol->onRecvMessage(msg); // Send the packet to the current protocol
 	}
+	return !closed;
+}
 
+void Connection::readRaw()
+{
 	try {
-		readTimer.expires_from_now(std::chrono::seconds(CONNECTION_READ_TIMEOUT));
-		readTimer.async_wait(
-		    [thisPtr = std::weak_ptr<Connection>(shared_from_this())](const boost::system::error_code& error) {
-			    Connection::handleTimeout(thisPtr, error);
-		    });
-
-		// Wait to the next packet
-		boost::asio::async_read(
-		    socket, boost::asio::buffer(msg.getBuffer(), NetworkMessage::HEADER_LENGTH),
-		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
-			    thisPtr->parseHeader(error);
+		socket.async_read_some(
+		    boost::asio::buffer(readBuffer),
+		    [thisPtr = shared_from_this()](const boost::system::error_code& error, size_t bytes_transferred) {
+			    thisPtr->parseRaw(error, bytes_transferred);
 		    });
 	} catch (boost::system::system_error& e) {
-		std::cout << "[Network error - Connection::parsePacket] " << e.what() << std::endl;
+		std::cout << "[Network error - Connection::readRaw] " << e.what() << std::endl;
 		close(FORCE_CLOSE);
 	}
 }
 
+void Connection::parseRaw(const boost::system::error_code& error, size_t size)
+{
+	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
+	if (error) {
+		close(FORCE_CLOSE);
+		return;
+	} else if (closed) {
+		return;
+	}
+
+	lastReceived = getSteadySeconds();
+	metrics::bytesReceived.add(size);
+	protocol->onRecvRaw({reinterpret_cast<const char*>(readBuffer.data()), size});
+	if (!closed) {
+		readRaw();
+	}
+}
+
 void Connection::send(const OutputMessage_ptr& msg)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
@@ -240,16 +367,52 @@ void Connection::send(const OutputMessage_ptr& msg)
 		return;
 	}
 
-	bool noPendingWrite = messageQueue.empty();
 	messageQueue.emplace_back(msg);
-	if (noPendingWrite) {
-		internalSend(msg);
+	queuedBytes += msg->getLength();
+	if (!updateQueuedBytes()) {
+		return;
+	}
+
+	if (writingQueue.empty()) {
+		internalSend();
 	}
 }
 
-void Connection::internalSend(const OutputMessage_ptr& msg)
+bool Connection::updateQueuedBytes()
 {
-	protocol->onSendMessage(msg);
+	const size_t hardLimit = static_cast<size_t>(g_config[ConfigKeysInteger::SEND_QUEUE_HARD_LIMIT]) * 1024;
+	if (hardLimit != 0 && queuedBytes > hardLimit) {
+		std::cout << convertIPToString(getIP()) << " disconnected for having " << queuedBytes / 1024
+		          << " KB waiting to be sent." << std::endl;
+		messageQueue.clear();
+		close(FORCE_CLOSE);
+		return false;
+	}
+
+	const size_t softLimit = static_cast<size_t>(g_config[ConfigKeysInteger::SEND_QUEUE_SOFT_LIMIT]) * 1024;
+	protocol->sendCongested.store(softLimit != 0 && queuedBytes > softLimit, std::memory_order_relaxed);
+	return true;
+}
+
+void Connection::internalSend()
+{
+	if (messageQueue.size() <= CONNECTION_MAX_WRITE_BATCH) {
+		writingQueue.swap(messageQueue);
+	} else {
+		auto last = messageQueue.begin() + CONNECTION_MAX_WRITE_BATCH;
+		writingQueue.assign(std::make_move_iterator(messageQueue.begin()), std::make_move_iterator(last));
+		messageQueue.erase(messageQueue.begin(), last);
+	}
+
+	writeBuffers.clear();
+	writingBytes = 0;
+	for (const OutputMessage_ptr& msg : writingQueue) {
+		writingBytes += msg->getLength();
+		protocol->onSendMessage(msg);
+		writeBuffers.emplace_back(msg->getOutputBuffer(), msg->getLength());
+		metrics::bytesSent.add(msg->getLength());
+	}
+
 	try {
 		writeTimer.expires_from_now(std::chrono::seconds(CONNECTION_WRITE_TIMEOUT));
 		writeTimer.async_wait(
@@ -258,7 +421,7 @@ void Connection::internalSend(const OutputMessage_ptr& msg)
 		    });
 
 		boost::asio::async_write(
-		    socket, boost::asio::buffer(msg->getOutputBuffer(), msg->getLength()),
+		    socket, writeBuffers,
 		    [thisPtr = shared_from_this()](const boost::system::error_code& error, auto /*bytes_transferred*/) {
 			    thisPtr->onWriteOperation(error);
 		    });
@@ -286,7 +449,7 @@ void Connection::onWriteOperation(const boost::system::error_code& error)
 {
 	std::lock_guard<std::recursive_mutex> lockClass(connectionLock);
 	writeTimer.cancel();
-	messageQueue.pop_front();
+	writingQueue.clear();
 
 	if (error) {
 		messageQueue.clear();
@@ -294,8 +457,11 @@ void Connection::onWriteOperation(const boost::system::error_code& error)
 		return;
 	}
 
+	queuedBytes -= writingBytes;
+	updateQueuedBytes();
+
 	if (!messageQueue.empty()) {
-		internalSend(messageQueue.front());
+		internalSend();
 	} else if (closed) {
 		closeSocket();
 	}
@@ -312,3 +478,9 @@ void Connection::handleTimeout(ConnectionWeak_ptr connectionWeak, const boost::s
 		connection->close(FORCE_CLOSE);
 	}
 }
+
+int64_t Connection::getSteadySeconds()
+{
+	return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now().time_since_epoch())
+	    .count();
+}
@@ -10,11 +10,20 @@
 
 inline constexpr int32_t CONNECTION_WRITE_TIMEOUT = 30;
 inline constexpr int32_t CONNECTION_READ_TIMEOUT = 30;
+// most queued messages handed to a single gathered socket write
+inline constexpr size_t CONNECTION_MAX_WRITE_BATCH = 64;
+// most bytes taken from the socket per read, every complete packet among them is handled before reading again
+inline constexpr size_t CONNECTION_READ_BUFFER_SIZE = 4096;
+// seconds between two sweeps of a network thread for connections that sent nothing for CONNECTION_READ_TIMEOUT
+inline constexpr int32_t CONNECTION_IDLE_SWEEP_INTERVAL = 5;
 
 class Protocol;
 using Protocol_ptr = std::shared_ptr<Protocol>;
 class OutputMessage;
-using OutputMessage_ptr = std::shared_ptr<OutputMessage>;
+// output messages carry their own reference count, see outputmessage.h
+using OutputMessage_ptr = boost::intrusive_ptr<OutputMessage>;
+void intrusive_ptr_add_ref(OutputMessage* msg);
+void intrusive_ptr_release(OutputMessage* msg);
 class Connection;
 using Connection_ptr = std::shared_ptr<Connection>;
 using ConnectionWeak_ptr = std::weak_ptr<Connection>;
@@ -24,8 +33,21 @@ class ServicePort;
 using ServicePort_ptr = std::shared_ptr<ServicePort>;
 using ConstServicePort_ptr = std::shared_ptr<const ServicePort>;
 
+/*
+ * The connections are kept in one shard per network thread, so accepting and closing on different threads do not
+ * contend for one lock. Shards are added before the network threads start and never removed.
+ */
 class ConnectionManager
 {
+	struct Shard
+	{
+		explicit Shard(boost::asio::io_service& service) : service(service) {}
+
+		boost::asio::io_service& service;
+		std::unordered_set<Connection_ptr> connections;
+		std::mutex lock;
+	};
+
 public:
 	static ConnectionManager& getInstance()
 	{
@@ -33,15 +55,23 @@ public:
 		return instance;
 	}
 
+	// registers a network thread, main thread only and before any connection is created on service
+	void addShard(boost::asio::io_service& service);
+
 	Connection_ptr createConnection(boost::asio::io_service& io_service, ConstServicePort_ptr servicePort);
 	void releaseConnection(const Connection_ptr& connection);
 	void closeAll();
+	// closes the connections of service that received nothing for CONNECTION_READ_TIMEOUT seconds
+	void closeIdleConnections(boost::asio::io_service& service);
 
 private:
 	ConnectionManager() = default;
 
-	std::unordered_set<Connection_ptr> connections;
-	std::mutex connectionManagerLock;
+	friend class Connection;
+
+	Shard* getShard(boost::asio::io_service& service) const;
+
+	std::vector<std::unique_ptr<Shard>> shards;
 };
 
 class Connection : public std::enable_shared_from_this<Connection>
@@ -57,11 +87,11 @@ public:
 	};
 
 	Connection(boost::asio::io_service& io_service, ConstServicePort_ptr service_port) :
-	    readTimer(io_service),
 	    writeTimer(io_service),
 	    service_port(std::move(service_port)),
 	    socket(io_service),
-	    timeConnected(time(nullptr))
+	    timeConnected(time(nullptr)),
+	    lastReceived(getSteadySeconds())
 	{}
 	~Connection();
 
@@ -78,39 +108,65 @@ public:
 	uint32_t getLastIp() const { return lastIp; }
 
 private:
-	void parseHeader(const boost::system::error_code& error);
-	void parsePacket(const boost::system::error_code& error);
+	void read();
+	void onRead(const boost::system::error_code& error, size_t size);
+	// handles the complete packets in readBuffer, false once the connection closed or a packet body is read directly
+	bool parsePackets();
+	// a packet larger than readBuffer is read into msg, received is how much of it is there already
+	void readPacketBody(size_t received);
+	void onReadPacketBody(const boost::system::error_code& error);
+	// hands msg to the protocol, false if the connection closed
+	bool parsePacket();
+	bool checkPacketRate();
+	void readRaw();
+	void parseRaw(const boost::system::error_code& error, size_t size);
 
 	void onWriteOperation(const boost::system::error_code& error);
 
 	static void handleTimeout(ConnectionWeak_ptr connectionWeak, const boost::system::error_code& error);
+	static int64_t getSteadySeconds();
 
 	void closeSocket();
-	void internalSend(const OutputMessage_ptr& msg);
+	void internalSend();
+	// false if the queue went past sendQueueHardLimit and the connection was closed
+	bool updateQueuedBytes();
 
 	boost::asio::ip::tcp::socket& getSocket() { return socket; }
 	friend class ServicePort;
 
 	NetworkMessage msg;
+	std::array<uint8_t, CONNECTION_READ_BUFFER_SIZE> readBuffer;
+	// the unhandled bytes of readBuffer, those before readStart were handled already
+	size_t readStart = 0;
+	size_t readEnd = 0;
 
-	boost::asio::steady_timer readTimer;
 	boost::asio::steady_timer writeTimer;
 
 	std::recursive_mutex connectionLock;
 
-	std::list<OutputMessage_ptr> messageQueue;
+	// messages waiting for the next write and the ones the write in flight is sending, both keep their capacity
+	std::vector<OutputMessage_ptr> messageQueue;
+	std::vector<OutputMessage_ptr> writingQueue;
+	std::vector<boost::asio::const_buffer> writeBuffers;
+	// bytes of both queues and of the messages of writingQueue alone, taken before the protocol wraps them
+	size_t queuedBytes = 0;
+	size_t writingBytes = 0;
 
 	ConstServicePort_ptr service_port;
 	Protocol_ptr protocol;
+	ConnectionManager::Shard* shard = nullptr;
 
 	boost::asio::ip::tcp::socket socket;
 
 	time_t timeConnected;
+	// steady clock seconds, read by the idle sweep
+	std::atomic<int64_t> lastReceived;
 	uint32_t packetsSent = 0;
 	uint32_t lastIp = 0;
 
 	bool closed = false;
 	bool receivedFirst = false;
+	bool rawStream = false;
 };
 
 #endif
@@ -10,6 +10,17 @@
 
 extern Game g_game;
 
+namespace {
+
+// the item itself and, for a container, everything below it
+int32_t getHoldingCount(const Item* item)
+{
+	const Container* container = item->getContainer();
+	return 1 + (container ? container->getItemHoldingCount() : 0);
+}
+
+} // namespace
+
 Container::Container(uint16_t type) : Container(type, items[type].maxItems) {}
 
 Container::Container(uint16_t type, uint16_t size) : Item(type), maxSize(size) {}
@@ -51,6 +62,7 @@ void Container::addItem(Item* item)
 {
 	itemlist.push_back(item);
 	item->setParent(this);
+	updateItemHoldingCount(getHoldingCount(item));
 }
 
 Attr_ReadValue Container::readAttr(AttrTypes_t attr, PropStream& propStream)
@@ -71,7 +83,7 @@ bool Container::unserializeItemNode(OTB::Loader& loader, const OTB::Node& node,
 		return false;
 	}
 
-	for (auto& itemNode : node.children) {
+	for (auto& itemNode : node.children()) {
 		// load container items
 		if (itemNode.type != OTBM_ITEM) {
 			// unknown type
@@ -106,6 +118,14 @@ void Container::updateItemWeight(int32_t diff)
 	}
 }
 
+void Container::updateItemHoldingCount(int32_t diff)
+{
+	holdingCount += diff;
+	if (Container* parentContainer = getParentContainer()) {
+		parentContainer->updateItemHoldingCount(diff);
+	}
+}
+
 uint32_t Container::getWeight() const { return Item::getWeight() + totalWeight; }
 
 Item* Container::getItemByIndex(size_t index) const
@@ -116,19 +136,10 @@ Item* Container::getItemByIndex(size_t index) const
 	return itemlist[index];
 }
 
-uint32_t Container::getItemHoldingCount() const
-{
-	uint32_t counter = 0;
-	for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
-		++counter;
-	}
-	return counter;
-}
-
 bool Container::isHoldingItem(const Item* item) const
 {
-	for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
-		if (*it == item) {
+	for (const Cylinder* cylinder = item->getParent(); cylinder; cylinder = cylinder->getParent()) {
+		if (cylinder == this) {
 			return true;
 		}
 	}
@@ -407,8 +418,9 @@ void Container::addThing(int32_t index, Thing* thing)
 	}
 
 	item->setParent(this);
-	itemlist.push_front(item);
+	itemlist.insert(itemlist.begin(), item);
 	updateItemWeight(item->getWeight());
+	updateItemHoldingCount(getHoldingCount(item));
 
 	// send change to client
 	if (getParent() && (getParent() != VirtualCylinder::virtualCylinder)) {
@@ -465,6 +477,7 @@ void Container::replaceThing(uint32_t index, Thing* thing)
 	itemlist[index] = item;
 	item->setParent(this);
 	updateItemWeight(-static_cast<int32_t>(replacedItem->getWeight()) + item->getWeight());
+	updateItemHoldingCount(getHoldingCount(item) - getHoldingCount(replacedItem));
 
 	// send change to client
 	if (getParent()) {
@@ -498,6 +511,7 @@ void Container::removeThing(Thing* thing, uint32_t count)
 		}
 	} else {
 		updateItemWeight(-static_cast<int32_t>(item->getWeight()));
+		updateItemHoldingCount(-getHoldingCount(item));
 
 		// send change to client
 		if (getParent()) {
@@ -511,14 +525,11 @@ void Container::removeThing(Thing* thing, uint32_t count)
 
 int32_t Container::getThingIndex(const Thing* thing) const
 {
-	int32_t index = 0;
-	for (Item* item : itemlist) {
-		if (item == thing) {
-			return index;
-		}
-		++index;
+	auto it = std::find(itemlist.begin(), itemlist.end(), thing);
+	if (it == itemlist.end()) {
+		return -1;
 	}
-	return -1;
+	return static_cast<int32_t>(std::distance(itemlist.begin(), it));
 }
 
 size_t Container::getFirstIndex() const { return 0; }
@@ -601,8 +612,9 @@ void Container::internalAddThing(uint32_t, Thing* thing)
 	}
 
 	item->setParent(this);
-	itemlist.push_front(item);
+	itemlist.insert(itemlist.begin(), item);
 	updateItemWeight(item->getWeight());
+	updateItemHoldingCount(getHoldingCount(item));
 }
 
 void Container::startDecaying()
@@ -615,11 +627,7 @@ void Container::startDecaying()
 size_t Container::size(const bool recursive /*= false*/) const
 {
 	if (recursive) {
-		size_t count = 0;
-		for (ContainerIterator it = iterator(); it.hasNext(); it.advance()) {
-			++count;
-		}
-		return count;
+		return holdingCount;
 	}
 	return itemlist.size();
 }
@@ -629,29 +637,23 @@ ContainerIterator Container::iterator() const
 	ContainerIterator cit;
 	if (!itemlist.empty()) {
 		cit.over.push_back(this);
-		cit.cur = itemlist.begin();
 	}
 	return cit;
 }
 
-Item* ContainerIterator::operator*() { return *cur; }
+Item* ContainerIterator::operator*() { return over[current]->itemlist[index]; }
 
 void ContainerIterator::advance()
 {
-	if (Item* i = *cur) {
-		if (Container* c = i->getContainer()) {
-			if (!c->empty()) {
-				over.push_back(c);
-			}
+	const ItemVector& itemList = over[current]->itemlist;
+	if (const Container* container = itemList[index]->getContainer()) {
+		if (!container->empty()) {
+			over.push_back(container);
 		}
 	}
 
-	++cur;
-
-	if (cur == over.front()->itemlist.end()) {
-		over.pop_front();
-		if (!over.empty()) {
-			cur = over.front()->itemlist.begin();
-		}
+	if (++index == itemList.size()) {
+		++current;
+		index = 0;
 	}
 }
@@ -16,17 +16,20 @@ class DepotLocker;
 
 using ContainerQueue = std::queue<const Container*>;
 
+// breadth first over every item below a container, the containers seen are kept in place instead of popped so
+// small trees need no allocation
 class ContainerIterator
 {
 public:
-	bool hasNext() const { return !over.empty(); }
+	bool hasNext() const { return current < over.size(); }
 
 	void advance();
 	Item* operator*();
 
 private:
-	std::list<const Container*> over;
-	ItemDeque::const_iterator cur;
+	boost::container::small_vector<const Container*, 8> over;
+	size_t current = 0;
+	size_t index = 0;
 
 	friend class Container;
 };
@@ -44,6 +47,10 @@ public:
 
 	Item* clone() const override final;
 
+	// pooled like the other items, accounted as containers
+	static void* operator new(size_t size) { return allocate(size, MEMORY_CONTAINERS); }
+	static void operator delete(void* p, size_t size) { deallocate(p, size, MEMORY_CONTAINERS); }
+
 	Container* getContainer() override final { return this; }
 	const Container* getContainer() const override final { return this; }
 
@@ -59,11 +66,11 @@ public:
 
 	ContainerIterator iterator() const;
 
-	const ItemDeque& getItemList() const { return itemlist; }
+	const ItemVector& getItemList() const { return itemlist; }
 	ItemVector getItems(bool recursive = false) const;
 
-	ItemDeque::const_reverse_iterator getReversedItems() const { return itemlist.rbegin(); }
-	ItemDeque::const_reverse_iterator getReversedEnd() const { return itemlist.rend(); }
+	ItemVector::const_reverse_iterator getReversedItems() const { return itemlist.rbegin(); }
+	ItemVector::const_reverse_iterator getReversedEnd() const { return itemlist.rend(); }
 
 	std::string getName(bool addArticle = false) const;
 
@@ -71,7 +78,7 @@ public:
 	Item* getItemByIndex(size_t index) const;
 	bool isHoldingItem(const Item* item) const;
 
-	uint32_t getItemHoldingCount() const;
+	uint32_t getItemHoldingCount() const { return holdingCount; }
 	uint32_t getWeight() const override final;
 
 	// cylinder implementations
@@ -109,11 +116,13 @@ public:
 	void startDecaying() override final;
 
 protected:
-	ItemDeque itemlist;
+	ItemVector itemlist;
 
 private:
 	uint32_t maxSize;
 	uint32_t totalWeight = 0;
+	// items below this one, counted through sub containers
+	uint32_t holdingCount = 0;
 	uint32_t serializationCount = 0;
 
 	void onAddContainerItem(Item* item);
@@ -122,9 +131,11 @@ private:
 
 	Container* getParentContainer();
 	void updateItemWeight(int32_t diff);
+	void updateItemHoldingCount(int32_t diff);
 
 	friend class ContainerIterator;
 	friend class IOMapSerialize;
+	friend class MapPager;
 };
 
 #endif
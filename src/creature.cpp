@@ -7,7 +7,10 @@
 
 #include "configmanager.h"
 #include "events.h"
+#include "flowfield.h"
 #include "game.h"
+#include "jobsystem.h"
+#include "memorystats.h"
 #include "monster.h"
 #include "scheduler.h"
 
@@ -16,10 +19,26 @@ extern CreatureEvents* g_creatureEvents;
 extern Events* g_events;
 extern Game g_game;
 
+void* Creature::operator new(size_t size)
+{
+	MemoryStats::allocated(MEMORY_CREATURES, size);
+	return ::operator new(size);
+}
+
+void Creature::operator delete(void* p, size_t size)
+{
+	MemoryStats::freed(MEMORY_CREATURES, size);
+	::operator delete(p);
+}
+
 Creature::Creature() { onIdleStatus(); }
 
 Creature::~Creature()
 {
+	if (id != 0) {
+		Lua::releaseCreatureUserdata(id);
+	}
+
 	for (Creature* summon : summons) {
 		summon->setAttackedCreature(nullptr);
 		summon->removeMaster();
@@ -64,11 +83,11 @@ bool Creature::canSee(const Position& pos) const
 
 bool Creature::canSeeCreature(const Creature* creature) const
 {
-	if (!canSeeGhostMode(creature) && creature->isInGhostMode()) {
+	if (creature->isInGhostMode() && !canSeeGhostMode(creature)) {
 		return false;
 	}
 
-	if (!canSeeInvisibility() && creature->isInvisible()) {
+	if (creature->isInvisible() && !canSeeInvisibility()) {
 		return false;
 	}
 	return true;
@@ -299,7 +318,8 @@ void Creature::addEventWalk(bool firstStep)
 		g_game.checkCreatureWalk(getID());
 	}
 
-	eventWalk = g_scheduler.addEvent(createSchedulerTask(ticks, [id = getID()]() { g_game.checkCreatureWalk(id); }));
+	eventWalk = g_scheduler.addEvent(createSchedulerTask(
+	    ticks, [id = getID()]() { g_game.checkCreatureWalk(id); }, SCHEDULER_EVENT_CREATURE_WALK));
 }
 
 void Creature::stopEventWalk()
@@ -330,7 +350,7 @@ void Creature::updateTileCache(const Tile* tile, int32_t dx, int32_t dy)
 {
 	if (std::abs(dx) <= maxWalkCacheWidth && std::abs(dy) <= maxWalkCacheHeight) {
 		localMapCache[maxWalkCacheHeight + dy][maxWalkCacheWidth + dx] =
-		    tile && tile->queryAdd(0, *this, 1, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RETURNVALUE_NOERROR;
+		    tile && tile->queryAddCreature(*this, FLAG_PATHFINDING | FLAG_IGNOREFIELDDAMAGE) == RETURNVALUE_NOERROR;
 	}
 }
 
@@ -631,6 +651,39 @@ void Creature::onCreatureMove(Creature* creature, const Tile* newTile, const Pos
 	}
 }
 
+void Creature::queueCreatureMove(const Creature* creature, const Position& oldPos, const Position& newPos)
+{
+	auto it = std::find_if(queuedMoves.begin(), queuedMoves.end(),
+	                       [id = creature->getID()](const QueuedMove& move) { return move.creatureId == id; });
+	if (it != queuedMoves.end()) {
+		it->newPos = newPos;
+		return;
+	}
+
+	if (queuedMoves.empty()) {
+		g_game.queueMoveNotification(this);
+	}
+	queuedMoves.push_back({creature->getID(), oldPos, newPos});
+}
+
+void Creature::flushQueuedMoves()
+{
+	std::vector<QueuedMove> moves = std::move(queuedMoves);
+	queuedMoves.clear();
+
+	for (const QueuedMove& move : moves) {
+		// a script reacting to an earlier move may have removed either of them
+		if (isRemoved()) {
+			return;
+		}
+
+		Creature* creature = g_game.getCreatureByID(move.creatureId);
+		if (creature && !creature->isRemoved()) {
+			onQueuedCreatureMove(creature, move.oldPos, move.newPos);
+		}
+	}
+}
+
 CreatureVector Creature::getKillers()
 {
 	CreatureVector killers;
@@ -965,6 +1018,7 @@ void Creature::goToFollowCreature()
 					listWalkDir.clear();
 					if (getPathTo(followCreature->getPosition(), listWalkDir, fpp)) {
 						hasFollowPath = true;
+						followPathEnd = getWalkPathEnd();
 						startAutoWalk();
 					} else {
 						hasFollowPath = false;
@@ -981,9 +1035,26 @@ void Creature::goToFollowCreature()
 				startAutoWalk();
 			}
 		} else {
+			if (repairFollowPath(fpp) || (monster && followFlowField(fpp))) {
+				onFollowCreatureComplete(followCreature);
+				return;
+			}
+
+			// what is left are full searches, past the cap a monster keeps its path until its next think
+			if (monster && !g_game.takeFollowReplan()) {
+				forceUpdateFollowPath = true;
+				return;
+			}
+
+			if (monster && g_jobs.isEnabled() && requestFollowPath(fpp)) {
+				// onFollowCreatureComplete runs once the result is applied
+				return;
+			}
+
 			listWalkDir.clear();
 			if (getPathTo(followCreature->getPosition(), listWalkDir, fpp)) {
 				hasFollowPath = true;
+				followPathEnd = getWalkPathEnd();
 				startAutoWalk();
 			} else {
 				hasFollowPath = false;
@@ -994,6 +1065,133 @@ void Creature::goToFollowCreature()
 	onFollowCreatureComplete(followCreature);
 }
 
+Position Creature::getWalkPathEnd() const
+{
+	Position pos = getPosition();
+	for (auto it = listWalkDir.rbegin(); it != listWalkDir.rend(); ++it) {
+		pos = getNextPosition(*it, pos);
+	}
+	return pos;
+}
+
+bool Creature::repairFollowPath(const FindPathParams& fpp)
+{
+	if (!hasFollowPath || fpp.maxTargetDist != 1 || fpp.minTargetDist > 1) {
+		return false;
+	}
+
+	const Position& targetPos = followCreature->getPosition();
+	if (targetPos.z != getPosition().z) {
+		return false;
+	}
+
+	// a step that failed or went astray leaves the rest of the path off by one
+	if (getWalkPathEnd() != followPathEnd) {
+		return false;
+	}
+
+	auto distanceToTarget = [&targetPos](const Position& pos) {
+		return std::max(targetPos.getDistanceX(pos), targetPos.getDistanceY(pos));
+	};
+
+	// the path still ends next to the target
+	if (distanceToTarget(followPathEnd) == 1) {
+		return true;
+	}
+
+	// the target stepped away from the end of the path, one more step reaches it again unless the path got long
+	if (distanceToTarget(followPathEnd) != 2 ||
+	    listWalkDir.size() >= static_cast<size_t>(distanceToTarget(getPosition()) + MAX_FOLLOW_PATH_DETOUR)) {
+		return false;
+	}
+
+	// straight steps first, they cost less than diagonal ones
+	static constexpr Direction directions[] = {DIRECTION_NORTH,     DIRECTION_EAST,      DIRECTION_SOUTH,
+	                                           DIRECTION_WEST,      DIRECTION_NORTHWEST, DIRECTION_NORTHEAST,
+	                                           DIRECTION_SOUTHWEST, DIRECTION_SOUTHEAST};
+	for (Direction direction : directions) {
+		const Position pos = getNextPosition(direction, followPathEnd);
+		if (distanceToTarget(pos) == 1 && g_game.map.canWalkTo(*this, pos)) {
+			listWalkDir.insert(listWalkDir.begin(), direction);
+			followPathEnd = pos;
+			startAutoWalk();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool Creature::followFlowField(const FindPathParams& fpp)
+{
+	// the field leads to the tiles next to the target, so it only stands in for a melee chase
+	if (fpp.maxTargetDist != 1 || fpp.minTargetDist > 1 || followCreature->getPosition().z != getPosition().z) {
+		return false;
+	}
+
+	const FlowField* field = g_flowFields.get(*followCreature);
+	if (!field || !field->getPath(g_game.map, *this, getPosition(), listWalkDir)) {
+		return false;
+	}
+
+	// a search still running on a pathfinding worker is outdated now
+	++pathRequestId;
+	hasFollowPath = true;
+	followPathEnd = getWalkPathEnd();
+	startAutoWalk();
+	return true;
+}
+
+bool Creature::requestFollowPath(const FindPathParams& fpp)
+{
+	auto snapshot = std::make_shared<PathSnapshot>();
+	if (!snapshot->capture(g_game.map, *this, followCreature->getPosition(), fpp)) {
+		return false;
+	}
+
+	uint32_t creatureId = getID();
+	uint32_t followId = followCreature->getID();
+	uint32_t requestId = ++pathRequestId;
+	return g_jobs.addJob(
+	    [snapshot]() {
+		    std::pair<bool, std::vector<Direction>> path;
+		    path.first = snapshot->getPathMatching(path.second);
+		    return path;
+	    },
+	    [=](std::pair<bool, std::vector<Direction>>&& path) {
+		    if (Creature* creature = g_game.getCreatureByID(creatureId)) {
+			    creature->onFollowPathFound(requestId, followId, snapshot->getStartPosition(), path.first,
+			                                std::move(path.second));
+		    }
+	    });
+}
+
+void Creature::onFollowPathFound(uint32_t requestId, uint32_t followId, const Position& startPos, bool found,
+                                 std::vector<Direction>&& dirList)
+{
+	// a newer search was requested or the target changed meanwhile
+	if (requestId != pathRequestId || !followCreature || followCreature->getID() != followId) {
+		return;
+	}
+
+	if (isRemoved() || isMovementBlocked()) {
+		return;
+	}
+
+	if (getPosition() != startPos) {
+		isUpdatingPath = true;
+		return;
+	}
+
+	listWalkDir = std::move(dirList);
+	hasFollowPath = found;
+	followPathEnd = getWalkPathEnd();
+	if (found) {
+		startAutoWalk();
+	}
+
+	onFollowCreatureComplete(followCreature);
+}
+
 bool Creature::setFollowCreature(Creature* creature)
 {
 	if (creature) {
@@ -1207,7 +1405,8 @@ bool Creature::addCondition(Condition* condition, bool force /* = false*/)
 		int64_t walkDelay = getWalkDelay();
 		if (walkDelay > 0) {
 			g_scheduler.addEvent(
-			    createSchedulerTask(walkDelay, [=, id = getID()]() { g_game.forceAddCondition(id, condition); }));
+			    createSchedulerTask(walkDelay, [=, id = getID()]() { g_game.forceAddCondition(id, condition); },
+			                        SCHEDULER_EVENT_CREATURE_CONDITION));
 			return false;
 		}
 	}
@@ -1216,11 +1415,14 @@ bool Creature::addCondition(Condition* condition, bool force /* = false*/)
 	if (prevCond) {
 		prevCond->addCondition(this, condition);
 		delete condition;
+		updateConditionSchedule();
 		return true;
 	}
 
 	if (condition->startCondition(this)) {
 		conditions.push_back(condition);
+		conditionTypes |= condition->getType();
+		updateConditionSchedule();
 		onAddCondition(condition->getType());
 		return true;
 	}
@@ -1244,6 +1446,10 @@ bool Creature::addCombatCondition(Condition* condition)
 
 void Creature::removeCondition(ConditionType_t type, bool force /* = false*/)
 {
+	if (!(conditionTypes & type)) {
+		return;
+	}
+
 	auto it = conditions.begin(), end = conditions.end();
 	while (it != end) {
 		Condition* condition = *it;
@@ -1256,7 +1462,8 @@ void Creature::removeCondition(ConditionType_t type, bool force /* = false*/)
 			int64_t walkDelay = getWalkDelay();
 			if (walkDelay > 0) {
 				g_scheduler.addEvent(
-				    createSchedulerTask(walkDelay, [=, id = getID()]() { g_game.forceRemoveCondition(id, type); }));
+				    createSchedulerTask(walkDelay, [=, id = getID()]() { g_game.forceRemoveCondition(id, type); },
+				                        SCHEDULER_EVENT_CREATURE_CONDITION));
 				return;
 			}
 		}
@@ -1268,10 +1475,15 @@ void Creature::removeCondition(ConditionType_t type, bool force /* = false*/)
 
 		onEndCondition(type);
 	}
+	updateConditionSchedule();
 }
 
 void Creature::removeCondition(ConditionType_t type, ConditionId_t conditionId, bool force /* = false*/)
 {
+	if (!(conditionTypes & type)) {
+		return;
+	}
+
 	auto it = conditions.begin(), end = conditions.end();
 	while (it != end) {
 		Condition* condition = *it;
@@ -1284,7 +1496,8 @@ void Creature::removeCondition(ConditionType_t type, ConditionId_t conditionId,
 			int64_t walkDelay = getWalkDelay();
 			if (walkDelay > 0) {
 				g_scheduler.addEvent(
-				    createSchedulerTask(walkDelay, [=, id = getID()]() { g_game.forceRemoveCondition(id, type); }));
+				    createSchedulerTask(walkDelay, [=, id = getID()]() { g_game.forceRemoveCondition(id, type); },
+				                        SCHEDULER_EVENT_CREATURE_CONDITION));
 				return;
 			}
 		}
@@ -1296,6 +1509,7 @@ void Creature::removeCondition(ConditionType_t type, ConditionId_t conditionId,
 
 		onEndCondition(type);
 	}
+	updateConditionSchedule();
 }
 
 void Creature::removeCombatCondition(ConditionType_t type)
@@ -1323,7 +1537,8 @@ void Creature::removeCondition(Condition* condition, bool force /* = false*/)
 		int64_t walkDelay = getWalkDelay();
 		if (walkDelay > 0) {
 			g_scheduler.addEvent(createSchedulerTask(
-			    walkDelay, [id = getID(), type = condition->getType()]() { g_game.forceRemoveCondition(id, type); }));
+			    walkDelay, [id = getID(), type = condition->getType()]() { g_game.forceRemoveCondition(id, type); },
+			    SCHEDULER_EVENT_CREATURE_CONDITION));
 			return;
 		}
 	}
@@ -1333,10 +1548,15 @@ void Creature::removeCondition(Condition* condition, bool force /* = false*/)
 	condition->endCondition(this);
 	onEndCondition(condition->getType());
 	delete condition;
+	updateConditionSchedule();
 }
 
 Condition* Creature::getCondition(ConditionType_t type) const
 {
+	if (!(conditionTypes & type)) {
+		return nullptr;
+	}
+
 	for (Condition* condition : conditions) {
 		if (condition->getType() == type) {
 			return condition;
@@ -1347,6 +1567,10 @@ Condition* Creature::getCondition(ConditionType_t type) const
 
 Condition* Creature::getCondition(ConditionType_t type, ConditionId_t conditionId, uint32_t subId /* = 0*/) const
 {
+	if (!(conditionTypes & type)) {
+		return nullptr;
+	}
+
 	for (Condition* condition : conditions) {
 		if (condition->getType() == type && condition->getId() == conditionId && condition->getSubId() == subId) {
 			return condition;
@@ -1357,7 +1581,18 @@ Condition* Creature::getCondition(ConditionType_t type, ConditionId_t conditionI
 
 void Creature::executeConditions(uint32_t interval)
 {
-	ConditionList tempConditions{conditions};
+	const int64_t timeNow = OTSYS_TIME();
+	if (!hasTickingConditions && nextConditionEnd >= timeNow) {
+		return;
+	}
+
+	boost::container::small_vector<Condition*, 8> tempConditions;
+	for (Condition* condition : conditions) {
+		if (condition->isTicking() || (condition->getTicks() != -1 && condition->getEndTime() < timeNow)) {
+			tempConditions.push_back(condition);
+		}
+	}
+
 	for (Condition* condition : tempConditions) {
 		auto it = std::find(conditions.begin(), conditions.end(), condition);
 		if (it == conditions.end()) {
@@ -1374,11 +1609,28 @@ void Creature::executeConditions(uint32_t interval)
 			}
 		}
 	}
+
+	updateConditionSchedule();
+}
+
+void Creature::updateConditionSchedule()
+{
+	nextConditionEnd = std::numeric_limits<int64_t>::max();
+	hasTickingConditions = false;
+	conditionTypes = 0;
+	for (const Condition* condition : conditions) {
+		conditionTypes |= condition->getType();
+		if (condition->isTicking()) {
+			hasTickingConditions = true;
+		} else if (condition->getTicks() != -1) {
+			nextConditionEnd = std::min(nextConditionEnd, condition->getEndTime());
+		}
+	}
 }
 
 bool Creature::hasCondition(ConditionType_t type, uint32_t subId /* = 0*/) const
 {
-	if (isSuppress(type)) {
+	if (isSuppress(type) || !(conditionTypes & type)) {
 		return false;
 	}
 
@@ -1419,26 +1671,38 @@ int64_t Creature::getStepDuration(Direction dir) const
 	return stepDuration;
 }
 
+int64_t Creature::computeStepDuration(uint16_t groundSpeed, int32_t stepSpeed)
+{
+	// 1000 * groundSpeed / stepSpeed rounded up to the next 50 ms, the same as the floating point formula
+	const int64_t dividend = 20 * static_cast<int64_t>(groundSpeed);
+	if (stepSpeed > 0) {
+		return (dividend + stepSpeed - 1) / stepSpeed * 50;
+	} else if (stepSpeed < 0) {
+		return dividend / stepSpeed * 50;
+	}
+	return 0;
+}
+
 int64_t Creature::getStepDuration() const
 {
 	if (isRemoved()) {
 		return 0;
 	}
 
-	uint32_t groundSpeed;
-	int32_t stepSpeed = getStepSpeed();
-	Item* ground = tile->getGround();
-	if (ground) {
-		groundSpeed = Item::items[ground->getID()].speed;
-		if (groundSpeed == 0) {
-			groundSpeed = 150;
+	uint16_t groundSpeed = 150;
+	if (const Item* ground = tile->getGround()) {
+		if (uint16_t speed = Item::items[ground->getID()].speed; speed != 0) {
+			groundSpeed = speed;
 		}
-	} else {
-		groundSpeed = 150;
 	}
 
-	double duration = std::floor(1000 * groundSpeed) / stepSpeed;
-	int64_t stepDuration = std::ceil(duration / 50) * 50;
+	// most steps are on the same kind of ground at the same speed as the step before
+	const int32_t stepSpeed = getStepSpeed();
+	if (stepSpeed != lastStepTime.stepSpeed || groundSpeed != lastStepTime.groundSpeed) {
+		lastStepTime = {stepSpeed, groundSpeed, computeStepDuration(groundSpeed, stepSpeed)};
+	}
+
+	int64_t stepDuration = lastStepTime.duration;
 
 	const Monster* monster = getMonster();
 	if (monster && monster->isTargetNearby() && !monster->isFleeing() && !monster->getMaster()) {
@@ -1476,17 +1740,16 @@ bool Creature::registerCreatureEvent(std::string_view name)
 	}
 
 	CreatureEventType_t type = event->getEventType();
-	if (hasEventRegistered(type)) {
-		for (CreatureEvent* creatureEvent : eventsList) {
-			if (creatureEvent == event) {
-				return false;
-			}
-		}
-	} else {
-		scriptEventsBitField |= static_cast<uint32_t>(1) << type;
+	const auto first = eventsList.begin() + eventsBegin[type], last = eventsList.begin() + eventsBegin[type + 1];
+	if (std::find(first, last, event) != last) {
+		return false;
 	}
 
-	eventsList.push_back(event);
+	eventsList.insert(last, event);
+	for (size_t nextType = type + 1; nextType < eventsBegin.size(); ++nextType) {
+		++eventsBegin[nextType];
+	}
+	scriptEventsBitField |= static_cast<uint32_t>(1) << type;
 	return true;
 }
 
@@ -1497,31 +1760,25 @@ bool Creature::unregisterCreatureEvent(std::string_view name)
 		return false;
 	}
 
-	CreatureEventType_t type = event->getEventType();
-	if (!hasEventRegistered(type)) {
-		return false;
-	}
-
-	bool resetTypeBit = true;
-
-	auto it = eventsList.begin(), end = eventsList.end();
-	while (it != end) {
-		CreatureEvent* curEvent = *it;
-		if (curEvent == event) {
-			it = eventsList.erase(it);
+	// the type of an event is searched that it was registered with, a reload may have changed it since
+	for (size_t type = 0; type <= CREATURE_EVENT_LAST; ++type) {
+		const auto first = eventsList.begin() + eventsBegin[type], last = eventsList.begin() + eventsBegin[type + 1];
+		const auto it = std::find(first, last, event);
+		if (it == last) {
 			continue;
 		}
 
-		if (curEvent->getEventType() == type) {
-			resetTypeBit = false;
+		eventsList.erase(it);
+		for (size_t nextType = type + 1; nextType < eventsBegin.size(); ++nextType) {
+			--eventsBegin[nextType];
 		}
-		++it;
-	}
 
-	if (resetTypeBit) {
-		scriptEventsBitField &= ~(static_cast<uint32_t>(1) << type);
+		if (eventsBegin[type] == eventsBegin[type + 1]) {
+			scriptEventsBitField &= ~(static_cast<uint32_t>(1) << type);
+		}
+		return true;
 	}
-	return true;
+	return false;
 }
 
 CreatureEventList Creature::getCreatureEvents(CreatureEventType_t type) const
@@ -1532,15 +1789,12 @@ CreatureEventList Creature::getCreatureEvents(CreatureEventType_t type) const
 		return tmpEventList;
 	}
 
-	for (CreatureEvent* creatureEvent : eventsList) {
-		if (!creatureEvent->isLoaded()) {
-			continue;
-		}
-
-		if (creatureEvent->getEventType() == type) {
-			tmpEventList.push_back(creatureEvent);
-		}
-	}
+	// a copy, the handlers may register or unregister events while they are run
+	const auto first = eventsList.begin() + eventsBegin[type], last = eventsList.begin() + eventsBegin[type + 1];
+	tmpEventList.reserve(last - first);
+	std::copy_if(first, last, std::back_inserter(tmpEventList), [type](const CreatureEvent* creatureEvent) {
+		return creatureEvent->isLoaded() && creatureEvent->getEventType() == type;
+	});
 
 	return tmpEventList;
 }
@@ -1599,8 +1853,12 @@ bool FrozenPathingConditionCall::operator()(const Position& startPos, const Posi
 		return false;
 	}
 
-	if (fpp.clearSight && !g_game.isSightClear(testPos, targetPos, true)) {
-		return false;
+	if (fpp.clearSight) {
+		bool sightClear =
+		    snapshot ? snapshot->isSightClear(testPos, targetPos) : g_game.isSightClear(testPos, targetPos, true);
+		if (!sightClear) {
+			return false;
+		}
 	}
 
 	int32_t testDist = std::max(targetPos.getDistanceX(testPos), targetPos.getDistanceY(testPos));
@@ -1629,6 +1887,11 @@ bool FrozenPathingConditionCall::operator()(const Position& startPos, const Posi
 
 bool Creature::isInvisible() const
 {
+	// every visibility check of every broadcast asks this, most creatures have no invisibility to look for
+	if (!(conditionTypes & CONDITION_INVISIBLE)) {
+		return false;
+	}
+
 	return std::find_if(conditions.begin(), conditions.end(), [](const Condition* condition) {
 		       return condition->getType() == CONDITION_INVISIBLE;
 	       }) != conditions.end();
@@ -1654,20 +1917,28 @@ bool Creature::getPathTo(const Position& targetPos, std::vector<Direction>& dirL
 
 void Creature::setStorageValue(uint32_t key, std::optional<int64_t> value, bool isSpawn)
 {
-	auto oldValue = getStorageValue(key);
+	// the old value is only looked up for the event
+	const bool hasOnUpdateStorage = g_events->hasHandler<EventInfoId::CREATURE_ON_UPDATE_STORAGE>();
+	std::optional<int64_t> oldValue;
+	if (hasOnUpdateStorage) {
+		oldValue = getStorageValue(key);
+	}
+
 	if (value) {
-		storageMap.insert_or_assign(key, value.value());
+		storageMap.set(key, value.value());
 	} else {
 		storageMap.erase(key);
 	}
-	g_events->eventCreatureOnUpdateStorage(this, key, oldValue, value, isSpawn);
+
+	if (hasOnUpdateStorage) {
+		g_events->eventCreatureOnUpdateStorage(this, key, oldValue, value, isSpawn);
+	}
 }
 
 std::optional<int64_t> Creature::getStorageValue(uint32_t key) const
 {
-	auto it = storageMap.find(key);
-	if (it == storageMap.end()) {
-		return std::nullopt;
+	if (const int64_t* value = storageMap.find(key)) {
+		return *value;
 	}
-	return std::make_optional(it->second);
+	return std::nullopt;
 }
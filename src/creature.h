@@ -10,10 +10,12 @@
 #include "enums.h"
 #include "map.h"
 #include "position.h"
+#include "slotmap.h"
+#include "storagemap.h"
 #include "tile.h"
 
 using ConditionList = std::list<Condition*>;
-using CreatureEventList = std::list<CreatureEvent*>;
+using CreatureEventList = std::vector<CreatureEvent*>;
 
 enum slots_t : uint8_t
 {
@@ -33,17 +35,6 @@ enum slots_t : uint8_t
 	CONST_SLOT_LAST = CONST_SLOT_AMMO,
 };
 
-struct FindPathParams
-{
-	bool fullPathSearch = true;
-	bool clearSight = true;
-	bool allowDiagonal = true;
-	bool keepDistance = false;
-	int32_t maxSearchDist = 0;
-	int32_t minTargetDist = -1;
-	int32_t maxTargetDist = -1;
-};
-
 class Map;
 class Thing;
 class Container;
@@ -56,6 +47,8 @@ class Tile;
 inline constexpr int32_t EVENT_CREATURECOUNT = 10;
 inline constexpr int32_t EVENT_CREATURE_THINK_INTERVAL = 250;
 inline constexpr int32_t EVENT_CHECK_CREATURE_INTERVAL = (EVENT_CREATURE_THINK_INTERVAL / EVENT_CREATURECOUNT);
+// steps a repaired follow path may be longer than the straight distance to the target
+inline constexpr int32_t MAX_FOLLOW_PATH_DETOUR = 4;
 
 class FrozenPathingConditionCall
 {
@@ -68,6 +61,8 @@ public:
 	bool isInRange(const Position& startPos, const Position& testPos, const FindPathParams& fpp) const;
 
 	Position targetPos;
+	// answers sight checks from a captured area instead of the live map
+	const PathSnapshot* snapshot = nullptr;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -86,6 +81,10 @@ public:
 	Creature(const Creature&) = delete;
 	Creature& operator=(const Creature&) = delete;
 
+	// accounted in the memory stats
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	Creature* getCreature() override final { return this; }
 	const Creature* getCreature() const override final { return this; }
 	virtual Player* getPlayer() { return nullptr; }
@@ -134,6 +133,7 @@ public:
 	int64_t getEventStepTicks(bool onlyDelay = false) const;
 	int64_t getStepDuration(Direction dir) const;
 	int64_t getStepDuration() const;
+	static int64_t computeStepDuration(uint16_t groundSpeed, int32_t stepSpeed);
 	virtual int32_t getStepSpeed() const { return getSpeed(); }
 	int32_t getSpeed() const { return baseSpeed + varSpeed; }
 	void setSpeed(int32_t varSpeedDelta)
@@ -172,6 +172,16 @@ public:
 	void addEventWalk(bool firstStep = false);
 	void stopEventWalk();
 	virtual void goToFollowCreature();
+	// ends the follow path next to the target again after it moved, false if only a new search helps
+	bool repairFollowPath(const FindPathParams& fpp);
+	// where the remaining walk steps lead
+	Position getWalkPathEnd() const;
+	// walks the flow field shared by everyone chasing the follow creature, false if it has none or it does not help
+	bool followFlowField(const FindPathParams& fpp);
+	// hands the follow path search to g_pathfinder, false if it has to run synchronously
+	bool requestFollowPath(const FindPathParams& fpp);
+	void onFollowPathFound(uint32_t requestId, uint32_t followId, const Position& startPos, bool found,
+	                       std::vector<Direction>&& dirList);
 
 	// walk events
 	virtual void onWalk(Direction& dir);
@@ -206,7 +216,7 @@ public:
 	bool isSummon() const { return master != nullptr; }
 	Creature* getMaster() const { return master; }
 
-	const std::list<Creature*>& getSummons() const { return summons; }
+	const CreatureVector& getSummons() const { return summons; }
 
 	virtual int32_t getArmor() const { return 0; }
 	virtual int32_t getDefense() const { return 0; }
@@ -222,6 +232,7 @@ public:
 	Condition* getCondition(ConditionType_t type) const;
 	Condition* getCondition(ConditionType_t type, ConditionId_t conditionId, uint32_t subId = 0) const;
 	void executeConditions(uint32_t interval);
+	void updateConditionSchedule();
 	bool hasCondition(ConditionType_t type, uint32_t subId = 0) const;
 	virtual bool isImmune(ConditionType_t type) const;
 	virtual bool isImmune(CombatType_t type) const;
@@ -280,6 +291,10 @@ public:
 	virtual void onRemoveCreature(Creature* creature, bool isLogout);
 	virtual void onCreatureMove(Creature* creature, const Tile* newTile, const Position& newPos, const Tile* oldTile,
 	                            const Position& oldPos, bool teleport);
+	// called on the creature that moved with everyone around its old and new position, after they were notified
+	virtual void onMoveSpectators(const SpectatorVec&) {}
+	// hands the moves queued since the last flush to onQueuedCreatureMove, called by Game once a tick
+	void flushQueuedMoves();
 
 	virtual void onAttackedCreatureDisappear(bool) {}
 	virtual void onFollowCreatureDisappear(bool) {}
@@ -341,7 +356,8 @@ public:
 
 	virtual void setStorageValue(uint32_t key, std::optional<int64_t> value, bool isSpawn = false);
 	virtual std::optional<int64_t> getStorageValue(uint32_t key) const;
-	decltype(auto) getStorageMap() const { return storageMap; }
+	const StorageMap<uint32_t, int64_t>& getStorageMap() const { return storageMap; }
+	std::vector<uint32_t> takeStorageChanges() { return storageMap.takeChanges(); }
 
 	// for lua module
 	CreatureEventList getCreatureEvents(CreatureEventType_t type) const;
@@ -372,11 +388,20 @@ protected:
 	using CountMap = std::map<uint32_t, CountBlock_t>;
 	CountMap damageMap;
 
-	std::list<Creature*> summons;
+	CreatureVector summons;
+	// registered events grouped by type, the ones of a type are eventsList[eventsBegin[type], eventsBegin[type + 1])
 	CreatureEventList eventsList;
+	std::array<uint16_t, CREATURE_EVENT_LAST + 2> eventsBegin = {};
 	ConditionList conditions;
+	// earliest end time of the conditions that only need executing once they run out
+	int64_t nextConditionEnd = std::numeric_limits<int64_t>::max();
+	bool hasTickingConditions = false;
+	// types of the conditions in the list, a removed type may stay set until the next schedule update
+	uint32_t conditionTypes = 0;
 
 	std::vector<Direction> listWalkDir;
+	// where the follow path led when it was last set, a repair only extends a path still leading there
+	Position followPathEnd;
 
 	Tile* tile = nullptr;
 	Creature* attackedCreature = nullptr;
@@ -392,9 +417,19 @@ protected:
 	uint32_t lastHitCreatureId = 0;
 	uint32_t blockCount = 0;
 	uint32_t blockTicks = 0;
+	uint32_t pathRequestId = 0;
 	uint32_t lastStepCost = 1;
 	uint32_t baseSpeed = 220;
 	int32_t varSpeed = 0;
+
+	struct StepTime
+	{
+		int32_t stepSpeed = 0;
+		uint16_t groundSpeed = 0;
+		int64_t duration = 0;
+	};
+	mutable StepTime lastStepTime;
+
 	int32_t health = 1000;
 	int32_t healthMax = 1000;
 	uint8_t drunkenness = 0;
@@ -430,6 +465,11 @@ protected:
 		return (0 != (scriptEventsBitField & (static_cast<uint32_t>(1) << event)));
 	}
 
+	// for the reaction to creatures moving around, the moves of a creature within a tick are handed over as one from
+	// its first old to its last new position
+	void queueCreatureMove(const Creature* creature, const Position& oldPos, const Position& newPos);
+	virtual void onQueuedCreatureMove(Creature*, const Position&, const Position&) {}
+
 	void updateMapCache();
 	void updateTileCache(const Tile* tile, int32_t dx, int32_t dy);
 	void updateTileCache(const Tile* tile, const Position& pos);
@@ -451,7 +491,15 @@ protected:
 	friend class LuaScriptInterface;
 
 private:
-	std::map<uint32_t, int64_t> storageMap;
+	struct QueuedMove
+	{
+		uint32_t creatureId;
+		Position oldPos;
+		Position newPos;
+	};
+
+	StorageMap<uint32_t, int64_t> storageMap;
+	std::vector<QueuedMove> queuedMoves;
 };
 
 #endif
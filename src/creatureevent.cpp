@@ -10,15 +10,13 @@
 
 CreatureEvents::CreatureEvents() : scriptInterface("CreatureScript Interface") { scriptInterface.initState(); }
 
-void CreatureEvents::clear(bool fromLua)
+void CreatureEvents::removeEvents(const EventFilter& filter)
 {
 	for (auto it = creatureEvents.begin(); it != creatureEvents.end(); ++it) {
-		if (fromLua == it->second.fromLua) {
+		if (filter(it->second)) {
 			it->second.clearEvent();
 		}
 	}
-
-	reInitState(fromLua);
 }
 
 void CreatureEvents::removeInvalidEvents()
@@ -248,6 +246,7 @@ void CreatureEvent::copyEvent(CreatureEvent* creatureEvent)
 	scriptId = creatureEvent->scriptId;
 	scriptInterface = creatureEvent->scriptInterface;
 	scripted = creatureEvent->scripted;
+	scriptFile = creatureEvent->scriptFile;
 	loaded = creatureEvent->loaded;
 }
 
@@ -26,6 +26,8 @@ enum CreatureEventType_t
 	CREATURE_EVENT_HEALTHCHANGE,
 	CREATURE_EVENT_MANACHANGE,
 	CREATURE_EVENT_EXTENDED_OPCODE, // otclient additional network opcodes
+
+	CREATURE_EVENT_LAST = CREATURE_EVENT_EXTENDED_OPCODE
 };
 
 class CreatureEvent final : public Event
@@ -86,7 +88,6 @@ public:
 	CreatureEvent* getEventByName(std::string_view name, bool forceLoaded = true);
 
 	bool registerLuaEvent(CreatureEvent* event);
-	void clear(bool fromLua) override final;
 
 	void removeInvalidEvents();
 
@@ -95,6 +96,7 @@ private:
 	std::string_view getScriptBaseName() const override;
 	Event_ptr getEvent(std::string_view nodeName) override;
 	bool registerEvent(Event_ptr event, const pugi::xml_node& node) override;
+	void removeEvents(const EventFilter& filter) override final;
 
 	// creature events
 	using CreatureEventMap = std::map<std::string, CreatureEvent>;
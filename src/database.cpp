@@ -6,11 +6,51 @@
 #include "database.h"
 
 #include "configmanager.h"
+#include "memorystats.h"
+#include "querystats.h"
+#include "tasks.h"
 
 #include <mysql/errmsg.h>
 
 extern ConfigManager g_config;
 
+namespace {
+
+thread_local std::string_view currentCaller;
+
+// times a query from its creation until it goes out of scope
+class QueryTimer
+{
+public:
+	QueryTimer(std::string_view query, const std::source_location& caller) : query{query}, caller{caller} {}
+
+	~QueryTimer()
+	{
+		const std::string_view name = currentCaller.empty() ? caller.function_name() : currentCaller;
+		QueryStats::record(query, name, std::chrono::steady_clock::now() - start, g_dispatcher.isCurrentThread());
+	}
+
+	// non-copyable
+	QueryTimer(const QueryTimer&) = delete;
+	QueryTimer& operator=(const QueryTimer&) = delete;
+
+private:
+	std::string_view query;
+	std::source_location caller;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+};
+
+} // namespace
+
+DBCallerScope::DBCallerScope(std::string caller) : caller{std::move(caller)}, previous{currentCaller}
+{
+	currentCaller = this->caller;
+}
+
+DBCallerScope::~DBCallerScope() { currentCaller = previous; }
+
+std::string_view DBCallerScope::current() { return currentCaller; }
+
 static bool connectToDatabase(MYSQL*& handle, const bool retryIfError)
 {
 	bool isFirstAttemptToConnect = true;
@@ -66,7 +106,11 @@ static bool executeQuery(MYSQL*& handle, const std::string_view query, const boo
 	return true;
 }
 
-Database::~Database() { mysql_close(handle); }
+Database::~Database()
+{
+	statements.clear();
+	mysql_close(handle);
+}
 
 bool Database::connect()
 {
@@ -108,15 +152,17 @@ bool Database::commit()
 	return result;
 }
 
-bool Database::executeQuery(std::string_view query)
+bool Database::executeQuery(std::string_view query, const std::source_location& caller)
 {
 	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
+	QueryTimer timer{query, caller};
 	return ::executeQuery(handle, query, retryQueries);
 }
 
-DBResult_ptr Database::storeQuery(std::string_view query)
+DBResult_ptr Database::storeQuery(std::string_view query, const std::source_location& caller)
 {
 	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
+	QueryTimer timer{query, caller};
 
 retry:
 	if (!::executeQuery(handle, query, retryQueries) && !retryQueries) {
@@ -144,8 +190,64 @@ retry:
 	return result;
 }
 
+bool Database::streamQuery(std::string_view query, const std::function<bool(DBResult&)>& visitor,
+                           const std::source_location& caller)
+{
+	std::lock_guard<std::recursive_mutex> lockGuard(databaseLock);
+	// includes the time the visitor took, the connection is held for all of it
+	QueryTimer timer{query, caller};
+
+retry:
+	if (!::executeQuery(handle, query, retryQueries) && !retryQueries) {
+		return false;
+	}
+
+	MYSQL_RES* res = mysql_use_result(handle);
+	if (!res) {
+		// no result set, or the connection failed before the first row
+		if (mysql_field_count(handle) == 0) {
+			return true;
+		}
+
+		std::cout << "[Error - mysql_use_result] Query: " << query << std::endl
+		          << "Message: " << mysql_error(handle) << std::endl;
+		const unsigned error = mysql_errno(handle);
+		if (!isLostConnectionError(error) || !retryQueries) {
+			return false;
+		}
+		goto retry;
+	}
+
+	// freeing the result reads and discards the rows the visitor skipped
+	DBResult result{res};
+	while (result.hasNext()) {
+		if (!visitor(result)) {
+			return true;
+		}
+		result.next();
+	}
+
+	// the rows visited so far cannot be taken back, so a query that fails midway is not tried again
+	if (mysql_errno(handle) != 0) {
+		std::cout << "[Error - mysql_fetch_row] Query: " << query << std::endl
+		          << "Message: " << mysql_error(handle) << std::endl;
+		return false;
+	}
+	return true;
+}
+
 std::string Database::escapeString(std::string_view s) const { return escapeBlob(s.data(), s.length()); }
 
+void Database::escapeStringTo(std::string& out, std::string_view s) const
+{
+	// the worst case is 2n + 1, plus the quotes
+	out.resize((s.length() * 2) + 3);
+	out[0] = '\'';
+	const unsigned long length = s.empty() ? 0 : mysql_real_escape_string(handle, out.data() + 1, s.data(), s.length());
+	out[length + 1] = '\'';
+	out.resize(length + 2);
+}
+
 std::string Database::escapeBlob(const char* s, uint32_t length) const
 {
 	// the worst case is 2n + 1
@@ -166,8 +268,34 @@ std::string Database::escapeBlob(const char* s, uint32_t length) const
 	return escaped;
 }
 
+namespace {
+
+DBColumnType getColumnType(enum_field_types type)
+{
+	switch (type) {
+		case MYSQL_TYPE_TINY:
+		case MYSQL_TYPE_SHORT:
+		case MYSQL_TYPE_INT24:
+		case MYSQL_TYPE_LONG:
+		case MYSQL_TYPE_LONGLONG:
+			return DB_COLUMN_INTEGER;
+
+		case MYSQL_TYPE_FLOAT:
+		case MYSQL_TYPE_DOUBLE:
+		case MYSQL_TYPE_DECIMAL:
+		case MYSQL_TYPE_NEWDECIMAL:
+			return DB_COLUMN_NUMBER;
+
+		default:
+			return DB_COLUMN_STRING;
+	}
+}
+
+} // namespace
+
 DBResult::DBResult(MYSQL_RES* res)
 {
+	MemoryStats::allocated(MEMORY_DATABASE_RESULTS, 0);
 	handle = res;
 
 	size_t i = 0;
@@ -175,13 +303,18 @@ DBResult::DBResult(MYSQL_RES* res)
 	MYSQL_FIELD* field = mysql_fetch_field(handle);
 	while (field) {
 		listNames[field->name] = i++;
+		columns.push_back({field->name, getColumnType(field->type)});
 		field = mysql_fetch_field(handle);
 	}
 
 	row = mysql_fetch_row(handle);
 }
 
-DBResult::~DBResult() { mysql_free_result(handle); }
+DBResult::~DBResult()
+{
+	mysql_free_result(handle);
+	MemoryStats::freed(MEMORY_DATABASE_RESULTS, 0);
+}
 
 std::string_view DBResult::getString(std::string_view column) const
 {
@@ -227,32 +360,56 @@ bool DBResult::next()
 	return row != nullptr;
 }
 
-DBInsert::DBInsert(std::string_view query) : query{query} { this->length = this->query.length(); }
+namespace {
 
-bool DBInsert::addRow(std::string_view row)
+// enough for a typical save without regrowing, the buffer still grows up to the packet size when needed
+constexpr size_t DBINSERT_RESERVE = 64 * 1024;
+
+} // namespace
+
+DBInsert::DBInsert(std::string_view query, Database& db /* = Database::getInstance()*/,
+                   const std::source_location& caller /* = std::source_location::current()*/) :
+    db{db}, caller{caller}, buffer{query}, queryLength{query.length()}
 {
-	// adds new row to buffer
-	const size_t rowLength = row.length();
-	length += rowLength;
-	if (length > Database::getInstance().getMaxPacketSize() && !execute()) {
-		return false;
+	buffer.reserve(std::min<size_t>(DBINSERT_RESERVE, db.getMaxPacketSize()));
+}
+
+size_t DBInsert::beginRow()
+{
+	const size_t rowStart = buffer.size();
+	if (pendingRows != 0) {
+		buffer.push_back(',');
+	}
+	buffer.push_back('(');
+	return rowStart;
+}
+
+bool DBInsert::endRow(size_t rowStart)
+{
+	buffer.push_back(')');
+	++pendingRows;
+
+	if (buffer.size() <= db.getMaxPacketSize() || pendingRows == 1) {
+		return true;
 	}
 
-	if (values.empty()) {
-		values.reserve(rowLength + 2);
-		values.push_back('(');
-		values.append(row);
-		values.push_back(')');
-	} else {
-		values.reserve(values.length() + rowLength + 3);
-		values.push_back(',');
-		values.push_back('(');
-		values.append(row);
-		values.push_back(')');
+	// send the rows before this one, then move it to the front
+	--pendingRows;
+	if (!send(rowStart)) {
+		return false;
 	}
+	buffer.erase(queryLength, rowStart + 1 - queryLength);
+	pendingRows = 1;
 	return true;
 }
 
+bool DBInsert::addRow(std::string_view row)
+{
+	const size_t rowStart = beginRow();
+	buffer.append(row);
+	return endRow(rowStart);
+}
+
 bool DBInsert::addRow(std::ostringstream& row)
 {
 	bool ret = addRow(row.str());
@@ -260,15 +417,198 @@ bool DBInsert::addRow(std::ostringstream& row)
 	return ret;
 }
 
+bool DBInsert::send(size_t length)
+{
+	const auto start = std::chrono::steady_clock::now();
+	const bool res = db.executeQuery(std::string_view{buffer.data(), length}, caller);
+	executeTime += std::chrono::steady_clock::now() - start;
+	rowCount += pendingRows;
+	pendingRows = 0;
+	return res;
+}
+
 bool DBInsert::execute()
 {
-	if (values.empty()) {
+	if (pendingRows == 0) {
 		return true;
 	}
 
 	// executes buffer
-	bool res = Database::getInstance().executeQuery(query + values);
-	values.clear();
-	length = query.length();
+	bool res = send(buffer.size());
+	buffer.resize(queryLength);
 	return res;
 }
+
+uint64_t DBInsert::getRowsPerSecond() const
+{
+	const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(executeTime).count();
+	return micros > 0 ? rowCount * 1000000 / micros : 0;
+}
+
+DBStatement_ptr Database::prepare(std::string_view query, const std::source_location& caller)
+{
+	databaseLock.lock();
+	auto it = statements.find(query);
+	if (it == statements.end()) {
+		it = statements.emplace(query, std::make_unique<DBStatement>(*this, query)).first;
+	}
+	it->second->caller = caller;
+	return DBStatement_ptr{it->second.get()};
+}
+
+void DBStatementRelease::operator()(DBStatement* statement) const { statement->db.databaseLock.unlock(); }
+
+DBStatement::DBStatement(Database& db, std::string_view query) : db{db}, queryText{query} {}
+
+DBStatement::~DBStatement() { close(); }
+
+void DBStatement::close()
+{
+	if (handle) {
+		mysql_stmt_close(handle);
+		handle = nullptr;
+	}
+}
+
+bool DBStatement::prepare()
+{
+	close();
+
+	handle = mysql_stmt_init(db.handle);
+	if (!handle) {
+		std::cout << "[Error - mysql_stmt_init] Query: " << queryText.substr(0, 256) << std::endl
+		          << "Message: " << mysql_error(db.handle) << std::endl;
+		return false;
+	}
+
+	if (mysql_stmt_prepare(handle, queryText.data(), queryText.length()) != 0) {
+		std::cout << "[Error - mysql_stmt_prepare] Query: " << queryText.substr(0, 256) << std::endl
+		          << "Message: " << mysql_stmt_error(handle) << std::endl;
+		close();
+		return false;
+	}
+
+	resultBinds.clear();
+	columns.clear();
+
+	MYSQL_RES* metadata = mysql_stmt_result_metadata(handle);
+	if (!metadata) {
+		return true;
+	}
+
+	const unsigned int fieldCount = mysql_num_fields(metadata);
+	const MYSQL_FIELD* fields = mysql_fetch_fields(metadata);
+	resultBinds.assign(fieldCount, MYSQL_BIND{});
+	columns.resize(fieldCount);
+	for (unsigned int i = 0; i < fieldCount; ++i) {
+		MYSQL_BIND& bind = resultBinds[i];
+		Column& column = columns[i];
+		switch (fields[i].type) {
+			case MYSQL_TYPE_TINY:
+			case MYSQL_TYPE_SHORT:
+			case MYSQL_TYPE_INT24:
+			case MYSQL_TYPE_LONG:
+			case MYSQL_TYPE_LONGLONG:
+				column.isInteger = true;
+				bind.buffer_type = MYSQL_TYPE_LONGLONG;
+				bind.buffer = &column.integer;
+				bind.is_unsigned = (fields[i].flags & UNSIGNED_FLAG) != 0;
+				break;
+
+			default:
+				column.data.resize(64);
+				bind.buffer_type = MYSQL_TYPE_BLOB;
+				bind.buffer = column.data.data();
+				bind.buffer_length = column.data.size();
+				break;
+		}
+		bind.length = &column.length;
+		bind.is_null = &column.isNull;
+		bind.error = &column.truncated;
+	}
+	mysql_free_result(metadata);
+	return true;
+}
+
+bool DBStatement::run(bool store)
+{
+	QueryTimer timer{queryText, caller};
+	for (int attempt = 0; attempt < 2; ++attempt) {
+		if (!handle && !prepare()) {
+			return false;
+		}
+
+		if (mysql_stmt_param_count(handle) != paramBinds.size()) {
+			std::cout << "[Error - DBStatement::run] Query: " << queryText.substr(0, 256) << std::endl
+			          << "Message: expected " << mysql_stmt_param_count(handle) << " parameters, got "
+			          << paramBinds.size() << std::endl;
+			return false;
+		}
+
+		mysql_stmt_free_result(handle);
+		if (mysql_stmt_bind_param(handle, paramBinds.data()) == 0 && mysql_stmt_execute(handle) == 0) {
+			if (!store) {
+				return true;
+			}
+
+			if (mysql_stmt_bind_result(handle, resultBinds.data()) == 0 && mysql_stmt_store_result(handle) == 0) {
+				return true;
+			}
+		}
+
+		std::cout << "[Error - DBStatement::run] Query: " << queryText.substr(0, 256) << std::endl
+		          << "Message: " << mysql_stmt_error(handle) << std::endl;
+
+		// the connection was lost or replaced since preparing, prepare again on the current one
+		const unsigned error = mysql_stmt_errno(handle);
+		close();
+		if (!isLostConnectionError(error) || !db.retryQueries) {
+			return false;
+		}
+
+		if (mysql_ping(db.handle) != 0) {
+			connectToDatabase(db.handle, true);
+		}
+	}
+	return false;
+}
+
+bool DBStatement::next()
+{
+	if (!handle || columns.empty()) {
+		return false;
+	}
+
+	const int status = mysql_stmt_fetch(handle);
+	if (status == 1 || status == MYSQL_NO_DATA) {
+		return false;
+	}
+
+	if (status == MYSQL_DATA_TRUNCATED) {
+		for (size_t i = 0; i < columns.size(); ++i) {
+			Column& column = columns[i];
+			if (!column.truncated || column.isInteger) {
+				continue;
+			}
+
+			column.data.resize(column.length);
+			MYSQL_BIND& bind = resultBinds[i];
+			bind.buffer = column.data.data();
+			bind.buffer_length = column.data.size();
+			mysql_stmt_fetch_column(handle, &bind, i, 0);
+		}
+		mysql_stmt_bind_result(handle, resultBinds.data());
+	}
+	return true;
+}
+
+std::string_view DBStatement::getString(size_t column) const
+{
+	const Column& col = columns[column];
+	if (col.isNull || col.isInteger) {
+		return {};
+	}
+	return {col.data.data(), std::min<size_t>(col.length, col.data.size())};
+}
+
+uint64_t DBStatement::getAffectedRows() const { return handle ? mysql_stmt_affected_rows(handle) : 0; }
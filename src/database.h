@@ -6,9 +6,41 @@
 
 #include <boost/lexical_cast.hpp>
 #include <mysql/mysql.h>
+#include <source_location>
 
 class DBResult;
 using DBResult_ptr = std::shared_ptr<DBResult>;
+class DBStatement;
+
+// keeps the connection locked while the statement and its result are in use
+struct DBStatementRelease
+{
+	void operator()(DBStatement* statement) const;
+};
+using DBStatement_ptr = std::unique_ptr<DBStatement, DBStatementRelease>;
+
+/**
+ * Names the caller of the queries this thread runs while it exists, for the query stats and the slow query log.
+ *
+ * Without one the C++ function that ran the query is its caller, Lua bindings name the calling script line instead.
+ */
+class DBCallerScope
+{
+public:
+	explicit DBCallerScope(std::string caller);
+	~DBCallerScope();
+
+	// non-copyable
+	DBCallerScope(const DBCallerScope&) = delete;
+	DBCallerScope& operator=(const DBCallerScope&) = delete;
+
+	// the innermost scope of this thread, empty if there is none
+	static std::string_view current();
+
+private:
+	std::string caller;
+	std::string_view previous;
+};
 
 class Database
 {
@@ -46,7 +78,7 @@ public:
 	 * @param query command
 	 * @return true on success, false on error
 	 */
-	bool executeQuery(std::string_view query);
+	bool executeQuery(std::string_view query, const std::source_location& caller = std::source_location::current());
 
 	/**
 	 * Queries database.
@@ -55,7 +87,22 @@ public:
 	 *
 	 * @return results object (nullptr on error)
 	 */
-	DBResult_ptr storeQuery(std::string_view query);
+	DBResult_ptr storeQuery(std::string_view query,
+	                        const std::source_location& caller = std::source_location::current());
+
+	/**
+	 * Queries database without buffering the result set.
+	 *
+	 * Rows are read from the server as they arrive and passed to the visitor, which returns false to skip the rest.
+	 * The result is only valid during the call and the connection stays locked until the last row was read, so the
+	 * visitor must not query the database itself.
+	 *
+	 * @param query command
+	 * @param visitor called with the result for every row
+	 * @return true on success, false on error
+	 */
+	bool streamQuery(std::string_view query, const std::function<bool(DBResult&)>& visitor,
+	                 const std::source_location& caller = std::source_location::current());
 
 	/**
 	 * Escapes string for query.
@@ -67,6 +114,14 @@ public:
 	 */
 	std::string escapeString(std::string_view s) const;
 
+	/**
+	 * Escapes a string for a query into the given buffer, replacing its contents.
+	 *
+	 * @param out buffer receiving the quoted string
+	 * @param s string to be escaped
+	 */
+	void escapeStringTo(std::string& out, std::string_view s) const;
+
 	/**
 	 * Escapes binary stream for query.
 	 *
@@ -94,6 +149,18 @@ public:
 
 	uint64_t getMaxPacketSize() const { return maxPacketSize; }
 
+	/**
+	 * Returns the prepared statement for a query, preparing it on first use.
+	 *
+	 * Statements are cached per connection for its lifetime, so the query text should be a constant with ? in
+	 * place of every value.
+	 *
+	 * @param query query text
+	 * @return the statement, the connection stays locked until it is released
+	 */
+	DBStatement_ptr prepare(std::string_view query,
+	                        const std::source_location& caller = std::source_location::current());
+
 private:
 	/**
 	 * Transaction related methods.
@@ -108,11 +175,161 @@ private:
 
 	MYSQL* handle = nullptr;
 	std::recursive_mutex databaseLock;
+	std::map<std::string, std::unique_ptr<DBStatement>, std::less<>> statements;
 	uint64_t maxPacketSize = 1048576;
 	// Do not retry queries if we are in the middle of a transaction
 	bool retryQueries = true;
 
 	friend class DBTransaction;
+	friend class DBStatement;
+	friend struct DBStatementRelease;
+};
+
+/**
+ * Prepared statement using the binary protocol.
+ *
+ * Values are bound by position and never escaped, result columns are read by index in select order.
+ */
+class DBStatement
+{
+public:
+	DBStatement(Database& db, std::string_view query);
+	~DBStatement();
+
+	// non-copyable
+	DBStatement(const DBStatement&) = delete;
+	DBStatement& operator=(const DBStatement&) = delete;
+
+	/**
+	 * Executes the statement with the given parameters.
+	 *
+	 * @return true on success, false on error
+	 */
+	template <typename... Args>
+	bool execute(const Args&... args)
+	{
+		bindParams(args...);
+		return run(false);
+	}
+
+	/**
+	 * Executes the statement with the given parameters and stores its result set.
+	 *
+	 * @return true if at least one row was returned, the first row is then current
+	 */
+	template <typename... Args>
+	bool query(const Args&... args)
+	{
+		bindParams(args...);
+		return run(true) && next();
+	}
+
+	bool next();
+
+	template <typename T>
+	T getNumber(size_t column) const
+	{
+		const Column& col = columns[column];
+		if (col.isNull) {
+			return static_cast<T>(0);
+		}
+
+		if (col.isInteger) {
+			return static_cast<T>(col.integer);
+		}
+
+		try {
+			return boost::lexical_cast<T>(std::string_view{col.data.data(), col.length});
+		} catch (boost::bad_lexical_cast&) {
+			return static_cast<T>(0);
+		}
+	}
+
+	std::string_view getString(size_t column) const;
+
+	uint64_t getAffectedRows() const;
+
+private:
+	using Flag = std::remove_pointer_t<decltype(MYSQL_BIND::is_null)>;
+
+	struct Column
+	{
+		std::vector<char> data;
+		int64_t integer = 0;
+		unsigned long length = 0;
+		Flag isNull = 0;
+		Flag truncated = 0;
+		bool isInteger = false;
+	};
+
+	struct Param
+	{
+		int64_t integer = 0;
+		unsigned long length = 0;
+	};
+
+	template <typename... Args>
+	void bindParams(const Args&... args)
+	{
+		paramBinds.assign(sizeof...(Args), MYSQL_BIND{});
+		params.assign(sizeof...(Args), Param{});
+		size_t index = 0;
+		(bindParam(index++, args), ...);
+	}
+
+	template <typename T>
+	void bindParam(size_t index, const T& value)
+	{
+		if constexpr (std::is_convertible_v<const T&, std::string_view>) {
+			std::string_view view = value;
+			params[index].length = view.size();
+			paramBinds[index].buffer_type = MYSQL_TYPE_BLOB;
+			paramBinds[index].buffer = const_cast<char*>(view.data());
+			paramBinds[index].buffer_length = view.size();
+			paramBinds[index].length = &params[index].length;
+		} else {
+			static_assert(std::is_integral_v<T> || std::is_enum_v<T>, "unsupported parameter type");
+			params[index].integer = static_cast<int64_t>(value);
+			paramBinds[index].buffer_type = MYSQL_TYPE_LONGLONG;
+			paramBinds[index].buffer = &params[index].integer;
+			if constexpr (std::is_unsigned_v<T>) {
+				paramBinds[index].is_unsigned = true;
+			}
+		}
+	}
+
+	bool prepare();
+	bool run(bool store);
+	void close();
+
+	Database& db;
+	std::string queryText;
+	MYSQL_STMT* handle = nullptr;
+	// where it was last prepared, for the query stats
+	std::source_location caller;
+
+	friend class Database;
+	friend struct DBStatementRelease;
+
+	std::vector<MYSQL_BIND> paramBinds;
+	std::vector<Param> params;
+
+	std::vector<MYSQL_BIND> resultBinds;
+	std::vector<Column> columns;
+};
+
+enum DBColumnType : uint8_t
+{
+	DB_COLUMN_STRING,
+	DB_COLUMN_INTEGER,
+	// floating point and decimal
+	DB_COLUMN_NUMBER,
+};
+
+struct DBColumn
+{
+	std::string_view name;
+	DBColumnType type;
 };
 
 class DBResult
@@ -151,6 +368,19 @@ public:
 	std::string_view getString(std::string_view column) const;
 	std::string_view getStream(std::string_view column, unsigned long& size) const;
 
+	// the columns in select order, for reading whole rows without looking the columns up by name
+	const std::vector<DBColumn>& getColumns() const { return columns; }
+
+	// calls f(column, data, size) for each column of the current row, data is nullptr for NULL
+	template <typename F>
+	void forEachValue(F&& f) const
+	{
+		const unsigned long* lengths = mysql_fetch_lengths(handle);
+		for (size_t index = 0; index < columns.size(); ++index) {
+			f(columns[index], row[index], lengths[index]);
+		}
+	}
+
 	bool hasNext() const;
 	bool next();
 
@@ -159,36 +389,84 @@ private:
 	MYSQL_ROW row;
 
 	std::map<std::string_view, size_t> listNames;
+	std::vector<DBColumn> columns;
 
 	friend class Database;
 };
 
+/**
+ * Value escaped for a query when formatted, for use with DBInsert::addRow.
+ */
+struct DBEscaped
+{
+	const Database& db;
+	std::string_view value;
+};
+
+template <>
+struct fmt::formatter<DBEscaped> : fmt::formatter<std::string_view>
+{
+	template <typename FormatContext>
+	auto format(const DBEscaped& escaped, FormatContext& ctx) const
+	{
+		// reused so escaping a row does not allocate once the buffer has grown
+		thread_local std::string buffer;
+		escaped.db.escapeStringTo(buffer, escaped.value);
+		return fmt::formatter<std::string_view>::format(buffer, ctx);
+	}
+};
+
 /**
  * INSERT statement.
+ *
+ * Rows are written straight into one buffer that starts with the query, which is sent as it is whenever the next row
+ * would make it larger than the server accepts.
  */
 class DBInsert
 {
 public:
-	explicit DBInsert(std::string_view query);
+	explicit DBInsert(std::string_view query, Database& db = Database::getInstance(),
+	                  const std::source_location& caller = std::source_location::current());
 	bool addRow(std::string_view row);
 	bool addRow(std::ostringstream& row);
+
+	template <typename... Args>
+	bool addRow(fmt::format_string<Args...> format, Args&&... args)
+	{
+		const size_t rowStart = beginRow();
+		fmt::format_to(std::back_inserter(buffer), format, std::forward<Args>(args)...);
+		return endRow(rowStart);
+	}
+
 	bool execute();
 
+	uint64_t getRowCount() const { return rowCount; }
+	// rows per second of time spent executing
+	uint64_t getRowsPerSecond() const;
+
 private:
-	std::string query;
-	std::string values;
-	size_t length;
+	size_t beginRow();
+	bool endRow(size_t rowStart);
+	bool send(size_t length);
+
+	Database& db;
+	std::source_location caller;
+	std::string buffer;
+	size_t queryLength;
+	size_t pendingRows = 0;
+	uint64_t rowCount = 0;
+	std::chrono::steady_clock::duration executeTime{};
 };
 
 class DBTransaction
 {
 public:
-	constexpr DBTransaction() = default;
+	explicit DBTransaction(Database& db = Database::getInstance()) : db{db} {}
 
 	~DBTransaction()
 	{
 		if (state == STATE_START) {
-			Database::getInstance().rollback();
+			db.rollback();
 		}
 	}
 
@@ -199,7 +477,7 @@ public:
 	bool begin()
 	{
 		state = STATE_START;
-		return Database::getInstance().beginTransaction();
+		return db.beginTransaction();
 	}
 
 	bool commit()
@@ -209,10 +487,12 @@ public:
 		}
 
 		state = STATE_COMMIT;
-		return Database::getInstance().commit();
+		return db.commit();
 	}
 
 private:
+	Database& db;
+
 	enum TransactionStates_t
 	{
 		STATE_NO_START,
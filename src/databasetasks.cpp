@@ -5,86 +5,189 @@
 
 #include "databasetasks.h"
 
-#include "tasks.h"
+#include "configmanager.h"
+#include "metrics.h"
+#include "threadregistry.h"
 
+extern ConfigManager g_config;
 extern Dispatcher g_dispatcher;
 
 void DatabaseTasks::start()
 {
-	db.connect();
+	const size_t workerCount = std::max<int64_t>(1, g_config[ConfigKeysInteger::DATABASE_THREADS]);
+	for (size_t i = 0; i < workerCount; ++i) {
+		auto& worker = workers.emplace_back(std::make_unique<Worker>());
+		worker->db.connect();
+	}
+
 	ThreadHolder::start();
+	for (size_t i = 1; i < workers.size(); ++i) {
+		workers[i]->thread = std::thread(&DatabaseTasks::workerMain, this, std::ref(*workers[i]));
+	}
 }
 
-void DatabaseTasks::threadMain()
+void DatabaseTasks::threadMain() { workerMain(*workers.front()); }
+
+void DatabaseTasks::workerMain(Worker& worker)
 {
-	std::unique_lock<std::mutex> taskLockUnique(taskLock, std::defer_lock);
-	while (getState() != THREAD_STATE_TERMINATED) {
-		taskLockUnique.lock();
-		if (tasks.empty()) {
-			taskSignal.wait(taskLockUnique);
-		}
+	ThreadRegistration registration{THREAD_ROLE_DATABASE};
 
-		if (!tasks.empty()) {
-			DatabaseTask task = std::move(tasks.front());
-			tasks.pop_front();
-			taskLockUnique.unlock();
-			runTask(task);
-		} else {
-			taskLockUnique.unlock();
+	while (getState() != THREAD_STATE_TERMINATED) {
+		{
+			std::unique_lock<std::mutex> taskLockUnique(worker.taskLock);
+			worker.taskSignal.wait(taskLockUnique, [&]() {
+				return !worker.tasks.empty() || getState() == THREAD_STATE_TERMINATED;
+			});
 		}
+		runNextTask(worker);
 	}
 }
 
-void DatabaseTasks::addTask(std::string query, std::function<void(DBResult_ptr, bool)> callback /* = nullptr*/,
-                            bool store /* = false*/)
+bool DatabaseTasks::enqueue(uint64_t key, DatabaseTask&& task)
 {
+	if (workers.empty()) {
+		return false;
+	}
+
+	Worker& worker = *workers[key % workers.size()];
+	task.enqueueTime = std::chrono::steady_clock::now();
+
 	bool signal = false;
-	taskLock.lock();
-	if (getState() == THREAD_STATE_RUNNING) {
-		signal = tasks.empty();
-		tasks.emplace_back(std::move(query), std::move(callback), store);
+	{
+		std::lock_guard<std::mutex> lockGuard(worker.taskLock);
+		if (getState() != THREAD_STATE_RUNNING) {
+			return false;
+		}
+
+		signal = worker.tasks.empty();
+		worker.tasks.push_back(std::move(task));
+		metrics::databaseQueueDepth.add();
+		worker.maxQueueDepth = std::max(worker.maxQueueDepth, worker.tasks.size());
 	}
-	taskLock.unlock();
 
 	if (signal) {
-		taskSignal.notify_one();
+		worker.taskSignal.notify_one();
 	}
+	return true;
+}
+
+void DatabaseTasks::addTask(std::string query, std::function<void(DBResult_ptr, bool)> callback /* = nullptr*/,
+                            bool store /* = false*/, uint64_t key /* = DATABASE_KEY_DEFAULT*/,
+                            const std::source_location& caller /* = std::source_location::current()*/)
+{
+	const std::string_view callerScope = DBCallerScope::current();
+	enqueue(key, DatabaseTask{query, std::move(callback), store,
+	                          callerScope.empty() ? std::string_view{caller.function_name()} : callerScope});
+}
+
+bool DatabaseTasks::addJob(std::function<void(Database&)> job, uint64_t key /* = DATABASE_KEY_DEFAULT*/)
+{
+	return enqueue(key, DatabaseTask{std::move(job)});
 }
 
-void DatabaseTasks::runTask(const DatabaseTask& task)
+bool DatabaseTasks::runNextTask(Worker& worker)
 {
-	bool success;
-	DBResult_ptr result;
-	if (task.store) {
-		result = db.storeQuery(task.query);
-		success = true;
+	std::lock_guard<std::mutex> runGuard{worker.runLock};
+
+	std::unique_lock<std::mutex> taskLockUnique(worker.taskLock);
+	if (worker.tasks.empty()) {
+		return false;
+	}
+
+	DatabaseTask task = std::move(worker.tasks.front());
+	worker.tasks.pop_front();
+	taskLockUnique.unlock();
+	metrics::databaseQueueDepth.sub();
+
+	runTask(worker, task);
+	return true;
+}
+
+void DatabaseTasks::runTask(Worker& worker, const DatabaseTask& task)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	if (task.job) {
+		task.job(worker.db);
 	} else {
-		result = nullptr;
-		success = db.executeQuery(task.query);
+		DBCallerScope callerScope{task.caller};
+		bool success;
+		DBResult_ptr result;
+		if (task.store) {
+			result = worker.db.storeQuery(task.query);
+			success = true;
+		} else {
+			result = nullptr;
+			success = worker.db.executeQuery(task.query);
+		}
+
+		if (task.callback) {
+			TaskOriginScope originScope{makeTaskOrigin(TASK_ORIGIN_DATABASE)};
+			g_dispatcher.addTask([=, callback = task.callback]() { callback(result, success); });
+		}
 	}
 
-	if (task.callback) {
-		g_dispatcher.addTask([=, callback = task.callback]() { callback(result, success); });
+	const auto endTime = std::chrono::steady_clock::now();
+	using std::chrono::duration_cast, std::chrono::microseconds;
+	std::lock_guard<std::mutex> lockGuard(worker.taskLock);
+	worker.stats.record(duration_cast<microseconds>(endTime - startTime).count(),
+	                    duration_cast<microseconds>(startTime - task.enqueueTime).count());
+}
+
+void DatabaseTasks::logStats()
+{
+	for (size_t i = 0; i < workers.size(); ++i) {
+		Worker& worker = *workers[i];
+
+		DispatcherTaskStats stats;
+		size_t queueDepth, maxQueueDepth;
+		{
+			std::lock_guard<std::mutex> lockGuard(worker.taskLock);
+			stats = std::exchange(worker.stats, {});
+			queueDepth = worker.tasks.size();
+			maxQueueDepth = std::exchange(worker.maxQueueDepth, queueDepth);
+		}
+
+		if (stats.count == 0 && queueDepth == 0) {
+			continue;
+		}
+
+		std::cout << fmt::format("> Database connection {:d}: {:d} queries | queued {:d}, max {:d} | avg {:>6d} us | "
+		                         "p99 {:>7d} us | max {:>7d} us | wait avg {:>6d} us, p99 {:>7d} us",
+		                         i, stats.count, queueDepth, maxQueueDepth,
+		                         stats.count ? stats.totalExecutionTime / stats.count : 0,
+		                         stats.getExecutionPercentile(0.99), stats.maxExecutionTime,
+		                         stats.count ? stats.totalWaitTime / stats.count : 0, stats.getWaitPercentile(0.99))
+		          << std::endl;
 	}
 }
 
 void DatabaseTasks::flush()
 {
-	std::unique_lock<std::mutex> guard{taskLock};
-	while (!tasks.empty()) {
-		auto task = std::move(tasks.front());
-		tasks.pop_front();
-		guard.unlock();
-		runTask(task);
-		guard.lock();
+	for (auto& worker : workers) {
+		while (runNextTask(*worker)) {
+		}
 	}
 }
 
 void DatabaseTasks::shutdown()
 {
-	taskLock.lock();
-	setState(THREAD_STATE_TERMINATED);
-	taskLock.unlock();
+	for (auto& worker : workers) {
+		std::lock_guard<std::mutex> lockGuard(worker->taskLock);
+		setState(THREAD_STATE_TERMINATED);
+	}
 	flush();
-	taskSignal.notify_one();
+	for (auto& worker : workers) {
+		worker->taskSignal.notify_one();
+	}
+}
+
+void DatabaseTasks::join()
+{
+	ThreadHolder::join();
+	for (auto& worker : workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+	}
 }
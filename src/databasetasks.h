@@ -6,19 +6,38 @@
 
 #include "database.h"
 #include "enums.h"
+#include "tasks.h"
 #include "thread_holder_base.h"
 
 #include <condition_variable>
 
+// tasks with the same key run in order on the same connection, unrelated work can use different keys to run in
+// parallel when there are several connections
+static constexpr uint64_t DATABASE_KEY_DEFAULT = 0;
+static constexpr uint64_t DATABASE_KEY_PLAYER_SAVES = 1;
+static constexpr uint64_t DATABASE_KEY_LOGINS = 2;
+static constexpr uint64_t DATABASE_KEY_HOUSE_SAVES = 3;
+static constexpr uint64_t DATABASE_KEY_STORAGE_SAVES = 4;
+// first of the keys the sections of a player load are spread over
+static constexpr uint64_t DATABASE_KEY_PLAYER_LOADS = 5;
+
 struct DatabaseTask
 {
-	DatabaseTask(std::string_view query, std::function<void(DBResult_ptr, bool)>&& callback, bool store) :
-	    query{query}, callback{std::move(callback)}, store{store}
+	DatabaseTask(std::string_view query, std::function<void(DBResult_ptr, bool)>&& callback, bool store,
+	             std::string_view caller) :
+	    query{query}, caller{caller}, callback{std::move(callback)}, store{store}
 	{}
 
+	explicit DatabaseTask(std::function<void(Database&)>&& job) : job{std::move(job)}, store{false} {}
+
 	std::string query;
+	// who queued the query, its caller in the query stats
+	std::string caller;
 	std::function<void(DBResult_ptr, bool)> callback;
+	// runs on the task thread's own connection instead of query
+	std::function<void(Database&)> job;
 	bool store;
+	std::chrono::steady_clock::time_point enqueueTime;
 };
 
 class DatabaseTasks : public ThreadHolder<DatabaseTasks>
@@ -28,19 +47,41 @@ public:
 	void start();
 	void flush();
 	void shutdown();
+	void join();
+
+	void addTask(std::string query, std::function<void(DBResult_ptr, bool)> callback = nullptr, bool store = false,
+	             uint64_t key = DATABASE_KEY_DEFAULT,
+	             const std::source_location& caller = std::source_location::current());
+	// returns false if the tasks are no longer accepting work
+	bool addJob(std::function<void(Database&)> job, uint64_t key = DATABASE_KEY_DEFAULT);
 
-	void addTask(std::string query, std::function<void(DBResult_ptr, bool)> callback = nullptr, bool store = false);
+	void logStats();
 
 	void threadMain();
 
 private:
-	void runTask(const DatabaseTask& task);
+	struct Worker
+	{
+		Database db;
+		std::thread thread;
+		std::list<DatabaseTask> tasks;
+		std::mutex taskLock;
+		std::condition_variable taskSignal;
+		// held while taking and running a task, flush may run tasks on the calling thread and must keep their order
+		std::mutex runLock;
+
+		// guarded by taskLock
+		DispatcherTaskStats stats;
+		size_t maxQueueDepth = 0;
+	};
+
+	bool enqueue(uint64_t key, DatabaseTask&& task);
+	void workerMain(Worker& worker);
+	bool runNextTask(Worker& worker);
+	void runTask(Worker& worker, const DatabaseTask& task);
 
-	Database db;
-	std::thread thread;
-	std::list<DatabaseTask> tasks;
-	std::mutex taskLock;
-	std::condition_variable taskSignal;
+	// the first worker runs on the ThreadHolder thread
+	std::vector<std::unique_ptr<Worker>> workers;
 };
 
 extern DatabaseTasks g_databaseTasks;
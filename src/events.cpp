@@ -131,6 +131,13 @@ bool Events::load()
 			std::cout << "[Warning - Events::load] Unknown class: " << className << std::endl;
 		}
 	}
+
+	handlers = 0;
+	for (size_t i = 0; i < eventInfoMembers.size(); ++i) {
+		if (info.*eventInfoMembers[i] != -1) {
+			handlers |= static_cast<uint64_t>(1) << i;
+		}
+	}
 	return true;
 }
 
@@ -17,10 +17,50 @@ class Tile;
 enum class EventInfoId
 {
 	// Creature
-	CREATURE_ONHEAR,
+	CREATURE_ON_CHANGE_OUTFIT,
+	CREATURE_ON_AREA_COMBAT,
+	CREATURE_ON_TARGET_COMBAT,
+	CREATURE_ON_HEAR,
+	CREATURE_ON_CHANGE_ZONE,
+	CREATURE_ON_UPDATE_STORAGE,
+
+	// Party
+	PARTY_ON_JOIN,
+	PARTY_ON_LEAVE,
+	PARTY_ON_DISBAND,
+	PARTY_ON_SHARE_EXPERIENCE,
+	PARTY_ON_INVITE,
+	PARTY_ON_REVOKE_INVITATION,
+	PARTY_ON_PASS_LEADERSHIP,
+
+	// Player
+	PLAYER_ON_LOOK,
+	PLAYER_ON_LOOK_IN_BATTLE_LIST,
+	PLAYER_ON_LOOK_IN_TRADE,
+	PLAYER_ON_LOOK_IN_SHOP,
+	PLAYER_ON_MOVE_ITEM,
+	PLAYER_ON_ITEM_MOVED,
+	PLAYER_ON_MOVE_CREATURE,
+	PLAYER_ON_REPORT_RULE_VIOLATION,
+	PLAYER_ON_REPORT_BUG,
+	PLAYER_ON_TURN,
+	PLAYER_ON_TRADE_REQUEST,
+	PLAYER_ON_TRADE_ACCEPT,
+	PLAYER_ON_TRADE_COMPLETED,
+	PLAYER_ON_GAIN_EXPERIENCE,
+	PLAYER_ON_LOSE_EXPERIENCE,
+	PLAYER_ON_GAIN_SKILL_TRIES,
+	PLAYER_ON_NETWORK_MESSAGE,
+	PLAYER_ON_UPDATE_INVENTORY,
+	PLAYER_ON_ACCOUNT_MANAGER,
+	PLAYER_ON_ROTATE_ITEM,
+	PLAYER_ON_SPELL_CHECK,
 
 	// Monster
-	MONSTER_ONSPAWN
+	MONSTER_ON_DROP_LOOT,
+	MONSTER_ON_SPAWN,
+
+	LAST
 };
 
 class Events
@@ -127,21 +167,61 @@ public:
 	void eventMonsterOnDropLoot(Monster* monster, Container* corpse);
 	bool eventMonsterOnSpawn(Monster* monster, const Position& position, bool startup, bool artificial);
 
-	int32_t getScriptId(EventInfoId eventInfoId)
+	int32_t getScriptId(EventInfoId eventInfoId) const
 	{
-		switch (eventInfoId) {
-			case EventInfoId::CREATURE_ONHEAR:
-				return info.creatureOnHear;
-			case EventInfoId::MONSTER_ONSPAWN:
-				return info.monsterOnSpawn;
-			default:
-				return -1;
-		}
-	};
+		return info.*eventInfoMembers[static_cast<size_t>(eventInfoId)];
+	}
+
+	// checked by the call sites before they prepare the arguments of an event nobody handles
+	template <EventInfoId eventInfoId>
+	bool hasHandler() const
+	{
+		return (handlers & (static_cast<uint64_t>(1) << static_cast<uint32_t>(eventInfoId))) != 0;
+	}
 
 private:
+	static constexpr std::array<int32_t EventsInfo::*, static_cast<size_t>(EventInfoId::LAST)> eventInfoMembers = {
+	    &EventsInfo::creatureOnChangeOutfit,
+	    &EventsInfo::creatureOnAreaCombat,
+	    &EventsInfo::creatureOnTargetCombat,
+	    &EventsInfo::creatureOnHear,
+	    &EventsInfo::creatureOnChangeZone,
+	    &EventsInfo::creatureOnUpdateStorage,
+	    &EventsInfo::partyOnJoin,
+	    &EventsInfo::partyOnLeave,
+	    &EventsInfo::partyOnDisband,
+	    &EventsInfo::partyOnShareExperience,
+	    &EventsInfo::partyOnInvite,
+	    &EventsInfo::partyOnRevokeInvitation,
+	    &EventsInfo::partyOnPassLeadership,
+	    &EventsInfo::playerOnLook,
+	    &EventsInfo::playerOnLookInBattleList,
+	    &EventsInfo::playerOnLookInTrade,
+	    &EventsInfo::playerOnLookInShop,
+	    &EventsInfo::playerOnMoveItem,
+	    &EventsInfo::playerOnItemMoved,
+	    &EventsInfo::playerOnMoveCreature,
+	    &EventsInfo::playerOnReportRuleViolation,
+	    &EventsInfo::playerOnReportBug,
+	    &EventsInfo::playerOnTurn,
+	    &EventsInfo::playerOnTradeRequest,
+	    &EventsInfo::playerOnTradeAccept,
+	    &EventsInfo::playerOnTradeCompleted,
+	    &EventsInfo::playerOnGainExperience,
+	    &EventsInfo::playerOnLoseExperience,
+	    &EventsInfo::playerOnGainSkillTries,
+	    &EventsInfo::playerOnNetworkMessage,
+	    &EventsInfo::playerOnUpdateInventory,
+	    &EventsInfo::playerOnAccountManager,
+	    &EventsInfo::playerOnRotateItem,
+	    &EventsInfo::playerOnSpellCheck,
+	    &EventsInfo::monsterOnDropLoot,
+	    &EventsInfo::monsterOnSpawn};
+	static_assert(static_cast<size_t>(EventInfoId::LAST) <= 64, "handlers has one bit per event");
+
 	LuaScriptInterface scriptInterface;
 	EventsInfo info;
+	uint64_t handlers = 0;
 };
 
 #endif
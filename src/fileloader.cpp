@@ -5,12 +5,78 @@
 
 #include "fileloader.h"
 
-#include <stack>
+#include <fstream>
 
 namespace OTB {
 
 constexpr Identifier wildcard = {{'\0', '\0', '\0', '\0'}};
 
+namespace {
+
+constexpr Identifier indexIdentifier = {{'O', 'T', 'B', 'C'}};
+constexpr uint32_t INDEX_VERSION = 1;
+
+#pragma pack(1)
+struct IndexHeader
+{
+	Identifier identifier;
+	uint32_t version;
+	Identifier sourceIdentifier;
+	uint64_t sourceSize;
+	int64_t sourceTime;
+	uint64_t sourceHash;
+	uint64_t nodeCount;
+};
+
+struct IndexNode
+{
+	uint64_t propsOffset;
+	uint32_t propsSize;
+	uint32_t subtreeSize;
+	uint32_t childCount;
+	uint8_t type;
+	uint8_t padding[3];
+};
+#pragma pack()
+
+static_assert(sizeof(IndexHeader) == 44 && sizeof(IndexNode) == 24);
+
+uint64_t hashContents(const MappedFile& file)
+{
+	uint64_t hash = 0xcbf29ce484222325;
+	for (char byte : file) {
+		hash = (hash ^ static_cast<uint8_t>(byte)) * 0x100000001b3;
+	}
+	return hash;
+}
+
+int64_t lastWriteTime(const std::string& fileName)
+{
+	std::error_code ec;
+	auto time = std::filesystem::last_write_time(fileName, ec);
+	return ec ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+}
+
+// every subtree has to end inside its parent or walking the children would leave the index
+bool validSubtrees(const std::vector<Node>& nodes)
+{
+	std::vector<size_t> ends{nodes.size()};
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		while (i >= ends.back()) {
+			ends.pop_back();
+		}
+
+		size_t end = i + nodes[i].subtreeSize;
+		if (nodes[i].subtreeSize == 0 || end > ends.back()) {
+			return false;
+		}
+		ends.push_back(end);
+	}
+	return nodes.front().subtreeSize == nodes.size();
+}
+
+} // namespace
+
 Loader::Loader(const std::string& fileName, const Identifier& acceptedIdentifier) : fileContents(fileName)
 {
 	constexpr auto minimalSize = sizeof(Identifier) + sizeof(Node::START) + sizeof(Node::type) + sizeof(Node::END);
@@ -25,49 +91,189 @@ Loader::Loader(const std::string& fileName, const Identifier& acceptedIdentifier
 	}
 }
 
-using NodeStack = std::stack<Node*, std::vector<Node*>>;
-static Node& getCurrentNode(const NodeStack& nodeStack)
+std::unique_ptr<Loader> Loader::openIndex(const std::string& indexName, const std::string& fileName,
+                                          const Identifier& acceptedIdentifier)
 {
-	if (nodeStack.empty()) {
-		throw InvalidOTBFormat{};
+	std::error_code ec;
+	if (!std::filesystem::exists(indexName, ec)) {
+		return nullptr;
+	}
+
+	std::unique_ptr<Loader> loader{new Loader};
+	loader->escaped = false;
+	try {
+		loader->fileContents.open(indexName);
+	} catch (const std::exception&) {
+		return nullptr;
+	}
+
+	const MappedFile& index = loader->fileContents;
+	if (index.size() < sizeof(IndexHeader)) {
+		return nullptr;
+	}
+
+	IndexHeader header;
+	std::memcpy(&header, index.data(), sizeof(header));
+	if (header.identifier != indexIdentifier || header.version != INDEX_VERSION || header.nodeCount == 0 ||
+	    (header.sourceIdentifier != acceptedIdentifier && header.sourceIdentifier != wildcard)) {
+		return nullptr;
 	}
-	return *nodeStack.top();
+
+	// an unchanged size and time is trusted, otherwise the contents decide whether the index is still valid
+	auto sourceSize = std::filesystem::file_size(fileName, ec);
+	if (ec) {
+		return nullptr;
+	}
+
+	if (sourceSize != header.sourceSize || lastWriteTime(fileName) != header.sourceTime) {
+		try {
+			if (sourceSize != header.sourceSize || hashContents(MappedFile{fileName}) != header.sourceHash) {
+				return nullptr;
+			}
+		} catch (const std::exception&) {
+			return nullptr;
+		}
+	}
+
+	if (header.nodeCount > (index.size() - sizeof(IndexHeader)) / sizeof(IndexNode)) {
+		return nullptr;
+	}
+
+	const char* table = index.data() + sizeof(IndexHeader);
+	const char* props = table + header.nodeCount * sizeof(IndexNode);
+	size_t propsSize = index.size() - (props - index.data());
+
+	loader->nodes.resize(header.nodeCount);
+	for (size_t i = 0; i < header.nodeCount; ++i) {
+		IndexNode indexNode;
+		std::memcpy(&indexNode, table + i * sizeof(IndexNode), sizeof(indexNode));
+		if (indexNode.propsOffset > propsSize || indexNode.propsSize > propsSize - indexNode.propsOffset) {
+			return nullptr;
+		}
+
+		Node& node = loader->nodes[i];
+		node.propsBegin = props + indexNode.propsOffset;
+		node.propsEnd = node.propsBegin + indexNode.propsSize;
+		node.subtreeSize = indexNode.subtreeSize;
+		node.childCount = indexNode.childCount;
+		node.type = indexNode.type;
+	}
+
+	if (!validSubtrees(loader->nodes)) {
+		return nullptr;
+	}
+	return loader;
+}
+
+bool Loader::writeIndex(const std::string& indexName, const std::string& fileName) const
+{
+	if (nodes.empty() || !escaped) {
+		return false;
+	}
+
+	IndexHeader header{};
+	header.identifier = indexIdentifier;
+	header.version = INDEX_VERSION;
+	std::copy(fileContents.begin(), fileContents.begin() + header.sourceIdentifier.size(),
+	          header.sourceIdentifier.begin());
+	header.sourceSize = fileContents.size();
+	header.sourceTime = lastWriteTime(fileName);
+	header.sourceHash = hashContents(fileContents);
+	header.nodeCount = nodes.size();
+
+	std::vector<IndexNode> table(nodes.size());
+	std::string props;
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		const Node& node = nodes[i];
+		IndexNode& indexNode = table[i];
+		indexNode.propsOffset = props.size();
+		indexNode.subtreeSize = node.subtreeSize;
+		indexNode.childCount = node.childCount;
+		indexNode.type = node.type;
+
+		bool lastEscaped = false;
+		for (auto it = node.propsBegin; it != node.propsEnd; ++it) {
+			lastEscaped = *it == static_cast<char>(Node::ESCAPE) && !lastEscaped;
+			if (!lastEscaped) {
+				props.push_back(*it);
+			}
+		}
+		indexNode.propsSize = static_cast<uint32_t>(props.size() - indexNode.propsOffset);
+	}
+
+	// written aside and renamed so an interrupted write never leaves a partial index behind
+	std::string tempName = indexName + ".tmp";
+	{
+		std::ofstream file{tempName, std::ios::binary | std::ios::trunc};
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(IndexNode));
+		file.write(props.data(), props.size());
+		if (!file) {
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempName, indexName, ec);
+	return !ec;
 }
 
 const Node& Loader::parseTree()
 {
+	if (!escaped) {
+		return nodes.front();
+	}
+
 	auto it = fileContents.begin() + sizeof(Identifier);
 	if (static_cast<uint8_t>(*it) != Node::START) {
 		throw InvalidOTBFormat{};
 	}
+
+	// a rough guess of the node count so the index rarely has to grow
+	nodes.clear();
+	nodes.reserve(fileContents.size() / 16);
+
+	Node& root = nodes.emplace_back();
 	root.type = *(++it);
 	root.propsBegin = ++it;
-	NodeStack parseStack;
-	parseStack.push(&root);
+
+	// indices of the open nodes, the index may grow while they are open
+	std::vector<uint32_t> parseStack;
+	parseStack.push_back(0);
 
 	for (; it != fileContents.end(); ++it) {
 		switch (static_cast<uint8_t>(*it)) {
 			case Node::START: {
-				auto& currentNode = getCurrentNode(parseStack);
-				if (currentNode.children.empty()) {
+				if (parseStack.empty()) {
+					throw InvalidOTBFormat{};
+				}
+
+				Node& currentNode = nodes[parseStack.back()];
+				if (currentNode.childCount++ == 0) {
 					currentNode.propsEnd = it;
 				}
-				currentNode.children.emplace_back();
-				auto& child = currentNode.children.back();
+
 				if (++it == fileContents.end()) {
 					throw InvalidOTBFormat{};
 				}
+
+				parseStack.push_back(static_cast<uint32_t>(nodes.size()));
+				Node& child = nodes.emplace_back();
 				child.type = *it;
 				child.propsBegin = it + sizeof(Node::type);
-				parseStack.push(&child);
 				break;
 			}
 			case Node::END: {
-				auto& currentNode = getCurrentNode(parseStack);
-				if (currentNode.children.empty()) {
+				if (parseStack.empty()) {
+					throw InvalidOTBFormat{};
+				}
+
+				Node& currentNode = nodes[parseStack.back()];
+				if (currentNode.childCount == 0) {
 					currentNode.propsEnd = it;
 				}
-				parseStack.pop();
+				currentNode.subtreeSize = static_cast<uint32_t>(nodes.size() - parseStack.back());
+				parseStack.pop_back();
 				break;
 			}
 			case Node::ESCAPE: {
@@ -85,15 +291,23 @@ const Node& Loader::parseTree()
 		throw InvalidOTBFormat{};
 	}
 
-	return root;
+	return nodes.front();
 }
 
-bool Loader::getProps(const Node& node, PropStream& props)
+bool Loader::getProps(const Node& node, PropStream& props) const
 {
 	auto size = std::distance(node.propsBegin, node.propsEnd);
 	if (size == 0) {
 		return false;
 	}
+
+	// most nodes have nothing escaped and can be read straight from the mapping
+	if (!escaped || !std::memchr(node.propsBegin, Node::ESCAPE, size)) {
+		props.init(node.propsBegin, size);
+		return true;
+	}
+
+	thread_local std::vector<char> propBuffer;
 	propBuffer.resize(size);
 	bool lastEscaped = false;
 
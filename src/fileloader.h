@@ -11,13 +11,47 @@ using MappedFile = boost::iostreams::mapped_file_source;
 using ContentIt = MappedFile::iterator;
 using Identifier = std::array<char, 4>;
 
+// nodes are stored flat in file order, a node's descendants directly follow it
 struct Node
 {
-	using ChildrenVector = std::vector<Node>;
+	class ChildIterator
+	{
+	public:
+		explicit ChildIterator(const Node* node) : node{node} {}
+
+		const Node& operator*() const { return *node; }
+		const Node* operator->() const { return node; }
+		ChildIterator& operator++()
+		{
+			node += node->subtreeSize;
+			return *this;
+		}
+		bool operator==(const ChildIterator& other) const { return node == other.node; }
+
+	private:
+		const Node* node;
+	};
+
+	struct Children
+	{
+		ChildIterator begin() const { return ChildIterator{first}; }
+		ChildIterator end() const { return ChildIterator{last}; }
+		size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		const Node& front() const { return *first; }
+
+		const Node* first;
+		const Node* last;
+		size_t count;
+	};
+
+	Children children() const { return {this + 1, this + subtreeSize, childCount}; }
 
-	ChildrenVector children;
 	ContentIt propsBegin;
 	ContentIt propsEnd;
+	// this node and all of its descendants
+	uint32_t subtreeSize = 1;
+	uint32_t childCount = 0;
 	uint8_t type;
 	enum NodeChar : uint8_t
 	{
@@ -40,12 +74,23 @@ struct InvalidOTBFormat final : LoadError
 class Loader
 {
 	MappedFile fileContents;
-	Node root;
-	std::vector<char> propBuffer;
+	std::vector<Node> nodes;
+	// props read from a node index are stored unescaped
+	bool escaped = true;
+
+	Loader() = default;
 
 public:
 	Loader(const std::string& fileName, const Identifier& acceptedIdentifier);
-	bool getProps(const Node& node, PropStream& props);
+
+	// opens the node index of a file written by writeIndex, nullptr if it is missing or the file has changed since
+	static std::unique_ptr<Loader> openIndex(const std::string& indexName, const std::string& fileName,
+	                                         const Identifier& acceptedIdentifier);
+	// writes the parsed tree of fileName so later loads can skip parsing and unescaping it
+	bool writeIndex(const std::string& indexName, const std::string& fileName) const;
+
+	// the props stay valid until the next call on the same thread, may be called from several threads at once
+	bool getProps(const Node& node, PropStream& props) const;
 	const Node& parseTree();
 };
 
@@ -90,6 +135,18 @@ public:
 		return {ret, true};
 	}
 
+	// the next n bytes, still owned by the buffer the stream reads
+	std::pair<std::string_view, bool> readBytes(size_t n)
+	{
+		if (size() < n) {
+			return {"", false};
+		}
+
+		std::string_view ret{p, n};
+		p += n;
+		return {ret, true};
+	}
+
 	bool skip(size_t n)
 	{
 		if (size() < n) {
@@ -114,15 +171,25 @@ public:
 	PropWriteStream(const PropWriteStream&) = delete;
 	PropWriteStream& operator=(const PropWriteStream&) = delete;
 
-	std::string_view getStream() const { return {buffer.data(), buffer.size()}; }
+	std::string_view getStream() const { return {buffer.get(), length}; }
 
-	void clear() { buffer.clear(); }
+	// keeps the buffer, a stream that is written again does not allocate until it outgrows it
+	void clear() { length = 0; }
 
 	template <typename T>
 	void write(T add)
 	{
-		char* addr = reinterpret_cast<char*>(&add);
-		std::copy(addr, addr + sizeof(T), std::back_inserter(buffer));
+		static_assert(std::is_trivially_copyable_v<T>, "PropWriteStream only writes trivially copyable values");
+		writeBytes(reinterpret_cast<const char*>(&add), sizeof(T));
+	}
+
+	void writeBytes(const char* bytes, size_t size)
+	{
+		if (size > capacity - length) {
+			grow(size);
+		}
+		std::memcpy(buffer.get() + length, bytes, size);
+		length += size;
 	}
 
 	void writeString(std::string_view str)
@@ -134,11 +201,23 @@ public:
 		}
 
 		write(static_cast<uint16_t>(strLength));
-		std::copy(str.begin(), str.end(), std::back_inserter(buffer));
+		writeBytes(str.data(), strLength);
 	}
 
 private:
-	std::vector<char> buffer;
+	void grow(size_t size)
+	{
+		capacity = std::max<size_t>({capacity * 2, length + size, 64});
+		auto grown = std::make_unique_for_overwrite<char[]>(capacity);
+		if (length != 0) {
+			std::memcpy(grown.get(), buffer.get(), length);
+		}
+		buffer = std::move(grown);
+	}
+
+	std::unique_ptr<char[]> buffer;
+	size_t length = 0;
+	size_t capacity = 0;
 };
 
 #endif // FS_FILELOADER_H
@@ -0,0 +1,144 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_FLATHASHMAP_H
+#define FS_FLATHASHMAP_H
+
+/*
+ * Open-addressing hash map with linear probing for integral keys.
+ * One key value (EmptyKey) is reserved to mark unused slots and can never be inserted.
+ * Erasing uses backward-shift deletion, so there are no tombstones and lookups stay short.
+ * Pointers returned by find/operator[] are invalidated by any insertion.
+ */
+template <typename Key, typename Value, Key EmptyKey = Key{}>
+class FlatHashMap
+{
+	static_assert(std::is_integral_v<Key>, "FlatHashMap only supports integral keys");
+
+	struct Slot
+	{
+		Key key = EmptyKey;
+		Value value{};
+	};
+
+public:
+	explicit FlatHashMap(size_t initialCapacity = 16) { rehash(std::bit_ceil(std::max<size_t>(initialCapacity, 8))); }
+
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	Value* find(Key key)
+	{
+		assert(key != EmptyKey);
+		for (size_t i = indexFor(key);; i = (i + 1) & mask) {
+			Slot& slot = slots[i];
+			if (slot.key == key) {
+				return &slot.value;
+			} else if (slot.key == EmptyKey) {
+				return nullptr;
+			}
+		}
+	}
+
+	const Value* find(Key key) const { return const_cast<FlatHashMap*>(this)->find(key); }
+
+	bool contains(Key key) const { return find(key) != nullptr; }
+
+	Value& operator[](Key key)
+	{
+		assert(key != EmptyKey);
+		if ((count + 1) * 2 > slots.size()) {
+			rehash(slots.size() * 2);
+		}
+
+		for (size_t i = indexFor(key);; i = (i + 1) & mask) {
+			Slot& slot = slots[i];
+			if (slot.key == key) {
+				return slot.value;
+			} else if (slot.key == EmptyKey) {
+				slot.key = key;
+				++count;
+				return slot.value;
+			}
+		}
+	}
+
+	bool erase(Key key)
+	{
+		assert(key != EmptyKey);
+		size_t i = indexFor(key);
+		while (slots[i].key != key) {
+			if (slots[i].key == EmptyKey) {
+				return false;
+			}
+			i = (i + 1) & mask;
+		}
+
+		// shift back every entry of the probe chain that would become unreachable
+		for (size_t j = (i + 1) & mask; slots[j].key != EmptyKey; j = (j + 1) & mask) {
+			size_t ideal = indexFor(slots[j].key);
+			if (((j - ideal) & mask) >= ((j - i) & mask)) {
+				slots[i] = std::move(slots[j]);
+				i = j;
+			}
+		}
+
+		slots[i] = Slot{};
+		--count;
+		return true;
+	}
+
+	void clear()
+	{
+		std::fill(slots.begin(), slots.end(), Slot{});
+		count = 0;
+	}
+
+	template <typename F>
+	void forEach(F&& f)
+	{
+		for (Slot& slot : slots) {
+			if (slot.key != EmptyKey) {
+				f(slot.key, slot.value);
+			}
+		}
+	}
+
+	template <typename F>
+	void forEach(F&& f) const
+	{
+		for (const Slot& slot : slots) {
+			if (slot.key != EmptyKey) {
+				f(slot.key, slot.value);
+			}
+		}
+	}
+
+private:
+	size_t indexFor(Key key) const
+	{
+		// fibonacci hashing spreads sequential ids and packed coordinates alike
+		return (static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL) >> shift;
+	}
+
+	void rehash(size_t capacity)
+	{
+		std::vector<Slot> old = std::exchange(slots, std::vector<Slot>(capacity));
+		mask = capacity - 1;
+		shift = 64 - std::countr_zero(capacity);
+		count = 0;
+
+		for (Slot& slot : old) {
+			if (slot.key != EmptyKey) {
+				(*this)[slot.key] = std::move(slot.value);
+			}
+		}
+	}
+
+	std::vector<Slot> slots;
+	size_t mask = 0;
+	size_t count = 0;
+	int shift = 0;
+};
+
+#endif // FS_FLATHASHMAP_H
@@ -0,0 +1,217 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "flowfield.h"
+
+#include "configmanager.h"
+#include "game.h"
+
+extern ConfigManager g_config;
+extern Game g_game;
+
+FlowFields g_flowFields;
+
+namespace {
+
+// fields of targets nobody chased for that long are dropped, in milliseconds
+constexpr int64_t FLOW_FIELD_IDLE_TIME = 10000;
+
+struct Neighbor
+{
+	int32_t x, y;
+	Direction direction;
+	uint32_t cost;
+};
+
+constexpr std::array<Neighbor, 8> neighbors = {{
+    {-1, 0, DIRECTION_WEST, MAP_NORMALWALKCOST},
+    {1, 0, DIRECTION_EAST, MAP_NORMALWALKCOST},
+    {0, -1, DIRECTION_NORTH, MAP_NORMALWALKCOST},
+    {0, 1, DIRECTION_SOUTH, MAP_NORMALWALKCOST},
+    {-1, -1, DIRECTION_NORTHWEST, MAP_DIAGONALWALKCOST},
+    {1, -1, DIRECTION_NORTHEAST, MAP_DIAGONALWALKCOST},
+    {-1, 1, DIRECTION_SOUTHWEST, MAP_DIAGONALWALKCOST},
+    {1, 1, DIRECTION_SOUTHEAST, MAP_DIAGONALWALKCOST},
+}};
+
+} // namespace
+
+void FlowField::build(const Map& map, const Position& targetPos)
+{
+	this->targetPos = targetPos;
+
+	Position pos = targetPos;
+	for (int32_t y = 0; y < SIZE; ++y) {
+		for (int32_t x = 0; x < SIZE; ++x) {
+			int16_t& walkCost = walkCosts[y * SIZE + x];
+			walkCost = -1;
+
+			const int32_t mapX = targetPos.x + x - RADIUS;
+			const int32_t mapY = targetPos.y + y - RADIUS;
+			if (mapX < 0 || mapY < 0 || mapX > 0xFFFF || mapY > 0xFFFF) {
+				continue;
+			}
+
+			pos.x = static_cast<uint16_t>(mapX);
+			pos.y = static_cast<uint16_t>(mapY);
+			const uint8_t walkFlags = map.getTileWalkFlags(pos.x, pos.y, pos.z);
+			if (!(walkFlags & TILEWALK_GROUND) || (walkFlags & (TILEWALK_BLOCKED | TILEWALK_SOLID))) {
+				continue;
+			}
+
+			// monsters only stay out of protection zones, the other zones are walkable
+			if (walkFlags & TILEWALK_ZONE) {
+				const Tile* tile = map.getTile(pos.x, pos.y, pos.z);
+				if (!tile || tile->hasFlag(TILESTATE_PROTECTIONZONE)) {
+					continue;
+				}
+			}
+
+			// what AStarNodes::getTileWalkCost charges a monster that would be hurt by the field
+			walkCost = (walkFlags & TILEWALK_FIELD) ? MAP_NORMALWALKCOST * 18 : 0;
+		}
+	}
+
+	// the chaser never enters the target tile, the search starts from the tiles around it
+	walkCosts[RADIUS * SIZE + RADIUS] = -1;
+	distances.fill(UNREACHABLE);
+
+	using QueueEntry = std::pair<uint32_t, int32_t>;
+	std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<>> queue;
+	for (const Neighbor& neighbor : neighbors) {
+		const int32_t index = (RADIUS + neighbor.y) * SIZE + RADIUS + neighbor.x;
+		if (walkCosts[index] >= 0) {
+			distances[index] = 0;
+			queue.emplace(0, index);
+		}
+	}
+
+	// distances[n] is the cost from n to a tile next to the target, the same A* would sum up walking it
+	while (!queue.empty()) {
+		const auto [distance, index] = queue.top();
+		queue.pop();
+		if (distance != distances[index]) {
+			continue;
+		}
+
+		const int32_t x = index % SIZE;
+		const int32_t y = index / SIZE;
+		for (const Neighbor& neighbor : neighbors) {
+			const int32_t nx = x + neighbor.x;
+			const int32_t ny = y + neighbor.y;
+			if (nx < 0 || ny < 0 || nx >= SIZE || ny >= SIZE) {
+				continue;
+			}
+
+			const int32_t next = ny * SIZE + nx;
+			if (walkCosts[next] < 0) {
+				continue;
+			}
+
+			const uint32_t nextDistance = distance + neighbor.cost + walkCosts[index];
+			if (nextDistance < distances[next]) {
+				distances[next] = nextDistance;
+				queue.emplace(nextDistance, next);
+			}
+		}
+	}
+}
+
+bool FlowField::getPath(const Map& map, const Creature& chaser, const Position& fromPos,
+                        std::vector<Direction>& dirList) const
+{
+	uint32_t distance = getDistance(fromPos);
+	if (distance == UNREACHABLE) {
+		return false;
+	}
+
+	Position pos = fromPos;
+	std::vector<Direction> steps;
+	while (distance != 0) {
+		const Neighbor* best = nullptr;
+		uint32_t bestCost = UNREACHABLE;
+		for (const Neighbor& neighbor : neighbors) {
+			const Position next(pos.x + neighbor.x, pos.y + neighbor.y, pos.z);
+			const int32_t index = getIndex(next);
+			if (index < 0 || distances[index] >= distance) {
+				continue;
+			}
+
+			const uint32_t cost = distances[index] + neighbor.cost + walkCosts[index];
+			if (cost >= bestCost) {
+				continue;
+			}
+
+			// only the first step is checked against the creatures standing around, the rest is checked while walking
+			if (steps.empty() && !map.canWalkTo(chaser, next)) {
+				continue;
+			}
+
+			best = &neighbor;
+			bestCost = cost;
+		}
+
+		if (!best) {
+			return false;
+		}
+
+		steps.push_back(best->direction);
+		pos.x += best->x;
+		pos.y += best->y;
+		distance = distances[getIndex(pos)];
+	}
+
+	dirList.assign(steps.rbegin(), steps.rend());
+	return true;
+}
+
+const FlowField* FlowFields::get(const Creature& target)
+{
+	const int32_t minChasers = g_config[ConfigKeysInteger::FLOW_FIELD_CHASERS];
+	if (minChasers <= 0) {
+		return nullptr;
+	}
+
+	const int64_t now = OTSYS_TIME();
+	Entry& entry = entries[target.getID()];
+	if (now - entry.windowStart >= EVENT_CREATURE_THINK_INTERVAL) {
+		// every chaser searching once per think interval is counted in either window
+		entry.previousRequests = now - entry.windowStart < EVENT_CREATURE_THINK_INTERVAL * 2 ? entry.requests : 0;
+		entry.requests = 0;
+		entry.windowStart = now;
+	}
+
+	++entry.requests;
+	if (std::max(entry.requests, entry.previousRequests) < static_cast<uint32_t>(minChasers)) {
+		return nullptr;
+	}
+
+	if (!entry.field) {
+		entry.field = std::make_unique<FlowField>();
+	} else if (entry.field->getTargetPosition() == target.getPosition() &&
+	           now - entry.builtAt < EVENT_CREATURE_THINK_INTERVAL) {
+		return entry.field.get();
+	}
+
+	entry.field->build(g_game.map, target.getPosition());
+	entry.builtAt = now;
+	return entry.field.get();
+}
+
+void FlowFields::cleanup()
+{
+	const int64_t now = OTSYS_TIME();
+
+	std::vector<uint32_t> idle;
+	entries.forEach([&](uint32_t targetId, const Entry& entry) {
+		if (now - entry.windowStart >= FLOW_FIELD_IDLE_TIME) {
+			idle.push_back(targetId);
+		}
+	});
+
+	for (uint32_t targetId : idle) {
+		entries.erase(targetId);
+	}
+}
@@ -0,0 +1,83 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_FLOWFIELD_H
+#define FS_FLOWFIELD_H
+
+#include "flathashmap.h"
+#include "position.h"
+
+class Creature;
+class Map;
+
+/**
+ * Walk distances towards the tiles next to one target over the area around it, built by a single Dijkstra run with
+ * the A* step costs. Creatures are left out since they move every step, a chaser checks only its next tile against
+ * the live map and follows the field downhill from there.
+ */
+class FlowField
+{
+public:
+	static constexpr int32_t RADIUS = 16;
+	static constexpr int32_t SIZE = RADIUS * 2 + 1;
+	static constexpr uint32_t UNREACHABLE = std::numeric_limits<uint32_t>::max();
+
+	void build(const Map& map, const Position& targetPos);
+
+	// steps from fromPos to a tile next to the target, last step first as in Creature::listWalkDir, false if the
+	// field does not reach fromPos or every downhill tile next to it is taken
+	bool getPath(const Map& map, const Creature& chaser, const Position& fromPos,
+	             std::vector<Direction>& dirList) const;
+
+	const Position& getTargetPosition() const { return targetPos; }
+
+private:
+	int32_t getIndex(const Position& pos) const
+	{
+		const int32_t x = pos.x - targetPos.x + RADIUS;
+		const int32_t y = pos.y - targetPos.y + RADIUS;
+		if (pos.z != targetPos.z || x < 0 || y < 0 || x >= SIZE || y >= SIZE) {
+			return -1;
+		}
+		return y * SIZE + x;
+	}
+
+	uint32_t getDistance(const Position& pos) const
+	{
+		const int32_t index = getIndex(pos);
+		return index < 0 ? UNREACHABLE : distances[index];
+	}
+
+	Position targetPos;
+	// extra cost of entering a tile, -1 if it cannot be entered
+	std::array<int16_t, SIZE * SIZE> walkCosts;
+	std::array<uint32_t, SIZE * SIZE> distances;
+};
+
+// One flow field per chased creature, used once enough chasers ask for the same target. Dispatcher thread only.
+class FlowFields
+{
+public:
+	// nullptr while fewer than the configured chasers searched towards target within the last think interval;
+	// rebuilt once the target moved or the field is a think interval old
+	const FlowField* get(const Creature& target);
+
+	// drops the fields of targets nobody chased for a while
+	void cleanup();
+
+private:
+	struct Entry
+	{
+		std::unique_ptr<FlowField> field;
+		int64_t builtAt = 0;
+		int64_t windowStart = 0;
+		uint32_t requests = 0;
+		uint32_t previousRequests = 0;
+	};
+
+	FlatHashMap<uint32_t, Entry> entries;
+};
+
+extern FlowFields g_flowFields;
+
+#endif // FS_FLOWFIELD_H
@@ -12,9 +12,15 @@
 #include "creatureevent.h"
 #include "databasetasks.h"
 #include "events.h"
+#include "flowfield.h"
 #include "globalevent.h"
+#include "governor.h"
 #include "iologindata.h"
+#include "iomapserialize.h"
 #include "items.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "metrics.h"
 #include "monster.h"
 #include "movement.h"
 #include "pugicast.h"
@@ -23,6 +29,7 @@
 #include "server.h"
 #include "spells.h"
 #include "talkaction.h"
+#include "tickprofiler.h"
 #include "weapons.h"
 
 extern ConfigManager g_config;
@@ -49,8 +56,24 @@ Game::~Game()
 void Game::start(ServiceManager* manager)
 {
 	serviceManager = manager;
-	g_scheduler.addEvent(createSchedulerTask(EVENT_CREATURE_THINK_INTERVAL, [this]() { checkCreatures(0); }));
-	g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL, [this]() { checkDecay(); }));
+	g_scheduler.addEvent(createSchedulerTask(EVENT_CREATURE_THINK_INTERVAL, [this]() { checkCreatures(0); },
+	                                         SCHEDULER_EVENT_CREATURE_THINK));
+	g_scheduler.addEvent(
+	    createSchedulerTask(EVENT_DECAYINTERVAL, [this]() { checkDecay(); }, SCHEDULER_EVENT_DECAY));
+
+	if (g_config[ConfigKeysInteger::DISPATCHER_STATS_LOG_INTERVAL] > 0) {
+		g_scheduler.addEvent(createSchedulerTask(g_config[ConfigKeysInteger::DISPATCHER_STATS_LOG_INTERVAL] * 1000,
+		                                         [this]() { logDispatcherStats(); }, SCHEDULER_EVENT_SERVER));
+	}
+
+	if (g_config[ConfigKeysInteger::ROLLING_SAVE_INTERVAL] > 0) {
+		g_scheduler.addEvent(
+		    createSchedulerTask(EVENT_ROLLING_SAVE_INTERVAL, [this]() { checkRollingSave(); }, SCHEDULER_EVENT_SERVER));
+	}
+
+	if (g_config[ConfigKeysBoolean::MAP_PAGED_STORAGE]) {
+		map.startPaging(static_cast<uint32_t>(g_config[ConfigKeysInteger::MAP_PAGE_IDLE_TIME]));
+	}
 }
 
 GameState_t Game::getGameState() const { return gameState; }
@@ -75,8 +98,6 @@ void Game::setGameState(GameState_t newState)
 
 			map.spawns.startup();
 
-			mounts.loadFromXml();
-
 			raids.loadFromXml();
 			raids.startup();
 
@@ -131,39 +152,181 @@ void Game::setGameState(GameState_t newState)
 	}
 }
 
+namespace {
+
+// storage writes queued to the database tasks that did not finish yet
+std::atomic<uint32_t> pendingStorageSaves{0};
+
+// set when a storage write failed, the next save of that storage rewrites it whole
+std::atomic<bool> gameStorageUnsynced{false};
+std::atomic<bool> accountStorageUnsynced{false};
+
+constexpr uint64_t accountStorageKey(uint32_t accountId, uint32_t key) { return (uint64_t{accountId} << 32) | key; }
+
+// the rows a storage save writes, the erased keys have no value
+template <typename Key, typename Value>
+struct StorageSave
+{
+	bool rewrite = false;
+	std::vector<std::pair<Key, std::optional<Value>>> rows;
+};
+
+template <typename Key, typename Value>
+StorageSave<Key, Value> takeStorageSave(StorageMap<Key, Value>& storageMap, std::atomic<bool>& unsynced)
+{
+	StorageSave<Key, Value> save;
+	std::vector<Key> changes = storageMap.takeChanges();
+	save.rewrite = unsynced.exchange(false);
+	if (save.rewrite) {
+		storageMap.forEach([&save](Key key, Value value) { save.rows.emplace_back(key, value); });
+		return save;
+	}
+
+	save.rows.reserve(changes.size());
+	for (Key key : changes) {
+		const Value* value = storageMap.find(key);
+		save.rows.emplace_back(key, value ? std::make_optional(*value) : std::nullopt);
+	}
+	return save;
+}
+
+bool writeGameStorageValues(Database& db, const StorageSave<uint32_t, int64_t>& save)
+{
+	if (save.rows.empty() && !save.rewrite) {
+		return true;
+	}
+
+	DBTransaction transaction{db};
+	if (!transaction.begin()) {
+		return false;
+	}
+
+	if (save.rewrite && !db.executeQuery("DELETE FROM `game_storage`")) {
+		return false;
+	}
+
+	DBInsert gameStorageQuery("REPLACE INTO `game_storage` (`key`, `value`) VALUES", db);
+	std::string erased;
+	for (const auto& [key, value] : save.rows) {
+		if (value) {
+			if (!gameStorageQuery.addRow("{:d}, {:d}", key, *value)) {
+				return false;
+			}
+		} else {
+			if (!erased.empty()) {
+				erased.push_back(',');
+			}
+			erased += std::to_string(key);
+		}
+	}
+
+	if (!gameStorageQuery.execute()) {
+		return false;
+	}
+
+	if (!erased.empty() &&
+	    !db.executeQuery(fmt::format("DELETE FROM `game_storage` WHERE `key` IN ({:s})", erased))) {
+		return false;
+	}
+
+	return transaction.commit();
+}
+
+bool writeAccountStorageValues(Database& db, const StorageSave<uint64_t, int32_t>& save)
+{
+	if (save.rows.empty() && !save.rewrite) {
+		return true;
+	}
+
+	DBTransaction transaction{db};
+	if (!transaction.begin()) {
+		return false;
+	}
+
+	if (save.rewrite && !db.executeQuery("DELETE FROM `account_storage`")) {
+		return false;
+	}
+
+	DBInsert accountStorageQuery("REPLACE INTO `account_storage` (`account_id`, `key`, `value`) VALUES", db);
+	std::string erased;
+	for (const auto& [key, value] : save.rows) {
+		const uint32_t accountId = key >> 32;
+		const uint32_t storageKey = static_cast<uint32_t>(key);
+		if (value) {
+			if (!accountStorageQuery.addRow("{:d}, {:d}, {:d}", accountId, storageKey, *value)) {
+				return false;
+			}
+		} else {
+			if (!erased.empty()) {
+				erased.push_back(',');
+			}
+			erased += fmt::format("({:d}, {:d})", accountId, storageKey);
+		}
+	}
+
+	if (!accountStorageQuery.execute()) {
+		return false;
+	}
+
+	if (!erased.empty() && !db.executeQuery(fmt::format(
+	                           "DELETE FROM `account_storage` WHERE (`account_id`, `key`) IN ({:s})", erased))) {
+		return false;
+	}
+
+	return transaction.commit();
+}
+
+} // namespace
+
 void Game::saveGameState()
 {
 	if (gameState == GAME_STATE_NORMAL) {
 		setGameState(GAME_STATE_MAINTAIN);
 	}
 
-	std::cout << "Saving server..." << std::endl;
+	Logger::log(LOG_INFO, "", "Saving server...");
+	int64_t start = OTSYS_NANOTIME();
 
-	if (!saveGameStorageValues()) {
-		std::cout << "[Error - Game::saveGameState] Failed to save game storage values." << std::endl;
-	}
+	// everything is captured while the game is paused here, the database tasks write it while the game goes on
+	auto storageJob = [gameStorage = takeStorageSave(storageMap, gameStorageUnsynced),
+	                   accountStorage = takeStorageSave(accountStorageMap, accountStorageUnsynced)](Database& db) {
+		if (!writeGameStorageValues(db, gameStorage)) {
+			gameStorageUnsynced = true;
+			Logger::log(LOG_ERROR, "Game::saveGameState", "Failed to save game storage values.");
+		}
+
+		if (!writeAccountStorageValues(db, accountStorage)) {
+			accountStorageUnsynced = true;
+			Logger::log(LOG_ERROR, "Game::saveGameState", "Failed to save account-level storage values.");
+		}
+		--pendingStorageSaves;
+	};
 
-	if (!saveAccountStorageValues()) {
-		std::cout << "[Error - Game::saveGameState] Failed to save account-level storage values." << std::endl;
+	++pendingStorageSaves;
+	if (!g_databaseTasks.addJob(storageJob, DATABASE_KEY_STORAGE_SAVES)) {
+		storageJob(Database::getInstance());
 	}
 
 	for (const auto& it : players) {
 		it.second->loginPosition = it.second->getPosition();
-		IOLoginData::savePlayer(it.second);
+		IOLoginData::savePlayerAsync(it.second);
 	}
+	IOLoginData::flushPlayerSaves();
 
-	Map::save();
+	if (!Map::save()) {
+		Logger::log(LOG_ERROR, "Game::saveGameState", "Failed to save the houses.");
+	}
 
-	g_databaseTasks.flush();
+	Logger::log(LOG_INFO, "", "> Captured the server save in: {:.3f} s", (OTSYS_NANOTIME() - start) / 1e9);
 
 	if (gameState == GAME_STATE_MAINTAIN) {
 		setGameState(GAME_STATE_NORMAL);
 	}
 }
 
-bool Game::loadMainMap(std::string_view filename)
+bool Game::loadMainMap(std::string_view filename, bool loadHouseState)
 {
-	return map.loadMap(fmt::format("data/world/{}.otbm", filename), true);
+	return map.loadMap(fmt::format("data/world/{}.otbm", filename), true, loadHouseState);
 }
 
 void Game::loadMap(const std::string& path) { map.loadMap(path, false); }
@@ -311,54 +474,20 @@ void Game::internalGetPosition(Item* item, Position& pos, uint8_t& stackpos)
 
 Creature* Game::getCreatureByID(uint32_t id)
 {
-	if (id <= Player::playerAutoID) {
-		return getPlayerByID(id);
-	} else if (id <= Monster::monsterAutoID) {
-		return getMonsterByID(id);
-	} else if (id <= Npc::npcAutoID) {
+	// every kind of creature has its own id range
+	if (id >= 0x80000000) {
 		return getNpcByID(id);
+	} else if (id >= 0x40000000) {
+		return getMonsterByID(id);
 	}
-	return nullptr;
-}
-
-Monster* Game::getMonsterByID(uint32_t id)
-{
-	if (id == 0) {
-		return nullptr;
-	}
-
-	auto it = monsters.find(id);
-	if (it == monsters.end()) {
-		return nullptr;
-	}
-	return it->second;
+	return getPlayerByID(id);
 }
 
-Npc* Game::getNpcByID(uint32_t id)
-{
-	if (id == 0) {
-		return nullptr;
-	}
-
-	auto it = npcs.find(id);
-	if (it == npcs.end()) {
-		return nullptr;
-	}
-	return it->second;
-}
+Monster* Game::getMonsterByID(uint32_t id) { return Monster::monsterIds.find(id); }
 
-Player* Game::getPlayerByID(uint32_t id)
-{
-	if (id == 0) {
-		return nullptr;
-	}
+Npc* Game::getNpcByID(uint32_t id) { return Npc::npcIds.find(id); }
 
-	auto it = players.find(id);
-	if (it == players.end()) {
-		return nullptr;
-	}
-	return it->second;
-}
+Player* Game::getPlayerByID(uint32_t id) { return Player::playerIds.find(id); }
 
 Creature* Game::getCreatureByName(const std::string& s)
 {
@@ -366,20 +495,15 @@ Creature* Game::getCreatureByName(const std::string& s)
 		return nullptr;
 	}
 
-	const std::string& lowerCaseName = boost::algorithm::to_lower_copy<std::string>(s);
-
 	{
-		auto it = mappedPlayerNames.find(lowerCaseName);
+		auto it = mappedPlayerNames.find(s);
 		if (it != mappedPlayerNames.end()) {
 			return it->second;
 		}
 	}
 
 	auto equalCreatureName = [&](const std::pair<uint32_t, Creature*>& it) {
-		auto& name = it.second->getName();
-		return lowerCaseName.size() == name.size() &&
-		       std::equal(lowerCaseName.begin(), lowerCaseName.end(), name.begin(),
-		                  [](char a, char b) { return a == std::tolower(b); });
+		return caseInsensitiveEqual(s, it.second->getName());
 	};
 
 	{
@@ -419,7 +543,7 @@ Player* Game::getPlayerByName(std::string_view s)
 		return nullptr;
 	}
 
-	auto it = mappedPlayerNames.find(boost::algorithm::to_lower_copy<std::string>(std::string{s}));
+	auto it = mappedPlayerNames.find(s);
 	if (it == mappedPlayerNames.end()) {
 		return nullptr;
 	}
@@ -447,9 +571,8 @@ ReturnValue Game::getPlayerByNameWildcard(std::string_view s, Player*& player)
 	}
 
 	if (s.back() == '~') {
-		auto query = boost::algorithm::to_lower_copy<std::string>(std::string{s.substr(0, strlen - 1)});
 		std::string result;
-		ReturnValue ret = wildcardTree.findOne(query, result);
+		ReturnValue ret = wildcardTree.findOne(s.substr(0, strlen - 1), result);
 		if (ret != RETURNVALUE_NOERROR) {
 			return ret;
 		}
@@ -519,8 +642,63 @@ bool Game::placeCreature(Creature* creature, const Position& pos, bool extendedP
 	return true;
 }
 
+bool Game::placeStartupCreature(Creature* creature, const Position& pos)
+{
+	assert(players.empty());
+
+	if (!internalPlaceCreature(creature, pos, false, true)) {
+		return false;
+	}
+
+	creature->onCreatureAppear(creature, true);
+	creature->getParent()->postAddNotification(creature, nullptr, 0);
+
+	addCreatureCheck(creature);
+	creature->onPlacedCreature();
+	return true;
+}
+
+void Game::announcePlacedCreatures(const std::vector<Creature*>& creatures,
+                                   MagicEffectClasses magicEffect /*= CONST_ME_TELEPORT*/)
+{
+	std::vector<Position> positions;
+	positions.reserve(creatures.size());
+	for (const Creature* creature : creatures) {
+		positions.push_back(creature->getPosition());
+	}
+
+	SpectatorVec spectators;
+	map.getAreaSpectators(spectators, positions);
+
+	for (Creature* spectator : spectators) {
+		if (Player* tmpPlayer = spectator->getPlayer()) {
+			for (const Creature* creature : creatures) {
+				if (Map::isInSpectatorRange(creature->getPosition(), tmpPlayer->getPosition())) {
+					tmpPlayer->sendCreatureAppear(creature, creature->getPosition(), magicEffect);
+				}
+			}
+		}
+	}
+
+	for (Creature* creature : creatures) {
+		const Position& pos = creature->getPosition();
+		for (Creature* spectator : spectators) {
+			if (Map::isInSpectatorRange(pos, spectator->getPosition())) {
+				spectator->onCreatureAppear(creature, true);
+			}
+		}
+
+		creature->getParent()->postAddNotification(creature, nullptr, 0);
+
+		addCreatureCheck(creature);
+		creature->onPlacedCreature();
+	}
+}
+
 bool Game::removeCreature(Creature* creature, bool isLogout /* = true*/)
 {
+	assert(g_dispatcher.isCurrentThread());
+
 	if (creature->isRemoved()) {
 		return false;
 	}
@@ -814,7 +992,7 @@ ReturnValue Game::internalMoveCreature(Creature* creature, Direction direction,
 ReturnValue Game::internalMoveCreature(Creature& creature, Tile& toTile, uint32_t flags /*= 0*/)
 {
 	// check if we can move the creature to the destination
-	ReturnValue ret = toTile.queryAdd(0, creature, 1, flags);
+	ReturnValue ret = toTile.queryAddCreature(creature, flags);
 	if (ret != RETURNVALUE_NOERROR) {
 		return ret;
 	}
@@ -1286,9 +1464,7 @@ ReturnValue Game::internalMoveItem(Cylinder* fromCylinder, Cylinder* toCylinder,
 
 	if (moveItem && moveItem->getDuration() > 0) {
 		if (moveItem->getDecaying() != DECAYING_TRUE) {
-			moveItem->incrementReferenceCounter();
-			moveItem->setDecaying(DECAYING_TRUE);
-			toDecayItems.push_front(moveItem);
+			queueDecay(moveItem);
 		}
 	}
 
@@ -1391,9 +1567,7 @@ ReturnValue Game::internalAddItem(Cylinder* toCylinder, Item* item, int32_t inde
 	}
 
 	if (item->getDuration() > 0) {
-		item->incrementReferenceCounter();
-		item->setDecaying(DECAYING_TRUE);
-		toDecayItems.push_front(item);
+		queueDecay(item);
 	}
 
 	return RETURNVALUE_NOERROR;
@@ -1428,9 +1602,6 @@ ReturnValue Game::internalRemoveItem(Item* item, int32_t count /*= -1*/, bool te
 
 		if (item->isRemoved()) {
 			item->onRemoved();
-			if (item->canDecay()) {
-				decayItems->remove(item);
-			}
 			ReleaseItem(item);
 		}
 
@@ -1742,9 +1913,7 @@ Item* Game::transformItem(Item* item, uint16_t newId, int32_t newCount /*= -1*/)
 
 	if (newItem->getDuration() > 0) {
 		if (newItem->getDecaying() != DECAYING_TRUE) {
-			newItem->incrementReferenceCounter();
-			newItem->setDecaying(DECAYING_TRUE);
-			toDecayItems.push_front(newItem);
+			queueDecay(newItem);
 		}
 	}
 
@@ -1766,7 +1935,7 @@ ReturnValue Game::internalTeleport(Thing* thing, const Position& newPos, bool pu
 	}
 
 	if (Creature* creature = thing->getCreature()) {
-		ReturnValue ret = toTile->queryAdd(0, *creature, 1, FLAG_NOLIMIT);
+		ReturnValue ret = toTile->queryAddCreature(*creature, FLAG_NOLIMIT);
 		if (ret != RETURNVALUE_NOERROR) {
 			return ret;
 		}
@@ -1854,7 +2023,7 @@ bool Game::playerBroadcastMessage(Player* player, std::string_view text) const
 		return false;
 	}
 
-	std::cout << "> " << player->getName() << " broadcasted: \"" << text << "\"." << std::endl;
+	Logger::log(LOG_INFO, "", "> {} broadcasted: \"{}\".", player->getName(), text);
 
 	for (const auto& it : players) {
 		it.second->sendPrivateMessage(player, TALKTYPE_BROADCAST, text);
@@ -2051,8 +2220,7 @@ Position Game::getClosestFreeTile(Creature* creature, const Position& nextPos, b
 
 	for (const auto& [x, y] : relList) {
 		if (const Tile* tile = map.getTile(nextPos.x + x, nextPos.y + y, nextPos.z)) {
-			if (tile->getGround() &&
-			    tile->queryAdd(0, *creature, 1, FLAG_IGNOREBLOCKITEM, creature) == RETURNVALUE_NOERROR) {
+			if (tile->getGround() && tile->queryAddCreature(*creature, FLAG_IGNOREBLOCKITEM) == RETURNVALUE_NOERROR) {
 				return tile->getPosition();
 			}
 		}
@@ -3726,19 +3894,24 @@ bool Game::internalCreatureSay(Creature* creature, SpeakClasses type, std::strin
 	}
 
 	// send to client
+	NetworkMessage msg;
 	for (Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			if (!ghostMode || tmpPlayer->canSeeCreature(creature)) {
-				tmpPlayer->sendCreatureSay(creature, type, text, pos);
+				if (msg.getLength() == 0) {
+					ProtocolGame::buildCreatureSay(msg, creature, type, text, pos);
+				}
+				tmpPlayer->sendSharedMessage(msg);
 			}
 		}
 	}
 
 	// event method
 	if (!echo) {
+		const bool hasOnHear = g_events->hasHandler<EventInfoId::CREATURE_ON_HEAR>();
 		for (Creature* spectator : spectators) {
 			spectator->onCreatureSay(creature, type, text);
-			if (creature != spectator) {
+			if (hasOnHear && creature != spectator) {
 				g_events->eventCreatureOnHear(spectator, creature, text, type);
 			}
 		}
@@ -3781,7 +3954,15 @@ void Game::addCreatureCheck(Creature* creature)
 	}
 
 	creature->inCheckCreaturesVector = true;
-	checkCreatureLists[uniform_random(0, EVENT_CREATURECOUNT - 1)].push_back(creature);
+
+	auto& creatureLists = checkCreatureLists[uniform_random(0, EVENT_CREATURECOUNT - 1)];
+	if (creature->getPlayer()) {
+		creatureLists.players.push_back(creature);
+	} else if (creature->getMonster()) {
+		creatureLists.monsters.push_back(creature);
+	} else {
+		creatureLists.npcs.push_back(creature);
+	}
 	creature->incrementReferenceCounter();
 }
 
@@ -3794,28 +3975,101 @@ void Game::removeCreatureCheck(Creature* creature)
 
 void Game::checkCreatures(size_t index)
 {
-	g_scheduler.addEvent(createSchedulerTask(EVENT_CHECK_CREATURE_INTERVAL,
-	                                         [=, this]() { checkCreatures((index + 1) % EVENT_CREATURECOUNT); }));
+	g_tickProfiler.endTick(g_config[ConfigKeysInteger::SLOW_TICK_THRESHOLD]);
+	g_overloadGovernor.update(OTSYS_TIME());
+	followReplans = 0;
+
+	g_scheduler.addEvent(createSchedulerTask(
+	    EVENT_CHECK_CREATURE_INTERVAL, [=, this]() { checkCreatures((index + 1) % EVENT_CREATURECOUNT); },
+	    SCHEDULER_EVENT_CREATURE_THINK));
+
+	if (index == 0) {
+		g_flowFields.cleanup();
+	}
+
+	auto& creatureLists = checkCreatureLists[index];
+	checkCreatureList<Player>(creatureLists.players);
+	decideMonsterTargets(creatureLists.monsters);
+	checkCreatureList<Monster>(creatureLists.monsters);
+	checkCreatureList<Npc>(creatureLists.npcs);
+
+	cleanup();
+}
+
+bool Game::takeFollowReplan()
+{
+	const uint32_t maxReplans = g_config[ConfigKeysInteger::MAX_FOLLOW_REPLANS];
+	if (maxReplans != 0 && followReplans >= maxReplans) {
+		return false;
+	}
+
+	++followReplans;
+	return true;
+}
+
+void Game::decideMonsterTargets(const std::vector<Creature*>& monsters)
+{
+	if (!g_jobs.isEnabled()) {
+		return;
+	}
+
+	std::vector<Monster*> deciding;
+	for (Creature* creature : monsters) {
+		Monster* monster = static_cast<Monster*>(creature);
+		if (monster->creatureCheck && !monster->isDead() && monster->needsTargetDecision()) {
+			deciding.push_back(monster);
+		}
+	}
 
-	auto& checkCreatureList = checkCreatureLists[index];
-	auto it = checkCreatureList.begin(), end = checkCreatureList.end();
-	while (it != end) {
-		Creature* creature = *it;
+	// handing out a handful of searches costs more than it saves
+	if (deciding.size() < MIN_PARALLEL_TARGET_DECISIONS) {
+		return;
+	}
+
+	// the game thread takes shares too and then waits, so no one writes to the world while the workers read it
+	const size_t shares = g_jobs.getThreadCount() + 1;
+	const size_t shareSize = (deciding.size() + shares - 1) / shares;
+
+	map.setSightCacheReadOnly(true);
+	g_jobs.parallelFor(shares, [&deciding, shareSize](size_t share) {
+		const size_t first = share * shareSize;
+		const size_t last = std::min(first + shareSize, deciding.size());
+		for (size_t i = first; i < last; ++i) {
+			deciding[i]->decideTargets();
+		}
+	});
+	map.setSightCacheReadOnly(false);
+}
+
+template <typename T>
+void Game::checkCreatureList(std::vector<Creature*>& creatures)
+{
+	const bool slowMonsters =
+	    std::is_same_v<T, Monster> && g_overloadGovernor.isEngaged(OVERLOAD_SLOW_MONSTER_THINK);
+	const int32_t fullThinkDistance = g_config[ConfigKeysInteger::MONSTER_FULL_THINK_DISTANCE];
+
+	// indexed since thinking may add creatures to this very list, order is not kept
+	for (size_t i = 0; i < creatures.size();) {
+		Creature* creature = creatures[i];
 		if (creature->creatureCheck) {
-			if (!creature->isDead()) {
-				creature->onThink(EVENT_CREATURE_THINK_INTERVAL);
-				creature->onAttacking(EVENT_CREATURE_THINK_INTERVAL);
-				creature->executeConditions(EVENT_CREATURE_THINK_INTERVAL);
+			uint32_t interval = EVENT_CREATURE_THINK_INTERVAL;
+			if constexpr (std::is_same_v<T, Monster>) {
+				interval = static_cast<Monster*>(creature)->getThinkInterval(slowMonsters, fullThinkDistance);
 			}
-			++it;
+
+			if (interval != 0 && !creature->isDead()) {
+				static_cast<T*>(creature)->onThink(interval);
+				creature->onAttacking(interval);
+				creature->executeConditions(interval);
+			}
+			++i;
 		} else {
 			creature->inCheckCreaturesVector = false;
-			it = checkCreatureList.erase(it);
+			creatures[i] = creatures.back();
+			creatures.pop_back();
 			ReleaseCreature(creature);
 		}
 	}
-
-	cleanup();
 }
 
 void Game::changeSpeed(Creature* creature, int32_t varSpeedDelta)
@@ -3868,12 +4122,70 @@ void Game::internalCreatureChangeVisible(Creature* creature, bool visible)
 
 void Game::changeLight(const Creature* creature)
 {
-	// send to clients
-	SpectatorVec spectators;
-	map.getSpectators(spectators, creature->getPosition(), true, true);
-	for (Creature* spectator : spectators) {
-		assert(dynamic_cast<Player*>(spectator) != nullptr);
-		static_cast<Player*>(spectator)->sendCreatureLight(creature);
+	if (pendingLightUpdates.empty()) {
+		g_dispatcher.addTask([this]() { flushLightUpdates(); });
+	}
+
+	if (std::find(pendingLightUpdates.begin(), pendingLightUpdates.end(), creature->getID()) ==
+	    pendingLightUpdates.end()) {
+		pendingLightUpdates.push_back(creature->getID());
+	}
+}
+
+void Game::queueMoveNotification(Creature* spectator)
+{
+	if (pendingMoveNotifications.empty()) {
+		g_dispatcher.addTask([this]() { flushMoveNotifications(); });
+	}
+	pendingMoveNotifications.push_back(spectator->getID());
+}
+
+void Game::flushMoveNotifications()
+{
+	std::vector<uint32_t> creatureIds = std::move(pendingMoveNotifications);
+	pendingMoveNotifications.clear();
+
+	for (uint32_t creatureId : creatureIds) {
+		Creature* creature = getCreatureByID(creatureId);
+		if (creature && !creature->isRemoved()) {
+			creature->flushQueuedMoves();
+		}
+	}
+}
+
+void Game::flushLightUpdates()
+{
+	std::vector<uint32_t> creatureIds = std::move(pendingLightUpdates);
+	pendingLightUpdates.clear();
+
+	for (uint32_t creatureId : creatureIds) {
+		Creature* creature = getCreatureByID(creatureId);
+		if (!creature || creature->isRemoved()) {
+			continue;
+		}
+
+		SpectatorVec spectators;
+		map.getSpectators(spectators, creature->getPosition(), true, true);
+		if (spectators.empty()) {
+			continue;
+		}
+
+		// access players see everyone at full light, the message for them is only built if one is around
+		NetworkMessage msg, fullLightMsg;
+		ProtocolGame::buildCreatureLight(msg, creature, false);
+		for (Creature* spectator : spectators) {
+			assert(dynamic_cast<Player*>(spectator) != nullptr);
+			Player* player = static_cast<Player*>(spectator);
+			if (!player->isAccessPlayer()) {
+				player->sendSharedMessage(msg, creature);
+				continue;
+			}
+
+			if (fullLightMsg.getLength() == 0) {
+				ProtocolGame::buildCreatureLight(fullLightMsg, creature, true);
+			}
+			player->sendSharedMessage(fullLightMsg, creature);
+		}
 	}
 }
 
@@ -4366,7 +4678,11 @@ bool Game::combatChangeHealth(Creature* attacker, Creature* target, CombatDamage
 		}
 
 		target->drainHealth(attacker, realDamage);
-		addCreatureHealth(spectators, target);
+		if (g_config[ConfigKeysBoolean::COALESCE_HEALTH_UPDATES]) {
+			addCreatureHealth(target);
+		} else {
+			addCreatureHealth(spectators, target);
+		}
 	}
 
 	return true;
@@ -4500,6 +4816,18 @@ bool Game::combatChangeMana(Creature* attacker, Creature* target, CombatDamage&
 
 void Game::addCreatureHealth(const Creature* target)
 {
+	if (g_config[ConfigKeysBoolean::COALESCE_HEALTH_UPDATES]) {
+		if (pendingHealthUpdates.empty()) {
+			g_dispatcher.addTask([this]() { flushHealthUpdates(); });
+		}
+
+		if (std::find(pendingHealthUpdates.begin(), pendingHealthUpdates.end(), target->getID()) ==
+		    pendingHealthUpdates.end()) {
+			pendingHealthUpdates.push_back(target->getID());
+		}
+		return;
+	}
+
 	SpectatorVec spectators;
 	map.getSpectators(spectators, target->getPosition(), true, true);
 	addCreatureHealth(spectators, target);
@@ -4507,9 +4835,15 @@ void Game::addCreatureHealth(const Creature* target)
 
 void Game::addCreatureHealth(const SpectatorVec& spectators, const Creature* target)
 {
+	if (spectators.empty()) {
+		return;
+	}
+
+	NetworkMessage msg;
+	ProtocolGame::buildCreatureHealth(msg, target);
 	for (Creature* spectator : spectators) {
 		assert(dynamic_cast<Player*>(spectator) != nullptr);
-		static_cast<Player*>(spectator)->sendCreatureHealth(target);
+		static_cast<Player*>(spectator)->sendSharedMessage(msg);
 	}
 }
 
@@ -4527,14 +4861,28 @@ void Game::addAnimatedText(std::string_view message, const Position& pos, TextCo
 void Game::addAnimatedText(const SpectatorVec& spectators, std::string_view message, const Position& pos,
                            TextColor_t color)
 {
+	if (spectators.empty()) {
+		return;
+	}
+
+	NetworkMessage msg;
+	ProtocolGame::buildAnimatedText(msg, message, pos, color);
 	for (Creature* spectator : spectators) {
 		assert(dynamic_cast<Player*>(spectator) != nullptr);
-		static_cast<Player*>(spectator)->sendAnimatedText(message, pos, color);
+		static_cast<Player*>(spectator)->sendSharedEffect(msg, pos);
 	}
 }
 
 void Game::addMagicEffect(const Position& pos, uint8_t effect)
 {
+	if (g_config[ConfigKeysBoolean::BATCH_EFFECTS] || g_overloadGovernor.isEngaged(OVERLOAD_COALESCE_EFFECTS)) {
+		if (pendingEffects.empty()) {
+			g_dispatcher.addTask([this]() { flushEffects(); });
+		}
+		pendingEffects.push_back({pos, pos, effect, false});
+		return;
+	}
+
 	SpectatorVec spectators;
 	map.getSpectators(spectators, pos, true, true);
 	addMagicEffect(spectators, pos, effect);
@@ -4550,6 +4898,16 @@ void Game::addMagicEffect(const SpectatorVec& spectators, const Position& pos, u
 
 void Game::addDistanceEffect(const Position& fromPos, const Position& toPos, uint8_t effect)
 {
+	// effects between floors have two differently shaped spectator areas and are not batched
+	if ((g_config[ConfigKeysBoolean::BATCH_EFFECTS] || g_overloadGovernor.isEngaged(OVERLOAD_COALESCE_EFFECTS)) &&
+	    fromPos.z == toPos.z) {
+		if (pendingEffects.empty()) {
+			g_dispatcher.addTask([this]() { flushEffects(); });
+		}
+		pendingEffects.push_back({fromPos, toPos, effect, true});
+		return;
+	}
+
 	SpectatorVec spectators, toPosSpectators;
 	map.getSpectators(spectators, fromPos, true, true);
 	map.getSpectators(toPosSpectators, toPos, true, true);
@@ -4567,24 +4925,132 @@ void Game::addDistanceEffect(const SpectatorVec& spectators, const Position& fro
 	}
 }
 
+namespace {
+
+// same test as a multifloor Map::getSpectators around centerPos with the default viewport
+bool isSpectatorOf(const Position& spectatorPos, const Position& centerPos)
+{
+	int32_t minRangeZ, maxRangeZ;
+	if (centerPos.z > 7) {
+		minRangeZ = std::max(centerPos.getZ() - 2, 0);
+		maxRangeZ = std::min(centerPos.getZ() + 2, MAP_MAX_LAYERS - 1);
+	} else if (centerPos.z == 6) {
+		minRangeZ = 0;
+		maxRangeZ = 8;
+	} else if (centerPos.z == 7) {
+		minRangeZ = 0;
+		maxRangeZ = 9;
+	} else {
+		minRangeZ = 0;
+		maxRangeZ = 7;
+	}
+
+	if (spectatorPos.z < minRangeZ || spectatorPos.z > maxRangeZ) {
+		return false;
+	}
+
+	int32_t offsetZ = centerPos.getZ() - spectatorPos.getZ();
+	return spectatorPos.x >= centerPos.x - Map::maxViewportX + offsetZ &&
+	       spectatorPos.x <= centerPos.x + Map::maxViewportX + offsetZ &&
+	       spectatorPos.y >= centerPos.y - Map::maxViewportY + offsetZ &&
+	       spectatorPos.y <= centerPos.y + Map::maxViewportY + offsetZ;
+}
+
+} // namespace
+
+void Game::flushEffects()
+{
+	std::vector<PendingEffect> effects = std::move(pendingEffects);
+	pendingEffects.clear();
+
+	if (g_overloadGovernor.isEngaged(OVERLOAD_COALESCE_EFFECTS)) {
+		// the same effect queued twice between two flushes looks the same sent once
+		auto key = [](const PendingEffect& effect) {
+			return std::tie(effect.fromPos, effect.toPos, effect.effect, effect.distance);
+		};
+		auto less = [&](const PendingEffect& lhs, const PendingEffect& rhs) { return key(lhs) < key(rhs); };
+		auto equal = [&](const PendingEffect& lhs, const PendingEffect& rhs) { return key(lhs) == key(rhs); };
+		std::sort(effects.begin(), effects.end(), less);
+		effects.erase(std::unique(effects.begin(), effects.end(), equal), effects.end());
+	}
+
+	// effects starting in the same 16x16 area share one spectator lookup over their bounding box
+	auto getAreaKey = [](const PendingEffect& effect) {
+		return ((effect.fromPos.x >> 4) << 16) | ((effect.fromPos.y >> 4) << 4) | effect.fromPos.z;
+	};
+	std::stable_sort(effects.begin(), effects.end(), [&](const PendingEffect& lhs, const PendingEffect& rhs) {
+		return getAreaKey(lhs) < getAreaKey(rhs);
+	});
+
+	for (auto first = effects.begin(); first != effects.end();) {
+		const int32_t areaKey = getAreaKey(*first);
+		auto last = std::find_if(first, effects.end(),
+		                         [&](const PendingEffect& effect) { return getAreaKey(effect) != areaKey; });
+
+		int32_t minX = first->fromPos.x, maxX = minX;
+		int32_t minY = first->fromPos.y, maxY = minY;
+		for (auto it = first; it != last; ++it) {
+			for (const Position& pos : {it->fromPos, it->toPos}) {
+				minX = std::min<int32_t>(minX, pos.x);
+				maxX = std::max<int32_t>(maxX, pos.x);
+				minY = std::min<int32_t>(minY, pos.y);
+				maxY = std::max<int32_t>(maxY, pos.y);
+			}
+		}
+
+		SpectatorVec spectators;
+		map.getSpectators(spectators, Position(minX, minY, first->fromPos.z), true, true, Map::maxViewportX,
+		                  maxX - minX + Map::maxViewportX, Map::maxViewportY, maxY - minY + Map::maxViewportY);
+		for (Creature* spectator : spectators) {
+			assert(dynamic_cast<Player*>(spectator) != nullptr);
+			Player* player = static_cast<Player*>(spectator);
+			const Position& playerPos = player->getPosition();
+			for (auto it = first; it != last; ++it) {
+				if (!it->distance) {
+					if (isSpectatorOf(playerPos, it->fromPos)) {
+						player->sendMagicEffect(it->fromPos, it->effect);
+					}
+				} else if (isSpectatorOf(playerPos, it->fromPos) || isSpectatorOf(playerPos, it->toPos)) {
+					player->sendDistanceShoot(it->fromPos, it->toPos, it->effect);
+				}
+			}
+		}
+
+		first = last;
+	}
+}
+
+void Game::flushHealthUpdates()
+{
+	std::vector<uint32_t> creatureIds = std::move(pendingHealthUpdates);
+	pendingHealthUpdates.clear();
+
+	for (uint32_t creatureId : creatureIds) {
+		Creature* creature = getCreatureByID(creatureId);
+		if (!creature || creature->isRemoved()) {
+			continue;
+		}
+
+		SpectatorVec spectators;
+		map.getSpectators(spectators, creature->getPosition(), true, true);
+		addCreatureHealth(spectators, creature);
+	}
+}
+
 void Game::setAccountStorageValue(const uint32_t accountId, const uint32_t key, const int32_t value)
 {
 	if (value == -1) {
-		accountStorageMap[accountId].erase(key);
+		accountStorageMap.erase(accountStorageKey(accountId, key));
 		return;
 	}
 
-	accountStorageMap[accountId][key] = value;
+	accountStorageMap.set(accountStorageKey(accountId, key), value);
 }
 
 int32_t Game::getAccountStorageValue(const uint32_t accountId, const uint32_t key) const
 {
-	const auto& accountMapIt = accountStorageMap.find(accountId);
-	if (accountMapIt != accountStorageMap.end()) {
-		const auto& storageMapIt = accountMapIt->second.find(key);
-		if (storageMapIt != accountMapIt->second.end()) {
-			return storageMapIt->second;
-		}
+	if (const int32_t* value = accountStorageMap.find(accountStorageKey(accountId, key))) {
+		return *value;
 	}
 	return -1;
 }
@@ -4600,40 +5066,23 @@ void Game::loadAccountStorageValues()
 			                              result->getNumber<int32_t>("value"));
 		} while (result->next());
 	}
+	// the loaded values are what the database holds already
+	accountStorageMap.takeChanges();
 }
 
-bool Game::saveAccountStorageValues() const
+bool Game::saveAccountStorageValues()
 {
-	DBTransaction transaction;
-	Database& db = Database::getInstance();
-
-	if (!transaction.begin()) {
-		return false;
+	// the values written now must not be overwritten by an older capture still on its way
+	if (pendingStorageSaves != 0) {
+		g_databaseTasks.flush();
 	}
 
-	if (!db.executeQuery("DELETE FROM `account_storage`")) {
+	auto save = takeStorageSave(accountStorageMap, accountStorageUnsynced);
+	if (!writeAccountStorageValues(Database::getInstance(), save)) {
+		accountStorageUnsynced = true;
 		return false;
 	}
-
-	for (const auto& accountIt : g_game.accountStorageMap) {
-		if (accountIt.second.empty()) {
-			break;
-		}
-
-		DBInsert accountStorageQuery("INSERT INTO `account_storage` (`account_id`, `key`, `value`) VALUES");
-		for (const auto& storageIt : accountIt.second) {
-			if (!accountStorageQuery.addRow(
-			        fmt::format("{:d}, {:d}, {:d}", accountIt.first, storageIt.first, storageIt.second))) {
-				return false;
-			}
-		}
-
-		if (!accountStorageQuery.execute()) {
-			return false;
-		}
-	}
-
-	return transaction.commit();
+	return true;
 }
 
 void Game::startDecay(Item* item)
@@ -4648,14 +5097,29 @@ void Game::startDecay(Item* item)
 	}
 
 	if (item->getDuration() > 0) {
-		item->incrementReferenceCounter();
-		item->setDecaying(DECAYING_TRUE);
-		toDecayItems.push_front(item);
+		queueDecay(item);
 	} else {
 		internalDecayItem(item);
 	}
 }
 
+void Game::queueDecay(Item* item)
+{
+	item->setDecaying(DECAYING_TRUE);
+
+	// an entry that expires no later than the new deadline is already queued, the item is requeued when it pops
+	const int64_t deadline = item->getDecayDeadline();
+	const int64_t queued = item->getQueuedDecay();
+	if (queued != 0 && queued <= deadline) {
+		return;
+	}
+
+	// any earlier entry for this item is now stale and only drops its reference once popped
+	item->incrementReferenceCounter();
+	item->setQueuedDecay(deadline);
+	decayQueue.push({deadline, item});
+}
+
 void Game::internalDecayItem(Item* item)
 {
 	const int32_t decayTo = item->getDecayTo();
@@ -4664,54 +5128,114 @@ void Game::internalDecayItem(Item* item)
 	} else {
 		ReturnValue ret = internalRemoveItem(item);
 		if (ret != RETURNVALUE_NOERROR) {
-			std::cout << "[Debug - Game::internalDecayItem] internalDecayItem failed, error code: "
-			          << static_cast<uint32_t>(ret) << ", item id: " << item->getID() << std::endl;
+			Logger::log(LOG_DEBUG, "Game::internalDecayItem", "internalDecayItem failed, error code: {}, item id: {}",
+			            static_cast<uint32_t>(ret), item->getID());
 		}
 	}
 }
 
+void Game::logDispatcherStats()
+{
+	g_scheduler.addEvent(createSchedulerTask(g_config[ConfigKeysInteger::DISPATCHER_STATS_LOG_INTERVAL] * 1000,
+	                                         [this]() { logDispatcherStats(); }, SCHEDULER_EVENT_SERVER));
+	g_dispatcher.logTaskStats();
+	g_databaseTasks.logStats();
+	Item::logPoolStats();
+}
+
+void Game::checkRollingSave()
+{
+	g_scheduler.addEvent(
+	    createSchedulerTask(EVENT_ROLLING_SAVE_INTERVAL, [this]() { checkRollingSave(); }, SCHEDULER_EVENT_SERVER));
+
+	// a server save or the shutdown writes everything anyway, and the database is behind already when the
+	// dispatcher is
+	if (gameState != GAME_STATE_NORMAL || g_overloadGovernor.isEngaged(OVERLOAD_DEFER_SAVES)) {
+		return;
+	}
+
+	const int64_t interval = g_config[ConfigKeysInteger::ROLLING_SAVE_INTERVAL] * 60 * 1000;
+	const auto share = [interval](size_t count) {
+		return static_cast<size_t>((count * EVENT_ROLLING_SAVE_INTERVAL + interval - 1) / interval);
+	};
+
+	// the players saved longest ago, those saved on their own since (logout, player:save()) wait for their turn
+	const int64_t now = OTSYS_TIME();
+	std::vector<Player*> due;
+	for (const auto& it : players) {
+		if (now - it.second->getLastSaveTime() >= interval) {
+			due.push_back(it.second);
+		}
+	}
+
+	const size_t playerCount = std::min(due.size(), share(players.size()));
+	std::partial_sort(due.begin(), due.begin() + playerCount, due.end(), [](const Player* lhs, const Player* rhs) {
+		return lhs->getLastSaveTime() < rhs->getLastSaveTime();
+	});
+	for (size_t i = 0; i < playerCount; ++i) {
+		due[i]->loginPosition = due[i]->getPosition();
+		IOLoginData::savePlayerAsync(due[i]);
+	}
+	IOLoginData::flushPlayerSaves();
+
+	// the houses go round by id, so each is written once per interval
+	const HouseMap& houseMap = map.houses.getHouses();
+	std::vector<const House*> houses;
+	const size_t houseCount = std::min(houseMap.size(), share(houseMap.size()));
+	auto it = houseMap.upper_bound(rollingSaveHouseId);
+	while (houses.size() < houseCount) {
+		if (it == houseMap.end()) {
+			it = houseMap.begin();
+		}
+		houses.push_back(it->second);
+		rollingSaveHouseId = it->first;
+		++it;
+	}
+
+	if (!IOMapSerialize::saveHouseInfo(houses) || !IOMapSerialize::saveHouseItems(houses)) {
+		Logger::log(LOG_ERROR, "Game::checkRollingSave", "Failed to save {} houses.", houses.size());
+	}
+}
+
 void Game::checkDecay()
 {
-	g_scheduler.addEvent(createSchedulerTask(EVENT_DECAYINTERVAL, [this]() { checkDecay(); }));
+	g_scheduler.addEvent(
+	    createSchedulerTask(EVENT_DECAYINTERVAL, [this]() { checkDecay(); }, SCHEDULER_EVENT_DECAY));
 
-	size_t bucket = (lastBucket + 1) % EVENT_DECAY_BUCKETS;
+	const int64_t now = OTSYS_TIME();
+	while (!decayQueue.empty() && decayQueue.top().deadline <= now) {
+		auto [deadline, item] = decayQueue.top();
+		decayQueue.pop();
+
+		if (deadline != item->getQueuedDecay()) {
+			ReleaseItem(item);
+			continue;
+		}
+		item->setQueuedDecay(0);
 
-	auto it = decayItems[bucket].begin(), end = decayItems[bucket].end();
-	while (it != end) {
-		Item* item = *it;
 		if (!item->canDecay()) {
 			item->setDecaying(DECAYING_FALSE);
 			ReleaseItem(item);
-			it = decayItems[bucket].erase(it);
 			continue;
 		}
 
-		int32_t duration = item->getDuration();
-		int32_t decreaseTime = std::min<int32_t>(EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS, duration);
-
-		duration -= decreaseTime;
-		item->decreaseDuration(decreaseTime);
-
-		if (duration <= 0) {
-			it = decayItems[bucket].erase(it);
-			internalDecayItem(item);
+		if (item->getDecaying() != DECAYING_TRUE) {
 			ReleaseItem(item);
-		} else if (duration < EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS) {
-			it = decayItems[bucket].erase(it);
-			size_t newBucket =
-			    (bucket + static_cast<size_t>((duration + EVENT_DECAYINTERVAL / 2) / 1000)) % EVENT_DECAY_BUCKETS;
-			if (newBucket == bucket) {
-				internalDecayItem(item);
-				ReleaseItem(item);
-			} else {
-				decayItems[newBucket].push_back(item);
-			}
-		} else {
-			++it;
+			continue;
+		}
+
+		// the duration was extended while queued, keep the reference and wait for the new deadline
+		const int64_t decayDeadline = item->getDecayDeadline();
+		if (decayDeadline > now) {
+			item->setQueuedDecay(decayDeadline);
+			decayQueue.push({decayDeadline, item});
+			continue;
 		}
+
+		internalDecayItem(item);
+		ReleaseItem(item);
 	}
 
-	lastBucket = bucket;
 	cleanup();
 }
 
@@ -4721,6 +5245,7 @@ void Game::shutdown()
 
 	g_scheduler.shutdown();
 	g_databaseTasks.shutdown();
+	g_jobs.shutdown();
 	g_dispatcher.shutdown();
 	map.spawns.clear();
 	raids.clear();
@@ -4748,16 +5273,6 @@ void Game::cleanup()
 		item->decrementReferenceCounter();
 	}
 	ToReleaseItems.clear();
-
-	for (Item* item : toDecayItems) {
-		const uint32_t dur = item->getDuration();
-		if (dur >= EVENT_DECAYINTERVAL * EVENT_DECAY_BUCKETS) {
-			decayItems[lastBucket].push_back(item);
-		} else {
-			decayItems[(lastBucket + 1 + dur / 1000) % EVENT_DECAY_BUCKETS].push_back(item);
-		}
-	}
-	toDecayItems.clear();
 }
 
 void Game::ReleaseCreature(Creature* creature) { ToReleaseCreatures.push_back(creature); }
@@ -4766,7 +5281,7 @@ void Game::ReleaseItem(Item* item) { ToReleaseItems.push_back(item); }
 
 void Game::broadcastMessage(std::string_view text, MessageClasses type) const
 {
-	std::cout << "> Broadcasted message: \"" << text << "\"." << std::endl;
+	Logger::log(LOG_INFO, "", "> Broadcasted message: \"{}\".", text);
 	for (const auto& it : players) {
 		it.second->sendTextMessage(type, text);
 	}
@@ -5124,29 +5639,81 @@ void Game::playerAnswerModalWindow(uint32_t playerId, uint32_t modalWindowId, ui
 
 void Game::addPlayer(Player* player)
 {
-	const std::string& lowercase_name = boost::algorithm::to_lower_copy<std::string>(player->getName());
-	mappedPlayerNames[lowercase_name] = player;
+	mappedPlayerNames[player->getName()] = player;
 	mappedPlayerGuids[player->getGUID()] = player;
-	wildcardTree.insert(lowercase_name);
+	wildcardTree.insert(player->getName());
 	players[player->getID()] = player;
+	Player::playerIds.set(player->getID(), player);
+	metrics::playersOnline.add();
 }
 
 void Game::removePlayer(Player* player)
 {
-	const std::string& lowercase_name = boost::algorithm::to_lower_copy<std::string>(player->getName());
-	mappedPlayerNames.erase(lowercase_name);
+	mappedPlayerNames.erase(player->getName());
 	mappedPlayerGuids.erase(player->getGUID());
-	wildcardTree.remove(lowercase_name);
+	wildcardTree.remove(player->getName());
 	players.erase(player->getID());
+	Player::playerIds.set(player->getID(), nullptr);
+	metrics::playersOnline.sub();
 }
 
-void Game::addNpc(Npc* npc) { npcs[npc->getID()] = npc; }
+void Game::addVIPWatcher(uint32_t guid, Player* watcher) { vipWatchers[guid].push_back(watcher); }
 
-void Game::removeNpc(Npc* npc) { npcs.erase(npc->getID()); }
+void Game::removeVIPWatcher(uint32_t guid, Player* watcher)
+{
+	auto it = vipWatchers.find(guid);
+	if (it == vipWatchers.end()) {
+		return;
+	}
+
+	auto& watchers = it->second;
+	auto watcherIt = std::find(watchers.begin(), watchers.end(), watcher);
+	if (watcherIt != watchers.end()) {
+		*watcherIt = watchers.back();
+		watchers.pop_back();
+	}
+
+	if (watchers.empty()) {
+		vipWatchers.erase(it);
+	}
+}
+
+void Game::notifyVIPWatchers(Player* player, VipStatus_t status)
+{
+	auto it = vipWatchers.find(player->getGUID());
+	if (it == vipWatchers.end()) {
+		return;
+	}
+
+	for (Player* watcher : it->second) {
+		watcher->notifyStatusChange(player, status);
+	}
+}
 
-void Game::addMonster(Monster* monster) { monsters[monster->getID()] = monster; }
+void Game::addNpc(Npc* npc)
+{
+	// ids mostly grow, so the end is the right place and placing every npc at startup does not search the tree
+	npcs.insert_or_assign(npcs.end(), npc->getID(), npc);
+	Npc::npcIds.set(npc->getID(), npc);
+}
 
-void Game::removeMonster(Monster* monster) { monsters.erase(monster->getID()); }
+void Game::removeNpc(Npc* npc)
+{
+	npcs.erase(npc->getID());
+	Npc::npcIds.set(npc->getID(), nullptr);
+}
+
+void Game::addMonster(Monster* monster)
+{
+	monsters.insert_or_assign(monsters.end(), monster->getID(), monster);
+	Monster::monsterIds.set(monster->getID(), monster);
+}
+
+void Game::removeMonster(Monster* monster)
+{
+	monsters.erase(monster->getID());
+	Monster::monsterIds.set(monster->getID(), nullptr);
+}
 
 Guild* Game::getGuild(uint32_t id) const
 {
@@ -5189,10 +5756,15 @@ BedItem* Game::getBedBySleeper(uint32_t guid) const
 	return it->second;
 }
 
-void Game::setBedSleeper(BedItem* bed, uint32_t guid) { bedSleepersMap[guid] = bed; }
+void Game::setBedSleeper(BedItem* bed, uint32_t guid)
+{
+	std::lock_guard<std::mutex> lockGuard(mapItemsLock);
+	bedSleepersMap[guid] = bed;
+}
 
 void Game::removeBedSleeper(uint32_t guid)
 {
+	std::lock_guard<std::mutex> lockGuard(mapItemsLock);
 	auto it = bedSleepersMap.find(guid);
 	if (it != bedSleepersMap.end()) {
 		bedSleepersMap.erase(it);
@@ -5210,15 +5782,17 @@ Item* Game::getUniqueItem(uint16_t uniqueId)
 
 bool Game::addUniqueItem(uint16_t uniqueId, Item* item)
 {
+	std::lock_guard<std::mutex> lockGuard(mapItemsLock);
 	auto result = uniqueItems.emplace(uniqueId, item);
 	if (!result.second) {
-		std::cout << "Duplicate unique id: " << uniqueId << std::endl;
+		Logger::log(LOG_INFO, "", "Duplicate unique id: {}", uniqueId);
 	}
 	return result.second;
 }
 
 void Game::removeUniqueItem(uint16_t uniqueId)
 {
+	std::lock_guard<std::mutex> lockGuard(mapItemsLock);
 	auto it = uniqueItems.find(uniqueId);
 	if (it != uniqueItems.end()) {
 		uniqueItems.erase(it);
@@ -5280,16 +5854,10 @@ bool Game::reload(ReloadTypes_t reloadType)
 		}
 
 		case RELOAD_TYPE_SCRIPTS: {
+			// only the changed files run again, unchanged ones keep what they registered
 			// commented out stuff is TODO, once we approach further in revscriptsys
-			g_actions->clear(true);
-			g_creatureEvents->clear(true);
-			g_moveEvents->clear(true);
-			g_talkActions->clear(true);
-			g_globalEvents->clear(true);
-			g_weapons->clear(true);
+			g_scripts->reloadChangedScripts("scripts");
 			g_weapons->loadDefaults();
-			g_spells->clear(true);
-			g_scripts->loadScripts("scripts", false, true);
 			g_creatureEvents->removeInvalidEvents();
 			/*
 			Npcs::reload();
@@ -5341,6 +5909,77 @@ bool Game::reload(ReloadTypes_t reloadType)
 	return true;
 }
 
+namespace {
+
+// runs work on a worker and done with its result in a dispatcher task, without workers work runs right here
+template <typename Work, typename Done>
+void runReloadJob(Work&& work, Done&& done)
+{
+	if (!g_jobs.isEnabled()) {
+		g_dispatcher.addTask(std::function<void()>{[done, result = work()]() mutable { done(std::move(result)); }});
+		return;
+	}
+	g_jobs.addJob(std::forward<Work>(work), std::forward<Done>(done));
+}
+
+} // namespace
+
+bool Game::reloadInBackground(ReloadTypes_t reloadType, std::function<void(bool)> callback)
+{
+	if (backgroundReloadRunning) {
+		return false;
+	}
+
+	backgroundReloadRunning = true;
+	auto finish = [this, callback = std::move(callback)](bool result) {
+		backgroundReloadRunning = false;
+		callback(result);
+	};
+
+	switch (reloadType) {
+		case RELOAD_TYPE_ITEMS: {
+			runReloadJob(
+			    []() {
+				    auto items = std::make_shared<Items>();
+				    return items->load() ? items : nullptr;
+			    },
+			    [finish](std::shared_ptr<Items> items) {
+				    if (!items) {
+					    finish(false);
+					    return;
+				    }
+
+				    // the old types are left in items and freed with the last task holding them
+				    Item::items.swap(*items);
+				    Items::reloadScripts();
+				    finish(true);
+			    });
+			break;
+		}
+
+		case RELOAD_TYPE_MONSTERS: {
+			// the names are taken here, reading monsterTypeIds on the worker would race the lazy loads
+			const bool forceLoad = g_config[ConfigKeysBoolean::FORCE_MONSTERTYPE_LOAD];
+			runReloadJob(
+			    [names = g_monsters.getLoadedNames(), forceLoad]() {
+				    return std::make_shared<Monsters::MonsterFiles>(Monsters::readMonsterFiles(names, forceLoad));
+			    },
+			    [finish](std::shared_ptr<Monsters::MonsterFiles> monsterFiles) {
+				    // loading scripts and spells of the types needs the game thread, the files are parsed already
+				    finish(g_monsters.applyMonsterFiles(*monsterFiles, true));
+			    });
+			break;
+		}
+
+		default: {
+			g_dispatcher.addTask(std::function<void()>{
+			    [this, reloadType, finish = std::move(finish)]() { finish(reload(reloadType)); }});
+			break;
+		}
+	}
+	return true;
+}
+
 void Game::loadGameStorageValues()
 {
 	Database& db = Database::getInstance();
@@ -5351,39 +5990,27 @@ void Game::loadGameStorageValues()
 			g_game.setStorageValue(result->getNumber<uint32_t>("key"), result->getNumber<int32_t>("value"));
 		} while (result->next());
 	}
+	storageMap.takeChanges();
 }
 
-bool Game::saveGameStorageValues() const
+bool Game::saveGameStorageValues()
 {
-	DBTransaction transaction;
-	Database& db = Database::getInstance();
-
-	if (!transaction.begin()) {
-		return false;
+	if (pendingStorageSaves != 0) {
+		g_databaseTasks.flush();
 	}
 
-	if (!db.executeQuery("DELETE FROM `game_storage`")) {
+	auto save = takeStorageSave(storageMap, gameStorageUnsynced);
+	if (!writeGameStorageValues(Database::getInstance(), save)) {
+		gameStorageUnsynced = true;
 		return false;
 	}
-
-	for (const auto& [key, value] : g_game.storageMap) {
-		DBInsert gameStorageQuery("INSERT INTO `game_storage` (`key`, `value`) VALUES");
-		if (!gameStorageQuery.addRow(fmt::format("{:d}, {:d}", key, value))) {
-			return false;
-		}
-
-		if (!gameStorageQuery.execute()) {
-			return false;
-		}
-	}
-
-	return transaction.commit();
+	return true;
 }
 
 void Game::setStorageValue(uint32_t key, std::optional<int64_t> value)
 {
 	if (value) {
-		storageMap.insert_or_assign(key, value.value());
+		storageMap.set(key, value.value());
 	} else {
 		storageMap.erase(key);
 	}
@@ -5391,9 +6018,8 @@ void Game::setStorageValue(uint32_t key, std::optional<int64_t> value)
 
 std::optional<int64_t> Game::getStorageValue(uint32_t key) const
 {
-	auto it = storageMap.find(key);
-	if (it == storageMap.end()) {
-		return std::nullopt;
+	if (const int64_t* value = storageMap.find(key)) {
+		return *value;
 	}
-	return std::make_optional(it->second);
+	return std::nullopt;
 }
@@ -15,6 +15,7 @@
 #include "player.h"
 #include "position.h"
 #include "raids.h"
+#include "storagemap.h"
 #include "wildcardtree.h"
 
 class ServiceManager;
@@ -55,7 +56,9 @@ inline constexpr int32_t PLAYER_NAME_LENGTH = 25;
 inline constexpr int32_t EVENT_LIGHTINTERVAL = 10000;
 inline constexpr int32_t EVENT_WORLDTIMEINTERVAL = 2500;
 inline constexpr int32_t EVENT_DECAYINTERVAL = 250;
-inline constexpr int32_t EVENT_DECAY_BUCKETS = 4;
+inline constexpr int32_t EVENT_ROLLING_SAVE_INTERVAL = 1000;
+
+inline constexpr size_t MIN_PARALLEL_TARGET_DECISIONS = 32;
 
 inline constexpr int32_t MOVE_CREATURE_INTERVAL = 1000;
 inline constexpr int32_t RANGE_MOVE_CREATURE_INTERVAL = 1500;
@@ -88,7 +91,7 @@ public:
 	void forceAddCondition(uint32_t creatureId, Condition* condition);
 	void forceRemoveCondition(uint32_t creatureId, ConditionType_t type);
 
-	bool loadMainMap(std::string_view filename);
+	bool loadMainMap(std::string_view filename, bool loadHouseState = true);
 	void loadMap(const std::string& path);
 
 	/**
@@ -201,6 +204,19 @@ public:
 	bool placeCreature(Creature* creature, const Position& pos, bool extendedPos = false, bool forced = false,
 	                   MagicEffectClasses magicEffect = CONST_ME_TELEPORT);
 
+	/**
+	 * Place Creature on the map before any player is online.
+	 * Only the creature itself learns that it appeared, there are no spectators to look up and notify.
+	 */
+	bool placeStartupCreature(Creature* creature, const Position& pos);
+
+	/**
+	 * Announce creatures already put on the map by internalPlaceCreature the way placeCreature does.
+	 * The spectators of all of them are looked up at once and each player gets the appearances it sees together.
+	 */
+	void announcePlacedCreatures(const std::vector<Creature*>& creatures,
+	                             MagicEffectClasses magicEffect = CONST_ME_TELEPORT);
+
 	/**
 	 * Remove Creature from the map.
 	 * Removes the Creature from the map
@@ -398,6 +414,8 @@ public:
 	void internalCreatureChangeOutfit(Creature* creature, const Outfit_t& outfit);
 	void internalCreatureChangeVisible(Creature* creature, bool visible);
 	void changeLight(const Creature* creature);
+	// the spectator's queued creature moves are flushed by a dispatcher task, once for everyone queued in a tick
+	void queueMoveNotification(Creature* spectator);
 	void updateCreatureSkull(const Creature* creature);
 	void updatePlayerShield(Player* player);
 	void updateCreatureWalkthrough(const Creature* creature);
@@ -412,6 +430,11 @@ public:
 	void updateCreatureWalk(uint32_t creatureId);
 	void checkCreatureAttack(uint32_t creatureId);
 	void checkCreatures(size_t index);
+	// counts a full follow path search of a monster, false once this creature check used up the configured cap
+	bool takeFollowReplan();
+	void decideMonsterTargets(const std::vector<Creature*>& monsters);
+	template <typename T>
+	void checkCreatureList(std::vector<Creature*>& creatures);
 
 	bool combatBlockHit(CombatDamage& damage, Creature* attacker, Creature* target, bool checkDefense, bool checkArmor,
 	                    bool field, bool ignoreResistances = false);
@@ -436,9 +459,10 @@ public:
 	void setAccountStorageValue(const uint32_t accountId, const uint32_t key, const int32_t value);
 	int32_t getAccountStorageValue(const uint32_t accountId, const uint32_t key) const;
 	void loadAccountStorageValues();
-	bool saveAccountStorageValues() const;
+	bool saveAccountStorageValues();
 
 	void startDecay(Item* item);
+	void queueDecay(Item* item);
 
 	void loadMotdNum();
 	void saveMotdNum() const;
@@ -452,6 +476,11 @@ public:
 	void addPlayer(Player* player);
 	void removePlayer(Player* player);
 
+	// watchers are the online players that have guid in their VIP list
+	void addVIPWatcher(uint32_t guid, Player* watcher);
+	void removeVIPWatcher(uint32_t guid, Player* watcher);
+	void notifyVIPWatchers(Player* player, VipStatus_t status);
+
 	void addNpc(Npc* npc);
 	void removeNpc(Npc* npc);
 
@@ -473,28 +502,30 @@ public:
 	void removeUniqueItem(uint16_t uniqueId);
 
 	bool reload(ReloadTypes_t reloadType);
+	// items and monsters are read on a worker and swapped in by one dispatcher task, any other type reloads in a
+	// task of its own; callback gets the result on the dispatcher, false if a background reload still runs
+	bool reloadInBackground(ReloadTypes_t reloadType, std::function<void(bool)> callback);
 
 	Groups groups;
 	Map map;
 	Raids raids;
 	Mounts mounts;
 
-	std::forward_list<Item*> toDecayItems;
-
-	std::unordered_set<Tile*> getTilesToClean() const { return tilesToClean; }
+	const std::unordered_set<Tile*>& getTilesToClean() const { return tilesToClean; }
+	bool isTileToClean(Tile* tile) const { return tilesToClean.contains(tile); }
 	void addTileToClean(Tile* tile) { tilesToClean.emplace(tile); }
 	void removeTileToClean(Tile* tile) { tilesToClean.erase(tile); }
 	void clearTilesToClean() { tilesToClean.clear(); }
 
 	void loadGameStorageValues();
-	bool saveGameStorageValues() const;
+	bool saveGameStorageValues();
 
 	void setStorageValue(uint32_t key, std::optional<int64_t> value);
 	std::optional<int64_t> getStorageValue(uint32_t key) const;
-	decltype(auto) getStorageMap() const { return storageMap; }
+	const StorageMap<uint32_t, int64_t>& getStorageMap() const { return storageMap; }
 
 private:
-	std::map<uint32_t, int64_t> storageMap;
+	StorageMap<uint32_t, int64_t> storageMap;
 
 	bool playerSaySpell(Player* player, SpeakClasses type, std::string_view text);
 	void playerWhisper(Player* player, std::string_view text);
@@ -503,23 +534,61 @@ private:
 	void playerSpeakToNpc(Player* player, std::string_view text);
 
 	void checkDecay();
+	void checkRollingSave();
+	void logDispatcherStats();
+	void flushEffects();
+	void flushHealthUpdates();
+	void flushLightUpdates();
+	void flushMoveNotifications();
 	void internalDecayItem(Item* item);
 
 	std::unordered_map<uint32_t, Player*> players;
-	std::unordered_map<std::string, Player*> mappedPlayerNames;
+	std::unordered_map<std::string, Player*, CaseInsensitiveHash, CaseInsensitiveEqual> mappedPlayerNames;
 	std::unordered_map<uint32_t, Player*> mappedPlayerGuids;
+	std::unordered_map<uint32_t, std::vector<Player*>> vipWatchers;
 	std::unordered_map<uint32_t, Guild*> guilds;
 	std::unordered_map<uint16_t, Item*> uniqueItems;
 	std::map<uint32_t, uint32_t> stages;
-	std::unordered_map<uint32_t, std::unordered_map<uint32_t, int32_t>> accountStorageMap;
+	// keyed by the account id in the high and the storage key in the low half
+	StorageMap<uint64_t, int32_t> accountStorageMap;
 
-	std::list<Item*> decayItems[EVENT_DECAY_BUCKETS];
-	std::list<Creature*> checkCreatureLists[EVENT_CREATURECOUNT];
+	struct DecayEntry
+	{
+		int64_t deadline;
+		Item* item;
+
+		bool operator>(const DecayEntry& other) const { return deadline > other.deadline; }
+	};
+	// keyed by absolute expiry, an item is only looked at again once its deadline has passed
+	std::priority_queue<DecayEntry, std::vector<DecayEntry>, std::greater<>> decayQueue;
+	// contiguous and split by kind of creature, so each pass runs a single think path
+	struct CreatureCheckList
+	{
+		std::vector<Creature*> players;
+		std::vector<Creature*> monsters;
+		std::vector<Creature*> npcs;
+	};
+	CreatureCheckList checkCreatureLists[EVENT_CREATURECOUNT];
+	uint32_t followReplans = 0;
 
 	std::vector<Creature*> ToReleaseCreatures;
-	std::vector<Item*> ToReleaseItems;
 
-	size_t lastBucket = 0;
+	struct PendingEffect
+	{
+		Position fromPos;
+		Position toPos;
+		uint8_t effect;
+		bool distance;
+	};
+	// flushed by a dispatcher task posted when the first one is queued
+	std::vector<PendingEffect> pendingEffects;
+	// ids of the creatures whose health bar is sent by the next flush
+	std::vector<uint32_t> pendingHealthUpdates;
+	// same for creature light, a creature changing light several times in a tick is sent once
+	std::vector<uint32_t> pendingLightUpdates;
+	// ids of the monsters and npcs with creature moves queued for the next flush
+	std::vector<uint32_t> pendingMoveNotifications;
+	std::vector<Item*> ToReleaseItems;
 
 	WildcardTreeNode wildcardTree{false};
 
@@ -530,6 +599,8 @@ private:
 	std::map<Item*, uint32_t> tradeItems;
 
 	std::map<uint32_t, BedItem*> bedSleepersMap;
+	// unique items and sleepers are registered by items created while the map loads on several threads
+	std::mutex mapItemsLock;
 
 	std::unordered_set<Tile*> tilesToClean;
 
@@ -544,6 +615,11 @@ private:
 	std::string motdHash;
 	uint32_t motdNum = 0;
 
+	// the house the next step of the rolling save starts after
+	uint32_t rollingSaveHouseId = 0;
+
+	bool backgroundReloadRunning = false;
+
 	uint32_t lastStageLevel = 0;
 	bool stagesEnabled = false;
 	bool useLastStageLevel = false;
@@ -6,6 +6,8 @@
 #include "globalevent.h"
 
 #include "configmanager.h"
+#include "governor.h"
+#include "luaprofiler.h"
 #include "pugicast.h"
 #include "scheduler.h"
 #include "tools.h"
@@ -14,12 +16,16 @@ extern ConfigManager g_config;
 
 GlobalEvents::GlobalEvents() : scriptInterface("GlobalEvent Interface") { scriptInterface.initState(); }
 
-GlobalEvents::~GlobalEvents() { clear(false); }
+GlobalEvents::~GlobalEvents()
+{
+	g_scheduler.stopEvent(thinkEventId);
+	g_scheduler.stopEvent(timerEventId);
+}
 
-void GlobalEvents::clearMap(GlobalEventMap& map, bool fromLua)
+void GlobalEvents::clearMap(GlobalEventMap& map, const EventFilter& filter)
 {
 	for (auto it = map.begin(); it != map.end();) {
-		if (fromLua == it->second.fromLua) {
+		if (filter(it->second)) {
 			it = map.erase(it);
 		} else {
 			++it;
@@ -27,18 +33,42 @@ void GlobalEvents::clearMap(GlobalEventMap& map, bool fromLua)
 	}
 }
 
-void GlobalEvents::clear(bool fromLua)
+void GlobalEvents::removeEvents(const EventFilter& filter)
 {
 	g_scheduler.stopEvent(thinkEventId);
 	thinkEventId = 0;
 	g_scheduler.stopEvent(timerEventId);
 	timerEventId = 0;
 
-	clearMap(thinkMap, fromLua);
-	clearMap(serverMap, fromLua);
-	clearMap(timerMap, fromLua);
+	clearMap(thinkMap, filter);
+	clearMap(serverMap, filter);
+	clearMap(timerMap, filter);
+
+	++generation;
+	rebuildQueues();
+}
+
+void GlobalEvents::rebuildQueues()
+{
+	thinkQueue = {};
+	for (auto& it : thinkMap) {
+		thinkQueue.emplace(it.second.getNextExecution(), &it.second);
+	}
+
+	timerQueue = {};
+	for (auto& it : timerMap) {
+		timerQueue.emplace(it.second.getNextExecution(), &it.second);
+	}
 
-	reInitState(fromLua);
+	// the events of the other kind of script are kept and have to go on
+	if (!thinkQueue.empty() && thinkEventId == 0) {
+		thinkEventId = g_scheduler.addEvent(
+		    createSchedulerTask(SCHEDULER_MINTICKS, [this]() { think(); }, SCHEDULER_EVENT_GLOBALEVENT));
+	}
+	if (!timerQueue.empty() && timerEventId == 0) {
+		timerEventId = g_scheduler.addEvent(
+		    createSchedulerTask(SCHEDULER_MINTICKS, [this]() { timer(); }, SCHEDULER_EVENT_GLOBALEVENT));
+	}
 }
 
 Event_ptr GlobalEvents::getEvent(std::string_view nodeName)
@@ -51,33 +81,8 @@ Event_ptr GlobalEvents::getEvent(std::string_view nodeName)
 
 bool GlobalEvents::registerEvent(Event_ptr event, const pugi::xml_node&)
 {
-	GlobalEvent_ptr globalEvent{static_cast<GlobalEvent*>(event.release())}; // event is guaranteed to be a GlobalEvent
-	if (globalEvent->getEventType() == GLOBALEVENT_TIMER) {
-		auto result = timerMap.emplace(globalEvent->getName(), std::move(*globalEvent));
-		if (result.second) {
-			if (timerEventId == 0) {
-				timerEventId = g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, [this]() { timer(); }));
-			}
-			return true;
-		}
-	} else if (globalEvent->getEventType() != GLOBALEVENT_NONE) {
-		auto result = serverMap.emplace(globalEvent->getName(), std::move(*globalEvent));
-		if (result.second) {
-			return true;
-		}
-	} else { // think event
-		auto result = thinkMap.emplace(globalEvent->getName(), std::move(*globalEvent));
-		if (result.second) {
-			if (thinkEventId == 0) {
-				thinkEventId = g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, [this]() { think(); }));
-			}
-			return true;
-		}
-	}
-
-	std::cout << "[Warning - GlobalEvents::configureEvent] Duplicate registered globalevent with name: "
-	          << globalEvent->getName() << std::endl;
-	return false;
+	// event is guaranteed to be a GlobalEvent
+	return registerLuaEvent(static_cast<GlobalEvent*>(event.release()));
 }
 
 bool GlobalEvents::registerLuaEvent(GlobalEvent* event)
@@ -86,8 +91,10 @@ bool GlobalEvents::registerLuaEvent(GlobalEvent* event)
 	if (globalEvent->getEventType() == GLOBALEVENT_TIMER) {
 		auto result = timerMap.emplace(globalEvent->getName(), std::move(*globalEvent));
 		if (result.second) {
+			GlobalEvent& timerEvent = result.first->second;
+			timerQueue.emplace(timerEvent.getNextExecution(), &timerEvent);
 			if (timerEventId == 0) {
-				timerEventId = g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, [this]() { timer(); }));
+				timerEventId = g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, [this]() { timer(); }, SCHEDULER_EVENT_GLOBALEVENT));
 			}
 			return true;
 		}
@@ -99,8 +106,11 @@ bool GlobalEvents::registerLuaEvent(GlobalEvent* event)
 	} else { // think event
 		auto result = thinkMap.emplace(globalEvent->getName(), std::move(*globalEvent));
 		if (result.second) {
+			GlobalEvent& thinkEvent = result.first->second;
+			thinkQueue.emplace(thinkEvent.getNextExecution(), &thinkEvent);
 			if (thinkEventId == 0) {
-				thinkEventId = g_scheduler.addEvent(createSchedulerTask(SCHEDULER_MINTICKS, [this]() { think(); }));
+				thinkEventId = g_scheduler.addEvent(
+				    createSchedulerTask(SCHEDULER_MINTICKS, [this]() { think(); }, SCHEDULER_EVENT_GLOBALEVENT));
 			}
 			return true;
 		}
@@ -115,76 +125,68 @@ void GlobalEvents::startup() const { execute(GLOBALEVENT_STARTUP); }
 
 void GlobalEvents::timer()
 {
-	auto now = OTSYS_TIME();
-
-	int64_t nextScheduledTime = std::numeric_limits<int64_t>::max();
-
-	auto it = timerMap.begin();
-	while (it != timerMap.end()) {
-		GlobalEvent& globalEvent = it->second;
-
-		int64_t nextExecutionTime = globalEvent.getNextExecution() - now;
-		if (nextExecutionTime > 0) {
-			if (nextExecutionTime < nextScheduledTime) {
-				nextScheduledTime = nextExecutionTime;
-			}
-
-			++it;
-			continue;
+	const int64_t now = OTSYS_TIME();
+	const uint32_t currentGeneration = generation;
+	while (!timerQueue.empty() && timerQueue.top().nextExecution <= now) {
+		GlobalEvent* globalEvent = timerQueue.top().event;
+		timerQueue.pop();
+
+		const bool executed = globalEvent->executeEvent();
+		if (generation != currentGeneration) {
+			return;
 		}
 
-		if (!globalEvent.executeEvent()) {
-			it = timerMap.erase(it);
+		if (!executed) {
+			timerMap.erase(std::string{globalEvent->getName()});
 			continue;
 		}
 
-		nextExecutionTime = 86400000;
-		if (nextExecutionTime < nextScheduledTime) {
-			nextScheduledTime = nextExecutionTime;
-		}
-
-		globalEvent.setNextExecution(globalEvent.getNextExecution() + nextExecutionTime);
-
-		++it;
+		globalEvent->setNextExecution(globalEvent->getNextExecution() + 86400000);
+		timerQueue.emplace(globalEvent->getNextExecution(), globalEvent);
 	}
 
-	if (nextScheduledTime != std::numeric_limits<int64_t>::max()) {
-		thinkEventId = g_scheduler.addEvent(createSchedulerTask(nextScheduledTime, [this]() { timer(); }));
+	// the id stays set while the events run, so an event registered by one of them does not start a second wake-up
+	timerEventId = 0;
+	if (!timerQueue.empty()) {
+		timerEventId = g_scheduler.addEvent(createSchedulerTask(
+		    timerQueue.top().nextExecution - now, [this]() { timer(); }, SCHEDULER_EVENT_GLOBALEVENT));
 	}
 }
 
 void GlobalEvents::think()
 {
-	auto now = OTSYS_TIME();
-
-	int64_t nextScheduledTime = std::numeric_limits<int64_t>::max();
-	for (auto& it : thinkMap) {
-		GlobalEvent& globalEvent = it.second;
-
-		int64_t nextExecutionTime = globalEvent.getNextExecution() - now;
-		if (nextExecutionTime > 0) {
-			if (nextExecutionTime < nextScheduledTime) {
-				nextScheduledTime = nextExecutionTime;
-			}
-			continue;
-		}
-
-		if (!globalEvent.executeEvent()) {
-			std::cout << "[Error - GlobalEvents::think] Failed to execute event: " << globalEvent.getName()
+	const int64_t now = OTSYS_TIME();
+	const uint32_t currentGeneration = generation;
+	const int64_t intervalFactor = g_overloadGovernor.isEngaged(OVERLOAD_THROTTLE_GLOBALEVENTS) ? 2 : 1;
+
+	// an event that is late by more than its interval runs once and on the next wake-up again
+	std::vector<GlobalEvent*> executed;
+	while (!thinkQueue.empty() && thinkQueue.top().nextExecution <= now) {
+		GlobalEvent* globalEvent = thinkQueue.top().event;
+		thinkQueue.pop();
+
+		if (!globalEvent->executeEvent()) {
+			std::cout << "[Error - GlobalEvents::think] Failed to execute event: " << globalEvent->getName()
 			          << std::endl;
 		}
 
-		nextExecutionTime = globalEvent.getInterval();
-		if (nextExecutionTime < nextScheduledTime) {
-			nextScheduledTime = nextExecutionTime;
+		if (generation != currentGeneration) {
+			return;
 		}
 
-		globalEvent.setNextExecution(globalEvent.getNextExecution() + nextExecutionTime);
+		globalEvent->setNextExecution(globalEvent->getNextExecution() + globalEvent->getInterval() * intervalFactor);
+		executed.push_back(globalEvent);
 	}
 
-	if (nextScheduledTime != std::numeric_limits<int64_t>::max()) {
-		timerEventId = g_scheduler.addEvent(
-		    createSchedulerTask(std::max<int64_t>(1000, nextScheduledTime), [this]() { think(); }));
+	for (GlobalEvent* globalEvent : executed) {
+		thinkQueue.emplace(globalEvent->getNextExecution(), globalEvent);
+	}
+
+	thinkEventId = 0;
+	if (!thinkQueue.empty()) {
+		thinkEventId = g_scheduler.addEvent(
+		    createSchedulerTask(std::max<int64_t>(1000, thinkQueue.top().nextExecution - now), [this]() { think(); },
+		                        SCHEDULER_EVENT_GLOBALEVENT));
 	}
 }
 
@@ -347,6 +349,12 @@ bool GlobalEvent::executeEvent() const
 		return false;
 	}
 
+	// the script interface frame only names the file, and a revscript may register several events
+	std::optional<LuaProfiler::Scope> profilerScope;
+	if (g_luaProfiler.isEnabled()) {
+		profilerScope.emplace(g_luaProfiler, "GlobalEvent", name);
+	}
+
 	ScriptEnvironment* env = scriptInterface->getScriptEnv();
 	env->setScriptId(scriptId, scriptInterface);
 	lua_State* L = scriptInterface->getLuaState();
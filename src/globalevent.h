@@ -37,22 +37,37 @@ public:
 	void execute(GlobalEvent_t type) const;
 
 	GlobalEventMap getEventMap(GlobalEvent_t type);
-	static void clearMap(GlobalEventMap& map, bool fromLua);
+	static void clearMap(GlobalEventMap& map, const EventFilter& filter);
 
 	bool registerLuaEvent(GlobalEvent* event);
-	void clear(bool fromLua) override final;
 
 private:
 	std::string_view getScriptBaseName() const override { return "globalevents"; }
 
 	Event_ptr getEvent(std::string_view nodeName) override;
 	bool registerEvent(Event_ptr event, const pugi::xml_node& node) override;
+	void removeEvents(const EventFilter& filter) override final;
 
 	LuaScriptInterface& getScriptInterface() override { return scriptInterface; }
 	LuaScriptInterface scriptInterface;
 
+	struct ScheduledEvent
+	{
+		int64_t nextExecution;
+		GlobalEvent* event;
+
+		bool operator>(const ScheduledEvent& other) const { return nextExecution > other.nextExecution; }
+	};
+	using EventQueue = std::priority_queue<ScheduledEvent, std::vector<ScheduledEvent>, std::greater<>>;
+
+	void rebuildQueues();
+
 	GlobalEventMap thinkMap, serverMap, timerMap;
+	// the think and timer events by their next execution, so a wake-up only looks at the ones that are due
+	EventQueue thinkQueue, timerQueue;
 	int32_t thinkEventId = 0, timerEventId = 0;
+	// bumped by clear, an event that reloads the scripts ends the wake-up that ran it
+	uint32_t generation = 0;
 };
 
 class GlobalEvent final : public Event
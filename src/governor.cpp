@@ -0,0 +1,81 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "governor.h"
+
+#include "configmanager.h"
+#include "creature.h"
+
+#include <fmt/format.h>
+
+extern ConfigManager g_config;
+
+OverloadGovernor g_overloadGovernor;
+
+namespace {
+
+// the last 16 checks, 400 ms, weigh the most
+constexpr double LAG_SMOOTHING = 1.0 / 16;
+
+int64_t getThreshold(OverloadMeasure measure)
+{
+	switch (measure) {
+		case OVERLOAD_COALESCE_EFFECTS:
+			return g_config[ConfigKeysInteger::OVERLOAD_EFFECTS_LAG];
+		case OVERLOAD_SLOW_MONSTER_THINK:
+			return g_config[ConfigKeysInteger::OVERLOAD_MONSTER_THINK_LAG];
+		case OVERLOAD_DEFER_SAVES:
+			return g_config[ConfigKeysInteger::OVERLOAD_SAVES_LAG];
+		case OVERLOAD_THROTTLE_GLOBALEVENTS:
+			return g_config[ConfigKeysInteger::OVERLOAD_GLOBALEVENTS_LAG];
+		default:
+			return 0;
+	}
+}
+
+} // namespace
+
+const char* getOverloadMeasureName(OverloadMeasure measure)
+{
+	switch (measure) {
+		case OVERLOAD_COALESCE_EFFECTS:
+			return "effect coalescing";
+		case OVERLOAD_SLOW_MONSTER_THINK:
+			return "slow monster thinking";
+		case OVERLOAD_DEFER_SAVES:
+			return "deferred saves";
+		case OVERLOAD_THROTTLE_GLOBALEVENTS:
+			return "global event throttling";
+		default:
+			return "unknown";
+	}
+}
+
+void OverloadGovernor::update(int64_t now)
+{
+	if (lastCheck != 0) {
+		const int64_t lag = std::max<int64_t>(0, now - lastCheck - EVENT_CHECK_CREATURE_INTERVAL);
+		averageLag += (lag - averageLag) * LAG_SMOOTHING;
+	}
+	lastCheck = now;
+
+	for (uint8_t i = 0; i < OVERLOAD_MEASURE_COUNT; ++i) {
+		const OverloadMeasure measure = static_cast<OverloadMeasure>(i);
+		const int64_t threshold = getThreshold(measure);
+		if (!engaged.test(i)) {
+			if (threshold > 0 && averageLag >= threshold) {
+				engaged.set(i);
+				std::cout << fmt::format("> Overload: dispatcher lags {:d} ms behind, {:s} engaged.", getLag(),
+				                         getOverloadMeasureName(measure))
+				          << std::endl;
+			}
+		} else if (threshold <= 0 || averageLag < threshold / 2.0) {
+			engaged.reset(i);
+			std::cout << fmt::format("> Overload: dispatcher lags {:d} ms behind, {:s} released.", getLag(),
+			                         getOverloadMeasureName(measure))
+			          << std::endl;
+		}
+	}
+}
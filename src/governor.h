@@ -0,0 +1,40 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_GOVERNOR_H
+#define FS_GOVERNOR_H
+
+// cheaper modes engaged one after another the further the dispatcher falls behind
+enum OverloadMeasure : uint8_t
+{
+	OVERLOAD_COALESCE_EFFECTS,      // identical effects on a tile are sent once
+	OVERLOAD_SLOW_MONSTER_THINK,    // monsters without a target think every other round
+	OVERLOAD_DEFER_SAVES,           // player:save() queues the save instead of waiting for it
+	OVERLOAD_THROTTLE_GLOBALEVENTS, // global events run at twice their interval
+
+	OVERLOAD_MEASURE_COUNT
+};
+
+const char* getOverloadMeasureName(OverloadMeasure measure);
+
+// Measures how late the creature checks start and engages a measure once the average lag reaches its configured
+// threshold, it is released when the lag falls below half of it. Dispatcher thread only.
+class OverloadGovernor
+{
+public:
+	// called by every creature check with the time it started at
+	void update(int64_t now);
+
+	bool isEngaged(OverloadMeasure measure) const { return engaged.test(measure); }
+	// milliseconds
+	int64_t getLag() const { return static_cast<int64_t>(averageLag); }
+
+private:
+	int64_t lastCheck = 0;
+	double averageLag = 0;
+	std::bitset<OVERLOAD_MEASURE_COUNT> engaged;
+};
+
+extern OverloadGovernor g_overloadGovernor;
+
+#endif // FS_GOVERNOR_H
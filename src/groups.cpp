@@ -84,15 +84,19 @@ bool Groups::load()
 
 		groups.push_back(group);
 	}
-	return true;
-}
 
-Group* Groups::getGroup(uint16_t id)
-{
+	groupsById.clear();
 	for (Group& group : groups) {
-		if (group.id == id) {
-			return &group;
+		if (group.id >= groupsById.size()) {
+			groupsById.resize(group.id + 1);
+		}
+
+		// the first group with an id wins, as with the scan before
+		if (!groupsById[group.id]) {
+			groupsById[group.id] = &group;
 		}
 	}
-	return nullptr;
+	return true;
 }
+
+Group* Groups::getGroup(uint16_t id) { return id < groupsById.size() ? groupsById[id] : nullptr; }
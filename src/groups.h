@@ -22,6 +22,8 @@ public:
 
 private:
 	std::vector<Group> groups;
+	// indexed by group id
+	std::vector<Group*> groupsById;
 };
 
 #endif
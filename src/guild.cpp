@@ -56,22 +56,87 @@ void Guild::addRank(uint32_t rankId, std::string_view rankName, uint8_t level)
 	ranks.emplace_back(std::make_shared<GuildRank>(rankId, rankName, level));
 }
 
+void Guild::setWars(std::vector<uint32_t> guildIds)
+{
+	std::sort(guildIds.begin(), guildIds.end());
+	guildIds.erase(std::unique(guildIds.begin(), guildIds.end()), guildIds.end());
+
+	for (uint32_t guildId : wars) {
+		if (!std::binary_search(guildIds.begin(), guildIds.end(), guildId)) {
+			if (Guild* enemy = g_game.getGuild(guildId)) {
+				enemy->updateWar(id, false);
+			}
+		}
+	}
+
+	for (uint32_t guildId : guildIds) {
+		if (Guild* enemy = g_game.getGuild(guildId)) {
+			enemy->updateWar(id, true);
+		}
+	}
+	wars = std::move(guildIds);
+}
+
+void Guild::setWar(uint32_t guildId, bool active)
+{
+	updateWar(guildId, active);
+	if (Guild* enemy = g_game.getGuild(guildId)) {
+		enemy->updateWar(id, active);
+	}
+}
+
+void Guild::updateWar(uint32_t guildId, bool active)
+{
+	auto it = std::lower_bound(wars.begin(), wars.end(), guildId);
+	if (it != wars.end() && *it == guildId) {
+		if (!active) {
+			wars.erase(it);
+		}
+	} else if (active) {
+		wars.insert(it, guildId);
+	}
+}
+
+GuildEmblems_t Guild::getEmblem(const Guild* viewer, const Guild* target)
+{
+	if (!target || target->wars.empty()) {
+		return GUILDEMBLEM_NONE;
+	}
+
+	if (viewer == target) {
+		return GUILDEMBLEM_ALLY;
+	} else if (viewer && viewer->isAtWarWith(target->id) && target->isAtWarWith(viewer->id)) {
+		return GUILDEMBLEM_ENEMY;
+	}
+	return GUILDEMBLEM_NEUTRAL;
+}
+
 Guild* IOGuild::loadGuild(uint32_t guildId)
 {
 	Database& db = Database::getInstance();
-	if (DBResult_ptr result = db.storeQuery(fmt::format("SELECT `name` FROM `guilds` WHERE `id` = {:d}", guildId))) {
-		Guild* guild = new Guild(guildId, result->getString("name"));
-
-		if ((result = db.storeQuery(
-		         fmt::format("SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `guild_id` = {:d}", guildId)))) {
-			do {
-				guild->addRank(result->getNumber<uint32_t>("id"), result->getString("name"),
-				               result->getNumber<uint16_t>("level"));
-			} while (result->next());
-		}
-		return guild;
+	DBResult_ptr result = db.storeQuery(fmt::format("SELECT `name` FROM `guilds` WHERE `id` = {:d}", guildId));
+	if (!result) {
+		return nullptr;
 	}
-	return nullptr;
+	return loadGuild(guildId, std::move(result),
+	                 db.storeQuery(fmt::format(
+	                     "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `guild_id` = {:d}", guildId)));
+}
+
+Guild* IOGuild::loadGuild(uint32_t guildId, DBResult_ptr result, DBResult_ptr ranks)
+{
+	if (!result) {
+		return nullptr;
+	}
+
+	Guild* guild = new Guild(guildId, result->getString("name"));
+	if (ranks) {
+		do {
+			guild->addRank(ranks->getNumber<uint32_t>("id"), ranks->getString("name"),
+			               ranks->getNumber<uint16_t>("level"));
+		} while (ranks->next());
+	}
+	return guild;
 }
 
 uint32_t IOGuild::getGuildIdByName(std::string_view name)
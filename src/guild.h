@@ -4,8 +4,13 @@
 #ifndef FS_GUILD_H
 #define FS_GUILD_H
 
+#include "const.h"
+
+class DBResult;
 class Player;
 
+using DBResult_ptr = std::shared_ptr<DBResult>;
+
 struct GuildRank
 {
 	uint32_t id;
@@ -40,19 +45,31 @@ public:
 	const std::string& getMotd() const { return motd; }
 	void setMotd(std::string_view motd) { this->motd = motd; }
 
+	// the guilds this one is at war with, kept sorted and mirrored into the loaded enemy guilds
+	const std::vector<uint32_t>& getWars() const { return wars; }
+	bool isAtWarWith(uint32_t guildId) const { return std::binary_search(wars.begin(), wars.end(), guildId); }
+	void setWars(std::vector<uint32_t> guildIds);
+	void setWar(uint32_t guildId, bool active);
+
+	// the emblem a member of viewer sees on a member of target
+	static GuildEmblems_t getEmblem(const Guild* viewer, const Guild* target);
+
 private:
+	void updateWar(uint32_t guildId, bool active);
+
 	std::list<Player*> membersOnline;
 	std::vector<GuildRank_ptr> ranks;
+	std::vector<uint32_t> wars;
 	std::string name;
 	std::string motd;
 	uint32_t id;
 	uint32_t memberCount = 0;
 };
 
-using GuildWarVector = std::vector<uint32_t>;
-
 namespace IOGuild {
 Guild* loadGuild(uint32_t guildId);
+// builds the guild from its row and its rank rows, nullptr without a row
+Guild* loadGuild(uint32_t guildId, DBResult_ptr result, DBResult_ptr ranks);
 uint32_t getGuildIdByName(std::string_view name);
 } // namespace IOGuild
 
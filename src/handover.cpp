@@ -0,0 +1,157 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "handover.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// more than a server ever listens on, the control message buffer is sized for it
+constexpr size_t MAX_SOCKETS = 16;
+
+int heldPeer = -1;
+Handover::Sockets heldSockets;
+
+} // namespace
+
+Handover::Sockets Handover::request(const std::string& path)
+{
+	sockaddr_un address{};
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path)) {
+		std::cout << "[Error - Handover::request] The handover socket path is too long." << std::endl;
+		return {};
+	}
+	std::copy(path.begin(), path.end(), address.sun_path);
+
+	int peer = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (peer == -1) {
+		return {};
+	}
+
+	if (connect(peer, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+		std::cout << "[Warning - Handover::request] No server is listening on " << path << '.' << std::endl;
+		close(peer);
+		return {};
+	}
+
+	// the ports are the payload, the descriptors come in the control message
+	std::array<uint16_t, MAX_SOCKETS> ports;
+	iovec payload{ports.data(), sizeof(ports)};
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_SOCKETS)];
+
+	msghdr message{};
+	message.msg_iov = &payload;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	ssize_t received;
+	do {
+		received = recvmsg(peer, &message, 0);
+	} while (received == -1 && errno == EINTR);
+	close(peer);
+
+	if (received <= 0) {
+		std::cout << "[Warning - Handover::request] The running server did not hand its sockets over." << std::endl;
+		return {};
+	}
+
+	Sockets sockets;
+	const size_t portCount = static_cast<size_t>(received) / sizeof(uint16_t);
+	for (cmsghdr* header = CMSG_FIRSTHDR(&message); header; header = CMSG_NXTHDR(&message, header)) {
+		if (header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+
+		const int* descriptors = reinterpret_cast<const int*>(CMSG_DATA(header));
+		const size_t count = (header->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (size_t i = 0; i < count; ++i) {
+			if (sockets.size() < portCount) {
+				sockets.emplace_back(ports[sockets.size()], descriptors[i]);
+			} else {
+				close(descriptors[i]);
+			}
+		}
+	}
+	return sockets;
+}
+
+void Handover::hold(int peer, const Sockets& sockets)
+{
+	if (heldPeer != -1) {
+		return;
+	}
+
+	heldPeer = dup(peer);
+	for (const auto& [port, socket] : sockets) {
+		if (heldSockets.size() == MAX_SOCKETS) {
+			break;
+		}
+
+		int copy = dup(socket);
+		if (copy != -1) {
+			heldSockets.emplace_back(port, copy);
+		}
+	}
+}
+
+void Handover::complete()
+{
+	if (heldPeer == -1) {
+		return;
+	}
+
+	std::array<uint16_t, MAX_SOCKETS> ports;
+	alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_SOCKETS)] = {};
+	iovec payload{ports.data(), sizeof(uint16_t) * heldSockets.size()};
+
+	msghdr message{};
+	message.msg_iov = &payload;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = CMSG_SPACE(sizeof(int) * heldSockets.size());
+
+	cmsghdr* header = CMSG_FIRSTHDR(&message);
+	header->cmsg_level = SOL_SOCKET;
+	header->cmsg_type = SCM_RIGHTS;
+	header->cmsg_len = CMSG_LEN(sizeof(int) * heldSockets.size());
+	int* descriptors = reinterpret_cast<int*>(CMSG_DATA(header));
+	for (size_t i = 0; i < heldSockets.size(); ++i) {
+		ports[i] = heldSockets[i].first;
+		descriptors[i] = heldSockets[i].second;
+	}
+
+	// an empty payload would read as the server going away
+	if (heldSockets.empty() || sendmsg(heldPeer, &message, MSG_NOSIGNAL) == -1) {
+		std::cout << "[Error - Handover::complete] Failed to hand the sockets over." << std::endl;
+	} else {
+		std::cout << ">> Handed " << heldSockets.size() << " listening sockets over." << std::endl;
+	}
+
+	release(heldSockets);
+	heldSockets.clear();
+	close(std::exchange(heldPeer, -1));
+}
+
+void Handover::release(const Sockets& sockets)
+{
+	for (const auto& [port, socket] : sockets) {
+		close(socket);
+	}
+}
+#else
+Handover::Sockets Handover::request(const std::string&) { return {}; }
+
+void Handover::hold(int, const Sockets&) {}
+
+void Handover::complete() {}
+
+void Handover::release(const Sockets&) {}
+#endif
@@ -0,0 +1,30 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_HANDOVER_H
+#define FS_HANDOVER_H
+
+/*
+ * Passes the listening sockets of a running server to the server replacing it. The replacement loads the world
+ * first and then asks over a unix socket, the running server saves, shuts down and sends its sockets last, so a
+ * client connecting in between waits in the listen backlog instead of being refused. Not supported on Windows.
+ */
+namespace Handover {
+
+// listening socket descriptors and the port each was opened for
+using Sockets = std::vector<std::pair<uint16_t, int>>;
+
+// blocks until the server listening on path saved and sent its sockets, empty if there is none or it went away
+Sockets request(const std::string& path);
+
+// keeps copies of the replacement and the sockets, so they outlive the shutdown that closes the originals
+void hold(int peer, const Sockets& sockets);
+
+// sends the sockets to the replacement that hold kept, once the last save was written
+void complete();
+
+void release(const Sockets& sockets);
+
+} // namespace Handover
+
+#endif // FS_HANDOVER_H
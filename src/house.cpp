@@ -37,6 +37,7 @@ void House::setOwner(uint32_t guid, bool updateDatabase /* = true*/, Player* pla
 
 	isLoaded = true;
 
+	const uint32_t oldOwner = owner;
 	if (owner != 0) {
 		// send items to depot
 		if (player) {
@@ -98,6 +99,10 @@ void House::setOwner(uint32_t guid, bool updateDatabase /* = true*/, Player* pla
 			ownerAccountId = IOLoginData::getAccountIdByPlayerName(name);
 		}
 	}
+
+	if (owner != oldOwner) {
+		g_game.map.houses.updateOwner(this, oldOwner);
+	}
 }
 
 AccessHouseLevel_t House::getHouseAccessLevel(const Player* player) const
@@ -191,16 +196,13 @@ bool House::transferToDepot() const
 
 	Player* player = g_game.getPlayerByGUID(owner);
 	if (player) {
-		transferToDepot(player);
-	} else {
-		Player tmpPlayer(nullptr);
-		if (!IOLoginData::loadPlayerById(&tmpPlayer, owner)) {
-			return false;
-		}
-
-		transferToDepot(&tmpPlayer);
-		IOLoginData::savePlayer(&tmpPlayer);
+		return transferToDepot(player->getDepotLocker(townId));
 	}
+
+	// the items of an offline owner are only added to the depot rows
+	auto depotLocker = std::make_shared<DepotLocker>(ITEM_LOCKER);
+	transferToDepot(depotLocker.get());
+	IOLoginData::addDepotItems(owner, townId, *depotLocker);
 	return true;
 }
 
@@ -209,7 +211,11 @@ bool House::transferToDepot(Player* player) const
 	if (townId == 0 || owner == 0) {
 		return false;
 	}
+	return transferToDepot(player->getDepotLocker(townId));
+}
 
+bool House::transferToDepot(DepotLocker* depot) const
+{
 	ItemList moveItemList;
 	for (HouseTile* tile : houseTiles) {
 		if (const TileItemVector* items = tile->getItemList()) {
@@ -228,7 +234,6 @@ bool House::transferToDepot(Player* player) const
 		}
 	}
 
-	DepotLocker* depot = player->getDepotLocker(townId);
 	for (Item* item : moveItemList) {
 		g_game.internalMoveItem(item->getParent(), depot, INDEX_WHEREEVER, item, item->getItemCount(), nullptr,
 		                        FLAG_NOLIMIT);
@@ -370,17 +375,98 @@ bool House::executeTransfer(HouseTransferItem* item, Player* newOwner)
 	return true;
 }
 
+namespace {
+
+const Guild* getGuildByName(std::string_view name)
+{
+	uint32_t guildId = IOGuild::getGuildIdByName(name);
+	if (guildId == 0) {
+		return nullptr;
+	}
+
+	const Guild* guild = g_game.getGuild(guildId);
+	if (guild) {
+		return guild;
+	}
+
+	return IOGuild::loadGuild(guildId);
+}
+
+std::vector<uint32_t> getPlayerGuids(std::string_view name)
+{
+	if (Player* player = g_game.getPlayerByName(name)) {
+		return {player->getGUID()};
+	}
+
+	if (uint32_t guid = IOLoginData::getGuidByName(name)) {
+		return {guid};
+	}
+	return {};
+}
+
+std::vector<uint32_t> getGuildRankIds(std::string_view name)
+{
+	std::vector<uint32_t> rankIds;
+	if (const Guild* guild = getGuildByName(name)) {
+		for (auto rank : guild->getRanks()) {
+			rankIds.push_back(rank->id);
+		}
+	}
+	return rankIds;
+}
+
+std::vector<uint32_t> getGuildRankIds(std::string_view name, std::string_view rankName)
+{
+	if (const Guild* guild = getGuildByName(name)) {
+		if (GuildRank_ptr rank = guild->getRankByName(rankName)) {
+			return {rank->id};
+		}
+	}
+	return {};
+}
+
+void insertSorted(std::vector<uint32_t>& ids, const std::vector<uint32_t>& newIds)
+{
+	for (uint32_t id : newIds) {
+		auto it = std::lower_bound(ids.begin(), ids.end(), id);
+		if (it == ids.end() || *it != id) {
+			ids.insert(it, id);
+		}
+	}
+}
+
+// the ids of the line from the last parse if it had the line, looked up otherwise
+template <typename Resolve>
+const std::vector<uint32_t>& resolveLine(std::map<std::string, std::vector<uint32_t>, std::less<>>& resolved,
+                                         std::map<std::string, std::vector<uint32_t>, std::less<>>& previous,
+                                         const std::string& line, Resolve&& resolve)
+{
+	if (auto it = resolved.find(line); it != resolved.end()) {
+		return it->second;
+	}
+
+	if (auto node = previous.extract(line)) {
+		return resolved.insert(std::move(node)).position->second;
+	}
+	return resolved.emplace(line, resolve()).first->second;
+}
+
+} // namespace
+
 void AccessList::parseList(std::string_view list)
 {
 	playerList.clear();
 	guildRankList.clear();
 	allowEveryone = false;
 	this->list = list;
+
+	auto previousPlayers = std::exchange(resolvedPlayers, {});
+	auto previousGuilds = std::exchange(resolvedGuilds, {});
 	if (list.empty()) {
 		return;
 	}
 
-	std::istringstream listStream(list.data());
+	std::istringstream listStream(this->list);
 	std::string line;
 
 	uint16_t lineNo = 1;
@@ -399,73 +485,32 @@ void AccessList::parseList(std::string_view list)
 
 		std::string::size_type at_pos = line.find("@");
 		if (at_pos != std::string::npos) {
-			if (at_pos == 0) {
-				addGuild(line.substr(1));
-			} else {
-				addGuildRank(line.substr(0, at_pos - 1), line.substr(at_pos + 1));
-			}
+			auto resolve = [&line, at_pos]() {
+				if (at_pos == 0) {
+					return getGuildRankIds(line.substr(1));
+				}
+				return getGuildRankIds(line.substr(0, at_pos - 1), line.substr(at_pos + 1));
+			};
+			insertSorted(guildRankList, resolveLine(resolvedGuilds, previousGuilds, line, resolve));
 		} else if (line == "*") {
 			allowEveryone = true;
 		} else if (line.find("!") != std::string::npos || line.find("*") != std::string::npos ||
 		           line.find("?") != std::string::npos) {
 			continue; // regexp no longer supported
 		} else {
-			addPlayer(line);
+			insertSorted(playerList,
+			             resolveLine(resolvedPlayers, previousPlayers, line, [&]() { return getPlayerGuids(line); }));
 		}
 	}
 }
 
-void AccessList::addPlayer(std::string_view name)
-{
-	Player* player = g_game.getPlayerByName(name);
-	if (player) {
-		playerList.insert(player->getGUID());
-	} else {
-		uint32_t guid = IOLoginData::getGuidByName(name);
-		if (guid != 0) {
-			playerList.insert(guid);
-		}
-	}
-}
+void AccessList::addPlayer(std::string_view name) { insertSorted(playerList, getPlayerGuids(name)); }
 
-namespace {
-
-const Guild* getGuildByName(std::string_view name)
-{
-	uint32_t guildId = IOGuild::getGuildIdByName(name);
-	if (guildId == 0) {
-		return nullptr;
-	}
-
-	const Guild* guild = g_game.getGuild(guildId);
-	if (guild) {
-		return guild;
-	}
-
-	return IOGuild::loadGuild(guildId);
-}
-
-} // namespace
-
-void AccessList::addGuild(std::string_view name)
-{
-	const Guild* guild = getGuildByName(name);
-	if (guild) {
-		for (auto rank : guild->getRanks()) {
-			guildRankList.insert(rank->id);
-		}
-	}
-}
+void AccessList::addGuild(std::string_view name) { insertSorted(guildRankList, getGuildRankIds(name)); }
 
 void AccessList::addGuildRank(std::string_view name, std::string_view rankName)
 {
-	const Guild* guild = getGuildByName(name);
-	if (guild) {
-		GuildRank_ptr rank = guild->getRankByName(rankName);
-		if (rank) {
-			guildRankList.insert(rank->id);
-		}
-	}
+	insertSorted(guildRankList, getGuildRankIds(name, rankName));
 }
 
 bool AccessList::isInList(const Player* player) const
@@ -474,13 +519,16 @@ bool AccessList::isInList(const Player* player) const
 		return true;
 	}
 
-	auto playerIt = playerList.find(player->getGUID());
-	if (playerIt != playerList.end()) {
+	if (std::binary_search(playerList.begin(), playerList.end(), player->getGUID())) {
 		return true;
 	}
 
-	GuildRank_ptr rank = player->getGuildRank();
-	return rank && guildRankList.find(rank->id) != guildRankList.end();
+	if (guildRankList.empty()) {
+		return false;
+	}
+
+	uint32_t rankId = player->getGuildRankId();
+	return rankId != 0 && std::binary_search(guildRankList.begin(), guildRankList.end(), rankId);
 }
 
 Door::Door(uint16_t type) : Item(type) {}
@@ -554,12 +602,32 @@ void Door::onRemoved()
 
 House* Houses::getHouseByPlayerId(uint32_t playerId)
 {
-	for (const auto& it : houseMap) {
-		if (it.second->getOwner() == playerId) {
-			return it.second;
+	auto it = housesByOwner.find(playerId);
+	return it != housesByOwner.end() ? it->second : nullptr;
+}
+
+void Houses::updateOwner(House* house, uint32_t oldOwner)
+{
+	if (oldOwner != 0) {
+		auto it = housesByOwner.find(oldOwner);
+		if (it != housesByOwner.end() && it->second == house) {
+			// the old owner might still own another house
+			housesByOwner.erase(it);
+			for (const auto& [_, otherHouse] : houseMap) {
+				if (otherHouse->getOwner() == oldOwner) {
+					housesByOwner.emplace(oldOwner, otherHouse);
+					break;
+				}
+			}
+		}
+	}
+
+	if (const uint32_t owner = house->getOwner(); owner != 0) {
+		auto [it, inserted] = housesByOwner.emplace(owner, house);
+		if (!inserted && it->second->getId() > house->getId()) {
+			it->second = house;
 		}
 	}
-	return nullptr;
 }
 
 bool Houses::loadHousesXML(const std::string& filename)
@@ -604,13 +672,53 @@ bool Houses::loadHousesXML(const std::string& filename)
 	return true;
 }
 
+namespace {
+
+time_t getRentPaidUntil(RentPeriod_t rentPeriod, time_t currentTime)
+{
+	switch (rentPeriod) {
+		case RENTPERIOD_DAILY:
+			return currentTime + 24 * 60 * 60;
+		case RENTPERIOD_WEEKLY:
+			return currentTime + 24 * 60 * 60 * 7;
+		case RENTPERIOD_MONTHLY:
+			return currentTime + 24 * 60 * 60 * 30;
+		case RENTPERIOD_YEARLY:
+			return currentTime + 24 * 60 * 60 * 365;
+		default:
+			return currentTime;
+	}
+}
+
+std::string_view getRentPeriodName(RentPeriod_t rentPeriod)
+{
+	switch (rentPeriod) {
+		case RENTPERIOD_DAILY:
+			return "daily";
+		case RENTPERIOD_WEEKLY:
+			return "weekly";
+		case RENTPERIOD_MONTHLY:
+			return "monthly";
+		case RENTPERIOD_YEARLY:
+			return "annual";
+		default:
+			return "";
+	}
+}
+
+} // namespace
+
 void Houses::payHouses(RentPeriod_t rentPeriod) const
 {
 	if (rentPeriod == RENTPERIOD_NEVER) {
 		return;
 	}
 
+	int64_t start = OTSYS_NANOTIME();
 	time_t currentTime = time(nullptr);
+
+	std::vector<House*> dueHouses;
+	std::set<uint32_t> ownerIds;
 	for (const auto& it : houseMap) {
 		House* house = it.second;
 		if (house->getOwner() == 0) {
@@ -622,82 +730,98 @@ void Houses::payHouses(RentPeriod_t rentPeriod) const
 			continue;
 		}
 
-		const uint32_t ownerId = house->getOwner();
-		Town* town = g_game.map.towns.getTown(house->getTownId());
-		if (!town) {
+		if (!g_game.map.towns.getTown(house->getTownId())) {
 			continue;
 		}
 
-		Player player(nullptr);
-		if (!IOLoginData::loadPlayerById(&player, ownerId)) {
+		dueHouses.push_back(house);
+		ownerIds.insert(house->getOwner());
+	}
+
+	if (dueHouses.empty()) {
+		return;
+	}
+
+	// the balances of all the owners in one query, only the owners that can not pay are loaded in full
+	Database& db = Database::getInstance();
+	DBResult_ptr result = db.storeQuery(
+	    fmt::format("SELECT `id`, `balance` FROM `players` WHERE `id` IN ({:d})", fmt::join(ownerIds, ",")));
+	if (!result) {
+		std::cout << "[Warning - Houses::payHouses] Could not read the balances of the house owners." << std::endl;
+		return;
+	}
+
+	std::map<uint32_t, uint64_t> balances;
+	do {
+		balances[result->getNumber<uint32_t>("id")] = result->getNumber<uint64_t>("balance");
+	} while (result->next());
+
+	// houses are paid in order, an owner of several pays for each as long as the balance lasts
+	std::map<uint32_t, uint64_t> debits;
+	std::vector<House*> paidHouses;
+	std::vector<House*> unpaidHouses;
+	for (House* house : dueHouses) {
+		auto it = balances.find(house->getOwner());
+		if (it == balances.end()) {
 			// Player doesn't exist, reset house owner
 			house->setOwner(0);
 			continue;
 		}
 
-		if (player.getBankBalance() >= rent) {
-			player.setBankBalance(player.getBankBalance() - rent);
-
-			time_t paidUntil = currentTime;
-			switch (rentPeriod) {
-				case RENTPERIOD_DAILY:
-					paidUntil += 24 * 60 * 60;
-					break;
-				case RENTPERIOD_WEEKLY:
-					paidUntil += 24 * 60 * 60 * 7;
-					break;
-				case RENTPERIOD_MONTHLY:
-					paidUntil += 24 * 60 * 60 * 30;
-					break;
-				case RENTPERIOD_YEARLY:
-					paidUntil += 24 * 60 * 60 * 365;
-					break;
-				default:
-					break;
-			}
-
-			house->setPaidUntil(paidUntil);
+		if (it->second >= house->getRent()) {
+			it->second -= house->getRent();
+			debits[it->first] += house->getRent();
+			paidHouses.push_back(house);
 		} else {
-			if (house->getPayRentWarnings() < 7) {
-				int32_t daysLeft = 7 - house->getPayRentWarnings();
-
-				Item* letter = Item::CreateItem(ITEM_LETTER_STAMPED);
-				std::string period;
-
-				switch (rentPeriod) {
-					case RENTPERIOD_DAILY:
-						period = "daily";
-						break;
+			unpaidHouses.push_back(house);
+		}
+	}
 
-					case RENTPERIOD_WEEKLY:
-						period = "weekly";
-						break;
+	if (!debits.empty()) {
+		std::string cases;
+		std::vector<uint32_t> debitedIds;
+		for (const auto& [guid, debit] : debits) {
+			cases += fmt::format(" WHEN {:d} THEN {:d}", guid, debit);
+			debitedIds.push_back(guid);
+		}
 
-					case RENTPERIOD_MONTHLY:
-						period = "monthly";
-						break;
+		if (!db.executeQuery(fmt::format("UPDATE `players` SET `balance` = `balance` - CASE `id`{:s} END WHERE `id` "
+		                                 "IN ({:d})",
+		                                 cases, fmt::join(debitedIds, ",")))) {
+			std::cout << "[Warning - Houses::payHouses] Could not charge the house rents." << std::endl;
+			return;
+		}
 
-					case RENTPERIOD_YEARLY:
-						period = "annual";
-						break;
+		const time_t paidUntil = getRentPaidUntil(rentPeriod, currentTime);
+		for (House* house : paidHouses) {
+			house->setPaidUntil(paidUntil);
+		}
+	}
 
-					default:
-						break;
-				}
+	// the owners that could not pay are not loaded, the letters and the items of lost houses go to their depot rows
+	for (House* house : unpaidHouses) {
+		if (house->getPayRentWarnings() < 7) {
+			int32_t daysLeft = 7 - house->getPayRentWarnings();
 
-				letter->setText(fmt::format(
-				    "Warning! \nThe {:s} rent of {:d} gold for your house \"{:s}\" is payable. Have it within {:d} days or you will lose this house.",
-				    period, house->getRent(), house->getName(), daysLeft));
-				DepotLocker* depot = player.getDepotLocker(town->getID());
-				if (depot) {
-					g_game.internalAddItem(depot, letter, INDEX_WHEREEVER, FLAG_NOLIMIT);
-				}
-				house->setPayRentWarnings(house->getPayRentWarnings() + 1);
+			Item* letter = Item::CreateItem(ITEM_LETTER_STAMPED);
+			letter->setText(fmt::format(
+			    "Warning! \nThe {:s} rent of {:d} gold for your house \"{:s}\" is payable. Have it within {:d} days or you will lose this house.",
+			    getRentPeriodName(rentPeriod), house->getRent(), house->getName(), daysLeft));
+			if (Player* player = g_game.getPlayerByGUID(house->getOwner())) {
+				g_game.internalAddItem(player->getDepotLocker(house->getTownId()), letter, INDEX_WHEREEVER,
+				                       FLAG_NOLIMIT);
 			} else {
-				house->setOwner(0, true, &player);
+				auto depotLocker = std::make_shared<DepotLocker>(ITEM_LOCKER);
+				g_game.internalAddItem(depotLocker.get(), letter, INDEX_WHEREEVER, FLAG_NOLIMIT);
+				IOLoginData::addDepotItems(house->getOwner(), house->getTownId(), *depotLocker);
 			}
+			house->setPayRentWarnings(house->getPayRentWarnings() + 1);
+		} else {
+			house->setOwner(0, true, g_game.getPlayerByGUID(house->getOwner()));
 		}
-
-		IOLoginData::savePlayer(&player);
 	}
+
+	std::cout << fmt::format("> Charged the rent of {:d} houses, {:d} owners could not pay, in {:.3f}s.",
+	                         paidHouses.size(), unpaidHouses.size(), (OTSYS_NANOTIME() - start) / 1e9)
+	          << std::endl;
 }
@@ -8,11 +8,12 @@
 #include "housetile.h"
 #include "position.h"
 
+#include <map>
 #include <set>
-#include <unordered_set>
 
 class House;
 class BedItem;
+class DepotLocker;
 class Player;
 
 class AccessList
@@ -29,8 +30,12 @@ public:
 
 private:
 	std::string list;
-	std::unordered_set<uint32_t> playerList;
-	std::unordered_set<uint32_t> guildRankList;
+	// sorted guids and guild rank ids, a list has at most 100 lines so a search over them beats hashing
+	std::vector<uint32_t> playerList;
+	std::vector<uint32_t> guildRankList;
+	// ids each line resolved to, kept across parses so an edit only looks up the lines it added
+	std::map<std::string, std::vector<uint32_t>, std::less<>> resolvedPlayers;
+	std::map<std::string, std::vector<uint32_t>, std::less<>> resolvedGuilds;
 	bool allowEveryone = false;
 };
 
@@ -169,6 +174,7 @@ public:
 private:
 	bool transferToDepot() const;
 	bool transferToDepot(Player* player) const;
+	bool transferToDepot(DepotLocker* depot) const;
 
 	AccessList guestList;
 	AccessList subOwnerList;
@@ -246,6 +252,8 @@ public:
 	}
 
 	House* getHouseByPlayerId(uint32_t playerId);
+	// called by House::setOwner once the owner changed
+	void updateOwner(House* house, uint32_t oldOwner);
 
 	bool loadHousesXML(const std::string& filename);
 
@@ -255,6 +263,8 @@ public:
 
 private:
 	HouseMap houseMap;
+	// the owned house with the lowest id for each owner guid
+	std::unordered_map<uint32_t, House*> housesByOwner;
 };
 
 #endif
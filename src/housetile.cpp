@@ -12,7 +12,10 @@
 extern Game g_game;
 extern ConfigManager g_config;
 
-HouseTile::HouseTile(uint16_t x, uint16_t y, uint8_t z, House* house) : DynamicTile(x, y, z), house(house) {}
+HouseTile::HouseTile(uint16_t x, uint16_t y, uint8_t z, House* house) : DynamicTile(x, y, z), house(house)
+{
+	setFlag(TILESTATE_HOUSE);
+}
 
 void HouseTile::addThing(int32_t index, Thing* thing)
 {
@@ -66,25 +69,27 @@ ReturnValue HouseTile::queryAdd(int32_t index, const Thing& thing, uint32_t coun
 		return RETURNVALUE_NOERROR;
 	}
 
-	if (const Creature* creature = thing.getCreature()) {
-		if (const Player* player = creature->getPlayer()) {
-			if (!house->isInvited(player)) {
-				return RETURNVALUE_PLAYERISNOTINVITED;
-			}
-		} else {
-			return RETURNVALUE_NOTPOSSIBLE;
-		}
-	} else if (thing.getItem()) {
-		if (actor) {
-			Player* actorPlayer = actor->getPlayer();
-			if (!house->isInvited(actorPlayer)) {
-				return RETURNVALUE_CANNOTTHROW;
-			}
+	// creatures are checked by Tile::queryAddCreature
+	if (thing.getItem() && actor) {
+		Player* actorPlayer = actor->getPlayer();
+		if (!house->isInvited(actorPlayer)) {
+			return RETURNVALUE_CANNOTTHROW;
 		}
 	}
 	return Tile::queryAdd(index, thing, count, flags, actor);
 }
 
+ReturnValue HouseTile::queryInvited(const Creature& creature) const
+{
+	if (const Player* player = creature.getPlayer()) {
+		if (!house->isInvited(player)) {
+			return RETURNVALUE_PLAYERISNOTINVITED;
+		}
+		return RETURNVALUE_NOERROR;
+	}
+	return RETURNVALUE_NOTPOSSIBLE;
+}
+
 Tile* HouseTile::queryDestination(int32_t& index, const Thing& thing, Item** destItem, uint32_t& flags)
 {
 	if (const Creature* creature = thing.getCreature()) {
@@ -15,6 +15,9 @@ public:
 
 	using Tile::internalAddThing;
 
+	// only invited players may enter
+	ReturnValue queryInvited(const Creature& creature) const;
+
 	// cylinder implementations
 	ReturnValue queryAdd(int32_t index, const Thing& thing, uint32_t count, uint32_t flags,
 	                     Creature* actor = nullptr) const override;
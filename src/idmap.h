@@ -0,0 +1,84 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_IDMAP_H
+#define FS_IDMAP_H
+
+/*
+ * Map from 16 bit ids (item, action and unique ids) to values, looked up through a table indexed by the id itself.
+ * The table only holds a slot number per id and grows up to the highest id inserted, the values live in a deque so
+ * pointers to them stay valid until they are erased.
+ */
+template <typename Value>
+class IdMap
+{
+public:
+	Value* find(uint16_t id)
+	{
+		if (id >= index.size() || index[id] == 0) {
+			return nullptr;
+		}
+		return &values[index[id] - 1]->second;
+	}
+
+	const Value* find(uint16_t id) const { return const_cast<IdMap*>(this)->find(id); }
+
+	std::pair<Value*, bool> emplace(uint16_t id, Value value)
+	{
+		if (Value* existing = find(id)) {
+			return {existing, false};
+		}
+
+		uint32_t slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+			values[slot].emplace(id, std::move(value));
+		} else {
+			slot = static_cast<uint32_t>(values.size());
+			values.emplace_back(std::in_place, id, std::move(value));
+		}
+
+		if (id >= index.size()) {
+			index.resize(id + 1);
+		}
+		index[id] = slot + 1;
+		return {&values[slot]->second, true};
+	}
+
+	Value& operator[](uint16_t id) { return *emplace(id, Value{}).first; }
+
+	// erases every value pred(value) returns true for
+	template <typename Pred>
+	void eraseIf(Pred&& pred)
+	{
+		for (uint32_t slot = 0; slot < values.size(); ++slot) {
+			auto& entry = values[slot];
+			if (entry && pred(entry->second)) {
+				index[entry->first] = 0;
+				entry.reset();
+				freeSlots.push_back(slot);
+			}
+		}
+	}
+
+	// calls f(id, value) for every value, in no particular order
+	template <typename F>
+	void forEach(F&& f)
+	{
+		for (auto& entry : values) {
+			if (entry) {
+				f(entry->first, entry->second);
+			}
+		}
+	}
+
+	size_t size() const { return values.size() - freeSlots.size(); }
+
+private:
+	std::vector<uint32_t> index;
+	std::deque<std::optional<std::pair<uint16_t, Value>>> values;
+	std::vector<uint32_t> freeSlots;
+};
+
+#endif // FS_IDMAP_H
@@ -6,16 +6,52 @@
 #include "iologindata.h"
 
 #include "configmanager.h"
+#include "databasetasks.h"
 #include "game.h"
+#include "logger.h"
 
 extern ConfigManager g_config;
+extern Dispatcher g_dispatcher;
 extern Game g_game;
 
-Account IOLoginData::loadAccount(uint32_t accno)
+namespace {
+
+// accounts that got a character list recently, by account name
+struct CachedAccount
+{
+	Account account;
+	std::string password;
+	int64_t expiresAt;
+};
+
+constexpr size_t MAX_CACHED_ACCOUNTS = 4096;
+
+std::unordered_map<std::string, CachedAccount> accountCache;
+std::mutex accountCacheLock;
+
+constexpr std::string_view PLAYER_COLUMNS =
+    "`id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction`";
+
+// a loadPlayerAsync in flight, the last section to arrive hands it to the dispatcher
+struct PendingPlayerLoad
+{
+	PlayerLoadData data;
+	std::atomic<uint8_t> pendingSections = PlayerLoadData::SECTION_COUNT;
+	std::function<void(PlayerLoadData*)> callback;
+};
+
+void finishPlayerLoad(std::shared_ptr<PendingPlayerLoad> load, bool success)
+{
+	g_dispatcher.addTask([load = std::move(load), success]() { load->callback(success ? &load->data : nullptr); });
+}
+
+} // namespace
+
+Account IOLoginData::loadAccount(Database& db, uint32_t accno)
 {
 	Account account;
 
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
+	DBResult_ptr result = db.storeQuery(fmt::format(
 	    "SELECT `id`, `name`, `password`, `type`, `premium_ends_at`, `tibia_coins` FROM `accounts` WHERE `id` = {:d}",
 	    accno));
 	if (!result) {
@@ -59,9 +95,20 @@ std::string decodeSecret(std::string_view secret)
 	return key;
 }
 
-bool IOLoginData::loginserverAuthentication(std::string_view name, std::string_view password, Account& account)
+bool IOLoginData::loginserverAuthentication(Database& db, std::string_view name, std::string_view password,
+                                            Account& account)
 {
-	Database& db = Database::getInstance();
+	const int64_t cacheTime = g_config[ConfigKeysInteger::LOGIN_CACHE_TIME] * 1000;
+	const std::string passwordHash = transformToSHA1(password);
+	if (cacheTime > 0) {
+		std::lock_guard<std::mutex> lockClass(accountCacheLock);
+		auto it = accountCache.find(std::string{name});
+		// a different password may have been set since, only a match is answered from the cache
+		if (it != accountCache.end() && OTSYS_TIME() < it->second.expiresAt && it->second.password == passwordHash) {
+			account = it->second.account;
+			return true;
+		}
+	}
 
 	DBResult_ptr result = db.storeQuery(fmt::format(
 	    "SELECT `id`, `name`, `password`, `secret`, `type`, `premium_ends_at`, `tibia_coins` FROM `accounts` WHERE `name` = {:s}",
@@ -70,7 +117,7 @@ bool IOLoginData::loginserverAuthentication(std::string_view name, std::string_v
 		return false;
 	}
 
-	if (transformToSHA1(password) != result->getString("password")) {
+	if (passwordHash != result->getString("password")) {
 		return false;
 	}
 
@@ -92,9 +139,24 @@ bool IOLoginData::loginserverAuthentication(std::string_view name, std::string_v
 			account.characters.push_back(std::string{result->getString("name")});
 		} while (result->next());
 	}
+
+	if (cacheTime > 0) {
+		const int64_t now = OTSYS_TIME();
+		std::lock_guard<std::mutex> lockClass(accountCacheLock);
+		if (accountCache.size() >= MAX_CACHED_ACCOUNTS) {
+			std::erase_if(accountCache, [=](const auto& it) { return now >= it.second.expiresAt; });
+		}
+		accountCache.insert_or_assign(std::string{name}, CachedAccount{account, passwordHash, now + cacheTime});
+	}
 	return true;
 }
 
+void IOLoginData::clearAccountCache()
+{
+	std::lock_guard<std::mutex> lockClass(accountCacheLock);
+	accountCache.clear();
+}
+
 std::pair<uint32_t, uint32_t> IOLoginData::gameworldAuthentication(std::string_view accountName,
                                                                    std::string_view password,
                                                                    std::string_view characterName)
@@ -190,11 +252,11 @@ void IOLoginData::updateOnlineStatus(uint32_t guid, bool login)
 		return;
 	}
 
+	Database& db = Database::getInstance();
 	if (login) {
-		Database::getInstance().executeQuery(fmt::format("INSERT INTO `players_online` VALUES ({:d})", guid));
+		db.prepare("INSERT INTO `players_online` VALUES (?)")->execute(guid);
 	} else {
-		Database::getInstance().executeQuery(
-		    fmt::format("DELETE FROM `players_online` WHERE `player_id` = {:d}", guid));
+		db.prepare("DELETE FROM `players_online` WHERE `player_id` = ?")->execute(guid);
 	}
 }
 
@@ -212,8 +274,8 @@ bool IOLoginData::preloadPlayer(Player* player)
 	player->setName(result->getString("name"));
 	Group* group = g_game.groups.getGroup(result->getNumber<uint16_t>("group_id"));
 	if (!group) {
-		std::cout << "[Error - IOLoginData::preloadPlayer] " << player->name << " has Group ID "
-		          << result->getNumber<uint16_t>("group_id") << " which doesn't exist." << std::endl;
+		Logger::log(LOG_ERROR, "IOLoginData::preloadPlayer", "{} has Group ID {} which doesn't exist.", player->name,
+		            result->getNumber<uint16_t>("group_id"));
 		return false;
 	}
 	player->setGroup(group);
@@ -225,34 +287,157 @@ bool IOLoginData::preloadPlayer(Player* player)
 
 bool IOLoginData::loadPlayerById(Player* player, uint32_t id)
 {
+	flushPlayerSaves();
+	waitForPendingSave(id);
+
 	Database& db = Database::getInstance();
-	return loadPlayer(
-	    player,
-	    db.storeQuery(fmt::format(
-	        "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction` FROM `players` WHERE `id` = {:d}",
-	        id)));
+	PlayerLoadData data;
+	data.player = db.storeQuery(fmt::format("SELECT {:s} FROM `players` WHERE `id` = {:d}", PLAYER_COLUMNS, id));
+	return fetchPlayer(db, data) && loadPlayer(player, data);
 }
 
 bool IOLoginData::loadPlayerByName(Player* player, std::string_view name)
 {
+	if (hasPendingSaves()) {
+		flushPlayerSaves();
+		waitForPendingSave(getGuidByName(name));
+	}
+
 	Database& db = Database::getInstance();
-	return loadPlayer(
-	    player,
-	    db.storeQuery(fmt::format(
-	        "SELECT `id`, `name`, `account_id`, `group_id`, `sex`, `vocation`, `experience`, `level`, `maglevel`, `health`, `healthmax`, `blessings`, `mana`, `manamax`, `manaspent`, `soul`, `lookbody`, `lookfeet`, `lookhead`, `looklegs`, `looktype`, `lookaddons`, `currentmount`, `randomizemount`, `posx`, `posy`, `posz`, `cap`, `lastlogin`, `lastlogout`, `lastip`, `conditions`, `skulltime`, `skull`, `town_id`, `balance`, `stamina`, `skill_fist`, `skill_fist_tries`, `skill_club`, `skill_club_tries`, `skill_sword`, `skill_sword_tries`, `skill_axe`, `skill_axe_tries`, `skill_dist`, `skill_dist_tries`, `skill_shielding`, `skill_shielding_tries`, `skill_fishing`, `skill_fishing_tries`, `direction` FROM `players` WHERE `name` = {:s}",
-	        db.escapeString(name))));
+	PlayerLoadData data;
+	data.player = db.storeQuery(
+	    fmt::format("SELECT {:s} FROM `players` WHERE `name` = {:s}", PLAYER_COLUMNS, db.escapeString(name)));
+	return fetchPlayer(db, data) && loadPlayer(player, data);
+}
+
+void IOLoginData::loadPlayerAsync(uint32_t guid, std::function<void(PlayerLoadData*)> callback)
+{
+	// queued behind the saves of the player on their own connection
+	flushPlayerSaves();
+
+	auto load = std::make_shared<PendingPlayerLoad>();
+	load->callback = std::move(callback);
+
+	auto job = [load, guid](Database& db) {
+		PlayerLoadData& data = load->data;
+		data.player = db.storeQuery(fmt::format("SELECT {:s} FROM `players` WHERE `id` = {:d}", PLAYER_COLUMNS, guid));
+		if (!fetchPlayerRow(db, data)) {
+			finishPlayerLoad(load, false);
+			return;
+		}
+
+		// the sections only depend on the player row and spread over the other connections
+		for (uint8_t section = 0; section < PlayerLoadData::SECTION_COUNT; ++section) {
+			auto sectionJob = [load, section](Database& db) {
+				fetchPlayerSection(db, load->data, static_cast<PlayerLoadData::Section>(section));
+				if (--load->pendingSections == 0) {
+					finishPlayerLoad(load, true);
+				}
+			};
+
+			if (!g_databaseTasks.addJob(sectionJob, DATABASE_KEY_PLAYER_LOADS + section)) {
+				sectionJob(db);
+			}
+		}
+	};
+
+	if (!g_databaseTasks.addJob(job, DATABASE_KEY_PLAYER_SAVES)) {
+		job(Database::getInstance());
+	}
+}
+
+bool IOLoginData::fetchPlayerRow(Database& db, PlayerLoadData& data)
+{
+	if (!data.player) {
+		return false;
+	}
+
+	data.guid = data.player->getNumber<uint32_t>("id");
+	data.accountId = data.player->getNumber<uint32_t>("account_id");
+	data.account = loadAccount(db, data.accountId);
+	return true;
+}
+
+bool IOLoginData::fetchPlayer(Database& db, PlayerLoadData& data)
+{
+	if (!fetchPlayerRow(db, data)) {
+		return false;
+	}
+
+	for (uint8_t section = 0; section < PlayerLoadData::SECTION_COUNT; ++section) {
+		fetchPlayerSection(db, data, static_cast<PlayerLoadData::Section>(section));
+	}
+	return true;
+}
+
+void IOLoginData::fetchPlayerSection(Database& db, PlayerLoadData& data, PlayerLoadData::Section section)
+{
+	const uint32_t guid = data.guid;
+	switch (section) {
+		case PlayerLoadData::SECTION_GUILD: {
+			data.guildMembership = db.storeQuery(fmt::format(
+			    "SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = {:d}", guid));
+			if (!data.guildMembership) {
+				break;
+			}
+
+			const uint32_t guildId = data.guildMembership->getNumber<uint32_t>("guild_id");
+			// the guild is read here as well, so a guild that is not loaded yet does not cost a query on login
+			data.guild = db.storeQuery(fmt::format("SELECT `name` FROM `guilds` WHERE `id` = {:d}", guildId));
+			data.guildRanks = db.storeQuery(
+			    fmt::format("SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `guild_id` = {:d}", guildId));
+			data.guildWars = db.storeQuery(fmt::format(
+			    "SELECT `guild1`, `guild2` FROM `guild_wars` WHERE (`guild1` = {:d} OR `guild2` = {:d}) AND `ended` = 0 AND `status` = 1",
+			    guildId, guildId));
+			data.guildMembers = db.storeQuery(fmt::format(
+			    "SELECT COUNT(*) AS `members` FROM `guild_membership` WHERE `guild_id` = {:d}", guildId));
+			break;
+		}
+
+		case PlayerLoadData::SECTION_SPELLS:
+			data.spells = db.storeQuery(
+			    fmt::format("SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = {:d}", guid));
+			break;
+
+		case PlayerLoadData::SECTION_ITEMS:
+			data.items = db.storeQuery(fmt::format(
+			    "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
+			    guid));
+			break;
+
+		case PlayerLoadData::SECTION_STORAGE:
+			data.storage = db.storeQuery(
+			    fmt::format("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = {:d}", guid));
+			break;
+
+		case PlayerLoadData::SECTION_VIP:
+			data.vips = db.storeQuery(fmt::format(
+			    "SELECT `player_id`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `name` FROM `account_viplist` WHERE `account_id` = {:d}",
+			    data.accountId));
+			break;
+
+		case PlayerLoadData::SECTION_OUTFITS:
+			data.outfits = db.storeQuery(
+			    fmt::format("SELECT `outfit_id`, `addons` FROM `player_outfits` WHERE `player_id` = {:d}", guid));
+			break;
+
+		case PlayerLoadData::SECTION_MOUNTS:
+			data.mounts =
+			    db.storeQuery(fmt::format("SELECT `mount_id` FROM `player_mounts` WHERE `player_id` = {:d}", guid));
+			break;
+
+		default:
+			break;
+	}
 }
 
-static GuildWarVector getWarList(uint32_t guildId)
+static std::vector<uint32_t> getWarList(uint32_t guildId, DBResult_ptr result)
 {
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `guild1`, `guild2` FROM `guild_wars` WHERE (`guild1` = {:d} OR `guild2` = {:d}) AND `ended` = 0 AND `status` = 1",
-	    guildId, guildId));
 	if (!result) {
 		return {};
 	}
 
-	GuildWarVector guildWarVector;
+	std::vector<uint32_t> guildWarVector;
 	do {
 		uint32_t guild1 = result->getNumber<uint32_t>("guild1");
 		if (guildId != guild1) {
@@ -264,18 +449,14 @@ static GuildWarVector getWarList(uint32_t guildId)
 	return guildWarVector;
 }
 
-bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
+bool IOLoginData::loadPlayer(Player* player, PlayerLoadData& data)
 {
-	if (!result) {
-		return false;
-	}
-
-	Database& db = Database::getInstance();
-
-	uint32_t accno = result->getNumber<uint32_t>("account_id");
-	Account acc = loadAccount(accno);
+	DBResult_ptr result = data.player;
+	uint32_t accno = data.accountId;
+	const Account& acc = data.account;
 
 	player->setGUID(result->getNumber<uint32_t>("id"));
+	resetSaveSections(player->getGUID());
 	player->name = result->getString("name");
 	player->accountNumber = accno;
 
@@ -285,8 +466,8 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 
 	Group* group = g_game.groups.getGroup(result->getNumber<uint16_t>("group_id"));
 	if (!group) {
-		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Group ID "
-		          << result->getNumber<uint16_t>("group_id") << " which doesn't exist" << std::endl;
+		Logger::log(LOG_ERROR, "IOLoginData::loadPlayer", "{} has Group ID {} which doesn't exist", player->name,
+		            result->getNumber<uint16_t>("group_id"));
 		return false;
 	}
 	player->setGroup(group);
@@ -330,8 +511,8 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	}
 
 	if (!player->setVocation(result->getNumber<uint16_t>("vocation"))) {
-		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Vocation ID "
-		          << result->getNumber<uint16_t>("vocation") << " which doesn't exist" << std::endl;
+		Logger::log(LOG_ERROR, "IOLoginData::loadPlayer", "{} has Vocation ID {} which doesn't exist", player->name,
+		            result->getNumber<uint16_t>("vocation"));
 		return false;
 	}
 
@@ -383,11 +564,12 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 
 	player->lastLoginSaved = result->getNumber<time_t>("lastlogin");
 	player->lastLogout = result->getNumber<time_t>("lastlogout");
+	player->lastSaveTime = OTSYS_TIME();
 
 	Town* town = g_game.map.towns.getTown(result->getNumber<uint32_t>("town_id"));
 	if (!town) {
-		std::cout << "[Error - IOLoginData::loadPlayer] " << player->name << " has Town ID "
-		          << result->getNumber<uint32_t>("town_id") << " which doesn't exist" << std::endl;
+		Logger::log(LOG_ERROR, "IOLoginData::loadPlayer", "{} has Town ID {} which doesn't exist", player->name,
+		            result->getNumber<uint32_t>("town_id"));
 		return false;
 	}
 
@@ -419,32 +601,35 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		player->skills[i].percent = Player::getBasisPointLevel(skillTries, nextSkillTries);
 	}
 
-	if ((result = db.storeQuery(
-	         fmt::format("SELECT `guild_id`, `rank_id`, `nick` FROM `guild_membership` WHERE `player_id` = {:d}",
-	                     player->getGUID())))) {
+	if ((result = data.guildMembership)) {
 		uint32_t guildId = result->getNumber<uint32_t>("guild_id");
 		uint32_t playerRankId = result->getNumber<uint32_t>("rank_id");
 		player->guildNick = result->getString("nick");
 
 		Guild* guild = g_game.getGuild(guildId);
-		if (!guild) {
-			guild = IOGuild::loadGuild(guildId);
+		const bool cached = guild != nullptr;
+		if (!cached) {
+			guild = IOGuild::loadGuild(guildId, data.guild, data.guildRanks);
 			if (guild) {
 				g_game.addGuild(guild);
 			} else {
-				std::cout << "[Warning - IOLoginData::loadPlayer] " << player->name << " has Guild ID " << guildId
-				          << " which doesn't exist" << std::endl;
+				Logger::log(LOG_WARNING, "IOLoginData::loadPlayer", "{} has Guild ID {} which doesn't exist",
+				            player->name, guildId);
 			}
 		}
 
 		if (guild) {
 			player->guild = guild;
 			GuildRank_ptr rank = guild->getRankById(playerRankId);
-			if (!rank) {
-				if ((result = db.storeQuery(fmt::format(
-				         "SELECT `id`, `name`, `level` FROM `guild_ranks` WHERE `id` = {:d}", playerRankId)))) {
-					guild->addRank(result->getNumber<uint32_t>("id"), result->getString("name"),
-					               result->getNumber<uint16_t>("level"));
+			if (!rank && cached) {
+				// a rank added since the guild was loaded
+				if ((result = data.guildRanks)) {
+					do {
+						if (result->getNumber<uint32_t>("id") == playerRankId) {
+							guild->addRank(playerRankId, result->getString("name"),
+							               result->getNumber<uint16_t>("level"));
+						}
+					} while (result->next());
 				}
 
 				rank = guild->getRankById(playerRankId);
@@ -455,17 +640,16 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 
 			player->guildRank = rank;
 
-			player->guildWarVector = getWarList(guildId);
+			// the wars were read with the player anyway, so every login refreshes the ones of the guild
+			guild->setWars(getWarList(guildId, data.guildWars));
 
-			if ((result = db.storeQuery(fmt::format(
-			         "SELECT COUNT(*) AS `members` FROM `guild_membership` WHERE `guild_id` = {:d}", guildId)))) {
+			if ((result = data.guildMembers)) {
 				guild->setMemberCount(result->getNumber<uint32_t>("members"));
 			}
 		}
 	}
 
-	if ((result = db.storeQuery(fmt::format("SELECT `player_id`, `name` FROM `player_spells` WHERE `player_id` = {:d}",
-	                                        player->getGUID())))) {
+	if ((result = data.spells)) {
 		do {
 			player->learnedInstantSpellList.emplace_front(result->getString("name"));
 		} while (result->next());
@@ -474,9 +658,7 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	// load inventory items
 	ItemMap itemMap;
 
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_items` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
+	if ((result = data.items)) {
 		loadItems(itemMap, result);
 
 		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
@@ -500,97 +682,31 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 		}
 	}
 
-	// load depot locker items
-	itemMap.clear();
-
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotlockeritems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
-		loadItems(itemMap, result);
-
-		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
-			const std::pair<Item*, int32_t>& pair = it->second;
-			Item* item = pair.first;
-
-			int32_t pid = pair.second;
-			if (pid >= 0 && pid < 100) {
-				DepotLocker* depotLocker = player->getDepotLocker(pid);
-				if (depotLocker) {
-					depotLocker->internalAddThing(item);
-				}
-			} else {
-				ItemMap::const_iterator it2 = itemMap.find(pid);
-				if (it2 == itemMap.end()) {
-					continue;
-				}
-
-				Container* container = it2->second.first->getContainer();
-				if (container) {
-					container->internalAddThing(item);
-				}
-			}
-		}
-	}
-
-	// load depot items
-	itemMap.clear();
-
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
-	         player->getGUID())))) {
-		loadItems(itemMap, result);
-
-		for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
-			const std::pair<Item*, int32_t>& pair = it->second;
-			Item* item = pair.first;
-
-			int32_t pid = pair.second;
-			if (pid >= 0 && pid < 100) {
-				DepotChest* depotChest = player->getDepotChest(pid, true);
-				if (depotChest) {
-					depotChest->internalAddThing(item);
-				}
-			} else {
-				ItemMap::const_iterator it2 = itemMap.find(pid);
-				if (it2 == itemMap.end()) {
-					continue;
-				}
-
-				Container* container = it2->second.first->getContainer();
-				if (container) {
-					container->internalAddThing(item);
-				}
-			}
-		}
-	}
-
 	// load storage map
-	if ((result = db.storeQuery(
-	         fmt::format("SELECT `key`, `value` FROM `player_storage` WHERE `player_id` = {:d}", player->getGUID())))) {
+	if ((result = data.storage)) {
 		do {
 			player->setStorageValue(result->getNumber<uint32_t>("key"), result->getNumber<int64_t>("value"), true);
 		} while (result->next());
 	}
+	// the loaded values are what the database holds already
+	player->takeStorageChanges();
 
 	// load vip list
-	if ((result = db.storeQuery(fmt::format("SELECT `player_id` FROM `account_viplist` WHERE `account_id` = {:d}",
-	                                        player->getAccount())))) {
+	if ((result = data.vips)) {
 		do {
-			player->addVIPInternal(result->getNumber<uint32_t>("player_id"));
+			player->addVIPInternal(result->getNumber<uint32_t>("player_id"), result->getString("name"));
 		} while (result->next());
 	}
 
 	// load outfits & addons
-	if ((result = db.storeQuery(fmt::format(
-	         "SELECT `outfit_id`, `addons` FROM `player_outfits` WHERE `player_id` = {:d}", player->getGUID())))) {
+	if ((result = data.outfits)) {
 		do {
 			player->addOutfit(result->getNumber<uint16_t>("outfit_id"), result->getNumber<uint8_t>("addons"));
 		} while (result->next());
 	}
 
 	// load mounts
-	if ((result = db.storeQuery(
-	         fmt::format("SELECT `mount_id` FROM `player_mounts` WHERE `player_id` = {:d}", player->getGUID())))) {
+	if ((result = data.mounts)) {
 		do {
 			player->tameMount(result->getNumber<uint16_t>("mount_id"));
 		} while (result->next());
@@ -602,8 +718,258 @@ bool IOLoginData::loadPlayer(Player* player, DBResult_ptr result)
 	return true;
 }
 
-bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert,
-                            PropWriteStream& propWriteStream)
+void IOLoginData::loadDepots(Player* player)
+{
+	// the player was loaded after its pending saves, and saves leave the depot rows alone until this ran, only
+	// items sent while it was offline may still be on the way
+	waitForPendingSave(player->getGUID());
+	Database& db = Database::getInstance();
+
+	// load depot locker items
+	ItemMap itemMap;
+
+	// the rows are streamed, the items are created as they arrive instead of buffering all of them first
+	const auto loadRow = [&itemMap](DBResult& result) {
+		loadItem(itemMap, result);
+		return true;
+	};
+
+	db.streamQuery(
+	    fmt::format(
+	        "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotlockeritems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
+	        player->getGUID()),
+	    loadRow);
+
+	for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
+		const std::pair<Item*, int32_t>& pair = it->second;
+		Item* item = pair.first;
+
+		int32_t pid = pair.second;
+		if (pid >= 0 && pid < 100) {
+			DepotLocker* depotLocker = player->getDepotLocker(pid);
+			if (depotLocker) {
+				depotLocker->internalAddThing(item);
+			}
+		} else {
+			ItemMap::const_iterator it2 = itemMap.find(pid);
+			if (it2 == itemMap.end()) {
+				continue;
+			}
+
+			Container* container = it2->second.first->getContainer();
+			if (container) {
+				container->internalAddThing(item);
+			}
+		}
+	}
+
+	// load depot items
+	itemMap.clear();
+
+	db.streamQuery(
+	    fmt::format(
+	        "SELECT `pid`, `sid`, `itemtype`, `count`, `attributes` FROM `player_depotitems` WHERE `player_id` = {:d} ORDER BY `sid` DESC",
+	        player->getGUID()),
+	    loadRow);
+
+	for (ItemMap::const_reverse_iterator it = itemMap.rbegin(), end = itemMap.rend(); it != end; ++it) {
+		const std::pair<Item*, int32_t>& pair = it->second;
+		Item* item = pair.first;
+
+		int32_t pid = pair.second;
+		if (pid >= 0 && pid < 100) {
+			DepotChest* depotChest = player->getDepotChest(pid, true);
+			if (depotChest) {
+				depotChest->internalAddThing(item);
+			}
+		} else {
+			ItemMap::const_iterator it2 = itemMap.find(pid);
+			if (it2 == itemMap.end()) {
+				continue;
+			}
+
+			Container* container = it2->second.first->getContainer();
+			if (container) {
+				container->internalAddThing(item);
+			}
+		}
+	}
+}
+
+struct SavedItem
+{
+	int32_t pid;
+	int32_t sid;
+	uint16_t itemId;
+	uint16_t subType;
+	std::string attributes;
+};
+
+// everything savePlayer writes, copied out of the player so it can be written from another thread
+struct PlayerSaveRecord
+{
+	// child tables that are only rewritten when their rows changed since the last save,
+	// the storage is written by its changed keys and only rewritten after a failed write
+	enum Section : uint8_t
+	{
+		SECTION_SPELLS,
+		SECTION_ITEMS,
+		SECTION_DEPOT,
+		SECTION_STORAGE,
+		SECTION_OUTFITS,
+		SECTION_MOUNTS,
+
+		SECTION_COUNT
+	};
+	using SectionHashes = std::array<uint64_t, SECTION_COUNT>;
+
+	uint32_t guid = 0;
+	time_t lastLoginSaved = 0;
+	uint32_t lastIP = 0;
+
+	// `players` columns, the names are literals
+	std::vector<std::pair<std::string_view, int64_t>> columns;
+	std::string conditions;
+	int64_t onlineTime = 0;
+	bool addOnlineTime = false;
+
+	std::vector<std::string> spells;
+	std::vector<SavedItem> items;
+	bool saveDepot = false;
+	std::vector<SavedItem> depotLockerItems;
+	std::vector<SavedItem> depotItems;
+	// sorted by key
+	std::vector<std::pair<uint32_t, int64_t>> storage;
+	std::vector<uint32_t> storageChanges;
+	std::vector<std::pair<uint16_t, uint8_t>> outfits;
+	std::vector<uint16_t> mounts;
+
+	SectionHashes hashes = {};
+	std::bitset<SECTION_COUNT> changed;
+};
+
+namespace {
+
+constexpr size_t PLAYER_SAVE_BATCH_SIZE = 64;
+
+// dispatcher thread only
+std::vector<PlayerSaveRecord> queuedSaves;
+
+// guids with a record handed to the database thread but not written yet
+std::map<uint32_t, uint32_t> pendingSaves;
+std::mutex pendingSavesLock;
+std::condition_variable pendingSavesSignal;
+
+// guids with an offline change handed to the database thread but not applied yet, guarded by pendingSavesLock
+std::map<uint32_t, uint32_t> pendingOfflineChanges;
+
+// section hashes of the newest record made per guid, guarded by pendingSavesLock
+std::map<uint32_t, PlayerSaveRecord::SectionHashes> writtenSections;
+
+// guids whose storage changes were lost to a failed write, guarded by pendingSavesLock
+std::set<uint32_t> unsyncedStorage;
+
+class SectionHasher
+{
+public:
+	template <typename T>
+	requires std::is_integral_v<T>
+	void add(T value)
+	{
+		add(std::string_view{reinterpret_cast<const char*>(&value), sizeof(value)});
+	}
+
+	void add(std::string_view bytes)
+	{
+		for (char c : bytes) {
+			hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+		}
+		// keeps adjacent strings from running into each other
+		hash = (hash ^ bytes.size()) * 0x100000001b3;
+	}
+
+	void add(const std::vector<SavedItem>& items)
+	{
+		for (const SavedItem& item : items) {
+			add(item.pid);
+			add(item.sid);
+			add(item.itemId);
+			add(item.subType);
+			add(item.attributes);
+		}
+	}
+
+	uint64_t get() const { return hash; }
+
+private:
+	uint64_t hash = 0xcbf29ce484222325;
+};
+
+void hashSections(PlayerSaveRecord& record)
+{
+	using Section = PlayerSaveRecord::Section;
+
+	SectionHasher spells;
+	for (const std::string& spell : record.spells) {
+		spells.add(spell);
+	}
+	record.hashes[Section::SECTION_SPELLS] = spells.get();
+
+	SectionHasher items;
+	items.add(record.items);
+	record.hashes[Section::SECTION_ITEMS] = items.get();
+
+	SectionHasher depot;
+	depot.add(record.depotLockerItems);
+	depot.add(record.depotItems);
+	record.hashes[Section::SECTION_DEPOT] = depot.get();
+
+	// unordered containers on the player, sort so the same content hashes the same
+	std::sort(record.outfits.begin(), record.outfits.end());
+	SectionHasher outfits;
+	for (const auto& [lookType, addon] : record.outfits) {
+		outfits.add(lookType);
+		outfits.add(addon);
+	}
+	record.hashes[Section::SECTION_OUTFITS] = outfits.get();
+
+	std::sort(record.mounts.begin(), record.mounts.end());
+	SectionHasher mounts;
+	for (uint16_t mountId : record.mounts) {
+		mounts.add(mountId);
+	}
+	record.hashes[Section::SECTION_MOUNTS] = mounts.get();
+
+	std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+	auto [it, inserted] = writtenSections.try_emplace(record.guid, record.hashes);
+	for (size_t section = 0; section < Section::SECTION_COUNT; ++section) {
+		if (section != Section::SECTION_STORAGE && (inserted || it->second[section] != record.hashes[section])) {
+			record.changed.set(section);
+		}
+	}
+
+	if (unsyncedStorage.erase(record.guid) != 0) {
+		record.changed.set(Section::SECTION_STORAGE);
+	}
+
+	if (!record.saveDepot) {
+		// the depot rows in the database are left as they are
+		record.changed.reset(Section::SECTION_DEPOT);
+		record.hashes[Section::SECTION_DEPOT] = it->second[Section::SECTION_DEPOT];
+	}
+	it->second = record.hashes;
+}
+
+void forgetWrittenSections(const std::vector<PlayerSaveRecord>& records)
+{
+	std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+	for (const PlayerSaveRecord& record : records) {
+		writtenSections.erase(record.guid);
+		unsyncedStorage.insert(record.guid);
+	}
+}
+
+void snapshotItems(const ItemBlockList& itemList, std::vector<SavedItem>& savedItems)
 {
 	using ContainerBlock = std::pair<Container*, int32_t>;
 	std::vector<ContainerBlock> containers;
@@ -611,7 +977,8 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 
 	int32_t runningId = 100;
 
-	Database& db = Database::getInstance();
+	// kept for every save on this thread, so its buffer is only grown by the first ones
+	thread_local PropWriteStream propWriteStream;
 	for (const auto& it : itemList) {
 		int32_t pid = it.first;
 		Item* item = it.second;
@@ -619,12 +986,8 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 
 		propWriteStream.clear();
 		item->serializeAttr(propWriteStream);
-
-		if (!query_insert.addRow(fmt::format("{:d}, {:d}, {:d}, {:d}, {:d}, {:s}", player->getGUID(), pid, runningId,
-		                                     item->getID(), item->getSubType(),
-		                                     db.escapeString(propWriteStream.getStream())))) {
-			return false;
-		}
+		savedItems.emplace_back(pid, runningId, item->getID(), item->getSubType(),
+		                        std::string{propWriteStream.getStream()});
 
 		if (Container* container = item->getContainer()) {
 			containers.emplace_back(container, runningId);
@@ -646,95 +1009,355 @@ bool IOLoginData::saveItems(const Player* player, const ItemBlockList& itemList,
 
 			propWriteStream.clear();
 			item->serializeAttr(propWriteStream);
+			savedItems.emplace_back(parentId, runningId, item->getID(), item->getSubType(),
+			                        std::string{propWriteStream.getStream()});
+		}
+	}
+}
+
+std::string joinGuids(const std::vector<const PlayerSaveRecord*>& records)
+{
+	std::string guids;
+	for (const PlayerSaveRecord* record : records) {
+		if (!guids.empty()) {
+			guids.push_back(',');
+		}
+		guids += std::to_string(record->guid);
+	}
+	return guids;
+}
+
+bool replaceRows(Database& db, std::string_view table, const std::vector<const PlayerSaveRecord*>& allRecords,
+                 PlayerSaveRecord::Section section, std::string_view insert,
+                 const std::function<bool(DBInsert&, const PlayerSaveRecord&)>& addRows)
+{
+	std::vector<const PlayerSaveRecord*> records;
+	for (const PlayerSaveRecord* record : allRecords) {
+		if (record->changed.test(section)) {
+			records.push_back(record);
+		}
+	}
+
+	if (records.empty()) {
+		return true;
+	}
+
+	if (!db.executeQuery(fmt::format("DELETE FROM `{:s}` WHERE `player_id` IN ({:s})", table, joinGuids(records)))) {
+		return false;
+	}
+
+	DBInsert query(insert, db);
+	for (const PlayerSaveRecord* record : records) {
+		if (!addRows(query, *record)) {
+			return false;
+		}
+	}
+	return query.execute();
+}
+
+bool addItemRows(Database& db, DBInsert& query, uint32_t guid, const std::vector<SavedItem>& items)
+{
+	for (const SavedItem& item : items) {
+		if (!query.addRow("{:d}, {:d}, {:d}, {:d}, {:d}, {:s}", guid, item.pid, item.sid, item.itemId, item.subType,
+		                  DBEscaped{db, item.attributes})) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// puts the items in front of the depot locker items of an offline player, the way adding them online does
+bool writeDepotItems(Database& db, uint32_t guid, const std::vector<SavedItem>& items)
+{
+	DBTransaction transaction(db);
+	if (!transaction.begin()) {
+		return false;
+	}
+
+	// the rows are loaded by descending sid and added to the front, so the new ones take the lowest sids
+	if (!db.executeQuery(fmt::format("UPDATE `player_depotlockeritems` SET `sid` = `sid` + {0:d}, `pid` = IF(`pid` > "
+	                                 "100, `pid` + {0:d}, `pid`) WHERE `player_id` = {1:d} ORDER BY `sid` DESC",
+	                                 items.size(), guid))) {
+		return false;
+	}
 
-			if (!query_insert.addRow(fmt::format("{:d}, {:d}, {:d}, {:d}, {:d}, {:s}", player->getGUID(), parentId,
-			                                     runningId, item->getID(), item->getSubType(),
-			                                     db.escapeString(propWriteStream.getStream())))) {
-				return false;
+	DBInsert query(
+	    "INSERT INTO `player_depotlockeritems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ",
+	    db);
+	return addItemRows(db, query, guid, items) && query.execute() && transaction.commit();
+}
+
+// upserts the changed storage keys and deletes the erased ones of the records whose storage is not rewritten whole
+bool writeStorageChanges(Database& db, const std::vector<const PlayerSaveRecord*>& records)
+{
+	DBInsert query("REPLACE INTO `player_storage` (`player_id`, `key`, `value`) VALUES ", db);
+	std::string erased;
+	for (const PlayerSaveRecord* record : records) {
+		if (record->changed.test(PlayerSaveRecord::SECTION_STORAGE)) {
+			continue;
+		}
+
+		for (uint32_t key : record->storageChanges) {
+			auto it = std::lower_bound(record->storage.begin(), record->storage.end(), key,
+			                           [](const auto& row, uint32_t key) { return row.first < key; });
+			if (it != record->storage.end() && it->first == key) {
+				if (!query.addRow("{:d}, {:d}, {:d}", record->guid, key, it->second)) {
+					return false;
+				}
+			} else {
+				if (!erased.empty()) {
+					erased.push_back(',');
+				}
+				erased += fmt::format("({:d}, {:d})", record->guid, key);
 			}
 		}
 	}
 
-	return query_insert.execute();
+	if (!erased.empty() &&
+	    !db.executeQuery(fmt::format("DELETE FROM `player_storage` WHERE (`player_id`, `key`) IN ({:s})", erased))) {
+		return false;
+	}
+	return query.execute();
 }
 
-bool IOLoginData::savePlayer(Player* player)
+/**
+ * Writes a batch of player saves.
+ * Statements are issued per table for the whole batch, so a guid must not appear twice in it.
+ */
+bool writePlayerSaves(Database& db, const std::vector<PlayerSaveRecord>& records)
 {
-	if (player->isDead()) {
-		player->changeHealth(1);
+	if (records.empty()) {
+		return true;
 	}
 
-	Database& db = Database::getInstance();
+	std::vector<const PlayerSaveRecord*> allRecords;
+	allRecords.reserve(records.size());
+	for (const PlayerSaveRecord& record : records) {
+		allRecords.push_back(&record);
+	}
 
+	// characters with `save` = 0 only keep their login data
 	DBResult_ptr result =
-	    db.storeQuery(fmt::format("SELECT `save` FROM `players` WHERE `id` = {:d}", player->getGUID()));
+	    db.storeQuery(fmt::format("SELECT `id`, `save` FROM `players` WHERE `id` IN ({:s})", joinGuids(allRecords)));
 	if (!result) {
 		return false;
 	}
 
-	if (result->getNumber<uint16_t>("save") == 0) {
-		return db.executeQuery(fmt::format("UPDATE `players` SET `lastlogin` = {:d}, `lastip` = {:d} WHERE `id` = {:d}",
-		                                   player->lastLoginSaved, player->lastIP, player->getGUID()));
+	std::set<uint32_t> saved;
+	do {
+		if (result->getNumber<uint16_t>("save") != 0) {
+			saved.insert(result->getNumber<uint32_t>("id"));
+		}
+	} while (result->next());
+
+	bool success = true;
+	std::vector<const PlayerSaveRecord*> savedRecords;
+	for (const PlayerSaveRecord* record : allRecords) {
+		if (saved.contains(record->guid)) {
+			savedRecords.push_back(record);
+		} else if (!db.prepare("UPDATE `players` SET `lastlogin` = ?, `lastip` = ? WHERE `id` = ?")
+		                ->execute(record->lastLoginSaved, record->lastIP, record->guid)) {
+			success = false;
+		}
+	}
+
+	if (savedRecords.empty()) {
+		return success;
+	}
+
+	DBTransaction transaction(db);
+	if (!transaction.begin()) {
+		return false;
+	}
+
+	for (const PlayerSaveRecord* record : savedRecords) {
+		std::string query = "UPDATE `players` SET ";
+		for (const auto& [column, value] : record->columns) {
+			query += fmt::format("`{:s}` = {:d},", column, value);
+		}
+		query += fmt::format("`conditions` = {:s},", db.escapeString(record->conditions));
+		if (record->addOnlineTime) {
+			query += fmt::format("`onlinetime` = `onlinetime` + {:d},", record->onlineTime);
+		}
+		query.pop_back();
+		query += fmt::format(" WHERE `id` = {:d}", record->guid);
+
+		if (!db.executeQuery(query)) {
+			return false;
+		}
+	}
+
+	if (!replaceRows(db, "player_spells", savedRecords, PlayerSaveRecord::SECTION_SPELLS, "INSERT INTO `player_spells` (`player_id`, `name` ) VALUES ",
+	                 [&db](DBInsert& query, const PlayerSaveRecord& record) {
+		                 for (const std::string& spellName : record.spells) {
+			                 if (!query.addRow("{:d}, {:s}", record.guid, DBEscaped{db, spellName})) {
+				                 return false;
+			                 }
+		                 }
+		                 return true;
+	                 })) {
+		return false;
+	}
+
+	if (!replaceRows(
+	        db, "player_items", savedRecords, PlayerSaveRecord::SECTION_ITEMS,
+	        "INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ",
+	        [&db](DBInsert& query, const PlayerSaveRecord& record) {
+		        return addItemRows(db, query, record.guid, record.items);
+	        })) {
+		return false;
+	}
+
+	if (!replaceRows(
+	        db, "player_depotlockeritems", savedRecords, PlayerSaveRecord::SECTION_DEPOT,
+	        "INSERT INTO `player_depotlockeritems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ",
+	        [&db](DBInsert& query, const PlayerSaveRecord& record) {
+		        return addItemRows(db, query, record.guid, record.depotLockerItems);
+	        })) {
+		return false;
+	}
+
+	if (!replaceRows(
+	        db, "player_depotitems", savedRecords, PlayerSaveRecord::SECTION_DEPOT,
+	        "INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ",
+	        [&db](DBInsert& query, const PlayerSaveRecord& record) {
+		        return addItemRows(db, query, record.guid, record.depotItems);
+	        })) {
+		return false;
+	}
+
+	if (!replaceRows(db, "player_storage", savedRecords, PlayerSaveRecord::SECTION_STORAGE,
+	                 "INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ",
+	                 [](DBInsert& query, const PlayerSaveRecord& record) {
+		                 for (const auto& [key, value] : record.storage) {
+			                 if (!query.addRow("{:d}, {:d}, {:d}", record.guid, key, value)) {
+				                 return false;
+			                 }
+		                 }
+		                 return true;
+	                 })) {
+		return false;
+	}
+
+	if (!writeStorageChanges(db, savedRecords)) {
+		return false;
 	}
 
+	if (!replaceRows(db, "player_outfits", savedRecords, PlayerSaveRecord::SECTION_OUTFITS,
+	                 "INSERT INTO `player_outfits` (`player_id`, `outfit_id`, `addons`) VALUES ",
+	                 [](DBInsert& query, const PlayerSaveRecord& record) {
+		                 for (const auto& [lookType, addon] : record.outfits) {
+			                 if (!query.addRow("{:d}, {:d}, {:d}", record.guid, lookType, addon)) {
+				                 return false;
+			                 }
+		                 }
+		                 return true;
+	                 })) {
+		return false;
+	}
+
+	if (!replaceRows(db, "player_mounts", savedRecords, PlayerSaveRecord::SECTION_MOUNTS,
+	                 "INSERT INTO `player_mounts` (`player_id`, `mount_id`) VALUES ",
+	                 [](DBInsert& query, const PlayerSaveRecord& record) {
+		                 for (uint16_t mountId : record.mounts) {
+			                 if (!query.addRow("{:d}, {:d}", record.guid, mountId)) {
+				                 return false;
+			                 }
+		                 }
+		                 return true;
+	                 })) {
+		return false;
+	}
+
+	return transaction.commit() && success;
+}
+
+void finishPlayerSaves(const std::vector<PlayerSaveRecord>& records)
+{
+	{
+		std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+		for (const PlayerSaveRecord& record : records) {
+			auto it = pendingSaves.find(record.guid);
+			if (it != pendingSaves.end() && --it->second == 0) {
+				pendingSaves.erase(it);
+			}
+		}
+	}
+	pendingSavesSignal.notify_all();
+}
+
+} // namespace
+
+PlayerSaveRecord IOLoginData::makeSaveRecord(Player* player)
+{
+	if (player->isDead()) {
+		player->changeHealth(1);
+	}
+
+	player->lastSaveTime = OTSYS_TIME();
+
+	PlayerSaveRecord record;
+	record.guid = player->getGUID();
+	record.lastLoginSaved = player->lastLoginSaved;
+	record.lastIP = player->lastIP;
+
 	// serialize conditions
-	PropWriteStream propWriteStream;
+	thread_local PropWriteStream propWriteStream;
+	propWriteStream.clear();
 	for (Condition* condition : player->conditions) {
 		if (condition->isPersistent() || condition->isConstant()) {
 			condition->serialize(propWriteStream);
 			propWriteStream.write<uint8_t>(CONDITIONATTR_END);
 		}
 	}
-
-	// First, an UPDATE query to write the player itself
-	std::ostringstream query;
-	query << "UPDATE `players` SET ";
-	query << "`level` = " << player->level << ',';
-	query << "`group_id` = " << player->group->id << ',';
-	query << "`vocation` = " << player->getVocationId() << ',';
-	query << "`health` = " << player->health << ',';
-	query << "`healthmax` = " << player->healthMax << ',';
-	query << "`experience` = " << player->experience << ',';
-	query << "`lookbody` = " << static_cast<uint32_t>(player->defaultOutfit.lookBody) << ',';
-	query << "`lookfeet` = " << static_cast<uint32_t>(player->defaultOutfit.lookFeet) << ',';
-	query << "`lookhead` = " << static_cast<uint32_t>(player->defaultOutfit.lookHead) << ',';
-	query << "`looklegs` = " << static_cast<uint32_t>(player->defaultOutfit.lookLegs) << ',';
-	query << "`looktype` = " << player->defaultOutfit.lookType << ',';
-	query << "`lookaddons` = " << static_cast<uint32_t>(player->defaultOutfit.lookAddons) << ',';
-	query << "`currentmount` = " << static_cast<uint16_t>(player->currentMount) << ',';
-	query << "`randomizemount` = " << player->randomizeMount << ",";
-	query << "`maglevel` = " << player->magLevel << ',';
-	query << "`mana` = " << player->mana << ',';
-	query << "`manamax` = " << player->manaMax << ',';
-	query << "`manaspent` = " << player->manaSpent << ',';
-	query << "`soul` = " << static_cast<uint16_t>(player->soul) << ',';
-	query << "`town_id` = " << player->town->getID() << ',';
+	record.conditions = propWriteStream.getStream();
+
+	auto& columns = record.columns;
+	columns.reserve(48);
+	columns.emplace_back("level", player->level);
+	columns.emplace_back("group_id", player->group->id);
+	columns.emplace_back("vocation", player->getVocationId());
+	columns.emplace_back("health", player->health);
+	columns.emplace_back("healthmax", player->healthMax);
+	columns.emplace_back("experience", player->experience);
+	columns.emplace_back("lookbody", player->defaultOutfit.lookBody);
+	columns.emplace_back("lookfeet", player->defaultOutfit.lookFeet);
+	columns.emplace_back("lookhead", player->defaultOutfit.lookHead);
+	columns.emplace_back("looklegs", player->defaultOutfit.lookLegs);
+	columns.emplace_back("looktype", player->defaultOutfit.lookType);
+	columns.emplace_back("lookaddons", player->defaultOutfit.lookAddons);
+	columns.emplace_back("currentmount", player->currentMount);
+	columns.emplace_back("randomizemount", player->randomizeMount);
+	columns.emplace_back("maglevel", player->magLevel);
+	columns.emplace_back("mana", player->mana);
+	columns.emplace_back("manamax", player->manaMax);
+	columns.emplace_back("manaspent", player->manaSpent);
+	columns.emplace_back("soul", player->soul);
+	columns.emplace_back("town_id", player->town->getID());
 
 	const Position& loginPosition = player->getLoginPosition();
-	query << "`posx` = " << loginPosition.getX() << ',';
-	query << "`posy` = " << loginPosition.getY() << ',';
-	query << "`posz` = " << loginPosition.getZ() << ',';
+	columns.emplace_back("posx", loginPosition.getX());
+	columns.emplace_back("posy", loginPosition.getY());
+	columns.emplace_back("posz", loginPosition.getZ());
 
-	query << "`cap` = " << (player->capacity / 100) << ',';
-	query << "`sex` = " << static_cast<uint16_t>(player->sex) << ',';
+	columns.emplace_back("cap", player->capacity / 100);
+	columns.emplace_back("sex", player->sex);
 
 	if (player->lastLoginSaved != 0) {
-		query << "`lastlogin` = " << player->lastLoginSaved << ',';
+		columns.emplace_back("lastlogin", player->lastLoginSaved);
 	}
 
 	if (player->lastIP != 0) {
-		query << "`lastip` = " << player->lastIP << ",";
+		columns.emplace_back("lastip", player->lastIP);
 	}
 
-	query << "`conditions` = " << db.escapeString(propWriteStream.getStream()) << ',';
-
 	if (g_game.getWorldType() != WORLD_TYPE_PVP_ENFORCED) {
 		int64_t skullTime = 0;
 
 		if (player->skullTicks > 0) {
 			skullTime = time(nullptr) + player->skullTicks;
 		}
-		query << "`skulltime` = " << skullTime << ',';
+		columns.emplace_back("skulltime", skullTime);
 
 		Skulls_t skull = SKULL_NONE;
 		if (player->skull == SKULL_RED) {
@@ -742,67 +1365,36 @@ bool IOLoginData::savePlayer(Player* player)
 		} else if (player->skull == SKULL_BLACK) {
 			skull = SKULL_BLACK;
 		}
-		query << "`skull` = " << static_cast<int64_t>(skull) << ',';
-	}
-
-	query << "`lastlogout` = " << player->getLastLogout() << ',';
-	query << "`balance` = " << player->bankBalance << ',';
-	query << "`stamina` = " << player->getStaminaMinutes() << ',';
-
-	query << "`skill_fist` = " << player->skills[SKILL_FIST].level << ',';
-	query << "`skill_fist_tries` = " << player->skills[SKILL_FIST].tries << ',';
-	query << "`skill_club` = " << player->skills[SKILL_CLUB].level << ',';
-	query << "`skill_club_tries` = " << player->skills[SKILL_CLUB].tries << ',';
-	query << "`skill_sword` = " << player->skills[SKILL_SWORD].level << ',';
-	query << "`skill_sword_tries` = " << player->skills[SKILL_SWORD].tries << ',';
-	query << "`skill_axe` = " << player->skills[SKILL_AXE].level << ',';
-	query << "`skill_axe_tries` = " << player->skills[SKILL_AXE].tries << ',';
-	query << "`skill_dist` = " << player->skills[SKILL_DISTANCE].level << ',';
-	query << "`skill_dist_tries` = " << player->skills[SKILL_DISTANCE].tries << ',';
-	query << "`skill_shielding` = " << player->skills[SKILL_SHIELD].level << ',';
-	query << "`skill_shielding_tries` = " << player->skills[SKILL_SHIELD].tries << ',';
-	query << "`skill_fishing` = " << player->skills[SKILL_FISHING].level << ',';
-	query << "`skill_fishing_tries` = " << player->skills[SKILL_FISHING].tries << ',';
-	query << "`direction` = " << static_cast<uint16_t>(player->getDirection()) << ',';
+		columns.emplace_back("skull", skull);
+	}
+
+	columns.emplace_back("lastlogout", player->getLastLogout());
+	columns.emplace_back("balance", player->bankBalance);
+	columns.emplace_back("stamina", player->getStaminaMinutes());
+
+	columns.emplace_back("skill_fist", player->skills[SKILL_FIST].level);
+	columns.emplace_back("skill_fist_tries", player->skills[SKILL_FIST].tries);
+	columns.emplace_back("skill_club", player->skills[SKILL_CLUB].level);
+	columns.emplace_back("skill_club_tries", player->skills[SKILL_CLUB].tries);
+	columns.emplace_back("skill_sword", player->skills[SKILL_SWORD].level);
+	columns.emplace_back("skill_sword_tries", player->skills[SKILL_SWORD].tries);
+	columns.emplace_back("skill_axe", player->skills[SKILL_AXE].level);
+	columns.emplace_back("skill_axe_tries", player->skills[SKILL_AXE].tries);
+	columns.emplace_back("skill_dist", player->skills[SKILL_DISTANCE].level);
+	columns.emplace_back("skill_dist_tries", player->skills[SKILL_DISTANCE].tries);
+	columns.emplace_back("skill_shielding", player->skills[SKILL_SHIELD].level);
+	columns.emplace_back("skill_shielding_tries", player->skills[SKILL_SHIELD].tries);
+	columns.emplace_back("skill_fishing", player->skills[SKILL_FISHING].level);
+	columns.emplace_back("skill_fishing_tries", player->skills[SKILL_FISHING].tries);
+	columns.emplace_back("direction", player->getDirection());
+	columns.emplace_back("blessings", player->blessings.to_ulong());
 
 	if (!player->isOffline()) {
-		query << "`onlinetime` = `onlinetime` + " << (time(nullptr) - player->lastLoginSaved) << ',';
-	}
-	query << "`blessings` = " << player->blessings.to_ulong();
-	query << " WHERE `id` = " << player->getGUID();
-
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
-	}
-
-	if (!db.executeQuery(query.str())) {
-		return false;
-	}
-
-	// learned spells
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_spells` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
-	}
-
-	DBInsert spellsQuery("INSERT INTO `player_spells` (`player_id`, `name` ) VALUES ");
-	for (std::string_view spellName : player->learnedInstantSpellList) {
-		if (!spellsQuery.addRow(fmt::format("{:d}, {:s}", player->getGUID(), db.escapeString(spellName)))) {
-			return false;
-		}
+		record.addOnlineTime = true;
+		record.onlineTime = time(nullptr) - player->lastLoginSaved;
 	}
 
-	if (!spellsQuery.execute()) {
-		return false;
-	}
-
-	// item saving
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_items` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
-	}
-
-	DBInsert itemsQuery(
-	    "INSERT INTO `player_items` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	record.spells.assign(player->learnedInstantSpellList.begin(), player->learnedInstantSpellList.end());
 
 	ItemBlockList itemList;
 	for (int32_t slotId = CONST_SLOT_FIRST; slotId <= CONST_SLOT_LAST; ++slotId) {
@@ -811,31 +1403,17 @@ bool IOLoginData::savePlayer(Player* player)
 			itemList.emplace_back(slotId, item);
 		}
 	}
-
-	if (!saveItems(player, itemList, itemsQuery, propWriteStream)) {
-		return false;
-	}
-
-	// save depot locker items
-	bool needsSave = false;
+	snapshotItems(itemList, record.items);
 
 	for (const auto& it : player->depotLockerMap) {
 		if (it.second->needsSave()) {
-			needsSave = true;
+			record.saveDepot = true;
 			break;
 		}
 	}
 
-	if (needsSave) {
-		if (!db.executeQuery(
-		        fmt::format("DELETE FROM `player_depotlockeritems` WHERE `player_id` = {:d}", player->getGUID()))) {
-			return false;
-		}
-
-		DBInsert lockerQuery(
-		    "INSERT INTO `player_depotlockeritems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
+	if (record.saveDepot) {
 		itemList.clear();
-
 		for (const auto& it : player->depotLockerMap) {
 			for (Item* item : it.second->getItemList()) {
 				if (item->getID() != ITEM_DEPOT) {
@@ -843,86 +1421,170 @@ bool IOLoginData::savePlayer(Player* player)
 				}
 			}
 		}
+		snapshotItems(itemList, record.depotLockerItems);
 
-		if (!saveItems(player, itemList, lockerQuery, propWriteStream)) {
-			return false;
-		}
-
-		// save depot items
-		if (needsSave) {
-			if (!db.executeQuery(
-			        fmt::format("DELETE FROM `player_depotitems` WHERE `player_id` = {:d}", player->getGUID()))) {
-				return false;
+		itemList.clear();
+		for (const auto& it : player->depotChests) {
+			for (Item* item : it.second->getItemList()) {
+				itemList.emplace_back(it.first, item);
 			}
+		}
+		snapshotItems(itemList, record.depotItems);
+	}
 
-			DBInsert depotQuery(
-			    "INSERT INTO `player_depotitems` (`player_id`, `pid`, `sid`, `itemtype`, `count`, `attributes`) VALUES ");
-			itemList.clear();
+	player->getStorageMap().forEach([&record](uint32_t key, int64_t value) { record.storage.emplace_back(key, value); });
+	std::sort(record.storage.begin(), record.storage.end());
+	record.storageChanges = player->takeStorageChanges();
+	record.outfits.assign(player->outfits.begin(), player->outfits.end());
+	record.mounts.assign(player->mounts.begin(), player->mounts.end());
 
-			for (const auto& it : player->depotChests) {
-				for (Item* item : it.second->getItemList()) {
-					itemList.emplace_back(it.first, item);
-				}
-			}
+	hashSections(record);
+	return record;
+}
 
-			if (!saveItems(player, itemList, depotQuery, propWriteStream)) {
-				return false;
-			}
-		}
-	}
+void IOLoginData::resetSaveSections(uint32_t guid)
+{
+	std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+	writtenSections.erase(guid);
+	// the storage is loaded from the database next
+	unsyncedStorage.erase(guid);
+}
 
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_storage` WHERE `player_id` = {:d}", player->getGUID()))) {
+bool IOLoginData::savePlayer(Player* player)
+{
+	// an older queued save must not land after this one
+	flushPlayerSaves();
+	waitForPendingSave(player->getGUID());
+
+	std::vector<PlayerSaveRecord> records;
+	records.push_back(makeSaveRecord(player));
+	if (!writePlayerSaves(Database::getInstance(), records)) {
+		forgetWrittenSections(records);
 		return false;
 	}
+	return true;
+}
 
-	DBInsert storageQuery("INSERT INTO `player_storage` (`player_id`, `key`, `value`) VALUES ");
+void IOLoginData::savePlayerAsync(Player* player)
+{
+	PlayerSaveRecord record = makeSaveRecord(player);
+
+	// a newer record for the same player replaces the queued one
+	auto it = std::find_if(queuedSaves.begin(), queuedSaves.end(),
+	                       [guid = record.guid](const PlayerSaveRecord& queued) { return queued.guid == guid; });
+	if (it != queuedSaves.end()) {
+		// the queued record may have changes this one compares equal against
+		record.changed |= it->changed;
+		record.storageChanges.insert(record.storageChanges.end(), it->storageChanges.begin(),
+		                             it->storageChanges.end());
+		std::sort(record.storageChanges.begin(), record.storageChanges.end());
+		record.storageChanges.erase(std::unique(record.storageChanges.begin(), record.storageChanges.end()),
+		                            record.storageChanges.end());
+		*it = std::move(record);
+		return;
+	}
 
-	for (const auto& [key, value] : player->getStorageMap()) {
-		if (!storageQuery.addRow(fmt::format("{:d}, {:d}, {:d}", player->getGUID(), key, value))) {
-			return false;
-		}
+	if (queuedSaves.empty()) {
+		g_dispatcher.addTask([]() { flushPlayerSaves(); });
 	}
 
-	if (!storageQuery.execute()) {
-		return false;
+	queuedSaves.push_back(std::move(record));
+	if (queuedSaves.size() >= PLAYER_SAVE_BATCH_SIZE) {
+		flushPlayerSaves();
 	}
+}
 
-	// save outfits & addons
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_outfits` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
+void IOLoginData::flushPlayerSaves()
+{
+	if (queuedSaves.empty()) {
+		return;
 	}
 
-	DBInsert outfitQuery("INSERT INTO `player_outfits` (`player_id`, `outfit_id`, `addons`) VALUES ");
+	auto records = std::make_shared<std::vector<PlayerSaveRecord>>(std::move(queuedSaves));
+	queuedSaves.clear();
 
-	for (const auto& [lookType, addon] : player->outfits) {
-		if (!outfitQuery.addRow(fmt::format("{:d}, {:d}, {:d}", player->getGUID(), lookType, addon))) {
-			return false;
+	{
+		std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+		for (const PlayerSaveRecord& record : *records) {
+			++pendingSaves[record.guid];
 		}
 	}
 
-	if (!outfitQuery.execute()) {
-		return false;
+	auto job = [records](Database& db) {
+		if (!writePlayerSaves(db, *records)) {
+			forgetWrittenSections(*records);
+			Logger::log(LOG_ERROR, "IOLoginData::flushPlayerSaves", "Failed to save a batch of {} players.",
+			            records->size());
+		}
+		finishPlayerSaves(*records);
+	};
+
+	if (!g_databaseTasks.addJob(job, DATABASE_KEY_PLAYER_SAVES)) {
+		job(Database::getInstance());
 	}
+}
 
-	// save mounts
-	if (!db.executeQuery(fmt::format("DELETE FROM `player_mounts` WHERE `player_id` = {:d}", player->getGUID()))) {
-		return false;
+void IOLoginData::waitForPendingSave(uint32_t guid)
+{
+	std::unique_lock<std::mutex> lockGuard(pendingSavesLock);
+	pendingSavesSignal.wait(lockGuard, [guid]() {
+		return !pendingSaves.contains(guid) && !pendingOfflineChanges.contains(guid);
+	});
+}
+
+bool IOLoginData::hasPendingSaves()
+{
+	std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+	return !pendingSaves.empty() || !pendingOfflineChanges.empty() || !queuedSaves.empty();
+}
+
+void IOLoginData::updateOfflinePlayer(uint32_t guid, std::function<void(Database&)> job)
+{
+	// an older queued save of the player must not land after the change
+	flushPlayerSaves();
+
+	{
+		std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+		++pendingOfflineChanges[guid];
 	}
 
-	DBInsert mountQuery("INSERT INTO `player_mounts` (`player_id`, `mount_id`) VALUES ");
+	auto change = [guid, job = std::move(job)](Database& db) {
+		job(db);
 
-	for (const auto& it : player->mounts) {
-		if (!mountQuery.addRow(fmt::format("{:d}, {:d}", player->getGUID(), it))) {
-			return false;
+		{
+			std::lock_guard<std::mutex> lockGuard(pendingSavesLock);
+			auto it = pendingOfflineChanges.find(guid);
+			if (it != pendingOfflineChanges.end() && --it->second == 0) {
+				pendingOfflineChanges.erase(it);
+			}
 		}
+		pendingSavesSignal.notify_all();
+	};
+
+	if (!g_databaseTasks.addJob(change, DATABASE_KEY_PLAYER_SAVES)) {
+		change(Database::getInstance());
 	}
+}
 
-	if (!mountQuery.execute()) {
-		return false;
+void IOLoginData::addDepotItems(uint32_t guid, uint32_t depotId, const DepotLocker& locker)
+{
+	ItemBlockList itemList;
+	for (Item* item : locker.getItemList()) {
+		itemList.emplace_back(depotId, item);
+	}
+
+	std::vector<SavedItem> items;
+	snapshotItems(itemList, items);
+	if (items.empty()) {
+		return;
 	}
 
-	// End the transaction
-	return transaction.commit();
+	updateOfflinePlayer(guid, [guid, items = std::move(items)](Database& db) {
+		if (!writeDepotItems(db, guid, items)) {
+			Logger::log(LOG_ERROR, "IOLoginData::addDepotItems", "Could not add {} items to the depot of player {}.",
+			            items.size(), guid);
+		}
+	});
 }
 
 std::string_view IOLoginData::getNameByGuid(uint32_t guid)
@@ -989,31 +1651,38 @@ bool IOLoginData::formatPlayerName(std::string& name)
 void IOLoginData::loadItems(ItemMap& itemMap, DBResult_ptr result)
 {
 	do {
-		uint32_t sid = result->getNumber<uint32_t>("sid");
-		uint32_t pid = result->getNumber<uint32_t>("pid");
-		uint16_t type = result->getNumber<uint16_t>("itemtype");
-		uint16_t count = result->getNumber<uint16_t>("count");
+		loadItem(itemMap, *result);
+	} while (result->next());
+}
 
-		auto attr = result->getString("attributes");
-		PropStream propStream;
-		propStream.init(attr.data(), attr.size());
+void IOLoginData::loadItem(ItemMap& itemMap, const DBResult& result)
+{
+	uint32_t sid = result.getNumber<uint32_t>("sid");
+	uint32_t pid = result.getNumber<uint32_t>("pid");
+	uint16_t type = result.getNumber<uint16_t>("itemtype");
+	uint16_t count = result.getNumber<uint16_t>("count");
 
-		Item* item = Item::CreateItem(type, count);
-		if (item) {
-			if (!item->unserializeAttr(propStream)) {
-				std::cout << "WARNING: Serialize error in IOLoginData::loadItems" << std::endl;
-			}
+	auto attr = result.getString("attributes");
+	PropStream propStream;
+	propStream.init(attr.data(), attr.size());
 
-			std::pair<Item*, uint32_t> pair(item, pid);
-			itemMap[sid] = pair;
+	Item* item = Item::CreateItem(type, count);
+	if (item) {
+		if (!item->unserializeAttr(propStream)) {
+			Logger::log(LOG_WARNING, "IOLoginData::loadItems", "Serialize error.");
 		}
-	} while (result->next());
+
+		std::pair<Item*, uint32_t> pair(item, pid);
+		itemMap[sid] = pair;
+	}
 }
 
 void IOLoginData::increaseBankBalance(uint32_t guid, uint64_t bankBalance)
 {
-	Database::getInstance().executeQuery(
-	    fmt::format("UPDATE `players` SET `balance` = `balance` + {:d} WHERE `id` = {:d}", bankBalance, guid));
+	updateOfflinePlayer(guid, [guid, bankBalance](Database& db) {
+		db.executeQuery(
+		    fmt::format("UPDATE `players` SET `balance` = `balance` + {:d} WHERE `id` = {:d}", bankBalance, guid));
+	});
 }
 
 bool IOLoginData::hasBiddedOnHouse(uint32_t guid)
@@ -1023,32 +1692,19 @@ bool IOLoginData::hasBiddedOnHouse(uint32_t guid)
 	       nullptr;
 }
 
-std::forward_list<VIPEntry> IOLoginData::getVIPEntries(uint32_t accountId)
-{
-	std::forward_list<VIPEntry> entries;
-
-	DBResult_ptr result = Database::getInstance().storeQuery(fmt::format(
-	    "SELECT `player_id`, (SELECT `name` FROM `players` WHERE `id` = `player_id`) AS `name` FROM `account_viplist` WHERE `account_id` = {:d}",
-	    accountId));
-	if (result) {
-		do {
-			entries.emplace_front(result->getNumber<uint32_t>("player_id"), result->getString("name"));
-		} while (result->next());
-	}
-	return entries;
-}
-
+// queued with the player saves, so a later login of the account reads the list after them
 void IOLoginData::addVIPEntry(uint32_t accountId, uint32_t guid)
 {
-	Database& db = Database::getInstance();
-	db.executeQuery(
-	    fmt::format("INSERT INTO `account_viplist` (`account_id`, `player_id`) VALUES ({:d}, {:d})", accountId, guid));
+	g_databaseTasks.addTask(
+	    fmt::format("INSERT INTO `account_viplist` (`account_id`, `player_id`) VALUES ({:d}, {:d})", accountId, guid),
+	    nullptr, false, DATABASE_KEY_PLAYER_SAVES);
 }
 
 void IOLoginData::removeVIPEntry(uint32_t accountId, uint32_t guid)
 {
-	Database::getInstance().executeQuery(
-	    fmt::format("DELETE FROM `account_viplist` WHERE `account_id` = {:d} AND `player_id` = {:d}", accountId, guid));
+	g_databaseTasks.addTask(
+	    fmt::format("DELETE FROM `account_viplist` WHERE `account_id` = {:d} AND `player_id` = {:d}", accountId, guid),
+	    nullptr, false, DATABASE_KEY_PLAYER_SAVES);
 }
 
 void IOLoginData::updatePremiumTime(uint32_t accountId, time_t endTime)
@@ -10,12 +10,53 @@
 
 using ItemBlockList = std::list<std::pair<int32_t, Item*>>;
 
+struct PlayerSaveRecord;
+
+// the rows a player is loaded from, fetched apart from building the player so the queries can run on the database
+// threads
+struct PlayerLoadData
+{
+	// queries that only need the player row and can run side by side
+	enum Section : uint8_t
+	{
+		SECTION_GUILD,
+		SECTION_SPELLS,
+		SECTION_ITEMS,
+		SECTION_STORAGE,
+		SECTION_VIP,
+		SECTION_OUTFITS,
+		SECTION_MOUNTS,
+
+		SECTION_COUNT
+	};
+
+	DBResult_ptr player;
+	uint32_t guid = 0;
+	uint32_t accountId = 0;
+	Account account;
+
+	DBResult_ptr guildMembership;
+	DBResult_ptr guild;
+	DBResult_ptr guildRanks;
+	DBResult_ptr guildWars;
+	DBResult_ptr guildMembers;
+	DBResult_ptr spells;
+	DBResult_ptr items;
+	DBResult_ptr storage;
+	DBResult_ptr vips;
+	DBResult_ptr outfits;
+	DBResult_ptr mounts;
+};
+
 class IOLoginData
 {
 public:
-	static Account loadAccount(uint32_t accno);
+	static Account loadAccount(Database& db, uint32_t accno);
 
-	static bool loginserverAuthentication(std::string_view name, std::string_view password, Account& account);
+	static bool loginserverAuthentication(Database& db, std::string_view name, std::string_view password,
+	                                     Account& account);
+	// drops the character lists kept by loginserverAuthentication
+	static void clearAccountCache();
 	static std::pair<uint32_t, uint32_t> gameworldAuthentication(std::string_view accountName,
 	                                                             std::string_view password,
 	                                                             std::string_view characterName);
@@ -32,16 +73,32 @@ public:
 
 	static bool loadPlayerById(Player* player, uint32_t id);
 	static bool loadPlayerByName(Player* player, std::string_view name);
-	static bool loadPlayer(Player* player, DBResult_ptr result);
+	// fetches the rows on the database threads after the pending saves of the player, then calls back on the
+	// dispatcher with them or nullptr if the player does not exist
+	static void loadPlayerAsync(uint32_t guid, std::function<void(PlayerLoadData*)> callback);
+	static bool loadPlayer(Player* player, PlayerLoadData& data);
+	// reads the depot lockers and chests, done the first time the player uses a depot
+	static void loadDepots(Player* player);
 	static bool savePlayer(Player* player);
+	// snapshots the player now and writes it on the database thread, batched with other queued saves
+	static void savePlayerAsync(Player* player);
+	static void flushPlayerSaves();
+	static void waitForPendingSave(uint32_t guid);
+	static bool hasPendingSaves();
 	static uint32_t getGuidByName(std::string_view name);
 	static bool getGuidByNameEx(uint32_t& guid, bool& specialVip, std::string& name);
 	static std::string_view getNameByGuid(uint32_t guid);
 	static bool formatPlayerName(std::string& name);
+
+	// changes a player that is not online with a few rows instead of loading and saving all of it, the job runs on
+	// the database thread in order with the saves and loads of the player
+	static void updateOfflinePlayer(uint32_t guid, std::function<void(Database&)> job);
+	// the items of locker go in front of the ones in the depot locker depotId, the locker itself is not written
+	static void addDepotItems(uint32_t guid, uint32_t depotId, const DepotLocker& locker);
 	static void increaseBankBalance(uint32_t guid, uint64_t bankBalance);
+
 	static bool hasBiddedOnHouse(uint32_t guid);
 
-	static std::forward_list<VIPEntry> getVIPEntries(uint32_t accountId);
 	static void addVIPEntry(uint32_t accountId, uint32_t guid);
 	static void removeVIPEntry(uint32_t accountId, uint32_t guid);
 
@@ -54,8 +111,13 @@ private:
 	using ItemMap = std::map<uint32_t, std::pair<Item*, uint32_t>>;
 
 	static void loadItems(ItemMap& itemMap, DBResult_ptr result);
-	static bool saveItems(const Player* player, const ItemBlockList& itemList, DBInsert& query_insert,
-	                      PropWriteStream& propWriteStream);
+	static void loadItem(ItemMap& itemMap, const DBResult& result);
+	static bool fetchPlayerRow(Database& db, PlayerLoadData& data);
+	static bool fetchPlayer(Database& db, PlayerLoadData& data);
+	static void fetchPlayerSection(Database& db, PlayerLoadData& data, PlayerLoadData::Section section);
+	static PlayerSaveRecord makeSaveRecord(Player* player);
+	// the rows in the database are what was just loaded, the next save compares against nothing
+	static void resetSaveSections(uint32_t guid);
 };
 
 #endif
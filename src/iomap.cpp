@@ -31,6 +31,191 @@
     |--- OTBM_ITEM_DEF (not implemented)
 */
 
+namespace {
+
+std::string tileError(const DecodedTile& tile, std::string_view error)
+{
+	return fmt::format("[x:{:d}, y:{:d}, z:{:d}] {:s}", tile.x, tile.y, tile.z, error);
+}
+
+// keeps the item for the tile unless it is a moveable item inside a house
+void addDecodedItem(DecodedTileArea& area, DecodedTile& tile, Item* item)
+{
+	if (tile.isHouseTile && item->isMoveable()) {
+		area.warnings.push_back(fmt::format("[Warning - IOMap::loadMap] Moveable item with ID: {:d}, in house: {:d}, "
+		                                    "at position [x: {:d}, y: {:d}, z: {:d}].",
+		                                    item->getID(), tile.houseId, tile.x, tile.y, tile.z));
+		delete item;
+		return;
+	}
+
+	if (item->getItemCount() == 0) {
+		item->setItemCount(1);
+	}
+	tile.items.push_back(item);
+}
+
+// reads the tiles and creates their items, nothing here may touch the map or start decaying
+bool decodeTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, DecodedTileArea& area)
+{
+	PropStream propStream;
+	if (!loader.getProps(tileAreaNode, propStream)) {
+		area.error = "Invalid map node.";
+		return false;
+	}
+
+	OTBM_Destination_coords area_coord;
+	if (!propStream.read(area_coord)) {
+		area.error = "Invalid map node.";
+		return false;
+	}
+
+	uint16_t base_x = area_coord.x;
+	uint16_t base_y = area_coord.y;
+	uint8_t z = area_coord.z;
+
+	area.tiles.reserve(tileAreaNode.children().size());
+	for (auto& tileNode : tileAreaNode.children()) {
+		if (tileNode.type != OTBM_TILE && tileNode.type != OTBM_HOUSETILE) {
+			area.error = "Unknown tile node.";
+			return false;
+		}
+
+		if (!loader.getProps(tileNode, propStream)) {
+			area.error = "Could not read node data.";
+			return false;
+		}
+
+		OTBM_Tile_coords tile_coord;
+		if (!propStream.read(tile_coord)) {
+			area.error = "Could not read tile position.";
+			return false;
+		}
+
+		DecodedTile& tile = area.tiles.emplace_back();
+		tile.x = base_x + tile_coord.x;
+		tile.y = base_y + tile_coord.y;
+		tile.z = z;
+
+		if (tileNode.type == OTBM_HOUSETILE) {
+			if (!propStream.read<uint32_t>(tile.houseId)) {
+				area.error = tileError(tile, "Could not read house id.");
+				return false;
+			}
+			tile.isHouseTile = true;
+		}
+
+		uint8_t attribute;
+		// read tile attributes
+		while (propStream.read<uint8_t>(attribute)) {
+			switch (attribute) {
+				case OTBM_ATTR_TILE_FLAGS: {
+					uint32_t flags;
+					if (!propStream.read<uint32_t>(flags)) {
+						area.error = tileError(tile, "Failed to read tile flags.");
+						return false;
+					}
+
+					if ((flags & OTBM_TILEFLAG_PROTECTIONZONE) != 0) {
+						tile.flags |= TILESTATE_PROTECTIONZONE;
+					} else if ((flags & OTBM_TILEFLAG_NOPVPZONE) != 0) {
+						tile.flags |= TILESTATE_NOPVPZONE;
+					} else if ((flags & OTBM_TILEFLAG_PVPZONE) != 0) {
+						tile.flags |= TILESTATE_PVPZONE;
+					}
+
+					if ((flags & OTBM_TILEFLAG_NOLOGOUT) != 0) {
+						tile.flags |= TILESTATE_NOLOGOUT;
+					}
+					break;
+				}
+
+				case OTBM_ATTR_ITEM: {
+					Item* item = Item::CreateItem(propStream);
+					if (!item) {
+						area.error = tileError(tile, "Failed to create item.");
+						return false;
+					}
+					addDecodedItem(area, tile, item);
+					break;
+				}
+
+				default:
+					area.error = tileError(tile, "Unknown tile attribute.");
+					return false;
+			}
+		}
+
+		for (auto& itemNode : tileNode.children()) {
+			if (itemNode.type != OTBM_ITEM) {
+				area.error = tileError(tile, "Unknown node type.");
+				return false;
+			}
+
+			PropStream stream;
+			if (!loader.getProps(itemNode, stream)) {
+				area.error = "Invalid item node.";
+				return false;
+			}
+
+			Item* item = Item::CreateItem(stream);
+			if (!item) {
+				area.error = tileError(tile, "Failed to create item.");
+				return false;
+			}
+
+			if (!item->unserializeItemNode(loader, itemNode, stream)) {
+				area.error = tileError(tile, fmt::format("Failed to load item {:d}.", item->getID()));
+				delete item;
+				return false;
+			}
+			addDecodedItem(area, tile, item);
+		}
+	}
+	return true;
+}
+
+void decodeTileAreas(OTB::Loader& loader, const std::vector<const OTB::Node*>& nodes,
+                     std::vector<DecodedTileArea>& areas)
+{
+	std::atomic<size_t> nextArea{0};
+	auto decode = [&]() {
+		for (size_t i = nextArea++; i < nodes.size(); i = nextArea++) {
+			try {
+				decodeTileArea(loader, *nodes[i], areas[i]);
+			} catch (const std::exception& e) {
+				areas[i].error = e.what();
+			}
+		}
+	};
+
+	size_t threadCount = std::clamp<size_t>(std::thread::hardware_concurrency(), 1, nodes.size());
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (size_t i = 1; i < threadCount; ++i) {
+		threads.emplace_back(decode);
+	}
+	decode();
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+void freeTileAreas(std::vector<DecodedTileArea>& areas)
+{
+	for (auto& area : areas) {
+		for (auto& tile : area.tiles) {
+			for (Item* item : tile.items) {
+				delete item;
+			}
+		}
+	}
+	areas.clear();
+}
+
+} // namespace
+
 Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t x, uint16_t y, uint8_t z)
 {
 	if (!ground) {
@@ -52,9 +237,25 @@ Tile* IOMap::createTile(Item*& ground, Item* item, uint16_t x, uint16_t y, uint8
 
 bool IOMap::loadMap(Map* map, const std::filesystem::path& fileName)
 {
-	int64_t start = OTSYS_TIME();
+	int64_t start = OTSYS_NANOTIME();
 	try {
-		OTB::Loader loader{fileName.string(), OTB::Identifier{{'O', 'T', 'B', 'M'}}};
+		// the cached node index is opened instead of parsing the map again while the map file is unchanged
+		constexpr OTB::Identifier identifier{{'O', 'T', 'B', 'M'}};
+		bool useCache = g_config[ConfigKeysBoolean::MAP_CACHE];
+		std::string cacheName = fileName.string() + ".cache";
+
+		std::unique_ptr<OTB::Loader> loaderPtr;
+		if (useCache) {
+			loaderPtr = OTB::Loader::openIndex(cacheName, fileName.string(), identifier);
+		}
+		bool writeCache = useCache && !loaderPtr;
+		if (!loaderPtr) {
+			loaderPtr = std::make_unique<OTB::Loader>(fileName.string(), identifier);
+		} else {
+			std::cout << "> Using map cache " << cacheName << '.' << std::endl;
+		}
+
+		OTB::Loader& loader = *loaderPtr;
 		auto& root = loader.parseTree();
 
 		PropStream propStream;
@@ -109,21 +310,20 @@ bool IOMap::loadMap(Map* map, const std::filesystem::path& fileName)
 		map->width = root_header.width;
 		map->height = root_header.height;
 
-		if (root.children.size() != 1 || root.children[0].type != OTBM_MAP_DATA) {
+		if (root.children().size() != 1 || root.children().front().type != OTBM_MAP_DATA) {
 			setLastErrorString("Could not read data node.");
 			return false;
 		}
 
-		auto& mapNode = root.children[0];
+		auto& mapNode = root.children().front();
 		if (!parseMapDataAttributes(loader, mapNode, *map, fileName)) {
 			return false;
 		}
 
-		for (auto& mapDataNode : mapNode.children) {
+		std::vector<const OTB::Node*> tileAreaNodes;
+		for (auto& mapDataNode : mapNode.children()) {
 			if (mapDataNode.type == OTBM_TILE_AREA) {
-				if (!parseTileArea(loader, mapDataNode, *map)) {
-					return false;
-				}
+				tileAreaNodes.push_back(&mapDataNode);
 			} else if (mapDataNode.type == OTBM_TOWNS) {
 				if (!parseTowns(loader, mapDataNode, *map)) {
 					return false;
@@ -137,12 +337,51 @@ bool IOMap::loadMap(Map* map, const std::filesystem::path& fileName)
 				return false;
 			}
 		}
+
+		// items are created on all cores, the tiles are put on the map in file order afterwards
+		int64_t decodeStart = OTSYS_NANOTIME();
+		std::vector<DecodedTileArea> areas(tileAreaNodes.size());
+		if (!tileAreaNodes.empty()) {
+			decodeTileAreas(loader, tileAreaNodes, areas);
+		}
+
+		int64_t placeStart = OTSYS_NANOTIME();
+		shareTileItems = g_config[ConfigKeysBoolean::SHARE_STATIC_TILE_ITEMS];
+		for (auto& area : areas) {
+			if (!area.error.empty()) {
+				setLastErrorString(area.error);
+				freeTileAreas(areas);
+				return false;
+			}
+		}
+
+		for (auto& area : areas) {
+			if (!placeTileArea(area, *map)) {
+				freeTileAreas(areas);
+				return false;
+			}
+		}
+
+		std::cout << fmt::format("> Map tree parsed in {:.3f}s, tiles decoded in {:.3f}s and placed in {:.3f}s.",
+		                         (decodeStart - start) / 1e9, (placeStart - decodeStart) / 1e9,
+		                         (OTSYS_NANOTIME() - placeStart) / 1e9)
+		          << std::endl;
+
+		if (shareTileItems) {
+			std::cout << fmt::format("> Items of {:d} static tiles shared through {:d} stacks.", sharedTiles,
+			                         SharedTileItems::getCount())
+			          << std::endl;
+		}
+
+		if (writeCache && !loader.writeIndex(cacheName, fileName.string())) {
+			std::cout << "[Warning - IOMap::loadMap] Could not write map cache " << cacheName << '.' << std::endl;
+		}
 	} catch (const OTB::InvalidOTBFormat& err) {
 		setLastErrorString(err.what());
 		return false;
 	}
 
-	std::cout << "> Map loading time: " << (OTSYS_TIME() - start) / (1000.) << " seconds." << std::endl;
+	std::cout << "> Map loading time: " << (OTSYS_NANOTIME() - start) / 1e9 << " seconds." << std::endl;
 	return true;
 }
 
@@ -197,190 +436,60 @@ bool IOMap::parseMapDataAttributes(OTB::Loader& loader, const OTB::Node& mapNode
 	return true;
 }
 
-bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Map& map)
+bool IOMap::placeTileArea(DecodedTileArea& area, Map& map)
 {
-	PropStream propStream;
-	if (!loader.getProps(tileAreaNode, propStream)) {
-		setLastErrorString("Invalid map node.");
-		return false;
+	for (auto& warning : area.warnings) {
+		std::cout << warning << std::endl;
 	}
 
-	OTBM_Destination_coords area_coord;
-	if (!propStream.read(area_coord)) {
-		setLastErrorString("Invalid map node.");
-		return false;
-	}
-
-	uint16_t base_x = area_coord.x;
-	uint16_t base_y = area_coord.y;
-	uint16_t z = area_coord.z;
-
-	for (auto& tileNode : tileAreaNode.children) {
-		if (tileNode.type != OTBM_TILE && tileNode.type != OTBM_HOUSETILE) {
-			setLastErrorString("Unknown tile node.");
-			return false;
-		}
-
-		if (!loader.getProps(tileNode, propStream)) {
-			setLastErrorString("Could not read node data.");
-			return false;
-		}
-
-		OTBM_Tile_coords tile_coord;
-		if (!propStream.read(tile_coord)) {
-			setLastErrorString("Could not read tile position.");
-			return false;
-		}
-
-		uint16_t x = base_x + tile_coord.x;
-		uint16_t y = base_y + tile_coord.y;
+	for (auto& decoded : area.tiles) {
+		uint16_t x = decoded.x;
+		uint16_t y = decoded.y;
+		uint8_t z = decoded.z;
 
-		bool isHouseTile = false;
-		House* house = nullptr;
 		Tile* tile = nullptr;
 		Item* ground_item = nullptr;
-		uint32_t tileflags = TILESTATE_NONE;
-
-		if (tileNode.type == OTBM_HOUSETILE) {
-			uint32_t houseId;
-			if (!propStream.read<uint32_t>(houseId)) {
-				setLastErrorString(fmt::format("[x:{:d}, y:{:d}, z:{:d}] Could not read house id.", x, y, z));
-				return false;
-			}
 
-			house = map.houses.addHouse(houseId);
+		if (decoded.isHouseTile) {
+			House* house = map.houses.addHouse(decoded.houseId);
 			if (!house) {
 				setLastErrorString(
-				    fmt::format("[x:{:d}, y:{:d}, z:{:d}] Could not create house id: {:d}", x, y, z, houseId));
+				    fmt::format("[x:{:d}, y:{:d}, z:{:d}] Could not create house id: {:d}", x, y, z, decoded.houseId));
 				return false;
 			}
 
 			tile = new HouseTile(x, y, z, house);
 			house->addTile(static_cast<HouseTile*>(tile));
-			isHouseTile = true;
 		}
 
-		uint8_t attribute;
-		// read tile attributes
-		while (propStream.read<uint8_t>(attribute)) {
-			switch (attribute) {
-				case OTBM_ATTR_TILE_FLAGS: {
-					uint32_t flags;
-					if (!propStream.read<uint32_t>(flags)) {
-						setLastErrorString(fmt::format("[x:{:d}, y:{:d}, z:{:d}] Failed to read tile flags.", x, y, z));
-						return false;
-					}
-
-					if ((flags & OTBM_TILEFLAG_PROTECTIONZONE) != 0) {
-						tileflags |= TILESTATE_PROTECTIONZONE;
-					} else if ((flags & OTBM_TILEFLAG_NOPVPZONE) != 0) {
-						tileflags |= TILESTATE_NOPVPZONE;
-					} else if ((flags & OTBM_TILEFLAG_PVPZONE) != 0) {
-						tileflags |= TILESTATE_PVPZONE;
-					}
-
-					if ((flags & OTBM_TILEFLAG_NOLOGOUT) != 0) {
-						tileflags |= TILESTATE_NOLOGOUT;
-					}
-					break;
-				}
-
-				case OTBM_ATTR_ITEM: {
-					Item* item = Item::CreateItem(propStream);
-					if (!item) {
-						setLastErrorString(fmt::format("[x:{:d}, y:{:d}, z:{:d}] Failed to create item.", x, y, z));
-						return false;
-					}
-
-					if (isHouseTile && item->isMoveable()) {
-						std::cout << "[Warning - IOMap::loadMap] Moveable item with ID: " << item->getID()
-						          << ", in house: " << house->getId() << ", at position [x: " << x << ", y: " << y
-						          << ", z: " << z << "]." << std::endl;
-						delete item;
-					} else {
-						if (item->getItemCount() == 0) {
-							item->setItemCount(1);
-						}
-
-						if (tile) {
-							tile->internalAddThing(item);
-							item->startDecaying();
-							item->setLoadedFromMap(true);
-						} else if (item->isGroundTile()) {
-							delete ground_item;
-							ground_item = item;
-						} else {
-							tile = createTile(ground_item, item, x, y, z);
-							tile->internalAddThing(item);
-							item->startDecaying();
-							item->setLoadedFromMap(true);
-						}
-					}
-					break;
-				}
-
-				default:
-					setLastErrorString(fmt::format("[x:{:d}, y:{:d}, z:{:d}] Unknown tile attribute.", x, y, z));
-					return false;
-			}
-		}
-
-		for (auto& itemNode : tileNode.children) {
-			if (itemNode.type != OTBM_ITEM) {
-				setLastErrorString(fmt::format("[x:{:d}, y:{:d}, z:{:d}] Unknown node type.", x, y, z));
-				return false;
-			}
-
-			PropStream stream;
-			if (!loader.getProps(itemNode, stream)) {
-				setLastErrorString("Invalid item node.");
-				return false;
-			}
-
-			Item* item = Item::CreateItem(stream);
-			if (!item) {
-				setLastErrorString(fmt::format("[x:{:d}, y:{:d}, z:{:d}] Failed to create item.", x, y, z));
-				return false;
-			}
-
-			if (!item->unserializeItemNode(loader, itemNode, stream)) {
-				setLastErrorString(
-				    fmt::format("[x:{:d}, y:{:d}, z:{:d}] Failed to load item {:d}.", x, y, z, item->getID()));
-				delete item;
-				return false;
-			}
-
-			if (isHouseTile && item->isMoveable()) {
-				std::cout << "[Warning - IOMap::loadMap] Moveable item with ID: " << item->getID()
-				          << ", in house: " << house->getId() << ", at position [x: " << x << ", y: " << y
-				          << ", z: " << z << "]." << std::endl;
-				delete item;
+		for (Item*& item : decoded.items) {
+			if (tile) {
+				tile->internalAddThing(item);
+				item->startDecaying();
+				item->setLoadedFromMap(true);
+			} else if (item->isGroundTile()) {
+				delete ground_item;
+				ground_item = item;
 			} else {
-				if (item->getItemCount() == 0) {
-					item->setItemCount(1);
-				}
-
-				if (tile) {
-					tile->internalAddThing(item);
-					item->startDecaying();
-					item->setLoadedFromMap(true);
-				} else if (item->isGroundTile()) {
-					delete ground_item;
-					ground_item = item;
-				} else {
-					tile = createTile(ground_item, item, x, y, z);
-					tile->internalAddThing(item);
-					item->startDecaying();
-					item->setLoadedFromMap(true);
-				}
+				tile = createTile(ground_item, item, x, y, z);
+				tile->internalAddThing(item);
+				item->startDecaying();
+				item->setLoadedFromMap(true);
 			}
+			item = nullptr;
 		}
 
 		if (!tile) {
 			tile = createTile(ground_item, nullptr, x, y, z);
 		}
 
-		tile->setFlag(static_cast<tileflags_t>(tileflags));
+		tile->setFlag(static_cast<tileflags_t>(decoded.flags));
+
+		if (shareTileItems) {
+			if (auto staticTile = dynamic_cast<StaticTile*>(tile); staticTile && staticTile->shareItems()) {
+				++sharedTiles;
+			}
+		}
 
 		map.setTile(x, y, z, tile);
 	}
@@ -389,7 +498,7 @@ bool IOMap::parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Ma
 
 bool IOMap::parseTowns(OTB::Loader& loader, const OTB::Node& townsNode, Map& map)
 {
-	for (auto& townNode : townsNode.children) {
+	for (auto& townNode : townsNode.children()) {
 		PropStream propStream;
 		if (townNode.type != OTBM_TOWN) {
 			setLastErrorString("Unknown town node.");
@@ -435,7 +544,7 @@ bool IOMap::parseTowns(OTB::Loader& loader, const OTB::Node& townsNode, Map& map
 bool IOMap::parseWaypoints(OTB::Loader& loader, const OTB::Node& waypointsNode, Map& map)
 {
 	PropStream propStream;
-	for (auto& node : waypointsNode.children) {
+	for (auto& node : waypointsNode.children()) {
 		if (node.type != OTBM_WAYPOINT) {
 			setLastErrorString("Unknown waypoint node.");
 			return false;
@@ -92,6 +92,25 @@ struct OTBM_Tile_coords
 
 #pragma pack()
 
+// a tile read from the map file whose items are created but not yet placed
+struct DecodedTile
+{
+	std::vector<Item*> items;
+	uint32_t houseId = 0;
+	uint32_t flags = TILESTATE_NONE;
+	uint16_t x = 0;
+	uint16_t y = 0;
+	uint8_t z = 0;
+	bool isHouseTile = false;
+};
+
+struct DecodedTileArea
+{
+	std::vector<DecodedTile> tiles;
+	std::vector<std::string> warnings;
+	std::string error;
+};
+
 class IOMap
 {
 	static Tile* createTile(Item*& ground, Item* item, uint16_t x, uint16_t y, uint8_t z);
@@ -140,8 +159,10 @@ private:
 	                            const std::filesystem::path& fileName);
 	bool parseWaypoints(OTB::Loader& loader, const OTB::Node& waypointsNode, Map& map);
 	bool parseTowns(OTB::Loader& loader, const OTB::Node& townsNode, Map& map);
-	bool parseTileArea(OTB::Loader& loader, const OTB::Node& tileAreaNode, Map& map);
+	bool placeTileArea(DecodedTileArea& area, Map& map);
 	std::string errorString;
+	size_t sharedTiles = 0;
+	bool shareTileItems = false;
 };
 
 #endif
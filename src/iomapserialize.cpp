@@ -6,77 +6,373 @@
 #include "iomapserialize.h"
 
 #include "bed.h"
+#include "databasetasks.h"
+#include "configmanager.h"
 #include "game.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "tasks.h"
+#include "tilecodec.h"
 
+extern ConfigManager g_config;
 extern Game g_game;
 
+// a tile_store blob, decoded on a job worker into items that are not on the map yet
+struct DecodedHouseTile
+{
+	std::string blob;
+	Position position;
+	std::vector<Item*> items;
+	// stationary items change what already is on the tile, they and the items after them load on the main thread
+	size_t mainThreadOffset = 0;
+	uint32_t mainThreadItems = 0;
+	bool valid = false;
+};
+
+namespace {
+
+constexpr size_t HOUSE_TILES_PER_DECODE_JOB = 256;
+
+using DecodedHouseTiles = std::vector<DecodedHouseTile>;
+
+} // namespace
+
 void IOMapSerialize::loadHouseItems(Map* map)
 {
-	int64_t start = OTSYS_TIME();
+	int64_t start = OTSYS_NANOTIME();
 
-	DBResult_ptr result = Database::getInstance().storeQuery("SELECT `data` FROM `tile_store`");
-	if (!result) {
+	auto decodeBatch = [](DecodedHouseTiles& batch) {
+		for (DecodedHouseTile& decoded : batch) {
+			decodeHouseTile(decoded);
+		}
+	};
+
+	// the rows are streamed and the blobs decoded on the job workers meanwhile, a batch at a time
+	std::vector<std::future<DecodedHouseTiles>> decoding;
+	DecodedHouseTiles batch;
+	auto submitBatch = [&]() {
+		auto job = std::make_shared<std::packaged_task<DecodedHouseTiles()>>(
+		    [decodeBatch, batch = std::move(batch)]() mutable {
+			    decodeBatch(batch);
+			    return std::move(batch);
+		    });
+		decoding.push_back(job->get_future());
+		if (!g_jobs.isEnabled() || !g_jobs.addJob([job]() { (*job)(); })) {
+			(*job)();
+		}
+		batch.clear();
+	};
+
+	size_t tiles = 0;
+	Database::getInstance().streamQuery("SELECT `data` FROM `tile_store`", [&](DBResult& result) {
+		batch.emplace_back().blob = result.getString("data");
+		++tiles;
+		if (batch.size() == HOUSE_TILES_PER_DECODE_JOB) {
+			submitBatch();
+		}
+		return true;
+	});
+	if (!batch.empty()) {
+		submitBatch();
+	}
+	const int64_t read = OTSYS_NANOTIME();
+
+	std::vector<DecodedHouseTiles> decoded;
+	decoded.reserve(decoding.size());
+	for (auto& future : decoding) {
+		decoded.push_back(future.get());
+	}
+	const int64_t decodedTime = OTSYS_NANOTIME();
+
+	// in row order, the same as when every blob was loaded on its own
+	for (DecodedHouseTiles& decodedBatch : decoded) {
+		for (DecodedHouseTile& decodedTile : decodedBatch) {
+			attachHouseTile(map, decodedTile);
+		}
+	}
+	const int64_t end = OTSYS_NANOTIME();
+
+	std::cout << fmt::format("> Loaded {:d} house tiles in: {:.3f} s (read {:.3f} s, decode waited {:.3f} s, attach "
+	                         "{:.3f} s)",
+	                         tiles, (end - start) / 1e9, (read - start) / 1e9, (decodedTime - read) / 1e9,
+	                         (end - decodedTime) / 1e9)
+	          << std::endl;
+}
+
+void IOMapSerialize::decodeHouseTile(DecodedHouseTile& decoded)
+{
+	std::string_view attr = decoded.blob;
+	PropWriteStream expanded;
+	if (TileCodec::isCompact(attr)) {
+		if (!TileCodec::expand(attr, expanded)) {
+			std::cout << "[Warning - IOMapSerialize::loadHouseItems] Skipping a damaged compact house tile."
+			          << std::endl;
+			return;
+		}
+		decoded.blob = expanded.getStream();
+		attr = decoded.blob;
+	}
+
+	PropStream propStream;
+	propStream.init(attr.data(), attr.size());
+
+	uint32_t item_count;
+	if (!propStream.read<uint16_t>(decoded.position.x) || !propStream.read<uint16_t>(decoded.position.y) ||
+	    !propStream.read<uint8_t>(decoded.position.z) || !propStream.read<uint32_t>(item_count)) {
 		return;
 	}
+	decoded.valid = true;
 
-	do {
-		auto attr = result->getString("data");
-		PropStream propStream;
-		propStream.init(attr.data(), attr.size());
+	while (item_count > 0) {
+		const size_t offset = attr.size() - propStream.size();
 
-		uint16_t x, y;
-		uint8_t z;
-		if (!propStream.read<uint16_t>(x) || !propStream.read<uint16_t>(y) || !propStream.read<uint8_t>(z)) {
-			continue;
+		Item* item = nullptr;
+		const DecodeResult result = decodeItem(propStream, true, item);
+		if (result == DECODE_MAIN_THREAD) {
+			decoded.mainThreadOffset = offset;
+			decoded.mainThreadItems = item_count;
+			break;
 		}
 
-		Tile* tile = map->getTile(x, y, z);
-		if (!tile) {
-			continue;
+		if (item) {
+			decoded.items.push_back(item);
 		}
+		--item_count;
+	}
 
-		uint32_t item_count;
-		if (!propStream.read<uint32_t>(item_count)) {
-			continue;
+	if (decoded.mainThreadItems == 0) {
+		std::string{}.swap(decoded.blob);
+	}
+}
+
+IOMapSerialize::DecodeResult IOMapSerialize::decodeItem(PropStream& propStream, bool topLevel, Item*& decoded)
+{
+	uint16_t id;
+	if (!propStream.read<uint16_t>(id)) {
+		return DECODE_ERROR;
+	}
+
+	// stationary items are looked up on the tile and beds look up their sleeper when read, both touch the game
+	const ItemType& iType = Item::items[id];
+	if ((topLevel && !iType.moveable && !iType.forceSerialize) || iType.isBed()) {
+		return DECODE_MAIN_THREAD;
+	}
+
+	Item* item = Item::CreateItem(id);
+	if (!item) {
+		return DECODE_OK;
+	}
+
+	if (!item->unserializeAttr(propStream)) {
+		std::cout << "WARNING: Unserialization error in IOMapSerialize::loadItem()" << id << std::endl;
+		delete item;
+		return DECODE_ERROR;
+	}
+
+	if (Container* container = item->getContainer()) {
+		while (container->serializationCount > 0) {
+			Item* child = nullptr;
+			const DecodeResult result = decodeItem(propStream, false, child);
+			if (result != DECODE_OK) {
+				if (result == DECODE_ERROR) {
+					std::cout << "[Warning - IOMapSerialize::loadContainer] Unserialization error for container item: "
+					          << container->getID() << std::endl;
+				}
+				delete item;
+				return result;
+			}
+
+			if (child) {
+				container->internalAddThing(child);
+			}
+			container->serializationCount--;
 		}
 
-		while (item_count--) {
+		uint8_t endAttr;
+		if (!propStream.read<uint8_t>(endAttr) || endAttr != 0) {
+			std::cout << "[Warning - IOMapSerialize::loadContainer] Unserialization error for container item: "
+			          << container->getID() << std::endl;
+			delete item;
+			return DECODE_ERROR;
+		}
+	}
+
+	decoded = item;
+	return DECODE_OK;
+}
+
+void IOMapSerialize::attachHouseTile(Map* map, DecodedHouseTile& decoded)
+{
+	if (!decoded.valid) {
+		return;
+	}
+
+	Tile* tile = map->getTile(decoded.position);
+	if (!tile) {
+		for (Item* item : decoded.items) {
+			delete item;
+		}
+		return;
+	}
+
+	for (Item* item : decoded.items) {
+		tile->internalAddThing(item);
+		item->startDecaying();
+	}
+
+	if (decoded.mainThreadItems != 0) {
+		PropStream propStream;
+		propStream.init(decoded.blob.data() + decoded.mainThreadOffset,
+		                decoded.blob.size() - decoded.mainThreadOffset);
+		while (decoded.mainThreadItems--) {
 			loadItem(propStream, tile);
 		}
-	} while (result->next());
-	std::cout << "> Loaded house items in: " << (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
+	}
 }
 
-bool IOMapSerialize::saveHouseItems()
+struct SerializedHouse
 {
-	int64_t start = OTSYS_TIME();
-	Database& db = Database::getInstance();
+	explicit SerializedHouse(const House* house) : house{house} {}
 
-	// Start the transaction
-	DBTransaction transaction;
+	const House* house;
+	std::vector<std::string> tiles;
+	uint64_t hash = 0xcbf29ce484222325;
+};
+
+namespace {
+
+// houses per serialization thread below which spawning another one is not worth it
+constexpr size_t HOUSES_PER_SERIALIZE_THREAD = 64;
+constexpr size_t MAX_SERIALIZE_THREADS = 8;
+
+// a failed write is tried again this many times
+constexpr uint32_t HOUSE_SAVE_TRIES = 3;
+
+// serialized tile_store content of each house as of its last successful save, dispatcher thread only
+std::map<uint32_t, uint64_t> savedHouseHashes;
+// whether a save of the house items went through since startup, the first one rewrites the whole tile_store
+bool tileStoreCleared = false;
+// house writes queued to the database tasks that did not finish yet
+std::atomic<uint32_t> pendingHouseSaves{0};
+
+struct HouseItemsRecord
+{
+	uint32_t houseId;
+	uint64_t hash;
+	std::vector<std::string> tiles;
+};
+
+struct HouseInfoRecord
+{
+	uint32_t id;
+	uint32_t owner;
+	time_t paidUntil;
+	uint32_t payRentWarnings;
+	std::string name;
+	uint32_t townId;
+	uint32_t rent;
+	size_t size;
+	uint32_t beds;
+	// list id and text of every access list that is not empty
+	std::vector<std::pair<uint32_t, std::string>> lists;
+};
+
+void hashBytes(uint64_t& hash, std::string_view bytes)
+{
+	for (char c : bytes) {
+		hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+	}
+	hash = (hash ^ bytes.size()) * 0x100000001b3;
+}
+
+bool writeHouseItems(Database& db, const std::vector<HouseItemsRecord>& records, bool clearAll, uint64_t& rows)
+{
+	DBTransaction transaction{db};
 	if (!transaction.begin()) {
 		return false;
 	}
 
-	// clear old tile data
-	if (!db.executeQuery("DELETE FROM `tile_store`")) {
+	// clear old tile data, everything on the first save so rows of houses no longer on the map go too
+	if (clearAll) {
+		if (!db.executeQuery("DELETE FROM `tile_store`")) {
+			return false;
+		}
+	} else {
+		std::string houseIds;
+		for (const HouseItemsRecord& record : records) {
+			if (!houseIds.empty()) {
+				houseIds.push_back(',');
+			}
+			houseIds += std::to_string(record.houseId);
+		}
+
+		if (!db.executeQuery(fmt::format("DELETE FROM `tile_store` WHERE `house_id` IN ({:s})", houseIds))) {
+			return false;
+		}
+	}
+
+	DBInsert stmt("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ", db);
+	for (const HouseItemsRecord& record : records) {
+		for (const std::string& attributes : record.tiles) {
+			if (!stmt.addRow("{:d}, {:s}", record.houseId, DBEscaped{db, attributes})) {
+				return false;
+			}
+		}
+	}
+
+	if (!stmt.execute() || !transaction.commit()) {
 		return false;
 	}
 
-	DBInsert stmt("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ");
+	rows = stmt.getRowCount();
+	return true;
+}
 
-	PropWriteStream stream;
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		// save house items
-		House* house = it.second;
-		for (HouseTile* tile : house->getTiles()) {
-			saveTile(stream, tile);
+bool writeHouseInfo(Database& db, const std::vector<HouseInfoRecord>& records, bool allHouses)
+{
+	DBTransaction transaction{db};
+	if (!transaction.begin()) {
+		return false;
+	}
 
-			if (auto attributes = stream.getStream(); !attributes.empty()) {
-				if (!stmt.addRow(fmt::format("{:d}, {:s}", house->getId(), db.escapeString(attributes)))) {
-					return false;
-				}
-				stream.clear();
+	if (allHouses) {
+		if (!db.executeQuery("DELETE FROM `house_lists`")) {
+			return false;
+		}
+	} else {
+		std::string houseIds;
+		for (const HouseInfoRecord& house : records) {
+			if (!houseIds.empty()) {
+				houseIds.push_back(',');
+			}
+			houseIds += std::to_string(house.id);
+		}
+
+		if (!db.executeQuery(fmt::format("DELETE FROM `house_lists` WHERE `house_id` IN ({:s})", houseIds))) {
+			return false;
+		}
+	}
+
+	for (const HouseInfoRecord& house : records) {
+		DBResult_ptr result = db.storeQuery(fmt::format("SELECT `id` FROM `houses` WHERE `id` = {:d}", house.id));
+		if (result) {
+			db.executeQuery(fmt::format(
+			    "UPDATE `houses` SET `owner` = {:d}, `paid` = {:d}, `warnings` = {:d}, `name` = {:s}, `town_id` = {:d}, `rent` = {:d}, `size` = {:d}, `beds` = {:d} WHERE `id` = {:d}",
+			    house.owner, house.paidUntil, house.payRentWarnings, db.escapeString(house.name), house.townId,
+			    house.rent, house.size, house.beds, house.id));
+		} else {
+			db.executeQuery(fmt::format(
+			    "INSERT INTO `houses` (`id`, `owner`, `paid`, `warnings`, `name`, `town_id`, `rent`, `size`, `beds`) VALUES ({:d}, {:d}, {:d}, {:d}, {:s}, {:d}, {:d}, {:d}, {:d})",
+			    house.id, house.owner, house.paidUntil, house.payRentWarnings, db.escapeString(house.name),
+			    house.townId, house.rent, house.size, house.beds));
+		}
+	}
+
+	DBInsert stmt("INSERT INTO `house_lists` (`house_id` , `listid` , `list`) VALUES ", db);
+	for (const HouseInfoRecord& house : records) {
+		for (const auto& [listId, listText] : house.lists) {
+			if (!stmt.addRow("{:d}, {:d}, {:s}", house.id, listId, DBEscaped{db, listText})) {
+				return false;
 			}
 		}
 	}
@@ -85,10 +381,139 @@ bool IOMapSerialize::saveHouseItems()
 		return false;
 	}
 
-	// End the transaction
-	bool success = transaction.commit();
-	std::cout << "> Saved house items in: " << (OTSYS_TIME() - start) / (1000.) << " s" << std::endl;
-	return success;
+	return transaction.commit();
+}
+
+} // namespace
+
+void IOMapSerialize::serializeHouse(SerializedHouse& serialized)
+{
+	// one per serialization thread, kept for the next houses and saves
+	thread_local PropWriteStream stream;
+	stream.clear();
+	const bool compact = g_config[ConfigKeysBoolean::COMPACT_HOUSE_ITEMS];
+	for (HouseTile* tile : serialized.house->getTiles()) {
+		saveTile(stream, tile);
+
+		if (auto attributes = stream.getStream(); !attributes.empty()) {
+			hashBytes(serialized.hash, attributes);
+			if (compact) {
+				serialized.tiles.push_back(TileCodec::compact(attributes).value_or(std::string{attributes}));
+			} else {
+				serialized.tiles.emplace_back(attributes);
+			}
+			stream.clear();
+		}
+	}
+}
+
+bool IOMapSerialize::saveHouseItems()
+{
+	std::vector<const House*> houses;
+	houses.reserve(g_game.map.houses.getHouses().size());
+	for (const auto& it : g_game.map.houses.getHouses()) {
+		houses.push_back(it.second);
+	}
+	return captureHouseItems(houses, true);
+}
+
+bool IOMapSerialize::saveHouseItems(const std::vector<const House*>& houses)
+{
+	if (houses.empty()) {
+		return true;
+	}
+	return captureHouseItems(houses, false);
+}
+
+bool IOMapSerialize::captureHouseItems(const std::vector<const House*>& houseList, bool allHouses)
+{
+	int64_t start = OTSYS_NANOTIME();
+
+	std::vector<SerializedHouse> houses(houseList.begin(), houseList.end());
+
+	// the dispatcher is blocked in here, so the items can be read from other threads
+	const size_t threadCount = std::clamp<size_t>(houses.size() / HOUSES_PER_SERIALIZE_THREAD, 1,
+	                                              std::min<size_t>(MAX_SERIALIZE_THREADS,
+	                                                               std::max(1u, std::thread::hardware_concurrency())));
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (size_t i = 1; i < threadCount; ++i) {
+		threads.emplace_back([&houses, i, threadCount]() {
+			for (size_t index = i; index < houses.size(); index += threadCount) {
+				serializeHouse(houses[index]);
+			}
+		});
+	}
+	for (size_t index = 0; index < houses.size(); index += threadCount) {
+		serializeHouse(houses[index]);
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	auto changed = std::make_shared<std::vector<HouseItemsRecord>>();
+	for (SerializedHouse& serialized : houses) {
+		const uint32_t houseId = serialized.house->getId();
+		auto it = savedHouseHashes.find(houseId);
+		if (it == savedHouseHashes.end() || it->second != serialized.hash) {
+			changed->push_back({houseId, serialized.hash, std::move(serialized.tiles)});
+			if (it != savedHouseHashes.end()) {
+				// a later save writes the house again until this one went through
+				savedHouseHashes.erase(it);
+			}
+		}
+	}
+
+	if (changed->empty()) {
+		if (allHouses) {
+			Logger::log(LOG_INFO, "", "> Saved house items in: {:.3f} s (no changes)",
+			            (OTSYS_NANOTIME() - start) / 1e9);
+		}
+		return true;
+	}
+
+	// the rows of houses no longer on the map only go with a save of every house
+	const int64_t captured = OTSYS_TIME();
+	auto job = [changed, clearAll = allHouses && !tileStoreCleared, allHouses, captured,
+	            houseCount = houses.size()](Database& db) {
+		int64_t written = OTSYS_TIME();
+		bool saved = false;
+		uint64_t rows = 0;
+		for (uint32_t tries = 0; tries < HOUSE_SAVE_TRIES && !saved; ++tries) {
+			saved = writeHouseItems(db, *changed, clearAll, rows);
+		}
+
+		if (saved) {
+			if (allHouses) {
+				Logger::log(LOG_INFO, "",
+				            "> Wrote house items in: {:.3f} s ({:d} of {:d} houses changed, {:d} rows, queued for {:.3f} s)",
+				            (OTSYS_TIME() - written) / 1000., changed->size(), houseCount, rows,
+				            (written - captured) / 1000.);
+			}
+
+			g_dispatcher.addTask([changed, clearAll]() {
+				for (const HouseItemsRecord& record : *changed) {
+					savedHouseHashes[record.houseId] = record.hash;
+				}
+				tileStoreCleared = tileStoreCleared || clearAll;
+			});
+		} else {
+			Logger::log(LOG_ERROR, "IOMapSerialize::saveHouseItems", "Failed to write the items of {:d} houses.",
+			            changed->size());
+		}
+		--pendingHouseSaves;
+	};
+
+	++pendingHouseSaves;
+	if (!g_databaseTasks.addJob(job, DATABASE_KEY_HOUSE_SAVES)) {
+		job(Database::getInstance());
+	}
+
+	if (allHouses) {
+		Logger::log(LOG_INFO, "", "> Captured house items in: {:.3f} s ({:d} of {:d} houses changed)",
+		            (OTSYS_NANOTIME() - start) / 1e9, changed->size(), houses.size());
+	}
+	return true;
 }
 
 bool IOMapSerialize::loadContainer(PropStream& propStream, Container* container)
@@ -281,77 +706,74 @@ bool IOMapSerialize::loadHouseInfo()
 
 bool IOMapSerialize::saveHouseInfo()
 {
-	Database& db = Database::getInstance();
-
-	DBTransaction transaction;
-	if (!transaction.begin()) {
-		return false;
+	std::vector<const House*> houses;
+	houses.reserve(g_game.map.houses.getHouses().size());
+	for (const auto& it : g_game.map.houses.getHouses()) {
+		houses.push_back(it.second);
 	}
+	return captureHouseInfo(houses, true);
+}
 
-	if (!db.executeQuery("DELETE FROM `house_lists`")) {
-		return false;
+bool IOMapSerialize::saveHouseInfo(const std::vector<const House*>& houses)
+{
+	if (houses.empty()) {
+		return true;
 	}
+	return captureHouseInfo(houses, false);
+}
 
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		House* house = it.second;
-		DBResult_ptr result = db.storeQuery(fmt::format("SELECT `id` FROM `houses` WHERE `id` = {:d}", house->getId()));
-		if (result) {
-			db.executeQuery(fmt::format(
-			    "UPDATE `houses` SET `owner` = {:d}, `paid` = {:d}, `warnings` = {:d}, `name` = {:s}, `town_id` = {:d}, `rent` = {:d}, `size` = {:d}, `beds` = {:d} WHERE `id` = {:d}",
-			    house->getOwner(), house->getPaidUntil(), house->getPayRentWarnings(),
-			    db.escapeString(house->getName()), house->getTownId(), house->getRent(), house->getTiles().size(),
-			    house->getBedCount(), house->getId()));
-		} else {
-			db.executeQuery(fmt::format(
-			    "INSERT INTO `houses` (`id`, `owner`, `paid`, `warnings`, `name`, `town_id`, `rent`, `size`, `beds`) VALUES ({:d}, {:d}, {:d}, {:d}, {:s}, {:d}, {:d}, {:d}, {:d})",
-			    house->getId(), house->getOwner(), house->getPaidUntil(), house->getPayRentWarnings(),
-			    db.escapeString(house->getName()), house->getTownId(), house->getRent(), house->getTiles().size(),
-			    house->getBedCount()));
+bool IOMapSerialize::captureHouseInfo(const std::vector<const House*>& houses, bool allHouses)
+{
+	auto records = std::make_shared<std::vector<HouseInfoRecord>>();
+	records->reserve(houses.size());
+	for (const House* house : houses) {
+		HouseInfoRecord& record = records->emplace_back(HouseInfoRecord{
+		    house->getId(), house->getOwner(), house->getPaidUntil(), house->getPayRentWarnings(),
+		    std::string{house->getName()}, house->getTownId(), house->getRent(), house->getTiles().size(),
+		    house->getBedCount(), {}});
+
+		if (auto listText = house->getAccessList(GUEST_LIST).value_or(""); !listText.empty()) {
+			record.lists.emplace_back(tfs::to_underlying(GUEST_LIST), listText);
 		}
-	}
-
-	DBInsert stmt("INSERT INTO `house_lists` (`house_id` , `listid` , `list`) VALUES ");
 
-	for (const auto& it : g_game.map.houses.getHouses()) {
-		House* house = it.second;
-
-		auto listText = house->getAccessList(GUEST_LIST).value_or("");
+		if (auto listText = house->getAccessList(SUBOWNER_LIST).value_or(""); !listText.empty()) {
+			record.lists.emplace_back(tfs::to_underlying(SUBOWNER_LIST), listText);
+		}
 
-		if (!listText.empty()) {
-			if (!stmt.addRow(fmt::format("{:d}, {}, {:s}", house->getId(), tfs::to_underlying(GUEST_LIST),
-			                             db.escapeString(listText)))) {
-				return false;
+		for (const Door* door : house->getDoors()) {
+			if (auto listText = door->getAccessList().value_or(""); !listText.empty()) {
+				record.lists.emplace_back(door->getDoorId(), listText);
 			}
 		}
+	}
 
-		listText = house->getAccessList(SUBOWNER_LIST).value_or("");
-		if (!listText.empty()) {
-			if (!stmt.addRow(fmt::format("{:d}, {}, {:s}", house->getId(), tfs::to_underlying(SUBOWNER_LIST),
-			                             db.escapeString(listText)))) {
-				return false;
-			}
+	auto job = [records, allHouses](Database& db) {
+		bool saved = false;
+		for (uint32_t tries = 0; tries < HOUSE_SAVE_TRIES && !saved; ++tries) {
+			saved = writeHouseInfo(db, *records, allHouses);
 		}
 
-		for (Door* door : house->getDoors()) {
-			listText = door->getAccessList().value_or("");
-			if (!listText.empty()) {
-				if (!stmt.addRow(fmt::format("{:d}, {:d}, {:s}", house->getId(), door->getDoorId(),
-				                             db.escapeString(listText)))) {
-					return false;
-				}
-			}
+		if (!saved) {
+			Logger::log(LOG_ERROR, "IOMapSerialize::saveHouseInfo", "Failed to write the info of {:d} houses.",
+			            records->size());
 		}
-	}
+		--pendingHouseSaves;
+	};
 
-	if (!stmt.execute()) {
-		return false;
+	++pendingHouseSaves;
+	if (!g_databaseTasks.addJob(job, DATABASE_KEY_HOUSE_SAVES)) {
+		job(Database::getInstance());
 	}
-
-	return transaction.commit();
+	return true;
 }
 
 bool IOMapSerialize::saveHouse(const House* house)
 {
+	// the tiles written now must not be overwritten by an older capture still on its way
+	if (pendingHouseSaves != 0) {
+		g_databaseTasks.flush();
+	}
+
 	Database& db = Database::getInstance();
 
 	// Start the transaction
@@ -369,15 +791,11 @@ bool IOMapSerialize::saveHouse(const House* house)
 
 	DBInsert stmt("INSERT INTO `tile_store` (`house_id`, `data`) VALUES ");
 
-	PropWriteStream stream;
-	for (HouseTile* tile : house->getTiles()) {
-		saveTile(stream, tile);
-
-		if (auto attributes = stream.getStream(); attributes.size() > 0) {
-			if (!stmt.addRow(fmt::format("{:d}, {:s}", houseId, db.escapeString(attributes)))) {
-				return false;
-			}
-			stream.clear();
+	SerializedHouse serialized{house};
+	serializeHouse(serialized);
+	for (const std::string& attributes : serialized.tiles) {
+		if (!stmt.addRow("{:d}, {:s}", houseId, DBEscaped{db, attributes})) {
+			return false;
 		}
 	}
 
@@ -386,5 +804,10 @@ bool IOMapSerialize::saveHouse(const House* house)
 	}
 
 	// End the transaction
-	return transaction.commit();
+	if (!transaction.commit()) {
+		return false;
+	}
+
+	savedHouseHashes[houseId] = serialized.hash;
+	return true;
 }
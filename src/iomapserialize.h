@@ -8,19 +8,40 @@
 #include "house.h"
 #include "map.h"
 
+struct DecodedHouseTile;
+struct SerializedHouse;
+
 class IOMapSerialize
 {
 public:
 	static void loadHouseItems(Map* map);
+	// capture the houses and queue the writes to the database tasks
 	static bool saveHouseItems();
 	static bool loadHouseInfo();
 	static bool saveHouseInfo();
+	// the same for some of the houses, what the rolling save writes each step
+	static bool saveHouseItems(const std::vector<const House*>& houses);
+	static bool saveHouseInfo(const std::vector<const House*>& houses);
 
 	static bool saveHouse(const House* house);
 
 private:
+	static bool captureHouseItems(const std::vector<const House*>& houses, bool allHouses);
+	static bool captureHouseInfo(const std::vector<const House*>& houses, bool allHouses);
 	static void saveItem(PropWriteStream& stream, const Item* item);
 	static void saveTile(PropWriteStream& stream, const Tile* tile);
+	static void serializeHouse(SerializedHouse& serialized);
+
+	enum DecodeResult : uint8_t
+	{
+		DECODE_OK,
+		DECODE_ERROR,
+		DECODE_MAIN_THREAD,
+	};
+
+	static void decodeHouseTile(DecodedHouseTile& decoded);
+	static DecodeResult decodeItem(PropStream& propStream, bool topLevel, Item*& decoded);
+	static void attachHouseTile(Map* map, DecodedHouseTile& decoded);
 
 	static bool loadContainer(PropStream& propStream, Container* container);
 	static bool loadItem(PropStream& propStream, Cylinder* parent);
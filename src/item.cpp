@@ -7,7 +7,10 @@
 
 #include "actions.h"
 #include "bed.h"
+#include "combat.h"
 #include "container.h"
+#include "depotchest.h"
+#include "depotlocker.h"
 #include "game.h"
 #include "house.h"
 #include "mailbox.h"
@@ -21,6 +24,131 @@ extern Vocations g_vocations;
 
 Items Item::items;
 
+namespace {
+
+// freed objects of each size kept for reuse, any beyond that go back to the heap
+constexpr size_t ITEM_FREE_LIST_CAPACITY = 16384;
+
+struct ItemSizeClass
+{
+	std::string names;
+	size_t size = 0;
+	boost::lockfree::stack<void*, boost::lockfree::capacity<ITEM_FREE_LIST_CAPACITY>> freeList;
+	std::atomic<uint64_t> allocations{0};
+	std::atomic<uint64_t> reuses{0};
+	std::atomic<uint64_t> releases{0};
+};
+
+struct ItemSizeClasses
+{
+	ItemSizeClasses()
+	{
+		// classes of the same size share a free list
+		for (auto&& [name, size] : std::initializer_list<std::pair<std::string_view, size_t>>{
+		         {"Item", sizeof(Item)},
+		         {"Container", sizeof(Container)},
+		         {"MagicField", sizeof(MagicField)},
+		         {"Teleport", sizeof(Teleport)},
+		         {"Door", sizeof(Door)},
+		         {"BedItem", sizeof(BedItem)},
+		         {"Mailbox", sizeof(Mailbox)},
+		         {"TrashHolder", sizeof(TrashHolder)},
+		         {"DepotLocker", sizeof(DepotLocker)},
+		         {"DepotChest", sizeof(DepotChest)},
+		     }) {
+			if (ItemSizeClass* sizeClass = find(size)) {
+				sizeClass->names += '/';
+				sizeClass->names += name;
+				continue;
+			}
+
+			ItemSizeClass& sizeClass = classes[count++];
+			sizeClass.names = name;
+			sizeClass.size = size;
+		}
+	}
+
+	ItemSizeClass* find(size_t size)
+	{
+		for (size_t i = 0; i < count; ++i) {
+			if (classes[i].size == size) {
+				return &classes[i];
+			}
+		}
+		return nullptr;
+	}
+
+	std::array<ItemSizeClass, 10> classes;
+	size_t count = 0;
+};
+
+ItemSizeClasses& getItemSizeClasses()
+{
+	// never destroyed, items are still freed by global destructors at exit
+	static ItemSizeClasses* sizeClasses = new ItemSizeClasses;
+	return *sizeClasses;
+}
+
+} // namespace
+
+void* Item::operator new(size_t size) { return allocate(size, MEMORY_ITEMS); }
+
+void Item::operator delete(void* p, size_t size) { deallocate(p, size, MEMORY_ITEMS); }
+
+void* Item::allocate(size_t size, MemorySubsystem subsystem)
+{
+	MemoryStats::allocated(subsystem, size);
+
+	ItemSizeClass* sizeClass = getItemSizeClasses().find(size);
+	if (!sizeClass) {
+		return ::operator new(size);
+	}
+
+	sizeClass->allocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* p;
+	if (sizeClass->freeList.pop(p)) {
+		sizeClass->reuses.fetch_add(1, std::memory_order_relaxed);
+		return p;
+	}
+	return ::operator new(size);
+}
+
+void Item::deallocate(void* p, size_t size, MemorySubsystem subsystem)
+{
+	MemoryStats::freed(subsystem, size);
+
+	ItemSizeClass* sizeClass = getItemSizeClasses().find(size);
+	if (!sizeClass) {
+		::operator delete(p);
+		return;
+	}
+
+	sizeClass->releases.fetch_add(1, std::memory_order_relaxed);
+	if (!sizeClass->freeList.bounded_push(p)) {
+		::operator delete(p);
+	}
+}
+
+void Item::logPoolStats()
+{
+	ItemSizeClasses& sizeClasses = getItemSizeClasses();
+	for (size_t i = 0; i < sizeClasses.count; ++i) {
+		const ItemSizeClass& sizeClass = sizeClasses.classes[i];
+		uint64_t allocations = sizeClass.allocations.load(std::memory_order_relaxed);
+		if (allocations == 0) {
+			continue;
+		}
+
+		uint64_t reuses = sizeClass.reuses.load(std::memory_order_relaxed);
+		uint64_t releases = sizeClass.releases.load(std::memory_order_relaxed);
+		std::cout << fmt::format("> Item pool {:s} ({:d} bytes): {:d} allocated, {:d} reused ({:.1f}%), {:d} live",
+		                         sizeClass.names, sizeClass.size, allocations, reuses, reuses * 100. / allocations,
+		                         allocations - std::min(releases, allocations))
+		          << std::endl;
+	}
+}
+
 Item* Item::CreateItem(const uint16_t type, uint16_t count /*= 0*/)
 {
 	Item* newItem = nullptr;
@@ -163,9 +291,7 @@ Item* Item::clone() const
 	if (attributes) {
 		item->attributes.reset(new ItemAttributes(*attributes));
 		if (item->getDuration() > 0) {
-			item->incrementReferenceCounter();
-			item->setDecaying(DECAYING_TRUE);
-			g_game.toDecayItems.push_front(item);
+			g_game.queueDecay(item);
 		}
 	}
 	return item;
@@ -188,6 +314,12 @@ bool Item::equals(const Item* otherItem) const
 		return false;
 	}
 
+	for (const auto& attribute : attributes->intAttributes) {
+		if (attribute.value != otherAttributes->getIntAttr(attribute.type)) {
+			return false;
+		}
+	}
+
 	const auto& attributeList = attributes->attributes;
 	const auto& otherAttributeList = otherAttributes->attributes;
 	for (const auto& attribute : attributeList) {
@@ -199,7 +331,7 @@ bool Item::equals(const Item* otherItem) const
 			}
 		} else {
 			for (const auto& otherAttribute : otherAttributeList) {
-				if (attribute.type == otherAttribute.type && attribute.value.integer != otherAttribute.value.integer) {
+				if (attribute.type == otherAttribute.type && attribute.value.custom != otherAttribute.value.custom) {
 					return false;
 				}
 			}
@@ -926,33 +1058,26 @@ std::string Item::getNameDescription(const ItemType& it, const Item* item /*= nu
 		subType = item->getSubType();
 	}
 
-	std::ostringstream s;
-
-	auto name = (item ? item->getName() : it.name);
-	if (!name.empty()) {
-		if (it.stackable && subType > 1) {
-			if (it.showCount) {
-				s << subType << ' ';
-			}
-
-			s << (item ? item->getPluralName() : it.getPluralName());
-		} else {
-			if (addArticle) {
-				auto article = (item ? item->getArticle() : it.article);
-				if (!article.empty()) {
-					s << article << ' ';
-				}
-			}
+	std::string_view name = (item ? item->getName() : it.name);
+	if (name.empty()) {
+		return fmt::format("{:s}item of type {:d}", addArticle ? "an " : "", it.id);
+	}
 
-			s << name;
+	if (it.stackable && subType > 1) {
+		std::string_view pluralName = (item ? item->getPluralName() : it.getPluralName());
+		if (it.showCount) {
+			return fmt::format("{:d} {:s}", subType, pluralName);
 		}
-	} else {
-		if (addArticle) {
-			s << "an ";
+		return std::string{pluralName};
+	}
+
+	if (addArticle) {
+		std::string_view article = (item ? item->getArticle() : it.article);
+		if (!article.empty()) {
+			return fmt::format("{:s} {:s}", article, name);
 		}
-		s << "item of type " << it.id;
 	}
-	return s.str();
+	return std::string{name};
 }
 
 std::string Item::getNameDescription() const
@@ -963,25 +1088,8 @@ std::string Item::getNameDescription() const
 
 std::string Item::getWeightDescription(const ItemType& it, uint32_t weight, uint32_t count /*= 1*/)
 {
-	std::ostringstream ss;
-	if (it.stackable && count > 1 && it.showCount != 0) {
-		ss << "They weigh ";
-	} else {
-		ss << "It weighs ";
-	}
-
-	if (weight < 10) {
-		ss << "0.0" << weight;
-	} else if (weight < 100) {
-		ss << "0." << weight;
-	} else {
-		std::string weightString = std::to_string(weight);
-		weightString.insert(weightString.end() - 2, '.');
-		ss << weightString;
-	}
-
-	ss << " oz.";
-	return ss.str();
+	std::string_view prefix = (it.stackable && count > 1 && it.showCount != 0) ? "They weigh" : "It weighs";
+	return fmt::format("{:s} {:d}.{:02d} oz.", prefix, weight / 100, weight % 100);
 }
 
 std::string Item::getWeightDescription(uint32_t weight) const
@@ -1119,6 +1227,19 @@ void ItemAttributes::removeAttribute(itemAttrTypes type)
 		return;
 	}
 
+	attributeBits &= ~type;
+	if (isIntAttrType(type)) {
+		if (type == ITEM_ATTRIBUTE_DURATION) {
+			decayDeadline = 0;
+		}
+
+		auto it = std::find_if(intAttributes.begin(), intAttributes.end(),
+		                       [type](const IntAttribute& attribute) { return attribute.type == type; });
+		*it = intAttributes.back();
+		intAttributes.pop_back();
+		return;
+	}
+
 	auto prev_it = attributes.rbegin();
 	if ((*prev_it).type == type) {
 		attributes.pop_back();
@@ -1132,7 +1253,6 @@ void ItemAttributes::removeAttribute(itemAttrTypes type)
 			}
 		}
 	}
-	attributeBits &= ~type;
 }
 
 int64_t ItemAttributes::getIntAttr(itemAttrTypes type) const
@@ -1141,11 +1261,18 @@ int64_t ItemAttributes::getIntAttr(itemAttrTypes type) const
 		return 0;
 	}
 
-	const Attribute* attr = getExistingAttr(type);
-	if (!attr) {
-		return 0;
+	if (type == ITEM_ATTRIBUTE_DURATION && decayDeadline != 0) {
+		return std::max<int64_t>(0, decayDeadline - OTSYS_TIME());
 	}
-	return attr->value.integer;
+
+	if (hasAttribute(type)) {
+		for (const IntAttribute& attribute : intAttributes) {
+			if (attribute.type == type) {
+				return attribute.value;
+			}
+		}
+	}
+	return 0;
 }
 
 void ItemAttributes::setIntAttr(itemAttrTypes type, int64_t value)
@@ -1156,9 +1283,30 @@ void ItemAttributes::setIntAttr(itemAttrTypes type, int64_t value)
 
 	if (type == ITEM_ATTRIBUTE_ATTACK_SPEED && value < 100) {
 		value = 100;
+	} else if (type == ITEM_ATTRIBUTE_DURATION && decayDeadline != 0) {
+		decayDeadline = OTSYS_TIME() + value;
+	} else if (type == ITEM_ATTRIBUTE_DECAYSTATE) {
+		// the duration only counts down while decaying, freeze what is left of it otherwise
+		if (value == DECAYING_TRUE && decayDeadline == 0 && hasAttribute(ITEM_ATTRIBUTE_DURATION)) {
+			decayDeadline = OTSYS_TIME() + getIntAttr(ITEM_ATTRIBUTE_DURATION);
+		} else if (value != DECAYING_TRUE && decayDeadline != 0) {
+			int64_t remaining = getIntAttr(ITEM_ATTRIBUTE_DURATION);
+			decayDeadline = 0;
+			setIntAttr(ITEM_ATTRIBUTE_DURATION, remaining);
+		}
+	}
+
+	if (hasAttribute(type)) {
+		for (IntAttribute& attribute : intAttributes) {
+			if (attribute.type == type) {
+				attribute.value = value;
+				return;
+			}
+		}
 	}
 
-	getAttr(type).value.integer = value;
+	attributeBits |= type;
+	intAttributes.push_back({value, type});
 }
 
 void ItemAttributes::increaseIntAttr(itemAttrTypes type, int64_t value) { setIntAttr(type, getIntAttr(type) + value); }
@@ -7,6 +7,7 @@
 #include "cylinder.h"
 #include "items.h"
 #include "luascript.h"
+#include "memorystats.h"
 #include "thing.h"
 
 class BedItem;
@@ -198,7 +199,7 @@ public:
 
 			void operator()(const boost::blank&) const {}
 
-			void operator()(std::string_view v) const { propWriteStream.writeString(v); }
+			void operator()(const std::string& v) const { propWriteStream.writeString(v); }
 
 			template <typename T>
 			void operator()(const T& v) const
@@ -279,11 +280,18 @@ private:
 
 	using CustomAttributeMap = std::unordered_map<std::string, CustomAttribute>;
 
+	// integer attributes are kept inline, the first few without any allocation of their own
+	struct IntAttribute
+	{
+		int64_t value;
+		itemAttrTypes type;
+	};
+
+	// string and custom attributes, which own their heap allocated value
 	struct Attribute
 	{
 		union Value
 		{
-			int64_t integer;
 			std::string* string;
 			CustomAttributeMap* custom;
 		};
@@ -295,9 +303,7 @@ private:
 		Attribute(const Attribute& i)
 		{
 			type = i.type;
-			if (ItemAttributes::isIntAttrType(type)) {
-				value.integer = i.value.integer;
-			} else if (ItemAttributes::isStrAttrType(type)) {
+			if (ItemAttributes::isStrAttrType(type)) {
 				value.string = new std::string(*i.value.string);
 			} else if (ItemAttributes::isCustomAttrType(type)) {
 				value.custom = new CustomAttributeMap(*i.value.custom);
@@ -348,11 +354,25 @@ private:
 		}
 	};
 
+	boost::container::small_vector<IntAttribute, 3> intAttributes;
 	std::vector<Attribute> attributes;
 	uint32_t attributeBits = 0;
 
-	std::map<CombatType_t, Reflect> reflect;
-	std::map<CombatType_t, uint16_t> boostPercent;
+	// while decaying the duration counts down against this absolute time (OTSYS_TIME), otherwise 0
+	int64_t decayDeadline = 0;
+
+	// deadline of the live entry in the game decay queue, which is never inherited by a copy
+	struct QueuedDecay
+	{
+		QueuedDecay() = default;
+		QueuedDecay(const QueuedDecay&) {}
+		QueuedDecay& operator=(const QueuedDecay&) { return *this; }
+
+		int64_t deadline = 0;
+	} queuedDecay;
+
+	boost::container::flat_map<CombatType_t, Reflect> reflect;
+	boost::container::flat_map<CombatType_t, uint16_t> boostPercent;
 
 	const Reflect& getReflect(CombatType_t combatType)
 	{
@@ -471,8 +491,6 @@ public:
 	static bool isStrAttrType(itemAttrTypes type) { return (type & stringAttributeTypes) == type; }
 	inline static bool isCustomAttrType(itemAttrTypes type) { return (type & ITEM_ATTRIBUTE_CUSTOM) == type; }
 
-	const std::vector<Attribute>& getList() const { return attributes; }
-
 	friend class Item;
 };
 
@@ -492,6 +510,11 @@ public:
 
 	virtual ~Item() = default;
 
+	// items and the common item classes are recycled through free lists kept per object size
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+	static void logPoolStats();
+
 	// non-assignable
 	Item& operator=(const Item&) = delete;
 
@@ -681,6 +704,9 @@ public:
 		}
 		return static_cast<ItemDecayState_t>(getIntAttr(ITEM_ATTRIBUTE_DECAYSTATE));
 	}
+	int64_t getDecayDeadline() const { return attributes ? attributes->decayDeadline : 0; }
+	int64_t getQueuedDecay() const { return attributes ? attributes->queuedDecay.deadline : 0; }
+	void setQueuedDecay(int64_t deadline) { getAttributes()->queuedDecay.deadline = deadline; }
 
 	int32_t getDecayTimeMin() const
 	{
@@ -890,6 +916,7 @@ public:
 	virtual void startDecaying();
 
 	bool isLoadedFromMap() const { return loadedFromMap; }
+	bool hasAttributes() const { return attributes != nullptr; }
 	void setLoadedFromMap(bool value) { loadedFromMap = value; }
 	bool isCleanable() const
 	{
@@ -922,6 +949,10 @@ public:
 	bool isRemoved() const override { return !parent || parent->isRemoved(); }
 
 protected:
+	// the item pool, accounting the memory to the given subsystem
+	static void* allocate(size_t size, MemorySubsystem subsystem);
+	static void deallocate(void* p, size_t size, MemorySubsystem subsystem);
+
 	Cylinder* parent = nullptr;
 
 	uint16_t id; // the same id as in ItemType
@@ -941,6 +972,5 @@ private:
 };
 
 using ItemList = std::list<Item*>;
-using ItemDeque = std::deque<Item*>;
 
 #endif
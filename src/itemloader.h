@@ -6,7 +6,7 @@
 
 #include "fileloader.h"
 
-enum itemgroup_t
+enum itemgroup_t : uint8_t
 {
 	ITEM_GROUP_NONE,
 
@@ -305,8 +305,28 @@ Direction getDirection(std::string_view string)
 	return DIRECTION_NORTH;
 }
 
+// never shrinks, item types keep pointing into it across reloads and set names from scripts at runtime
+std::mutex internedStringsLock;
+std::set<std::string, std::less<>> internedStrings;
+
 } // namespace
 
+InternedString& InternedString::operator=(std::string_view value)
+{
+	if (value.empty()) {
+		this->value = {};
+		return *this;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(internedStringsLock);
+	auto it = internedStrings.find(value);
+	if (it == internedStrings.end()) {
+		it = internedStrings.emplace(value).first;
+	}
+	this->value = *it;
+	return *this;
+}
+
 Items::Items()
 {
 	items.reserve(30000);
@@ -324,18 +344,36 @@ void Items::clear()
 
 bool Items::reload()
 {
-	clear();
-	loadFromOtb("data/items/items.otb");
-
-	if (!loadFromXml()) {
+	Items loaded;
+	if (!loaded.load()) {
 		return false;
 	}
 
+	swap(loaded);
+	reloadScripts();
+	return true;
+}
+
+bool Items::load() { return loadFromOtb("data/items/items.otb") && loadFromXml(); }
+
+void Items::swap(Items& other)
+{
+	std::swap(majorVersion, other.majorVersion);
+	std::swap(minorVersion, other.minorVersion);
+	std::swap(buildNumber, other.buildNumber);
+	nameToItems.swap(other.nameToItems);
+	currencyItems.swap(other.currencyItems);
+	items.swap(other.items);
+	inventory.swap(other.inventory);
+	std::swap(clientIdToServerIdMap, other.clientIdToServerIdMap);
+}
+
+void Items::reloadScripts()
+{
 	g_scripts->loadScripts("items", false, true);
 	g_moveEvents->reload();
 	g_weapons->reload();
 	g_weapons->loadDefaults();
-	return true;
 }
 
 constexpr auto OTBI = OTB::Identifier{{'O', 'T', 'B', 'I'}};
@@ -392,7 +430,7 @@ bool Items::loadFromOtb(const std::string& file)
 		return false;
 	}
 
-	for (auto& itemNode : root.children) {
+	for (auto& itemNode : root.children()) {
 		PropStream stream;
 		if (!loader.getProps(itemNode, stream)) {
 			return false;
@@ -634,7 +672,7 @@ void Items::parseItemNode(const pugi::xml_node& itemNode, uint16_t id)
 	it.name = itemNode.attribute("name").as_string();
 
 	if (!it.name.empty()) {
-		std::string lowerCaseName = boost::algorithm::to_lower_copy(it.name);
+		std::string lowerCaseName = boost::algorithm::to_lower_copy(std::string{it.name});
 		if (nameToItems.find(lowerCaseName) == nameToItems.end()) {
 			nameToItems.emplace(std::move(lowerCaseName), id);
 		}
@@ -1960,13 +1998,13 @@ const ItemType& Items::getItemIdByClientId(uint16_t spriteId) const
 	return items.front();
 }
 
-uint16_t Items::getItemIdByName(const std::string& name)
+uint16_t Items::getItemIdByName(std::string_view name)
 {
 	if (name.empty()) {
 		return 0;
 	}
 
-	auto result = nameToItems.find(boost::algorithm::to_lower_copy<std::string>(name));
+	auto result = nameToItems.find(name);
 	if (result == nameToItems.end()) return 0;
 
 	return result->second;
@@ -1984,12 +2022,12 @@ std::string_view ItemType::getPluralName() const
 		return name;
 	}
 
-	if (name.empty() || name.back() == 's') {
+	if (name.empty() || std::string_view{name}.back() == 's') {
 		return name;
 	}
 
 	pluralString.reserve(name.size() + 1);
-	pluralString.assign(name);
+	pluralString.assign(std::string_view{name});
 	pluralString.push_back('s');
 	return pluralString;
 }
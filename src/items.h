@@ -8,6 +8,7 @@
 #include "enums.h"
 #include "itemloader.h"
 #include "position.h"
+#include "tools.h"
 
 enum SlotPositionBits : uint32_t
 {
@@ -27,7 +28,7 @@ enum SlotPositionBits : uint32_t
 	SLOTP_HAND = (SLOTP_LEFT | SLOTP_RIGHT)
 };
 
-enum ItemTypes_t
+enum ItemTypes_t : uint8_t
 {
 	ITEM_TYPE_NONE,
 	ITEM_TYPE_DEPOT,
@@ -268,6 +269,33 @@ struct Abilities
 
 class ConditionDamage;
 
+// a string stored once in a table shared by all item types and never freed
+class InternedString
+{
+public:
+	InternedString& operator=(std::string_view value);
+
+	operator std::string_view() const { return value; }
+
+	bool empty() const { return value.empty(); }
+	size_t size() const { return value.size(); }
+
+	friend std::ostream& operator<<(std::ostream& os, const InternedString& str) { return os << str.value; }
+
+private:
+	std::string_view value;
+};
+
+template <>
+struct fmt::formatter<InternedString> : fmt::formatter<std::string_view>
+{
+	template <typename FormatContext>
+	auto format(const InternedString& str, FormatContext& ctx) const
+	{
+		return fmt::formatter<std::string_view>::format(str, ctx);
+	}
+};
+
 class ItemType
 {
 public:
@@ -309,24 +337,47 @@ public:
 
 	std::string_view getPluralName() const;
 
-	itemgroup_t group = ITEM_GROUP_NONE;
-	ItemTypes_t type = ITEM_TYPE_NONE;
+	// hot properties checked on every tile and path lookup, kept together at the front
+	uint32_t weight = 0;
 	uint16_t id = 0;
 	uint16_t clientId = 0;
+	uint16_t speed = 0;
+	itemgroup_t group = ITEM_GROUP_NONE;
+	ItemTypes_t type = ITEM_TYPE_NONE;
+	uint8_t floorChange = 0;
+	uint8_t alwaysOnTopOrder = 0;
+	uint8_t lightLevel = 0;
+	uint8_t lightColor = 0;
 	bool stackable = false;
+	bool alwaysOnTop = false;
+	bool hasHeight = false;
+	bool walkStack = true;
+	bool blockSolid = false;
+	bool blockPickupable = false;
+	bool blockProjectile = false;
+	bool blockPathFind = false;
+	bool allowPickupable = false;
+	bool pickupable = false;
+	bool moveable = false;
+	bool useable = false;
+	bool forceUse = false;
+	bool isVertical = false;
+	bool isHorizontal = false;
+	bool isHangable = false;
+	bool replaceable = true;
+	bool lookThrough = false;
 
-	std::string name;
-	std::string article;
-	std::string pluralName;
-	std::string description;
-	std::string runeSpellName;
-	std::string vocationString;
+	InternedString name;
+	InternedString article;
+	InternedString pluralName;
+	InternedString description;
+	InternedString runeSpellName;
+	InternedString vocationString;
 
 	std::unique_ptr<Abilities> abilities;
 	std::unique_ptr<ConditionDamage> conditionDamage;
 
 	uint32_t attackSpeed = 0;
-	uint32_t weight = 0;
 	uint32_t levelDoor = 0;
 	uint32_t decayTimeMin = 0;
 	uint32_t decayTimeMax = 0;
@@ -356,7 +407,6 @@ public:
 	uint16_t transformDeEquipTo = 0;
 	uint16_t maxItems = 8;
 	uint16_t slotPosition = SLOTP_HAND;
-	uint16_t speed = 0;
 	uint16_t wareId = 0;
 
 	MagicEffectClasses magicEffect = CONST_ME_NONE;
@@ -368,39 +418,18 @@ public:
 	FluidTypes_t fluidSource = FLUID_NONE;
 
 	uint8_t stackSize = 100;
-	uint8_t floorChange = 0;
-	uint8_t alwaysOnTopOrder = 0;
-	uint8_t lightLevel = 0;
-	uint8_t lightColor = 0;
 	uint8_t shootRange = 1;
 	int8_t hitChance = 0;
 
 	bool storeItem = false;
-	bool forceUse = false;
 	bool forceSerialize = false;
-	bool hasHeight = false;
-	bool walkStack = true;
-	bool blockSolid = false;
-	bool blockPickupable = false;
-	bool blockProjectile = false;
-	bool blockPathFind = false;
-	bool allowPickupable = false;
 	bool showDuration = false;
 	bool showCharges = false;
 	bool showAttributes = false;
-	bool replaceable = true;
-	bool pickupable = false;
 	bool rotatable = false;
-	bool useable = false;
-	bool moveable = false;
-	bool alwaysOnTop = false;
 	bool canReadText = false;
 	bool canWriteText = false;
-	bool isVertical = false;
-	bool isHorizontal = false;
-	bool isHangable = false;
 	bool allowDistRead = false;
-	bool lookThrough = false;
 	bool isAnimation = false;
 	bool stopTime = false;
 	bool showCount = true;
@@ -413,7 +442,8 @@ private:
 class Items
 {
 public:
-	using NameMap = std::unordered_map<std::string, uint16_t>;
+	// keyed by lower case name, looked up ignoring case
+	using NameMap = std::unordered_map<std::string, uint16_t, CaseInsensitiveHash, CaseInsensitiveEqual>;
 	using InventoryVector = std::vector<uint16_t>;
 
 	using CurrencyMap = std::map<uint64_t, uint16_t, std::greater<uint64_t>>;
@@ -427,6 +457,13 @@ public:
 	bool reload();
 	void clear();
 
+	// loads items.otb and items.xml into an empty instance, touching nothing else, so any thread may do it
+	bool load();
+	// exchanges the types with other, a reload swaps in a loaded instance and other keeps the old types to retire
+	void swap(Items& other);
+	// the scripts and events bound to item ids, loaded again once new types were swapped in
+	static void reloadScripts();
+
 	bool loadFromOtb(const std::string& file);
 
 	const ItemType& operator[](size_t id) const { return getItemType(id); }
@@ -434,7 +471,7 @@ public:
 	ItemType& getItemType(size_t id);
 	const ItemType& getItemIdByClientId(uint16_t spriteId) const;
 
-	uint16_t getItemIdByName(const std::string& name);
+	uint16_t getItemIdByName(std::string_view name);
 
 	uint32_t majorVersion = 0;
 	uint32_t minorVersion = 0;
@@ -0,0 +1,172 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "jobsystem.h"
+
+#include "tasks.h"
+#include "threadregistry.h"
+
+#include <latch>
+
+extern Dispatcher g_dispatcher;
+
+namespace {
+
+constexpr size_t NOT_A_WORKER = std::numeric_limits<size_t>::max();
+
+thread_local size_t currentWorker = NOT_A_WORKER;
+
+} // namespace
+
+void JobSystem::start(size_t threadCount)
+{
+	{
+		std::lock_guard<std::mutex> lockGuard(sleepLock);
+		running = true;
+	}
+
+	workers.reserve(threadCount);
+	for (size_t i = 0; i < threadCount; ++i) {
+		workers.emplace_back(std::make_unique<Worker>());
+	}
+
+	// every queue exists before the first worker looks for something to steal
+	for (size_t i = 0; i < threadCount; ++i) {
+		workers[i]->thread = std::thread(&JobSystem::threadMain, this, i);
+	}
+}
+
+void JobSystem::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lockGuard(sleepLock);
+		running = false;
+		for (auto& worker : workers) {
+			std::lock_guard<std::mutex> workerGuard(worker->lock);
+			worker->jobs.clear();
+		}
+		pending = 0;
+	}
+	sleepSignal.notify_all();
+}
+
+void JobSystem::join()
+{
+	for (auto& worker : workers) {
+		if (worker->thread.joinable()) {
+			worker->thread.join();
+		}
+	}
+}
+
+bool JobSystem::addJob(Job&& job)
+{
+	{
+		std::lock_guard<std::mutex> lockGuard(sleepLock);
+		if (!running || workers.empty()) {
+			return false;
+		}
+
+		const size_t index = currentWorker != NOT_A_WORKER ? currentWorker : nextWorker++ % workers.size();
+		Worker& worker = *workers[index];
+		{
+			std::lock_guard<std::mutex> workerGuard(worker.lock);
+			worker.jobs.push_back(std::move(job));
+		}
+		++pending;
+	}
+	sleepSignal.notify_one();
+	return true;
+}
+
+void JobSystem::parallelFor(size_t count, const std::function<void(size_t)>& work)
+{
+	if (count == 0) {
+		return;
+	}
+
+	// whoever comes first runs the next index, the caller takes back what no worker got to and only waits for the
+	// indexes still running, a helper starting late finds nothing left and never touches work
+	struct Indexes
+	{
+		Indexes(size_t count, const std::function<void(size_t)>& work) :
+		    work{work}, count{count}, done{static_cast<std::ptrdiff_t>(count)}
+		{}
+
+		const std::function<void(size_t)>& work;
+		const size_t count;
+		std::atomic<size_t> next{0};
+		std::latch done;
+	};
+
+	auto indexes = std::make_shared<Indexes>(count, work);
+	auto run = [indexes]() {
+		for (size_t i; (i = indexes->next++) < indexes->count;) {
+			indexes->work(i);
+			indexes->done.count_down();
+		}
+	};
+
+	const size_t helpers = std::min(count - 1, workers.size());
+	for (size_t i = 0; i < helpers; ++i) {
+		if (!addJob(run)) {
+			break;
+		}
+	}
+
+	run();
+	indexes->done.wait();
+}
+
+void JobSystem::threadMain(size_t index)
+{
+	ThreadRegistration registration{THREAD_ROLE_JOB};
+	currentWorker = index;
+
+	Job job;
+	while (true) {
+		if (takeJob(index, job)) {
+			job();
+			job = nullptr;
+			continue;
+		}
+
+		std::unique_lock<std::mutex> sleepLockUnique(sleepLock);
+		sleepSignal.wait(sleepLockUnique, [this]() { return !running || pending > 0; });
+		if (!running) {
+			break;
+		}
+	}
+}
+
+bool JobSystem::takeJob(size_t index, Job& job)
+{
+	// the newest job of its own queue, it most likely still has what the job needs in cache
+	{
+		Worker& worker = *workers[index];
+		std::lock_guard<std::mutex> workerGuard(worker.lock);
+		if (!worker.jobs.empty()) {
+			job = std::move(worker.jobs.back());
+			worker.jobs.pop_back();
+			--pending;
+			return true;
+		}
+	}
+
+	// the oldest job of another queue
+	for (size_t i = 1; i < workers.size(); ++i) {
+		Worker& victim = *workers[(index + i) % workers.size()];
+		std::lock_guard<std::mutex> workerGuard(victim.lock);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			--pending;
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::complete(std::function<void()>&& done) { g_dispatcher.addTask(std::move(done)); }
@@ -0,0 +1,71 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_JOBSYSTEM_H
+#define FS_JOBSYSTEM_H
+
+#include <condition_variable>
+
+/*
+ * Worker threads for side-effect-free work such as path searches on PathSnapshots and async Lua. Each worker has a
+ * queue of its own, jobs added from a worker stay on its queue and idle workers steal from the others. Jobs only
+ * read the world while the game thread waits for them, anything else goes back through g_dispatcher.
+ */
+class JobSystem
+{
+public:
+	using Job = std::function<void()>;
+
+	JobSystem() = default;
+
+	// non-copyable
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	void start(size_t threadCount);
+	void shutdown();
+	void join();
+
+	// without workers every search stays synchronous on the game thread
+	bool isEnabled() const { return !workers.empty(); }
+	size_t getThreadCount() const { return workers.size(); }
+
+	// false once shut down, the job is dropped then
+	bool addJob(Job&& job);
+
+	// runs job on a worker, then done with its result on the dispatcher
+	template <typename Work, typename Done>
+	bool addJob(Work&& work, Done&& done)
+	{
+		return addJob([work = std::forward<Work>(work), done = std::forward<Done>(done)]() mutable {
+			complete([result = work(), done = std::move(done)]() mutable { done(std::move(result)); });
+		});
+	}
+
+	// runs work(0) to work(count - 1) on the workers and the calling thread, returns once all of them ran
+	void parallelFor(size_t count, const std::function<void(size_t)>& work);
+
+private:
+	struct Worker
+	{
+		std::deque<Job> jobs;
+		std::mutex lock;
+		std::thread thread;
+	};
+
+	void threadMain(size_t index);
+	bool takeJob(size_t index, Job& job);
+	static void complete(std::function<void()>&& done);
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::mutex sleepLock;
+	std::condition_variable sleepSignal;
+	// jobs queued on any worker, workers sleep while it is 0
+	std::atomic<size_t> pending{0};
+	std::atomic<size_t> nextWorker{0};
+	bool running = false;
+};
+
+extern JobSystem g_jobs;
+
+#endif // FS_JOBSYSTEM_H
@@ -0,0 +1,583 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "../otpch.h"
+
+#include "botclient.h"
+
+#include "../enums.h"
+#include "../position.h"
+#include "../rsa.h"
+#include "../tools.h"
+
+namespace {
+
+constexpr size_t RSA_BLOCK_SIZE = 128;
+// seconds between two pongs, the server kicks players that stop answering its pings
+constexpr auto KEEPALIVE_INTERVAL = std::chrono::seconds(10);
+// CONST_SLOT_BACKPACK, inventory items are addressed as x 0xFFFF and the slot as y
+constexpr uint16_t BACKPACK_SLOT = 3;
+// failures beyond this many are only counted
+constexpr uint32_t MAX_REPORTED_FAILURES = 10;
+
+constexpr std::array<std::string_view, 6> PHRASES = {
+    "hi", "anyone going to the dragon lair?", "selling a few rope", "exura", "brb", "how do I get to the boat?",
+};
+
+std::chrono::milliseconds jitter(Xoshiro256& generator, uint32_t interval)
+{
+	// somewhere between half and one and a half interval, so the bots do not act in lockstep
+	return std::chrono::milliseconds(interval / 2 + generator.bounded(interval + 1));
+}
+
+} // namespace
+
+bool parseBotProfile(std::string_view name, BotProfile& profile)
+{
+	static constexpr std::array<std::pair<std::string_view, BotProfile>, 6> profiles = {{
+	    {"idle", BOT_PROFILE_IDLE},
+	    {"walker", BOT_PROFILE_WALKER},
+	    {"talker", BOT_PROFILE_TALKER},
+	    {"fighter", BOT_PROFILE_FIGHTER},
+	    {"user", BOT_PROFILE_USER},
+	    {"mixed", BOT_PROFILE_MIXED},
+	}};
+
+	for (const auto& [profileName, value] : profiles) {
+		if (profileName == name) {
+			profile = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+BotClient::BotClient(boost::asio::io_context& io, LoadTestContext& context, uint32_t number) :
+    context{context},
+    socket{io},
+    actionTimer{io},
+    probeTimer{io},
+    keepaliveTimer{io},
+    accountName{context.options.accountPrefix + std::to_string(context.options.firstAccount + number)},
+    number{number}
+{}
+
+void BotClient::start()
+{
+	++context.stats.loginsStarted;
+	state = STATE_LOGIN;
+	connect(context.options.loginPort);
+}
+
+void BotClient::stop()
+{
+	if (state == STATE_GAME) {
+		NetworkMessage out;
+		out.addByte(0x14);
+		send(out);
+
+		// the connection is closed once the logout went out
+		std::erase(context.playerIds, playerId);
+		state = STATE_CLOSED;
+		actionTimer.cancel();
+		probeTimer.cancel();
+		keepaliveTimer.cancel();
+		return;
+	}
+
+	close();
+}
+
+void BotClient::connect(uint16_t port)
+{
+	boost::system::error_code error;
+	socket.close(error);
+	writeQueue.clear();
+	encrypted = false;
+	++connectionId;
+
+	boost::asio::ip::tcp::endpoint endpoint{boost::asio::ip::make_address(context.options.host, error), port};
+	if (error) {
+		fail(fmt::format("invalid host {:s}", context.options.host));
+		return;
+	}
+
+	socket.async_connect(endpoint,
+	                     [thisPtr = shared_from_this(), id = connectionId](const boost::system::error_code& error) {
+		                     if (id != thisPtr->connectionId || thisPtr->state == STATE_CLOSED) {
+			                     return;
+		                     }
+
+		                     if (error) {
+			                     thisPtr->fail(fmt::format("connect failed: {:s}", error.message()));
+			                     return;
+		                     }
+		                     thisPtr->onConnect();
+	                     });
+}
+
+void BotClient::onConnect()
+{
+	boost::system::error_code error;
+	socket.set_option(boost::asio::ip::tcp::no_delay(true), error);
+
+	if (state == STATE_LOGIN) {
+		sendLogin();
+	}
+	// the game server speaks first with its challenge
+	readHeader();
+}
+
+void BotClient::readHeader()
+{
+	boost::asio::async_read(
+	    socket, boost::asio::buffer(msg.getBuffer(), NetworkMessage::HEADER_LENGTH),
+	    [thisPtr = shared_from_this(), id = connectionId](const boost::system::error_code& error, auto /*bytes*/) {
+		    if (id != thisPtr->connectionId || thisPtr->state == STATE_CLOSED) {
+			    return;
+		    }
+
+		    if (error) {
+			    thisPtr->fail("connection lost");
+			    return;
+		    }
+		    thisPtr->readBody();
+	    });
+}
+
+void BotClient::readBody()
+{
+	const uint16_t size = msg.getLengthHeader();
+	if (size == 0 || size >= NETWORKMESSAGE_MAXSIZE - 16) {
+		fail("invalid packet size");
+		return;
+	}
+
+	// the message may read up to the initial buffer position past its length, as on the server
+	msg.reserve(size + NetworkMessage::HEADER_LENGTH + NetworkMessage::INITIAL_BUFFER_POSITION);
+	msg.setLength(size + NetworkMessage::HEADER_LENGTH);
+	boost::asio::async_read(
+	    socket, boost::asio::buffer(msg.getBodyBuffer(), size),
+	    [thisPtr = shared_from_this(), id = connectionId](const boost::system::error_code& error, auto bytes) {
+		    if (id != thisPtr->connectionId || thisPtr->state == STATE_CLOSED) {
+			    return;
+		    }
+
+		    if (error) {
+			    thisPtr->fail("connection lost");
+			    return;
+		    }
+
+		    thisPtr->context.stats.bytesReceived += bytes + NetworkMessage::HEADER_LENGTH;
+		    thisPtr->onPacket(thisPtr->msg);
+
+		    // the login answer moves the bot on to the game server
+		    if (id == thisPtr->connectionId && thisPtr->state != STATE_CLOSED) {
+			    thisPtr->readHeader();
+		    }
+	    });
+}
+
+void BotClient::onPacket(NetworkMessage& msg)
+{
+	// the checksum is optional, as on the server
+	const int32_t checksumLength = msg.getLength() - msg.getBufferPosition() - NetworkMessage::CHECKSUM_LENGTH;
+	uint32_t checksum = 0;
+	if (checksumLength > 0) {
+		checksum = adlerChecksum(msg.getBuffer() + msg.getBufferPosition() + NetworkMessage::CHECKSUM_LENGTH,
+		                         checksumLength);
+	}
+
+	if (msg.get<uint32_t>() != checksum) {
+		msg.skipBytes(-NetworkMessage::CHECKSUM_LENGTH);
+	}
+
+	if (encrypted) {
+		const size_t length = msg.getLength() - msg.getBufferPosition();
+		if ((length & 7) != 0) {
+			fail("invalid encrypted packet");
+			return;
+		}
+		xtea::decrypt(msg.getBuffer() + msg.getBufferPosition(), length, roundKeys);
+	}
+
+	const uint16_t innerLength = msg.get<uint16_t>();
+	if (msg.getBufferPosition() + innerLength > msg.getLength()) {
+		fail("invalid packet length");
+		return;
+	}
+	// reads stop at the inner length
+	msg.setLength(msg.getBufferPosition() + innerLength - NetworkMessage::INITIAL_BUFFER_POSITION);
+
+	switch (state) {
+		case STATE_LOGIN:
+			onLoginPacket(msg);
+			break;
+		case STATE_CHALLENGE:
+			onChallengePacket(msg);
+			break;
+		default:
+			onGamePacket(msg);
+			break;
+	}
+}
+
+void BotClient::onLoginPacket(NetworkMessage& msg)
+{
+	while (!msg.isOverrun()) {
+		switch (msg.getByte()) {
+			case 0x0A:
+			case 0x0B:
+				fail(msg.getString());
+				return;
+
+			case 0x14: // motd
+				msg.getString();
+				break;
+
+			case 0x64: {
+				if (msg.getByte() == 0) {
+					fail("account has no characters");
+					return;
+				}
+
+				characterName = msg.getString();
+				msg.getString(); // world name
+				msg.get<uint32_t>(); // world ip, the host from the options is used instead
+				gamePort = msg.get<uint16_t>();
+
+				state = STATE_CHALLENGE;
+				connect(gamePort);
+				return;
+			}
+
+			default:
+				fail("unexpected login answer");
+				return;
+		}
+	}
+}
+
+void BotClient::onChallengePacket(NetworkMessage& msg)
+{
+	if (msg.getByte() != 0x1F) {
+		fail("missing login challenge");
+		return;
+	}
+
+	const uint32_t timestamp = msg.get<uint32_t>();
+	const uint8_t random = msg.getByte();
+	state = STATE_ENTERING;
+	sendGameLogin(timestamp, random);
+}
+
+void BotClient::onGamePacket(NetworkMessage& msg)
+{
+	if (state == STATE_ENTERING) {
+		switch (msg.getByte()) {
+			case 0x0A: // self appear
+				playerId = msg.get<uint32_t>();
+				state = STATE_GAME;
+				++context.stats.logins;
+				context.playerIds.push_back(playerId);
+				scheduleAction();
+				scheduleProbe();
+				scheduleKeepalive();
+				break;
+
+			case 0x14:
+				fail(msg.getString());
+				break;
+
+			case 0x16:
+				fail("login queue is full");
+				break;
+
+			default:
+				break;
+		}
+		return;
+	}
+
+	if (probeToken.empty()) {
+		return;
+	}
+
+	// the messages are not parsed, the token is unique enough to be looked for in the raw bytes
+	const std::string_view data{reinterpret_cast<const char*>(msg.getBuffer() + msg.getBufferPosition()),
+	                            static_cast<size_t>(msg.getLength() + NetworkMessage::INITIAL_BUFFER_POSITION -
+	                                                msg.getBufferPosition())};
+	if (data.find(probeToken) != std::string_view::npos) {
+		const auto latency = std::chrono::steady_clock::now() - probeSent;
+		context.stats.latencies.push_back(
+		    static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count()));
+		probeToken.clear();
+	}
+}
+
+void BotClient::sendLogin()
+{
+	for (uint32_t& word : key) {
+		word = static_cast<uint32_t>(context.generator());
+	}
+
+	NetworkMessage out;
+	out.addByte(0x01); // protocol id
+	out.add<uint16_t>(CLIENTOS_WINDOWS);
+	out.add<uint16_t>(CLIENT_VERSION_MIN);
+	// dat, spr and pic signatures
+	out.add<uint32_t>(0);
+	out.add<uint32_t>(0);
+	out.add<uint32_t>(0);
+
+	const auto rsaStart = out.getLength();
+	out.addByte(0);
+	for (uint32_t word : key) {
+		out.add<uint32_t>(word);
+	}
+	out.addString(accountName);
+	out.addString(context.options.password);
+	out.addPaddingBytes(RSA_BLOCK_SIZE - (out.getLength() - rsaStart));
+	context.rsa.encrypt(reinterpret_cast<char*>(out.getBuffer()) + NetworkMessage::INITIAL_BUFFER_POSITION + rsaStart);
+
+	sendFirst(out);
+	roundKeys = xtea::expand_key(key);
+	encrypted = true;
+}
+
+void BotClient::sendGameLogin(uint32_t timestamp, uint8_t random)
+{
+	for (uint32_t& word : key) {
+		word = static_cast<uint32_t>(context.generator());
+	}
+
+	NetworkMessage out;
+	out.addByte(0x0A); // protocol id
+	out.add<uint16_t>(CLIENTOS_WINDOWS);
+	out.add<uint16_t>(CLIENT_VERSION_MIN);
+
+	const auto rsaStart = out.getLength();
+	out.addByte(0);
+	for (uint32_t word : key) {
+		out.add<uint32_t>(word);
+	}
+	out.addByte(0); // gamemaster flag
+	out.addString(accountName);
+	out.addString(characterName);
+	out.addString(context.options.password);
+	out.add<uint32_t>(timestamp);
+	out.addByte(random);
+	out.add<uint16_t>(0); // not an OTCv8 client
+	out.addPaddingBytes(RSA_BLOCK_SIZE - (out.getLength() - rsaStart));
+	context.rsa.encrypt(reinterpret_cast<char*>(out.getBuffer()) + NetworkMessage::INITIAL_BUFFER_POSITION + rsaStart);
+
+	sendFirst(out);
+	roundKeys = xtea::expand_key(key);
+	encrypted = true;
+}
+
+void BotClient::sendFirst(const NetworkMessage& msg)
+{
+	const uint8_t* body = msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION;
+	const uint16_t length = msg.getLength();
+	const uint16_t size = length + NetworkMessage::CHECKSUM_LENGTH;
+	const uint32_t checksum = adlerChecksum(body, length);
+
+	std::vector<uint8_t> packet(NetworkMessage::HEADER_LENGTH + size);
+	std::memcpy(packet.data(), &size, sizeof(size));
+	std::memcpy(packet.data() + NetworkMessage::HEADER_LENGTH, &checksum, sizeof(checksum));
+	std::memcpy(packet.data() + NetworkMessage::HEADER_LENGTH + NetworkMessage::CHECKSUM_LENGTH, body, length);
+	write(std::move(packet));
+}
+
+void BotClient::send(const NetworkMessage& msg)
+{
+	// inner length and body, padded to whole xtea blocks
+	const uint16_t length = msg.getLength();
+	const size_t innerSize = (sizeof(uint16_t) + length + 7) & ~size_t{7};
+	constexpr size_t offset = size_t{NetworkMessage::HEADER_LENGTH} + NetworkMessage::CHECKSUM_LENGTH;
+
+	std::vector<uint8_t> packet(offset + innerSize, 0x33);
+	std::memcpy(packet.data() + offset, &length, sizeof(length));
+	std::memcpy(packet.data() + offset + sizeof(uint16_t), msg.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION,
+	            length);
+	xtea::encrypt(packet.data() + offset, innerSize, roundKeys);
+
+	const uint16_t size = innerSize + NetworkMessage::CHECKSUM_LENGTH;
+	const uint32_t checksum = adlerChecksum(packet.data() + offset, innerSize);
+	std::memcpy(packet.data(), &size, sizeof(size));
+	std::memcpy(packet.data() + NetworkMessage::HEADER_LENGTH, &checksum, sizeof(checksum));
+	write(std::move(packet));
+}
+
+void BotClient::write(std::vector<uint8_t> packet)
+{
+	context.stats.bytesSent += packet.size();
+	writeQueue.push_back(std::move(packet));
+	if (writeQueue.size() > 1) {
+		return;
+	}
+
+	writeNext();
+}
+
+void BotClient::writeNext()
+{
+	boost::asio::async_write(
+	    socket, boost::asio::buffer(writeQueue.front()),
+	    [thisPtr = shared_from_this(), id = connectionId](const boost::system::error_code& error, auto /*bytes*/) {
+		    if (id != thisPtr->connectionId) {
+			    return;
+		    }
+
+		    thisPtr->writeQueue.pop_front();
+		    if (error || (thisPtr->state == STATE_CLOSED && thisPtr->writeQueue.empty())) {
+			    thisPtr->close();
+			    return;
+		    }
+
+		    if (!thisPtr->writeQueue.empty()) {
+			    thisPtr->writeNext();
+		    }
+	    });
+}
+
+void BotClient::scheduleAction()
+{
+	if (context.options.profile == BOT_PROFILE_IDLE) {
+		return;
+	}
+
+	actionTimer.expires_after(jitter(context.generator, context.options.actionInterval));
+	actionTimer.async_wait([thisPtr = shared_from_this()](const boost::system::error_code& error) {
+		if (!error && thisPtr->state == STATE_GAME) {
+			thisPtr->act();
+			thisPtr->scheduleAction();
+		}
+	});
+}
+
+void BotClient::scheduleProbe()
+{
+	probeTimer.expires_after(jitter(context.generator, context.options.probeInterval));
+	probeTimer.async_wait([thisPtr = shared_from_this()](const boost::system::error_code& error) {
+		if (!error && thisPtr->state == STATE_GAME) {
+			thisPtr->probe();
+			thisPtr->scheduleProbe();
+		}
+	});
+}
+
+void BotClient::scheduleKeepalive()
+{
+	keepaliveTimer.expires_after(KEEPALIVE_INTERVAL);
+	keepaliveTimer.async_wait([thisPtr = shared_from_this()](const boost::system::error_code& error) {
+		if (!error && thisPtr->state == STATE_GAME) {
+			NetworkMessage out;
+			out.addByte(0x1E);
+			thisPtr->send(out);
+			thisPtr->scheduleKeepalive();
+		}
+	});
+}
+
+void BotClient::act()
+{
+	Xoshiro256& generator = context.generator;
+
+	BotProfile profile = context.options.profile;
+	if (profile == BOT_PROFILE_MIXED) {
+		profile = static_cast<BotProfile>(BOT_PROFILE_WALKER + generator.bounded(BOT_PROFILE_USER));
+	}
+
+	NetworkMessage out;
+	switch (profile) {
+		case BOT_PROFILE_WALKER:
+			// mostly steps, north east south west, now and then a turn
+			if (generator.bounded(5) != 0) {
+				out.addByte(0x65 + generator.bounded(4));
+			} else {
+				out.addByte(0x6F + generator.bounded(4));
+			}
+			break;
+
+		case BOT_PROFILE_TALKER:
+			out.addByte(0x96);
+			out.addByte(TALKTYPE_SAY);
+			out.addString(PHRASES[generator.bounded(PHRASES.size())]);
+			break;
+
+		case BOT_PROFILE_FIGHTER: {
+			const auto& playerIds = context.playerIds;
+			if (playerIds.size() < 2) {
+				return;
+			}
+
+			uint32_t target = playerIds[generator.bounded(playerIds.size())];
+			if (target == playerId) {
+				return;
+			}
+
+			out.addByte(0xA1);
+			out.add<uint32_t>(target);
+			break;
+		}
+
+		case BOT_PROFILE_USER:
+			out.addByte(0x82);
+			out.addPosition(Position(0xFFFF, BACKPACK_SLOT, 0));
+			out.add<uint16_t>(context.options.useItemId);
+			out.addByte(0); // stackpos
+			out.addByte(0); // container index
+			break;
+
+		default:
+			return;
+	}
+
+	++context.stats.actions;
+	send(out);
+}
+
+void BotClient::probe()
+{
+	// a lost probe is given up on when the next one is sent
+	probeToken = fmt::format("lt{:d}.{:d}", number, nextProbe++);
+	probeSent = std::chrono::steady_clock::now();
+
+	NetworkMessage out;
+	out.addByte(0x96);
+	out.addByte(TALKTYPE_SAY);
+	out.addString(probeToken);
+	send(out);
+}
+
+void BotClient::fail(std::string_view reason)
+{
+	if (state == STATE_CLOSED) {
+		return;
+	}
+
+	// bots that made it into the game count as disconnected instead
+	if (state == STATE_GAME) {
+		++context.stats.disconnects;
+	} else if (++context.stats.loginFailures <= MAX_REPORTED_FAILURES) {
+		std::cout << fmt::format("> {:s}: {:s}", accountName, reason) << std::endl;
+	}
+	close();
+}
+
+void BotClient::close()
+{
+	if (playerId != 0) {
+		std::erase(context.playerIds, playerId);
+	}
+
+	state = STATE_CLOSED;
+	actionTimer.cancel();
+	probeTimer.cancel();
+	keepaliveTimer.cancel();
+
+	boost::system::error_code error;
+	socket.close(error);
+}
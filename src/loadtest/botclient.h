@@ -0,0 +1,159 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_BOTCLIENT_H
+#define FS_BOTCLIENT_H
+
+#include "../networkmessage.h"
+#include "../xoshiro.h"
+#include "../xtea.h"
+
+class RSA;
+
+enum BotProfile : uint8_t
+{
+	BOT_PROFILE_IDLE,    // logs in and answers pings only
+	BOT_PROFILE_WALKER,  // steps and turns
+	BOT_PROFILE_TALKER,  // says something on the default channel
+	BOT_PROFILE_FIGHTER, // attacks other bots
+	BOT_PROFILE_USER,    // uses the item in its backpack slot
+	BOT_PROFILE_MIXED,   // any of the above, picked per action
+};
+
+bool parseBotProfile(std::string_view name, BotProfile& profile);
+
+struct LoadTestOptions
+{
+	std::string host = "127.0.0.1";
+	uint16_t loginPort = 7171;
+	// 0 skips the server metrics
+	uint16_t metricsPort = 0;
+
+	// bot n logs in to account <accountPrefix><firstAccount + n> and plays its first character
+	std::string accountPrefix = "loadtest";
+	std::string password = "loadtest";
+	uint32_t firstAccount = 1;
+
+	uint32_t bots = 100;
+	// logins started per second
+	uint32_t rampRate = 50;
+	// seconds after the last login was started
+	uint32_t duration = 60;
+
+	BotProfile profile = BOT_PROFILE_MIXED;
+	// milliseconds between two actions of a bot, drawn within +-50%
+	uint32_t actionInterval = 1000;
+	// milliseconds between two latency probes of a bot
+	uint32_t probeInterval = 5000;
+	// client id of the item the user profile uses, the default is a backpack
+	uint16_t useItemId = 1988;
+};
+
+struct LoadTestStats
+{
+	uint32_t loginsStarted = 0;
+	uint32_t logins = 0;
+	uint32_t loginFailures = 0;
+	uint32_t disconnects = 0;
+	uint64_t actions = 0;
+	uint64_t bytesSent = 0;
+	uint64_t bytesReceived = 0;
+	// microseconds from sending a probe until the server echoed it back
+	std::vector<uint32_t> latencies;
+};
+
+struct LoadTestContext
+{
+	LoadTestContext(const LoadTestOptions& options, RSA& rsa) : options{options}, rsa{rsa} {}
+
+	LoadTestOptions options;
+	RSA& rsa;
+	LoadTestStats stats;
+	Xoshiro256 generator{static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())};
+	// creature ids of the bots in game, the fighters pick their targets from them
+	std::vector<uint32_t> playerIds;
+};
+
+// One simulated client: logs in through the login protocol, enters the game with the character it was given and
+// plays its profile until stopped. Every bot runs on the same io_context thread, which also owns the context.
+class BotClient : public std::enable_shared_from_this<BotClient>
+{
+public:
+	BotClient(boost::asio::io_context& io, LoadTestContext& context, uint32_t number);
+
+	// non-copyable
+	BotClient(const BotClient&) = delete;
+	BotClient& operator=(const BotClient&) = delete;
+
+	void start();
+	// logs out if in game and closes the connection
+	void stop();
+
+	bool isInGame() const { return state == STATE_GAME; }
+
+private:
+	enum State : uint8_t
+	{
+		STATE_IDLE,
+		STATE_LOGIN,
+		STATE_CHALLENGE,
+		STATE_ENTERING,
+		STATE_GAME,
+		STATE_CLOSED,
+	};
+
+	void connect(uint16_t port);
+	void onConnect();
+	void readHeader();
+	void readBody();
+	void onPacket(NetworkMessage& msg);
+	void onLoginPacket(NetworkMessage& msg);
+	void onChallengePacket(NetworkMessage& msg);
+	void onGamePacket(NetworkMessage& msg);
+
+	void sendLogin();
+	void sendGameLogin(uint32_t timestamp, uint8_t random);
+	// the first message of a connection is sent in the clear but for the rsa block
+	void sendFirst(const NetworkMessage& msg);
+	void send(const NetworkMessage& msg);
+	void write(std::vector<uint8_t> packet);
+	void writeNext();
+
+	void scheduleAction();
+	void scheduleProbe();
+	void scheduleKeepalive();
+	void act();
+	void probe();
+
+	void fail(std::string_view reason);
+	void close();
+
+	LoadTestContext& context;
+	boost::asio::ip::tcp::socket socket;
+	boost::asio::steady_timer actionTimer;
+	boost::asio::steady_timer probeTimer;
+	boost::asio::steady_timer keepaliveTimer;
+
+	NetworkMessage msg;
+	std::deque<std::vector<uint8_t>> writeQueue;
+
+	xtea::key key;
+	xtea::round_keys roundKeys;
+	bool encrypted = false;
+
+	std::string accountName;
+	std::string characterName;
+	uint16_t gamePort = 0;
+	uint32_t number;
+	uint32_t playerId = 0;
+	// bumped on every connect, so handlers of the previous socket can tell they are stale
+	uint32_t connectionId = 0;
+	State state = STATE_IDLE;
+
+	// the probe being waited for, empty when none is
+	std::string probeToken;
+	std::chrono::steady_clock::time_point probeSent;
+	uint32_t nextProbe = 0;
+};
+
+#endif // FS_BOTCLIENT_H
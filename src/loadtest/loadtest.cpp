@@ -0,0 +1,355 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+// Logs in simulated clients against a running server and reports their latency with the tick and dispatcher task
+// times from the server metrics. The accounts must exist beforehand, each with its character outside of protection
+// zones for the fighters to do anything.
+
+#include "../otpch.h"
+
+#include "botclient.h"
+
+#include "../rsa.h"
+
+#include <charconv>
+
+namespace {
+
+// seconds between two progress lines
+constexpr auto REPORT_INTERVAL = std::chrono::seconds(10);
+
+struct Histogram
+{
+	// bucket upper bounds and cumulative counts, +Inf last
+	std::vector<double> bounds;
+	std::vector<uint64_t> counts;
+};
+
+void printUsage(const char* name)
+{
+	std::cout << "Usage: " << name << " [options]\n"
+	          << "  --host <ip>                server address (127.0.0.1)\n"
+	          << "  --login-port <port>        login protocol port (7171)\n"
+	          << "  --metrics-port <port>      metricsProtocolPort of the server, 0 skips its metrics (0)\n"
+	          << "  --key <file>               the server rsa key, the public half is used (key.pem)\n"
+	          << "  --account-prefix <prefix>  bot n plays account <prefix><first account + n> (loadtest)\n"
+	          << "  --first-account <n>        (1)\n"
+	          << "  --password <password>      password of every bot account (loadtest)\n"
+	          << "  --bots <n>                 (100)\n"
+	          << "  --ramp <n>                 logins started per second (50)\n"
+	          << "  --duration <seconds>       time to play once every login was started (60)\n"
+	          << "  --profile <name>           idle, walker, talker, fighter, user or mixed (mixed)\n"
+	          << "  --action-interval <ms>     average time between two actions of a bot (1000)\n"
+	          << "  --probe-interval <ms>      average time between two latency probes of a bot (5000)\n"
+	          << "  --use-item <client id>     item in the backpack slot the user profile uses (1988)\n";
+}
+
+template <typename T>
+bool parseNumber(std::string_view value, T& result)
+{
+	const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+	return error == std::errc{} && end == value.data() + value.size();
+}
+
+bool parseOptions(int argc, char* argv[], LoadTestOptions& options, std::string& keyFile)
+{
+	for (int i = 1; i < argc; i += 2) {
+		const std::string_view name = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "> Missing value for " << name << std::endl;
+			return false;
+		}
+
+		const std::string_view value = argv[i + 1];
+		bool valid = true;
+		if (name == "--host") {
+			options.host = value;
+		} else if (name == "--login-port") {
+			valid = parseNumber(value, options.loginPort);
+		} else if (name == "--metrics-port") {
+			valid = parseNumber(value, options.metricsPort);
+		} else if (name == "--key") {
+			keyFile = value;
+		} else if (name == "--account-prefix") {
+			options.accountPrefix = value;
+		} else if (name == "--first-account") {
+			valid = parseNumber(value, options.firstAccount);
+		} else if (name == "--password") {
+			options.password = value;
+		} else if (name == "--bots") {
+			valid = parseNumber(value, options.bots);
+		} else if (name == "--ramp") {
+			valid = parseNumber(value, options.rampRate) && options.rampRate != 0;
+		} else if (name == "--duration") {
+			valid = parseNumber(value, options.duration);
+		} else if (name == "--profile") {
+			valid = parseBotProfile(value, options.profile);
+		} else if (name == "--action-interval") {
+			valid = parseNumber(value, options.actionInterval) && options.actionInterval != 0;
+		} else if (name == "--probe-interval") {
+			valid = parseNumber(value, options.probeInterval) && options.probeInterval != 0;
+		} else if (name == "--use-item") {
+			valid = parseNumber(value, options.useItemId);
+		} else {
+			std::cout << "> Unknown option " << name << std::endl;
+			return false;
+		}
+
+		if (!valid) {
+			std::cout << "> Invalid value " << value << " for " << name << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// a blocking GET of the metrics page, empty on failure
+std::string scrapeMetrics(boost::asio::io_context& io, const LoadTestOptions& options)
+{
+	try {
+		boost::asio::ip::tcp::socket socket{io};
+		socket.connect({boost::asio::ip::make_address(options.host), options.metricsPort});
+
+		const std::string request = "GET /metrics HTTP/1.0\r\nHost: " + options.host + "\r\n\r\n";
+		boost::asio::write(socket, boost::asio::buffer(request));
+
+		std::string response;
+		boost::system::error_code error;
+		boost::asio::read(socket, boost::asio::dynamic_buffer(response), error);
+		if (error && error != boost::asio::error::eof) {
+			throw boost::system::system_error(error);
+		}
+
+		const auto bodyStart = response.find("\r\n\r\n");
+		if (!response.starts_with("HTTP/1.1 200") || bodyStart == std::string::npos) {
+			std::cout << "> Unexpected metrics answer" << std::endl;
+			return {};
+		}
+		return response.substr(bodyStart + 4);
+	} catch (const boost::system::system_error& e) {
+		std::cout << "> Could not read the server metrics: " << e.what() << std::endl;
+		return {};
+	}
+}
+
+Histogram parseHistogram(std::string_view metrics, std::string_view name)
+{
+	Histogram histogram;
+	const std::string prefix = fmt::format("{:s}_bucket{{le=\"", name);
+	for (size_t start = 0; start < metrics.size();) {
+		size_t end = metrics.find('\n', start);
+		if (end == std::string_view::npos) {
+			end = metrics.size();
+		}
+
+		const std::string_view line = metrics.substr(start, end - start);
+		start = end + 1;
+		if (!line.starts_with(prefix)) {
+			continue;
+		}
+
+		const size_t boundEnd = line.find('"', prefix.size());
+		const size_t valueStart = line.rfind(' ');
+		if (boundEnd == std::string_view::npos || valueStart == std::string_view::npos) {
+			continue;
+		}
+
+		const std::string_view bound = line.substr(prefix.size(), boundEnd - prefix.size());
+		uint64_t count = 0;
+		if (!parseNumber(line.substr(valueStart + 1), count)) {
+			continue;
+		}
+
+		histogram.bounds.push_back(bound == "+Inf" ? std::numeric_limits<double>::infinity()
+		                                           : std::stod(std::string{bound}));
+		histogram.counts.push_back(count);
+	}
+	return histogram;
+}
+
+// the observations made between the two scrapes
+Histogram subtract(const Histogram& after, const Histogram& before)
+{
+	Histogram difference = after;
+	if (before.counts.size() == after.counts.size()) {
+		for (size_t i = 0; i < difference.counts.size(); ++i) {
+			difference.counts[i] -= std::min(before.counts[i], difference.counts[i]);
+		}
+	}
+	return difference;
+}
+
+// interpolated within the bucket like prometheus' histogram_quantile
+double quantile(const Histogram& histogram, double q)
+{
+	if (histogram.counts.empty() || histogram.counts.back() == 0) {
+		return 0;
+	}
+
+	const double rank = q * histogram.counts.back();
+	for (size_t i = 0; i < histogram.counts.size(); ++i) {
+		if (histogram.counts[i] < rank) {
+			continue;
+		}
+
+		if (std::isinf(histogram.bounds[i])) {
+			// past the last bound there is nothing to interpolate with
+			return i == 0 ? 0 : histogram.bounds[i - 1];
+		}
+
+		const double lower = i == 0 ? 0 : histogram.bounds[i - 1];
+		const uint64_t below = i == 0 ? 0 : histogram.counts[i - 1];
+		const uint64_t inBucket = histogram.counts[i] - below;
+		return lower + (histogram.bounds[i] - lower) * (rank - below) / std::max<uint64_t>(inBucket, 1);
+	}
+	return histogram.bounds.back();
+}
+
+void printHistogram(std::string_view title, const Histogram& histogram)
+{
+	const uint64_t count = histogram.counts.empty() ? 0 : histogram.counts.back();
+	std::cout << fmt::format("  {:s}: {:d} samples, p50 {:.0f} us, p90 {:.0f} us, p99 {:.0f} us, p99.9 {:.0f} us",
+	                         title, count, quantile(histogram, 0.5), quantile(histogram, 0.9),
+	                         quantile(histogram, 0.99), quantile(histogram, 0.999))
+	          << std::endl;
+}
+
+// exact percentile of the probe latencies in milliseconds, sorts them
+double percentile(std::vector<uint32_t>& latencies, double p)
+{
+	if (latencies.empty()) {
+		return 0;
+	}
+
+	const size_t index = std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+	std::nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+	return latencies[index] / 1000.0;
+}
+
+void printLatency(std::vector<uint32_t> latencies)
+{
+	std::cout << fmt::format("  client latency: {:d} probes, p50 {:.1f} ms, p90 {:.1f} ms, p99 {:.1f} ms, "
+	                         "max {:.1f} ms",
+	                         latencies.size(), percentile(latencies, 0.5), percentile(latencies, 0.9),
+	                         percentile(latencies, 0.99), percentile(latencies, 1))
+	          << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+	LoadTestOptions options;
+	std::string keyFile = "key.pem";
+	if (!parseOptions(argc, argv, options, keyFile)) {
+		printUsage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	RSA rsa;
+	try {
+		rsa.loadPEM(keyFile);
+	} catch (const std::exception& e) {
+		std::cout << "> " << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	boost::asio::io_context io;
+	LoadTestContext context{options, rsa};
+
+	std::string metricsBefore;
+	if (options.metricsPort != 0) {
+		metricsBefore = scrapeMetrics(io, options);
+	}
+
+	std::vector<std::shared_ptr<BotClient>> bots;
+	bots.reserve(options.bots);
+
+	const auto start = std::chrono::steady_clock::now();
+	const auto rampTime = std::chrono::milliseconds(uint64_t{options.bots} * 1000 / options.rampRate);
+	const auto end = start + rampTime + std::chrono::seconds(options.duration);
+
+	// logins are started every 20 ms in batches of whatever the ramp rate allows by then
+	boost::asio::steady_timer rampTimer{io};
+	std::function<void()> ramp = [&]() {
+		const auto elapsed =
+		    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+		const uint64_t due = std::min<uint64_t>(options.bots, elapsed.count() * options.rampRate / 1000 + 1);
+		while (bots.size() < due) {
+			auto& bot = bots.emplace_back(std::make_shared<BotClient>(io, context, bots.size()));
+			bot->start();
+		}
+
+		if (bots.size() < options.bots) {
+			rampTimer.expires_after(std::chrono::milliseconds(20));
+			rampTimer.async_wait([&](const boost::system::error_code& error) {
+				if (!error) {
+					ramp();
+				}
+			});
+		}
+	};
+	ramp();
+
+	boost::asio::steady_timer reportTimer{io};
+	std::function<void()> report = [&]() {
+		reportTimer.expires_after(REPORT_INTERVAL);
+		reportTimer.async_wait([&](const boost::system::error_code& error) {
+			if (error) {
+				return;
+			}
+
+			const LoadTestStats& stats = context.stats;
+			const auto elapsed =
+			    std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start);
+			std::cout << fmt::format("> {:>4d} s: {:d} of {:d} bots in game, {:d} failed, {:d} disconnected, "
+			                         "{:d} probes",
+			                         elapsed.count(), context.playerIds.size(), stats.loginsStarted,
+			                         stats.loginFailures, stats.disconnects, stats.latencies.size())
+			          << std::endl;
+			report();
+		});
+	};
+	report();
+
+	std::string metricsAfter;
+	boost::asio::steady_timer endTimer{io};
+	endTimer.expires_at(end);
+	endTimer.async_wait([&](const boost::system::error_code&) {
+		// read while the bots are still logged in
+		if (options.metricsPort != 0) {
+			metricsAfter = scrapeMetrics(io, options);
+		}
+
+		rampTimer.cancel();
+		reportTimer.cancel();
+		for (const auto& bot : bots) {
+			bot->stop();
+		}
+	});
+
+	io.run();
+
+	const LoadTestStats& stats = context.stats;
+	const auto elapsed =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	const double seconds = elapsed.count() / 1000.0;
+	std::cout << fmt::format("> Load test over after {:.1f} s", seconds) << std::endl;
+	std::cout << fmt::format("  {:d} logins started, {:d} logged in, {:d} failed, {:d} disconnected",
+	                         stats.loginsStarted, stats.logins, stats.loginFailures, stats.disconnects)
+	          << std::endl;
+	std::cout << fmt::format("  {:d} actions, {:d} bytes sent, {:d} bytes received", stats.actions, stats.bytesSent,
+	                         stats.bytesReceived)
+	          << std::endl;
+	printLatency(stats.latencies);
+
+	if (!metricsAfter.empty()) {
+		for (const auto& [title, name] : {
+		         std::pair{"server tick busy time", "tfs_tick_busy_microseconds"},
+		         std::pair{"server dispatcher tasks", "tfs_dispatcher_task_duration_microseconds"},
+		     }) {
+			printHistogram(title, subtract(parseHistogram(metricsAfter, name), parseHistogram(metricsBefore, name)));
+		}
+	}
+	return EXIT_SUCCESS;
+}
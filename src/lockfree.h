@@ -28,6 +28,34 @@ struct LockfreeFreeList
 	}
 };
 
+/*
+ * raw storage helpers on top of LockfreeFreeList, used both by
+ * LockfreePoolingAllocator and by classes that pool themselves through a
+ * class-specific operator new/delete
+ */
+template <size_t TSize, size_t Capacity>
+void* lockfreeAllocate()
+{
+	auto& inst = LockfreeFreeList<TSize, Capacity>::get();
+	void* p; // NOTE: p doesn't have to be initialized
+	if (!inst.pop(p)) {
+		// Acquire memory without calling the constructor of T
+		p = operator new(TSize);
+	}
+	return p;
+}
+
+template <size_t TSize, size_t Capacity>
+void lockfreeDeallocate(void* p)
+{
+	auto& inst = LockfreeFreeList<TSize, Capacity>::get();
+	if (!inst.bounded_push(p)) {
+		// Release memory without calling the destructor of T
+		//(it has already been called at this point)
+		operator delete(p);
+	}
+}
+
 template <typename T, size_t Capacity>
 class LockfreePoolingAllocator
 {
@@ -45,26 +73,9 @@ public:
 	{}
 	using value_type = T;
 
-	T* allocate(size_t) const
-	{
-		auto& inst = LockfreeFreeList<sizeof(T), Capacity>::get();
-		void* p; // NOTE: p doesn't have to be initialized
-		if (!inst.pop(p)) {
-			// Acquire memory without calling the constructor of T
-			p = operator new(sizeof(T));
-		}
-		return static_cast<T*>(p);
-	}
+	T* allocate(size_t) const { return static_cast<T*>(lockfreeAllocate<sizeof(T), Capacity>()); }
 
-	void deallocate(T* p, size_t) const
-	{
-		auto& inst = LockfreeFreeList<sizeof(T), Capacity>::get();
-		if (!inst.bounded_push(p)) {
-			// Release memory without calling the destructor of T
-			//(it has already been called at this point)
-			operator delete(p);
-		}
-	}
+	void deallocate(T* p, size_t) const { lockfreeDeallocate<sizeof(T), Capacity>(p); }
 };
 
 #endif // FS_LOCKFREE_H
@@ -0,0 +1,320 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "logger.h"
+
+#include "configmanager.h"
+#include "metrics.h"
+#include "tools.h"
+
+extern ConfigManager g_config;
+
+namespace {
+
+// lines the writer may be behind by, a power of two
+constexpr uint64_t RING_SIZE = 8192;
+constexpr auto REPEAT_WINDOW = std::chrono::seconds(1);
+// the writer sleeps at most this long, a wakeup lost to the race with a writer going to sleep costs no more
+constexpr auto WRITER_WAKEUP = std::chrono::milliseconds(100);
+
+using Clock = std::chrono::system_clock;
+
+struct LogLine
+{
+	Clock::time_point time;
+	LogLevel level = LOG_INFO;
+	std::string source;
+	std::string message;
+};
+
+struct Slot
+{
+	// the position the slot is free for, that position + 1 once the line in it can be written
+	std::atomic<uint64_t> sequence;
+	LogLine line;
+};
+
+struct Repeat
+{
+	Clock::time_point windowStart;
+	uint32_t count = 0;
+	uint32_t suppressed = 0;
+	LogLine line;
+};
+
+MetricCounter droppedLines{"tfs_log_dropped_lines_total", "Log lines dropped because the writer was a ring behind."};
+MetricCounter suppressedLines{"tfs_log_suppressed_lines_total", "Repeated log lines the writer collapsed."};
+
+std::atomic<bool> json{false};
+std::atomic<uint32_t> repeatLimit{0};
+
+std::unique_ptr<Slot[]> slots;
+std::atomic<uint64_t> head{0};
+std::atomic<uint64_t> dropped{0};
+std::atomic<bool> running{false};
+
+// writer thread only, or the thread stopping it after the join
+uint64_t tail = 0;
+std::unordered_map<uint64_t, Repeat> repeats;
+
+std::mutex wakeupLock;
+std::condition_variable wakeupSignal;
+std::thread writer;
+std::atomic<bool> stopping{false};
+
+// the lines written right away, before start and after stop
+std::mutex directLock;
+
+// by LogLevel, what text and json output print
+constexpr std::array<std::string_view, 4> LEVEL_NAMES = {"Debug", "Info", "Warning", "Error"};
+constexpr std::array<std::string_view, 4> LEVEL_KEYS = {"debug", "info", "warning", "error"};
+
+void appendJsonString(std::string& out, std::string_view value)
+{
+	out.push_back('"');
+	for (char c : value) {
+		switch (c) {
+			case '"':
+				out += "\\\"";
+				break;
+			case '\\':
+				out += "\\\\";
+				break;
+			case '\n':
+				out += "\\n";
+				break;
+			case '\r':
+				out += "\\r";
+				break;
+			case '\t':
+				out += "\\t";
+				break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20) {
+					out += fmt::format("\\u{:04x}", static_cast<unsigned char>(c));
+				} else {
+					out.push_back(c);
+				}
+				break;
+		}
+	}
+	out.push_back('"');
+}
+
+void formatLine(std::string& out, const LogLine& line)
+{
+	if (!json.load(std::memory_order_relaxed)) {
+		if (!line.source.empty()) {
+			out += fmt::format("[{:s} - {:s}] ", LEVEL_NAMES[line.level], line.source);
+		}
+		out += line.message;
+		out.push_back('\n');
+		return;
+	}
+
+	const auto milliseconds =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(line.time.time_since_epoch()).count() % 1000;
+	out += fmt::format("{{\"time\":\"{:%Y-%m-%dT%H:%M:%S}.{:03d}Z\",\"level\":\"{:s}\",\"source\":",
+	                   fmt::gmtime(Clock::to_time_t(line.time)), milliseconds, LEVEL_KEYS[line.level]);
+	appendJsonString(out, line.source);
+	out += ",\"message\":";
+	appendJsonString(out, line.message);
+	out += "}\n";
+}
+
+uint64_t repeatKey(const LogLine& line)
+{
+	uint64_t key = std::hash<std::string_view>{}(line.message);
+	key ^= std::hash<std::string_view>{}(line.source) + 0x9e3779b97f4a7c15 + (key << 6) + (key >> 2);
+	return key ^ line.level;
+}
+
+void flushRepeat(std::string& out, Repeat& repeat)
+{
+	if (repeat.suppressed != 0) {
+		repeat.line.message += fmt::format(" (repeated {:d} more times)", repeat.suppressed);
+		formatLine(out, repeat.line);
+		repeat.suppressed = 0;
+	}
+}
+
+void processLine(std::string& out, LogLine& line)
+{
+	const uint32_t limit = repeatLimit.load(std::memory_order_relaxed);
+	if (limit != 0) {
+		auto [it, inserted] = repeats.try_emplace(repeatKey(line));
+		Repeat& repeat = it->second;
+		if (inserted) {
+			repeat.windowStart = line.time;
+			repeat.line = line;
+		}
+
+		if (++repeat.count > limit) {
+			++repeat.suppressed;
+			suppressedLines.add(1);
+			return;
+		}
+	}
+	formatLine(out, line);
+}
+
+void sweepRepeats(std::string& out, Clock::time_point now, bool all)
+{
+	for (auto it = repeats.begin(); it != repeats.end();) {
+		if (all || now - it->second.windowStart >= REPEAT_WINDOW) {
+			flushRepeat(out, it->second);
+			it = repeats.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+// writes what is in the ring, false once it is empty
+bool drainRing(std::string& out)
+{
+	Slot& slot = slots[tail & (RING_SIZE - 1)];
+	if (slot.sequence.load(std::memory_order_acquire) != tail + 1) {
+		return false;
+	}
+
+	LogLine line = std::move(slot.line);
+	slot.sequence.store(tail + RING_SIZE, std::memory_order_release);
+	++tail;
+
+	processLine(out, line);
+	return true;
+}
+
+void writeOut(std::string& out)
+{
+	if (const uint64_t lost = dropped.exchange(0, std::memory_order_relaxed); lost != 0) {
+		droppedLines.add(lost);
+		formatLine(out, {Clock::now(), LOG_WARNING, "Logger", fmt::format("{:d} lines dropped.", lost)});
+	}
+
+	if (!out.empty()) {
+		std::cout << out << std::flush;
+		out.clear();
+	}
+}
+
+void writerThread()
+{
+	std::string out;
+	while (true) {
+		const bool stop = stopping.load(std::memory_order_acquire);
+		while (drainRing(out)) {
+		}
+
+		sweepRepeats(out, Clock::now(), stop);
+		writeOut(out);
+		if (stop) {
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(wakeupLock);
+		wakeupSignal.wait_for(lock, WRITER_WAKEUP);
+	}
+}
+
+LogLevel parseLevel(std::string_view name)
+{
+	for (size_t level = 0; level < LEVEL_KEYS.size(); ++level) {
+		if (caseInsensitiveEqual(name, LEVEL_KEYS[level])) {
+			return static_cast<LogLevel>(level);
+		}
+	}
+	return LOG_INFO;
+}
+
+} // namespace
+
+void Logger::configure()
+{
+	minimumLevel = parseLevel(g_config[ConfigKeysString::LOG_LEVEL]);
+	json = caseInsensitiveEqual(g_config[ConfigKeysString::LOG_FORMAT], "json");
+	repeatLimit = static_cast<uint32_t>(std::max<int64_t>(0, g_config[ConfigKeysInteger::LOG_REPEAT_LIMIT]));
+}
+
+void Logger::start()
+{
+	if (writer.joinable()) {
+		return;
+	}
+
+	slots = std::make_unique<Slot[]>(RING_SIZE);
+	for (uint64_t position = 0; position < RING_SIZE; ++position) {
+		slots[position].sequence.store(position, std::memory_order_relaxed);
+	}
+	head = 0;
+	tail = 0;
+
+	stopping = false;
+	writer = std::thread(writerThread);
+	running.store(true, std::memory_order_release);
+}
+
+void Logger::stop()
+{
+	if (!writer.joinable()) {
+		return;
+	}
+
+	running.store(false, std::memory_order_release);
+	stopping.store(true, std::memory_order_release);
+	wakeupSignal.notify_one();
+	writer.join();
+
+	// lines that made it into the ring while the writer was finishing
+	std::lock_guard<std::mutex> lockGuard(directLock);
+	std::string out;
+	while (drainRing(out)) {
+	}
+	sweepRepeats(out, Clock::now(), true);
+	writeOut(out);
+}
+
+void Logger::write(LogLevel level, std::string_view source, std::string message)
+{
+	while (!message.empty() && message.back() == '\n') {
+		message.pop_back();
+	}
+
+	if (!running.load(std::memory_order_acquire)) {
+		std::string out;
+		formatLine(out, {Clock::now(), level, std::string{source}, std::move(message)});
+
+		std::lock_guard<std::mutex> lockGuard(directLock);
+		std::cout << out << std::flush;
+		return;
+	}
+
+	uint64_t position = head.load(std::memory_order_relaxed);
+	Slot* slot;
+	while (true) {
+		slot = &slots[position & (RING_SIZE - 1)];
+		const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+		const auto difference = static_cast<int64_t>(sequence - position);
+		if (difference == 0) {
+			if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (difference < 0) {
+			// the writer is a whole ring behind, the line goes rather than the caller waiting for the console
+			dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		} else {
+			position = head.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->line.time = Clock::now();
+	slot->line.level = level;
+	slot->line.source.assign(source);
+	slot->line.message = std::move(message);
+	slot->sequence.store(position + 1, std::memory_order_release);
+	wakeupSignal.notify_one();
+}
@@ -0,0 +1,45 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_LOGGER_H
+#define FS_LOGGER_H
+
+enum LogLevel : uint8_t
+{
+	LOG_DEBUG,
+	LOG_INFO,
+	LOG_WARNING,
+	LOG_ERROR,
+};
+
+/*
+ * Leveled console lines written by a background thread, so the thread logging never waits for the console. A line
+ * goes into a fixed ring without taking a lock and is dropped when the ring is full. The writer collapses a line
+ * repeated more than logRepeatLimit times a second and prints text or, with logFormat = "json", one object per line.
+ * Until start() and after stop() lines are written right away, in order with the rest of the console output.
+ */
+namespace Logger {
+
+// reads logLevel, logFormat and logRepeatLimit, again after a config reload
+void configure();
+void start();
+void stop();
+
+inline std::atomic<uint8_t> minimumLevel{LOG_INFO};
+
+inline bool isEnabled(LogLevel level) { return level >= minimumLevel.load(std::memory_order_relaxed); }
+
+// source is the function or subsystem the line comes from, text output prints it as [Warning - source]
+void write(LogLevel level, std::string_view source, std::string message);
+
+template <typename... Args>
+void log(LogLevel level, std::string_view source, fmt::format_string<Args...> format, Args&&... args)
+{
+	if (isEnabled(level)) {
+		write(level, source, fmt::format(format, std::forward<Args>(args)...));
+	}
+}
+
+} // namespace Logger
+
+#endif // FS_LOGGER_H
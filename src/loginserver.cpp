@@ -0,0 +1,49 @@
+#include "otpch.h"
+
+#include "configmanager.h"
+#include "otserv.h"
+#include "tools.h"
+
+extern ConfigManager g_config;
+
+static bool argumentsHandler(const std::vector<std::string_view>& args)
+{
+	for (const auto& arg : args) {
+		if (arg == "--help") {
+			std::clog << "Usage:\n"
+			             "\n"
+			             "\t--config=$1\t\tAlternate configuration file path.\n"
+			             "\t--ip=$1\t\t\tIP address of the game server sent in the character list.\n"
+			             "\t--login-port=$1\tPort for login server to listen on.\n"
+			             "\t--game-port=$1\tPort of the game server sent in the character list.\n";
+			return false;
+		} else if (arg == "--version") {
+			printServerVersion();
+			return false;
+		}
+
+		auto tmp = explodeString(arg, "=");
+
+		if (tmp[0] == "--config")
+			g_config.setString(ConfigKeysString::CONFIG_FILE, tmp[1]);
+		else if (tmp[0] == "--ip")
+			g_config.setString(ConfigKeysString::IP, tmp[1]);
+		else if (tmp[0] == "--login-port")
+			g_config.setInteger(ConfigKeysInteger::LOGIN_PORT, std::stoi(tmp[1].data()));
+		else if (tmp[0] == "--game-port")
+			g_config.setInteger(ConfigKeysInteger::GAME_PORT, std::stoi(tmp[1].data()));
+	}
+
+	return true;
+}
+
+int main(int argc, const char** argv)
+{
+	std::vector<std::string_view> args(argv, argv + argc);
+	if (!argumentsHandler(args)) {
+		return 1;
+	}
+
+	startLoginServer();
+	return 0;
+}
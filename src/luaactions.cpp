@@ -25,6 +25,7 @@ int luaCreateAction(lua_State* L)
 
 	Action* action = new Action(LuaScriptInterface::getScriptEnv()->getScriptInterface());
 	action->fromLua = true;
+	action->scriptFile = g_scripts->getLoadingFile();
 	pushUserdata<Action>(L, action);
 	setMetatable(L, -1, "Action");
 	return 1;
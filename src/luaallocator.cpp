@@ -0,0 +1,119 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "luaallocator.h"
+
+#include "memorystats.h"
+
+#include <cstring>
+
+void* LuaAllocator::allocate(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	// when ptr is null osize holds the type of the new object, not a size
+	return static_cast<LuaAllocator*>(ud)->reallocate(ptr, ptr ? osize : 0, nsize);
+}
+
+void* LuaAllocator::reallocate(void* ptr, size_t oldSize, size_t newSize)
+{
+	if (newSize == 0) {
+		if (ptr) {
+			freeBlock(ptr, oldSize);
+		}
+		return nullptr;
+	}
+
+	if (!ptr) {
+		return allocateBlock(newSize);
+	}
+
+	const bool oldPooled = oldSize <= MAX_POOLED_SIZE;
+	const bool newPooled = newSize <= MAX_POOLED_SIZE;
+	if (oldPooled && newPooled && getSizeClass(oldSize) == getSizeClass(newSize)) {
+		stats.liveBytes += newSize;
+		stats.liveBytes -= oldSize;
+		MemoryStats::resized(MEMORY_LUA, oldSize, newSize);
+		return ptr;
+	}
+
+	if (!oldPooled && !newPooled) {
+		void* block = std::realloc(ptr, newSize);
+		if (block) {
+			stats.liveBytes += newSize;
+			stats.liveBytes -= oldSize;
+			MemoryStats::resized(MEMORY_LUA, oldSize, newSize);
+		}
+		return block;
+	}
+
+	void* block = allocateBlock(newSize);
+	if (block) {
+		std::memcpy(block, ptr, std::min(oldSize, newSize));
+		freeBlock(ptr, oldSize);
+	}
+	return block;
+}
+
+void LuaAllocator::release()
+{
+	assert(stats.liveBytes == 0);
+	freeLists.fill(nullptr);
+	arenas.clear();
+	arenaCursor = arenaEnd = nullptr;
+	stats.arenaBytes = 0;
+}
+
+void* LuaAllocator::allocateBlock(size_t size)
+{
+	void* block;
+	if (size > MAX_POOLED_SIZE) {
+		block = std::malloc(size);
+		if (!block) {
+			return nullptr;
+		}
+		++stats.largeLive;
+		++stats.largeAllocations;
+	} else {
+		const size_t sizeClass = getSizeClass(size);
+		if (FreeBlock* freeBlock = freeLists[sizeClass]) {
+			freeLists[sizeClass] = freeBlock->next;
+			block = freeBlock;
+		} else {
+			const size_t blockSize = (sizeClass + 1) * GRANULARITY;
+			if (static_cast<size_t>(arenaEnd - arenaCursor) < blockSize) {
+				// the tail of the previous arena is left unused
+				arenaCursor = arenas.emplace_back(new char[ARENA_SIZE]).get();
+				arenaEnd = arenaCursor + ARENA_SIZE;
+				stats.arenaBytes += ARENA_SIZE;
+			}
+			block = arenaCursor;
+			arenaCursor += blockSize;
+		}
+		++stats.sizeClasses[sizeClass].live;
+		++stats.sizeClasses[sizeClass].allocations;
+	}
+
+	stats.liveBytes += size;
+	++stats.allocations;
+	MemoryStats::allocated(MEMORY_LUA, size);
+	return block;
+}
+
+void LuaAllocator::freeBlock(void* ptr, size_t size)
+{
+	stats.liveBytes -= size;
+	MemoryStats::freed(MEMORY_LUA, size);
+	if (size > MAX_POOLED_SIZE) {
+		--stats.largeLive;
+		std::free(ptr);
+		return;
+	}
+
+	const size_t sizeClass = getSizeClass(size);
+	--stats.sizeClasses[sizeClass].live;
+
+	FreeBlock* block = static_cast<FreeBlock*>(ptr);
+	block->next = freeLists[sizeClass];
+	freeLists[sizeClass] = block;
+}
@@ -0,0 +1,73 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_LUAALLOCATOR_H
+#define FS_LUAALLOCATOR_H
+
+// Size-class pool for the allocations of a single Lua state. Blocks up to MAX_POOLED_SIZE bytes are carved out of
+// large arenas and recycled through a free list per size class, bigger ones go to the system allocator. Lua passes
+// the old size of every block back, so blocks carry no header. Not thread-safe, a Lua state is only used by one
+// thread at a time.
+class LuaAllocator
+{
+public:
+	static constexpr size_t GRANULARITY = 16;
+	static constexpr size_t MAX_POOLED_SIZE = 512;
+	static constexpr size_t SIZE_CLASSES = MAX_POOLED_SIZE / GRANULARITY;
+	static constexpr size_t ARENA_SIZE = 64 * 1024;
+
+	struct SizeClassStats
+	{
+		uint64_t live = 0;
+		uint64_t allocations = 0;
+	};
+
+	struct Stats
+	{
+		uint64_t liveBytes = 0;
+		uint64_t arenaBytes = 0;
+		uint64_t allocations = 0;
+		// blocks above MAX_POOLED_SIZE
+		uint64_t largeLive = 0;
+		uint64_t largeAllocations = 0;
+		std::array<SizeClassStats, SIZE_CLASSES> sizeClasses = {};
+	};
+
+	LuaAllocator() = default;
+	~LuaAllocator() { release(); }
+
+	// non-copyable
+	LuaAllocator(const LuaAllocator&) = delete;
+	LuaAllocator& operator=(const LuaAllocator&) = delete;
+
+	// lua_Alloc, ud is the LuaAllocator
+	static void* allocate(void* ud, void* ptr, size_t osize, size_t nsize);
+
+	void* reallocate(void* ptr, size_t oldSize, size_t newSize);
+
+	// frees the arenas, only once every block is back (after lua_close)
+	void release();
+
+	const Stats& getStats() const { return stats; }
+
+private:
+	struct FreeBlock
+	{
+		FreeBlock* next;
+	};
+
+	static size_t getSizeClass(size_t size) { return (size - 1) / GRANULARITY; }
+
+	void* allocateBlock(size_t size);
+	void freeBlock(void* ptr, size_t size);
+
+	std::array<FreeBlock*, SIZE_CLASSES> freeLists = {};
+	std::vector<std::unique_ptr<char[]>> arenas;
+	// unused tail of the newest arena
+	char* arenaCursor = nullptr;
+	char* arenaEnd = nullptr;
+
+	Stats stats;
+};
+
+#endif // FS_LUAALLOCATOR_H
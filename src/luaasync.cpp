@@ -0,0 +1,248 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "luaasync.h"
+
+namespace {
+
+// deeper nesting is taken for a table holding itself
+constexpr int MAX_TABLE_DEPTH = 32;
+
+// the hook counts in steps of this many instructions
+constexpr int INSTRUCTION_STEP = 1'000'000;
+constexpr uint32_t MAX_INSTRUCTION_STEPS = 100;
+
+thread_local uint32_t instructionSteps = 0;
+
+void instructionHook(lua_State* L, lua_Debug*)
+{
+	if (++instructionSteps > MAX_INSTRUCTION_STEPS) {
+		luaL_error(L, "the async function ran for too long");
+	}
+}
+
+void openLibrary(lua_State* L, const char* name, lua_CFunction open)
+{
+#ifdef LUAJIT_VERSION
+	lua_pushcfunction(L, open);
+	lua_pushstring(L, name);
+	lua_call(L, 1, 0);
+#else
+	luaL_requiref(L, name, open, 1);
+	lua_pop(L, 1);
+#endif
+}
+
+lua_State* createState()
+{
+	lua_State* L = luaL_newstate();
+	if (!L) {
+		return nullptr;
+	}
+
+	openLibrary(L, "_G", luaopen_base);
+	openLibrary(L, LUA_TABLIBNAME, luaopen_table);
+	openLibrary(L, LUA_STRLIBNAME, luaopen_string);
+	openLibrary(L, LUA_MATHLIBNAME, luaopen_math);
+
+	// nothing reaches the files from here
+	for (const char* name : {"dofile", "loadfile"}) {
+		lua_pushnil(L);
+		lua_setglobal(L, name);
+	}
+
+	lua_sethook(L, instructionHook, LUA_MASKCOUNT, INSTRUCTION_STEP);
+	return L;
+}
+
+struct StateDeleter
+{
+	void operator()(lua_State* L) const { lua_close(L); }
+};
+
+thread_local std::unique_ptr<lua_State, StateDeleter> threadState;
+
+bool copyValue(lua_State* L, int index, LuaAsyncValue& value, std::string& error, int depth)
+{
+	switch (lua_type(L, index)) {
+		case LUA_TNIL:
+			value.type = LuaAsyncValue::NIL;
+			return true;
+
+		case LUA_TBOOLEAN:
+			value.type = LuaAsyncValue::BOOLEAN;
+			value.boolean = lua_toboolean(L, index) != 0;
+			return true;
+
+		case LUA_TNUMBER:
+			if (lua_isinteger(L, index)) {
+				value.type = LuaAsyncValue::INTEGER;
+				value.integer = lua_tointeger(L, index);
+			} else {
+				value.type = LuaAsyncValue::NUMBER;
+				value.number = lua_tonumber(L, index);
+			}
+			return true;
+
+		case LUA_TSTRING: {
+			size_t length;
+			const char* string = lua_tolstring(L, index, &length);
+			value.type = LuaAsyncValue::STRING;
+			value.string.assign(string, length);
+			return true;
+		}
+
+		case LUA_TTABLE: {
+			if (depth == MAX_TABLE_DEPTH) {
+				error = "tables nest too deep or hold themselves";
+				return false;
+			}
+
+			value.type = LuaAsyncValue::TABLE;
+			index = lua_absindex(L, index);
+			lua_pushnil(L);
+			while (lua_next(L, index) != 0) {
+				if (!copyValue(L, -2, value.keys.emplace_back(), error, depth + 1) ||
+				    !copyValue(L, -1, value.values.emplace_back(), error, depth + 1)) {
+					lua_pop(L, 2);
+					return false;
+				}
+				lua_pop(L, 1);
+			}
+			return true;
+		}
+
+		default:
+			error = fmt::format("a {:s} cannot be copied to another state", luaL_typename(L, index));
+			return false;
+	}
+}
+
+int writeChunk(lua_State*, const void* data, size_t size, void* bytecode)
+{
+	static_cast<std::string*>(bytecode)->append(static_cast<const char*>(data), size);
+	return 0;
+}
+
+} // namespace
+
+bool LuaAsync::copy(lua_State* L, int index, LuaAsyncValue& value, std::string& error)
+{
+	value = {};
+	return copyValue(L, index, value, error, 0);
+}
+
+void LuaAsync::push(lua_State* L, const LuaAsyncValue& value)
+{
+	switch (value.type) {
+		case LuaAsyncValue::BOOLEAN:
+			lua_pushboolean(L, value.boolean);
+			break;
+
+		case LuaAsyncValue::INTEGER:
+			lua_pushinteger(L, value.integer);
+			break;
+
+		case LuaAsyncValue::NUMBER:
+			lua_pushnumber(L, value.number);
+			break;
+
+		case LuaAsyncValue::STRING:
+			lua_pushlstring(L, value.string.data(), value.string.size());
+			break;
+
+		case LuaAsyncValue::TABLE:
+			lua_createtable(L, 0, value.keys.size());
+			for (size_t i = 0; i < value.keys.size(); ++i) {
+				push(L, value.keys[i]);
+				push(L, value.values[i]);
+				lua_rawset(L, -3);
+			}
+			break;
+
+		default:
+			lua_pushnil(L);
+			break;
+	}
+}
+
+bool LuaAsync::dump(lua_State* L, int index, std::string& bytecode, std::string& error)
+{
+	if (lua_type(L, index) != LUA_TFUNCTION || lua_iscfunction(L, index)) {
+		error = "expected a Lua function";
+		return false;
+	}
+
+	// the globals are the only upvalue that means the same in the other state
+	for (int i = 1; const char* name = lua_getupvalue(L, index, i); ++i) {
+		lua_pop(L, 1);
+		if (std::string_view{name} != "_ENV") {
+			error = fmt::format("the async function uses the local '{:s}' from outside, pass it as data", name);
+			return false;
+		}
+	}
+
+	lua_pushvalue(L, index);
+#ifdef LUAJIT_VERSION
+	const int dumped = lua_dump(L, writeChunk, &bytecode);
+#else
+	const int dumped = lua_dump(L, writeChunk, &bytecode, 0);
+#endif
+	lua_pop(L, 1);
+
+	if (dumped != 0) {
+		error = "the function could not be dumped";
+		return false;
+	}
+	return true;
+}
+
+bool LuaAsync::run(const std::string& bytecode, const LuaAsyncValue& argument, LuaAsyncValue& result,
+                   std::string& error)
+{
+	if (!threadState) {
+		threadState.reset(createState());
+		if (!threadState) {
+			error = "failed to create a Lua state";
+			return false;
+		}
+	}
+
+	lua_State* L = threadState.get();
+	if (luaL_loadbufferx(L, bytecode.data(), bytecode.size(), "=async", "b") != 0) {
+		error = lua_tostring(L, -1);
+		lua_settop(L, 0);
+		return false;
+	}
+
+	// globals set by one function stay in a table of its own, the next one starts clean
+	lua_newtable(L);
+	lua_createtable(L, 0, 1);
+#ifdef LUAJIT_VERSION
+	lua_pushvalue(L, LUA_GLOBALSINDEX);
+	lua_setfield(L, -2, "__index");
+	lua_setmetatable(L, -2);
+	lua_setfenv(L, -2);
+#else
+	lua_pushglobaltable(L);
+	lua_setfield(L, -2, "__index");
+	lua_setmetatable(L, -2);
+	if (!lua_setupvalue(L, -2, 1)) {
+		lua_pop(L, 1);
+	}
+#endif
+
+	push(L, argument);
+	instructionSteps = 0;
+	if (lua_pcall(L, 1, 1, 0) != 0) {
+		error = lua_tostring(L, -1) ? lua_tostring(L, -1) : "error object is not a string";
+		lua_settop(L, 0);
+		return false;
+	}
+
+	const bool copied = copy(L, -1, result, error);
+	lua_settop(L, 0);
+	return copied;
+}
@@ -0,0 +1,48 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_LUAASYNC_H
+#define FS_LUAASYNC_H
+
+// plain Lua data, what Game.runAsync copies into a worker state and the result back out of it
+struct LuaAsyncValue
+{
+	enum Type : uint8_t
+	{
+		NIL,
+		BOOLEAN,
+		INTEGER,
+		NUMBER,
+		STRING,
+		TABLE,
+	};
+
+	Type type = NIL;
+	bool boolean = false;
+	int64_t integer = 0;
+	double number = 0;
+	std::string string;
+	// the fields of a table, keys[i] holds values[i]
+	std::vector<LuaAsyncValue> keys;
+	std::vector<LuaAsyncValue> values;
+};
+
+/*
+ * Runs Lua functions off the game thread. Each thread keeps a state of its own with only the base, string, table
+ * and math libraries, functions get there as bytecode and may not use locals from outside, arguments and results
+ * are copied. A function that runs too long is stopped with an error.
+ */
+namespace LuaAsync {
+
+// copies nil, booleans, numbers, strings and tables of those, metatables are left behind
+bool copy(lua_State* L, int index, LuaAsyncValue& value, std::string& error);
+void push(lua_State* L, const LuaAsyncValue& value);
+
+bool dump(lua_State* L, int index, std::string& bytecode, std::string& error);
+
+// calls the dumped function with argument on the state of the calling thread
+bool run(const std::string& bytecode, const LuaAsyncValue& argument, LuaAsyncValue& result, std::string& error);
+
+} // namespace LuaAsync
+
+#endif // FS_LUAASYNC_H
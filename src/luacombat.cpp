@@ -114,6 +114,49 @@ int luaCombatSetFormula(lua_State* L)
 	return 1;
 }
 
+CombatFormula::Coefficients getFormulaCoefficients(lua_State* L, int32_t arg)
+{
+	CombatFormula::Coefficients coefficients;
+	coefficients.level = getField<double>(L, arg, "level", 0);
+	coefficients.magicLevel = getField<double>(L, arg, "magicLevel", 0);
+	coefficients.skill = getField<double>(L, arg, "skill", 0);
+	coefficients.attack = getField<double>(L, arg, "attack", 0);
+	coefficients.skillAttack = getField<double>(L, arg, "skillAttack", 0);
+	coefficients.base = getField<double>(L, arg, "base", 0);
+	lua_pop(L, 6);
+	return coefficients;
+}
+
+int luaCombatSetLinearFormula(lua_State* L)
+{
+	// combat:setLinearFormula(min, max)
+	// both {level = a, magicLevel = b, skill = c, attack = d, skillAttack = e, base = f}, the missing ones are 0
+	if (!isType<Combat>(L, 1)) {
+		reportErrorFunc(L, LuaScriptInterface::getErrorDesc(LuaErrorCode::COMBAT_NOT_FOUND));
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const Combat_ptr& combat = getSharedPtr<Combat>(L, 1);
+	if (!combat) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	if (!isTable(L, 2) || !isTable(L, 3)) {
+		reportErrorFunc(L, "Formula must be given as two tables.");
+		pushBoolean(L, false);
+		return 1;
+	}
+
+	CombatFormula formula;
+	formula.min = getFormulaCoefficients(L, 2);
+	formula.max = getFormulaCoefficients(L, 3);
+	combat->setLinearFormula(formula);
+	pushBoolean(L, true);
+	return 1;
+}
+
 int luaCombatSetArea(lua_State* L)
 {
 	// combat:setArea(area)
@@ -335,6 +378,7 @@ void LuaScriptInterface::registerCombat()
 	registerMethod("Combat", "getParameter", luaCombatGetParameter);
 
 	registerMethod("Combat", "setFormula", luaCombatSetFormula);
+	registerMethod("Combat", "setLinearFormula", luaCombatSetLinearFormula);
 
 	registerMethod("Combat", "setArea", luaCombatSetArea);
 	registerMethod("Combat", "addCondition", luaCombatAddCondition);
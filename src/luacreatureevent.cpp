@@ -26,6 +26,7 @@ int luaCreateCreatureEvent(lua_State* L)
 	CreatureEvent* creature = new CreatureEvent(LuaScriptInterface::getScriptEnv()->getScriptInterface());
 	creature->setName(getString(L, 2));
 	creature->fromLua = true;
+	creature->scriptFile = g_scripts->getLoadingFile();
 	pushUserdata<CreatureEvent>(L, creature);
 	setMetatable(L, -1, "CreatureEvent");
 	return 1;
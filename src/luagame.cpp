@@ -3,14 +3,24 @@
 
 #include "otpch.h"
 
+#include "ban.h"
 #include "configmanager.h"
 #include "events.h"
 #include "game.h"
+#include "iologindata.h"
+#include "jobsystem.h"
+#include "luaasync.h"
+#include "luaprofiler.h"
 #include "luascript.h"
+#include "memorystats.h"
+#include "metrics.h"
 #include "monster.h"
 #include "monsters.h"
+#include "replay.h"
 #include "script.h"
 #include "talkaction.h"
+#include "tasks.h"
+#include "tickprofiler.h"
 
 extern Events* g_events;
 extern Vocations g_vocations;
@@ -21,10 +31,31 @@ extern Scripts* g_scripts;
 extern TalkActions* g_talkActions;
 
 extern LuaEnvironment g_luaEnvironment;
+extern Dispatcher g_dispatcher;
 
 namespace {
 using namespace Lua;
 
+struct LuaAsyncResult
+{
+	LuaAsyncValue value;
+	std::string error;
+	bool success = false;
+};
+
+// the result, or nil and the error
+int pushAsyncResult(lua_State* L, const LuaAsyncResult& result)
+{
+	if (result.success) {
+		LuaAsync::push(L, result.value);
+		return 1;
+	}
+
+	lua_pushnil(L);
+	pushString(L, result.error);
+	return 2;
+}
+
 // Game
 int luaGameGetSpectators(lua_State* L)
 {
@@ -52,6 +83,82 @@ int luaGameGetSpectators(lua_State* L)
 	return 1;
 }
 
+int luaGameGetSpectatorsInfo(lua_State* L)
+{
+	// Game.getSpectatorsInfo(position[, multifloor = false[, onlyPlayer = false[, minRangeX = 0[, maxRangeX = 0[,
+	// minRangeY = 0[, maxRangeY = 0]]]]]])
+	const Position& position = getPosition(L, 1);
+	bool multifloor = getBoolean(L, 2, false);
+	bool onlyPlayers = getBoolean(L, 3, false);
+	int32_t minRangeX = getInteger<int32_t>(L, 4, 0);
+	int32_t maxRangeX = getInteger<int32_t>(L, 5, 0);
+	int32_t minRangeY = getInteger<int32_t>(L, 6, 0);
+	int32_t maxRangeY = getInteger<int32_t>(L, 7, 0);
+
+	SpectatorVec spectators;
+	g_game.map.getSpectators(spectators, position, multifloor, onlyPlayers, minRangeX, maxRangeX, minRangeY, maxRangeY);
+
+	lua_createtable(L, spectators.size(), 0);
+
+	int index = 0;
+	for (Creature* creature : spectators) {
+		lua_createtable(L, 0, 6);
+
+		pushUserdata<Creature>(L, creature);
+		setCreatureMetatable(L, -1, creature);
+		lua_setfield(L, -2, "creature");
+
+		setField(L, "id", creature->getID());
+		if (creature->getPlayer()) {
+			setField(L, "type", CREATURETYPE_PLAYER);
+		} else if (creature->getMonster()) {
+			setField(L, "type", CREATURETYPE_MONSTER);
+		} else {
+			setField(L, "type", CREATURETYPE_NPC);
+		}
+
+		pushPosition(L, creature->getPosition());
+		lua_setfield(L, -2, "position");
+
+		setField(L, "health", creature->getHealth());
+		setField(L, "maxHealth", creature->getMaxHealth());
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int luaGameGetTiles(lua_State* L)
+{
+	// Game.getTiles(fromPosition, toPosition)
+	const Position& fromPosition = getPosition(L, 1);
+	const Position& toPosition = getPosition(L, 2);
+	const uint16_t startX = std::min(fromPosition.x, toPosition.x), endX = std::max(fromPosition.x, toPosition.x);
+	const uint16_t startY = std::min(fromPosition.y, toPosition.y), endY = std::max(fromPosition.y, toPosition.y);
+	const uint8_t startZ = std::min(fromPosition.z, toPosition.z), endZ = std::max(fromPosition.z, toPosition.z);
+	const uint16_t width = endX - startX + 1;
+
+	lua_newtable(L);
+
+	// a band of chunk rows at a time, so a large area does not need a buffer for all of it
+	std::vector<Tile*> tiles;
+	int index = 0;
+	for (uint32_t z = startZ; z <= endZ; ++z) {
+		for (uint32_t y = startY; y <= endY; y += MAP_CHUNK_SIZE) {
+			const uint16_t height = static_cast<uint16_t>(std::min<uint32_t>(MAP_CHUNK_SIZE, endY - y + 1));
+			tiles.resize(width * height);
+			g_game.map.getTiles(startX, static_cast<uint16_t>(y), static_cast<uint8_t>(z), width, height, tiles.data());
+			for (Tile* tile : tiles) {
+				if (tile) {
+					pushUserdata<Tile>(L, tile);
+					setMetatable(L, -1, "Tile");
+					lua_rawseti(L, -2, ++index);
+				}
+			}
+		}
+	}
+	return 1;
+}
+
 int luaGameGetPlayers(lua_State* L)
 {
 	// Game.getPlayers()
@@ -125,14 +232,13 @@ int luaGameGetNpcCount(lua_State* L)
 int luaGameGetMonsterTypes(lua_State* L)
 {
 	// Game.getMonsterTypes()
-	auto& type = g_monsters.monsters;
-	lua_createtable(L, type.size(), 0);
+	lua_createtable(L, 0, 0);
 
-	for (auto& mType : type) {
-		pushUserdata<MonsterType>(L, &mType.second);
+	g_monsters.forEachMonsterType([L](const std::string& name, MonsterType& mType) {
+		pushUserdata<MonsterType>(L, &mType);
 		setMetatable(L, -1, "MonsterType");
-		lua_setfield(L, -2, mType.first.c_str());
-	}
+		lua_setfield(L, -2, name.c_str());
+	});
 	return 1;
 }
 
@@ -313,7 +419,7 @@ int luaGameGetReturnMessage(lua_State* L)
 int luaGameGetItemAttributeByName(lua_State* L)
 {
 	// Game.getItemAttributeByName(name)
-	lua_pushinteger(L, stringToItemAttribute(getString(L, 1)));
+	lua_pushinteger(L, stringToItemAttribute(getStringView(L, 1)));
 	return 1;
 }
 
@@ -325,7 +431,7 @@ int luaGameCreateItem(lua_State* L)
 	if (isInteger(L, 1)) {
 		id = getInteger<uint16_t>(L, 1);
 	} else {
-		id = Item::items.getItemIdByName(getString(L, 1));
+		id = Item::items.getItemIdByName(getStringView(L, 1));
 		if (id == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -371,7 +477,7 @@ int luaGameCreateContainer(lua_State* L)
 	if (isInteger(L, 1)) {
 		id = getInteger<uint16_t>(L, 1);
 	} else {
-		id = Item::items.getItemIdByName(getString(L, 1));
+		id = Item::items.getItemIdByName(getStringView(L, 1));
 		if (id == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -462,7 +568,7 @@ int luaGameCreateTile(lua_State* L)
 	// Game.createTile(position[, isDynamic = false])
 	Position position;
 	bool isDynamic;
-	if (isTable(L, 1)) {
+	if (isPosition(L, 1)) {
 		position = getPosition(L, 1);
 		isDynamic = getBoolean(L, 2, false);
 	} else {
@@ -505,13 +611,16 @@ int luaGameCreateMonsterType(lua_State* L)
 
 	MonsterType* monsterType = g_monsters.getMonsterType(name, false);
 	if (!monsterType) {
-		monsterType = &g_monsters.monsters[boost::algorithm::to_lower_copy<std::string>(name)];
+		monsterType = g_monsters.addMonsterType(name);
 		monsterType->name = name;
 		monsterType->nameDescription = "a " + name;
 	} else {
 		monsterType->info.lootItems.clear();
+		monsterType->info.lootTable.clear();
 		monsterType->info.attackSpells.clear();
 		monsterType->info.defenseSpells.clear();
+		monsterType->info.attackSchedule = {};
+		monsterType->info.defenseSchedule = {};
 		monsterType->info.scripts.clear();
 		monsterType->info.thinkEvent = -1;
 		monsterType->info.creatureAppearEvent = -1;
@@ -592,8 +701,41 @@ int luaGameGetClientVersion(lua_State* L)
 
 int luaGameReload(lua_State* L)
 {
-	// Game.reload(reloadType)
+	// Game.reload(reloadType[, callback])
 	ReloadTypes_t reloadType = getInteger<ReloadTypes_t>(L, 1);
+	if (reloadType != RELOAD_TYPE_GLOBAL && isFunction(L, 2)) {
+		// the reload runs in the background and callback(reloaded) is called once it was swapped in
+		LuaEnvironment* environment = &getLuaEnvironment(L);
+		lua_pushvalue(L, 2);
+		int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
+		auto scriptId = LuaScriptInterface::getScriptEnv()->getScriptId();
+		const bool started = g_game.reloadInBackground(reloadType, [environment, ref, scriptId](bool reloaded) {
+			lua_State* luaState = environment->getLuaState();
+			if (!luaState) {
+				return;
+			}
+
+			if (!LuaScriptInterface::reserveScriptEnv()) {
+				luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
+				return;
+			}
+
+			lua_rawgeti(luaState, LUA_REGISTRYINDEX, ref);
+			pushBoolean(luaState, reloaded);
+			LuaScriptInterface::getScriptEnv()->setScriptId(scriptId, environment);
+			environment->callFunction(1);
+
+			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
+			lua_gc(luaState, LUA_GCCOLLECT, 0);
+		});
+
+		if (!started) {
+			luaL_unref(L, LUA_REGISTRYINDEX, ref);
+		}
+		pushBoolean(L, started);
+		return 1;
+	}
+
 	if (reloadType == RELOAD_TYPE_GLOBAL) {
 		pushBoolean(L, g_luaEnvironment.loadFile("data/global.lua") == 0);
 		pushBoolean(L, g_scripts->loadScripts("scripts/lib", true, true));
@@ -638,6 +780,16 @@ int luaGameSaveAccountStorageValues(lua_State* L)
 	return 1;
 }
 
+int luaGameClearLoginCache(lua_State* L)
+{
+	// Game.clearLoginCache()
+	IOLoginData::clearAccountCache();
+	IOBan::clearCache();
+	pushBoolean(L, true);
+
+	return 1;
+}
+
 int luaGameGetWaypoints(lua_State* L)
 {
 	// Game.getWaypoints()
@@ -706,6 +858,331 @@ int luaGameSaveGameStorageValues(lua_State* L)
 
 	return 1;
 }
+
+int luaGameGetDispatcherStats(lua_State* L)
+{
+	// Game.getDispatcherStats([reset = false])
+	const auto& stats = g_dispatcher.getTaskStats();
+	lua_createtable(L, static_cast<int>(stats.size()), 0);
+
+	int index = 0;
+	stats.forEach([L, &index](TaskOrigin origin, const DispatcherTaskStats& entry) {
+		lua_createtable(L, 0, 10);
+		setField(L, "origin", origin);
+		setField(L, "name", getTaskOriginName(origin));
+		setField(L, "kind", getTaskOriginKind(origin));
+		setField(L, "detail", getTaskOriginDetail(origin));
+		setField(L, "count", entry.count);
+		setField(L, "totalTime", entry.totalExecutionTime);
+		setField(L, "maxTime", entry.maxExecutionTime);
+		setField(L, "p99Time", entry.getExecutionPercentile(0.99));
+		setField(L, "waitTime", entry.totalWaitTime);
+		setField(L, "p99Wait", entry.getWaitPercentile(0.99));
+		lua_rawseti(L, -2, ++index);
+	});
+
+	if (getBoolean(L, 1, false)) {
+		g_dispatcher.resetTaskStats();
+	}
+	return 1;
+}
+
+int luaGameGetLuaTimerCount(lua_State* L)
+{
+	// Game.getLuaTimerCount()
+	lua_pushinteger(L, g_luaEnvironment.getTimerEventCount());
+	return 1;
+}
+
+int luaGameGetLuaGcStats(lua_State* L)
+{
+	// Game.getLuaGcStats([reset = false])
+	const LuaGcStats& stats = g_luaEnvironment.getGcStats();
+	lua_createtable(L, 0, 6);
+	setField(L, "steps", stats.steps);
+	setField(L, "cycles", stats.cycles);
+	setField(L, "totalTime", stats.totalTime);
+	setField(L, "maxStepTime", stats.maxStepTime);
+	setField(L, "lastCycleTime", stats.lastCycleTime);
+	setField(L, "memory", lua_gc(g_luaEnvironment.getLuaState(), LUA_GCCOUNT, 0));
+
+	if (getBoolean(L, 1, false)) {
+		g_luaEnvironment.resetGcStats();
+	}
+	return 1;
+}
+
+int luaGameGetLuaAllocatorStats(lua_State* L)
+{
+	// Game.getLuaAllocatorStats()
+	const LuaAllocator::Stats& stats = g_luaEnvironment.getAllocatorStats();
+	lua_createtable(L, 0, 6);
+	setField(L, "liveBytes", stats.liveBytes);
+	setField(L, "arenaBytes", stats.arenaBytes);
+	setField(L, "allocations", stats.allocations);
+	setField(L, "largeLive", stats.largeLive);
+	setField(L, "largeAllocations", stats.largeAllocations);
+
+	lua_createtable(L, LuaAllocator::SIZE_CLASSES, 0);
+	for (size_t i = 0; i < LuaAllocator::SIZE_CLASSES; ++i) {
+		lua_createtable(L, 0, 3);
+		setField(L, "size", (i + 1) * LuaAllocator::GRANULARITY);
+		setField(L, "live", stats.sizeClasses[i].live);
+		setField(L, "allocations", stats.sizeClasses[i].allocations);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "sizeClasses");
+	return 1;
+}
+
+int luaGameSetLuaProfilerEnabled(lua_State* L)
+{
+	// Game.setLuaProfilerEnabled(enabled)
+	g_luaProfiler.setEnabled(getBoolean(L, 1));
+	pushBoolean(L, true);
+	return 1;
+}
+
+int luaGameIsLuaProfilerEnabled(lua_State* L)
+{
+	// Game.isLuaProfilerEnabled()
+	pushBoolean(L, g_luaProfiler.isEnabled());
+	return 1;
+}
+
+int luaGameGetLuaProfilerStats(lua_State* L)
+{
+	// Game.getLuaProfilerStats([reset = false])
+	const auto& entries = g_luaProfiler.getEntries();
+	lua_createtable(L, static_cast<int>(entries.size()), 0);
+
+	int index = 0;
+	for (const LuaProfilerEntry& entry : entries) {
+		lua_createtable(L, 0, 5);
+		setField(L, "interface", entry.interfaceName);
+		setField(L, "file", entry.file);
+		setField(L, "count", entry.count);
+		setField(L, "totalTime", entry.totalTime);
+		setField(L, "selfTime", entry.selfTime);
+		lua_rawseti(L, -2, ++index);
+	}
+
+	if (getBoolean(L, 1, false)) {
+		g_luaProfiler.reset();
+	}
+	return 1;
+}
+
+int luaGameGetLuaProfilerDump(lua_State* L)
+{
+	// Game.getLuaProfilerDump([reset = false])
+	pushString(L, g_luaProfiler.dump());
+	if (getBoolean(L, 1, false)) {
+		g_luaProfiler.reset();
+	}
+	return 1;
+}
+
+int luaGameGetPacketStats(lua_State* L)
+{
+	// Game.getPacketStats()
+	lua_newtable(L);
+	for (uint32_t opcode = 0; opcode <= std::numeric_limits<uint8_t>::max(); ++opcode) {
+		const uint64_t count = metrics::packetsReceived(opcode).value();
+		if (count == 0) {
+			continue;
+		}
+
+		lua_createtable(L, 0, 4);
+		setField(L, "count", count);
+		setField(L, "bytes", metrics::packetBytes(opcode).value());
+		setField(L, "executionTime", metrics::packetExecutionTime(opcode).value());
+		setField(L, "waitTime", metrics::packetWaitTime(opcode).value());
+		lua_rawseti(L, -2, opcode);
+	}
+	return 1;
+}
+
+int luaGameGetSlowTicks(lua_State* L)
+{
+	// Game.getSlowTicks([clear = false])
+	const auto& ticks = g_tickProfiler.getSlowTicks();
+	lua_createtable(L, static_cast<int>(ticks.size()), 0);
+
+	int index = 0;
+	for (const TickRecord& tick : ticks) {
+		lua_createtable(L, 0, 6);
+		setField(L, "start", tick.start);
+		setField(L, "duration", tick.duration);
+		setField(L, "busy", tick.busy);
+		setField(L, "luaTime", tick.luaTime);
+		setField(L, "tasks", tick.tasks);
+
+		lua_createtable(L, 0, TICK_PHASE_COUNT);
+		for (uint8_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+			setField(L, getTickPhaseName(static_cast<TickPhase>(phase)), tick.phases[phase]);
+		}
+		lua_setfield(L, -2, "phases");
+		lua_rawseti(L, -2, ++index);
+	}
+
+	if (getBoolean(L, 1, false)) {
+		g_tickProfiler.clearSlowTicks();
+	}
+	return 1;
+}
+
+int luaGameGetMemoryStats(lua_State* L)
+{
+	// Game.getMemoryStats()
+	const auto usage = MemoryStats::getUsage();
+	lua_createtable(L, 0, static_cast<int>(usage.size()));
+	for (const MemoryStats::Usage& subsystem : usage) {
+		lua_createtable(L, 0, 2);
+		setField(L, "objects", subsystem.objects);
+		setField(L, "bytes", subsystem.bytes);
+		lua_setfield(L, -2, std::string{subsystem.subsystem}.c_str());
+	}
+	return 1;
+}
+
+int luaGameGetAllocatorStats(lua_State* L)
+{
+	// Game.getAllocatorStats()
+	const MemoryStats::AllocatorUsage usage = MemoryStats::getAllocatorUsage();
+	lua_createtable(L, 0, 4);
+	setField(L, "allocator", usage.allocator);
+	setField(L, "allocated", usage.allocated);
+	setField(L, "held", usage.held);
+	setField(L, "resident", usage.resident);
+	return 1;
+}
+
+int luaGamePurgeAllocator(lua_State* L)
+{
+	// Game.purgeAllocator()
+	lua_pushinteger(L, MemoryStats::purgeAllocator());
+	return 1;
+}
+
+int luaGameStartReplayRecording(lua_State* L)
+{
+	// Game.startReplayRecording(path)
+	pushBoolean(L, g_replayRecorder.start(getString(L, 1)));
+	return 1;
+}
+
+int luaGameStopReplayRecording(lua_State* L)
+{
+	// Game.stopReplayRecording()
+	lua_pushinteger(L, g_replayRecorder.stop());
+	return 1;
+}
+
+int luaGameIsRecordingReplay(lua_State* L)
+{
+	// Game.isRecordingReplay()
+	pushBoolean(L, g_replayRecorder.isRecording());
+	return 1;
+}
+
+int luaGameStartMapClean(lua_State* L)
+{
+	// Game.startMapClean([tilesPerTick = mapCleanTilesPerTick])
+	const auto tilesPerTick = getInteger<uint32_t>(
+	    L, 1, static_cast<uint32_t>(g_config[ConfigKeysInteger::MAP_CLEAN_TILES_PER_TICK]));
+	pushBoolean(L, g_game.map.startIncrementalClean(tilesPerTick));
+	return 1;
+}
+
+int luaGameGetMapCleanProgress(lua_State* L)
+{
+	// Game.getMapCleanProgress()
+	const MapCleanProgress& progress = g_game.map.getCleanProgress();
+	const int64_t endTime = progress.running ? OTSYS_TIME() : progress.endTime;
+
+	lua_createtable(L, 0, 6);
+	pushBoolean(L, progress.running);
+	lua_setfield(L, -2, "running");
+	setField(L, "tiles", progress.tiles);
+	setField(L, "tilesDone", progress.tilesDone);
+	setField(L, "items", progress.items);
+	setField(L, "ticks", progress.ticks);
+	setField(L, "duration", progress.startTime != 0 ? endTime - progress.startTime : 0);
+	return 1;
+}
+
+int luaGameRunAsync(lua_State* L)
+{
+	// Game.runAsync(function, data[, callback])
+	std::string bytecode, error;
+	LuaAsyncValue data;
+	if (!LuaAsync::dump(L, 1, bytecode, error) || !LuaAsync::copy(L, 2, data, error)) {
+		reportErrorFunc(L, error);
+		pushBoolean(L, false);
+		return 1;
+	}
+
+	auto work = [bytecode = std::move(bytecode), data = std::move(data)]() {
+		LuaAsyncResult result;
+		result.success = LuaAsync::run(bytecode, data, result.value, result.error);
+		return result;
+	};
+
+	LuaEnvironment* environment = &getLuaEnvironment(L);
+	if (!isFunction(L, 3)) {
+		if (!lua_isyieldable(L)) {
+			reportErrorFunc(L, "Game.runAsync needs a callback outside of a coroutine started by async.");
+			pushBoolean(L, false);
+			return 1;
+		}
+
+		// without workers there is nothing to wait for
+		if (!g_jobs.isEnabled()) {
+			return pushAsyncResult(L, work());
+		}
+
+		uint32_t coroutineId = environment->suspendCoroutine(L);
+		g_jobs.addJob(std::move(work), [environment, coroutineId](LuaAsyncResult&& result) {
+			environment->resumeCoroutine(coroutineId,
+			                             [&result](lua_State* thread) { return pushAsyncResult(thread, result); });
+		});
+		return lua_yield(L, 0);
+	}
+
+	lua_pushvalue(L, 3);
+	int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	auto scriptId = LuaScriptInterface::getScriptEnv()->getScriptId();
+	auto done = [environment, ref, scriptId](LuaAsyncResult&& result) {
+		lua_State* luaState = environment->getLuaState();
+		if (!luaState) {
+			return;
+		}
+
+		if (!LuaScriptInterface::reserveScriptEnv()) {
+			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
+			return;
+		}
+
+		lua_rawgeti(luaState, LUA_REGISTRYINDEX, ref);
+		const int results = pushAsyncResult(luaState, result);
+		LuaScriptInterface::getScriptEnv()->setScriptId(scriptId, environment);
+		environment->callFunction(results);
+
+		luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
+	};
+
+	// the callback comes later either way, never from within this call
+	if (!g_jobs.isEnabled()) {
+		g_dispatcher.addTask(std::function<void()>{[done, result = work()]() mutable { done(std::move(result)); }});
+	} else if (!g_jobs.addJob(std::move(work), std::move(done))) {
+		luaL_unref(L, LUA_REGISTRYINDEX, ref);
+		pushBoolean(L, false);
+		return 1;
+	}
+	pushBoolean(L, true);
+	return 1;
+}
 } // namespace
 
 void LuaScriptInterface::registerGame()
@@ -714,6 +1191,8 @@ void LuaScriptInterface::registerGame()
 	registerTable("Game");
 
 	registerMethod("Game", "getSpectators", luaGameGetSpectators);
+	registerMethod("Game", "getSpectatorsInfo", luaGameGetSpectatorsInfo);
+	registerMethod("Game", "getTiles", luaGameGetTiles);
 	registerMethod("Game", "getPlayers", luaGameGetPlayers);
 	registerMethod("Game", "loadMap", luaGameLoadMap);
 
@@ -760,10 +1239,36 @@ void LuaScriptInterface::registerGame()
 	registerMethod("Game", "setAccountStorageValue", luaGameSetAccountStorageValue);
 	registerMethod("Game", "saveAccountStorageValues", luaGameSaveAccountStorageValues);
 
+	registerMethod("Game", "clearLoginCache", luaGameClearLoginCache);
+
 	registerMethod("Game", "getWaypoints", luaGameGetWaypoints);
 	registerMethod("Game", "getThingFromClientPos", luaGameGetThingFromClientPos);
 
 	registerMethod("Game", "getStorageValue", luaGameGetGameStorageValue);
 	registerMethod("Game", "setStorageValue", luaGameSetGameStorageValue);
 	registerMethod("Game", "saveStorageValues", luaGameSaveGameStorageValues);
+
+	registerMethod("Game", "getDispatcherStats", luaGameGetDispatcherStats);
+	registerMethod("Game", "getLuaTimerCount", luaGameGetLuaTimerCount);
+	registerMethod("Game", "getLuaGcStats", luaGameGetLuaGcStats);
+	registerMethod("Game", "getLuaAllocatorStats", luaGameGetLuaAllocatorStats);
+
+	registerMethod("Game", "setLuaProfilerEnabled", luaGameSetLuaProfilerEnabled);
+	registerMethod("Game", "isLuaProfilerEnabled", luaGameIsLuaProfilerEnabled);
+	registerMethod("Game", "getLuaProfilerStats", luaGameGetLuaProfilerStats);
+	registerMethod("Game", "getLuaProfilerDump", luaGameGetLuaProfilerDump);
+	registerMethod("Game", "getSlowTicks", luaGameGetSlowTicks);
+	registerMethod("Game", "getPacketStats", luaGameGetPacketStats);
+	registerMethod("Game", "getMemoryStats", luaGameGetMemoryStats);
+	registerMethod("Game", "getAllocatorStats", luaGameGetAllocatorStats);
+	registerMethod("Game", "purgeAllocator", luaGamePurgeAllocator);
+
+	registerMethod("Game", "startReplayRecording", luaGameStartReplayRecording);
+	registerMethod("Game", "stopReplayRecording", luaGameStopReplayRecording);
+	registerMethod("Game", "isRecordingReplay", luaGameIsRecordingReplay);
+
+	registerMethod("Game", "startMapClean", luaGameStartMapClean);
+	registerMethod("Game", "getMapCleanProgress", luaGameGetMapCleanProgress);
+
+	registerMethod("Game", "runAsync", luaGameRunAsync);
 }
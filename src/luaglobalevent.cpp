@@ -28,6 +28,7 @@ int luaCreateGlobalEvent(lua_State* L)
 	global->setName(getString(L, 2));
 	global->setEventType(GLOBALEVENT_NONE);
 	global->fromLua = true;
+	global->scriptFile = g_scripts->getLoadingFile();
 	pushUserdata<GlobalEvent>(L, global);
 	setMetatable(L, -1, "GlobalEvent");
 	return 1;
@@ -145,6 +145,39 @@ int luaGuildGetMotd(lua_State* L)
 	return 1;
 }
 
+int luaGuildGetWars(lua_State* L)
+{
+	// guild:getWars()
+	const Guild* guild = getUserdata<const Guild>(L, 1);
+	if (!guild) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const auto& wars = guild->getWars();
+	lua_createtable(L, wars.size(), 0);
+
+	int index = 0;
+	for (uint32_t guildId : wars) {
+		lua_pushinteger(L, guildId);
+		lua_rawseti(L, -2, ++index);
+	}
+	return 1;
+}
+
+int luaGuildSetWar(lua_State* L)
+{
+	// guild:setWar(guildId, active)
+	Guild* guild = getUserdata<Guild>(L, 1);
+	if (guild) {
+		guild->setWar(getInteger<uint32_t>(L, 2), getBoolean(L, 3, true));
+		pushBoolean(L, true);
+	} else {
+		lua_pushnil(L);
+	}
+	return 1;
+}
+
 int luaGuildSetMotd(lua_State* L)
 {
 	// guild:setMotd(motd)
@@ -175,4 +208,7 @@ void LuaScriptInterface::registerGuild()
 
 	registerMethod("Guild", "getMotd", luaGuildGetMotd);
 	registerMethod("Guild", "setMotd", luaGuildSetMotd);
+
+	registerMethod("Guild", "getWars", luaGuildGetWars);
+	registerMethod("Guild", "setWar", luaGuildSetWar);
 }
@@ -363,7 +363,7 @@ int luaItemHasAttribute(lua_State* L)
 	if (isInteger(L, 2)) {
 		attribute = getInteger<itemAttrTypes>(L, 2);
 	} else if (isString(L, 2)) {
-		attribute = stringToItemAttribute(getString(L, 2));
+		attribute = stringToItemAttribute(getStringView(L, 2));
 	} else {
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
@@ -385,7 +385,7 @@ int luaItemGetAttribute(lua_State* L)
 	if (isInteger(L, 2)) {
 		attribute = getInteger<itemAttrTypes>(L, 2);
 	} else if (isString(L, 2)) {
-		attribute = stringToItemAttribute(getString(L, 2));
+		attribute = stringToItemAttribute(getStringView(L, 2));
 	} else {
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
@@ -413,7 +413,7 @@ int luaItemSetAttribute(lua_State* L)
 	if (isInteger(L, 2)) {
 		attribute = getInteger<itemAttrTypes>(L, 2);
 	} else if (isString(L, 2)) {
-		attribute = stringToItemAttribute(getString(L, 2));
+		attribute = stringToItemAttribute(getStringView(L, 2));
 	} else {
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
@@ -426,6 +426,10 @@ int luaItemSetAttribute(lua_State* L)
 		}
 
 		item->setIntAttr(attribute, getInteger<int32_t>(L, 3));
+		if (const Player* player = item->getHoldingPlayer()) {
+			player->invalidateEquipmentStats();
+			player->invalidateItemTypeCounts();
+		}
 		pushBoolean(L, true);
 	} else if (ItemAttributes::isStrAttrType(attribute)) {
 		item->setStrAttr(attribute, getString(L, 3));
@@ -449,7 +453,7 @@ int luaItemRemoveAttribute(lua_State* L)
 	if (isInteger(L, 2)) {
 		attribute = getInteger<itemAttrTypes>(L, 2);
 	} else if (isString(L, 2)) {
-		attribute = stringToItemAttribute(getString(L, 2));
+		attribute = stringToItemAttribute(getStringView(L, 2));
 	} else {
 		attribute = ITEM_ATTRIBUTE_NONE;
 	}
@@ -457,6 +461,10 @@ int luaItemRemoveAttribute(lua_State* L)
 	bool ret = attribute != ITEM_ATTRIBUTE_UNIQUEID;
 	if (ret) {
 		item->removeAttribute(attribute);
+		if (const Player* player = item->getHoldingPlayer()) {
+			player->invalidateEquipmentStats();
+			player->invalidateItemTypeCounts();
+		}
 	} else {
 		reportErrorFunc(L, "Attempt to erase protected key \"uid\"");
 	}
@@ -579,6 +587,9 @@ int luaItemMoveTo(lua_State* L)
 			case LuaData_Tile:
 				toCylinder = getUserdata<Tile>(L, 2);
 				break;
+			case LuaData_Position:
+				toCylinder = g_game.map.getTile(getPosition(L, 2));
+				break;
 			default:
 				toCylinder = nullptr;
 				break;
@@ -633,7 +644,7 @@ int luaItemTransform(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -18,7 +18,7 @@ int luaItemTypeCreate(lua_State* L)
 	if (isInteger(L, 2)) {
 		id = getInteger<uint32_t>(L, 2);
 	} else if (isString(L, 2)) {
-		id = Item::items.getItemIdByName(getString(L, 2));
+		id = Item::items.getItemIdByName(getStringView(L, 2));
 	} else {
 		lua_pushnil(L);
 		return 1;
@@ -39,7 +39,7 @@ int luaLootSetId(lua_State* L)
 			loot->lootBlock.id = getInteger<uint16_t>(L, 2);
 		} else {
 			auto name = getString(L, 2);
-			auto ids = Item::items.nameToItems.equal_range(boost::algorithm::to_lower_copy<std::string>(name));
+			auto ids = Item::items.nameToItems.equal_range(std::string_view{name});
 
 			if (ids.first == Item::items.nameToItems.cend()) {
 				std::cout << "[Warning - Loot:setId] Unknown loot item \"" << name << "\". " << std::endl;
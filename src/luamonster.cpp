@@ -49,7 +49,7 @@ int luaMonsterGetId(lua_State* L)
 	Monster* monster = getUserdata<Monster>(L, 1);
 	if (monster) {
 		// Set monster id if it's not set yet (only for onSpawn event)
-		if (LuaScriptInterface::getScriptEnv()->getScriptId() == g_events->getScriptId(EventInfoId::MONSTER_ONSPAWN)) {
+		if (LuaScriptInterface::getScriptEnv()->getScriptId() == g_events->getScriptId(EventInfoId::MONSTER_ON_SPAWN)) {
 			monster->setID();
 		}
 
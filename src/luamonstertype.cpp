@@ -581,6 +581,7 @@ int luaMonsterTypeAddAttack(lua_State* L)
 			spellBlock_t sb;
 			if (g_monsters.deserializeSpell(spell, sb, monsterType->name)) {
 				monsterType->info.attackSpells.push_back(std::move(sb));
+				monsterType->info.attackSchedule = {};
 			} else {
 				std::cout << monsterType->name << std::endl;
 				std::cout << "[Warning - Monsters::loadMonster] Cant load spell. " << spell->name << std::endl;
@@ -634,6 +635,7 @@ int luaMonsterTypeAddDefense(lua_State* L)
 			spellBlock_t sb;
 			if (g_monsters.deserializeSpell(spell, sb, monsterType->name)) {
 				monsterType->info.defenseSpells.push_back(std::move(sb));
+				monsterType->info.defenseSchedule = {};
 			} else {
 				std::cout << monsterType->name << std::endl;
 				std::cout << "[Warning - Monsters::loadMonster] Cant load spell. " << spell->name << std::endl;
@@ -747,6 +749,19 @@ int luaMonsterTypeAddLoot(lua_State* L)
 	return 1;
 }
 
+int luaMonsterTypeCreateLoot(lua_State* L)
+{
+	// monsterType:createLoot(corpse)
+	MonsterType* monsterType = getUserdata<MonsterType>(L, 1);
+	Container* corpse = getUserdata<Container>(L, 2);
+	if (monsterType && corpse) {
+		pushBoolean(L, monsterType->createLoot(corpse));
+	} else {
+		lua_pushnil(L);
+	}
+	return 1;
+}
+
 int luaMonsterTypeGetCreatureEvents(lua_State* L)
 {
 	// monsterType:getCreatureEvents()
@@ -1181,6 +1196,7 @@ void LuaScriptInterface::registerMonsterType()
 
 	registerMethod("MonsterType", "getLoot", luaMonsterTypeGetLoot);
 	registerMethod("MonsterType", "addLoot", luaMonsterTypeAddLoot);
+	registerMethod("MonsterType", "createLoot", luaMonsterTypeCreateLoot);
 
 	registerMethod("MonsterType", "getCreatureEvents", luaMonsterTypeGetCreatureEvents);
 	registerMethod("MonsterType", "registerEvent", luaMonsterTypeRegisterEvent);
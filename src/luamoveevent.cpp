@@ -25,6 +25,7 @@ int luaCreateMoveEvent(lua_State* L)
 
 	MoveEvent* moveevent = new MoveEvent(LuaScriptInterface::getScriptEnv()->getScriptInterface());
 	moveevent->fromLua = true;
+	moveevent->scriptFile = g_scripts->getLoadingFile();
 	pushUserdata<MoveEvent>(L, moveevent);
 	setMetatable(L, -1, "MoveEvent");
 	return 1;
@@ -247,7 +247,7 @@ int luaNetworkMessageAddItemId(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -21,7 +21,7 @@ int luaNpcCreate(lua_State* L)
 		if (isInteger(L, 2)) {
 			npc = g_game.getNpcByID(getInteger<uint32_t>(L, 2));
 		} else if (isString(L, 2)) {
-			npc = g_game.getNpcByName(getString(L, 2));
+			npc = g_game.getNpcByName(getStringView(L, 2));
 		} else if (isUserdata(L, 2)) {
 			npc = getUserdata<Npc>(L, 2);
 		} else {
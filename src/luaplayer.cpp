@@ -5,6 +5,7 @@
 
 #include "chat.h"
 #include "game.h"
+#include "governor.h"
 #include "iologindata.h"
 #include "luascript.h"
 #include "mounts.h"
@@ -27,13 +28,13 @@ int luaPlayerCreate(lua_State* L)
 	Player* player;
 	if (isInteger(L, 2)) {
 		uint32_t id = getInteger<uint32_t>(L, 2);
-		if (id >= 0x10000000 && id <= Player::playerAutoID) {
+		if (Player::playerIds.isInRange(id)) {
 			player = g_game.getPlayerByID(id);
 		} else {
 			player = g_game.getPlayerByGUID(id);
 		}
 	} else if (isString(L, 2)) {
-		ReturnValue ret = g_game.getPlayerByNameWildcard(getString(L, 2), player);
+		ReturnValue ret = g_game.getPlayerByNameWildcard(getStringView(L, 2), player);
 		if (ret != RETURNVALUE_NOERROR) {
 			lua_pushnil(L);
 			lua_pushinteger(L, ret);
@@ -97,6 +98,76 @@ int luaPlayerGetIp(lua_State* L)
 	return 1;
 }
 
+int luaPlayerGetPacketStats(lua_State* L)
+{
+	// player:getPacketStats()
+	const Player* player = getUserdata<const Player>(L, 1);
+	if (!player) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const ClientPacketStats* stats = player->getPacketStats();
+	if (!stats) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_createtable(L, 0, 3);
+	setField(L, "bytes", stats->getBytes());
+
+	lua_newtable(L);
+	for (uint32_t opcode = 0; opcode <= std::numeric_limits<uint8_t>::max(); ++opcode) {
+		if (uint32_t count = stats->getCount(opcode)) {
+			lua_pushinteger(L, count);
+			lua_rawseti(L, -2, opcode);
+		}
+	}
+	lua_setfield(L, -2, "opcodes");
+
+	const auto& history = stats->getRateHistory(OTSYS_TIME());
+	lua_createtable(L, history.size(), 0);
+	for (size_t i = 0; i < history.size(); ++i) {
+		lua_pushinteger(L, history[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "rate");
+	return 1;
+}
+
+int luaPlayerGetSentStats(lua_State* L)
+{
+	// player:getSentStats()
+	const Player* player = getUserdata<const Player>(L, 1);
+	if (!player) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	const ClientSentStats* stats = player->getSentStats();
+	if (!stats) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_createtable(L, 0, 2);
+
+	lua_createtable(L, 0, OUTBOUND_MESSAGE_LAST);
+	for (uint8_t type = 0; type < OUTBOUND_MESSAGE_LAST; ++type) {
+		setField(L, getOutboundMessageTypeName(static_cast<OutboundMessageType>(type)), stats->bytes[type]);
+	}
+	lua_setfield(L, -2, "bytes");
+
+	const auto& history = stats->rate.get(OTSYS_TIME());
+	lua_createtable(L, history.size(), 0);
+	for (size_t i = 0; i < history.size(); ++i) {
+		lua_pushinteger(L, history[i]);
+		lua_rawseti(L, -2, i + 1);
+	}
+	lua_setfield(L, -2, "rate");
+	return 1;
+}
+
 int luaPlayerGetAccountId(lua_State* L)
 {
 	// player:getAccountId()
@@ -630,7 +701,7 @@ int luaPlayerGetItemCount(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -655,7 +726,7 @@ int luaPlayerGetItemById(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -700,7 +771,7 @@ int luaPlayerSetVocation(lua_State* L)
 	if (isInteger(L, 2)) {
 		vocation = g_vocations.getVocation(getInteger<uint16_t>(L, 2));
 	} else if (isString(L, 2)) {
-		if (auto id = g_vocations.getVocationId(getString(L, 2))) {
+		if (auto id = g_vocations.getVocationId(getStringView(L, 2))) {
 			vocation = g_vocations.getVocation(id.value());
 		} else {
 			vocation = nullptr;
@@ -1019,7 +1090,7 @@ int luaPlayerAddItem(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -1146,7 +1217,7 @@ int luaPlayerRemoveItem(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -1221,7 +1292,7 @@ int luaPlayerShowTextDialog(lua_State* L)
 	if (isInteger(L, 2)) {
 		item = Item::CreateItem(getInteger<uint16_t>(L, 2));
 	} else if (isString(L, 2)) {
-		item = Item::CreateItem(Item::items.getItemIdByName(getString(L, 2)));
+		item = Item::CreateItem(Item::items.getItemIdByName(getStringView(L, 2)));
 	} else if (isUserdata(L, 2)) {
 		if (getUserdataType(L, 2) != LuaData_Item) {
 			pushBoolean(L, false);
@@ -1518,7 +1589,7 @@ int luaPlayerAddMount(lua_State* L)
 	if (isInteger(L, 2)) {
 		mountId = getInteger<uint16_t>(L, 2);
 	} else {
-		Mount* mount = g_game.mounts.getMountByName(getString(L, 2));
+		Mount* mount = g_game.mounts.getMountByName(getStringView(L, 2));
 		if (!mount) {
 			lua_pushnil(L);
 			return 1;
@@ -1543,7 +1614,7 @@ int luaPlayerRemoveMount(lua_State* L)
 	if (isInteger(L, 2)) {
 		mountId = getInteger<uint16_t>(L, 2);
 	} else {
-		Mount* mount = g_game.mounts.getMountByName(getString(L, 2));
+		Mount* mount = g_game.mounts.getMountByName(getStringView(L, 2));
 		if (!mount) {
 			lua_pushnil(L);
 			return 1;
@@ -1568,7 +1639,7 @@ int luaPlayerHasMount(lua_State* L)
 	if (isInteger(L, 2)) {
 		mount = g_game.mounts.getMountByID(getInteger<uint16_t>(L, 2));
 	} else {
-		mount = g_game.mounts.getMountByName(getString(L, 2));
+		mount = g_game.mounts.getMountByName(getStringView(L, 2));
 	}
 
 	if (mount) {
@@ -1786,7 +1857,13 @@ int luaPlayerSave(lua_State* L)
 	Player* player = getUserdata<Player>(L, 1);
 	if (player) {
 		player->setLoginPosition(player->getPosition());
-		pushBoolean(L, IOLoginData::savePlayer(player));
+		if (g_overloadGovernor.isEngaged(OVERLOAD_DEFER_SAVES)) {
+			// the dispatcher does not wait for the database while it is behind
+			IOLoginData::savePlayerAsync(player);
+			pushBoolean(L, true);
+		} else {
+			pushBoolean(L, IOLoginData::savePlayer(player));
+		}
 	} else {
 		lua_pushnil(L);
 	}
@@ -2283,6 +2360,8 @@ void LuaScriptInterface::registerPlayer()
 
 	registerMethod("Player", "getGuid", luaPlayerGetGuid);
 	registerMethod("Player", "getIp", luaPlayerGetIp);
+	registerMethod("Player", "getPacketStats", luaPlayerGetPacketStats);
+	registerMethod("Player", "getSentStats", luaPlayerGetSentStats);
 	registerMethod("Player", "getAccountId", luaPlayerGetAccountId);
 	registerMethod("Player", "getLastLoginSaved", luaPlayerGetLastLoginSaved);
 	registerMethod("Player", "getLastLogout", luaPlayerGetLastLogout);
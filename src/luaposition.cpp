@@ -22,7 +22,7 @@ int luaPositionCreate(lua_State* L)
 	}
 
 	int32_t stackpos;
-	if (isTable(L, 2)) {
+	if (isPosition(L, 2)) {
 		const Position& position = getPosition(L, 2, stackpos);
 		pushPosition(L, position, stackpos);
 	} else {
@@ -36,6 +36,98 @@ int luaPositionCreate(lua_State* L)
 	return 1;
 }
 
+int luaPositionIndex(lua_State* L)
+{
+	// position[key]
+	auto value = static_cast<const LuaPosition*>(lua_touserdata(L, 1));
+	if (value && lua_type(L, 2) == LUA_TSTRING) {
+		size_t length;
+		const char* key = lua_tolstring(L, 2, &length);
+		if (length == 1) {
+			switch (key[0]) {
+				case 'x':
+					lua_pushinteger(L, value->position.x);
+					return 1;
+				case 'y':
+					lua_pushinteger(L, value->position.y);
+					return 1;
+				case 'z':
+					lua_pushinteger(L, value->position.z);
+					return 1;
+				default:
+					break;
+			}
+		} else if (std::string_view{key, length} == "stackpos") {
+			lua_pushinteger(L, value->stackpos);
+			return 1;
+		}
+	}
+
+	// fields added by scripts
+	if (value) {
+		if (lua_getiuservalue(L, 1, 1) == LUA_TTABLE) {
+			lua_pushvalue(L, 2);
+			if (lua_rawget(L, -2) != LUA_TNIL) {
+				return 1;
+			}
+			lua_pop(L, 1);
+		}
+		lua_pop(L, 1);
+	}
+
+	// methods, registerClass stores the class table as __metatable
+	lua_getmetatable(L, 1);
+	lua_getfield(L, -1, "__metatable");
+	lua_pushvalue(L, 2);
+	lua_gettable(L, -2);
+	return 1;
+}
+
+int luaPositionNewIndex(lua_State* L)
+{
+	// position[key] = value
+	auto value = static_cast<LuaPosition*>(lua_touserdata(L, 1));
+	if (!value) {
+		lua_rawset(L, 1);
+		return 0;
+	}
+
+	if (lua_type(L, 2) == LUA_TSTRING) {
+		size_t length;
+		const char* key = lua_tolstring(L, 2, &length);
+		if (length == 1) {
+			switch (key[0]) {
+				case 'x':
+					value->position.x = getInteger<uint16_t>(L, 3);
+					return 0;
+				case 'y':
+					value->position.y = getInteger<uint16_t>(L, 3);
+					return 0;
+				case 'z':
+					value->position.z = getInteger<uint8_t>(L, 3);
+					return 0;
+				default:
+					break;
+			}
+		} else if (std::string_view{key, length} == "stackpos") {
+			value->stackpos = getInteger<int32_t>(L, 3);
+			return 0;
+		}
+	}
+
+	if (lua_getiuservalue(L, 1, 1) != LUA_TTABLE) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+		lua_pushvalue(L, -1);
+		lua_setiuservalue(L, 1, 1);
+	}
+
+	lua_pushvalue(L, 2);
+	lua_pushvalue(L, 3);
+	lua_rawset(L, -3);
+	return 0;
+}
+
 int luaPositionCompare(lua_State* L)
 {
 	// position == positionEx
@@ -102,6 +194,8 @@ void LuaScriptInterface::registerPosition()
 	// Position
 	registerClass("Position", "", luaPositionCreate);
 	registerMetaMethod("Position", "__eq", luaPositionCompare);
+	registerMetaMethod("Position", "__index", luaPositionIndex);
+	registerMetaMethod("Position", "__newindex", luaPositionNewIndex);
 
 	registerMethod("Position", "isSightClear", luaPositionIsSightClear);
 
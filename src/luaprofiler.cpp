@@ -0,0 +1,79 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "luaprofiler.h"
+
+LuaProfiler g_luaProfiler;
+
+void LuaProfiler::enter(std::string_view interfaceName, std::string_view file)
+{
+	std::string key = fmt::format("{}\n{}", interfaceName, file);
+	auto it = frameIds.find(key);
+	if (it == frameIds.end()) {
+		it = frameIds.emplace(std::move(key), static_cast<uint32_t>(frames.size())).first;
+		frames.emplace_back(std::string{interfaceName}, std::string{file});
+	}
+
+	currentStack.push_back(it->second);
+	activeCalls.emplace_back(std::chrono::steady_clock::now());
+}
+
+void LuaProfiler::leave()
+{
+	const ActiveCall call = activeCalls.back();
+	const uint64_t time =
+	    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - call.start).count();
+
+	StackStats& stats = stacks[currentStack];
+	++stats.count;
+	stats.totalTime += time;
+	stats.selfTime += time - std::min(time, call.childTime);
+
+	activeCalls.pop_back();
+	currentStack.pop_back();
+	if (!activeCalls.empty()) {
+		activeCalls.back().childTime += time;
+	}
+}
+
+std::string LuaProfiler::dump() const
+{
+	std::string out;
+	for (const auto& [stack, stats] : stacks) {
+		if (stats.selfTime == 0) {
+			continue;
+		}
+
+		for (uint32_t frameId : stack) {
+			const Frame& frame = frames[frameId];
+			out.append(frame.interfaceName).push_back(';');
+			out.append(frame.file).push_back(';');
+		}
+		out.back() = ' ';
+		out.append(std::to_string(stats.selfTime)).push_back('\n');
+	}
+	return out;
+}
+
+std::vector<LuaProfilerEntry> LuaProfiler::getEntries() const
+{
+	std::vector<LuaProfilerEntry> entries(frames.size());
+	for (size_t i = 0; i < frames.size(); ++i) {
+		entries[i].interfaceName = frames[i].interfaceName;
+		entries[i].file = frames[i].file;
+	}
+
+	for (const auto& [stack, stats] : stacks) {
+		LuaProfilerEntry& entry = entries[stack.back()];
+		entry.count += stats.count;
+		entry.totalTime += stats.totalTime;
+		entry.selfTime += stats.selfTime;
+	}
+
+	std::erase_if(entries, [](const LuaProfilerEntry& entry) { return entry.count == 0; });
+	std::sort(entries.begin(), entries.end(),
+	          [](const LuaProfilerEntry& lhs, const LuaProfilerEntry& rhs) { return lhs.selfTime > rhs.selfTime; });
+	return entries;
+}
@@ -0,0 +1,86 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_LUAPROFILER_H
+#define FS_LUAPROFILER_H
+
+struct LuaProfilerEntry
+{
+	std::string_view interfaceName;
+	std::string_view file;
+	uint64_t count = 0;
+	// microseconds, total includes the calls made from within the script
+	uint64_t totalTime = 0;
+	uint64_t selfTime = 0;
+};
+
+// Attributes the wall time of the calls made through LuaScriptInterface::protectedCall to the script and event they
+// run. Calls made from within another call (a script moving a creature onto a movement tile) are kept apart per call
+// stack so the dump can be fed to flamegraph.pl.
+class LuaProfiler
+{
+public:
+	bool isEnabled() const { return enabled; }
+	void setEnabled(bool enabled) { this->enabled = enabled; }
+	void reset() { stacks.clear(); }
+
+	void enter(std::string_view interfaceName, std::string_view file);
+	void leave();
+
+	// folded call stacks, one "interface;file;interface;file self-time" line per stack
+	std::string dump() const;
+
+	// stats of every script summed over the stacks it was called from
+	std::vector<LuaProfilerEntry> getEntries() const;
+
+	class Scope
+	{
+	public:
+		Scope(LuaProfiler& profiler, std::string_view interfaceName, std::string_view file) : profiler(profiler)
+		{
+			profiler.enter(interfaceName, file);
+		}
+		~Scope() { profiler.leave(); }
+
+		// non-copyable
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		LuaProfiler& profiler;
+	};
+
+private:
+	struct Frame
+	{
+		std::string interfaceName;
+		std::string file;
+	};
+
+	struct StackStats
+	{
+		uint64_t count = 0;
+		uint64_t totalTime = 0;
+		uint64_t selfTime = 0;
+	};
+
+	struct ActiveCall
+	{
+		std::chrono::steady_clock::time_point start;
+		uint64_t childTime = 0;
+	};
+
+	std::vector<Frame> frames;
+	std::map<std::string, uint32_t, std::less<>> frameIds;
+	std::map<std::vector<uint32_t>, StackStats> stacks;
+
+	// frame ids of the calls in progress, outermost first
+	std::vector<uint32_t> currentStack;
+	std::vector<ActiveCall> activeCalls;
+
+	bool enabled = false;
+};
+
+extern LuaProfiler g_luaProfiler;
+
+#endif // FS_LUAPROFILER_H
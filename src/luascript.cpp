@@ -14,6 +14,8 @@
 #include "events.h"
 #include "game.h"
 #include "housetile.h"
+#include "logger.h"
+#include "luaprofiler.h"
 #include "luavariant.h"
 #include "matrixarea.h"
 #include "monster.h"
@@ -25,8 +27,10 @@
 #include "spectators.h"
 #include "spells.h"
 #include "teleport.h"
+#include "tickprofiler.h"
 
 #include <boost/range/adaptor/reversed.hpp>
+#include <charconv>
 
 extern Chat* g_chat;
 extern Game g_game;
@@ -38,11 +42,15 @@ extern Spells* g_spells;
 ScriptEnvironment::DBResultMap ScriptEnvironment::tempResults;
 uint32_t ScriptEnvironment::lastResultId = 0;
 
-std::multimap<ScriptEnvironment*, Item*> ScriptEnvironment::tempItems;
+std::vector<std::pair<ScriptEnvironment*, Item*>> ScriptEnvironment::tempItems;
 
 LuaEnvironment g_luaEnvironment;
 
-ScriptEnvironment::ScriptEnvironment() { resetEnv(); }
+ScriptEnvironment::ScriptEnvironment()
+{
+	localMap.reserve(8);
+	resetEnv();
+}
 
 ScriptEnvironment::~ScriptEnvironment() { resetEnv(); }
 
@@ -52,17 +60,19 @@ void ScriptEnvironment::resetEnv()
 	callbackId = 0;
 	timerEvent = false;
 	interface = nullptr;
+	if (isClean()) {
+		return;
+	}
+
 	localMap.clear();
 	tempResults.clear();
 
-	auto pair = tempItems.equal_range(this);
-	auto it = pair.first;
-	while (it != pair.second) {
-		Item* item = it->second;
+	while (!tempItems.empty() && tempItems.back().first == this) {
+		Item* item = tempItems.back().second;
 		if (item && item->getParent() == VirtualCylinder::virtualCylinder) {
 			g_game.ReleaseItem(item);
 		}
-		it = tempItems.erase(it);
+		tempItems.pop_back();
 	}
 }
 
@@ -112,16 +122,18 @@ uint32_t ScriptEnvironment::addThing(Thing* thing)
 		}
 	}
 
-	localMap[++lastUID] = item;
+	localMap.emplace_back(++lastUID, item);
 	return lastUID;
 }
 
 void ScriptEnvironment::insertItem(uint32_t uid, Item* item)
 {
-	auto result = localMap.emplace(uid, item);
-	if (!result.second) {
+	auto it = std::find_if(localMap.begin(), localMap.end(), [uid](const auto& entry) { return entry.first == uid; });
+	if (it != localMap.end()) {
 		std::cout << std::endl << "Lua Script Error: Thing uid already taken.";
+		return;
 	}
+	localMap.emplace_back(uid, item);
 }
 
 Thing* ScriptEnvironment::getThingByUID(uint32_t uid)
@@ -138,7 +150,7 @@ Thing* ScriptEnvironment::getThingByUID(uint32_t uid)
 		return nullptr;
 	}
 
-	auto it = localMap.find(uid);
+	auto it = std::find_if(localMap.begin(), localMap.end(), [uid](const auto& entry) { return entry.first == uid; });
 	if (it != localMap.end()) {
 		Item* item = it->second;
 		if (!item->isRemoved()) {
@@ -173,21 +185,21 @@ void ScriptEnvironment::removeItemByUID(uint32_t uid)
 		return;
 	}
 
-	auto it = localMap.find(uid);
+	auto it = std::find_if(localMap.begin(), localMap.end(), [uid](const auto& entry) { return entry.first == uid; });
 	if (it != localMap.end()) {
 		localMap.erase(it);
 	}
 }
 
-void ScriptEnvironment::addTempItem(Item* item) { tempItems.emplace(this, item); }
+void ScriptEnvironment::addTempItem(Item* item) { tempItems.emplace_back(this, item); }
 
 void ScriptEnvironment::removeTempItem(Item* item)
 {
-	for (auto it = tempItems.begin(), end = tempItems.end(); it != end; ++it) {
-		if (it->second == item) {
-			tempItems.erase(it);
-			break;
-		}
+	// called for every item removed from the map, almost always with no temporary items at all
+	auto it =
+	    std::find_if(tempItems.begin(), tempItems.end(), [item](const auto& entry) { return entry.second == item; });
+	if (it != tempItems.end()) {
+		tempItems.erase(it);
 	}
 }
 
@@ -256,6 +268,29 @@ std::string_view LuaScriptInterface::getErrorDesc(LuaErrorCode code)
 ScriptEnvironment LuaScriptInterface::scriptEnv[16];
 int32_t LuaScriptInterface::scriptEnvIndex = -1;
 
+void LuaScriptInterface::resetScriptEnv()
+{
+	assert(scriptEnvIndex >= 0);
+	ScriptEnvironment& env = scriptEnv[scriptEnvIndex--];
+	if (!g_luaProfiler.isEnabled() || env.isClean()) {
+		env.resetEnv();
+		return;
+	}
+
+	// releasing what a call created is profiled apart, under the script that created it
+	int32_t scriptId, callbackId;
+	bool timerEvent;
+	LuaScriptInterface* scriptInterface;
+	env.getEventInfo(scriptId, scriptInterface, callbackId, timerEvent);
+
+	std::optional<LuaProfiler::Scope> profilerScope;
+	if (scriptInterface) {
+		profilerScope.emplace(g_luaProfiler, "ScriptEnvironment",
+		                      scriptInterface->getFileById(callbackId != 0 ? callbackId : scriptId));
+	}
+	env.resetEnv();
+}
+
 LuaScriptInterface::LuaScriptInterface(std::string_view interfaceName) : interfaceName{interfaceName}
 {
 	if (!g_luaEnvironment.getLuaState()) {
@@ -281,15 +316,89 @@ int LuaScriptInterface::protectedCall(lua_State* L, int nargs, int nresults)
 	lua_pushcfunction(L, luaErrorHandler);
 	lua_insert(L, error_index);
 
+	std::optional<LuaProfiler::Scope> profilerScope;
+	if (g_luaProfiler.isEnabled()) {
+		int32_t scriptId, callbackId;
+		bool timerEvent;
+		LuaScriptInterface* scriptInterface;
+		getScriptEnv()->getEventInfo(scriptId, scriptInterface, callbackId, timerEvent);
+		if (scriptInterface) {
+			std::string_view file = scriptInterface->getFileById(callbackId != 0 ? callbackId : scriptId);
+			profilerScope.emplace(g_luaProfiler, scriptInterface->getInterfaceName(),
+			                      timerEvent ? fmt::format("{}:addEvent", file) : std::string{file});
+		}
+	}
+
+	TickProfiler::LuaScope tickScope;
 	int ret = lua_pcall(L, nargs, nresults, error_index);
 	lua_remove(L, error_index);
 	return ret;
 }
 
+namespace {
+
+// compiled chunks of the files loaded through loadFile, a file is only parsed again once it changed on disk, npc
+// libraries and scripts shared by many npcs and whole script reloads then skip the compiler
+struct LuaChunkCacheEntry
+{
+	std::filesystem::file_time_type lastWriteTime;
+	uintmax_t fileSize;
+	std::string bytecode;
+};
+
+std::map<std::string, LuaChunkCacheEntry, std::less<>> chunkCache;
+
+int writeChunk(lua_State*, const void* p, size_t size, void* ud)
+{
+	static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+	return 0;
+}
+
+int loadChunk(lua_State* L, std::string_view file)
+{
+	std::error_code ec;
+	const auto lastWriteTime = std::filesystem::last_write_time(file, ec);
+	const uintmax_t fileSize = ec ? 0 : std::filesystem::file_size(file, ec);
+	if (ec) {
+		// let lua report the missing file
+		return luaL_loadfile(L, file.data());
+	}
+
+	auto it = chunkCache.find(file);
+	if (it != chunkCache.end()) {
+		const LuaChunkCacheEntry& entry = it->second;
+		if (entry.lastWriteTime == lastWriteTime && entry.fileSize == fileSize) {
+			const std::string chunkName = fmt::format("@{}", file);
+			return luaL_loadbuffer(L, entry.bytecode.data(), entry.bytecode.size(), chunkName.c_str());
+		}
+	}
+
+	int ret = luaL_loadfile(L, file.data());
+	if (ret != 0) {
+		if (it != chunkCache.end()) {
+			chunkCache.erase(it);
+		}
+		return ret;
+	}
+
+	std::string bytecode;
+#ifdef LUAJIT_VERSION
+	const int dumped = lua_dump(L, writeChunk, &bytecode);
+#else
+	const int dumped = lua_dump(L, writeChunk, &bytecode, 0);
+#endif
+	if (dumped == 0) {
+		chunkCache.insert_or_assign(std::string{file}, LuaChunkCacheEntry{lastWriteTime, fileSize, std::move(bytecode)});
+	}
+	return ret;
+}
+
+} // namespace
+
 int32_t LuaScriptInterface::loadFile(std::string_view file, Npc* npc /* = nullptr*/)
 {
 	// loads file as a chunk at stack top
-	int ret = luaL_loadfile(luaState, file.data());
+	int ret = loadChunk(luaState, file);
 	if (ret != 0) {
 		lastLuaError = Lua::popString(luaState);
 		return -1;
@@ -470,31 +579,34 @@ void LuaScriptInterface::reportError(const char* function, std::string_view erro
 	LuaScriptInterface* scriptInterface;
 	getScriptEnv()->getEventInfo(scriptId, scriptInterface, callbackId, timerEvent);
 
-	std::cout << std::endl << "Lua Script Error: ";
+	// one line for the logger, an error storm is collapsed instead of stalling the dispatcher on the console
+	std::string message = "Lua Script Error: ";
 
 	if (scriptInterface) {
-		std::cout << '[' << scriptInterface->getInterfaceName() << "] " << std::endl;
+		message += fmt::format("[{:s}]\n", scriptInterface->getInterfaceName());
 
 		if (timerEvent) {
-			std::cout << "in a timer event called from: " << std::endl;
+			message += "in a timer event called from:\n";
 		}
 
 		if (callbackId) {
-			std::cout << "in callback: " << scriptInterface->getFileById(callbackId) << std::endl;
+			message += fmt::format("in callback: {:s}\n", scriptInterface->getFileById(callbackId));
 		}
 
-		std::cout << scriptInterface->getFileById(scriptId) << std::endl;
+		message += scriptInterface->getFileById(scriptId);
+		message.push_back('\n');
 	}
 
 	if (function) {
-		std::cout << function << "(). ";
+		message += fmt::format("{:s}(). ", function);
 	}
 
 	if (L && stack_trace) {
-		std::cout << getStackTrace(L, error_desc) << std::endl;
+		message += getStackTrace(L, error_desc);
 	} else {
-		std::cout << error_desc << std::endl;
+		message += error_desc;
 	}
+	Logger::write(LOG_ERROR, "", std::move(message));
 }
 
 bool LuaScriptInterface::pushFunction(int32_t functionId)
@@ -621,6 +733,104 @@ void Lua::pushVariant(lua_State* L, const LuaVariant& var)
 	setMetatable(L, -1, "Variant");
 }
 
+namespace {
+
+// the address is the registry key of the weak valued table with the userdata of each creature by id
+const int creatureUserdataKey = 0;
+// main states of the environments, every one of them has such a table
+std::vector<lua_State*> userdataCacheStates;
+
+} // namespace
+
+void Lua::pushCreatureUserdata(lua_State* L, const Creature* creature, int nuvalue)
+{
+	// creatures that are not in game have no id yet, temporary players all share 0
+	const uint32_t creatureId = creature ? creature->getID() : 0;
+	if (creatureId == 0 || lua_rawgetp(L, LUA_REGISTRYINDEX, &creatureUserdataKey) != LUA_TTABLE) {
+		if (creatureId != 0) {
+			lua_pop(L, 1);
+		}
+
+		auto userdata = static_cast<const Creature**>(lua_newuserdatauv(L, sizeof(Creature*), nuvalue));
+		*userdata = creature;
+		return;
+	}
+
+	if (lua_rawgeti(L, -1, creatureId) == LUA_TUSERDATA) {
+		lua_remove(L, -2);
+		return;
+	}
+	lua_pop(L, 1);
+
+	auto userdata = static_cast<const Creature**>(lua_newuserdatauv(L, sizeof(Creature*), nuvalue));
+	*userdata = creature;
+	lua_pushvalue(L, -1);
+	lua_rawseti(L, -3, creatureId);
+	lua_remove(L, -2);
+}
+
+template <>
+void Lua::pushUserdata<Creature>(lua_State* L, Creature* value, int nuvalue)
+{
+	pushCreatureUserdata(L, value, nuvalue);
+}
+
+template <>
+void Lua::pushUserdata<const Creature>(lua_State* L, const Creature* value, int nuvalue)
+{
+	pushCreatureUserdata(L, value, nuvalue);
+}
+
+template <>
+void Lua::pushUserdata<Player>(lua_State* L, Player* value, int nuvalue)
+{
+	pushCreatureUserdata(L, value, nuvalue);
+}
+
+template <>
+void Lua::pushUserdata<const Player>(lua_State* L, const Player* value, int nuvalue)
+{
+	pushCreatureUserdata(L, value, nuvalue);
+}
+
+template <>
+void Lua::pushUserdata<Monster>(lua_State* L, Monster* value, int nuvalue)
+{
+	pushCreatureUserdata(L, value, nuvalue);
+}
+
+template <>
+void Lua::pushUserdata<Npc>(lua_State* L, Npc* value, int nuvalue)
+{
+	pushCreatureUserdata(L, value, nuvalue);
+}
+
+void Lua::createUserdataCache(lua_State* L)
+{
+	lua_createtable(L, 0, 0);
+	lua_createtable(L, 0, 1);
+	setField(L, "__mode", "v");
+	lua_setmetatable(L, -2);
+	lua_rawsetp(L, LUA_REGISTRYINDEX, &creatureUserdataKey);
+	userdataCacheStates.push_back(L);
+}
+
+void Lua::closeUserdataCache(lua_State* L) { std::erase(userdataCacheStates, L); }
+
+void Lua::releaseCreatureUserdata(uint32_t creatureId)
+{
+	for (lua_State* L : userdataCacheStates) {
+		lua_rawgetp(L, LUA_REGISTRYINDEX, &creatureUserdataKey);
+		if (lua_rawgeti(L, -1, creatureId) == LUA_TUSERDATA) {
+			// scripts that kept it find no creature in it anymore instead of a freed one
+			*static_cast<Creature**>(lua_touserdata(L, -1)) = nullptr;
+			lua_pushnil(L);
+			lua_rawseti(L, -3, creatureId);
+		}
+		lua_pop(L, 2);
+	}
+}
+
 void Lua::pushThing(lua_State* L, Thing* thing)
 {
 	if (!thing) {
@@ -665,6 +875,14 @@ void Lua::pushString(lua_State* L, std::string_view value) { lua_pushlstring(L,
 
 void Lua::pushCallback(lua_State* L, int32_t callback) { lua_rawgeti(L, LUA_REGISTRYINDEX, callback); }
 
+LuaEnvironment& Lua::getLuaEnvironment(lua_State* L)
+{
+	lua_getfield(L, LUA_REGISTRYINDEX, "environment");
+	auto environment = static_cast<LuaEnvironment*>(lua_touserdata(L, -1));
+	lua_pop(L, 1);
+	return environment ? *environment : g_luaEnvironment;
+}
+
 std::string Lua::popString(lua_State* L)
 {
 	if (lua_gettop(L) == 0) {
@@ -751,6 +969,10 @@ bool Lua::isBoolean(lua_State* L, int32_t arg) { return lua_isboolean(L, arg); }
 bool Lua::isTable(lua_State* L, int32_t arg) { return lua_istable(L, arg); }
 bool Lua::isFunction(lua_State* L, int32_t arg) { return lua_isfunction(L, arg); }
 bool Lua::isUserdata(lua_State* L, int32_t arg) { return lua_isuserdata(L, arg) != 0; }
+bool Lua::isPosition(lua_State* L, int32_t arg)
+{
+	return lua_istable(L, arg) || luaL_testudata(L, arg, "Position") != nullptr;
+}
 
 // Get
 bool Lua::getBoolean(lua_State* L, int32_t arg) { return lua_toboolean(L, arg) != 0; }
@@ -773,8 +995,23 @@ std::string Lua::getString(lua_State* L, int32_t arg)
 	return {c_str, len};
 }
 
+std::string_view Lua::getStringView(lua_State* L, int32_t arg)
+{
+	size_t len;
+	const char* c_str = lua_tolstring(L, arg, &len);
+	if (!c_str) {
+		return {};
+	}
+	return {c_str, len};
+}
+
 Position Lua::getPosition(lua_State* L, int32_t arg, int32_t& stackpos)
 {
+	if (auto value = static_cast<const LuaPosition*>(luaL_testudata(L, arg, "Position"))) {
+		stackpos = value->stackpos;
+		return value->position;
+	}
+
 	Position position;
 	position.x = getField<uint16_t>(L, arg, "x");
 	position.y = getField<uint16_t>(L, arg, "y");
@@ -793,6 +1030,10 @@ Position Lua::getPosition(lua_State* L, int32_t arg, int32_t& stackpos)
 
 Position Lua::getPosition(lua_State* L, int32_t arg)
 {
+	if (auto value = static_cast<const LuaPosition*>(luaL_testudata(L, arg, "Position"))) {
+		return value->position;
+	}
+
 	Position position;
 	position.x = getField<uint16_t>(L, arg, "x");
 	position.y = getField<uint16_t>(L, arg, "y");
@@ -1007,13 +1248,8 @@ void Lua::pushSpell(lua_State* L, const Spell& spell)
 
 void Lua::pushPosition(lua_State* L, const Position& position, int32_t stackpos /* = 0*/)
 {
-	lua_createtable(L, 0, 4);
-
-	setField(L, "x", position.x);
-	setField(L, "y", position.y);
-	setField(L, "z", position.z);
-	setField(L, "stackpos", stackpos);
-
+	// the associated value holds the fields scripts add to the position
+	new (lua_newuserdatauv(L, sizeof(LuaPosition), 1)) LuaPosition{position, stackpos};
 	setMetatable(L, -1, "Position");
 }
 
@@ -1150,6 +1386,18 @@ void LuaScriptInterface::registerFunctions()
 	// stopEvent(eventid)
 	lua_register(luaState, "stopEvent", LuaScriptInterface::luaStopEvent);
 
+	// async(callback, ...)
+	lua_register(luaState, "async", LuaScriptInterface::luaAsync);
+
+	// sleep(delay)
+	lua_register(luaState, "sleep", LuaScriptInterface::luaSleep);
+
+	// waitFor(event)
+	lua_register(luaState, "waitFor", LuaScriptInterface::luaWaitFor);
+
+	// notify(event, ...)
+	lua_register(luaState, "notify", LuaScriptInterface::luaNotify);
+
 	// saveServer()
 	lua_register(luaState, "saveServer", LuaScriptInterface::luaSaveServer);
 
@@ -1174,6 +1422,9 @@ void LuaScriptInterface::registerFunctions()
 	// isScriptsInterface()
 	lua_register(luaState, "isScriptsInterface", LuaScriptInterface::luaIsScriptsInterface);
 
+	// getLoadingScriptFile()
+	lua_register(luaState, "getLoadingScriptFile", LuaScriptInterface::luaGetLoadingScriptFile);
+
 	// configManager table
 	luaL_register(luaState, "configManager", LuaScriptInterface::luaConfigManagerTable);
 	lua_pop(luaState, 1);
@@ -2198,6 +2449,16 @@ void LuaScriptInterface::registerFunctions()
 	registerEnumIn("configKeys", ConfigKeysBoolean::MONSTER_OVERSPAWN);
 	registerEnumIn("configKeys", ConfigKeysBoolean::REMOVE_ON_DESPAWN);
 	registerEnumIn("configKeys", ConfigKeysBoolean::ACCOUNT_MANAGER);
+	registerEnumIn("configKeys", ConfigKeysBoolean::MAP_CHUNKED_STORAGE);
+	registerEnumIn("configKeys", ConfigKeysBoolean::BATCH_EFFECTS);
+	registerEnumIn("configKeys", ConfigKeysBoolean::MAP_CACHE);
+	registerEnumIn("configKeys", ConfigKeysBoolean::NPCS_SLEEP_WITHOUT_PLAYERS);
+	registerEnumIn("configKeys", ConfigKeysBoolean::NPC_SEPARATE_LUA_STATE);
+	registerEnumIn("configKeys", ConfigKeysBoolean::COALESCE_HEALTH_UPDATES);
+	registerEnumIn("configKeys", ConfigKeysBoolean::MAP_PAGED_STORAGE);
+	registerEnumIn("configKeys", ConfigKeysBoolean::SHARE_STATIC_TILE_ITEMS);
+	registerEnumIn("configKeys", ConfigKeysBoolean::COMPACT_HOUSE_ITEMS);
+	registerEnumIn("configKeys", ConfigKeysBoolean::SERVE_LOGIN);
 
 	registerEnumIn("configKeys", ConfigKeysString::MAP_NAME);
 	registerEnumIn("configKeys", ConfigKeysString::HOUSE_RENT_PERIOD);
@@ -2216,6 +2477,14 @@ void LuaScriptInterface::registerFunctions()
 	registerEnumIn("configKeys", ConfigKeysString::MYSQL_SOCK);
 	registerEnumIn("configKeys", ConfigKeysString::DEFAULT_PRIORITY);
 	registerEnumIn("configKeys", ConfigKeysString::MAP_AUTHOR);
+	registerEnumIn("configKeys", ConfigKeysString::HANDOVER_SOCKET);
+	registerEnumIn("configKeys", ConfigKeysString::DISPATCHER_CPUS);
+	registerEnumIn("configKeys", ConfigKeysString::SCHEDULER_CPUS);
+	registerEnumIn("configKeys", ConfigKeysString::DATABASE_CPUS);
+	registerEnumIn("configKeys", ConfigKeysString::NETWORK_CPUS);
+	registerEnumIn("configKeys", ConfigKeysString::JOB_CPUS);
+	registerEnumIn("configKeys", ConfigKeysString::LOG_LEVEL);
+	registerEnumIn("configKeys", ConfigKeysString::LOG_FORMAT);
 
 	registerEnumIn("configKeys", ConfigKeysInteger::SERVER_SAVE_NOTIFY_DURATION);
 	registerEnumIn("configKeys", ConfigKeysInteger::SQL_PORT);
@@ -2250,6 +2519,28 @@ void LuaScriptInterface::registerFunctions()
 	registerEnumIn("configKeys", ConfigKeysInteger::MAX_PACKETS_PER_SECOND);
 	registerEnumIn("configKeys", ConfigKeysInteger::STAMINA_REGEN_MINUTE);
 	registerEnumIn("configKeys", ConfigKeysInteger::STAMINA_REGEN_PREMIUM);
+	registerEnumIn("configKeys", ConfigKeysInteger::DISPATCHER_STATS_LOG_INTERVAL);
+	registerEnumIn("configKeys", ConfigKeysInteger::JOB_THREADS);
+	registerEnumIn("configKeys", ConfigKeysInteger::NETWORK_THREADS);
+	registerEnumIn("configKeys", ConfigKeysInteger::DATABASE_THREADS);
+	registerEnumIn("configKeys", ConfigKeysInteger::LUA_GC_STEP_BUDGET);
+	registerEnumIn("configKeys", ConfigKeysInteger::LOGIN_CACHE_TIME);
+	registerEnumIn("configKeys", ConfigKeysInteger::SLOW_TICK_THRESHOLD);
+	registerEnumIn("configKeys", ConfigKeysInteger::METRICS_PORT);
+	registerEnumIn("configKeys", ConfigKeysInteger::MAP_CLEAN_TILES_PER_TICK);
+	registerEnumIn("configKeys", ConfigKeysInteger::MAP_PAGE_IDLE_TIME);
+	registerEnumIn("configKeys", ConfigKeysInteger::OVERLOAD_EFFECTS_LAG);
+	registerEnumIn("configKeys", ConfigKeysInteger::OVERLOAD_MONSTER_THINK_LAG);
+	registerEnumIn("configKeys", ConfigKeysInteger::OVERLOAD_SAVES_LAG);
+	registerEnumIn("configKeys", ConfigKeysInteger::OVERLOAD_GLOBALEVENTS_LAG);
+	registerEnumIn("configKeys", ConfigKeysInteger::MONSTER_FULL_THINK_DISTANCE);
+	registerEnumIn("configKeys", ConfigKeysInteger::FLOW_FIELD_CHASERS);
+	registerEnumIn("configKeys", ConfigKeysInteger::MAX_FOLLOW_REPLANS);
+	registerEnumIn("configKeys", ConfigKeysInteger::SEND_QUEUE_SOFT_LIMIT);
+	registerEnumIn("configKeys", ConfigKeysInteger::SEND_QUEUE_HARD_LIMIT);
+	registerEnumIn("configKeys", ConfigKeysInteger::SLOW_QUERY_TIME);
+	registerEnumIn("configKeys", ConfigKeysInteger::ROLLING_SAVE_INTERVAL);
+	registerEnumIn("configKeys", ConfigKeysInteger::LOG_REPEAT_LIMIT);
 
 	// os
 	registerMethod("os", "mtime", LuaScriptInterface::luaSystemTime);
@@ -2298,6 +2589,70 @@ void LuaScriptInterface::registerFunctions()
 #undef registerEnum
 #undef registerEnumIn
 
+namespace {
+
+// Class tables are empty proxies: what a class defines itself is kept in its metatable's 'o' table and every
+// lookup goes to the 'f' table, which also holds the methods inherited from the base classes. Userdata then find any
+// method with a single table lookup instead of walking the __index chain of their base classes.
+void setClassField(lua_State* L, int classTable, int key, int value)
+{
+	lua_getmetatable(L, classTable);
+	int methodsTable = lua_gettop(L);
+
+	lua_rawgeti(L, methodsTable, 'f');
+	lua_pushvalue(L, key);
+	lua_pushvalue(L, value);
+	lua_rawset(L, -3);
+	lua_pop(L, 1);
+
+	// pass it down to derived classes that do not define their own
+	lua_rawgeti(L, methodsTable, 'd');
+	int derived = lua_gettop(L);
+	for (size_t i = 1, size = lua_rawlen(L, derived); i <= size; ++i) {
+		lua_rawgeti(L, derived, i);
+		lua_getmetatable(L, -1);
+		lua_rawgeti(L, -1, 'o');
+		lua_pushvalue(L, key);
+		bool overridden = lua_rawget(L, -2) != LUA_TNIL;
+		lua_pop(L, 3);
+
+		if (!overridden) {
+			setClassField(L, lua_gettop(L), key, value);
+		}
+		lua_pop(L, 1);
+	}
+	lua_pop(L, 2);
+}
+
+int luaClassNewIndex(lua_State* L)
+{
+	// className.key = value
+	lua_getmetatable(L, 1);
+	int methodsTable = lua_gettop(L);
+
+	lua_rawgeti(L, methodsTable, 'o');
+	lua_pushvalue(L, 2);
+	lua_pushvalue(L, 3);
+	lua_rawset(L, -3);
+	lua_pop(L, 1);
+
+	// removing a method uncovers the inherited one again
+	if (lua_isnil(L, 3) && lua_rawgeti(L, methodsTable, 'b') == LUA_TTABLE) {
+		lua_getmetatable(L, -1);
+		lua_rawgeti(L, -1, 'f');
+		lua_pushvalue(L, 2);
+		lua_rawget(L, -2);
+		lua_replace(L, 3);
+		lua_pop(L, 2);
+	}
+	lua_settop(L, 3);
+
+	setClassField(L, 1, 2, 3);
+	return 0;
+}
+
+} // namespace
+
 void LuaScriptInterface::registerClass(const std::string& className, const std::string& baseClass,
                                        lua_CFunction newFunction /* = nullptr*/)
 {
@@ -2307,6 +2662,10 @@ void LuaScriptInterface::registerClass(const std::string& className, const std::
 	lua_setglobal(luaState, className.c_str());
 	int methods = lua_gettop(luaState);
 
+	// dispatch = {}, the flattened methods of className
+	lua_newtable(luaState);
+	int dispatch = lua_gettop(luaState);
+
 	// methodsTable = {}
 	lua_newtable(luaState);
 	int methodsTable = lua_gettop(luaState);
@@ -2317,15 +2676,51 @@ void LuaScriptInterface::registerClass(const std::string& className, const std::
 		lua_setfield(luaState, methodsTable, "__call");
 	}
 
+	// methodsTable['o'] = {}, methodsTable['d'] = {}
+	lua_newtable(luaState);
+	lua_rawseti(luaState, methodsTable, 'o');
+	lua_newtable(luaState);
+	lua_rawseti(luaState, methodsTable, 'd');
+
 	uint32_t parents = 0;
 	if (!baseClass.empty()) {
 		lua_getglobal(luaState, baseClass.c_str());
-		lua_rawgeti(luaState, -1, 'p');
+		int base = lua_gettop(luaState);
+		lua_rawgeti(luaState, base, 'p');
 		parents = Lua::getInteger<uint32_t>(luaState, -1) + 1;
 		lua_pop(luaState, 1);
-		lua_setfield(luaState, methodsTable, "__index");
+
+		lua_getmetatable(luaState, base);
+
+		// copy what baseClass has so far, later additions are passed down by luaClassNewIndex
+		lua_rawgeti(luaState, -1, 'f');
+		lua_pushnil(luaState);
+		while (lua_next(luaState, -2) != 0) {
+			lua_pushvalue(luaState, -2);
+			lua_insert(luaState, -2);
+			lua_rawset(luaState, dispatch);
+		}
+		lua_pop(luaState, 1);
+
+		// baseClass.metatable['d'][#+1] = className
+		lua_rawgeti(luaState, -1, 'd');
+		lua_pushvalue(luaState, methods);
+		lua_rawseti(luaState, -2, lua_rawlen(luaState, -2) + 1);
+		lua_pop(luaState, 2);
+
+		// methodsTable['b'] = baseClass
+		lua_rawseti(luaState, methodsTable, 'b');
 	}
 
+	// methodsTable['f'] = dispatch
+	lua_pushvalue(luaState, dispatch);
+	lua_rawseti(luaState, methodsTable, 'f');
+
+	lua_pushvalue(luaState, dispatch);
+	lua_setfield(luaState, methodsTable, "__index");
+	lua_pushcfunction(luaState, luaClassNewIndex);
+	lua_setfield(luaState, methodsTable, "__newindex");
+
 	// setmetatable(className, methodsTable)
 	lua_setmetatable(luaState, methods);
 
@@ -2337,8 +2732,8 @@ void LuaScriptInterface::registerClass(const std::string& className, const std::
 	lua_pushvalue(luaState, methods);
 	lua_setfield(luaState, metatable, "__metatable");
 
-	// className.metatable.__index = className
-	lua_pushvalue(luaState, methods);
+	// className.metatable.__index = dispatch
+	lua_pushvalue(luaState, dispatch);
 	lua_setfield(luaState, metatable, "__index");
 
 	// className.metatable['h'] = hash
@@ -2401,8 +2796,8 @@ void LuaScriptInterface::registerClass(const std::string& className, const std::
 	}
 	lua_rawseti(luaState, metatable, 't');
 
-	// pop className, className.metatable
-	lua_pop(luaState, 2);
+	// pop className, dispatch, className.metatable
+	lua_pop(luaState, 3);
 }
 
 void LuaScriptInterface::registerTable(std::string_view tableName)
@@ -2960,25 +3355,105 @@ int LuaScriptInterface::luaAddEvent(lua_State* L)
 		}
 	}
 
+	uint32_t delay = std::max<uint32_t>(100, Lua::getInteger<uint32_t>(L, 2));
+
+	// { callback, arg1, ..., argN }
+	lua_createtable(L, parameters - 1, 0);
+	lua_pushvalue(L, 1);
+	lua_rawseti(L, -2, 1);
+	for (int i = 3; i <= parameters; ++i) {
+		lua_pushvalue(L, i);
+		lua_rawseti(L, -2, i - 1);
+	}
+
 	LuaTimerEventDesc eventDesc;
-	eventDesc.parameters.reserve(parameters -
-	                             2); // safe to use -2 since we garanteed that there is at least two parameters
-	for (int i = 0; i < parameters - 2; ++i) {
-		eventDesc.parameters.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+	eventDesc.ref = luaL_ref(L, LUA_REGISTRYINDEX);
+	eventDesc.parameters = parameters - 2;
+	eventDesc.scriptId = getScriptEnv()->getScriptId();
+
+	lua_pushinteger(L, Lua::getLuaEnvironment(L).addTimerEvent(std::move(eventDesc), delay));
+	return 1;
+}
+
+int LuaScriptInterface::luaAsync(lua_State* L)
+{
+	// async(callback, ...)
+	if (!Lua::isFunction(L, 1)) {
+		reportErrorFunc(L, "callback parameter should be a function.");
+		Lua::pushBoolean(L, false);
+		return 1;
 	}
 
-	uint32_t delay = std::max<uint32_t>(100, Lua::getInteger<uint32_t>(L, 2));
-	lua_pop(L, 1);
+	int args = lua_gettop(L);
+	lua_State* thread = lua_newthread(L);
+	lua_insert(L, 1);
+	lua_xmove(L, thread, args);
 
-	eventDesc.function = luaL_ref(L, LUA_REGISTRYINDEX);
-	eventDesc.scriptId = getScriptEnv()->getScriptId();
+	Lua::getLuaEnvironment(L).runCoroutine(L, thread, args - 1);
+	Lua::pushBoolean(L, true);
+	return 1;
+}
+
+int LuaScriptInterface::luaSleep(lua_State* L)
+{
+	// sleep(delay)
+	if (!lua_isyieldable(L)) {
+		reportErrorFunc(L, "sleep can only be called from a coroutine started by async.");
+		Lua::pushBoolean(L, false);
+		return 1;
+	}
+
+	uint32_t delay = std::max<uint32_t>(SCHEDULER_MINTICKS, Lua::getInteger<uint32_t>(L, 1));
+	LuaEnvironment* environment = &Lua::getLuaEnvironment(L);
+	uint32_t coroutineId = environment->suspendCoroutine(L);
 
-	auto& lastTimerEventId = g_luaEnvironment.lastEventTimerId;
-	eventDesc.eventId = g_scheduler.addEvent(
-	    createSchedulerTask(delay, [=]() { g_luaEnvironment.executeTimerEvent(lastTimerEventId); }));
+	SchedulerTask* task =
+	    createSchedulerTask(delay, [environment, coroutineId]() { environment->resumeCoroutine(coroutineId); });
+	task->setOrigin(makeTaskOrigin(TASK_ORIGIN_LUA_EVENT));
+	g_scheduler.addEvent(task);
+	return lua_yield(L, 0);
+}
+
+int LuaScriptInterface::luaWaitFor(lua_State* L)
+{
+	// waitFor(event)
+	if (!lua_isyieldable(L)) {
+		reportErrorFunc(L, "waitFor can only be called from a coroutine started by async.");
+		Lua::pushBoolean(L, false);
+		return 1;
+	}
+
+	std::string event = Lua::getString(L, 1);
+	LuaEnvironment& environment = Lua::getLuaEnvironment(L);
+	environment.coroutineSignals.emplace(std::move(event), environment.suspendCoroutine(L));
+	return lua_yield(L, 0);
+}
+
+int LuaScriptInterface::luaNotify(lua_State* L)
+{
+	// notify(event, ...)
+	LuaEnvironment& environment = Lua::getLuaEnvironment(L);
+	auto range = environment.coroutineSignals.equal_range(Lua::getStringView(L, 1));
+
+	// detach them first, a resumed coroutine may wait for the same event again
+	std::vector<uint32_t> waiting;
+	for (auto it = range.first; it != range.second; ++it) {
+		waiting.push_back(it->second);
+	}
+	environment.coroutineSignals.erase(range.first, range.second);
 
-	g_luaEnvironment.timerEvents.emplace(lastTimerEventId, std::move(eventDesc));
-	lua_pushinteger(L, lastTimerEventId++);
+	int args = lua_gettop(L) - 1;
+	for (uint32_t coroutineId : waiting) {
+		environment.resumeCoroutine(coroutineId, [L, args](lua_State* thread) {
+			for (int i = 2; i <= args + 1; ++i) {
+				lua_pushvalue(L, i);
+				lua_xmove(L, thread, 1);
+			}
+			return args;
+		}, L);
+	}
+
+	lua_pushinteger(L, waiting.size());
 	return 1;
 }
 
@@ -2987,22 +3462,15 @@ int LuaScriptInterface::luaStopEvent(lua_State* L)
 	// stopEvent(eventId)
 	uint32_t eventId = Lua::getInteger<uint32_t>(L, 1);
 
-	auto& timerEvents = g_luaEnvironment.timerEvents;
-	auto it = timerEvents.find(eventId);
-	if (it == timerEvents.end()) {
+	LuaEnvironment& environment = Lua::getLuaEnvironment(L);
+	LuaTimerEventDesc* timerEventDesc = environment.getTimerEvent(eventId);
+	if (!timerEventDesc) {
 		Lua::pushBoolean(L, false);
 		return 1;
 	}
 
-	LuaTimerEventDesc timerEventDesc = std::move(it->second);
-	timerEvents.erase(it);
-
-	g_scheduler.stopEvent(timerEventDesc.eventId);
-	luaL_unref(L, LUA_REGISTRYINDEX, timerEventDesc.function);
-
-	for (auto parameter : timerEventDesc.parameters) {
-		luaL_unref(L, LUA_REGISTRYINDEX, parameter);
-	}
+	g_scheduler.stopEvent(timerEventDesc->eventId);
+	environment.releaseTimerEvent(*timerEventDesc);
 
 	Lua::pushBoolean(L, true);
 	return 1;
@@ -3104,6 +3572,18 @@ int LuaScriptInterface::luaIsScriptsInterface(lua_State* L)
 	return 1;
 }
 
+int LuaScriptInterface::luaGetLoadingScriptFile(lua_State* L)
+{
+	// getLoadingScriptFile()
+	const std::string& file = g_scripts->getLoadingFile();
+	if (file.empty()) {
+		lua_pushnil(L);
+	} else {
+		Lua::pushString(L, file);
+	}
+	return 1;
+}
+
 std::string LuaScriptInterface::escapeString(std::string s)
 {
 	boost::algorithm::replace_all(s, "\\", "\\\\");
@@ -3137,11 +3617,26 @@ int LuaScriptInterface::luaConfigManagerGetBoolean(lua_State* L)
 	return 1;
 }
 
+namespace {
+
+// the script line calling a db function, the caller of its query in the query stats
+std::string getLuaCaller(lua_State* L)
+{
+	lua_Debug ar;
+	if (lua_getstack(L, 1, &ar) && lua_getinfo(L, "Sl", &ar) && ar.currentline > 0) {
+		return fmt::format("{:s}:{:d}", ar.short_src, ar.currentline);
+	}
+	return "lua";
+}
+
+} // namespace
+
 const luaL_Reg LuaScriptInterface::luaDatabaseTable[] = {
     {"query", LuaScriptInterface::luaDatabaseExecute},
     {"asyncQuery", LuaScriptInterface::luaDatabaseAsyncExecute},
     {"storeQuery", LuaScriptInterface::luaDatabaseStoreQuery},
     {"asyncStoreQuery", LuaScriptInterface::luaDatabaseAsyncStoreQuery},
+    {"streamQuery", LuaScriptInterface::luaDatabaseStreamQuery},
     {"escapeString", LuaScriptInterface::luaDatabaseEscapeString},
     {"escapeBlob", LuaScriptInterface::luaDatabaseEscapeBlob},
     {"lastInsertId", LuaScriptInterface::luaDatabaseLastInsertId},
@@ -3150,18 +3645,20 @@ const luaL_Reg LuaScriptInterface::luaDatabaseTable[] = {
 
 int LuaScriptInterface::luaDatabaseExecute(lua_State* L)
 {
+	DBCallerScope callerScope{getLuaCaller(L)};
 	Lua::pushBoolean(L, Database::getInstance().executeQuery(Lua::getString(L, -1)));
 	return 1;
 }
 
 int LuaScriptInterface::luaDatabaseAsyncExecute(lua_State* L)
 {
+	LuaEnvironment* environment = &Lua::getLuaEnvironment(L);
 	std::function<void(DBResult_ptr, bool)> callback;
 	if (lua_gettop(L) > 1) {
 		int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
 		auto scriptId = getScriptEnv()->getScriptId();
-		callback = [ref, scriptId](DBResult_ptr, bool success) {
-			lua_State* luaState = g_luaEnvironment.getLuaState();
+		callback = [environment, ref, scriptId](DBResult_ptr, bool success) {
+			lua_State* luaState = environment->getLuaState();
 			if (!luaState) {
 				return;
 			}
@@ -3174,18 +3671,35 @@ int LuaScriptInterface::luaDatabaseAsyncExecute(lua_State* L)
 			lua_rawgeti(luaState, LUA_REGISTRYINDEX, ref);
 			Lua::pushBoolean(luaState, success);
 			auto env = getScriptEnv();
-			env->setScriptId(scriptId, &g_luaEnvironment);
-			g_luaEnvironment.callFunction(1);
+			env->setScriptId(scriptId, environment);
+			environment->callFunction(1);
 
 			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
 		};
+	} else if (lua_isyieldable(L)) {
+		// called from a coroutine without a callback, resume it with the result instead
+		std::string query = Lua::getString(L, -1);
+		uint32_t coroutineId = environment->suspendCoroutine(L);
+		{
+			// the yield does not return here, so the scope has to end before it
+			DBCallerScope callerScope{getLuaCaller(L)};
+			g_databaseTasks.addTask(std::move(query), [environment, coroutineId](DBResult_ptr, bool success) {
+				environment->resumeCoroutine(coroutineId, [success](lua_State* thread) {
+					Lua::pushBoolean(thread, success);
+					return 1;
+				});
+			});
+		}
+		return lua_yield(L, 0);
 	}
+	DBCallerScope callerScope{getLuaCaller(L)};
 	g_databaseTasks.addTask(Lua::getString(L, -1), callback);
 	return 0;
 }
 
 int LuaScriptInterface::luaDatabaseStoreQuery(lua_State* L)
 {
+	DBCallerScope callerScope{getLuaCaller(L)};
 	if (DBResult_ptr res = Database::getInstance().storeQuery(Lua::getString(L, -1))) {
 		lua_pushinteger(L, ScriptEnvironment::addResult(res));
 	} else {
@@ -3196,12 +3710,13 @@ int LuaScriptInterface::luaDatabaseStoreQuery(lua_State* L)
 
 int LuaScriptInterface::luaDatabaseAsyncStoreQuery(lua_State* L)
 {
+	LuaEnvironment* environment = &Lua::getLuaEnvironment(L);
 	std::function<void(DBResult_ptr, bool)> callback;
 	if (lua_gettop(L) > 1) {
 		int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
 		auto scriptId = getScriptEnv()->getScriptId();
-		callback = [ref, scriptId](DBResult_ptr result, bool) {
-			lua_State* luaState = g_luaEnvironment.getLuaState();
+		callback = [environment, ref, scriptId](DBResult_ptr result, bool) {
+			lua_State* luaState = environment->getLuaState();
 			if (!luaState) {
 				return;
 			}
@@ -3218,16 +3733,72 @@ int LuaScriptInterface::luaDatabaseAsyncStoreQuery(lua_State* L)
 				Lua::pushBoolean(luaState, false);
 			}
 			auto env = getScriptEnv();
-			env->setScriptId(scriptId, &g_luaEnvironment);
-			g_luaEnvironment.callFunction(1);
+			env->setScriptId(scriptId, environment);
+			environment->callFunction(1);
 
 			luaL_unref(luaState, LUA_REGISTRYINDEX, ref);
 		};
+	} else if (lua_isyieldable(L)) {
+		// called from a coroutine without a callback, resume it with the result instead
+		std::string query = Lua::getString(L, -1);
+		uint32_t coroutineId = environment->suspendCoroutine(L);
+		{
+			// the yield does not return here, so the scope has to end before it
+			DBCallerScope callerScope{getLuaCaller(L)};
+			g_databaseTasks.addTask(
+			    std::move(query),
+			    [environment, coroutineId](DBResult_ptr result, bool) {
+				    environment->resumeCoroutine(coroutineId, [result](lua_State* thread) {
+					    if (result) {
+						    lua_pushinteger(thread, ScriptEnvironment::addResult(result));
+					    } else {
+						    Lua::pushBoolean(thread, false);
+					    }
+					    return 1;
+				    });
+			    },
+			    true);
+		}
+		return lua_yield(L, 0);
 	}
+	DBCallerScope callerScope{getLuaCaller(L)};
 	g_databaseTasks.addTask(Lua::getString(L, -1), callback, true);
 	return 0;
 }
 
+int LuaScriptInterface::luaDatabaseStreamQuery(lua_State* L)
+{
+	// db.streamQuery(query, callback(resultId)), the result id is only valid in the callback and returning false stops
+	if (!lua_isfunction(L, 2)) {
+		reportErrorFunc(L, "callback is not a function");
+		Lua::pushBoolean(L, false);
+		return 1;
+	}
+
+	DBCallerScope callerScope{getLuaCaller(L)};
+	bool failed = false;
+	const bool success = Database::getInstance().streamQuery(Lua::getString(L, 1), [L, &failed](DBResult& result) {
+		// not owned, the result goes away with the stream
+		const uint32_t resultId = ScriptEnvironment::addResult(DBResult_ptr{DBResult_ptr{}, &result});
+		lua_pushvalue(L, 2);
+		lua_pushinteger(L, resultId);
+		const int ret = protectedCall(L, 1, 1);
+		ScriptEnvironment::removeResult(resultId);
+
+		if (ret != 0) {
+			reportError(nullptr, Lua::popString(L));
+			failed = true;
+			return false;
+		}
+
+		const bool next = lua_isnil(L, -1) || Lua::getBoolean(L, -1);
+		lua_pop(L, 1);
+		return next;
+	});
+	Lua::pushBoolean(L, success && !failed);
+	return 1;
+}
+
 int LuaScriptInterface::luaDatabaseEscapeString(lua_State* L)
 {
 	Lua::pushString(L, Database::getInstance().escapeString(Lua::getString(L, -1)));
@@ -3253,10 +3824,68 @@ int LuaScriptInterface::luaDatabaseTableExists(lua_State* L)
 	return 1;
 }
 
+namespace {
+
+// the current row as a table by column name, NULL columns are left out
+void pushResultRow(lua_State* L, const DBResult& result)
+{
+	lua_createtable(L, 0, result.getColumns().size());
+	result.forEachValue([L](const DBColumn& column, const char* data, size_t size) {
+		if (!data) {
+			return;
+		}
+
+		switch (column.type) {
+			case DB_COLUMN_INTEGER: {
+				int64_t value;
+				auto [end, ec] = std::from_chars(data, data + size, value);
+				if (ec == std::errc{} && end == data + size) {
+					lua_pushinteger(L, value);
+				} else {
+					// an unsigned bigint above the int64 range
+					lua_pushnumber(L, std::strtod(data, nullptr));
+				}
+				break;
+			}
+
+			case DB_COLUMN_NUMBER:
+				lua_pushnumber(L, std::strtod(data, nullptr));
+				break;
+
+			default:
+				lua_pushlstring(L, data, size);
+				break;
+		}
+		lua_setfield(L, -2, column.name.data());
+	});
+}
+
+int luaResultRowsIterator(lua_State* L)
+{
+	const auto resultId = Lua::getInteger<uint32_t>(L, lua_upvalueindex(1));
+	DBResult_ptr res = ScriptEnvironment::getResultByID(resultId);
+	if (!res || !res->hasNext()) {
+		ScriptEnvironment::removeResult(resultId);
+		return 0;
+	}
+
+	pushResultRow(L, *res);
+	res->next();
+	return 1;
+}
+
+} // namespace
+
 const luaL_Reg LuaScriptInterface::luaResultTable[] = {
-    {"getNumber", LuaScriptInterface::luaResultGetNumber}, {"getString", LuaScriptInterface::luaResultGetString},
-    {"getStream", LuaScriptInterface::luaResultGetStream}, {"next", LuaScriptInterface::luaResultNext},
-    {"free", LuaScriptInterface::luaResultFree},           {nullptr, nullptr}};
+    {"getNumber", LuaScriptInterface::luaResultGetNumber},
+    {"getString", LuaScriptInterface::luaResultGetString},
+    {"getStream", LuaScriptInterface::luaResultGetStream},
+    {"getRow", LuaScriptInterface::luaResultGetRow},
+    {"fetchAll", LuaScriptInterface::luaResultFetchAll},
+    {"rows", LuaScriptInterface::luaResultRows},
+    {"next", LuaScriptInterface::luaResultNext},
+    {"free", LuaScriptInterface::luaResultFree},
+    {nullptr, nullptr}};
 
 int LuaScriptInterface::luaResultGetNumber(lua_State* L)
 {
@@ -3298,6 +3927,48 @@ int LuaScriptInterface::luaResultGetStream(lua_State* L)
 	return 2;
 }
 
+int LuaScriptInterface::luaResultGetRow(lua_State* L)
+{
+	// result.getRow(resultId), the current row as a table, also for the result of a db.streamQuery callback
+	DBResult_ptr res = ScriptEnvironment::getResultByID(Lua::getInteger<uint32_t>(L, 1));
+	if (!res || !res->hasNext()) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	pushResultRow(L, *res);
+	return 1;
+}
+
+int LuaScriptInterface::luaResultFetchAll(lua_State* L)
+{
+	// result.fetchAll(resultId), the rows from the current one on as an array of tables, the result is freed
+	const auto resultId = Lua::getInteger<uint32_t>(L, 1);
+	DBResult_ptr res = ScriptEnvironment::getResultByID(resultId);
+	if (!res) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	lua_newtable(L);
+	for (int index = 1; res->hasNext(); ++index) {
+		pushResultRow(L, *res);
+		lua_rawseti(L, -2, index);
+		res->next();
+	}
+
+	ScriptEnvironment::removeResult(resultId);
+	return 1;
+}
+
+int LuaScriptInterface::luaResultRows(lua_State* L)
+{
+	// for row in result.rows(resultId) do, the result is freed after the last row
+	lua_pushinteger(L, Lua::getInteger<uint32_t>(L, 1));
+	lua_pushcclosure(L, luaResultRowsIterator, 1);
+	return 1;
+}
+
 int LuaScriptInterface::luaResultNext(lua_State* L)
 {
 	DBResult_ptr res = ScriptEnvironment::getResultByID(Lua::getInteger<uint32_t>(L, -1));
@@ -3382,7 +4053,19 @@ int LuaScriptInterface::luaTableCreate(lua_State* L)
 }
 
 //
-LuaEnvironment::LuaEnvironment() : LuaScriptInterface("Main Interface") {}
+namespace {
+
+#ifndef LUAJIT_VERSION
+int luaPanic(lua_State* L)
+{
+	std::cout << "[Error - LuaEnvironment] unprotected error in call to Lua API: " << lua_tostring(L, -1) << std::endl;
+	return 0;
+}
+#endif
+
+} // namespace
+
+LuaEnvironment::LuaEnvironment(std::string_view interfaceName) : LuaScriptInterface(interfaceName) {}
 
 LuaEnvironment::~LuaEnvironment()
 {
@@ -3392,14 +4075,27 @@ LuaEnvironment::~LuaEnvironment()
 
 bool LuaEnvironment::initState()
 {
+#ifdef LUAJIT_VERSION
+	// 64 bit LuaJIT does not take a custom allocator
 	luaState = luaL_newstate();
+#else
+	luaState = lua_newstate(LuaAllocator::allocate, &allocator);
+#endif
 	if (!luaState) {
 		return false;
 	}
 
+#ifndef LUAJIT_VERSION
+	lua_atpanic(luaState, luaPanic);
+#endif
+
 	luaL_openlibs(luaState);
 	registerFunctions();
 
+	lua_pushlightuserdata(luaState, this);
+	lua_setfield(luaState, LUA_REGISTRYINDEX, "environment");
+	Lua::createUserdataCache(luaState);
+
 	runningEventId = EVENT_ID_USER;
 	return true;
 }
@@ -3425,24 +4121,86 @@ bool LuaEnvironment::closeState()
 		clearAreaObjects(areaEntry.first);
 	}
 
-	for (auto& timerEntry : timerEvents) {
-		LuaTimerEventDesc timerEventDesc = std::move(timerEntry.second);
-		for (int32_t parameter : timerEventDesc.parameters) {
-			luaL_unref(luaState, LUA_REGISTRYINDEX, parameter);
+	for (const auto& timerEventDesc : timerEvents) {
+		if (timerEventDesc.ref != LUA_NOREF) {
+			luaL_unref(luaState, LUA_REGISTRYINDEX, timerEventDesc.ref);
 		}
-		luaL_unref(luaState, LUA_REGISTRYINDEX, timerEventDesc.function);
+	}
+
+	for (const auto& coroutineEntry : suspendedCoroutines) {
+		luaL_unref(luaState, LUA_REGISTRYINDEX, coroutineEntry.second.ref);
 	}
 
 	combatIdMap.clear();
 	areaIdMap.clear();
 	timerEvents.clear();
+	freeTimerEvents.clear();
+	gcStoppedState = nullptr;
+	suspendedCoroutines.clear();
+	coroutineSignals.clear();
 	cacheFiles.clear();
 
+	Lua::closeUserdataCache(luaState);
 	lua_close(luaState);
 	luaState = nullptr;
+	allocator.release();
 	return true;
 }
 
+uint32_t LuaEnvironment::suspendCoroutine(lua_State* L)
+{
+	lua_pushthread(L);
+	int32_t ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	suspendedCoroutines.emplace(++lastCoroutineId, LuaSuspendedCoroutine{ref, getScriptEnv()->getScriptId()});
+	return lastCoroutineId;
+}
+
+void LuaEnvironment::resumeCoroutine(uint32_t coroutineId, const std::function<int(lua_State*)>& pushResults,
+                                     lua_State* L /* = nullptr*/)
+{
+	if (!L) {
+		L = luaState;
+	}
+
+	auto it = suspendedCoroutines.find(coroutineId);
+	if (it == suspendedCoroutines.end()) {
+		return;
+	}
+
+	const LuaSuspendedCoroutine suspended = it->second;
+	suspendedCoroutines.erase(it);
+
+	// keep the thread referenced from the stack while it runs
+	lua_rawgeti(L, LUA_REGISTRYINDEX, suspended.ref);
+	luaL_unref(L, LUA_REGISTRYINDEX, suspended.ref);
+
+	lua_State* thread = lua_tothread(L, -1);
+	if (!thread || !reserveScriptEnv()) {
+		lua_pop(L, 1);
+		return;
+	}
+
+	getScriptEnv()->setScriptId(suspended.scriptId, this);
+	runCoroutine(L, thread, pushResults ? pushResults(thread) : 0);
+	resetScriptEnv();
+
+	lua_pop(L, 1);
+}
+
+void LuaEnvironment::runCoroutine(lua_State* L, lua_State* thread, int nargs)
+{
+	int results;
+	int ret = lua_resume(thread, L, nargs, &results);
+	if (ret == LUA_OK || ret == LUA_YIELD) {
+		lua_pop(thread, results);
+		return;
+	}
+
+	luaL_traceback(L, thread, Lua::getString(thread, -1).c_str(), 0);
+	reportError(nullptr, Lua::popString(L));
+}
+
 LuaScriptInterface* LuaEnvironment::getTestInterface()
 {
 	if (!testInterface) {
@@ -3518,21 +4276,126 @@ void LuaEnvironment::clearAreaObjects(LuaScriptInterface* interface)
 	it->second.clear();
 }
 
-void LuaEnvironment::executeTimerEvent(uint32_t eventIndex)
+namespace {
+
+constexpr uint32_t TIMER_EVENT_SLOT_BITS = 20;
+constexpr uint32_t TIMER_EVENT_SLOT_MASK = (1 << TIMER_EVENT_SLOT_BITS) - 1;
+
+} // namespace
+
+uint32_t LuaEnvironment::addTimerEvent(LuaTimerEventDesc&& eventDesc, uint32_t delay)
+{
+	uint32_t slot;
+	if (!freeTimerEvents.empty()) {
+		slot = freeTimerEvents.back();
+		freeTimerEvents.pop_back();
+	} else {
+		slot = static_cast<uint32_t>(timerEvents.size());
+		timerEvents.emplace_back();
+	}
+
+	// slot + 1 in the low bits keeps 0 an invalid id
+	const uint32_t generation = (timerEvents[slot].id >> TIMER_EVENT_SLOT_BITS) + 1;
+	const uint32_t timerEventId = (generation << TIMER_EVENT_SLOT_BITS) | (slot + 1);
+
+	SchedulerTask* task = createSchedulerTask(delay, [=, this]() { executeTimerEvent(timerEventId); });
+	task->setOrigin(makeTaskOrigin(TASK_ORIGIN_LUA_EVENT));
+	eventDesc.eventId = g_scheduler.addEvent(task);
+	eventDesc.id = timerEventId;
+
+	timerEvents[slot] = std::move(eventDesc);
+	return timerEventId;
+}
+
+LuaTimerEventDesc* LuaEnvironment::getTimerEvent(uint32_t timerEventId)
 {
-	if (!timerEvents.contains(eventIndex)) {
+	const uint32_t slot = (timerEventId & TIMER_EVENT_SLOT_MASK) - 1;
+	if (slot >= timerEvents.size()) {
+		return nullptr;
+	}
+
+	LuaTimerEventDesc& eventDesc = timerEvents[slot];
+	if (eventDesc.id != timerEventId || eventDesc.ref == LUA_NOREF) {
+		return nullptr;
+	}
+	return &eventDesc;
+}
+
+void LuaEnvironment::releaseTimerEvent(LuaTimerEventDesc& eventDesc)
+{
+	luaL_unref(luaState, LUA_REGISTRYINDEX, eventDesc.ref);
+	eventDesc.ref = LUA_NOREF;
+	freeTimerEvents.push_back((eventDesc.id & TIMER_EVENT_SLOT_MASK) - 1);
+}
+
+void LuaEnvironment::stepGarbageCollector(uint32_t budget)
+{
+	if (!luaState) {
 		return;
 	}
 
-	LuaTimerEventDesc timerEventDesc = std::move(timerEvents[eventIndex]);
-	timerEvents.erase(eventIndex);
+	if (budget == 0) {
+		if (gcStoppedState == luaState) {
+			lua_gc(luaState, LUA_GCRESTART, 0);
+			gcStoppedState = nullptr;
+		}
+		return;
+	}
+
+	if (gcStoppedState != luaState) {
+		lua_gc(luaState, LUA_GCSTOP, 0);
+		gcStoppedState = luaState;
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	auto stepStart = start;
+	while (true) {
+		const bool cycleFinished = lua_gc(luaState, LUA_GCSTEP, 0) != 0;
+
+		const auto now = std::chrono::steady_clock::now();
+		const uint64_t stepTime = std::chrono::duration_cast<std::chrono::microseconds>(now - stepStart).count();
+		++gcStats.steps;
+		gcStats.totalTime += stepTime;
+		gcStats.maxStepTime = std::max(gcStats.maxStepTime, stepTime);
+		gcStats.currentCycleTime += stepTime;
+
+		if (cycleFinished) {
+			// leave the rest of the budget, the next cycle starts over an almost clean heap
+			++gcStats.cycles;
+			gcStats.lastCycleTime = gcStats.currentCycleTime;
+			gcStats.currentCycleTime = 0;
+			break;
+		}
+
+		if (now - start >= std::chrono::microseconds(budget)) {
+			break;
+		}
+		stepStart = now;
+	}
+}
+
+void LuaEnvironment::executeTimerEvent(uint32_t timerEventId)
+{
+	LuaTimerEventDesc* eventDesc = getTimerEvent(timerEventId);
+	if (!eventDesc) {
+		return;
+	}
+
+	const int32_t scriptId = eventDesc->scriptId;
+	const int32_t parameters = eventDesc->parameters;
+
+	// the slot is free to be reused by the callback
+	lua_rawgeti(luaState, LUA_REGISTRYINDEX, eventDesc->ref);
+	releaseTimerEvent(*eventDesc);
+
+	const int table = lua_gettop(luaState);
 
 	// push function
-	lua_rawgeti(luaState, LUA_REGISTRYINDEX, timerEventDesc.function);
+	lua_rawgeti(luaState, table, 1);
 
 	// push parameters
-	for (auto parameter : boost::adaptors::reverse(timerEventDesc.parameters)) {
-		lua_rawgeti(luaState, LUA_REGISTRYINDEX, parameter);
+	for (int32_t i = 2; i <= parameters + 1; ++i) {
+		lua_rawgeti(luaState, table, i);
 		if (lua_getmetatable(luaState, -1) == 0) {
 			continue;
 		}
@@ -3567,19 +4430,16 @@ void LuaEnvironment::executeTimerEvent(uint32_t eventIndex)
 		}
 	}
 
+	lua_remove(luaState, table);
+
 	// call the function
 	if (reserveScriptEnv()) {
 		ScriptEnvironment* env = getScriptEnv();
 		env->setTimerEvent();
-		env->setScriptId(timerEventDesc.scriptId, this);
-		callFunction(timerEventDesc.parameters.size());
+		env->setScriptId(scriptId, this);
+		callFunction(parameters);
 	} else {
+		lua_pop(luaState, parameters + 1);
 		std::cout << "[Error - LuaScriptInterface::executeTimerEvent] Call stack overflow" << std::endl;
 	}
-
-	// free resources
-	luaL_unref(luaState, LUA_REGISTRYINDEX, timerEventDesc.function);
-	for (auto parameter : timerEventDesc.parameters) {
-		luaL_unref(luaState, LUA_REGISTRYINDEX, parameter);
-	}
 }
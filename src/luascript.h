@@ -6,6 +6,7 @@
 
 #include "database.h"
 #include "enums.h"
+#include "luaallocator.h"
 #include "position.h"
 #include "spectators.h"
 
@@ -165,15 +166,33 @@ NEW_LUA_DATA_TYPE(Weapon)
 NEW_LUA_DATA_TYPE(XMLDocument)
 NEW_LUA_DATA_TYPE(XMLNode)
 
+struct LuaSuspendedCoroutine
+{
+	int32_t ref;
+	int32_t scriptId;
+};
+
+// microseconds
+struct LuaGcStats
+{
+	uint64_t steps = 0;
+	uint64_t cycles = 0;
+	uint64_t totalTime = 0;
+	uint64_t maxStepTime = 0;
+	// time spent stepping through the last completed cycle
+	uint64_t lastCycleTime = 0;
+	uint64_t currentCycleTime = 0;
+};
+
+// the callback and its arguments are kept in a single registry table, { callback, arg1, ..., argN }
 struct LuaTimerEventDesc
 {
 	int32_t scriptId = -1;
-	int32_t function = -1;
-	std::vector<int32_t> parameters;
+	int32_t ref = LUA_NOREF;
+	int32_t parameters = 0;
+	// id handed out by addEvent, the slot is free while ref is LUA_NOREF
+	uint32_t id = 0;
 	uint32_t eventId = 0;
-
-	LuaTimerEventDesc() = default;
-	LuaTimerEventDesc(LuaTimerEventDesc&& other) = default;
 };
 
 class ScriptEnvironment
@@ -187,6 +206,11 @@ public:
 	ScriptEnvironment& operator=(const ScriptEnvironment&) = delete;
 
 	void resetEnv();
+	// nothing was created during the call, resetting only clears the ids
+	bool isClean() const
+	{
+		return localMap.empty() && tempResults.empty() && (tempItems.empty() || tempItems.back().first != this);
+	}
 
 	void setScriptId(int32_t scriptId, LuaScriptInterface* scriptInterface)
 	{
@@ -230,11 +254,12 @@ private:
 	// for npc scripts
 	Npc* curNpc = nullptr;
 
-	// temporary item list
-	static std::multimap<ScriptEnvironment*, Item*> tempItems;
+	// temporary items of all environments, environments are reserved and reset in stack order so the items of the
+	// one being reset are always at the end
+	static std::vector<std::pair<ScriptEnvironment*, Item*>> tempItems;
 
-	// local item map
-	std::unordered_map<uint32_t, Item*> localMap;
+	// local item map, a handful of items at most so a flat list keeping its capacity
+	std::vector<std::pair<uint32_t, Item*>> localMap;
 	uint32_t lastUID = std::numeric_limits<uint16_t>::max();
 
 	// script file id
@@ -296,11 +321,7 @@ public:
 
 	static bool reserveScriptEnv() { return ++scriptEnvIndex < 16; }
 
-	static void resetScriptEnv()
-	{
-		assert(scriptEnvIndex >= 0);
-		scriptEnv[scriptEnvIndex--].resetEnv();
-	}
+	static void resetScriptEnv();
 
 	static void reportError(const char* function, std::string_view error_desc, lua_State* L = nullptr,
 	                        bool stack_trace = false);
@@ -320,8 +341,8 @@ public:
 	static std::string escapeString(std::string string);
 
 	static const luaL_Reg luaConfigManagerTable[4];
-	static const luaL_Reg luaDatabaseTable[9];
-	static const luaL_Reg luaResultTable[6];
+	static const luaL_Reg luaDatabaseTable[10];
+	static const luaL_Reg luaResultTable[9];
 
 	static int protectedCall(lua_State* L, int nargs, int nresults);
 
@@ -426,6 +447,11 @@ private:
 	static int luaAddEvent(lua_State* L);
 	static int luaStopEvent(lua_State* L);
 
+	static int luaAsync(lua_State* L);
+	static int luaSleep(lua_State* L);
+	static int luaWaitFor(lua_State* L);
+	static int luaNotify(lua_State* L);
+
 	static int luaSaveServer(lua_State* L);
 	static int luaCleanMap(lua_State* L);
 
@@ -437,6 +463,7 @@ private:
 	static int luaSendGuildChannelMessage(lua_State* L);
 
 	static int luaIsScriptsInterface(lua_State* L);
+	static int luaGetLoadingScriptFile(lua_State* L);
 
 	static int luaConfigManagerGetString(lua_State* L);
 	static int luaConfigManagerGetNumber(lua_State* L);
@@ -446,6 +473,7 @@ private:
 	static int luaDatabaseAsyncExecute(lua_State* L);
 	static int luaDatabaseStoreQuery(lua_State* L);
 	static int luaDatabaseAsyncStoreQuery(lua_State* L);
+	static int luaDatabaseStreamQuery(lua_State* L);
 	static int luaDatabaseEscapeString(lua_State* L);
 	static int luaDatabaseEscapeBlob(lua_State* L);
 	static int luaDatabaseLastInsertId(lua_State* L);
@@ -454,6 +482,9 @@ private:
 	static int luaResultGetNumber(lua_State* L);
 	static int luaResultGetString(lua_State* L);
 	static int luaResultGetStream(lua_State* L);
+	static int luaResultGetRow(lua_State* L);
+	static int luaResultFetchAll(lua_State* L);
+	static int luaResultRows(lua_State* L);
 	static int luaResultNext(lua_State* L);
 	static int luaResultFree(lua_State* L);
 
@@ -481,7 +512,7 @@ private:
 class LuaEnvironment : public LuaScriptInterface
 {
 public:
-	LuaEnvironment();
+	explicit LuaEnvironment(std::string_view interfaceName = "Main Interface");
 	~LuaEnvironment();
 
 	// non-copyable
@@ -502,10 +533,38 @@ public:
 	uint32_t createAreaObject(LuaScriptInterface* interface);
 	void clearAreaObjects(LuaScriptInterface* interface);
 
-private:
-	void executeTimerEvent(uint32_t eventIndex);
+	// coroutines waiting in sleep, waitFor or the async db functions, resumed on the dispatcher
+	uint32_t suspendCoroutine(lua_State* L);
+	void resumeCoroutine(uint32_t coroutineId, const std::function<int(lua_State*)>& pushResults = nullptr,
+	                     lua_State* L = nullptr);
+	void runCoroutine(lua_State* L, lua_State* thread, int nargs);
 
-	std::unordered_map<uint32_t, LuaTimerEventDesc> timerEvents;
+	uint32_t addTimerEvent(LuaTimerEventDesc&& eventDesc, uint32_t delay);
+	LuaTimerEventDesc* getTimerEvent(uint32_t timerEventId);
+	void releaseTimerEvent(LuaTimerEventDesc& eventDesc);
+	size_t getTimerEventCount() const { return timerEvents.size() - freeTimerEvents.size(); }
+
+	// runs incremental collection steps for up to budget microseconds, the automatic collector is stopped while a
+	// budget is set and restarted once it is 0 again
+	void stepGarbageCollector(uint32_t budget);
+	const LuaGcStats& getGcStats() const { return gcStats; }
+	const LuaAllocator::Stats& getAllocatorStats() const { return allocator.getStats(); }
+	void resetGcStats() { gcStats = {}; }
+
+private:
+	void executeTimerEvent(uint32_t timerEventId);
+
+	// slots are reused, the upper bits of a timer event id count how many times its slot was taken so stale ids from
+	// finished events never match a newer one
+	std::vector<LuaTimerEventDesc> timerEvents;
+	std::vector<uint32_t> freeTimerEvents;
+
+	LuaAllocator allocator;
+	LuaGcStats gcStats;
+	// state whose automatic collector was stopped by stepGarbageCollector
+	lua_State* gcStoppedState = nullptr;
+	std::unordered_map<uint32_t, LuaSuspendedCoroutine> suspendedCoroutines;
+	std::multimap<std::string, uint32_t, std::less<>> coroutineSignals;
 	std::unordered_map<uint32_t, Combat_ptr> combatMap;
 	std::unordered_map<uint32_t, AreaCombat*> areaMap;
 
@@ -514,7 +573,7 @@ private:
 
 	LuaScriptInterface* testInterface = nullptr;
 
-	uint32_t lastEventTimerId = 1;
+	uint32_t lastCoroutineId = 0;
 	uint32_t lastCombatId = 0;
 	uint32_t lastAreaId = 0;
 
@@ -523,6 +582,17 @@ private:
 };
 
 namespace Lua {
+// the environment owning the state L belongs to, script groups such as the npcs may run in their own state
+LuaEnvironment& getLuaEnvironment(lua_State* L);
+
+// Positions are pushed as userdata holding this, field access goes through the Position __index/__newindex
+// metamethods; plain tables with x, y and z fields are still accepted wherever a position is expected
+struct LuaPosition
+{
+	Position position;
+	int32_t stackpos;
+};
+
 // push/pop common structures
 void pushThing(lua_State* L, Thing* thing);
 void pushVariant(lua_State* L, const LuaVariant& var);
@@ -664,6 +734,8 @@ bool getBoolean(lua_State* L, int32_t arg);
 bool getBoolean(lua_State* L, int32_t arg, bool defaultValue);
 
 std::string getString(lua_State* L, int32_t arg);
+// only valid while the value stays on the stack
+std::string_view getStringView(lua_State* L, int32_t arg);
 Position getPosition(lua_State* L, int32_t arg, int32_t& stackpos);
 Position getPosition(lua_State* L, int32_t arg);
 Outfit_t getOutfit(lua_State* L, int32_t arg);
@@ -727,6 +799,7 @@ bool isBoolean(lua_State* L, int32_t arg);
 bool isTable(lua_State* L, int32_t arg);
 bool isFunction(lua_State* L, int32_t arg);
 bool isUserdata(lua_State* L, int32_t arg);
+bool isPosition(lua_State* L, int32_t arg);
 
 //
 template <typename T>
@@ -789,6 +862,25 @@ inline void pushUserdata(lua_State* L, T* value, int nuvalue = 1)
 	*userdata = value;
 }
 
+// a creature in game is pushed as the same userdata for as long as lua holds on to it, released with the creature
+void pushCreatureUserdata(lua_State* L, const Creature* creature, int nuvalue);
+void createUserdataCache(lua_State* L);
+void closeUserdataCache(lua_State* L);
+void releaseCreatureUserdata(uint32_t creatureId);
+
+template <>
+void pushUserdata<Creature>(lua_State* L, Creature* value, int nuvalue);
+template <>
+void pushUserdata<const Creature>(lua_State* L, const Creature* value, int nuvalue);
+template <>
+void pushUserdata<Player>(lua_State* L, Player* value, int nuvalue);
+template <>
+void pushUserdata<const Player>(lua_State* L, const Player* value, int nuvalue);
+template <>
+void pushUserdata<Monster>(lua_State* L, Monster* value, int nuvalue);
+template <>
+void pushUserdata<Npc>(lua_State* L, Npc* value, int nuvalue);
+
 // Shared Ptr
 template <class T>
 inline void pushSharedPtr(lua_State* L, T value, int nuvalue = 1)
@@ -4,8 +4,10 @@
 #include "otpch.h"
 
 #include "luascript.h"
+#include "script.h"
 #include "spells.h"
 
+extern Scripts* g_scripts;
 extern Spells* g_spells;
 
 namespace {
@@ -67,6 +69,7 @@ int luaSpellCreate(lua_State* L)
 	if (spellType == SPELL_INSTANT) {
 		InstantSpell* spell = new InstantSpell(LuaScriptInterface::getScriptEnv()->getScriptInterface());
 		spell->fromLua = true;
+		spell->scriptFile = g_scripts->getLoadingFile();
 		pushUserdata<Spell>(L, spell);
 		setMetatable(L, -1, "Spell");
 		spell->spellType = SPELL_INSTANT;
@@ -74,6 +77,7 @@ int luaSpellCreate(lua_State* L)
 	} else if (spellType == SPELL_RUNE) {
 		RuneSpell* spell = new RuneSpell(LuaScriptInterface::getScriptEnv()->getScriptInterface());
 		spell->fromLua = true;
+		spell->scriptFile = g_scripts->getLoadingFile();
 		pushUserdata<Spell>(L, spell);
 		setMetatable(L, -1, "Spell");
 		spell->spellType = SPELL_RUNE;
@@ -28,6 +28,7 @@ int luaCreateTalkaction(lua_State* L)
 		talk->setWords(getString(L, i));
 	}
 	talk->fromLua = true;
+	talk->scriptFile = g_scripts->getLoadingFile();
 	pushUserdata<TalkAction>(L, talk);
 	setMetatable(L, -1, "TalkAction");
 	return 1;
@@ -18,7 +18,7 @@ int luaTileCreate(lua_State* L)
 	// Tile(x, y, z)
 	// Tile(position)
 	Tile* tile;
-	if (isTable(L, 2)) {
+	if (isPosition(L, 2)) {
 		tile = g_game.map.getTile(getPosition(L, 2));
 	} else {
 		uint8_t z = getInteger<uint8_t>(L, 4);
@@ -213,7 +213,7 @@ int luaTileGetItemById(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -231,6 +231,52 @@ int luaTileGetItemById(lua_State* L)
 	return 1;
 }
 
+int luaTileGetItemsByIdBulk(lua_State* L)
+{
+	// Tile.getItemsByIdBulk(positions, itemId[, subType = -1])
+	if (!isTable(L, 1)) {
+		lua_pushnil(L);
+		return 1;
+	}
+
+	uint16_t itemId = getInteger<uint16_t>(L, 2);
+	int32_t subType = getInteger<int32_t>(L, 3, -1);
+
+	auto matches = [=](const Item* item) {
+		return item->getID() == itemId && (subType == -1 || subType == item->getSubType());
+	};
+
+	const size_t positions = lua_rawlen(L, 1);
+	lua_createtable(L, positions, 0);
+
+	int index = 0;
+	for (size_t i = 1; i <= positions; ++i) {
+		lua_rawgeti(L, 1, i);
+		Tile* tile = g_game.map.getTile(getPosition(L, -1));
+		lua_pop(L, 1);
+		if (!tile) {
+			continue;
+		}
+
+		if (Item* ground = tile->getGround(); ground && matches(ground)) {
+			pushUserdata<Item>(L, ground);
+			setItemMetatable(L, -1, ground);
+			lua_rawseti(L, -2, ++index);
+		}
+
+		if (const TileItemVector* items = tile->getItemList()) {
+			for (Item* item : *items) {
+				if (matches(item)) {
+					pushUserdata<Item>(L, item);
+					setItemMetatable(L, -1, item);
+					lua_rawseti(L, -2, ++index);
+				}
+			}
+		}
+	}
+	return 1;
+}
+
 int luaTileGetItemByType(lua_State* L)
 {
 	// tile:getItemByType(itemType)
@@ -333,7 +379,7 @@ int luaTileGetItemCountById(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -625,7 +671,7 @@ int luaTileAddItem(lua_State* L)
 	if (isInteger(L, 2)) {
 		itemId = getInteger<uint16_t>(L, 2);
 	} else {
-		itemId = Item::items.getItemIdByName(getString(L, 2));
+		itemId = Item::items.getItemIdByName(getStringView(L, 2));
 		if (itemId == 0) {
 			lua_pushnil(L);
 			return 1;
@@ -726,6 +772,7 @@ void LuaScriptInterface::registerTile()
 	registerMethod("Tile", "getFieldItem", luaTileGetFieldItem);
 
 	registerMethod("Tile", "getItemById", luaTileGetItemById);
+	registerMethod("Tile", "getItemsByIdBulk", luaTileGetItemsByIdBulk);
 	registerMethod("Tile", "getItemByType", luaTileGetItemByType);
 	registerMethod("Tile", "getItemByTopOrder", luaTileGetItemByTopOrder);
 	registerMethod("Tile", "getItemCountById", luaTileGetItemCountById);
@@ -16,12 +16,12 @@ int luaVariantCreate(lua_State* L)
 {
 	// Variant(number or string or position or thing)
 	LuaVariant variant;
-	if (isUserdata(L, 2)) {
+	if (isPosition(L, 2)) {
+		variant.setPosition(getPosition(L, 2));
+	} else if (isUserdata(L, 2)) {
 		if (Thing* thing = getThing(L, 2)) {
 			variant.setTargetPosition(thing->getPosition());
 		}
-	} else if (isTable(L, 2)) {
-		variant.setPosition(getPosition(L, 2));
 	} else if (isInteger(L, 2)) {
 		variant.setNumber(getInteger<uint32_t>(L, 2));
 	} else if (isString(L, 2)) {
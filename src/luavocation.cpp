@@ -18,7 +18,7 @@ int luaVocationCreate(lua_State* L)
 	uint16_t id;
 	if (isInteger(L, 2)) {
 		id = getInteger<uint16_t>(L, 2);
-	} else if (auto vocationId = g_vocations.getVocationId(getString(L, 2))) {
+	} else if (auto vocationId = g_vocations.getVocationId(getStringView(L, 2))) {
 		id = vocationId.value();
 	} else {
 		lua_pushnil(L);
@@ -33,6 +33,7 @@ int luaCreateWeapon(lua_State* L)
 			setMetatable(L, -1, "Weapon");
 			weapon->weaponType = type;
 			weapon->fromLua = true;
+			weapon->scriptFile = g_scripts->getLoadingFile();
 			break;
 		}
 		case WEAPON_DISTANCE:
@@ -42,6 +43,7 @@ int luaCreateWeapon(lua_State* L)
 			setMetatable(L, -1, "Weapon");
 			weapon->weaponType = type;
 			weapon->fromLua = true;
+			weapon->scriptFile = g_scripts->getLoadingFile();
 			break;
 		}
 		case WEAPON_WAND: {
@@ -50,6 +52,7 @@ int luaCreateWeapon(lua_State* L)
 			setMetatable(L, -1, "Weapon");
 			weapon->weaponType = type;
 			weapon->fromLua = true;
+			weapon->scriptFile = g_scripts->getLoadingFile();
 			break;
 		}
 		default: {
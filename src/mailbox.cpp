@@ -92,18 +92,18 @@ bool Mailbox::sendItem(Item* item) const
 			}
 		}
 	} else {
-		Player tmpPlayer(nullptr);
-		if (!IOLoginData::loadPlayerByName(&tmpPlayer, receiver)) {
+		uint32_t guid = IOLoginData::getGuidByName(receiver);
+		if (guid == 0) {
 			return false;
 		}
 
-		if (DepotLocker* depotLocker = tmpPlayer.getDepotLocker(depotId)) {
-			if (g_game.internalMoveItem(item->getParent(), depotLocker, INDEX_WHEREEVER, item, item->getItemCount(),
-			                            nullptr) == RETURNVALUE_NOERROR) {
-				g_game.transformItem(item, item->getID() + 1);
-				IOLoginData::savePlayer(&tmpPlayer);
-				return true;
-			}
+		// gathered in a locker of its own and only added to the depot rows of the receiver
+		auto depotLocker = std::make_shared<DepotLocker>(ITEM_LOCKER);
+		if (g_game.internalMoveItem(item->getParent(), depotLocker.get(), INDEX_WHEREEVER, item, item->getItemCount(),
+		                            nullptr) == RETURNVALUE_NOERROR) {
+			g_game.transformItem(item, item->getID() + 1);
+			IOLoginData::addDepotItems(guid, depotId, *depotLocker);
+			return true;
 		}
 	}
 	return false;
@@ -16,11 +16,19 @@ static bool argumentsHandler(const std::vector<std::string_view>& args)
 			             "\t--ip=$1\t\t\tIP address of the server.\n"
 			             "\t\t\t\tShould be equal to the global IP.\n"
 			             "\t--login-port=$1\tPort for login server to listen on.\n"
-			             "\t--game-port=$1\tPort for game server to listen on.\n";
+			             "\t--game-port=$1\tPort for game server to listen on.\n"
+			             "\t--replay=$1\t\tReplay a recorded capture instead of accepting clients.\n"
+			             "\t--replay-speed=$1\tReplay at this many times the recorded pace, 0 replays as fast\n"
+			             "\t\t\t\tas possible.\n"
+			             "\t--handover\t\tLoad the world, then take the place of the server listening on\n"
+			             "\t\t\t\thandoverSocket.\n";
 			return false;
 		} else if (arg == "--version") {
 			printServerVersion();
 			return false;
+		} else if (arg == "--handover") {
+			g_config.setBoolean(ConfigKeysBoolean::HANDOVER, true);
+			continue;
 		}
 
 		auto tmp = explodeString(arg, "=");
@@ -33,6 +41,10 @@ static bool argumentsHandler(const std::vector<std::string_view>& args)
 			g_config.setInteger(ConfigKeysInteger::LOGIN_PORT, std::stoi(tmp[1].data()));
 		else if (tmp[0] == "--game-port")
 			g_config.setInteger(ConfigKeysInteger::GAME_PORT, std::stoi(tmp[1].data()));
+		else if (tmp[0] == "--replay")
+			g_config.setString(ConfigKeysString::REPLAY_FILE, tmp[1]);
+		else if (tmp[0] == "--replay-speed")
+			g_config.setInteger(ConfigKeysInteger::REPLAY_SPEED, std::stoi(tmp[1].data()));
 	}
 
 	return true;
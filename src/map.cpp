@@ -6,17 +6,65 @@
 #include "map.h"
 
 #include "combat.h"
+#include "configmanager.h"
 #include "creature.h"
 #include "game.h"
 #include "iomap.h"
 #include "iomapserialize.h"
 #include "monster.h"
+#include "movement.h"
+#include "scheduler.h"
 #include "spectators.h"
+#include "tasks.h"
 
+extern ConfigManager g_config;
 extern Game g_game;
+extern MoveEvents* g_moveEvents;
 
-bool Map::loadMap(const std::string& identifier, bool loadHouses)
+namespace {
+
+void appendSpectators(SpectatorVec& spectators, std::span<Creature* const> cached, bool onlyPlayers)
 {
+	if (!onlyPlayers) {
+		spectators.addSpectators(cached);
+		return;
+	}
+
+	bool checkDuplicates = !spectators.empty();
+	for (Creature* spectator : cached) {
+		if (!spectator->getPlayer()) {
+			continue;
+		}
+
+		if (checkDuplicates && std::find(spectators.begin(), spectators.end(), spectator) != spectators.end()) {
+			continue;
+		}
+		spectators.emplace_back(spectator);
+	}
+}
+
+// the floors a multifloor spectator query around a position on floor z covers
+std::pair<int32_t, int32_t> getSpectatorFloors(int32_t z)
+{
+	if (z > 7) {
+		// underground (8->15)
+		return {std::max(z - 2, 0), std::min(z + 2, MAP_MAX_LAYERS - 1)};
+	} else if (z == 6) {
+		return {0, 8};
+	} else if (z == 7) {
+		return {0, 9};
+	}
+	return {0, 7};
+}
+
+} // namespace
+
+bool Map::loadMap(const std::string& identifier, bool loadHouses, bool loadHouseState)
+{
+	if (!hasTiles) {
+		chunkedStorage = g_config[ConfigKeysBoolean::MAP_CHUNKED_STORAGE];
+	}
+
 	IOMap loader;
 	if (!loader.loadMap(this, identifier)) {
 		std::cout << "[Fatal - Map::loadMap] " << loader.getLastErrorString() << std::endl;
@@ -32,34 +80,23 @@ bool Map::loadMap(const std::string& identifier, bool loadHouses)
 			std::cout << "[Warning - Map::loadMap] Failed to load house data." << std::endl;
 		}
 
-		IOMapSerialize::loadHouseInfo();
-		IOMapSerialize::loadHouseItems(this);
+		if (loadHouseState) {
+			this->loadHouseState();
+		}
 	}
 	return true;
 }
 
-bool Map::save()
+void Map::loadHouseState()
 {
-	bool saved = false;
-	for (uint32_t tries = 0; tries < 3; tries++) {
-		if (IOMapSerialize::saveHouseInfo()) {
-			saved = true;
-			break;
-		}
-	}
-
-	if (!saved) {
-		return false;
-	}
+	IOMapSerialize::loadHouseInfo();
+	IOMapSerialize::loadHouseItems(this);
+}
 
-	saved = false;
-	for (uint32_t tries = 0; tries < 3; tries++) {
-		if (IOMapSerialize::saveHouseItems()) {
-			saved = true;
-			break;
-		}
-	}
-	return saved;
+bool Map::save()
+{
+	// both capture the houses and leave the writes to the database tasks
+	return IOMapSerialize::saveHouseInfo() && IOMapSerialize::saveHouseItems();
 }
 
 Tile* Map::getTile(uint16_t x, uint16_t y, uint8_t z) const
@@ -68,6 +105,17 @@ Tile* Map::getTile(uint16_t x, uint16_t y, uint8_t z) const
 		return nullptr;
 	}
 
+	if (chunkedStorage) {
+		Tile* tile = chunks.getTile(x, y, z);
+		if (tile || !pager.isEnabled()) {
+			return tile;
+		}
+
+		// restoring a paged out area puts back the tiles it had, the map looks the same from the outside
+		Map& map = const_cast<Map&>(*this);
+		return map.pager.pageIn(map, MapChunks::getChunkKey(x, y, z)) ? chunks.getTile(x, y, z) : nullptr;
+	}
+
 	const QTreeLeafNode* leaf = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, x, y);
 	if (!leaf) {
 		return nullptr;
@@ -80,6 +128,62 @@ Tile* Map::getTile(uint16_t x, uint16_t y, uint8_t z) const
 	return floor->tiles[x & FLOOR_MASK][y & FLOOR_MASK];
 }
 
+void Map::getTiles(uint16_t x, uint16_t y, uint8_t z, uint16_t width, uint16_t height, Tile** tiles) const
+{
+	std::fill_n(tiles, static_cast<size_t>(width) * height, nullptr);
+	if (z >= MAP_MAX_LAYERS) {
+		return;
+	}
+
+	// the area is cut into the parts covered by one chunk, or one leaf floor of the quadtree
+	const uint32_t blockBits = chunkedStorage ? MAP_CHUNK_BITS : FLOOR_BITS;
+	const uint32_t endX = std::min<uint32_t>(x + width, std::numeric_limits<uint16_t>::max() + 1);
+	const uint32_t endY = std::min<uint32_t>(y + height, std::numeric_limits<uint16_t>::max() + 1);
+	for (uint32_t blockY = y, blockEndY; blockY < endY; blockY = blockEndY) {
+		blockEndY = std::min(endY, ((blockY >> blockBits) + 1) << blockBits);
+		for (uint32_t blockX = x, blockEndX; blockX < endX; blockX = blockEndX) {
+			blockEndX = std::min(endX, ((blockX >> blockBits) + 1) << blockBits);
+
+			if (chunkedStorage) {
+				const uint32_t chunkKey = MapChunks::getChunkKey(blockX, blockY, z);
+				const MapChunk* chunk = chunks.getChunk(chunkKey);
+				if (!chunk && pager.isEnabled()) {
+					Map& map = const_cast<Map&>(*this);
+					if (map.pager.pageIn(map, chunkKey)) {
+						chunk = chunks.getChunk(chunkKey);
+					}
+				}
+
+				if (!chunk) {
+					continue;
+				}
+
+				for (uint32_t tileY = blockY; tileY < blockEndY; ++tileY) {
+					Tile** row = tiles + (tileY - y) * width;
+					for (uint32_t tileX = blockX; tileX < blockEndX; ++tileX) {
+						row[tileX - x] = chunk->tiles[MapChunks::getTileIndex(tileX, tileY)];
+					}
+				}
+				continue;
+			}
+
+			const QTreeLeafNode* leaf =
+			    QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, blockX, blockY);
+			const Floor* floor = leaf ? leaf->getFloor(z) : nullptr;
+			if (!floor) {
+				continue;
+			}
+
+			for (uint32_t tileY = blockY; tileY < blockEndY; ++tileY) {
+				Tile** row = tiles + (tileY - y) * width;
+				for (uint32_t tileX = blockX; tileX < blockEndX; ++tileX) {
+					row[tileX - x] = floor->tiles[tileX & FLOOR_MASK][tileY & FLOOR_MASK];
+				}
+			}
+		}
+	}
+}
+
 void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 {
 	if (z >= MAP_MAX_LAYERS) {
@@ -87,6 +191,15 @@ void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 		return;
 	}
 
+	hasTiles = true;
+	if (chunkedStorage) {
+		if (pager.isEnabled()) {
+			pager.pageIn(*this, MapChunks::getChunkKey(x, y, z));
+		}
+		storeTile(chunks.getOrCreateTile(x, y, z), newTile);
+		return;
+	}
+
 	QTreeLeafNode::newLeaf = false;
 	QTreeLeafNode* leaf = root.createLeaf(x, y, 15);
 
@@ -119,8 +232,11 @@ void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 	Floor* floor = leaf->createFloor(z);
 	uint32_t offsetX = x & FLOOR_MASK;
 	uint32_t offsetY = y & FLOOR_MASK;
+	storeTile(floor->tiles[offsetX][offsetY], newTile);
+}
 
-	Tile*& tile = floor->tiles[offsetX][offsetY];
+void Map::storeTile(Tile*& tile, Tile* newTile)
+{
 	if (tile) {
 		TileItemVector* items = newTile->getItemList();
 		if (items) {
@@ -138,26 +254,16 @@ void Map::setTile(uint16_t x, uint16_t y, uint8_t z, Tile* newTile)
 		delete newTile;
 	} else {
 		tile = newTile;
+		if (g_moveEvents && g_moveEvents->hasPositionEvents(tile->getPosition())) {
+			tile->setFlag(TILESTATE_MOVEEVENT);
+		}
 	}
+	tile->updateWalkFlags();
 }
 
 void Map::removeTile(uint16_t x, uint16_t y, uint8_t z)
 {
-	if (z >= MAP_MAX_LAYERS) {
-		return;
-	}
-
-	const QTreeLeafNode* leaf = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, x, y);
-	if (!leaf) {
-		return;
-	}
-
-	const Floor* floor = leaf->getFloor(z);
-	if (!floor) {
-		return;
-	}
-
-	Tile* tile = floor->tiles[x & FLOOR_MASK][y & FLOOR_MASK];
+	Tile* tile = getTile(x, y, z);
 	if (tile) {
 		if (const CreatureVector* creatures = tile->getCreatures()) {
 			for (int32_t i = creatures->size(); --i >= 0;) {
@@ -186,20 +292,27 @@ void Map::removeTile(uint16_t x, uint16_t y, uint8_t z)
 bool Map::placeCreature(const Position& centerPos, Creature* creature, bool extendedPos /* = false*/,
                         bool forceLogin /* = false*/)
 {
+	assert(g_dispatcher.isCurrentThread());
+
 	bool foundTile;
 	bool placeInPZ;
 
 	Tile* tile = getTile(centerPos.x, centerPos.y, centerPos.z);
 	if (tile) {
 		placeInPZ = tile->hasFlag(TILESTATE_PROTECTIONZONE);
-		uint32_t flags = FLAG_IGNOREBLOCKITEM;
-		if (const auto player = creature->getPlayer()) {
-			if (player->isAccountManager()) {
-				flags |= FLAG_IGNOREBLOCKCREATURE;
+		// a forced placement takes the center tile whatever it holds, so there is nothing to query
+		if (forceLogin) {
+			foundTile = true;
+		} else {
+			uint32_t flags = FLAG_IGNOREBLOCKITEM;
+			if (const auto player = creature->getPlayer()) {
+				if (player->isAccountManager()) {
+					flags |= FLAG_IGNOREBLOCKCREATURE;
+				}
 			}
+			ReturnValue ret = tile->queryAddCreature(*creature, flags);
+			foundTile = ret == RETURNVALUE_NOERROR || ret == RETURNVALUE_PLAYERISNOTINVITED;
 		}
-		ReturnValue ret = tile->queryAdd(0, *creature, 1, flags);
-		foundTile = forceLogin || ret == RETURNVALUE_NOERROR || ret == RETURNVALUE_PLAYERISNOTINVITED;
 	} else {
 		placeInPZ = false;
 		foundTile = false;
@@ -229,7 +342,7 @@ bool Map::placeCreature(const Position& centerPos, Creature* creature, bool exte
 				continue;
 			}
 
-			if (tile->queryAdd(0, *creature, 1, 0) == RETURNVALUE_NOERROR) {
+			if (tile->queryAddCreature(*creature, 0) == RETURNVALUE_NOERROR) {
 				if (!extendedPos || isSightClear(centerPos, tryPos, false)) {
 					foundTile = true;
 					break;
@@ -249,13 +362,14 @@ bool Map::placeCreature(const Position& centerPos, Creature* creature, bool exte
 	Cylinder* toCylinder = tile->queryDestination(index, *creature, &toItem, flags);
 	toCylinder->internalAddThing(creature);
 
-	const Position& dest = toCylinder->getPosition();
-	getQTNode(dest.x, dest.y)->addCreature(creature);
+	spectatorGrid.addCreature(creature, toCylinder->getPosition());
 	return true;
 }
 
 void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport /* = false*/)
 {
+	assert(g_dispatcher.isCurrentThread());
+
 	Tile& oldTile = *creature.getTile();
 
 	// If the tile does not have the creature it means that the creature is ready for elimination, we skip the move.
@@ -268,33 +382,30 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport /*
 
 	bool teleport = forceTeleport || !newTile.getGround() || !oldPos.isInRange(newPos, 1, 1, 0);
 
-	SpectatorVec spectators, newPosSpectators;
-	getSpectators(spectators, oldPos, true);
-	getSpectators(newPosSpectators, newPos, true);
-	spectators.addSpectators(newPosSpectators);
+	SpectatorVec spectators;
+	auto [leftBegin, enteredBegin] = getMoveSpectators(spectators, oldPos, newPos);
 
+	// a player that did not have the old position in view is only sent the creature appearing, so its stack
+	// position there is not needed
 	std::vector<int32_t> oldStackPosVector;
-	for (Creature* spectator : spectators) {
+	for (size_t index = 0; Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
-			if (tmpPlayer->canSeeCreature(&creature)) {
+			if (!tmpPlayer->canSeeCreature(&creature)) {
+				oldStackPosVector.push_back(-1);
+			} else if (index < enteredBegin) {
 				oldStackPosVector.push_back(oldTile.getClientIndexOfCreature(tmpPlayer, &creature));
 			} else {
-				oldStackPosVector.push_back(-1);
+				oldStackPosVector.push_back(0);
 			}
 		}
+		++index;
 	}
 
 	// remove the creature
 	oldTile.removeThing(&creature, 0);
 
-	QTreeLeafNode* leaf = getQTNode(oldPos.x, oldPos.y);
-	QTreeLeafNode* new_leaf = getQTNode(newPos.x, newPos.y);
-
-	// Switch the node ownership
-	if (leaf != new_leaf) {
-		leaf->removeCreature(&creature);
-		new_leaf->addCreature(&creature);
-	}
+	// switch the grid bucket ownership
+	spectatorGrid.moveCreature(&creature, oldPos, newPos);
 
 	// add the creature
 	newTile.addThing(&creature);
@@ -313,88 +424,168 @@ void Map::moveCreature(Creature& creature, Tile& newTile, bool forceTeleport /*
 		}
 	}
 
-	// send to client
+	// send to client, a player that lost the creature out of view is only sent it disappearing
 	size_t i = 0;
-	for (Creature* spectator : spectators) {
+	for (size_t index = 0; Creature* spectator : spectators) {
 		if (Player* tmpPlayer = spectator->getPlayer()) {
 			// Use the correct stackpos
 			int32_t oldStackPos = oldStackPosVector[i++];
 			if (oldStackPos != -1) {
-				tmpPlayer->sendCreatureMove(&creature, newPos, newTile.getClientIndexOfCreature(tmpPlayer, &creature),
-				                            oldPos, oldStackPos, teleport);
+				int32_t newStackPos = 0;
+				if (index < leftBegin || index >= enteredBegin || tmpPlayer == &creature) {
+					newStackPos = newTile.getClientIndexOfCreature(tmpPlayer, &creature);
+				}
+				tmpPlayer->sendCreatureMove(&creature, newPos, newStackPos, oldPos, oldStackPos, teleport);
 			}
 		}
+		++index;
 	}
 
 	// event method
 	for (Creature* spectator : spectators) {
 		spectator->onCreatureMove(&creature, &newTile, newPos, &oldTile, oldPos, teleport);
 	}
+	creature.onMoveSpectators(spectators);
 
 	oldTile.postRemoveNotification(&creature, &newTile, 0);
 	newTile.postAddNotification(&creature, &oldTile, 0);
 }
 
+std::pair<size_t, size_t> Map::getMoveSpectators(SpectatorVec& spectators, const Position& oldPos,
+                                                 const Position& newPos)
+{
+	if (oldPos.isInRange(newPos, 1, 1, 0)) {
+		// the viewports of a step only differ by the strip it enters, so one query around the new position widened
+		// towards the old one sees them both
+		getSpectators(spectators, newPos, true, false, maxViewportX + std::max(newPos.x - oldPos.x, 0),
+		              maxViewportX + std::max(oldPos.x - newPos.x, 0), maxViewportY + std::max(newPos.y - oldPos.y, 0),
+		              maxViewportY + std::max(oldPos.y - newPos.y, 0));
+	} else {
+		SpectatorVec newPosSpectators;
+		getSpectators(spectators, oldPos, true);
+		getSpectators(newPosSpectators, newPos, true);
+		spectators.addSpectators(newPosSpectators);
+	}
+
+	auto seesOld = [&oldPos](const Creature* spectator) {
+		return isInSpectatorRange(oldPos, spectator->getPosition());
+	};
+	auto seesNew = [&newPos](const Creature* spectator) {
+		return isInSpectatorRange(newPos, spectator->getPosition());
+	};
+
+	// the corners of a widened query see neither position
+	auto entered = std::partition(spectators.begin(), spectators.end(), seesOld);
+	auto neither = std::partition(entered, spectators.end(), seesNew);
+	spectators.resize(neither - spectators.begin());
+
+	auto left = std::partition(spectators.begin(), entered, seesNew);
+	return {left - spectators.begin(), entered - spectators.begin()};
+}
+
 void Map::getSpectatorsInternal(SpectatorVec& spectators, const Position& centerPos, int32_t minRangeX,
                                 int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ,
                                 int32_t maxRangeZ, bool onlyPlayers) const
 {
-	auto min_y = centerPos.y + minRangeY;
-	auto min_x = centerPos.x + minRangeX;
-	auto max_y = centerPos.y + maxRangeY;
-	auto max_x = centerPos.x + maxRangeX;
-
-	int32_t minoffset = centerPos.getZ() - maxRangeZ;
-	uint16_t x1 = static_cast<uint16_t>(std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (min_x + minoffset))));
-	uint16_t y1 = static_cast<uint16_t>(std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (min_y + minoffset))));
-
-	int32_t maxoffset = centerPos.getZ() - minRangeZ;
-	uint16_t x2 = static_cast<uint16_t>(std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (max_x + maxoffset))));
-	uint16_t y2 = static_cast<uint16_t>(std::min<uint32_t>(0xFFFF, std::max<int32_t>(0, (max_y + maxoffset))));
-
-	int32_t startx1 = x1 - (x1 % FLOOR_SIZE);
-	int32_t starty1 = y1 - (y1 % FLOOR_SIZE);
-	int32_t endx2 = x2 - (x2 % FLOOR_SIZE);
-	int32_t endy2 = y2 - (y2 % FLOOR_SIZE);
-
-	const QTreeLeafNode* startLeaf =
-	    QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, startx1, starty1);
-	const QTreeLeafNode* leafS = startLeaf;
-	const QTreeLeafNode* leafE;
-
-	for (int_fast32_t ny = starty1; ny <= endy2; ny += FLOOR_SIZE) {
-		leafE = leafS;
-		for (int_fast32_t nx = startx1; nx <= endx2; nx += FLOOR_SIZE) {
-			if (leafE) {
-				const CreatureVector& node_list = (onlyPlayers ? leafE->player_list : leafE->creature_list);
-				for (Creature* creature : node_list) {
-					const Position& cpos = creature->getPosition();
-					if (minRangeZ > cpos.z || maxRangeZ < cpos.z) {
-						continue;
-					}
+	for (int32_t z = minRangeZ; z <= maxRangeZ; ++z) {
+		if (spectatorGrid.isFloorEmpty(static_cast<uint8_t>(z))) {
+			continue;
+		}
 
-					int16_t offsetZ = centerPos.getOffsetZ(cpos);
-					if ((min_y + offsetZ) > cpos.y || (max_y + offsetZ) < cpos.y || (min_x + offsetZ) > cpos.x ||
-					    (max_x + offsetZ) < cpos.x) {
-						continue;
-					}
+		// floors above and below are seen shifted by one tile per floor of difference
+		int32_t offsetZ = centerPos.getZ() - z;
+		int32_t min_x = centerPos.x + minRangeX + offsetZ;
+		int32_t max_x = centerPos.x + maxRangeX + offsetZ;
+		int32_t min_y = centerPos.y + minRangeY + offsetZ;
+		int32_t max_y = centerPos.y + maxRangeY + offsetZ;
+		if (max_x < 0 || max_y < 0 || min_x > 0xFFFF || min_y > 0xFFFF) {
+			continue;
+		}
+
+		uint16_t x1 = static_cast<uint16_t>(std::max<int32_t>(0, min_x));
+		uint16_t y1 = static_cast<uint16_t>(std::max<int32_t>(0, min_y));
+		uint16_t x2 = static_cast<uint16_t>(std::min<int32_t>(0xFFFF, max_x));
+		uint16_t y2 = static_cast<uint16_t>(std::min<int32_t>(0xFFFF, max_y));
 
+		auto collect = [&](const CreatureVector& bucket) {
+			for (Creature* creature : bucket) {
+				const Position& cpos = creature->getPosition();
+				if (cpos.x >= x1 && cpos.x <= x2 && cpos.y >= y1 && cpos.y <= y2) {
 					spectators.emplace_back(creature);
 				}
-				leafE = leafE->leafE;
-			} else {
-				leafE = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, nx + FLOOR_SIZE, ny);
+			}
+		};
+		spectatorGrid.forEachBucket(x1, y1, x2, y2, static_cast<uint8_t>(z), onlyPlayers, collect);
+	}
+}
+
+void Map::getAreaSpectators(SpectatorVec& spectators, const std::vector<Position>& positions)
+{
+	for (uint8_t z = 0; z < MAP_MAX_LAYERS; ++z) {
+		uint16_t minX = std::numeric_limits<uint16_t>::max(), maxX = 0;
+		uint16_t minY = std::numeric_limits<uint16_t>::max(), maxY = 0;
+		for (const Position& pos : positions) {
+			if (pos.z == z) {
+				minX = std::min(minX, pos.x);
+				maxX = std::max(maxX, pos.x);
+				minY = std::min(minY, pos.y);
+				maxY = std::max(maxY, pos.y);
 			}
 		}
 
-		if (leafS) {
-			leafS = leafS->leafS;
-		} else {
-			leafS = QTreeNode::getLeafStatic<const QTreeLeafNode*, const QTreeNode*>(&root, startx1, ny + FLOOR_SIZE);
+		if (minX > maxX) {
+			continue;
 		}
+
+		// widened from the center so every position stays in view, a single position is an ordinary cached query
+		const Position centerPos(minX + (maxX - minX) / 2, minY + (maxY - minY) / 2, z);
+		SpectatorVec floorSpectators;
+		getSpectators(floorSpectators, centerPos, true, false, centerPos.x - minX + maxViewportX,
+		              maxX - centerPos.x + maxViewportX, centerPos.y - minY + maxViewportY,
+		              maxY - centerPos.y + maxViewportY);
+		spectators.addSpectators(floorSpectators);
 	}
 }
 
+bool Map::isInSpectatorRange(const Position& centerPos, const Position& pos)
+{
+	auto [minZ, maxZ] = getSpectatorFloors(centerPos.z);
+	if (pos.z < minZ || pos.z > maxZ) {
+		return false;
+	}
+
+	const int32_t offsetZ = centerPos.getZ() - pos.getZ();
+	return std::abs(pos.x - centerPos.x - offsetZ) <= maxViewportX &&
+	       std::abs(pos.y - centerPos.y - offsetZ) <= maxViewportY;
+}
+
+bool Map::hasPlayerInRange(const Position& pos, int32_t range) const
+{
+	const uint16_t x1 = static_cast<uint16_t>(std::max<int32_t>(0, pos.x - range));
+	const uint16_t y1 = static_cast<uint16_t>(std::max<int32_t>(0, pos.y - range));
+	const uint16_t x2 = static_cast<uint16_t>(std::min<int32_t>(0xFFFF, pos.x + range));
+	const uint16_t y2 = static_cast<uint16_t>(std::min<int32_t>(0xFFFF, pos.y + range));
+
+	bool found = false;
+	auto find = [&](const CreatureVector& bucket) {
+		for (const Creature* player : bucket) {
+			const Position& playerPos = player->getPosition();
+			if (playerPos.x >= x1 && playerPos.x <= x2 && playerPos.y >= y1 && playerPos.y <= y2) {
+				found = true;
+				return;
+			}
+		}
+	};
+
+	const int32_t maxZ = std::min<int32_t>(MAP_MAX_LAYERS - 1, pos.z + 2);
+	for (int32_t z = std::max<int32_t>(0, pos.z - 2); z <= maxZ && !found; ++z) {
+		if (spectatorGrid.hasPlayers(static_cast<uint8_t>(z))) {
+			spectatorGrid.forEachBucket(x1, y1, x2, y2, static_cast<uint8_t>(z), true, find);
+		}
+	}
+	return found;
+}
+
 void Map::getSpectators(SpectatorVec& spectators, const Position& centerPos, bool multifloor /*= false*/,
                         bool onlyPlayers /*= false*/, int32_t minRangeX /*= 0*/, int32_t maxRangeX /*= 0*/,
                         int32_t minRangeY /*= 0*/, int32_t maxRangeY /*= 0*/)
@@ -414,35 +605,15 @@ void Map::getSpectators(SpectatorVec& spectators, const Position& centerPos, boo
 	if (minRangeX == -maxViewportX && maxRangeX == maxViewportX && minRangeY == -maxViewportY &&
 	    maxRangeY == maxViewportY && multifloor) {
 		if (onlyPlayers) {
-			if (playersSpectatorCache.contains(centerPos)) {
-				if (!spectators.empty()) {
-					spectators.addSpectators(playersSpectatorCache[centerPos]);
-				} else {
-					spectators = playersSpectatorCache[centerPos];
-				}
-
+			if (auto cachedSpectators = playersSpectatorCache.find(centerPos)) {
+				appendSpectators(spectators, *cachedSpectators, false);
 				foundCache = true;
 			}
 		}
 
 		if (!foundCache) {
-			if (spectatorCache.contains(centerPos)) {
-				if (!onlyPlayers) {
-					if (!spectators.empty()) {
-						const SpectatorVec& cachedSpectators = spectatorCache[centerPos];
-						spectators.addSpectators(cachedSpectators);
-					} else {
-						spectators = spectatorCache[centerPos];
-					}
-				} else {
-					const SpectatorVec& cachedSpectators = spectatorCache[centerPos];
-					for (Creature* spectator : cachedSpectators) {
-						if (spectator->getPlayer()) {
-							spectators.emplace_back(spectator);
-						}
-					}
-				}
-
+			if (auto cachedSpectators = spectatorCache.find(centerPos)) {
+				appendSpectators(spectators, *cachedSpectators, onlyPlayers);
 				foundCache = true;
 			} else {
 				cacheResult = true;
@@ -455,42 +626,33 @@ void Map::getSpectators(SpectatorVec& spectators, const Position& centerPos, boo
 		int32_t maxRangeZ;
 
 		if (multifloor) {
-			if (centerPos.z > 7) {
-				// underground (8->15)
-				minRangeZ = std::max(centerPos.getZ() - 2, 0);
-				maxRangeZ = std::min(centerPos.getZ() + 2, MAP_MAX_LAYERS - 1);
-			} else if (centerPos.z == 6) {
-				minRangeZ = 0;
-				maxRangeZ = 8;
-			} else if (centerPos.z == 7) {
-				minRangeZ = 0;
-				maxRangeZ = 9;
-			} else {
-				minRangeZ = 0;
-				maxRangeZ = 7;
-			}
+			std::tie(minRangeZ, maxRangeZ) = getSpectatorFloors(centerPos.z);
 		} else {
 			minRangeZ = centerPos.z;
 			maxRangeZ = centerPos.z;
 		}
 
-		getSpectatorsInternal(spectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ,
-		                      onlyPlayers);
-
 		if (cacheResult) {
+			// scan into a scratch list so entries already in spectators are not cached along with the result
+			static SpectatorVec found;
+			found.clear();
+			getSpectatorsInternal(found, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ, maxRangeZ,
+			                      onlyPlayers);
+
+			std::span<Creature* const> result = found.view();
 			if (onlyPlayers) {
-				playersSpectatorCache[centerPos] = spectators;
+				playersSpectatorCache.store(centerPos, result);
 			} else {
-				spectatorCache[centerPos] = spectators;
+				spectatorCache.store(centerPos, result);
 			}
+			appendSpectators(spectators, result, false);
+		} else {
+			getSpectatorsInternal(spectators, centerPos, minRangeX, maxRangeX, minRangeY, maxRangeY, minRangeZ,
+			                      maxRangeZ, onlyPlayers);
 		}
 	}
 }
 
-void Map::clearSpectatorCache() { spectatorCache.clear(); }
-
-void Map::clearPlayersSpectatorCache() { playersSpectatorCache.clear(); }
-
 bool Map::canThrowObjectTo(const Position& fromPos, const Position& toPos, bool checkLineOfSight /*= true*/,
                            bool sameFloor /*= false*/, int32_t rangex /*= Map::maxClientViewportX*/,
                            int32_t rangey /*= Map::maxClientViewportY*/) const
@@ -504,21 +666,18 @@ bool Map::canThrowObjectTo(const Position& fromPos, const Position& toPos, bool
 
 bool Map::isTileClear(uint16_t x, uint16_t y, uint8_t z, bool blockFloor /*= false*/) const
 {
-	const Tile* tile = getTile(x, y, z);
-	if (!tile) {
-		return true;
-	}
-
-	if (blockFloor && tile->getGround()) {
+	const uint8_t walkFlags = getTileWalkFlags(x, y, z);
+	if (blockFloor && (walkFlags & TILEWALK_GROUND)) {
 		return false;
 	}
 
-	return !tile->hasProperty(CONST_PROP_BLOCKPROJECTILE);
+	return !(walkFlags & TILEWALK_BLOCKPROJECTILE);
 }
 
 namespace {
 
-bool checkSteepLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z)
+template <typename IsClear>
+bool checkSteepLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, const IsClear& isClear)
 {
 	float dx = x1 - x0;
 	float slope = (dx == 0) ? 1 : (y1 - y0) / dx;
@@ -526,7 +685,7 @@ bool checkSteepLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t
 
 	for (uint16_t x = x0 + 1; x < x1; ++x) {
 		// 0.1 is necessary to avoid loss of precision during calculation
-		if (!g_game.map.isTileClear(std::floor(yi + 0.1), x, z)) {
+		if (!isClear(std::floor(yi + 0.1), x)) {
 			return false;
 		}
 		yi += slope;
@@ -535,7 +694,8 @@ bool checkSteepLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t
 	return true;
 }
 
-bool checkSlightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z)
+template <typename IsClear>
+bool checkSlightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, const IsClear& isClear)
 {
 	float dx = x1 - x0;
 	float slope = (dx == 0) ? 1 : (y1 - y0) / dx;
@@ -543,7 +703,7 @@ bool checkSlightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t
 
 	for (uint16_t x = x0 + 1; x < x1; ++x) {
 		// 0.1 is necessary to avoid loss of precision during calculation
-		if (!g_game.map.isTileClear(x, std::floor(yi + 0.1), z)) {
+		if (!isClear(x, std::floor(yi + 0.1))) {
 			return false;
 		}
 		yi += slope;
@@ -552,9 +712,9 @@ bool checkSlightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t
 	return true;
 }
 
-} // namespace
-
-bool Map::checkSightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z) const
+// isClear(x, y) tells whether a single tile lets the sight line through
+template <typename IsClear>
+bool checkLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, const IsClear& isClear)
 {
 	if (x0 == x1 && y0 == y1) {
 		return true;
@@ -562,16 +722,40 @@ bool Map::checkSightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uin
 
 	if (std::abs(y1 - y0) > std::abs(x1 - x0)) {
 		if (y1 > y0) {
-			return checkSteepLine(y0, x0, y1, x1, z);
+			return checkSteepLine(y0, x0, y1, x1, isClear);
 		}
-		return checkSteepLine(y1, x1, y0, x0, z);
+		return checkSteepLine(y1, x1, y0, x0, isClear);
 	}
 
 	if (x0 > x1) {
-		return checkSlightLine(x1, y1, x0, y0, z);
+		return checkSlightLine(x1, y1, x0, y0, isClear);
 	}
 
-	return checkSlightLine(x0, y0, x1, y1, z);
+	return checkSlightLine(x0, y0, x1, y1, isClear);
+}
+
+} // namespace
+
+bool Map::checkSightLine(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z) const
+{
+	if (std::optional<bool> sightClear = sightLineCache.find(x0, y0, x1, y1, z)) {
+		return *sightClear;
+	}
+
+	// consecutive steps nearly always stay in the same chunk, so look it up only when the line leaves it
+	uint32_t chunkKey = 0;
+	const uint8_t* chunk = nullptr;
+	bool sightClear = checkLine(x0, y0, x1, y1, [&](uint16_t x, uint16_t y) {
+		uint32_t key = MapChunks::getChunkKey(x, y, z);
+		if (key != chunkKey) {
+			chunkKey = key;
+			chunk = tileWalkMap.getChunk(key);
+		}
+		return !chunk || !(chunk[MapChunks::getTileIndex(x, y)] & TILEWALK_BLOCKPROJECTILE);
+	});
+
+	sightLineCache.store(x0, y0, x1, y1, z, sightClear);
+	return sightClear;
 }
 
 bool Map::isSightClear(const Position& fromPos, const Position& toPos, bool sameFloor /*= false*/) const
@@ -643,8 +827,22 @@ const Tile* Map::canWalkTo(const Creature& creature, const Position& pos) const
 	}
 
 	// used for non-cached tiles
+	const Tile* creatureTile = creature.getTile();
+	if (!creatureTile || creatureTile->getPosition() != pos) {
+		const uint8_t walkFlags = getTileWalkFlags(pos.x, pos.y, pos.z);
+		if (!(walkFlags & TILEWALK_GROUND) || (walkFlags & TILEWALK_BLOCKED)) {
+			return nullptr;
+		}
+
+		// a plain empty tile accepts everyone except pz locked players, whose checks depend on their own tile
+		const Player* player = creature.getPlayer();
+		if (walkFlags == TILEWALK_GROUND && (!player || !player->isPzLocked())) {
+			return getTile(pos.x, pos.y, pos.z);
+		}
+	}
+
 	Tile* tile = getTile(pos.x, pos.y, pos.z);
-	if (creature.getTile() != tile) {
+	if (creatureTile != tile) {
 		if (!tile) {
 			return nullptr;
 		}
@@ -654,20 +852,27 @@ const Tile* Map::canWalkTo(const Creature& creature, const Position& pos) const
 			flags |= FLAG_IGNOREFIELDDAMAGE;
 		}
 
-		if (tile->queryAdd(0, creature, 1, flags) != RETURNVALUE_NOERROR) {
+		if (tile->queryAddCreature(creature, flags) != RETURNVALUE_NOERROR) {
 			return nullptr;
 		}
 	}
 	return tile;
 }
 
-bool Map::getPathMatching(const Creature& creature, std::vector<Direction>& dirList,
-                          const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp) const
+namespace {
+
+// getWalkCost(pos, known) returns the extra cost of entering pos or -1 if it cannot be entered, known is set when
+// pos already holds a node and was therefore found walkable before
+template <typename WalkCost>
+bool searchPath(const Position& startPos, std::vector<Direction>& dirList,
+                const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp, const WalkCost& getWalkCost)
 {
-	Position pos = creature.getPosition();
+	Position pos = startPos;
 	Position endPos;
 
-	AStarNodes nodes(pos.x, pos.y);
+	// reused across searches so the node table keeps its capacity
+	static thread_local AStarNodes nodes;
+	nodes.reset(pos.x, pos.y);
 
 	int32_t bestMatch = 0;
 
@@ -678,8 +883,6 @@ bool Map::getPathMatching(const Creature& creature, std::vector<Direction>& dirL
 	    {{0, 1}, {1, 0}, {1, -1}, {1, 1}, {-1, 1}},    {{-1, 0}, {0, 1}, {-1, -1}, {1, 1}, {-1, 1}}};
 	static int_fast32_t allNeighbors[8][2] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}, {-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
 
-	const Position startPos = pos;
-
 	AStarNode* found = nullptr;
 	while (fpp.maxSearchDist != 0 || nodes.getClosedNodes() < 100) {
 		AStarNode* n = nodes.getBestNode();
@@ -750,20 +953,14 @@ bool Map::getPathMatching(const Creature& creature, std::vector<Direction>& dirL
 				continue;
 			}
 
-			const Tile* tile;
 			AStarNode* neighborNode = nodes.getNodeByPosition(pos.x, pos.y);
-			if (neighborNode) {
-				tile = getTile(pos.x, pos.y, pos.z);
-			} else {
-				tile = canWalkTo(creature, pos);
-				if (!tile) {
-					continue;
-				}
+			const int_fast32_t extraCost = getWalkCost(pos, neighborNode != nullptr);
+			if (extraCost < 0) {
+				continue;
 			}
 
 			// The cost (g) for this neighbor
 			const int_fast32_t cost = AStarNodes::getMapWalkCost(n, pos);
-			const int_fast32_t extraCost = AStarNodes::getTileWalkCost(creature, tile);
 			const int_fast32_t newf = f + cost + extraCost;
 
 			if (neighborNode) {
@@ -831,20 +1028,124 @@ bool Map::getPathMatching(const Creature& creature, std::vector<Direction>& dirL
 	return true;
 }
 
+} // namespace
+
+bool Map::getPathMatching(const Creature& creature, std::vector<Direction>& dirList,
+                          const FrozenPathingConditionCall& pathCondition, const FindPathParams& fpp) const
+{
+	auto getWalkCost = [this, &creature](const Position& pos, bool known) -> int_fast32_t {
+		const uint8_t walkFlags = getTileWalkFlags(pos.x, pos.y, pos.z);
+		if (!(walkFlags & TILEWALK_GROUND)) {
+			return -1;
+		}
+
+		const Tile* tile = known ? getTile(pos.x, pos.y, pos.z) : canWalkTo(creature, pos);
+		if (!tile) {
+			return -1;
+		}
+
+		if (walkFlags & (TILEWALK_CREATURE | TILEWALK_FIELD)) {
+			return AStarNodes::getTileWalkCost(creature, tile);
+		}
+		return 0;
+	};
+	return searchPath(creature.getPosition(), dirList, pathCondition, fpp, getWalkCost);
+}
+
+// PathSnapshot
+bool PathSnapshot::capture(const Map& map, const Creature& creature, const Position& targetPos,
+                           const FindPathParams& fpp)
+{
+	if (fpp.maxSearchDist == 0) {
+		return false;
+	}
+
+	this->startPos = creature.getPosition();
+	this->targetPos = targetPos;
+	this->fpp = fpp;
+
+	// every node the search may open, plus the target so sight lines towards it stay inside
+	minX = std::max<int32_t>(0, std::min<int32_t>(startPos.x - fpp.maxSearchDist, targetPos.x));
+	minY = std::max<int32_t>(0, std::min<int32_t>(startPos.y - fpp.maxSearchDist, targetPos.y));
+	int32_t maxX = std::min<int32_t>(0xFFFF, std::max<int32_t>(startPos.x + fpp.maxSearchDist, targetPos.x));
+	int32_t maxY = std::min<int32_t>(0xFFFF, std::max<int32_t>(startPos.y + fpp.maxSearchDist, targetPos.y));
+	width = maxX - minX + 1;
+	height = maxY - minY + 1;
+
+	cells.assign(width * height, Cell{});
+
+	Position pos = startPos;
+	for (int32_t y = minY; y <= maxY; ++y) {
+		for (int32_t x = minX; x <= maxX; ++x) {
+			pos.x = static_cast<uint16_t>(x);
+			pos.y = static_cast<uint16_t>(y);
+
+			Cell& cell = cells[(y - minY) * width + (x - minX)];
+			const uint8_t walkFlags = map.getTileWalkFlags(pos.x, pos.y, pos.z);
+			cell.blockProjectile = (walkFlags & TILEWALK_BLOCKPROJECTILE) != 0;
+			if (!(walkFlags & TILEWALK_GROUND)) {
+				continue;
+			}
+
+			const Tile* tile = pos == startPos ? creature.getTile() : map.canWalkTo(creature, pos);
+			if (!tile) {
+				continue;
+			}
+
+			if (walkFlags & (TILEWALK_CREATURE | TILEWALK_FIELD)) {
+				cell.walkCost = static_cast<int16_t>(AStarNodes::getTileWalkCost(creature, tile));
+			} else {
+				cell.walkCost = 0;
+			}
+		}
+	}
+	return true;
+}
+
+bool PathSnapshot::getPathMatching(std::vector<Direction>& dirList) const
+{
+	FrozenPathingConditionCall pathCondition(targetPos);
+	pathCondition.snapshot = this;
+
+	return searchPath(startPos, dirList, pathCondition, fpp, [this](const Position& pos, bool) -> int_fast32_t {
+		const Cell* cell = getCell(pos.x, pos.y);
+		return cell ? cell->walkCost : -1;
+	});
+}
+
+bool PathSnapshot::isSightClear(const Position& fromPos, const Position& toPos) const
+{
+	if (fromPos.z != toPos.z) {
+		return false;
+	}
+
+	if (fromPos.getDistanceX(toPos) < 2 && fromPos.getDistanceY(toPos) < 2) {
+		return true;
+	}
+
+	return checkLine(fromPos.x, fromPos.y, toPos.x, toPos.y, [this](uint16_t x, uint16_t y) {
+		const Cell* cell = getCell(x, y);
+		return !cell || !cell->blockProjectile;
+	});
+}
+
 // AStarNodes
 
-AStarNodes::AStarNodes(uint32_t x, uint32_t y) : nodes(), openNodes()
+void AStarNodes::reset(uint32_t x, uint32_t y)
 {
 	curNode = 1;
 	closedNodes = 0;
-	openNodes[0] = true;
+	openHeapSize = 0;
+	nodeTable.clear();
 
 	AStarNode& startNode = nodes[0];
 	startNode.parent = nullptr;
 	startNode.x = static_cast<uint16_t>(x);
 	startNode.y = static_cast<uint16_t>(y);
 	startNode.f = 0;
-	nodeTable[(x << 16) | y] = nodes;
+	openNodes[0] = true;
+	nodeTable[(x << 16) | y] = 0;
+	pushOpen(0);
 }
 
 AStarNode* AStarNodes::createOpenNode(AStarNode* parent, uint32_t x, uint32_t y, int_fast32_t f)
@@ -853,37 +1154,33 @@ AStarNode* AStarNodes::createOpenNode(AStarNode* parent, uint32_t x, uint32_t y,
 		return nullptr;
 	}
 
-	size_t retNode = curNode++;
+	uint16_t retNode = static_cast<uint16_t>(curNode++);
 	openNodes[retNode] = true;
 
 	AStarNode* node = nodes + retNode;
-	nodeTable[(x << 16) | y] = node;
+	nodeTable[(x << 16) | y] = retNode;
 	node->parent = parent;
 	node->x = static_cast<uint16_t>(x);
 	node->y = static_cast<uint16_t>(y);
 	node->f = f;
+	pushOpen(retNode);
 	return node;
 }
 
 AStarNode* AStarNodes::getBestNode()
 {
-	if (curNode == 0) {
+	if (openHeapSize == 0) {
 		return nullptr;
 	}
 
-	int32_t best_node_f = std::numeric_limits<int32_t>::max();
-	int32_t best_node = -1;
-	for (size_t i = 0; i < curNode; i++) {
-		if (openNodes[i] && nodes[i].f < best_node_f) {
-			best_node_f = nodes[i].f;
-			best_node = i;
-		}
-	}
-
-	if (best_node >= 0) {
-		return nodes + best_node;
+	uint16_t best = openHeap[0];
+	heapIndex[best] = NOT_IN_HEAP;
+	if (--openHeapSize > 0) {
+		openHeap[0] = openHeap[openHeapSize];
+		heapIndex[openHeap[0]] = 0;
+		siftDown(0);
 	}
-	return nullptr;
+	return nodes + best;
 }
 
 void AStarNodes::closeNode(AStarNode* node)
@@ -902,17 +1199,72 @@ void AStarNodes::openNode(AStarNode* node)
 		openNodes[index] = true;
 		--closedNodes;
 	}
+
+	if (heapIndex[index] == NOT_IN_HEAP) {
+		pushOpen(static_cast<uint16_t>(index));
+	} else {
+		siftUp(heapIndex[index]);
+	}
 }
 
 int_fast32_t AStarNodes::getClosedNodes() const { return closedNodes; }
 
 AStarNode* AStarNodes::getNodeByPosition(uint32_t x, uint32_t y)
 {
-	auto it = nodeTable.find((x << 16) | y);
-	if (it == nodeTable.end()) {
+	const uint16_t* index = nodeTable.find((x << 16) | y);
+	if (!index) {
 		return nullptr;
 	}
-	return it->second;
+	return nodes + *index;
+}
+
+void AStarNodes::pushOpen(uint16_t index)
+{
+	openHeap[openHeapSize] = index;
+	heapIndex[index] = static_cast<uint16_t>(openHeapSize);
+	siftUp(openHeapSize++);
+}
+
+void AStarNodes::siftUp(size_t position)
+{
+	uint16_t index = openHeap[position];
+	while (position > 0) {
+		size_t parent = (position - 1) / 2;
+		if (!isBetter(index, openHeap[parent])) {
+			break;
+		}
+
+		openHeap[position] = openHeap[parent];
+		heapIndex[openHeap[position]] = static_cast<uint16_t>(position);
+		position = parent;
+	}
+	openHeap[position] = index;
+	heapIndex[index] = static_cast<uint16_t>(position);
+}
+
+void AStarNodes::siftDown(size_t position)
+{
+	uint16_t index = openHeap[position];
+	while (true) {
+		size_t child = position * 2 + 1;
+		if (child >= openHeapSize) {
+			break;
+		}
+
+		if (child + 1 < openHeapSize && isBetter(openHeap[child + 1], openHeap[child])) {
+			++child;
+		}
+
+		if (!isBetter(openHeap[child], index)) {
+			break;
+		}
+
+		openHeap[position] = openHeap[child];
+		heapIndex[openHeap[position]] = static_cast<uint16_t>(position);
+		position = child;
+	}
+	openHeap[position] = index;
+	heapIndex[index] = static_cast<uint16_t>(position);
 }
 
 int_fast32_t AStarNodes::getMapWalkCost(AStarNode* node, const Position& neighborPos)
@@ -953,6 +1305,14 @@ Floor::~Floor()
 	}
 }
 
+// MapChunk
+MapChunk::~MapChunk()
+{
+	for (auto tile : tiles) {
+		delete tile;
+	}
+}
+
 // QTreeNode
 QTreeNode::~QTreeNode()
 {
@@ -1009,33 +1369,177 @@ Floor* QTreeLeafNode::createFloor(uint32_t z)
 	return array[z];
 }
 
-void QTreeLeafNode::addCreature(Creature* c)
+// SpectatorCache
+std::optional<std::span<Creature* const>> SpectatorCache::find(const Position& centerPos) const
+{
+	const Entry* entry = entries.find(getPositionKey(centerPos));
+	if (!entry || entry->generation != getGeneration(centerPos)) {
+		return std::nullopt;
+	}
+	return std::span<Creature* const>(arena.data() + entry->offset, entry->size);
+}
+
+void SpectatorCache::store(const Position& centerPos, std::span<Creature* const> spectators)
+{
+	if (arena.size() + spectators.size() > SPECTATOR_CACHE_ARENA_SIZE || entries.size() >= SPECTATOR_CACHE_MAX_ENTRIES) {
+		// stale entries keep their arena space until the whole arena is recycled
+		arena.clear();
+		entries.clear();
+	}
+
+	Entry& entry = entries[getPositionKey(centerPos)];
+	entry.generation = getGeneration(centerPos);
+	entry.offset = static_cast<uint32_t>(arena.size());
+	entry.size = static_cast<uint32_t>(spectators.size());
+	arena.insert(arena.end(), spectators.begin(), spectators.end());
+}
+
+void SpectatorCache::invalidate(const Position& pos)
+{
+	// a viewport centered up to this far away can see pos, including the shift of the farthest visible floor
+	static constexpr int32_t rangeX = Map::maxViewportX + 7;
+	static constexpr int32_t rangeY = Map::maxViewportY + 7;
+
+	uint32_t rx1 = std::max<int32_t>(0, pos.x - rangeX) >> SPECTATOR_CACHE_REGION_BITS;
+	uint32_t ry1 = std::max<int32_t>(0, pos.y - rangeY) >> SPECTATOR_CACHE_REGION_BITS;
+	uint32_t rx2 = std::min<int32_t>(0xFFFF, pos.x + rangeX) >> SPECTATOR_CACHE_REGION_BITS;
+	uint32_t ry2 = std::min<int32_t>(0xFFFF, pos.y + rangeY) >> SPECTATOR_CACHE_REGION_BITS;
+	for (uint32_t ry = ry1; ry <= ry2; ++ry) {
+		for (uint32_t rx = rx1; rx <= rx2; ++rx) {
+			++generations[getRegionKey(rx, ry)];
+		}
+	}
+}
+
+uint32_t SpectatorCache::getGeneration(const Position& pos) const
+{
+	const uint32_t* generation =
+	    generations.find(getRegionKey(pos.x >> SPECTATOR_CACHE_REGION_BITS, pos.y >> SPECTATOR_CACHE_REGION_BITS));
+	return generation ? *generation : 0;
+}
+
+// SightLineCache
+std::optional<bool> SightLineCache::find(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z) const
 {
-	creature_list.push_back(c);
+	uint64_t key = getEntryKey(x0, y0, x1, y1, z);
+	if (key == 0) {
+		return std::nullopt;
+	}
 
-	if (c->getPlayer()) {
-		player_list.push_back(c);
+	const Entry& entry = entries[getSlot(key)];
+	if (entry.key != key || entry.generation != getGeneration(x0, y0, z)) {
+		return std::nullopt;
 	}
+	return entry.sightClear;
 }
 
-void QTreeLeafNode::removeCreature(Creature* c)
+void SightLineCache::store(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z, bool sightClear)
 {
-	auto iter = std::find(creature_list.begin(), creature_list.end(), c);
-	assert(iter != creature_list.end());
-	*iter = creature_list.back();
-	creature_list.pop_back();
+	uint64_t key = getEntryKey(x0, y0, x1, y1, z);
+	if (key == 0 || readOnly) {
+		return;
+	}
 
-	if (c->getPlayer()) {
-		iter = std::find(player_list.begin(), player_list.end(), c);
-		assert(iter != player_list.end());
-		*iter = player_list.back();
-		player_list.pop_back();
+	Entry& entry = entries[getSlot(key)];
+	entry.key = key;
+	entry.generation = getGeneration(x0, y0, z);
+	entry.sightClear = sightClear;
+}
+
+void SightLineCache::invalidate(const Position& pos)
+{
+	// every cached line through pos starts at most this far away from it
+	uint32_t rx1 = std::max<int32_t>(0, pos.x - SIGHT_CACHE_MAX_DISTANCE) >> SIGHT_CACHE_REGION_BITS;
+	uint32_t ry1 = std::max<int32_t>(0, pos.y - SIGHT_CACHE_MAX_DISTANCE) >> SIGHT_CACHE_REGION_BITS;
+	uint32_t rx2 = std::min<int32_t>(0xFFFF, pos.x + SIGHT_CACHE_MAX_DISTANCE) >> SIGHT_CACHE_REGION_BITS;
+	uint32_t ry2 = std::min<int32_t>(0xFFFF, pos.y + SIGHT_CACHE_MAX_DISTANCE) >> SIGHT_CACHE_REGION_BITS;
+	for (uint32_t ry = ry1; ry <= ry2; ++ry) {
+		for (uint32_t rx = rx1; rx <= rx2; ++rx) {
+			++generations[getRegionKey(rx, ry, pos.z)];
+		}
 	}
 }
 
+uint32_t SightLineCache::getGeneration(uint16_t x, uint16_t y, uint8_t z) const
+{
+	const uint32_t* generation =
+	    generations.find(getRegionKey(x >> SIGHT_CACHE_REGION_BITS, y >> SIGHT_CACHE_REGION_BITS, z));
+	return generation ? *generation : 0;
+}
+
+// SpectatorGrid
+void SpectatorGrid::addCreature(Creature* creature, const Position& pos)
+{
+	Cell& cell = cells[getCellKey(pos)];
+	cell.creatures.push_back(creature);
+	if (creature->getPlayer()) {
+		cell.players.push_back(creature);
+		++floorPlayerCount[pos.z];
+	}
+	++floorCreatureCount[pos.z];
+}
+
+void SpectatorGrid::removeCreature(Creature* creature, const Position& pos)
+{
+	Cell* cell = cells.find(getCellKey(pos));
+	assert(cell);
+
+	auto iter = std::find(cell->creatures.begin(), cell->creatures.end(), creature);
+	assert(iter != cell->creatures.end());
+	*iter = cell->creatures.back();
+	cell->creatures.pop_back();
+
+	if (creature->getPlayer()) {
+		iter = std::find(cell->players.begin(), cell->players.end(), creature);
+		assert(iter != cell->players.end());
+		*iter = cell->players.back();
+		cell->players.pop_back();
+		--floorPlayerCount[pos.z];
+	}
+	--floorCreatureCount[pos.z];
+}
+
+void SpectatorGrid::moveCreature(Creature* creature, const Position& oldPos, const Position& newPos)
+{
+	if (getCellKey(oldPos) != getCellKey(newPos)) {
+		removeCreature(creature, oldPos);
+		addCreature(creature, newPos);
+	}
+}
+
+namespace {
+
+// milliseconds between two steps of the incremental clean
+constexpr uint32_t MAP_CLEAN_STEP_INTERVAL = 50;
+
+// removes the cleanable items of the tile, returns false if it has no items at all
+bool cleanTile(Tile* tile, uint64_t& removed)
+{
+	TileItemVector* items = tile->getItemList();
+	if (!items) {
+		return false;
+	}
+
+	std::vector<Item*> toRemove;
+	for (Item* item : *items) {
+		if (item->isCleanable()) {
+			toRemove.emplace_back(item);
+		}
+	}
+
+	for (Item* item : toRemove) {
+		g_game.internalRemoveItem(item, -1);
+	}
+
+	removed += toRemove.size();
+	return true;
+}
+
+} // namespace
+
 uint32_t Map::clean() const
 {
-	uint64_t start = OTSYS_TIME();
+	int64_t start = OTSYS_NANOTIME();
 	size_t tiles = 0;
 
 	if (g_game.getGameState() == GAME_STATE_NORMAL) {
@@ -1071,6 +1575,56 @@ uint32_t Map::clean() const
 	}
 
 	std::cout << "> CLEAN: Removed " << count << " item" << (count != 1 ? "s" : "") << " from " << tiles << " tile"
-	          << (tiles != 1 ? "s" : "") << " in " << (OTSYS_TIME() - start) / (1000.) << " seconds." << std::endl;
+	          << (tiles != 1 ? "s" : "") << " in " << (OTSYS_NANOTIME() - start) / 1e9 << " seconds." << std::endl;
 	return count;
 }
+
+bool Map::startIncrementalClean(uint32_t tilesPerTick)
+{
+	if (cleanProgress.running) {
+		return false;
+	}
+
+	const auto& tilesToClean = g_game.getTilesToClean();
+	cleanQueue.assign(tilesToClean.begin(), tilesToClean.end());
+	cleanTilesPerTick = std::max<uint32_t>(tilesPerTick, 1);
+
+	cleanProgress = {};
+	cleanProgress.tiles = cleanQueue.size();
+	cleanProgress.startTime = OTSYS_TIME();
+	cleanProgress.running = true;
+	cleanStep();
+	return true;
+}
+
+void Map::cleanStep()
+{
+	const size_t end = std::min(cleanProgress.tilesDone + cleanTilesPerTick, cleanQueue.size());
+	for (; cleanProgress.tilesDone < end; ++cleanProgress.tilesDone) {
+		Tile* tile = cleanQueue[cleanProgress.tilesDone];
+		// gone through by a full clean or emptied by the players since the clean started
+		if (!g_game.isTileToClean(tile)) {
+			continue;
+		}
+
+		cleanTile(tile, cleanProgress.items);
+		g_game.removeTileToClean(tile);
+	}
+	++cleanProgress.ticks;
+
+	if (cleanProgress.tilesDone < cleanQueue.size()) {
+		g_scheduler.addEvent(
+		    createSchedulerTask(MAP_CLEAN_STEP_INTERVAL, [this]() { cleanStep(); }, SCHEDULER_EVENT_SERVER));
+		return;
+	}
+
+	cleanQueue.clear();
+	cleanQueue.shrink_to_fit();
+	cleanProgress.endTime = OTSYS_TIME();
+	cleanProgress.running = false;
+
+	std::cout << fmt::format("> CLEAN: Removed {:d} items from {:d} tiles in {:.3f} seconds over {:d} ticks.",
+	                         cleanProgress.items, cleanProgress.tiles,
+	                         (cleanProgress.endTime - cleanProgress.startTime) / 1000., cleanProgress.ticks)
+	          << std::endl;
+}
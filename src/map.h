@@ -6,7 +6,9 @@
 
 #include "otpch.h"
 
+#include "flathashmap.h"
 #include "house.h"
+#include "mappager.h"
 #include "position.h"
 #include "spawn.h"
 #include "town.h"
@@ -15,7 +17,17 @@ class Creature;
 
 inline constexpr int32_t MAP_MAX_LAYERS = 16;
 
-struct FindPathParams;
+struct FindPathParams
+{
+	bool fullPathSearch = true;
+	bool clearSight = true;
+	bool allowDiagonal = true;
+	bool keepDistance = false;
+	int32_t maxSearchDist = 0;
+	int32_t minTargetDist = -1;
+	int32_t maxTargetDist = -1;
+};
+
 struct AStarNode
 {
 	AStarNode* parent;
@@ -28,14 +40,27 @@ inline constexpr int32_t MAX_NODES = 512;
 inline constexpr int32_t MAP_NORMALWALKCOST = 10;
 inline constexpr int32_t MAP_DIAGONALWALKCOST = 25;
 
+/**
+ * Node storage of one A* search. The open set is a binary heap ordered by f, ties going to the oldest node,
+ * which matches the order of the previous linear scan. Instances are meant to be reused through reset().
+ */
 class AStarNodes
 {
 public:
-	AStarNodes(uint32_t x, uint32_t y);
+	AStarNodes() = default;
+	AStarNodes(uint32_t x, uint32_t y) { reset(x, y); }
+
+	// non-copyable
+	AStarNodes(const AStarNodes&) = delete;
+	AStarNodes& operator=(const AStarNodes&) = delete;
+
+	void reset(uint32_t x, uint32_t y);
 
 	AStarNode* createOpenNode(AStarNode* parent, uint32_t x, uint32_t y, int_fast32_t f);
+	// removes and returns the cheapest open node, it stays counted as open until closeNode
 	AStarNode* getBestNode();
 	void closeNode(AStarNode* node);
+	// reopens a closed node or restores heap order after its f was lowered
 	void openNode(AStarNode* node);
 	int_fast32_t getClosedNodes() const;
 	AStarNode* getNodeByPosition(uint32_t x, uint32_t y);
@@ -44,15 +69,26 @@ public:
 	static int_fast32_t getTileWalkCost(const Creature& creature, const Tile* tile);
 
 private:
+	static constexpr uint16_t NOT_IN_HEAP = std::numeric_limits<uint16_t>::max();
+
+	bool isBetter(uint16_t a, uint16_t b) const
+	{
+		return nodes[a].f < nodes[b].f || (nodes[a].f == nodes[b].f && a < b);
+	}
+	void pushOpen(uint16_t index);
+	void siftUp(size_t position);
+	void siftDown(size_t position);
+
 	AStarNode nodes[MAX_NODES];
 	bool openNodes[MAX_NODES];
-	std::unordered_map<uint32_t, AStarNode*> nodeTable;
-	size_t curNode;
-	int_fast32_t closedNodes;
+	uint16_t openHeap[MAX_NODES];
+	uint16_t heapIndex[MAX_NODES];
+	size_t openHeapSize = 0;
+	FlatHashMap<uint32_t, uint16_t, std::numeric_limits<uint32_t>::max()> nodeTable{MAX_NODES * 4};
+	size_t curNode = 0;
+	int_fast32_t closedNodes = 0;
 };
 
-using SpectatorCache = std::map<Position, SpectatorVec>;
-
 inline constexpr int32_t FLOOR_BITS = 3;
 inline constexpr int32_t FLOOR_SIZE = (1 << FLOOR_BITS);
 inline constexpr int32_t FLOOR_MASK = (FLOOR_SIZE - 1);
@@ -69,7 +105,125 @@ struct Floor
 	Tile* tiles[FLOOR_SIZE][FLOOR_SIZE] = {};
 };
 
+inline constexpr int32_t MAP_CHUNK_BITS = 5;
+inline constexpr int32_t MAP_CHUNK_SIZE = (1 << MAP_CHUNK_BITS);
+inline constexpr int32_t MAP_CHUNK_MASK = (MAP_CHUNK_SIZE - 1);
+
+// tiles of one floor in a 32x32 area, stored row by row
+struct MapChunk
+{
+	MapChunk() = default;
+	~MapChunk();
+
+	// non-copyable
+	MapChunk(const MapChunk&) = delete;
+	MapChunk& operator=(const MapChunk&) = delete;
+
+	Tile* tiles[MAP_CHUNK_SIZE * MAP_CHUNK_SIZE] = {};
+};
+
+/**
+ * Alternative tile storage to the quadtree: a flat hash of dense chunks keyed by chunk coordinate and floor.
+ * A lookup is a single hash probe instead of a walk down sixteen levels of child pointers.
+ */
+class MapChunks
+{
+public:
+	Tile* getTile(uint16_t x, uint16_t y, uint8_t z) const
+	{
+		const std::unique_ptr<MapChunk>* chunk = chunks.find(getChunkKey(x, y, z));
+		return chunk ? (*chunk)->tiles[getTileIndex(x, y)] : nullptr;
+	}
+
+	const MapChunk* getChunk(uint32_t chunkKey) const
+	{
+		const std::unique_ptr<MapChunk>* chunk = chunks.find(chunkKey);
+		return chunk ? chunk->get() : nullptr;
+	}
+
+	MapChunk* getChunk(uint32_t chunkKey)
+	{
+		std::unique_ptr<MapChunk>* chunk = chunks.find(chunkKey);
+		return chunk ? chunk->get() : nullptr;
+	}
+
+	MapChunk& getOrCreateChunk(uint32_t chunkKey)
+	{
+		std::unique_ptr<MapChunk>& chunk = chunks[chunkKey];
+		if (!chunk) {
+			chunk = std::make_unique<MapChunk>();
+		}
+		return *chunk;
+	}
+
+	// deletes the chunk with its tiles
+	void eraseChunk(uint32_t chunkKey) { chunks.erase(chunkKey); }
+
+	template <typename F>
+	void forEachChunk(F&& f)
+	{
+		chunks.forEach([&f](uint32_t chunkKey, std::unique_ptr<MapChunk>& chunk) { f(chunkKey, *chunk); });
+	}
+
+	Tile*& getOrCreateTile(uint16_t x, uint16_t y, uint8_t z)
+	{
+		return getOrCreateChunk(getChunkKey(x, y, z)).tiles[getTileIndex(x, y)];
+	}
+
+	// 11 bits per chunk coordinate and 4 bits for the floor, offset by one since 0 marks an empty slot
+	static uint32_t getChunkKey(uint16_t x, uint16_t y, uint8_t z)
+	{
+		uint32_t cx = x >> MAP_CHUNK_BITS;
+		uint32_t cy = y >> MAP_CHUNK_BITS;
+		return ((cx << 15) | (cy << 4) | z) + 1;
+	}
+	static size_t getTileIndex(uint16_t x, uint16_t y)
+	{
+		return ((y & MAP_CHUNK_MASK) << MAP_CHUNK_BITS) | (x & MAP_CHUNK_MASK);
+	}
+
+private:
+	FlatHashMap<uint32_t, std::unique_ptr<MapChunk>> chunks{4096};
+};
+
+/**
+ * One TileWalkFlags byte per tile in the same chunk layout as MapChunks, kept in sync by the tiles themselves.
+ * Missing chunks read as TILEWALK_NONE, which is also what an empty or absent tile reports.
+ */
+class TileWalkMap
+{
+	using Chunk = std::array<uint8_t, MAP_CHUNK_SIZE * MAP_CHUNK_SIZE>;
+
+public:
+	uint8_t get(uint16_t x, uint16_t y, uint8_t z) const
+	{
+		const std::unique_ptr<Chunk>* chunk = chunks.find(MapChunks::getChunkKey(x, y, z));
+		return chunk ? (**chunk)[MapChunks::getTileIndex(x, y)] : static_cast<uint8_t>(TILEWALK_NONE);
+	}
+
+	// raw flags of a whole chunk indexed by MapChunks::getTileIndex, nullptr if no tile was ever stored in it
+	const uint8_t* getChunk(uint32_t chunkKey) const
+	{
+		const std::unique_ptr<Chunk>* chunk = chunks.find(chunkKey);
+		return chunk ? (*chunk)->data() : nullptr;
+	}
+
+	// returns the previous flags
+	uint8_t set(uint16_t x, uint16_t y, uint8_t z, uint8_t walkFlags)
+	{
+		std::unique_ptr<Chunk>& chunk = chunks[MapChunks::getChunkKey(x, y, z)];
+		if (!chunk) {
+			chunk = std::make_unique<Chunk>();
+		}
+		return std::exchange((*chunk)[MapChunks::getTileIndex(x, y)], walkFlags);
+	}
+
+private:
+	FlatHashMap<uint32_t, std::unique_ptr<Chunk>> chunks{4096};
+};
+
 class FrozenPathingConditionCall;
+class PathSnapshot;
 class QTreeLeafNode;
 
 class QTreeNode
@@ -129,26 +283,174 @@ public:
 	Floor* createFloor(uint32_t z);
 	Floor* getFloor(uint8_t z) const { return array[z]; }
 
-	void addCreature(Creature* c);
-	void removeCreature(Creature* c);
-
 private:
 	static bool newLeaf;
 	QTreeLeafNode* leafS = nullptr;
 	QTreeLeafNode* leafE = nullptr;
 	Floor* array[MAP_MAX_LAYERS] = {};
-	CreatureVector creature_list;
-	CreatureVector player_list;
 
 	friend class Map;
 	friend class QTreeNode;
 };
 
+inline constexpr int32_t SPECTATOR_GRID_BITS = 3;
+inline constexpr int32_t SPECTATOR_GRID_CELL_SIZE = (1 << SPECTATOR_GRID_BITS);
+
+/**
+ * Uniform grid of creature buckets, one per 8x8 cell of every floor.
+ * Players are kept in separate buckets so player-only queries skip monsters and npcs entirely.
+ */
+class SpectatorGrid
+{
+public:
+	void addCreature(Creature* creature, const Position& pos);
+	void removeCreature(Creature* creature, const Position& pos);
+	void moveCreature(Creature* creature, const Position& oldPos, const Position& newPos);
+
+	bool isFloorEmpty(uint8_t z) const { return floorCreatureCount[z] == 0; }
+	bool hasPlayers(uint8_t z) const { return floorPlayerCount[z] != 0; }
+
+	// calls f for every bucket overlapping [x1, x2] x [y1, y2] on floor z
+	template <typename F>
+	void forEachBucket(uint16_t x1, uint16_t y1, uint16_t x2, uint16_t y2, uint8_t z, bool onlyPlayers, F&& f) const
+	{
+		for (uint32_t cy = y1 >> SPECTATOR_GRID_BITS, ey = y2 >> SPECTATOR_GRID_BITS; cy <= ey; ++cy) {
+			for (uint32_t cx = x1 >> SPECTATOR_GRID_BITS, ex = x2 >> SPECTATOR_GRID_BITS; cx <= ex; ++cx) {
+				if (const Cell* cell = cells.find(makeCellKey(cx, cy, z))) {
+					f(onlyPlayers ? cell->players : cell->creatures);
+				}
+			}
+		}
+	}
+
+private:
+	struct Cell
+	{
+		CreatureVector creatures;
+		CreatureVector players;
+	};
+
+	// 13 bits per cell coordinate and 4 bits for the floor, offset by one since 0 marks an empty slot
+	static uint32_t makeCellKey(uint32_t cx, uint32_t cy, uint8_t z) { return ((cx << 17) | (cy << 4) | z) + 1; }
+	static uint32_t getCellKey(const Position& pos)
+	{
+		return makeCellKey(pos.x >> SPECTATOR_GRID_BITS, pos.y >> SPECTATOR_GRID_BITS, pos.z);
+	}
+
+	FlatHashMap<uint32_t, Cell> cells{1024};
+	std::array<uint32_t, MAP_MAX_LAYERS> floorCreatureCount = {};
+	std::array<uint32_t, MAP_MAX_LAYERS> floorPlayerCount = {};
+};
+
+inline constexpr int32_t SPECTATOR_CACHE_REGION_BITS = 5;
+inline constexpr size_t SPECTATOR_CACHE_ARENA_SIZE = 1 << 16;
+inline constexpr size_t SPECTATOR_CACHE_MAX_ENTRIES = 1 << 13;
+
+/**
+ * Cache of full multifloor viewport spectator queries, keyed by center position.
+ * Entries are invalidated lazily by per-region generation counters: a creature change only bumps the regions whose
+ * cached viewports can see it. Cached lists are bump-allocated from one arena that is recycled once it fills up.
+ */
+class SpectatorCache
+{
+public:
+	SpectatorCache() { arena.reserve(SPECTATOR_CACHE_ARENA_SIZE); }
+
+	std::optional<std::span<Creature* const>> find(const Position& centerPos) const;
+	void store(const Position& centerPos, std::span<Creature* const> spectators);
+
+	// drops every entry whose viewport can contain pos
+	void invalidate(const Position& pos);
+
+private:
+	struct Entry
+	{
+		uint32_t generation = 0;
+		uint32_t offset = 0;
+		uint32_t size = 0;
+	};
+
+	static uint32_t getRegionKey(uint32_t rx, uint32_t ry) { return ((rx << 16) | ry) + 1; }
+	uint32_t getGeneration(const Position& pos) const;
+
+	FlatHashMap<PositionKey, Entry> entries{1024};
+	FlatHashMap<uint32_t, uint32_t> generations{1024};
+	std::vector<Creature*> arena;
+};
+
+inline constexpr int32_t SIGHT_CACHE_MAX_DISTANCE = 15;
+inline constexpr int32_t SIGHT_CACHE_REGION_BITS = 5;
+inline constexpr size_t SIGHT_CACHE_SIZE = 1 << 14;
+
+/**
+ * Direct-mapped cache of single floor sight lines, keyed by origin and offset to the target.
+ * A tile changing its projectile blocking bumps the generation of every region an origin of a line through it can be
+ * in, so stale entries are simply never matched again.
+ */
+class SightLineCache
+{
+public:
+	// nullopt if the line is too long to be cached or was not traced since the last change around it
+	std::optional<bool> find(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z) const;
+	void store(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z, bool sightClear);
+
+	void invalidate(const Position& pos);
+
+	// while read only, lookups may run concurrently and new lines are traced without being stored
+	void setReadOnly(bool readOnly) { this->readOnly = readOnly; }
+
+private:
+	struct Entry
+	{
+		uint64_t key = 0;
+		uint32_t generation = 0;
+		bool sightClear = false;
+	};
+
+	// 0 when the line is too long
+	static uint64_t getEntryKey(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1, uint8_t z)
+	{
+		int32_t dx = x1 - x0;
+		int32_t dy = y1 - y0;
+		if (std::abs(dx) > SIGHT_CACHE_MAX_DISTANCE || std::abs(dy) > SIGHT_CACHE_MAX_DISTANCE) {
+			return 0;
+		}
+
+		return ((static_cast<uint64_t>(x0) << 34) | (static_cast<uint64_t>(y0) << 18) |
+		        (static_cast<uint64_t>(z) << 14) | ((dx + SIGHT_CACHE_MAX_DISTANCE) << 7) |
+		        (dy + SIGHT_CACHE_MAX_DISTANCE)) +
+		       1;
+	}
+	static size_t getSlot(uint64_t key)
+	{
+		return (key * 0x9E3779B97F4A7C15ULL) >> (64 - std::countr_zero(SIGHT_CACHE_SIZE));
+	}
+	static uint32_t getRegionKey(uint32_t rx, uint32_t ry, uint8_t z) { return ((rx << 16) | (ry << 5) | z) + 1; }
+	uint32_t getGeneration(uint16_t x, uint16_t y, uint8_t z) const;
+
+	std::vector<Entry> entries = std::vector<Entry>(SIGHT_CACHE_SIZE);
+	FlatHashMap<uint32_t, uint32_t> generations{1024};
+	bool readOnly = false;
+};
+
 /**
  * Map class.
  * Holds all the actual map-data
  */
 
+// Progress of the incremental map clean, kept after it finished until the next one starts.
+struct MapCleanProgress
+{
+	// tiles queued when the clean started and how many of them were gone through
+	size_t tiles = 0;
+	size_t tilesDone = 0;
+	uint64_t items = 0;
+	uint32_t ticks = 0;
+	int64_t startTime = 0;
+	int64_t endTime = 0;
+	bool running = false;
+};
+
 class Map
 {
 public:
@@ -160,14 +462,28 @@ public:
 	uint32_t clean() const;
 
 	/**
-	 * Load a map.
+	 * Cleans the tiles to clean a few at a time, at most tilesPerTick of them per scheduler tick, while the game keeps
+	 * running. Tiles that gain cleanable items meanwhile are left for the next clean.
+	 * \returns false if a clean is running already
+	 */
+	bool startIncrementalClean(uint32_t tilesPerTick);
+	const MapCleanProgress& getCleanProgress() const { return cleanProgress; }
+
+	// keeps the idle areas of a chunked map serialized, see MapPager
+	void startPaging(uint32_t idleTime) { pager.start(*this, idleTime); }
+
+	/**
+	 * Load a map, the saved house owners and items only with loadHouseState.
 	 * \returns true if the map was loaded successfully
 	 */
-	bool loadMap(const std::string& identifier, bool loadHouses);
+	bool loadMap(const std::string& identifier, bool loadHouses, bool loadHouseState = true);
+
+	// the saved house owners and items, for a map loaded without them
+	void loadHouseState();
 
 	/**
-	 * Save a map.
-	 * \returns true if the map was saved successfully
+	 * Save a map, the houses are captured now and written by the database tasks.
+	 * \returns true if the save was queued
 	 */
 	static bool save();
 
@@ -178,6 +494,12 @@ public:
 	Tile* getTile(uint16_t x, uint16_t y, uint8_t z) const;
 	Tile* getTile(const Position& pos) const { return getTile(pos.x, pos.y, pos.z); }
 
+	/**
+	 * Get the tiles of a rectangle of one floor, each chunk of it is looked up once instead of every tile.
+	 * \param tiles receives width * height tiles row by row, tiles[dy * width + dx], nullptr where there is none
+	 */
+	void getTiles(uint16_t x, uint16_t y, uint8_t z, uint16_t width, uint16_t height, Tile** tiles) const;
+
 	/**
 	 * Set a single tile.
 	 */
@@ -190,6 +512,18 @@ public:
 	void removeTile(uint16_t x, uint16_t y, uint8_t z);
 	void removeTile(const Position& pos) { removeTile(pos.x, pos.y, pos.z); }
 
+	/**
+	 * Walk flags (TileWalkFlags) of a single tile, without touching the tile.
+	 */
+	uint8_t getTileWalkFlags(uint16_t x, uint16_t y, uint8_t z) const { return tileWalkMap.get(x, y, z); }
+	void setTileWalkFlags(const Position& pos, uint8_t walkFlags)
+	{
+		uint8_t oldFlags = tileWalkMap.set(pos.x, pos.y, pos.z, walkFlags);
+		if ((oldFlags ^ walkFlags) & TILEWALK_BLOCKPROJECTILE) {
+			sightLineCache.invalidate(pos);
+		}
+	}
+
 	/**
 	 * Place a creature on the map
 	 * \param centerPos The position to place the creature
@@ -202,13 +536,36 @@ public:
 	                   bool forceLogin = false);
 
 	void moveCreature(Creature& creature, Tile& newTile, bool forceTeleport = false);
+	void removeCreatureFromGrid(Creature* creature, const Position& pos) { spectatorGrid.removeCreature(creature, pos); }
+	const SpectatorGrid& getSpectatorGrid() const { return spectatorGrid; }
 
 	void getSpectators(SpectatorVec& spectators, const Position& centerPos, bool multifloor = false,
 	                   bool onlyPlayers = false, int32_t minRangeX = 0, int32_t maxRangeX = 0, int32_t minRangeY = 0,
 	                   int32_t maxRangeY = 0);
 
-	void clearSpectatorCache();
-	void clearPlayersSpectatorCache();
+	/**
+	 * Gets the multifloor spectators of a creature moving from oldPos to newPos. They are ordered as the ones having
+	 * both positions in view, then the ones only having the old one, then the ones only having the new one.
+	 * \returns where the second and the third group start
+	 */
+	std::pair<size_t, size_t> getMoveSpectators(SpectatorVec& spectators, const Position& oldPos,
+	                                            const Position& newPos);
+
+	/**
+	 * Gets the multifloor spectators of a group of positions with one query per floor around the area they span.
+	 * The result can hold creatures in the corners of that area seeing none of them, see isInSpectatorRange.
+	 */
+	void getAreaSpectators(SpectatorVec& spectators, const std::vector<Position>& positions);
+
+	// whether a multifloor spectator query around centerPos with the default viewport finds a creature at pos
+	static bool isInSpectatorRange(const Position& centerPos, const Position& pos);
+
+	// whether a player stands within range tiles, on the same floor or up to two above or below
+	bool hasPlayerInRange(const Position& pos, int32_t range) const;
+
+	void clearSpectatorCache(const Position& pos) { spectatorCache.invalidate(pos); }
+	void clearPlayersSpectatorCache(const Position& pos) { playersSpectatorCache.invalidate(pos); }
+	void setSightCacheReadOnly(bool readOnly) { sightLineCache.setReadOnly(readOnly); }
 
 	/**
 	 * Checks if you can throw an object to that position
@@ -258,10 +615,25 @@ public:
 	Houses houses;
 
 private:
+	void cleanStep();
+
 	SpectatorCache spectatorCache;
 	SpectatorCache playersSpectatorCache;
+	mutable SightLineCache sightLineCache;
 
+	SpectatorGrid spectatorGrid;
 	QTreeNode root;
+	MapChunks chunks;
+	TileWalkMap tileWalkMap;
+	MapPager pager;
+
+	std::vector<Tile*> cleanQueue;
+	MapCleanProgress cleanProgress;
+	uint32_t cleanTilesPerTick = 0;
+
+	// tile backend, chosen when the first map is loaded
+	bool chunkedStorage = false;
+	bool hasTiles = false;
 
 	std::filesystem::path spawnfile;
 	std::filesystem::path housefile;
@@ -269,6 +641,9 @@ private:
 	uint32_t width = 0;
 	uint32_t height = 0;
 
+	// moves newTile into the slot, merging its items into the tile already there
+	static void storeTile(Tile*& tile, Tile* newTile);
+
 	// Actually scans the map for spectators
 	void getSpectatorsInternal(SpectatorVec& spectators, const Position& centerPos, int32_t minRangeX,
 	                           int32_t maxRangeX, int32_t minRangeY, int32_t maxRangeY, int32_t minRangeZ,
@@ -276,6 +651,50 @@ private:
 
 	friend class Game;
 	friend class IOMap;
+	friend class MapPager;
+};
+
+/**
+ * Walk costs and sight blockers around a creature, captured on the game thread so the path search itself can run
+ * on a pathfinding worker without reading live map state.
+ */
+class PathSnapshot
+{
+public:
+	// false if the search has no distance limit, it would need the whole map
+	bool capture(const Map& map, const Creature& creature, const Position& targetPos, const FindPathParams& fpp);
+
+	bool getPathMatching(std::vector<Direction>& dirList) const;
+	// same answer as Map::isSightClear with sameFloor set, for positions inside the captured area
+	bool isSightClear(const Position& fromPos, const Position& toPos) const;
+
+	const Position& getStartPosition() const { return startPos; }
+
+private:
+	struct Cell
+	{
+		int16_t walkCost = -1;
+		bool blockProjectile = false;
+	};
+
+	const Cell* getCell(int32_t x, int32_t y) const
+	{
+		x -= minX;
+		y -= minY;
+		if (x < 0 || y < 0 || x >= width || y >= height) {
+			return nullptr;
+		}
+		return &cells[y * width + x];
+	}
+
+	Position startPos;
+	Position targetPos;
+	FindPathParams fpp;
+	int32_t minX = 0;
+	int32_t minY = 0;
+	int32_t width = 0;
+	int32_t height = 0;
+	std::vector<Cell> cells;
 };
 
 #endif // FS_MAP_H
@@ -0,0 +1,353 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "mappager.h"
+
+#include "container.h"
+#include "game.h"
+#include "housetile.h"
+#include "map.h"
+#include "scheduler.h"
+
+extern Game g_game;
+
+namespace {
+
+// milliseconds between two checks for idle areas
+constexpr uint32_t MAP_PAGE_SWEEP_INTERVAL = 10000;
+
+// tile flags that do not follow from the items of the tile
+constexpr std::array<uint32_t, 5> PAGED_TILE_FLAGS = {TILESTATE_PROTECTIONZONE, TILESTATE_NOPVPZONE, TILESTATE_NOLOGOUT,
+                                                      TILESTATE_PVPZONE, TILESTATE_MOVEEVENT};
+
+Position getChunkPosition(uint32_t chunkKey)
+{
+	--chunkKey;
+	return Position(static_cast<uint16_t>((chunkKey >> 15) << MAP_CHUNK_BITS),
+	                static_cast<uint16_t>(((chunkKey >> 4) & 0x7FF) << MAP_CHUNK_BITS), chunkKey & 0xF);
+}
+
+// the same layout as IOMapSerialize::saveItem, false for an item that can not be restored from it
+bool serializeItem(PropWriteStream& stream, const Item* item)
+{
+	if (item->hasAttribute(ITEM_ATTRIBUTE_UNIQUEID)) {
+		return false;
+	}
+
+	stream.write<uint16_t>(item->getID());
+	item->serializeAttr(stream);
+
+	if (const Container* container = item->getContainer()) {
+		stream.write<uint8_t>(ATTR_CONTAINER_ITEMS);
+		stream.write<uint32_t>(container->size());
+		for (auto it = container->getReversedItems(), end = container->getReversedEnd(); it != end; ++it) {
+			if (!serializeItem(stream, *it)) {
+				return false;
+			}
+		}
+	}
+
+	stream.write<uint8_t>(0x00); // attr end
+	return true;
+}
+
+bool isDecaying(const Item* item)
+{
+	if (item->getDecaying() != DECAYING_FALSE) {
+		return true;
+	}
+
+	if (const Container* container = item->getContainer()) {
+		for (const Item* containerItem : container->getItemList()) {
+			if (isDecaying(containerItem)) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+void MapPager::start(Map& map, uint32_t idleTime)
+{
+	if (!map.chunkedStorage) {
+		std::cout << "[Warning - MapPager::start] mapPagedStorage needs useChunkedMapStorage, paging is disabled."
+		          << std::endl;
+		return;
+	}
+
+	int64_t start = OTSYS_NANOTIME();
+	enabled = true;
+	idleSweeps = std::max<uint32_t>((idleTime * 1000 + MAP_PAGE_SWEEP_INTERVAL - 1) / MAP_PAGE_SWEEP_INTERVAL, 1);
+
+	std::vector<uint32_t> chunkKeys;
+	map.chunks.forEachChunk([&chunkKeys](uint32_t chunkKey, MapChunk&) { chunkKeys.push_back(chunkKey); });
+
+	size_t pageBytes = 0;
+	for (uint32_t chunkKey : chunkKeys) {
+		std::string page;
+		PageState state = serialize(map, chunkKey, page);
+		if (state == PAGE_PINNED) {
+			continue;
+		}
+
+		pageBytes += page.size();
+		pages[chunkKey] = std::move(page);
+		if (state == PAGE_IDLE) {
+			pageOut(map, chunkKey);
+		} else {
+			lastUsed[chunkKey] = sweepCount;
+		}
+	}
+
+	std::cout << fmt::format("> Map paging: {:d} of {:d} areas paged out into {:d} KB, {:d} kept in memory, in "
+	                         "{:.3f}s.",
+	                         pageOuts, chunkKeys.size(), pageBytes / 1024, chunkKeys.size() - pageOuts,
+	                         (OTSYS_NANOTIME() - start) / 1e9)
+	          << std::endl;
+
+	g_scheduler.addEvent(
+	    createSchedulerTask(MAP_PAGE_SWEEP_INTERVAL, [this, &map]() { sweep(map); }, SCHEDULER_EVENT_SERVER));
+}
+
+bool MapPager::pageIn(Map& map, uint32_t chunkKey)
+{
+	const std::string* page = pages.find(chunkKey);
+	if (!page || map.chunks.getChunk(chunkKey)) {
+		return false;
+	}
+
+	if (!unserialize(map, chunkKey, *page)) {
+		std::cout << "[Error - MapPager::pageIn] Could not restore the area at " << getChunkPosition(chunkKey)
+		          << ", it stays in memory as far as it was read." << std::endl;
+		pages.erase(chunkKey);
+		return map.chunks.getChunk(chunkKey) != nullptr;
+	}
+
+	// the page is rebuilt from the tiles, so the next comparison is not thrown off by how they were read
+	std::string restored;
+	if (serialize(map, chunkKey, restored) == PAGE_PINNED) {
+		pages.erase(chunkKey);
+	} else {
+		pages[chunkKey] = std::move(restored);
+		lastUsed[chunkKey] = sweepCount;
+	}
+
+	++pageIns;
+	return true;
+}
+
+MapPager::PageState MapPager::serialize(Map& map, uint32_t chunkKey, std::string& page)
+{
+	MapChunk* chunk = map.chunks.getChunk(chunkKey);
+	if (!chunk) {
+		return PAGE_PINNED;
+	}
+
+	PageState state = PAGE_IDLE;
+	thread_local PropWriteStream stream;
+	stream.clear();
+	for (uint16_t index = 0; index < MAP_CHUNK_SIZE * MAP_CHUNK_SIZE; ++index) {
+		Tile* tile = chunk->tiles[index];
+		if (!tile) {
+			continue;
+		}
+
+		if (dynamic_cast<HouseTile*>(tile)) {
+			return PAGE_PINNED;
+		}
+
+		if (tile->getCreatureCount() != 0 || g_game.isTileToClean(tile)) {
+			state = PAGE_BUSY;
+		}
+
+		uint32_t flags = 0;
+		for (uint32_t flag : PAGED_TILE_FLAGS) {
+			if (tile->hasFlag(flag)) {
+				flags |= flag;
+			}
+		}
+
+		// the items go in the order Tile::internalAddThing puts them back in, the ground first
+		std::vector<const Item*> items;
+		if (const Item* ground = tile->getGround()) {
+			items.push_back(ground);
+		}
+		if (const TileItemVector* tileItems = tile->getItemList()) {
+			items.insert(items.end(), tileItems->getBeginTopItem(), tileItems->getEndTopItem());
+			items.insert(items.end(), std::make_reverse_iterator(tileItems->getEndDownItem()),
+			             std::make_reverse_iterator(tileItems->getBeginDownItem()));
+		}
+
+		stream.write<uint16_t>(index);
+		stream.write<uint8_t>(dynamic_cast<DynamicTile*>(tile) != nullptr);
+		stream.write<uint32_t>(flags);
+		stream.write<uint16_t>(items.size());
+		for (const Item* item : items) {
+			if (isDecaying(item)) {
+				state = PAGE_BUSY;
+			}
+
+			stream.write<uint8_t>(item->isLoadedFromMap());
+			if (!serializeItem(stream, item)) {
+				return PAGE_PINNED;
+			}
+		}
+	}
+
+	page = stream.getStream();
+	return state;
+}
+
+bool MapPager::unserialize(Map& map, uint32_t chunkKey, const std::string& page)
+{
+	const Position base = getChunkPosition(chunkKey);
+	MapChunk& chunk = map.chunks.getOrCreateChunk(chunkKey);
+
+	PropStream stream;
+	stream.init(page.data(), page.size());
+	while (stream.size() != 0) {
+		uint16_t index, itemCount;
+		uint8_t dynamic;
+		uint32_t flags;
+		if (!stream.read<uint16_t>(index) || index >= MAP_CHUNK_SIZE * MAP_CHUNK_SIZE ||
+		    !stream.read<uint8_t>(dynamic) || !stream.read<uint32_t>(flags) || !stream.read<uint16_t>(itemCount)) {
+			return false;
+		}
+
+		const uint16_t x = base.x + (index & MAP_CHUNK_MASK);
+		const uint16_t y = base.y + (index >> MAP_CHUNK_BITS);
+		Tile* tile;
+		if (dynamic) {
+			tile = new DynamicTile(x, y, base.z);
+		} else {
+			tile = new StaticTile(x, y, base.z);
+		}
+		chunk.tiles[index] = tile;
+
+		while (itemCount--) {
+			uint8_t loadedFromMap;
+			if (!stream.read<uint8_t>(loadedFromMap)) {
+				return false;
+			}
+
+			Item* item = readItem(stream);
+			if (!item) {
+				return false;
+			}
+
+			tile->internalAddThing(item);
+			item->startDecaying();
+			item->setLoadedFromMap(loadedFromMap != 0);
+		}
+
+		tile->setFlag(static_cast<tileflags_t>(flags));
+		tile->updateWalkFlags();
+	}
+	return true;
+}
+
+Item* MapPager::readItem(PropStream& stream)
+{
+	uint16_t id;
+	if (!stream.read<uint16_t>(id)) {
+		return nullptr;
+	}
+
+	Item* item = Item::CreateItem(id);
+	if (!item) {
+		return nullptr;
+	}
+
+	if (!item->unserializeAttr(stream)) {
+		delete item;
+		return nullptr;
+	}
+
+	// the container items are read the way IOMapSerialize::loadContainer does
+	if (Container* container = item->getContainer()) {
+		for (; container->serializationCount > 0; --container->serializationCount) {
+			Item* containerItem = readItem(stream);
+			if (!containerItem) {
+				delete item;
+				return nullptr;
+			}
+			container->internalAddThing(containerItem);
+		}
+
+		uint8_t endAttr;
+		if (!stream.read<uint8_t>(endAttr) || endAttr != 0) {
+			delete item;
+			return nullptr;
+		}
+	}
+	return item;
+}
+
+void MapPager::sweep(Map& map)
+{
+	++sweepCount;
+
+	// the areas a player can see, on every floor
+	for (const auto& it : g_game.getPlayers()) {
+		const Position& position = it.second->getPosition();
+		const int32_t minX = std::max<int32_t>(position.x - Map::maxViewportX - 1, 0);
+		const int32_t minY = std::max<int32_t>(position.y - Map::maxViewportY - 1, 0);
+		const int32_t maxX = std::min<int32_t>(position.x + Map::maxViewportX + 1, 0xFFFF);
+		const int32_t maxY = std::min<int32_t>(position.y + Map::maxViewportY + 1, 0xFFFF);
+		for (int32_t x = minX >> MAP_CHUNK_BITS; x <= maxX >> MAP_CHUNK_BITS; ++x) {
+			for (int32_t y = minY >> MAP_CHUNK_BITS; y <= maxY >> MAP_CHUNK_BITS; ++y) {
+				for (uint8_t z = 0; z < MAP_MAX_LAYERS; ++z) {
+					uint32_t chunkKey = MapChunks::getChunkKey(x << MAP_CHUNK_BITS, y << MAP_CHUNK_BITS, z);
+					if (uint32_t* used = lastUsed.find(chunkKey)) {
+						*used = sweepCount;
+					}
+				}
+			}
+		}
+	}
+
+	std::vector<uint32_t> idle;
+	lastUsed.forEach([this, &idle](uint32_t chunkKey, uint32_t used) {
+		if (sweepCount - used >= idleSweeps) {
+			idle.push_back(chunkKey);
+		}
+	});
+
+	const uint64_t pagedOut = pageOuts;
+	for (uint32_t chunkKey : idle) {
+		std::string page;
+		PageState state = serialize(map, chunkKey, page);
+		if (state == PAGE_BUSY) {
+			continue;
+		}
+
+		if (state == PAGE_PINNED || page != *pages.find(chunkKey)) {
+			// changed since it was paged in, it is kept as it is now
+			pages.erase(chunkKey);
+			lastUsed.erase(chunkKey);
+			continue;
+		}
+		pageOut(map, chunkKey);
+	}
+
+	if (pageOuts != pagedOut) {
+		std::cout << fmt::format("> Map paging: {:d} idle areas paged out, {:d} areas paged in since startup.",
+		                         pageOuts - pagedOut, pageIns)
+		          << std::endl;
+	}
+
+	g_scheduler.addEvent(
+	    createSchedulerTask(MAP_PAGE_SWEEP_INTERVAL, [this, &map]() { sweep(map); }, SCHEDULER_EVENT_SERVER));
+}
+
+void MapPager::pageOut(Map& map, uint32_t chunkKey)
+{
+	// the walk flags stay, so paths are still searched through the area without restoring it
+	map.chunks.eraseChunk(chunkKey);
+	lastUsed.erase(chunkKey);
+	++pageOuts;
+}
@@ -0,0 +1,58 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_MAPPAGER_H
+#define FS_MAPPAGER_H
+
+#include "flathashmap.h"
+
+class Item;
+class Map;
+class PropStream;
+
+/**
+ * Keeps the idle areas of a chunked map serialized instead of as tiles. An area is one MapChunk: every area that has
+ * no house tile and no unique item is paged out when paging starts and again once no player came near it for the
+ * idle time, as long as nothing stands on it and its tiles are still exactly as they were paged in. The first lookup
+ * of a paged out area restores it. An area that changed stays in memory from then on. Dispatcher thread only.
+ */
+class MapPager
+{
+public:
+	bool isEnabled() const { return enabled; }
+
+	// pages out every idle area and checks the map again every few seconds
+	void start(Map& map, uint32_t idleTime);
+	// restores the tiles of a paged out area, false if it is not paged out
+	bool pageIn(Map& map, uint32_t chunkKey);
+
+private:
+	enum PageState : uint8_t
+	{
+		PAGE_IDLE,
+		// a creature, a decaying item or a cleanable item keeps the area in memory for now
+		PAGE_BUSY,
+		// an area with a house tile or a unique item is never paged out
+		PAGE_PINNED,
+	};
+
+	static PageState serialize(Map& map, uint32_t chunkKey, std::string& page);
+	static Item* readItem(PropStream& stream);
+	static bool unserialize(Map& map, uint32_t chunkKey, const std::string& page);
+
+	void sweep(Map& map);
+	void pageOut(Map& map, uint32_t chunkKey);
+
+	// serialized tiles of every area that may be paged out, the ones in memory still have to match theirs
+	FlatHashMap<uint32_t, std::string> pages{1024};
+	// areas in memory that have a page, with the sweep a player was last near them
+	FlatHashMap<uint32_t, uint32_t> lastUsed{1024};
+
+	uint64_t pageIns = 0;
+	uint64_t pageOuts = 0;
+	uint32_t sweepCount = 0;
+	uint32_t idleSweeps = 1;
+	bool enabled = false;
+};
+
+#endif // FS_MAPPAGER_H
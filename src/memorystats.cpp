@@ -0,0 +1,196 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "memorystats.h"
+
+#include "metrics.h"
+
+#if defined(TFS_ALLOCATOR_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(TFS_ALLOCATOR_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <fstream>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr std::array<std::string_view, MEMORY_SUBSYSTEM_LAST> subsystemNames = {
+    "tiles", "items", "containers", "creatures", "conditions", "network_buffers", "database_results", "lua"};
+
+struct SubsystemGauges
+{
+	std::deque<MetricGauge> objects;
+	std::deque<MetricGauge> bytes;
+};
+
+SubsystemGauges* createGauges()
+{
+	auto gauges = new SubsystemGauges;
+	for (std::string_view name : subsystemNames) {
+		gauges->objects.emplace_back("tfs_memory_objects", "Live objects by the subsystem that allocated them.",
+		                             fmt::format("subsystem=\"{:s}\"", name));
+	}
+	for (std::string_view name : subsystemNames) {
+		gauges->bytes.emplace_back("tfs_memory_bytes", "Live bytes by the subsystem that allocated them.",
+		                           fmt::format("subsystem=\"{:s}\"", name));
+	}
+	return gauges;
+}
+
+SubsystemGauges& getGauges()
+{
+	// never destroyed, items and tiles are still freed by global destructors at exit
+	static SubsystemGauges* gauges = createGauges();
+	return *gauges;
+}
+
+// registers the gauges at startup like the other metrics
+const SubsystemGauges& registeredGauges = getGauges();
+
+// the allocator is asked when the metrics are scraped
+class AllocatorMetric final : public Metric
+{
+public:
+	AllocatorMetric(std::string_view name, std::string_view help, uint64_t MemoryStats::AllocatorUsage::*field) :
+	    Metric(METRIC_GAUGE, name, help), field{field}
+	{}
+
+	void serialize(std::string& out) const override
+	{
+		const auto usage = MemoryStats::getAllocatorUsage();
+		writeSample(out, {}, fmt::format("allocator=\"{:s}\"", usage.allocator), std::to_string(usage.*field));
+	}
+
+private:
+	uint64_t MemoryStats::AllocatorUsage::*field;
+};
+
+AllocatorMetric allocatorAllocated{"tfs_allocator_allocated_bytes", "Bytes the allocator handed out.",
+                                   &MemoryStats::AllocatorUsage::allocated};
+AllocatorMetric allocatorHeld{"tfs_allocator_held_bytes", "Bytes the allocator holds in pages from the system.",
+                              &MemoryStats::AllocatorUsage::held};
+AllocatorMetric allocatorResident{"tfs_allocator_resident_bytes", "Resident set size of the process.",
+                                  &MemoryStats::AllocatorUsage::resident};
+MetricCounter allocatorPurged{"tfs_allocator_purged_bytes_total", "Bytes allocator purges returned to the system."};
+
+uint64_t getResidentBytes()
+{
+#ifdef __linux__
+	std::ifstream statm("/proc/self/statm");
+	uint64_t size, resident;
+	if (statm >> size >> resident) {
+		return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	}
+#endif
+	return 0;
+}
+
+#ifdef TFS_ALLOCATOR_JEMALLOC
+uint64_t getJemallocStat(const char* name)
+{
+	size_t value = 0;
+	size_t length = sizeof(value);
+	mallctl(name, &value, &length, nullptr, 0);
+	return value;
+}
+#endif
+
+} // namespace
+
+void MemoryStats::allocated(MemorySubsystem subsystem, size_t bytes)
+{
+	SubsystemGauges& gauges = getGauges();
+	gauges.objects[subsystem].add();
+	gauges.bytes[subsystem].add(bytes);
+}
+
+void MemoryStats::freed(MemorySubsystem subsystem, size_t bytes)
+{
+	SubsystemGauges& gauges = getGauges();
+	gauges.objects[subsystem].sub();
+	gauges.bytes[subsystem].sub(bytes);
+}
+
+void MemoryStats::resized(MemorySubsystem subsystem, size_t oldBytes, size_t newBytes)
+{
+	getGauges().bytes[subsystem].add(static_cast<int64_t>(newBytes) - static_cast<int64_t>(oldBytes));
+}
+
+std::vector<MemoryStats::Usage> MemoryStats::getUsage()
+{
+	const SubsystemGauges& gauges = getGauges();
+
+	std::vector<Usage> usage;
+	usage.reserve(MEMORY_SUBSYSTEM_LAST);
+	for (size_t subsystem = 0; subsystem < MEMORY_SUBSYSTEM_LAST; ++subsystem) {
+		usage.push_back({subsystemNames[subsystem], gauges.objects[subsystem].value(), gauges.bytes[subsystem].value()});
+	}
+	return usage;
+}
+
+MemoryStats::AllocatorUsage MemoryStats::getAllocatorUsage()
+{
+	AllocatorUsage usage{"system", 0, 0, getResidentBytes()};
+#if defined(TFS_ALLOCATOR_MIMALLOC)
+	usage.allocator = "mimalloc";
+	size_t commit = 0;
+	mi_process_info(nullptr, nullptr, nullptr, nullptr, nullptr, &commit, nullptr, nullptr);
+	usage.held = commit;
+#elif defined(TFS_ALLOCATOR_JEMALLOC)
+	usage.allocator = "jemalloc";
+	// the statistics are a snapshot refreshed by advancing the epoch
+	uint64_t epoch = 1;
+	size_t length = sizeof(epoch);
+	mallctl("epoch", &epoch, &length, &epoch, length);
+	usage.allocated = getJemallocStat("stats.allocated");
+	usage.held = getJemallocStat("stats.active");
+#elif defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+	const struct mallinfo2 info = mallinfo2();
+	usage.allocated = info.uordblks + info.hblkhd;
+	usage.held = info.arena + info.hblkhd;
+#endif
+	return usage;
+}
+
+uint64_t MemoryStats::purgeAllocator()
+{
+	const uint64_t residentBefore = getResidentBytes();
+#if defined(TFS_ALLOCATOR_MIMALLOC)
+	// the heap of the calling thread and the pages other threads abandoned
+	mi_collect(true);
+#elif defined(TFS_ALLOCATOR_JEMALLOC)
+	mallctl(fmt::format("arena.{:d}.purge", MALLCTL_ARENAS_ALL).c_str(), nullptr, nullptr, nullptr, 0);
+#elif defined(__GLIBC__)
+	malloc_trim(0);
+#endif
+	const uint64_t residentAfter = getResidentBytes();
+
+	const uint64_t purged = residentBefore > residentAfter ? residentBefore - residentAfter : 0;
+	allocatorPurged.add(purged);
+	return purged;
+}
+
+void MemoryStats::print()
+{
+	const AllocatorUsage allocator = getAllocatorUsage();
+	std::cout << fmt::format(">> Allocator {:s}: {:d} KiB allocated, {:d} KiB held, {:d} KiB resident",
+	                         allocator.allocator, allocator.allocated / 1024, allocator.held / 1024,
+	                         allocator.resident / 1024)
+	          << std::endl;
+
+	std::cout << ">> Memory by subsystem:" << std::endl;
+	for (const Usage& usage : getUsage()) {
+		std::cout << fmt::format("   {:<16s} {:>10d} objects {:>12d} KiB", usage.subsystem, usage.objects,
+		                         usage.bytes / 1024)
+		          << std::endl;
+	}
+}
@@ -0,0 +1,61 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_MEMORYSTATS_H
+#define FS_MEMORYSTATS_H
+
+enum MemorySubsystem : uint8_t
+{
+	MEMORY_TILES,
+	MEMORY_ITEMS,
+	MEMORY_CONTAINERS,
+	MEMORY_CREATURES,
+	MEMORY_CONDITIONS,
+	MEMORY_NETWORK_BUFFERS,
+	MEMORY_DATABASE_RESULTS,
+	MEMORY_LUA,
+
+	MEMORY_SUBSYSTEM_LAST,
+};
+
+/*
+ * Live objects and bytes per subsystem, counted where the objects are allocated and exported as tfs_memory_objects
+ * and tfs_memory_bytes. Database results count no bytes, libmysql owns those. Lua counts the blocks of all states.
+ */
+namespace MemoryStats {
+
+struct Usage
+{
+	std::string_view subsystem;
+	int64_t objects;
+	int64_t bytes;
+};
+
+void allocated(MemorySubsystem subsystem, size_t bytes);
+void freed(MemorySubsystem subsystem, size_t bytes);
+// a block that changed size in place
+void resized(MemorySubsystem subsystem, size_t oldBytes, size_t newBytes);
+
+std::vector<Usage> getUsage();
+
+// what the ALLOCATOR the server was built with reports, allocated is 0 where it is not tracked
+struct AllocatorUsage
+{
+	std::string_view allocator;
+	// bytes handed out to the program
+	uint64_t allocated;
+	// bytes the allocator holds in pages it got from the system, the difference to allocated is fragmentation
+	uint64_t held;
+	// resident set size of the process
+	uint64_t resident;
+};
+
+AllocatorUsage getAllocatorUsage();
+// returns the freed pages the allocator keeps cached to the system, the bytes the resident set shrank by
+uint64_t purgeAllocator();
+
+void print();
+
+} // namespace MemoryStats
+
+#endif // FS_MEMORYSTATS_H
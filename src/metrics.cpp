@@ -0,0 +1,197 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "metrics.h"
+
+#include "tasks.h"
+
+namespace {
+
+std::atomic<size_t> nextMetricShard{0};
+
+std::string_view getTypeName(MetricType type)
+{
+	switch (type) {
+		case METRIC_COUNTER:
+			return "counter";
+		case METRIC_GAUGE:
+			return "gauge";
+		default:
+			return "histogram";
+	}
+}
+
+} // namespace
+
+size_t getMetricShard()
+{
+	thread_local const size_t shard = nextMetricShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+	return shard;
+}
+
+Metric::Metric(MetricType type, std::string_view name, std::string_view help, std::string_view labels) :
+    name{name}, help{help}, labels{labels}, type{type}
+{
+	Metrics::getInstance().add(this);
+}
+
+Metric::~Metric() { Metrics::getInstance().remove(this); }
+
+void Metric::writeSample(std::string& out, std::string_view suffix, std::string_view extraLabel,
+                         std::string_view value) const
+{
+	out += name;
+	out += suffix;
+	if (!labels.empty() || !extraLabel.empty()) {
+		out += '{';
+		out += labels;
+		if (!labels.empty() && !extraLabel.empty()) {
+			out += ',';
+		}
+		out += extraLabel;
+		out += '}';
+	}
+	out += ' ';
+	out += value;
+	out += '\n';
+}
+
+uint64_t MetricCounter::value() const
+{
+	uint64_t value = 0;
+	for (const Shard& shard : shards) {
+		value += shard.value.load(std::memory_order_relaxed);
+	}
+	return value;
+}
+
+void MetricCounter::serialize(std::string& out) const { writeSample(out, {}, {}, std::to_string(value())); }
+
+int64_t MetricGauge::value() const
+{
+	int64_t value = 0;
+	for (const Shard& shard : shards) {
+		value += shard.value.load(std::memory_order_relaxed);
+	}
+	return value;
+}
+
+void MetricGauge::serialize(std::string& out) const { writeSample(out, {}, {}, std::to_string(value())); }
+
+MetricHistogram::MetricHistogram(std::string_view name, std::string_view help, std::vector<uint64_t> bounds,
+                                 std::string_view labels) :
+    Metric(METRIC_HISTOGRAM, name, help, labels), bounds{std::move(bounds)}
+{
+	for (size_t i = 0; i < METRIC_SHARDS; ++i) {
+		shards.emplace_back(this->bounds.size() + 1);
+	}
+}
+
+void MetricHistogram::observe(uint64_t value)
+{
+	Shard& shard = shards[getMetricShard()];
+	const size_t bucket = std::lower_bound(bounds.begin(), bounds.end(), value) - bounds.begin();
+	shard.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	shard.sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+void MetricHistogram::serialize(std::string& out) const
+{
+	uint64_t count = 0, sum = 0;
+	for (size_t bucket = 0; bucket <= bounds.size(); ++bucket) {
+		for (const Shard& shard : shards) {
+			count += shard.buckets[bucket].load(std::memory_order_relaxed);
+		}
+
+		const std::string bound = bucket < bounds.size() ? std::to_string(bounds[bucket]) : "+Inf";
+		writeSample(out, "_bucket", fmt::format("le=\"{:s}\"", bound), std::to_string(count));
+	}
+
+	for (const Shard& shard : shards) {
+		sum += shard.sum.load(std::memory_order_relaxed);
+	}
+	writeSample(out, "_sum", {}, std::to_string(sum));
+	writeSample(out, "_count", {}, std::to_string(count));
+}
+
+std::string Metrics::serialize() const
+{
+	std::string out;
+	std::string_view lastName;
+	for (const Metric* metric : metrics) {
+		// labelled counters that never counted are left out, the packet opcodes would otherwise list all 256
+		if (metric->getType() == METRIC_COUNTER && !metric->getLabels().empty() &&
+		    static_cast<const MetricCounter*>(metric)->value() == 0) {
+			continue;
+		}
+
+		if (metric->getName() != lastName) {
+			lastName = metric->getName();
+			fmt::format_to(std::back_inserter(out), "# HELP {:s} {:s}\n# TYPE {:s} {:s}\n", metric->getName(),
+			               metric->getHelp(), metric->getName(), getTypeName(metric->getType()));
+		}
+		metric->serialize(out);
+	}
+	return out;
+}
+
+namespace metrics {
+
+MetricGauge playersOnline{"tfs_players_online", "Players logged in."};
+MetricGauge dispatcherQueueDepth{"tfs_dispatcher_queue_depth", "Tasks waiting for the dispatcher."};
+MetricHistogram dispatcherTaskTime{"tfs_dispatcher_task_duration_microseconds",
+                                   "Execution time of dispatcher tasks.",
+                                   {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000}};
+MetricHistogram tickBusyTime{"tfs_tick_busy_microseconds",
+                             "Dispatcher time spent between two creature checks.",
+                             {1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000}};
+MetricGauge schedulerEvents{"tfs_scheduler_events", "Scheduler events waiting to be due."};
+MetricGauge databaseQueueDepth{"tfs_database_queue_depth", "Queries and jobs waiting for a database connection."};
+MetricCounter bytesReceived{"tfs_network_received_bytes_total", "Bytes read from client connections."};
+MetricCounter bytesSent{"tfs_network_sent_bytes_total", "Bytes written to client connections."};
+MetricCounter luaTime{"tfs_lua_time_microseconds_total", "Time spent running lua scripts."};
+
+namespace {
+
+std::deque<MetricCounter> createOpcodeCounters(std::string_view name, std::string_view help)
+{
+	std::deque<MetricCounter> counters;
+	for (uint32_t opcode = 0; opcode <= std::numeric_limits<uint8_t>::max(); ++opcode) {
+		counters.emplace_back(name, help, fmt::format("opcode=\"0x{:02X}\"", opcode));
+	}
+	return counters;
+}
+
+std::deque<MetricCounter> packetCounters =
+    createOpcodeCounters("tfs_packets_received_total", "Client packets received by opcode.");
+std::deque<MetricCounter> packetByteCounters =
+    createOpcodeCounters("tfs_packet_received_bytes_total", "Bytes of client packets received by opcode.");
+std::deque<MetricCounter> packetExecutionCounters = createOpcodeCounters(
+    "tfs_packet_execution_microseconds_total", "Dispatcher time spent on client packets by opcode.");
+std::deque<MetricCounter> packetWaitCounters = createOpcodeCounters(
+    "tfs_packet_wait_microseconds_total", "Time client packet tasks waited for the dispatcher by opcode.");
+
+std::deque<MetricHistogram> createLaneHistograms()
+{
+	std::deque<MetricHistogram> histograms;
+	for (uint8_t lane = 0; lane < DISPATCHER_LANE_COUNT; ++lane) {
+		histograms.emplace_back("tfs_dispatcher_wait_microseconds", "Time dispatcher tasks waited by lane.",
+		                        std::vector<uint64_t>{50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000},
+		                        fmt::format("lane=\"{:s}\"", getDispatcherLaneName(static_cast<DispatcherLane>(lane))));
+	}
+	return histograms;
+}
+
+std::deque<MetricHistogram> laneWaitHistograms = createLaneHistograms();
+
+} // namespace
+
+MetricCounter& packetsReceived(uint8_t opcode) { return packetCounters[opcode]; }
+MetricCounter& packetBytes(uint8_t opcode) { return packetByteCounters[opcode]; }
+MetricCounter& packetExecutionTime(uint8_t opcode) { return packetExecutionCounters[opcode]; }
+MetricCounter& packetWaitTime(uint8_t opcode) { return packetWaitCounters[opcode]; }
+MetricHistogram& dispatcherWaitTime(uint8_t lane) { return laneWaitHistograms[lane]; }
+
+} // namespace metrics
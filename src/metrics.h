@@ -0,0 +1,164 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_METRICS_H
+#define FS_METRICS_H
+
+inline constexpr size_t METRIC_SHARDS = 8;
+
+// shard of the calling thread, threads are spread round-robin over the shards the first time they update a metric
+size_t getMetricShard();
+
+enum MetricType : uint8_t
+{
+	METRIC_COUNTER,
+	METRIC_GAUGE,
+	METRIC_HISTOGRAM,
+};
+
+// Metrics register themselves on construction and are exported in registration order, so they must be created at
+// startup (static objects) before the metrics port is opened. Updates are relaxed atomic adds on the shard of the
+// calling thread, reading sums the shards and is safe from any thread.
+class Metric
+{
+public:
+	Metric(MetricType type, std::string_view name, std::string_view help, std::string_view labels = {});
+	virtual ~Metric();
+
+	// non-copyable
+	Metric(const Metric&) = delete;
+	Metric& operator=(const Metric&) = delete;
+
+	MetricType getType() const { return type; }
+	std::string_view getName() const { return name; }
+	std::string_view getHelp() const { return help; }
+	// label pairs without the braces, e.g. opcode="0x64"
+	std::string_view getLabels() const { return labels; }
+
+	// appends the samples in the prometheus text format
+	virtual void serialize(std::string& out) const = 0;
+
+protected:
+	void writeSample(std::string& out, std::string_view suffix, std::string_view extraLabel,
+	                 std::string_view value) const;
+
+private:
+	std::string name;
+	std::string help;
+	std::string labels;
+	MetricType type;
+};
+
+class MetricCounter final : public Metric
+{
+public:
+	MetricCounter(std::string_view name, std::string_view help, std::string_view labels = {}) :
+	    Metric(METRIC_COUNTER, name, help, labels)
+	{}
+
+	void add(uint64_t value = 1) { shards[getMetricShard()].value.fetch_add(value, std::memory_order_relaxed); }
+	uint64_t value() const;
+
+	void serialize(std::string& out) const override;
+
+private:
+	struct alignas(64) Shard
+	{
+		std::atomic<uint64_t> value{0};
+	};
+	std::array<Shard, METRIC_SHARDS> shards;
+};
+
+// a value that goes up and down, kept as the sum of the changes made on each shard
+class MetricGauge final : public Metric
+{
+public:
+	MetricGauge(std::string_view name, std::string_view help, std::string_view labels = {}) :
+	    Metric(METRIC_GAUGE, name, help, labels)
+	{}
+
+	void add(int64_t value = 1) { shards[getMetricShard()].value.fetch_add(value, std::memory_order_relaxed); }
+	void sub(int64_t value = 1) { add(-value); }
+	int64_t value() const;
+
+	void serialize(std::string& out) const override;
+
+private:
+	struct alignas(64) Shard
+	{
+		std::atomic<int64_t> value{0};
+	};
+	std::array<Shard, METRIC_SHARDS> shards;
+};
+
+class MetricHistogram final : public Metric
+{
+public:
+	// bounds are the inclusive upper bounds of the buckets in ascending order, +Inf is implied
+	MetricHistogram(std::string_view name, std::string_view help, std::vector<uint64_t> bounds,
+	                std::string_view labels = {});
+
+	void observe(uint64_t value);
+
+	void serialize(std::string& out) const override;
+
+private:
+	struct alignas(64) Shard
+	{
+		explicit Shard(size_t buckets) : buckets(buckets) {}
+
+		// one past the bounds for +Inf
+		std::vector<std::atomic<uint64_t>> buckets;
+		std::atomic<uint64_t> sum{0};
+	};
+
+	std::vector<uint64_t> bounds;
+	std::deque<Shard> shards;
+};
+
+class Metrics
+{
+public:
+	static Metrics& getInstance()
+	{
+		static Metrics instance;
+		return instance;
+	}
+
+	void add(const Metric* metric) { metrics.push_back(metric); }
+	void remove(const Metric* metric) { std::erase(metrics, metric); }
+
+	// every metric in the prometheus text exposition format
+	std::string serialize() const;
+
+private:
+	Metrics() = default;
+
+	std::vector<const Metric*> metrics;
+};
+
+// metrics the server itself keeps up to date
+namespace metrics {
+
+extern MetricGauge playersOnline;
+extern MetricGauge dispatcherQueueDepth;
+extern MetricHistogram dispatcherTaskTime;
+extern MetricHistogram tickBusyTime;
+extern MetricGauge schedulerEvents;
+extern MetricGauge databaseQueueDepth;
+extern MetricCounter bytesReceived;
+extern MetricCounter bytesSent;
+extern MetricCounter luaTime;
+
+// client packets by first opcode, execution and wait time are those of the dispatcher tasks they post
+MetricCounter& packetsReceived(uint8_t opcode);
+MetricCounter& packetBytes(uint8_t opcode);
+MetricCounter& packetExecutionTime(uint8_t opcode);
+MetricCounter& packetWaitTime(uint8_t opcode);
+
+// time dispatcher tasks waited in the queue by lane, a DispatcherLane
+MetricHistogram& dispatcherWaitTime(uint8_t lane);
+
+} // namespace metrics
+
+#endif // FS_METRICS_H
@@ -18,7 +18,7 @@ extern ConfigManager g_config;
 int32_t Monster::despawnRange;
 int32_t Monster::despawnRadius;
 
-uint32_t Monster::monsterAutoID = 0x40000000;
+SlotMap<Monster> Monster::monsterIds{0x40000000, 0x80000000};
 
 Monster* Monster::createMonster(const std::string& name)
 {
@@ -52,6 +52,7 @@ Monster::~Monster()
 {
 	clearTargetList();
 	clearFriendList();
+	monsterIds.release(id);
 }
 
 void Monster::addList() { g_game.addMonster(this); }
@@ -190,85 +191,103 @@ void Monster::onRemoveCreature(Creature* creature, bool isLogout)
 	}
 }
 
-void Monster::onCreatureMove(Creature* creature, const Tile* newTile, const Position& newPos, const Tile* oldTile,
-                             const Position& oldPos, bool teleport)
+bool Monster::callCreatureMoveEvent(Creature* creature, const Position& oldPos, const Position& newPos)
 {
-	Creature::onCreatureMove(creature, newTile, newPos, oldTile, oldPos, teleport);
+	if (mType->info.creatureMoveEvent == -1) {
+		return false;
+	}
 
-	if (mType->info.creatureMoveEvent != -1) {
-		// onCreatureMove(self, creature, oldPosition, newPosition)
-		LuaScriptInterface* scriptInterface = mType->info.scriptInterface;
-		if (!scriptInterface->reserveScriptEnv()) {
-			std::cout << "[Error - Monster::onCreatureMove] Call stack overflow" << std::endl;
-			return;
-		}
+	// onCreatureMove(self, creature, oldPosition, newPosition)
+	LuaScriptInterface* scriptInterface = mType->info.scriptInterface;
+	if (!scriptInterface->reserveScriptEnv()) {
+		std::cout << "[Error - Monster::onCreatureMove] Call stack overflow" << std::endl;
+		return true;
+	}
 
-		ScriptEnvironment* env = scriptInterface->getScriptEnv();
-		env->setScriptId(mType->info.creatureMoveEvent, scriptInterface);
+	ScriptEnvironment* env = scriptInterface->getScriptEnv();
+	env->setScriptId(mType->info.creatureMoveEvent, scriptInterface);
 
-		lua_State* L = scriptInterface->getLuaState();
-		scriptInterface->pushFunction(mType->info.creatureMoveEvent);
+	lua_State* L = scriptInterface->getLuaState();
+	scriptInterface->pushFunction(mType->info.creatureMoveEvent);
 
-		Lua::pushUserdata<Monster>(L, this);
-		Lua::setMetatable(L, -1, "Monster");
+	Lua::pushUserdata<Monster>(L, this);
+	Lua::setMetatable(L, -1, "Monster");
 
-		Lua::pushUserdata<Creature>(L, creature);
-		Lua::setCreatureMetatable(L, -1, creature);
+	Lua::pushUserdata<Creature>(L, creature);
+	Lua::setCreatureMetatable(L, -1, creature);
 
-		Lua::pushPosition(L, oldPos);
-		Lua::pushPosition(L, newPos);
+	Lua::pushPosition(L, oldPos);
+	Lua::pushPosition(L, newPos);
 
-		if (scriptInterface->callFunction(4)) {
-			return;
-		}
+	return scriptInterface->callFunction(4);
+}
+
+void Monster::onCreatureMove(Creature* creature, const Tile* newTile, const Position& newPos, const Tile* oldTile,
+                             const Position& oldPos, bool teleport)
+{
+	Creature::onCreatureMove(creature, newTile, newPos, oldTile, oldPos, teleport);
+
+	if (creature != this) {
+		// a step in a crowd reaches hundreds of monsters, each reacts to the creatures that moved once a tick
+		queueCreatureMove(creature, oldPos, newPos);
+		return;
 	}
 
-	if (creature == this) {
-		if (isSummon()) {
-			isMasterInRange = canSee(getMaster()->getPosition());
-		}
+	if (callCreatureMoveEvent(creature, oldPos, newPos)) {
+		return;
+	}
 
-		updateTargetList();
-		updateIdleStatus();
-	} else {
-		bool canSeeNewPos = canSee(newPos);
-		bool canSeeOldPos = canSee(oldPos);
+	if (isSummon()) {
+		isMasterInRange = canSee(getMaster()->getPosition());
+	}
 
-		if (canSeeNewPos && !canSeeOldPos) {
-			onCreatureEnter(creature);
-		} else if (!canSeeNewPos && canSeeOldPos) {
-			onCreatureLeave(creature);
-		}
+	// whoever came into view is among the move's spectators, handed over once everyone was notified
+	scanTargetsOnMove = true;
+}
 
-		if (canSeeNewPos && isSummon() && getMaster() == creature) {
-			isMasterInRange = true; // Follow master again
-		}
+void Monster::onQueuedCreatureMove(Creature* creature, const Position& oldPos, const Position& newPos)
+{
+	if (callCreatureMoveEvent(creature, oldPos, newPos)) {
+		return;
+	}
 
-		updateIdleStatus();
+	bool canSeeNewPos = canSee(newPos);
+	bool canSeeOldPos = canSee(oldPos);
 
-		if (!isSummon()) {
-			if (followCreature) {
-				const Position& followPosition = followCreature->getPosition();
-				const Position& position = getPosition();
-
-				int32_t offset_x = followPosition.getDistanceX(position);
-				int32_t offset_y = followPosition.getDistanceY(position);
-				if ((offset_x > 1 || offset_y > 1) && mType->info.changeTargetChance > 0) {
-					Direction dir = getDirectionTo(position, followPosition);
-					const Position& checkPosition = getNextPosition(dir, position);
-
-					Tile* tile = g_game.map.getTile(checkPosition);
-					if (tile) {
-						Creature* topCreature = tile->getTopCreature();
-						if (topCreature && followCreature != topCreature && isOpponent(topCreature)) {
-							selectTarget(topCreature);
-						}
+	if (canSeeNewPos && !canSeeOldPos) {
+		onCreatureEnter(creature);
+	} else if (!canSeeNewPos && canSeeOldPos) {
+		onCreatureLeave(creature);
+	}
+
+	if (canSeeNewPos && isSummon() && getMaster() == creature) {
+		isMasterInRange = true; // Follow master again
+	}
+
+	updateIdleStatus();
+
+	if (!isSummon()) {
+		if (followCreature) {
+			const Position& followPosition = followCreature->getPosition();
+			const Position& position = getPosition();
+
+			int32_t offset_x = followPosition.getDistanceX(position);
+			int32_t offset_y = followPosition.getDistanceY(position);
+			if ((offset_x > 1 || offset_y > 1) && mType->info.changeTargetChance > 0) {
+				Direction dir = getDirectionTo(position, followPosition);
+				const Position& checkPosition = getNextPosition(dir, position);
+
+				Tile* tile = g_game.map.getTile(checkPosition);
+				if (tile) {
+					Creature* topCreature = tile->getTopCreature();
+					if (topCreature && followCreature != topCreature && isOpponent(topCreature)) {
+						selectTarget(topCreature);
 					}
 				}
-			} else if (isOpponent(creature)) {
-				// we have no target lets try pick this one
-				selectTarget(creature);
 			}
+		} else if (isOpponent(creature)) {
+			// we have no target lets try pick this one
+			selectTarget(creature);
 		}
 	}
 }
@@ -328,7 +347,7 @@ void Monster::addTarget(Creature* creature, bool pushFront /* = false*/)
 	if (std::find(targetList.begin(), targetList.end(), creature) == targetList.end()) {
 		creature->incrementReferenceCounter();
 		if (pushFront) {
-			targetList.push_front(creature);
+			targetList.insert(targetList.begin(), creature);
 		} else {
 			targetList.push_back(creature);
 		}
@@ -346,34 +365,38 @@ void Monster::removeTarget(Creature* creature)
 
 void Monster::updateTargetList()
 {
-	auto friendIterator = friendList.begin();
-	while (friendIterator != friendList.end()) {
-		Creature* creature = *friendIterator;
+	SpectatorVec spectators;
+	g_game.map.getSpectators(spectators, position, true);
+	updateTargetList(spectators);
+}
+
+void Monster::updateTargetList(const SpectatorVec& spectators)
+{
+	auto lostSight = [this](Creature* creature) {
 		if (creature->isDead() || !canSee(creature->getPosition())) {
 			creature->decrementReferenceCounter();
-			friendIterator = friendList.erase(friendIterator);
-		} else {
-			++friendIterator;
+			return true;
 		}
-	}
+		return false;
+	};
+	friendList.erase(std::remove_if(friendList.begin(), friendList.end(), lostSight), friendList.end());
+	targetList.erase(std::remove_if(targetList.begin(), targetList.end(), lostSight), targetList.end());
 
-	auto targetIterator = targetList.begin();
-	while (targetIterator != targetList.end()) {
-		Creature* creature = *targetIterator;
-		if (creature->isDead() || !canSee(creature->getPosition())) {
-			creature->decrementReferenceCounter();
-			targetIterator = targetList.erase(targetIterator);
-		} else {
-			++targetIterator;
+	for (Creature* spectator : spectators) {
+		if (spectator != this) {
+			onCreatureFound(spectator);
 		}
 	}
+}
 
-	SpectatorVec spectators;
-	g_game.map.getSpectators(spectators, position, true);
-	spectators.erase(this);
-	for (Creature* spectator : spectators) {
-		onCreatureFound(spectator);
+void Monster::onMoveSpectators(const SpectatorVec& spectators)
+{
+	if (!std::exchange(scanTargetsOnMove, false)) {
+		return;
 	}
+
+	updateTargetList(spectators);
+	updateIdleStatus();
 }
 
 void Monster::clearTargetList()
@@ -508,6 +531,64 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 		}
 	}
 
+	return selectFoundTarget(searchType, resultList);
+}
+
+uint32_t Monster::getThinkInterval(bool slow, int32_t fullThinkDistance)
+{
+	// one that is busy with a creature always thinks at full rate
+	uint8_t rounds = 1;
+	if (!attackedCreature && !followCreature) {
+		if (fullThinkDistance > 0 && !g_game.map.hasPlayerInRange(position, fullThinkDistance)) {
+			rounds = FAR_THINK_ROUNDS;
+		} else if (slow && !isSummon() && targetList.empty()) {
+			rounds = 2;
+		}
+	}
+
+	if (++skippedThinks < rounds) {
+		return 0;
+	}
+	return EVENT_CREATURE_THINK_INTERVAL * std::exchange(skippedThinks, 0);
+}
+
+bool Monster::needsTargetDecision() const
+{
+	return !isSummon() && !isIdle && !targetList.empty() && (!followCreature || !hasFollowPath);
+}
+
+void Monster::decideTargets()
+{
+	decidedTargets.clear();
+
+	const Position& myPos = getPosition();
+	for (Creature* creature : targetList) {
+		if (followCreature != creature && isTarget(creature) && canUseAttack(myPos, creature)) {
+			decidedTargets.push_back(creature);
+		}
+	}
+	hasDecidedTargets = true;
+}
+
+bool Monster::searchDecidedTarget()
+{
+	// the decision saw the world as it was at the start of the pass, only the cheap checks are repeated
+	std::list<Creature*> resultList;
+	for (Creature* creature : decidedTargets) {
+		if (std::find(targetList.begin(), targetList.end(), creature) != targetList.end() &&
+		    followCreature != creature && isTarget(creature)) {
+			resultList.push_back(creature);
+		}
+	}
+	decidedTargets.clear();
+
+	return selectFoundTarget(TARGETSEARCH_DEFAULT, resultList);
+}
+
+bool Monster::selectFoundTarget(TargetSearchType_t searchType, std::list<Creature*>& resultList)
+{
+	const Position& myPos = getPosition();
+
 	switch (searchType) {
 		case TARGETSEARCH_NEAREST: {
 			Creature* target = nullptr;
@@ -566,8 +647,9 @@ bool Monster::searchTarget(TargetSearchType_t searchType /*= TARGETSEARCH_DEFAUL
 		}
 	}
 
-	// lets just pick the first target in the list
-	for (Creature* target : targetList) {
+	// lets just pick the first target in the list, selecting one may reorder it
+	for (size_t i = 0; i < targetList.size(); ++i) {
+		Creature* target = targetList[i];
 		if (followCreature != target && selectTarget(target)) {
 			return true;
 		}
@@ -584,7 +666,7 @@ void Monster::onFollowCreatureComplete(const Creature* creature)
 			targetList.erase(it);
 
 			if (hasFollowPath) {
-				targetList.push_front(target);
+				targetList.insert(targetList.begin(), target);
 			} else if (!isSummon()) {
 				targetList.push_back(target);
 			} else {
@@ -705,6 +787,8 @@ void Monster::onThink(uint32_t interval)
 {
 	Creature::onThink(interval);
 
+	const bool decided = std::exchange(hasDecidedTargets, false);
+
 	if (mType->info.thinkEvent != -1) {
 		// onThink(self, interval)
 		LuaScriptInterface* scriptInterface = mType->info.scriptInterface;
@@ -760,7 +844,11 @@ void Monster::onThink(uint32_t interval)
 				}
 			} else if (!targetList.empty()) {
 				if (!followCreature || !hasFollowPath) {
-					searchTarget();
+					if (decided) {
+						searchDecidedTarget();
+					} else {
+						searchTarget();
+					}
 				} else if (isFleeing()) {
 					if (attackedCreature && !canUseAttack(getPosition(), attackedCreature)) {
 						searchTarget(TARGETSEARCH_ATTACKRANGE);
@@ -788,15 +876,10 @@ void Monster::doAttacking(uint32_t interval)
 	const Position& myPos = getPosition();
 	const Position& targetPos = attackedCreature->getPosition();
 
-	for (const spellBlock_t& spellBlock : mType->info.attackSpells) {
+	auto useSpell = [&](const spellBlock_t& spellBlock) {
 		bool inRange = false;
-
-		if (attackedCreature == nullptr) {
-			break;
-		}
-
 		if (canUseSpell(myPos, targetPos, spellBlock, interval, inRange, resetTicks)) {
-			if (spellBlock.chance >= static_cast<uint32_t>(uniform_random(1, 100))) {
+			if (spellBlock.chance >= 100 || spellBlock.chance >= static_cast<uint32_t>(uniform_random(1, 100))) {
 				if (updateLook) {
 					updateLookDirection();
 					updateLook = false;
@@ -816,6 +899,28 @@ void Monster::doAttacking(uint32_t interval)
 			// melee swing out of reach
 			lastMeleeAttack = 0;
 		}
+	};
+
+	const auto& spells = mType->info.attackSpells;
+	SpellSchedule& schedule = mType->info.attackSchedule;
+	if (const std::vector<uint16_t>* dueSpells = schedule.getDueSpells(spells, interval, attackTicks)) {
+		for (uint16_t index : *dueSpells) {
+			if (!attackedCreature) {
+				break;
+			}
+			useSpell(spells[index]);
+		}
+
+		if (attackTicks < schedule.getCycleTicks()) {
+			resetTicks = false;
+		}
+	} else {
+		for (const spellBlock_t& spellBlock : spells) {
+			if (!attackedCreature) {
+				break;
+			}
+			useSpell(spellBlock);
+		}
 	}
 
 	if (updateLook) {
@@ -924,26 +1029,40 @@ void Monster::onThinkDefense(uint32_t interval)
 	bool resetTicks = true;
 	defenseTicks += interval;
 
-	for (const spellBlock_t& spellBlock : mType->info.defenseSpells) {
+	auto useSpell = [&](const spellBlock_t& spellBlock) {
 		if (spellBlock.speed > defenseTicks) {
 			resetTicks = false;
-			continue;
+			return;
 		}
 
 		if (defenseTicks % spellBlock.speed >= interval) {
 			// already used this spell for this round
-			continue;
+			return;
 		}
 
-		if ((spellBlock.chance >= static_cast<uint32_t>(uniform_random(1, 100)))) {
+		if (spellBlock.chance >= 100 || spellBlock.chance >= static_cast<uint32_t>(uniform_random(1, 100))) {
 			minCombatValue = spellBlock.minCombatValue;
 			maxCombatValue = spellBlock.maxCombatValue;
 			spellBlock.spell->castSpell(this, this);
 		}
+	};
+
+	const auto& spells = mType->info.defenseSpells;
+	SpellSchedule& schedule = mType->info.defenseSchedule;
+	if (const std::vector<uint16_t>* dueSpells = schedule.getDueSpells(spells, interval, defenseTicks)) {
+		for (uint16_t index : *dueSpells) {
+			useSpell(spells[index]);
+		}
+
+		if (defenseTicks < schedule.getCycleTicks()) {
+			resetTicks = false;
+		}
+	} else {
+		std::for_each(spells.begin(), spells.end(), useSpell);
 	}
 
 	if (!isSummon() && summons.size() < mType->info.maxSummons && hasFollowPath) {
-		for (const summonBlock_t& summonBlock : mType->info.summons) {
+		for (summonBlock_t& summonBlock : mType->info.summons) {
 			if (summonBlock.speed > defenseTicks) {
 				resetTicks = false;
 				continue;
@@ -973,8 +1092,12 @@ void Monster::onThinkDefense(uint32_t interval)
 				continue;
 			}
 
-			Monster* summon = Monster::createMonster(summonBlock.name);
-			if (summon) {
+			if (!summonBlock.mType) {
+				summonBlock.mType = g_monsters.getMonsterType(summonBlock.name);
+			}
+
+			if (summonBlock.mType) {
+				Monster* summon = new Monster(summonBlock.mType);
 				if (g_game.placeCreature(summon, getPosition(), false, summonBlock.force, summonBlock.effect)) {
 					summon->setDropLoot(false);
 					summon->setSkillLoss(false);
@@ -1809,7 +1932,7 @@ bool Monster::canWalkTo(Position pos, Direction direction) const
 
 		Tile* tile = g_game.map.getTile(pos);
 		if (tile && tile->getTopVisibleCreature(this) == nullptr &&
-		    tile->queryAdd(0, *this, 1, FLAG_PATHFINDING) == RETURNVALUE_NOERROR) {
+		    tile->queryAddCreature(*this, FLAG_PATHFINDING) == RETURNVALUE_NOERROR) {
 			return true;
 		}
 	}
@@ -11,8 +11,9 @@ class Creature;
 class Game;
 class Spawn;
 
-using CreatureHashSet = std::unordered_set<Creature*>;
-using CreatureList = std::list<Creature*>;
+// a monster rarely sees more than a handful of creatures, flat containers keep them on a cache line or two
+using CreatureSet = boost::container::flat_set<Creature*>;
+using CreatureList = std::vector<Creature*>;
 
 enum TargetSearchType_t
 {
@@ -44,7 +45,7 @@ public:
 	void setID() override
 	{
 		if (id == 0) {
-			id = monsterAutoID++;
+			id = monsterIds.acquire();
 		}
 	}
 
@@ -85,6 +86,8 @@ public:
 	void onRemoveCreature(Creature* creature, bool isLogout) override;
 	void onCreatureMove(Creature* creature, const Tile* newTile, const Position& newPos, const Tile* oldTile,
 	                    const Position& oldPos, bool teleport) override;
+	void onMoveSpectators(const SpectatorVec& spectators) override;
+	void onQueuedCreatureMove(Creature* creature, const Position& oldPos, const Position& newPos) override;
 	void onCreatureSay(Creature* creature, SpeakClasses type, std::string_view text) override;
 
 	void drainHealth(Creature* attacker, int32_t damage) override;
@@ -98,6 +101,9 @@ public:
 	void onFollowCreatureComplete(const Creature* creature) override;
 
 	void onThink(uint32_t interval) override;
+	// what the creature check thinks with, 0 skips the round, the skipped rounds are thought along with the next one;
+	// one without players within fullThinkDistance tiles thinks every FAR_THINK_ROUNDS rounds, 0 disables that
+	uint32_t getThinkInterval(bool slow, int32_t fullThinkDistance);
 
 	bool challengeCreature(Creature* creature, bool force = false) override;
 
@@ -110,8 +116,12 @@ public:
 	bool searchTarget(TargetSearchType_t searchType = TARGETSEARCH_DEFAULT);
 	bool selectTarget(Creature* creature);
 
+	// decide phase of Game::checkCreatures, only reads the world and may run on a worker thread
+	bool needsTargetDecision() const;
+	void decideTargets();
+
 	const CreatureList& getTargetList() const { return targetList; }
-	const CreatureHashSet& getFriendList() const { return friendList; }
+	const CreatureSet& getFriendList() const { return friendList; }
 
 	bool isTarget(const Creature* creature) const;
 	bool isFleeing() const
@@ -126,7 +136,7 @@ public:
 	BlockType_t blockHit(Creature* attacker, CombatType_t combatType, int32_t& damage, bool checkDefense = false,
 	                     bool checkArmor = false, bool field = false, bool ignoreResistances = false) override;
 
-	static uint32_t monsterAutoID;
+	static SlotMap<Monster> monsterIds;
 
 	// for lua module
 	auto getMonsterType() const { return mType; }
@@ -145,8 +155,10 @@ public:
 	void removeTarget(Creature* creature);
 
 private:
-	CreatureHashSet friendList;
+	CreatureSet friendList;
 	CreatureList targetList;
+	// attackable targets found by decideTargets, used by the next think instead of searching again
+	std::vector<Creature*> decidedTargets;
 
 	std::string name;
 	std::string nameDescription;
@@ -173,14 +185,22 @@ private:
 	bool isMasterInRange = false;
 	bool randomStepping = false;
 	bool walkingToSpawn = false;
+	bool hasDecidedTargets = false;
+	bool scanTargetsOnMove = false;
+
+	static constexpr uint8_t FAR_THINK_ROUNDS = 4;
+	uint8_t skippedThinks = 0;
 
 	void onCreatureEnter(Creature* creature);
+	// true when the script asked to skip the monster's own reaction
+	bool callCreatureMoveEvent(Creature* creature, const Position& oldPos, const Position& newPos);
 	void onCreatureLeave(Creature* creature);
 	void onCreatureFound(Creature* creature, bool pushFront = false);
 
 	void updateLookDirection();
 
 	void updateTargetList();
+	void updateTargetList(const SpectatorVec& spectators);
 	void clearTargetList();
 	void clearFriendList();
 
@@ -189,6 +209,9 @@ private:
 
 	void updateIdleStatus();
 
+	bool selectFoundTarget(TargetSearchType_t searchType, std::list<Creature*>& resultList);
+	bool searchDecidedTarget();
+
 	void onAddCondition(ConditionType_t type) override;
 	void onEndCondition(ConditionType_t type) override;
 
@@ -8,6 +8,7 @@
 #include "combat.h"
 #include "configmanager.h"
 #include "game.h"
+#include "logger.h"
 #include "matrixarea.h"
 #include "monster.h"
 #include "pugicast.h"
@@ -26,6 +27,40 @@ spellBlock_t::~spellBlock_t()
 	}
 }
 
+const std::vector<uint16_t>* SpellSchedule::getDueSpells(const std::vector<spellBlock_t>& spells, uint32_t interval,
+                                                         uint32_t ticks)
+{
+	if (interval == 0 || ticks % interval != 0) {
+		return nullptr;
+	}
+
+	if (this->interval != interval || steps.empty()) {
+		this->interval = interval;
+		cycleTicks = 0;
+		for (const spellBlock_t& spell : spells) {
+			if (!spell.isMelee) {
+				cycleTicks = std::max(cycleTicks, spell.speed);
+			}
+		}
+
+		// the ticks restart at the first think at or past the cycle
+		steps.assign((cycleTicks + interval - 1) / interval + 1, {});
+		for (size_t step = 0; step < steps.size(); ++step) {
+			const uint32_t stepTicks = static_cast<uint32_t>(step) * interval;
+			for (size_t index = 0; index < spells.size(); ++index) {
+				const spellBlock_t& spell = spells[index];
+				if (spell.isMelee || spell.speed == 0 ||
+				    (spell.speed <= stepTicks && stepTicks % spell.speed < interval)) {
+					steps[step].push_back(static_cast<uint16_t>(index));
+				}
+			}
+		}
+	}
+
+	const size_t step = ticks / interval;
+	return step < steps.size() ? &steps[step] : nullptr;
+}
+
 void MonsterType::loadLoot(MonsterType* monsterType, LootBlock lootBlock)
 {
 	if (lootBlock.childLoot.empty()) {
@@ -39,46 +74,218 @@ void MonsterType::loadLoot(MonsterType* monsterType, LootBlock lootBlock)
 	} else {
 		monsterType->info.lootItems.push_back(lootBlock);
 	}
+	monsterType->info.lootTable.clear();
+}
+
+namespace {
+
+void compileLootBlocks(const std::vector<LootBlock>& blocks, std::vector<CompiledLootEntry>& table)
+{
+	for (const LootBlock& block : blocks) {
+		const ItemType& it = Item::items[block.id];
+		const auto index = table.size();
+		table.push_back({block.text, block.chance, block.countmin, block.countmax, block.subType, block.actionId, 0,
+		                 block.id, it.stackSize, it.stackable, it.isFluidContainer()});
+		compileLootBlocks(block.childLoot, table);
+		table[index].end = static_cast<uint32_t>(table.size());
+	}
+}
+
+} // namespace
+
+void MonsterType::compileLoot()
+{
+	info.lootTable.clear();
+	compileLootBlocks(info.lootItems, info.lootTable);
+	info.lootTable.shrink_to_fit();
+}
+
+bool MonsterType::createLoot(Container* corpse)
+{
+	const uint64_t rate = g_config[ConfigKeysInteger::RATE_LOOT];
+	if (rate == 0) {
+		return true;
+	}
+
+	if (info.lootTable.empty()) {
+		compileLoot();
+	}
+
+	bool success = true;
+	for (uint32_t index = 0; index < info.lootTable.size(); index = info.lootTable[index].end) {
+		if (!createLootItem(corpse, index, rate)) {
+			success = false;
+		}
+	}
+	return success;
+}
+
+bool MonsterType::createLootItem(Container* container, uint32_t index, uint64_t rate)
+{
+	if (container->capacity() <= container->size()) {
+		return true;
+	}
+
+	const CompiledLootEntry& entry = info.lootTable[index];
+
+	// roll / rate < chance, kept in integers
+	const uint32_t roll = static_cast<uint32_t>(uniform_random(0, MAX_LOOTCHANCE));
+	if (roll >= entry.chance * rate) {
+		return true;
+	}
+
+	uint32_t itemCount = 1;
+	if (entry.stackable) {
+		const double value = static_cast<double>(roll) / rate;
+		int32_t max = static_cast<int32_t>(std::fmod(value, entry.countmax)) + 1;
+		int32_t min = entry.countmin != 0 ? static_cast<int32_t>(std::fmod(value, entry.countmin)) + 1 : max;
+		if (min > max) {
+			std::swap(min, max);
+		}
+		itemCount = uniform_random(min, max);
+	}
+
+	while (itemCount > 0) {
+		const uint32_t count = entry.stackable ? std::min<uint32_t>(entry.stackSize, itemCount) : 1;
+
+		uint16_t subType = static_cast<uint16_t>(count);
+		if (entry.fluidContainer) {
+			subType = static_cast<uint16_t>(std::max(0, entry.subType));
+		}
+
+		Item* item = Item::CreateItem(entry.id, subType);
+		if (!item) {
+			return false;
+		}
+
+		if (Container* lootContainer = item->getContainer()) {
+			for (uint32_t child = index + 1; child < entry.end; child = info.lootTable[child].end) {
+				if (!createLootItem(lootContainer, child, rate)) {
+					delete item;
+					return false;
+				}
+			}
+
+			if (entry.end != index + 1 && lootContainer->empty()) {
+				delete item;
+				return true;
+			}
+		}
+
+		if (entry.subType != -1) {
+			item->setCharges(static_cast<uint16_t>(entry.subType));
+		}
+
+		if (entry.actionId != -1) {
+			item->setActionId(static_cast<uint16_t>(entry.actionId));
+		}
+
+		if (!entry.text.empty()) {
+			item->setText(entry.text);
+		}
+
+		if (g_game.internalAddItem(container, item) != RETURNVALUE_NOERROR) {
+			delete item;
+		}
+
+		itemCount -= count;
+	}
+	return true;
 }
 
 bool Monsters::loadFromXml(bool reloading /*= false*/)
 {
-	unloadedMonsters = {};
+	MonsterFiles monsterFiles = readMonsterFiles(reloading ? getLoadedNames() : std::unordered_set<std::string>{},
+	                                             g_config[ConfigKeysBoolean::FORCE_MONSTERTYPE_LOAD]);
+	return applyMonsterFiles(monsterFiles, reloading);
+}
+
+Monsters::MonsterFiles Monsters::readMonsterFiles(const std::unordered_set<std::string>& names, bool forceLoad)
+{
+	MonsterFiles monsterFiles;
 	pugi::xml_document doc;
 	pugi::xml_parse_result result = doc.load_file("data/monster/monsters.xml");
 	if (!result) {
 		printXMLError("Error - Monsters::loadFromXml", "data/monster/monsters.xml", result);
-		return false;
+		return monsterFiles;
 	}
 
-	loaded = true;
+	monsterFiles.valid = true;
 
 	for (auto& monsterNode : doc.child("monsters").children()) {
 		std::string name = boost::algorithm::to_lower_copy<std::string>(monsterNode.attribute("name").as_string());
 		std::string file = "data/monster/" + std::string{monsterNode.attribute("file").as_string()};
-		unloadedMonsters.emplace(name, file);
+		monsterFiles.files.emplace(name, file);
 	}
 
-	const bool& forceLoad = g_config[ConfigKeysBoolean::FORCE_MONSTERTYPE_LOAD];
+	auto& toLoad = monsterFiles.toLoad;
+	for (const auto& [monsterName, file] : monsterFiles.files) {
+		if (forceLoad || names.contains(monsterName)) {
+			toLoad.emplace_back(monsterName, file);
+		}
+	}
 
-	for (const auto& [monsterName, file] : unloadedMonsters) {
-		if (forceLoad || (reloading && monsters.find(monsterName) != monsters.end())) {
-			loadMonster(file, monsterName, reloading);
+	// the files are parsed on every core, only building the monster types from them touches shared state
+	auto& documents = monsterFiles.documents = std::vector<pugi::xml_document>(toLoad.size());
+	auto& results = monsterFiles.results = std::vector<pugi::xml_parse_result>(toLoad.size());
+	std::atomic<size_t> nextFile{0};
+	auto parse = [&]() {
+		for (size_t i = nextFile++; i < toLoad.size(); i = nextFile++) {
+			results[i] = documents[i].load_file(toLoad[i].second.c_str());
 		}
+	};
+
+	const size_t threadCount =
+	    std::clamp<size_t>(std::thread::hardware_concurrency(), 1, std::max<size_t>(1, toLoad.size()));
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount - 1);
+	for (size_t i = 1; i < threadCount; ++i) {
+		threads.emplace_back(parse);
 	}
+	parse();
 
-	return true;
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	return monsterFiles;
 }
 
-bool Monsters::reload()
+std::unordered_set<std::string> Monsters::getLoadedNames() const
 {
-	loaded = false;
+	std::unordered_set<std::string> names;
+	names.reserve(monsterTypeIds.size());
+	for (const auto& it : monsterTypeIds) {
+		names.insert(it.first);
+	}
+	return names;
+}
 
-	scriptInterface.reset();
+bool Monsters::applyMonsterFiles(MonsterFiles& monsterFiles, bool reloading)
+{
+	if (!monsterFiles.valid) {
+		return false;
+	}
+
+	if (reloading) {
+		scriptInterface.reset();
+	}
 
-	return loadFromXml(true);
+	loaded = true;
+	unloadedMonsters = std::move(monsterFiles.files);
+
+	for (size_t i = 0; i < monsterFiles.toLoad.size(); ++i) {
+		const auto& [monsterName, file] = monsterFiles.toLoad[i];
+		if (!monsterFiles.results[i]) {
+			printXMLError("Error - Monsters::loadMonster", file, monsterFiles.results[i]);
+			continue;
+		}
+		loadMonster(monsterFiles.documents[i], file, monsterName);
+	}
+	return true;
 }
 
+bool Monsters::reload() { return loadFromXml(true); }
+
 ConditionDamage* Monsters::getDamageCondition(ConditionType_t conditionType, int32_t maxDamage, int32_t minDamage,
                                               int32_t startDamage, uint32_t tickInterval)
 {
@@ -117,13 +324,13 @@ bool Monsters::deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, co
 		uint32_t chance = pugi::cast<uint32_t>(attr.value());
 		if (chance > 100) {
 			chance = 100;
-			std::cout << "[Warning - Monsters::deserializeSpell] " << description
-			          << " - Chance value out of bounds for spell: " << name << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::deserializeSpell", "{} - Chance value out of bounds for spell: {}",
+			            description, name);
 		}
 		sb.chance = chance;
 	} else if (boost::algorithm::to_lower_copy<std::string>(name) != "melee") {
-		std::cout << "[Warning - Monsters::deserializeSpell] " << description
-		          << " - Missing chance value on non-melee spell: " << name << std::endl;
+		Logger::log(LOG_WARNING, "Monsters::deserializeSpell", "{} - Missing chance value on non-melee spell: {}",
+		            description, name);
 	}
 
 	if ((attr = node.attribute("range"))) {
@@ -352,8 +559,8 @@ bool Monsters::deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, co
 				}
 
 				if (minSpeedChange == 0) {
-					std::cout << "[Error - Monsters::deserializeSpell] - " << description
-					          << " - missing speedchange/minspeedchange value" << std::endl;
+					Logger::log(LOG_ERROR, "Monsters::deserializeSpell",
+					            "{} - missing speedchange/minspeedchange value", description);
 					return false;
 				}
 
@@ -363,8 +570,8 @@ bool Monsters::deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, co
 			}
 
 			if (minSpeedChange < -1000) {
-				std::cout << "[Warning - Monsters::deserializeSpell] - " << description
-				          << " - you cannot reduce a creatures speed below -1000 (100%)" << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::deserializeSpell",
+				            "{} - you cannot reduce a creatures speed below -1000 (100%)", description);
 				minSpeedChange = -1000;
 			}
 
@@ -496,8 +703,7 @@ bool Monsters::deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, co
 		} else if (tmpName == "effect") {
 			//
 		} else {
-			std::cout << "[Error - Monsters::deserializeSpell] - " << description << " - Unknown spell name: " << name
-			          << std::endl;
+			Logger::log(LOG_ERROR, "Monsters::deserializeSpell", "{} - Unknown spell name: {}", description, name);
 			return false;
 		}
 
@@ -514,8 +720,8 @@ bool Monsters::deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, co
 						if (shoot != CONST_ANI_NONE) {
 							combat->setParam(COMBAT_PARAM_DISTANCEEFFECT, shoot);
 						} else {
-							std::cout << "[Warning - Monsters::deserializeSpell] " << description
-							          << " - Unknown shootEffect: " << attr.as_string() << std::endl;
+							Logger::log(LOG_WARNING, "Monsters::deserializeSpell", "{} - Unknown shootEffect: {}",
+							            description, attr.as_string());
 						}
 					}
 				} else if (caseInsensitiveEqual(value, "areaeffect")) {
@@ -525,13 +731,13 @@ bool Monsters::deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, co
 						if (effect != CONST_ME_NONE) {
 							combat->setParam(COMBAT_PARAM_EFFECT, effect);
 						} else {
-							std::cout << "[Warning - Monsters::deserializeSpell] " << description
-							          << " - Unknown areaEffect: " << attr.as_string() << std::endl;
+							Logger::log(LOG_WARNING, "Monsters::deserializeSpell", "{} - Unknown areaEffect: {}",
+							            description, attr.as_string());
 						}
 					}
 				} else {
-					std::cout << "[Warning - Monsters::deserializeSpells] Effect type \"" << attr.as_string()
-					          << "\" does not exist." << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::deserializeSpells", "Effect type \"{}\" does not exist.",
+					            attr.as_string());
 				}
 			}
 		}
@@ -586,7 +792,8 @@ bool Monsters::deserializeSpell(MonsterSpell* spell, spellBlock_t& sb, const std
 		std::unique_ptr<CombatSpell> combatSpellPtr(new CombatSpell(nullptr, spell->needTarget, spell->needDirection));
 		if (!combatSpellPtr->loadScript(
 		        fmt::format("data/{}/scripts/{}", g_spells->getScriptBaseName(), spell->scriptName))) {
-			std::cout << "cannot find file" << std::endl;
+			Logger::log(LOG_ERROR, "Monsters::deserializeSpell", "Can not load the script of spell {}",
+			            spell->scriptName);
 			return false;
 		}
 
@@ -657,8 +864,7 @@ bool Monsters::deserializeSpell(MonsterSpell* spell, spellBlock_t& sb, const std
 			combat->setOrigin(ORIGIN_MELEE);
 		} else if (tmpName == "combat") {
 			if (spell->combatType == COMBAT_UNDEFINEDDAMAGE) {
-				std::cout << "[Warning - Monsters::deserializeSpell] - " << description
-				          << " - spell has undefined damage" << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::deserializeSpell", "{} - spell has undefined damage", description);
 				combat->setParam(COMBAT_PARAM_TYPE, COMBAT_PHYSICALDAMAGE);
 			}
 
@@ -681,15 +887,15 @@ bool Monsters::deserializeSpell(MonsterSpell* spell, spellBlock_t& sb, const std
 			if (spell->minSpeedChange != 0) {
 				minSpeedChange = spell->minSpeedChange;
 			} else {
-				std::cout << "[Error - Monsters::deserializeSpell] - " << description
-				          << " - missing speedchange/minspeedchange value" << std::endl;
+				Logger::log(LOG_ERROR, "Monsters::deserializeSpell", "{} - missing speedchange/minspeedchange value",
+				            description);
 				delete spell;
 				return false;
 			}
 
 			if (minSpeedChange < -1000) {
-				std::cout << "[Warning - Monsters::deserializeSpell] - " << description
-				          << " - you cannot reduce a creatures speed below -1000 (100%)" << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::deserializeSpell",
+				            "{} - you cannot reduce a creatures speed below -1000 (100%)", description);
 				minSpeedChange = -1000;
 			}
 
@@ -756,16 +962,16 @@ bool Monsters::deserializeSpell(MonsterSpell* spell, spellBlock_t& sb, const std
 			combat->setParam(COMBAT_PARAM_CREATEITEM, ITEM_ENERGYFIELD_PVP);
 		} else if (tmpName == "condition") {
 			if (spell->conditionType == CONDITION_NONE) {
-				std::cout << "[Error - Monsters::deserializeSpell] - " << description
-				          << " - Condition is not set for: " << spell->name << std::endl;
+				Logger::log(LOG_ERROR, "Monsters::deserializeSpell", "{} - Condition is not set for: {}", description,
+				            spell->name);
 			}
 		} else if (tmpName == "strength") {
 			//
 		} else if (tmpName == "effect") {
 			//
 		} else {
-			std::cout << "[Error - Monsters::deserializeSpell] - " << description
-			          << " - Unknown spell name: " << spell->name << std::endl;
+			Logger::log(LOG_ERROR, "Monsters::deserializeSpell", "{} - Unknown spell name: {}", description,
+			            spell->name);
 		}
 
 		if (spell->needTarget) {
@@ -789,41 +995,36 @@ bool Monsters::deserializeSpell(MonsterSpell* spell, spellBlock_t& sb, const std
 	return true;
 }
 
-MonsterType* Monsters::loadMonster(const std::string& file, const std::string& monsterName, bool reloading /*= false*/)
+MonsterType* Monsters::loadMonster(const std::string& file, const std::string& monsterName)
 {
-	MonsterType* mType = nullptr;
-
 	pugi::xml_document doc;
 	pugi::xml_parse_result result = doc.load_file(file.c_str());
 	if (!result) {
 		printXMLError("Error - Monsters::loadMonster", file, result);
 		return nullptr;
 	}
+	return loadMonster(doc, file, monsterName);
+}
+
+MonsterType* Monsters::loadMonster(const pugi::xml_document& doc, const std::string& file,
+                                   const std::string& monsterName)
+{
+	MonsterType* mType = nullptr;
 
 	pugi::xml_node monsterNode = doc.child("monster");
 	if (!monsterNode) {
-		std::cout << "[Error - Monsters::loadMonster] Missing monster node in: " << file << std::endl;
+		Logger::log(LOG_ERROR, "Monsters::loadMonster", "Missing monster node in: {}", file);
 		return nullptr;
 	}
 
 	pugi::xml_attribute attr;
 	if (!(attr = monsterNode.attribute("name"))) {
-		std::cout << "[Error - Monsters::loadMonster] Missing name in: " << file << std::endl;
+		Logger::log(LOG_ERROR, "Monsters::loadMonster", "Missing name in: {}", file);
 		return nullptr;
 	}
 
-	if (reloading) {
-		auto it = monsters.find(boost::algorithm::to_lower_copy<std::string>(monsterName));
-		if (it != monsters.end()) {
-			mType = &it->second;
-			mType->info = {};
-		}
-	}
-
-	if (!mType) {
-		mType = &monsters[boost::algorithm::to_lower_copy<std::string>(monsterName)];
-		mType->info = {};
-	}
+	mType = addMonsterType(monsterName);
+	mType->info = {};
 
 	mType->name = attr.as_string();
 
@@ -847,8 +1048,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 		} else if (tmpStrValue == "energy" || tmpInt == 5) {
 			mType->info.race = RACE_ENERGY;
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Unknown race type " << attr.as_string() << ". " << file
-			          << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown race type {}. {}", attr.as_string(), file);
 		}
 	}
 
@@ -874,7 +1074,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			mType->raceId = raceId;
 			registerBestiaryMonster(mType);
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Invalid raceId 0. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Invalid raceId 0. {}", file);
 		}
 	} else {
 		mType->raceId = 0;
@@ -895,8 +1095,8 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			mType->info.creatureSayEvent = scriptInterface->getEvent("onCreatureSay");
 			mType->info.thinkEvent = scriptInterface->getEvent("onThink");
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Can not load script: " << script << std::endl;
-			std::cout << scriptInterface->getLastLuaError() << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Can not load script: {}", script);
+			Logger::log(LOG_WARNING, "", "{}", scriptInterface->getLastLuaError());
 		}
 	}
 
@@ -905,19 +1105,18 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 		if ((attr = node.attribute("now"))) {
 			mType->info.health = pugi::cast<int32_t>(attr.value());
 		} else {
-			std::cout << "[Error - Monsters::loadMonster] Missing health now. " << file << std::endl;
+			Logger::log(LOG_ERROR, "Monsters::loadMonster", "Missing health now. {}", file);
 		}
 
 		if ((attr = node.attribute("max"))) {
 			mType->info.healthMax = pugi::cast<int32_t>(attr.value());
 		} else {
-			std::cout << "[Error - Monsters::loadMonster] Missing health max. " << file << std::endl;
+			Logger::log(LOG_ERROR, "Monsters::loadMonster", "Missing health max. {}", file);
 		}
 
 		if (mType->info.health > mType->info.healthMax) {
 			mType->info.health = mType->info.healthMax;
-			std::cout << "[Warning - Monsters::loadMonster] Health now is greater than health max." << file
-			          << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Health now is greater than health max. {}", file);
 		}
 	}
 
@@ -950,8 +1149,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			} else if (caseInsensitiveEqual(attrName, "staticattack")) {
 				uint32_t staticAttack = pugi::cast<uint32_t>(attr.value());
 				if (staticAttack > 100) {
-					std::cout << "[Warning - Monsters::loadMonster] staticattack greater than 100. " << file
-					          << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster", "staticattack greater than 100. {}", file);
 					staticAttack = 100;
 				}
 
@@ -964,7 +1162,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 				int32_t targetDistance = pugi::cast<int32_t>(attr.value());
 				if (targetDistance < 1) {
 					targetDistance = 1;
-					std::cout << "[Warning - Monsters::loadMonster] targetdistance less than 1. " << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster", "targetdistance less than 1. {}", file);
 				}
 				mType->info.targetDistance = targetDistance;
 			} else if (caseInsensitiveEqual(attrName, "runonhealth")) {
@@ -978,8 +1176,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			} else if (caseInsensitiveEqual(attrName, "canwalkonpoison")) {
 				mType->info.canWalkOnPoison = attr.as_bool();
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Unknown flag attribute: " << attrName << ". " << file
-				          << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown flag attribute: {}. {}", attrName, file);
 			}
 		}
 
@@ -990,28 +1187,26 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 		}
 	}
 	if (mType->info.manaCost == 0 && (mType->info.isSummonable || mType->info.isConvinceable)) {
-		std::cout
-		    << "[Warning - Monsters::loadMonster] manaCost missing or zero on monster with summonable and/or convinceable flags: "
-		    << file << std::endl;
+		Logger::log(LOG_WARNING, "Monsters::loadMonster",
+		            "manaCost missing or zero on monster with summonable and/or convinceable flags: {}", file);
 	}
 
 	if ((node = monsterNode.child("targetchange"))) {
 		if ((attr = node.attribute("speed")) || (attr = node.attribute("interval"))) {
 			mType->info.changeTargetSpeed = pugi::cast<uint32_t>(attr.value());
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Missing targetchange speed. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing targetchange speed. {}", file);
 		}
 
 		if ((attr = node.attribute("chance"))) {
 			int32_t chance = pugi::cast<int32_t>(attr.value());
 			if (chance > 100) {
 				chance = 100;
-				std::cout << "[Warning - Monsters::loadMonster] targetchange chance value out of bounds. " << file
-				          << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "targetchange chance value out of bounds. {}", file);
 			}
 			mType->info.changeTargetChance = chance;
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Missing targetchange chance. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing targetchange chance. {}", file);
 		}
 	}
 
@@ -1041,7 +1236,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 		} else if ((attr = node.attribute("typeex"))) {
 			mType->info.outfit.lookTypeEx = pugi::cast<uint16_t>(attr.value());
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Missing look type/typeex. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing look type/typeex. {}", file);
 		}
 
 		if ((attr = node.attribute("corpse"))) {
@@ -1055,7 +1250,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			if (deserializeSpell(attackNode, sb, monsterName)) {
 				mType->info.attackSpells.emplace_back(std::move(sb));
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Cant load spell. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Cant load spell. {}", file);
 			}
 		}
 	}
@@ -1074,7 +1269,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			if (deserializeSpell(defenseNode, sb, monsterName)) {
 				mType->info.defenseSpells.emplace_back(std::move(sb));
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Cant load spell. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Cant load spell. {}", file);
 			}
 		}
 	}
@@ -1122,8 +1317,8 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 				} else if (tmpStrValue == "bleed") {
 					mType->info.conditionImmunities |= CONDITION_BLEEDING;
 				} else {
-					std::cout << "[Warning - Monsters::loadMonster] Unknown immunity name " << attr.as_string() << ". "
-					          << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown immunity name {}. {}", attr.as_string(),
+					            file);
 				}
 			} else if ((attr = immunityNode.attribute("physical"))) {
 				if (attr.as_bool()) {
@@ -1195,7 +1390,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 					mType->info.conditionImmunities |= CONDITION_INVISIBLE;
 				}
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Unknown immunity. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown immunity. {}", file);
 			}
 		}
 	}
@@ -1204,18 +1399,18 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 		if ((attr = node.attribute("speed")) || (attr = node.attribute("interval"))) {
 			mType->info.yellSpeedTicks = pugi::cast<uint32_t>(attr.value());
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Missing voices speed. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing voices speed. {}", file);
 		}
 
 		if ((attr = node.attribute("chance"))) {
 			uint32_t chance = pugi::cast<uint32_t>(attr.value());
 			if (chance > 100) {
 				chance = 100;
-				std::cout << "[Warning - Monsters::loadMonster] yell chance value out of bounds. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "yell chance value out of bounds. {}", file);
 			}
 			mType->info.yellChance = chance;
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Missing voices chance. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing voices chance. {}", file);
 		}
 
 		for (auto& voiceNode : node.children()) {
@@ -1223,7 +1418,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			if ((attr = voiceNode.attribute("sentence"))) {
 				vb.text = attr.as_string();
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Missing voice sentence. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing voice sentence. {}", file);
 			}
 
 			if ((attr = voiceNode.attribute("yell"))) {
@@ -1241,7 +1436,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			if (loadLootItem(lootNode, lootBlock)) {
 				mType->info.lootItems.emplace_back(std::move(lootBlock));
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Cant load loot. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Cant load loot. {}", file);
 			}
 		}
 	}
@@ -1251,75 +1446,66 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			if ((attr = elementNode.attribute("physicalPercent"))) {
 				mType->info.elementMap[COMBAT_PHYSICALDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_PHYSICALDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"physical\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"physical\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("icePercent"))) {
 				mType->info.elementMap[COMBAT_ICEDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_ICEDAMAGE) {
-					std::cout << "[Warning - Monsters::loadMonster] Same element \"ice\" on immunity and element tags. "
-					          << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"ice\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("poisonPercent")) ||
 			           (attr = elementNode.attribute("earthPercent"))) {
 				mType->info.elementMap[COMBAT_EARTHDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_EARTHDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"earth\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"earth\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("firePercent"))) {
 				mType->info.elementMap[COMBAT_FIREDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_FIREDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"fire\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"fire\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("energyPercent"))) {
 				mType->info.elementMap[COMBAT_ENERGYDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_ENERGYDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"energy\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"energy\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("holyPercent"))) {
 				mType->info.elementMap[COMBAT_HOLYDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_HOLYDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"holy\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"holy\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("deathPercent"))) {
 				mType->info.elementMap[COMBAT_DEATHDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_DEATHDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"death\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"death\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("drownPercent"))) {
 				mType->info.elementMap[COMBAT_DROWNDAMAGE] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_DROWNDAMAGE) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"drown\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"drown\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("lifedrainPercent"))) {
 				mType->info.elementMap[COMBAT_LIFEDRAIN] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_LIFEDRAIN) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"lifedrain\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"lifedrain\" on immunity and element tags. {}", file);
 				}
 			} else if ((attr = elementNode.attribute("manadrainPercent"))) {
 				mType->info.elementMap[COMBAT_MANADRAIN] = pugi::cast<int32_t>(attr.value());
 				if (mType->info.damageImmunities & COMBAT_MANADRAIN) {
-					std::cout
-					    << "[Warning - Monsters::loadMonster] Same element \"manadrain\" on immunity and element tags. "
-					    << file << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster",
+					            "Same element \"manadrain\" on immunity and element tags. {}", file);
 				}
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Unknown element percent. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown element percent. {}", file);
 			}
 		}
 	}
@@ -1328,7 +1514,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 		if ((attr = node.attribute("maxSummons"))) {
 			mType->info.maxSummons = std::min<uint32_t>(pugi::cast<uint32_t>(attr.value()), 100);
 		} else {
-			std::cout << "[Warning - Monsters::loadMonster] Missing summons maxSummons. " << file << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing summons maxSummons. {}", file);
 		}
 
 		for (auto& summonNode : node.children()) {
@@ -1347,8 +1533,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 				chance = pugi::cast<int32_t>(attr.value());
 				if (chance > 100) {
 					chance = 100;
-					std::cout << "[Warning - Monsters::loadMonster] Summon chance value out of bounds. " << file
-					          << std::endl;
+					Logger::log(LOG_WARNING, "Monsters::loadMonster", "Summon chance value out of bounds. {}", file);
 				}
 			}
 
@@ -1364,9 +1549,8 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 							masterEffect =
 							    getMagicEffect(boost::algorithm::to_lower_copy<std::string>(attr.as_string()));
 							if (masterEffect == CONST_ME_NONE) {
-								std::cout
-								    << "[Warning - Monsters::loadMonster] Summon master effect - Unknown masterEffect: "
-								    << attr.as_string() << std::endl;
+								Logger::log(LOG_WARNING, "Monsters::loadMonster",
+								            "Summon master effect - Unknown masterEffect: {}", attr.as_string());
 							}
 						}
 					} else if (caseInsensitiveEqual(value, "effect")) {
@@ -1374,13 +1558,13 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 							effect = getMagicEffect(boost::algorithm::to_lower_copy<std::string>(attr.as_string()));
 							if (effect == CONST_ME_NONE) {
 								effect = CONST_ME_TELEPORT;
-								std::cout << "[Warning - Monsters::loadMonster] Summon effect - Unknown effect: "
-								          << attr.as_string() << std::endl;
+								Logger::log(LOG_WARNING, "Monsters::loadMonster", "Summon effect - Unknown effect: {}",
+								            attr.as_string());
 							}
 						}
 					} else {
-						std::cout << "[Warning - Monsters::loadMonster] Summon effect type \"" << attr.as_string()
-						          << "\" does not exist." << std::endl;
+						Logger::log(LOG_WARNING, "Monsters::loadMonster", "Summon effect type \"{}\" does not exist.",
+						            attr.as_string());
 					}
 				}
 			}
@@ -1400,7 +1584,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 				sb.force = force;
 				mType->info.summons.emplace_back(sb);
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Missing summon name. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing summon name. {}", file);
 			}
 		}
 	}
@@ -1410,7 +1594,7 @@ MonsterType* Monsters::loadMonster(const std::string& file, const std::string& m
 			if ((attr = eventNode.attribute("name"))) {
 				mType->info.scripts.emplace_back(attr.as_string());
 			} else {
-				std::cout << "[Warning - Monsters::loadMonster] Missing name for script event. " << file << std::endl;
+				Logger::log(LOG_WARNING, "Monsters::loadMonster", "Missing name for script event. {}", file);
 			}
 		}
 	}
@@ -1428,7 +1612,7 @@ bool MonsterType::loadCallback(LuaScriptInterface* scriptInterface)
 {
 	int32_t id = scriptInterface->getEvent();
 	if (id == -1) {
-		std::cout << "[Warning - MonsterType::loadCallback] Event not found. " << std::endl;
+		Logger::log(LOG_WARNING, "MonsterType::loadCallback", "Event not found.");
 		return false;
 	}
 
@@ -1455,7 +1639,7 @@ bool Monsters::loadLootItem(const pugi::xml_node& node, LootBlock& lootBlock)
 		const ItemType& it = Item::items.getItemType(id);
 
 		if (it.name.empty()) {
-			std::cout << "[Warning - Monsters::loadMonster] Unknown loot item id \"" << id << "\". " << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown loot item id \"{}\".", id);
 			return false;
 		}
 
@@ -1463,17 +1647,17 @@ bool Monsters::loadLootItem(const pugi::xml_node& node, LootBlock& lootBlock)
 
 	} else if ((attr = node.attribute("name"))) {
 		auto name = attr.as_string();
-		auto ids = Item::items.nameToItems.equal_range(boost::algorithm::to_lower_copy<std::string>(name));
+		auto ids = Item::items.nameToItems.equal_range(std::string_view{name});
 
 		if (ids.first == Item::items.nameToItems.cend()) {
-			std::cout << "[Warning - Monsters::loadMonster] Unknown loot item \"" << name << "\". " << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Unknown loot item \"{}\".", name);
 			return false;
 		}
 
 		uint32_t id = ids.first->second;
 
 		if (std::next(ids.first) != ids.second) {
-			std::cout << "[Warning - Monsters::loadMonster] Non-unique loot item \"" << name << "\". " << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Non-unique loot item \"{}\".", name);
 			return false;
 		}
 
@@ -1494,8 +1678,8 @@ bool Monsters::loadLootItem(const pugi::xml_node& node, LootBlock& lootBlock)
 	if ((attr = node.attribute("chance")) || (attr = node.attribute("chance1"))) {
 		int32_t lootChance = pugi::cast<int32_t>(attr.value());
 		if (lootChance > static_cast<int32_t>(MAX_LOOTCHANCE)) {
-			std::cout << "[Warning - Monsters::loadMonster] Invalid \"chance\" " << lootChance
-			          << " used for loot, the max is " << MAX_LOOTCHANCE << ". " << std::endl;
+			Logger::log(LOG_WARNING, "Monsters::loadMonster", "Invalid \"chance\" {} used for loot, the max is {}.",
+			            lootChance, MAX_LOOTCHANCE);
 		}
 		lootBlock.chance = std::min<int32_t>(MAX_LOOTCHANCE, lootChance);
 	} else {
@@ -1538,39 +1722,50 @@ void Monsters::loadLootContainer(const pugi::xml_node& node, LootBlock& lBlock)
 	}
 }
 
-MonsterType* Monsters::getMonsterType(const std::string& name, bool loadFromFile /*= true */)
+MonsterType* Monsters::getMonsterType(std::string_view name, bool loadFromFile /*= true */)
 {
-	std::string lowerCaseName = boost::algorithm::to_lower_copy<std::string>(name);
-
-	auto it = monsters.find(lowerCaseName);
-	if (it == monsters.end()) {
+	auto it = monsterTypeIds.find(name);
+	if (it == monsterTypeIds.end()) {
 		if (!loadFromFile) {
 			return nullptr;
 		}
 
-		auto it2 = unloadedMonsters.find(lowerCaseName);
+		auto it2 = unloadedMonsters.find(name);
 		if (it2 == unloadedMonsters.end()) {
 			return nullptr;
 		}
 
-		return loadMonster(it2->second, name);
+		return loadMonster(it2->second, std::string{name});
 	}
-	return &it->second;
+	return &monsterTypes[it->second - 1];
 }
 
 MonsterType* Monsters::getMonsterType(uint32_t raceId)
 {
 	auto it = bestiaryMonsters.find(raceId);
 	if (it != bestiaryMonsters.end()) {
-		return getMonsterType(it->second);
+		return getMonsterTypeById(it->second);
 	}
 
 	return nullptr;
 }
 
+MonsterType* Monsters::addMonsterType(std::string_view name)
+{
+	auto it = monsterTypeIds.find(name);
+	if (it != monsterTypeIds.end()) {
+		return &monsterTypes[it->second - 1];
+	}
+
+	MonsterType& mType = monsterTypes.emplace_back();
+	mType.typeId = static_cast<uint32_t>(monsterTypes.size());
+	monsterTypeIds.emplace(boost::algorithm::to_lower_copy(std::string{name}), mType.typeId);
+	return &mType;
+}
+
 bool Monsters::registerBestiaryMonster(const MonsterType* mType)
 {
-	auto [it, success] = bestiaryMonsters.insert_or_assign(mType->raceId, mType->name);
+	auto [it, success] = bestiaryMonsters.insert_or_assign(mType->raceId, mType->typeId);
 	if (!success) {
 		/* std::cout << "[Warning - Monsters::registerBestiaryMonster] Monster raceId " << mType->raceId
 		          << " already exists but was overwritten for the monster " << mType->name << ". " << std::endl;*/
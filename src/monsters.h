@@ -33,6 +33,23 @@ struct LootBlock
 	}
 };
 
+// loot blocks flattened in pre-order with the item type resolved, an entry is followed by its child loot
+struct CompiledLootEntry
+{
+	std::string text;
+	uint32_t chance;
+	uint32_t countmin;
+	uint32_t countmax;
+	int32_t subType;
+	int32_t actionId;
+	// one past the last entry of the child loot
+	uint32_t end;
+	uint16_t id;
+	uint16_t stackSize;
+	bool stackable;
+	bool fluidContainer;
+};
+
 class Loot
 {
 public:
@@ -48,6 +65,8 @@ public:
 struct summonBlock_t
 {
 	std::string name;
+	// resolved from name on first use
+	MonsterType* mType = nullptr;
 	uint32_t chance;
 	uint32_t speed;
 	uint32_t max;
@@ -86,6 +105,23 @@ struct spellBlock_t
 	bool isMelee = false;
 };
 
+// the spells of a list that can be due at each think of one tick cycle, so a think only looks at those
+class SpellSchedule
+{
+public:
+	// indices of the spells due once the ticks reach ticks, nullptr if ticks is outside the cycle
+	const std::vector<uint16_t>* getDueSpells(const std::vector<spellBlock_t>& spells, uint32_t interval,
+	                                          uint32_t ticks);
+	// every timed spell has been due once the ticks reach this
+	uint32_t getCycleTicks() const { return cycleTicks; }
+
+private:
+	// indexed by ticks / interval, melee spells are in every step since they run on their own clock
+	std::vector<std::vector<uint16_t>> steps;
+	uint32_t interval = 0;
+	uint32_t cycleTicks = 0;
+};
+
 struct voiceBlock_t
 {
 	std::string text;
@@ -103,9 +139,14 @@ class MonsterType
 		std::vector<voiceBlock_t> voiceVector;
 
 		std::vector<LootBlock> lootItems;
+		// built from lootItems on first use, cleared whenever they change
+		std::vector<CompiledLootEntry> lootTable;
 		std::vector<std::string> scripts;
 		std::vector<spellBlock_t> attackSpells;
 		std::vector<spellBlock_t> defenseSpells;
+		// built on first use, reset whenever the spells change
+		SpellSchedule attackSchedule;
+		SpellSchedule defenseSchedule;
 		std::vector<summonBlock_t> summons;
 
 		Skulls_t skull = SKULL_NONE;
@@ -171,10 +212,19 @@ public:
 	std::string name;
 	std::string nameDescription;
 	uint32_t raceId;
+	// dense id given when the type is first added, see Monsters::getMonsterTypeById
+	uint32_t typeId = 0;
 
 	MonsterInfo info;
 
 	void loadLoot(MonsterType* monsterType, LootBlock lootBlock);
+
+	// rolls the loot into corpse, false if an item could not be created
+	bool createLoot(Container* corpse);
+
+private:
+	void compileLoot();
+	bool createLootItem(Container* container, uint32_t index, uint64_t rate);
 };
 
 class MonsterSpell
@@ -231,30 +281,69 @@ public:
 	Monsters(const Monsters&) = delete;
 	Monsters& operator=(const Monsters&) = delete;
 
+	// what a load reads from the monster files, nothing else is touched while reading so any thread may do it
+	struct MonsterFiles
+	{
+		std::unordered_map<std::string, std::string, CaseInsensitiveHash, CaseInsensitiveEqual> files;
+		// name and file of the types built from documents
+		std::vector<std::pair<std::string, std::string>> toLoad;
+		std::vector<pugi::xml_document> documents;
+		std::vector<pugi::xml_parse_result> results;
+		bool valid = false;
+	};
+
 	bool loadFromXml(bool reloading = false);
 	bool isLoaded() const { return loaded; }
 	bool reload();
 
-	MonsterType* getMonsterType(const std::string& name, bool loadFromFile = true);
+	// reads monsters.xml and parses the files of the names given, or of every monster with forceLoad
+	static MonsterFiles readMonsterFiles(const std::unordered_set<std::string>& names, bool forceLoad);
+	// the lower case names of the loaded types, the ones a reload reads again
+	std::unordered_set<std::string> getLoadedNames() const;
+	// builds the types from files read before, nothing changes if monsters.xml could not be read
+	bool applyMonsterFiles(MonsterFiles& monsterFiles, bool reloading);
+
+	MonsterType* getMonsterType(std::string_view name, bool loadFromFile = true);
 	MonsterType* getMonsterType(uint32_t raceId);
+	MonsterType* getMonsterTypeById(uint32_t typeId)
+	{
+		return typeId != 0 && typeId <= monsterTypes.size() ? &monsterTypes[typeId - 1] : nullptr;
+	}
+	// the type registered under name, added if there is none yet
+	MonsterType* addMonsterType(std::string_view name);
+
+	// calls f(lowerCaseName, monsterType) for every added type
+	template <typename F>
+	void forEachMonsterType(F&& f)
+	{
+		for (const auto& [name, typeId] : monsterTypeIds) {
+			f(name, monsterTypes[typeId - 1]);
+		}
+	}
+
 	bool deserializeSpell(MonsterSpell* spell, spellBlock_t& sb, const std::string& description = "");
 	bool registerBestiaryMonster(const MonsterType* mType);
 
 	std::unique_ptr<LuaScriptInterface> scriptInterface;
-	std::map<std::string, MonsterType> monsters;
 
 private:
 	ConditionDamage* getDamageCondition(ConditionType_t conditionType, int32_t maxDamage, int32_t minDamage,
 	                                    int32_t startDamage, uint32_t tickInterval);
 	bool deserializeSpell(const pugi::xml_node& node, spellBlock_t& sb, const std::string& description = "");
 
-	MonsterType* loadMonster(const std::string& file, const std::string& monsterName, bool reloading = false);
+	MonsterType* loadMonster(const std::string& file, const std::string& monsterName);
+	MonsterType* loadMonster(const pugi::xml_document& doc, const std::string& file, const std::string& monsterName);
 
 	void loadLootContainer(const pugi::xml_node& node, LootBlock&);
 	bool loadLootItem(const pugi::xml_node& node, LootBlock&);
 
-	std::map<std::string, std::string> unloadedMonsters;
-	std::unordered_map<uint32_t, std::string> bestiaryMonsters;
+	std::unordered_map<std::string, std::string, CaseInsensitiveHash, CaseInsensitiveEqual> unloadedMonsters;
+	// types are never removed, so pointers and ids stay valid across reloads
+	std::deque<MonsterType> monsterTypes;
+	// lower case name to type id, looked up ignoring case
+	std::unordered_map<std::string, uint32_t, CaseInsensitiveHash, CaseInsensitiveEqual> monsterTypeIds;
+	// race id to type id
+	std::unordered_map<uint32_t, uint32_t> bestiaryMonsters;
 
 	bool loaded = false;
 };
@@ -11,6 +11,8 @@
 bool Mounts::reload()
 {
 	mounts.clear();
+	mountsById.clear();
+	mountsByClientId.clear();
 	return loadFromXml();
 }
 
@@ -31,7 +33,7 @@ bool Mounts::loadFromXml()
 			continue;
 		}
 
-		if (getMountByID(nodeId)) {
+		if (std::any_of(mounts.begin(), mounts.end(), [nodeId](const Mount& mount) { return mount.id == nodeId; })) {
 			std::cout << "[Notice - Mounts::loadFromXml] Duplicate mount with id: " << nodeId << std::endl;
 			continue;
 		}
@@ -42,14 +44,27 @@ bool Mounts::loadFromXml()
 		    mountNode.attribute("premium").as_bool());
 	}
 	mounts.shrink_to_fit();
+
+	for (Mount& mount : mounts) {
+		if (mount.id >= mountsById.size()) {
+			mountsById.resize(mount.id + 1);
+		}
+		if (mount.clientId >= mountsByClientId.size()) {
+			mountsByClientId.resize(mount.clientId + 1);
+		}
+
+		mountsById[mount.id] = &mount;
+		// the first mount with a client id wins, as with the scan before
+		if (!mountsByClientId[mount.clientId]) {
+			mountsByClientId[mount.clientId] = &mount;
+		}
+	}
 	return true;
 }
 
 Mount* Mounts::getMountByID(uint16_t id)
 {
-	auto it = std::find_if(mounts.begin(), mounts.end(), [id](const Mount& mount) { return mount.id == id; });
-
-	return it != mounts.end() ? &*it : nullptr;
+	return id < mountsById.size() ? mountsById[id] : nullptr;
 }
 
 Mount* Mounts::getMountByName(std::string_view name)
@@ -65,8 +80,5 @@ Mount* Mounts::getMountByName(std::string_view name)
 
 Mount* Mounts::getMountByClientID(uint16_t clientId)
 {
-	auto it = std::find_if(mounts.begin(), mounts.end(),
-	                       [clientId](const Mount& mount) { return mount.clientId == clientId; });
-
-	return it != mounts.end() ? &*it : nullptr;
+	return clientId < mountsByClientId.size() ? mountsByClientId[clientId] : nullptr;
 }
@@ -30,6 +30,9 @@ public:
 
 private:
 	std::vector<Mount> mounts;
+	// indexed by mount id and by client id, rebuilt on every load
+	std::vector<Mount*> mountsById;
+	std::vector<Mount*> mountsByClientId;
 };
 
 #endif // FS_MOUNTS_H
@@ -15,46 +15,44 @@ MoveEvents::MoveEvents() : scriptInterface("MoveEvents Interface") { scriptInter
 
 MoveEvents::~MoveEvents() { clear(false); }
 
-void MoveEvents::clearMap(MoveListMap& map, bool fromLua)
+void MoveEvents::clearMap(MoveListMap& map, const EventFilter& filter)
 {
-	for (auto it = map.begin(); it != map.end(); ++it) {
+	map.forEach([&filter](uint16_t, MoveEventList& moveEventList) {
 		for (int eventType = MOVE_EVENT_STEP_IN; eventType < MOVE_EVENT_LAST; ++eventType) {
-			auto& moveEvents = it->second.moveEvent[eventType];
+			auto& moveEvents = moveEventList.moveEvent[eventType];
 			for (auto find = moveEvents.begin(); find != moveEvents.end();) {
-				if (fromLua == find->fromLua) {
+				if (filter(*find)) {
 					find = moveEvents.erase(find);
 				} else {
 					++find;
 				}
 			}
 		}
-	}
+	});
 }
 
-void MoveEvents::clearPosMap(MovePosListMap& map, bool fromLua)
+void MoveEvents::clearPosMap(MovePosListMap& map, const EventFilter& filter)
 {
-	for (auto it = map.begin(); it != map.end(); ++it) {
+	map.forEach([&filter](PositionKey, MoveEventList& moveEventList) {
 		for (int eventType = MOVE_EVENT_STEP_IN; eventType < MOVE_EVENT_LAST; ++eventType) {
-			auto& moveEvents = it->second.moveEvent[eventType];
+			auto& moveEvents = moveEventList.moveEvent[eventType];
 			for (auto find = moveEvents.begin(); find != moveEvents.end();) {
-				if (fromLua == find->fromLua) {
+				if (filter(*find)) {
 					find = moveEvents.erase(find);
 				} else {
 					++find;
 				}
 			}
 		}
-	}
+	});
 }
 
-void MoveEvents::clear(bool fromLua)
+void MoveEvents::removeEvents(const EventFilter& filter)
 {
-	clearMap(itemIdMap, fromLua);
-	clearMap(actionIdMap, fromLua);
-	clearMap(uniqueIdMap, fromLua);
-	clearPosMap(positionMap, fromLua);
-
-	reInitState(fromLua);
+	clearMap(itemIdMap, filter);
+	clearMap(actionIdMap, filter);
+	clearMap(uniqueIdMap, filter);
+	clearPosMap(positionMap, filter);
 }
 
 LuaScriptInterface& MoveEvents::getScriptInterface() { return scriptInterface; }
@@ -280,13 +278,13 @@ bool MoveEvents::registerLuaEvent(MoveEvent* event)
 
 void MoveEvents::addEvent(MoveEvent moveEvent, uint16_t id, MoveListMap& map)
 {
-	auto it = map.find(id);
-	if (it == map.end()) {
+	MoveEventList* moveEvents = map.find(id);
+	if (!moveEvents) {
 		MoveEventList moveEventList;
 		moveEventList.moveEvent[moveEvent.getEventType()].push_back(std::move(moveEvent));
-		map[id] = moveEventList;
+		map.emplace(id, std::move(moveEventList));
 	} else {
-		std::list<MoveEvent>& moveEventList = it->second.moveEvent[moveEvent.getEventType()];
+		std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[moveEvent.getEventType()];
 		for (MoveEvent& existingMoveEvent : moveEventList) {
 			if (existingMoveEvent.getSlot() == moveEvent.getSlot()) {
 				std::cout << "[Warning - MoveEvents::addEvent] Duplicate move event found: " << id << std::endl;
@@ -335,9 +333,8 @@ MoveEvent* MoveEvents::getEvent(Item* item, MoveEvent_t eventType, slots_t slot)
 			break;
 	}
 
-	auto it = itemIdMap.find(item->getID());
-	if (it != itemIdMap.end()) {
-		std::list<MoveEvent>& moveEventList = it->second.moveEvent[eventType];
+	if (MoveEventList* moveEvents = itemIdMap.find(item->getID())) {
+		std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[eventType];
 		for (MoveEvent& moveEvent : moveEventList) {
 			if ((moveEvent.getSlot() & slotp) != 0) {
 				return &moveEvent;
@@ -349,12 +346,9 @@ MoveEvent* MoveEvents::getEvent(Item* item, MoveEvent_t eventType, slots_t slot)
 
 MoveEvent* MoveEvents::getEvent(Item* item, MoveEvent_t eventType)
 {
-	MoveListMap::iterator it;
-
 	if (item->hasAttribute(ITEM_ATTRIBUTE_UNIQUEID)) {
-		it = uniqueIdMap.find(item->getUniqueId());
-		if (it != uniqueIdMap.end()) {
-			std::list<MoveEvent>& moveEventList = it->second.moveEvent[eventType];
+		if (MoveEventList* moveEvents = uniqueIdMap.find(item->getUniqueId())) {
+			std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[eventType];
 			if (!moveEventList.empty()) {
 				return &(*moveEventList.begin());
 			}
@@ -362,18 +356,16 @@ MoveEvent* MoveEvents::getEvent(Item* item, MoveEvent_t eventType)
 	}
 
 	if (item->hasAttribute(ITEM_ATTRIBUTE_ACTIONID)) {
-		it = actionIdMap.find(item->getActionId());
-		if (it != actionIdMap.end()) {
-			std::list<MoveEvent>& moveEventList = it->second.moveEvent[eventType];
+		if (MoveEventList* moveEvents = actionIdMap.find(item->getActionId())) {
+			std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[eventType];
 			if (!moveEventList.empty()) {
 				return &(*moveEventList.begin());
 			}
 		}
 	}
 
-	it = itemIdMap.find(item->getID());
-	if (it != itemIdMap.end()) {
-		std::list<MoveEvent>& moveEventList = it->second.moveEvent[eventType];
+	if (MoveEventList* moveEvents = itemIdMap.find(item->getID())) {
+		std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[eventType];
 		if (!moveEventList.empty()) {
 			return &(*moveEventList.begin());
 		}
@@ -383,13 +375,16 @@ MoveEvent* MoveEvents::getEvent(Item* item, MoveEvent_t eventType)
 
 void MoveEvents::addEvent(MoveEvent moveEvent, const Position& pos, MovePosListMap& map)
 {
-	auto it = map.find(pos);
-	if (it == map.end()) {
-		MoveEventList moveEventList;
-		moveEventList.moveEvent[moveEvent.getEventType()].push_back(std::move(moveEvent));
-		map[pos] = moveEventList;
+	MoveEventList* moveEvents = map.find(getPositionKey(pos));
+	if (!moveEvents) {
+		map[getPositionKey(pos)].moveEvent[moveEvent.getEventType()].push_back(std::move(moveEvent));
+
+		// tiles loaded later are flagged by Map::setTile
+		if (Tile* tile = g_game.map.getTile(pos)) {
+			tile->setFlag(TILESTATE_MOVEEVENT);
+		}
 	} else {
-		std::list<MoveEvent>& moveEventList = it->second.moveEvent[moveEvent.getEventType()];
+		std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[moveEvent.getEventType()];
 		if (!moveEventList.empty()) {
 			std::cout << "[Warning - MoveEvents::addEvent] Duplicate move event found: " << pos << std::endl;
 		}
@@ -400,9 +395,12 @@ void MoveEvents::addEvent(MoveEvent moveEvent, const Position& pos, MovePosListM
 
 MoveEvent* MoveEvents::getEvent(const Tile* tile, MoveEvent_t eventType)
 {
-	auto it = positionMap.find(tile->getPosition());
-	if (it != positionMap.end()) {
-		std::list<MoveEvent>& moveEventList = it->second.moveEvent[eventType];
+	if (!tile->hasFlag(TILESTATE_MOVEEVENT)) {
+		return nullptr;
+	}
+
+	if (MoveEventList* moveEvents = positionMap.find(getPositionKey(tile->getPosition()))) {
+		std::list<MoveEvent>& moveEventList = moveEvents->moveEvent[eventType];
 		if (!moveEventList.empty()) {
 			return &(*moveEventList.begin());
 		}
@@ -418,7 +416,7 @@ uint32_t MoveEvents::onCreatureMove(Creature* creature, const Tile* tile, MoveEv
 
 	MoveEvent* moveEvent = getEvent(tile, eventType);
 	if (moveEvent) {
-		ret &= moveEvent->fireStepEvent(creature, nullptr, pos);
+		ret &= fireStepEvent(moveEvent, creature, nullptr, pos);
 	}
 
 	for (size_t i = tile->getFirstIndex(), j = tile->getLastIndex(); i < j; ++i) {
@@ -434,7 +432,7 @@ uint32_t MoveEvents::onCreatureMove(Creature* creature, const Tile* tile, MoveEv
 
 		moveEvent = getEvent(tileItem, eventType);
 		if (moveEvent) {
-			ret &= moveEvent->fireStepEvent(creature, tileItem, pos);
+			ret &= fireStepEvent(moveEvent, creature, tileItem, pos);
 		}
 	}
 	return ret;
@@ -475,12 +473,12 @@ uint32_t MoveEvents::onItemMove(Item* item, Tile* tile, bool isAdd)
 	uint32_t ret = 1;
 	MoveEvent* moveEvent = getEvent(tile, eventType1);
 	if (moveEvent) {
-		ret &= moveEvent->fireAddRemItem(item, nullptr, tile->getPosition());
+		ret &= fireAddRemItem(moveEvent, item, nullptr, tile->getPosition());
 	}
 
 	moveEvent = getEvent(item, eventType1);
 	if (moveEvent) {
-		ret &= moveEvent->fireAddRemItem(item, nullptr, tile->getPosition());
+		ret &= fireAddRemItem(moveEvent, item, nullptr, tile->getPosition());
 	}
 
 	for (size_t i = tile->getFirstIndex(), j = tile->getLastIndex(); i < j; ++i) {
@@ -496,12 +494,78 @@ uint32_t MoveEvents::onItemMove(Item* item, Tile* tile, bool isAdd)
 
 		moveEvent = getEvent(tileItem, eventType2);
 		if (moveEvent) {
-			ret &= moveEvent->fireAddRemItem(item, tileItem, tile->getPosition());
+			ret &= fireAddRemItem(moveEvent, item, tileItem, tile->getPosition());
 		}
 	}
 	return ret;
 }
 
+void MoveEvents::endBatch()
+{
+	assert(batchDepth != 0);
+	if (--batchDepth != 0) {
+		return;
+	}
+
+	// events queued by the scripts fired here run right away
+	std::vector<QueuedMoveEvent> events;
+	events.swap(queuedEvents);
+	for (const QueuedMoveEvent& event : events) {
+		if (event.creature) {
+			if (!event.creature->isRemoved()) {
+				event.moveEvent->fireStepEvent(event.creature, event.tileItem, event.pos);
+			}
+			g_game.ReleaseCreature(event.creature);
+		} else {
+			event.moveEvent->fireAddRemItem(event.item, event.tileItem, event.pos);
+			g_game.ReleaseItem(event.item);
+		}
+
+		if (event.tileItem) {
+			g_game.ReleaseItem(event.tileItem);
+		}
+	}
+}
+
+uint32_t MoveEvents::fireStepEvent(MoveEvent* moveEvent, Creature* creature, Item* tileItem, const Position& pos)
+{
+	if (batchDepth == 0) {
+		return moveEvent->fireStepEvent(creature, tileItem, pos);
+	}
+
+	queueEvent({moveEvent, creature, nullptr, tileItem, pos});
+	return 1;
+}
+
+uint32_t MoveEvents::fireAddRemItem(MoveEvent* moveEvent, Item* item, Item* tileItem, const Position& pos)
+{
+	if (batchDepth == 0) {
+		return moveEvent->fireAddRemItem(item, tileItem, pos);
+	}
+
+	queueEvent({moveEvent, nullptr, item, tileItem, pos});
+	return 1;
+}
+
+void MoveEvents::queueEvent(const QueuedMoveEvent& event)
+{
+	if (std::find(queuedEvents.begin(), queuedEvents.end(), event) != queuedEvents.end()) {
+		return;
+	}
+
+	// the things have to outlive the batch
+	if (event.creature) {
+		event.creature->incrementReferenceCounter();
+	} else {
+		event.item->incrementReferenceCounter();
+	}
+
+	if (event.tileItem) {
+		event.tileItem->incrementReferenceCounter();
+	}
+	queuedEvents.push_back(event);
+}
+
 MoveEvent::MoveEvent(LuaScriptInterface* interface) : Event(interface) {}
 
 std::string_view MoveEvent::getScriptEventName() const
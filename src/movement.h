@@ -6,6 +6,8 @@
 
 #include "baseevents.h"
 #include "creature.h"
+#include "flathashmap.h"
+#include "idmap.h"
 #include "item.h"
 #include "luascript.h"
 #include "vocation.h"
@@ -52,15 +54,35 @@ public:
 
 	MoveEvent* getEvent(Item* item, MoveEvent_t eventType);
 
+	// tiles at these positions get TILESTATE_MOVEEVENT so the tiles without any skip the position lookup
+	bool hasPositionEvents(const Position& pos) const { return positionMap.contains(getPositionKey(pos)); }
+
 	bool registerLuaEvent(MoveEvent* event);
 	bool registerLuaFunction(MoveEvent* event);
-	void clear(bool fromLua) override final;
+
+	// while a batch is open the step and add/remove item scripts are queued, each distinct call once, and fired when
+	// the outermost batch ends
+	void beginBatch() { ++batchDepth; }
+	void endBatch();
 
 private:
-	using MoveListMap = std::map<uint16_t, MoveEventList>;
-	using MovePosListMap = std::map<Position, MoveEventList>;
-	void clearMap(MoveListMap& map, bool fromLua);
-	void clearPosMap(MovePosListMap& map, bool fromLua);
+	struct QueuedMoveEvent
+	{
+		MoveEvent* moveEvent;
+		// set for step events, item for add/remove item events
+		Creature* creature;
+		Item* item;
+		Item* tileItem;
+		Position pos;
+
+		bool operator==(const QueuedMoveEvent&) const = default;
+	};
+
+	using MoveListMap = IdMap<MoveEventList>;
+	using MovePosListMap = FlatHashMap<PositionKey, MoveEventList>;
+	void clearMap(MoveListMap& map, const EventFilter& filter);
+	void clearPosMap(MovePosListMap& map, const EventFilter& filter);
+	void removeEvents(const EventFilter& filter) override final;
 
 	LuaScriptInterface& getScriptInterface() override;
 	std::string_view getScriptBaseName() const override;
@@ -74,14 +96,35 @@ private:
 
 	MoveEvent* getEvent(Item* item, MoveEvent_t eventType, slots_t slot);
 
+	uint32_t fireStepEvent(MoveEvent* moveEvent, Creature* creature, Item* tileItem, const Position& pos);
+	uint32_t fireAddRemItem(MoveEvent* moveEvent, Item* item, Item* tileItem, const Position& pos);
+	void queueEvent(const QueuedMoveEvent& event);
+
 	MoveListMap uniqueIdMap;
 	MoveListMap actionIdMap;
 	MoveListMap itemIdMap;
 	MovePosListMap positionMap;
 
+	std::vector<QueuedMoveEvent> queuedEvents;
+	uint32_t batchDepth = 0;
+
 	LuaScriptInterface scriptInterface;
 };
 
+extern MoveEvents* g_moveEvents;
+
+// batches the move events fired during an operation touching many tiles at once, like an area spell
+class MoveEventBatch
+{
+public:
+	MoveEventBatch() { g_moveEvents->beginBatch(); }
+	~MoveEventBatch() { g_moveEvents->endBatch(); }
+
+	// non-copyable
+	MoveEventBatch(const MoveEventBatch&) = delete;
+	MoveEventBatch& operator=(const MoveEventBatch&) = delete;
+};
+
 using StepFunction = std::function<uint32_t(Creature* creature, Item* item, const Position& pos)>;
 using MoveFunction = std::function<uint32_t(Item* item, Item* tileItem, const Position& pos)>;
 using EquipFunction =
@@ -7,6 +7,61 @@
 
 #include "container.h"
 #include "creature.h"
+#include "lockfree.h"
+
+namespace {
+
+const uint16_t NETWORKMESSAGE_MEDIUM_FREE_LIST_CAPACITY = 2048;
+const uint16_t NETWORKMESSAGE_LARGE_FREE_LIST_CAPACITY = 256;
+
+} // namespace
+
+NetworkMessage::NetworkMessage(const NetworkMessage& other) : info(other.info)
+{
+	reserve(other.capacity);
+	std::memcpy(buffer, other.buffer, other.capacity);
+}
+
+NetworkMessage& NetworkMessage::operator=(const NetworkMessage& other)
+{
+	if (this != &other) {
+		info = other.info;
+		reserve(other.capacity);
+		std::memcpy(buffer, other.buffer, other.capacity);
+	}
+	return *this;
+}
+
+void NetworkMessage::grow(size_t size)
+{
+	assert(size <= NETWORKMESSAGE_MAXSIZE);
+
+	uint8_t* newBuffer;
+	MsgSize_t newCapacity;
+	if (size <= NETWORKMESSAGE_MEDIUM_SIZE) {
+		newBuffer = static_cast<uint8_t*>(
+		    lockfreeAllocate<NETWORKMESSAGE_MEDIUM_SIZE, NETWORKMESSAGE_MEDIUM_FREE_LIST_CAPACITY>());
+		newCapacity = NETWORKMESSAGE_MEDIUM_SIZE;
+	} else {
+		newBuffer =
+		    static_cast<uint8_t*>(lockfreeAllocate<NETWORKMESSAGE_MAXSIZE, NETWORKMESSAGE_LARGE_FREE_LIST_CAPACITY>());
+		newCapacity = NETWORKMESSAGE_MAXSIZE;
+	}
+
+	std::memcpy(newBuffer, buffer, capacity);
+	releaseBuffer();
+	buffer = newBuffer;
+	capacity = newCapacity;
+}
+
+void NetworkMessage::releaseBuffer()
+{
+	if (capacity == NETWORKMESSAGE_MEDIUM_SIZE) {
+		lockfreeDeallocate<NETWORKMESSAGE_MEDIUM_SIZE, NETWORKMESSAGE_MEDIUM_FREE_LIST_CAPACITY>(buffer);
+	} else if (capacity == NETWORKMESSAGE_MAXSIZE) {
+		lockfreeDeallocate<NETWORKMESSAGE_MAXSIZE, NETWORKMESSAGE_LARGE_FREE_LIST_CAPACITY>(buffer);
+	}
+}
 
 std::string_view NetworkMessage::getString(uint16_t stringLen /* = 0*/)
 {
@@ -18,7 +73,7 @@ std::string_view NetworkMessage::getString(uint16_t stringLen /* = 0*/)
 		return "";
 	}
 
-	auto it = buffer.data() + info.position;
+	auto it = buffer + info.position;
 	info.position += stringLen;
 	return {reinterpret_cast<char*>(it), stringLen};
 }
@@ -35,12 +90,12 @@ Position NetworkMessage::getPosition()
 void NetworkMessage::addString(std::string_view value)
 {
 	size_t stringLen = value.length();
-	if (!canAdd(stringLen + 2) || stringLen > 8192) {
+	if (!prepareAdd(stringLen + 2) || stringLen > 8192) {
 		return;
 	}
 
 	add<uint16_t>(stringLen);
-	std::memcpy(buffer.data() + info.position, value.data(), stringLen);
+	std::memcpy(buffer + info.position, value.data(), stringLen);
 	info.position += stringLen;
 	info.length += stringLen;
 }
@@ -54,22 +109,22 @@ void NetworkMessage::addDouble(double value, uint8_t precision /* = 2*/)
 
 void NetworkMessage::addBytes(const char* bytes, size_t size)
 {
-	if (!canAdd(size) || size > 8192) {
+	if (!prepareAdd(size) || size > 8192) {
 		return;
 	}
 
-	std::memcpy(buffer.data() + info.position, bytes, size);
+	std::memcpy(buffer + info.position, bytes, size);
 	info.position += size;
 	info.length += size;
 }
 
 void NetworkMessage::addPaddingBytes(size_t n)
 {
-	if (!canAdd(n)) {
+	if (!prepareAdd(n)) {
 		return;
 	}
 
-	std::fill_n(buffer.data() + info.position, n, 0x33);
+	std::fill_n(buffer + info.position, n, 0x33);
 	info.length += n;
 }
 
@@ -12,6 +12,10 @@ class Player;
 struct Position;
 class RSA;
 
+// messages start in an inline buffer and move to a pooled block of the next size class once they outgrow it
+inline constexpr size_t NETWORKMESSAGE_INLINE_SIZE = 512;
+inline constexpr size_t NETWORKMESSAGE_MEDIUM_SIZE = 4096;
+
 class NetworkMessage
 {
 public:
@@ -43,9 +47,21 @@ public:
 	};
 
 	NetworkMessage() = default;
+	~NetworkMessage() { releaseBuffer(); }
+
+	NetworkMessage(const NetworkMessage& other);
+	NetworkMessage& operator=(const NetworkMessage& other);
 
 	void reset() { info = {}; }
 
+	// makes sure the first size bytes of the buffer can be written, size must not exceed NETWORKMESSAGE_MAXSIZE
+	void reserve(size_t size)
+	{
+		if (size > capacity) {
+			grow(size);
+		}
+	}
+
 	// simply read functions for incoming message
 	uint8_t getByte()
 	{
@@ -68,7 +84,7 @@ public:
 		}
 
 		T value;
-		std::memcpy(&value, buffer.data() + info.position, sizeof(T));
+		std::memcpy(&value, buffer + info.position, sizeof(T));
 		info.position += sizeof(T);
 		return value;
 	}
@@ -82,7 +98,7 @@ public:
 	// simply write functions for outgoing message
 	void addByte(uint8_t value)
 	{
-		if (!canAdd(1)) {
+		if (!prepareAdd(1)) {
 			return;
 		}
 
@@ -93,11 +109,11 @@ public:
 	template <typename T>
 	void add(T value)
 	{
-		if (!canAdd(sizeof(T))) {
+		if (!prepareAdd(sizeof(T))) {
 			return;
 		}
 
-		std::memcpy(buffer.data() + info.position, &value, sizeof(T));
+		std::memcpy(buffer + info.position, &value, sizeof(T));
 		info.position += sizeof(T);
 		info.length += sizeof(T);
 	}
@@ -134,8 +150,8 @@ public:
 
 	bool isOverrun() const { return info.overrun; }
 
-	uint8_t* getBuffer() { return &buffer[0]; }
-	const uint8_t* getBuffer() const { return &buffer[0]; }
+	uint8_t* getBuffer() { return buffer; }
+	const uint8_t* getBuffer() const { return buffer; }
 
 	uint8_t* getBodyBuffer()
 	{
@@ -152,11 +168,26 @@ protected:
 	};
 
 	NetworkMessageInfo info = {};
-	std::array<uint8_t, NETWORKMESSAGE_MAXSIZE> buffer = {};
+	std::array<uint8_t, NETWORKMESSAGE_INLINE_SIZE> inlineBuffer = {};
+	uint8_t* buffer = inlineBuffer.data();
+	MsgSize_t capacity = NETWORKMESSAGE_INLINE_SIZE;
+
+	bool prepareAdd(size_t size)
+	{
+		if (!canAdd(size)) {
+			return false;
+		}
+
+		reserve(info.position + size);
+		return true;
+	}
 
 private:
 	bool canAdd(size_t size) const { return (size + info.position) < MAX_BODY_LENGTH; }
 
+	void grow(size_t size);
+	void releaseBuffer();
+
 	bool canRead(int32_t size)
 	{
 		if ((info.position + size) > (info.length + 8) || size >= (NETWORKMESSAGE_MAXSIZE - info.position)) {
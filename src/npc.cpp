@@ -5,13 +5,51 @@
 
 #include "npc.h"
 
+#include "configmanager.h"
 #include "game.h"
 #include "pugicast.h"
 
+extern ConfigManager g_config;
 extern Game g_game;
 extern LuaEnvironment g_luaEnvironment;
 
-uint32_t Npc::npcAutoID = 0x80000000;
+SlotMap<Npc> Npc::npcIds{0x80000000, 0x100000000};
+
+namespace {
+
+LuaEnvironment& getNpcLuaEnvironment()
+{
+	// constructed on first use, after g_luaEnvironment
+	static LuaEnvironment environment{"Npc Environment"};
+	if (!environment.getLuaState()) {
+		environment.initState();
+		if (environment.loadFile("data/global.lua") == -1) {
+			std::cout << "[Warning - getNpcLuaEnvironment] Can not load data/global.lua" << std::endl;
+			std::cout << environment.getLastLuaError() << std::endl;
+		}
+	}
+	return environment;
+}
+
+// the npc functions and data/npc/lib are set up once per lua state, not once per npc, the registry of the state
+// remembers it until the npcs are reloaded
+constexpr auto NPC_LIB_LOADED = "npcLibLoaded";
+
+bool isNpcLibLoaded(lua_State* L)
+{
+	lua_getfield(L, LUA_REGISTRYINDEX, NPC_LIB_LOADED);
+	const bool loaded = lua_toboolean(L, -1) != 0;
+	lua_pop(L, 1);
+	return loaded;
+}
+
+void setNpcLibLoaded(lua_State* L, bool loaded)
+{
+	lua_pushboolean(L, loaded);
+	lua_setfield(L, LUA_REGISTRYINDEX, NPC_LIB_LOADED);
+}
+
+} // namespace
 
 void Npcs::reload()
 {
@@ -20,9 +58,21 @@ void Npcs::reload()
 		it.second->closeAllShopWindows();
 	}
 
+	const bool separateState = g_config[ConfigKeysBoolean::NPC_SEPARATE_LUA_STATE];
+	if (separateState) {
+		getNpcLuaEnvironment().loadFile("data/global.lua");
+		setNpcLibLoaded(getNpcLuaEnvironment().getLuaState(), false);
+	} else {
+		setNpcLibLoaded(g_luaEnvironment.getLuaState(), false);
+	}
+
 	for (const auto& it : npcs) {
 		it.second->reload();
 	}
+
+	if (separateState) {
+		lua_gc(getNpcLuaEnvironment().getLuaState(), LUA_GCCOLLECT, 0);
+	}
 }
 
 Npc* Npc::createNpc(const std::string& name)
@@ -39,7 +89,11 @@ Npc::Npc(const std::string& name) : Creature(), filename("data/npc/" + name + ".
 	reset();
 }
 
-Npc::~Npc() { reset(); }
+Npc::~Npc()
+{
+	reset();
+	npcIds.release(id);
+}
 
 void Npc::addList() { g_game.addNpc(this); }
 
@@ -273,24 +327,31 @@ void Npc::onCreatureMove(Creature* creature, const Tile* newTile, const Position
 {
 	Creature::onCreatureMove(creature, newTile, newPos, oldTile, oldPos, teleport);
 
-	if (creature == this || creature->getPlayer()) {
-		if (npcEventHandler) {
+	if (creature == this) {
+		// moves of the npc itself only matter to scripts while a player can see it
+		if (npcEventHandler && !spectators.empty()) {
 			npcEventHandler->onCreatureMove(creature, oldPos, newPos);
 		}
+	} else if (creature->getPlayer()) {
+		queueCreatureMove(creature, oldPos, newPos);
+	}
+}
 
-		if (creature != this) {
-			Player* player = creature->getPlayer();
-
-			// if player is now in range, add to spectators list, otherwise erase
-			if (player->canSee(position)) {
-				spectators.insert(player);
-			} else {
-				spectators.erase(player);
-			}
+void Npc::onQueuedCreatureMove(Creature* creature, const Position& oldPos, const Position& newPos)
+{
+	if (npcEventHandler) {
+		npcEventHandler->onCreatureMove(creature, oldPos, newPos);
+	}
 
-			setIdle(spectators.empty());
-		}
+	// if player is now in range, add to spectators list, otherwise erase
+	Player* player = creature->getPlayer();
+	if (player->canSee(position)) {
+		spectators.insert(player);
+	} else {
+		spectators.erase(player);
 	}
+
+	setIdle(spectators.empty());
 }
 
 void Npc::onCreatureSay(Creature* creature, SpeakClasses type, std::string_view text)
@@ -317,6 +378,12 @@ void Npc::onPlayerCloseChannel(Player* player)
 
 void Npc::onThink(uint32_t interval)
 {
+	// nobody is around to talk to, sleep until a player comes into view again
+	if (isIdle && g_config[ConfigKeysBoolean::NPCS_SLEEP_WITHOUT_PLAYERS]) {
+		Game::removeCreatureCheck(this);
+		return;
+	}
+
 	Creature::onThink(interval);
 
 	if (npcEventHandler) {
@@ -401,6 +468,8 @@ void Npc::setIdle(const bool idle)
 
 	if (isIdle) {
 		onIdleStatus();
+	} else {
+		g_game.addCreatureCheck(this);
 	}
 }
 
@@ -416,7 +485,7 @@ bool Npc::canWalkTo(const Position& fromPos, Direction dir) const
 	}
 
 	Tile* tile = g_game.map.getTile(toPos);
-	if (!tile || tile->queryAdd(0, *this, 1, 0) != RETURNVALUE_NOERROR) {
+	if (!tile || tile->queryAddCreature(*this, 0) != RETURNVALUE_NOERROR) {
 		return false;
 	}
 
@@ -509,20 +578,22 @@ void Npc::closeAllShopWindows()
 	}
 }
 
-NpcScriptInterface::NpcScriptInterface() : LuaScriptInterface("Npc interface")
-{
-	libLoaded = false;
-	initState();
-}
+NpcScriptInterface::NpcScriptInterface() : LuaScriptInterface("Npc interface") { initState(); }
 
 bool NpcScriptInterface::initState()
 {
-	luaState = g_luaEnvironment.getLuaState();
+	if (g_config[ConfigKeysBoolean::NPC_SEPARATE_LUA_STATE]) {
+		luaState = getNpcLuaEnvironment().getLuaState();
+	} else {
+		luaState = g_luaEnvironment.getLuaState();
+	}
 	if (!luaState) {
 		return false;
 	}
 
-	registerFunctions();
+	if (!isNpcLibLoaded(luaState)) {
+		registerFunctions();
+	}
 
 	lua_newtable(luaState);
 	eventTableRef = luaL_ref(luaState, LUA_REGISTRYINDEX);
@@ -530,16 +601,9 @@ bool NpcScriptInterface::initState()
 	return true;
 }
 
-bool NpcScriptInterface::closeState()
-{
-	libLoaded = false;
-	LuaScriptInterface::closeState();
-	return true;
-}
-
 bool NpcScriptInterface::loadNpcLib(std::string_view file)
 {
-	if (libLoaded) {
+	if (isNpcLibLoaded(luaState)) {
 		return true;
 	}
 
@@ -548,7 +612,7 @@ bool NpcScriptInterface::loadNpcLib(std::string_view file)
 		return false;
 	}
 
-	libLoaded = true;
+	setNpcLibLoaded(luaState, true);
 	return true;
 }
 
@@ -619,7 +683,7 @@ int NpcScriptInterface::luaActionMoveTo(lua_State* L)
 
 	Position position;
 	int32_t argsStart = 2;
-	if (Lua::isTable(L, 1)) {
+	if (Lua::isPosition(L, 1)) {
 		position = Lua::getPosition(L, 1);
 	} else {
 		position.x = Lua::getInteger<uint16_t>(L, 1);
@@ -50,9 +50,6 @@ private:
 
 private:
 	bool initState() override;
-	bool closeState() override;
-
-	bool libLoaded;
 };
 
 class NpcEventsHandler
@@ -106,7 +103,7 @@ public:
 	void setID() override
 	{
 		if (id == 0) {
-			id = npcAutoID++;
+			id = npcIds.acquire();
 		}
 	}
 
@@ -153,7 +150,7 @@ public:
 
 	auto& getScriptInterface() { return npcEventHandler->scriptInterface; }
 
-	static uint32_t npcAutoID;
+	static SlotMap<Npc> npcIds;
 
 private:
 	explicit Npc(const std::string& name);
@@ -162,6 +159,7 @@ private:
 	void onRemoveCreature(Creature* creature, bool isLogout) override;
 	void onCreatureMove(Creature* creature, const Tile* newTile, const Position& newPos, const Tile* oldTile,
 	                    const Position& oldPos, bool teleport) override;
+	void onQueuedCreatureMove(Creature* creature, const Position& oldPos, const Position& newPos) override;
 
 	void onCreatureSay(Creature* creature, SpeakClasses type, std::string_view text) override;
 	void onThink(uint32_t interval) override;
@@ -211,6 +209,7 @@ private:
 
 	friend class Npcs;
 	friend class NpcScriptInterface;
+	friend class Game;
 };
 
 #endif
@@ -11,11 +11,17 @@
 #include <algorithm>
 #include <array>
 #include <atomic>
+#include <bit>
 #include <bitset>
 #include <boost/algorithm/string.hpp>
 #include <boost/asio.hpp>
+#include <boost/container/flat_map.hpp>
+#include <boost/container/flat_set.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/lockfree/queue.hpp>
 #include <boost/lockfree/stack.hpp>
+#include <boost/smart_ptr/intrusive_ptr.hpp>
 #include <boost/variant.hpp>
 #include <cassert>
 #include <concepts>
@@ -43,9 +49,11 @@
 #include <mutex>
 #include <mysql/mysql.h>
 #include <optional>
+#include <queue>
 #include <pugixml.hpp>
 #include <random>
 #include <set>
+#include <span>
 #include <sstream>
 #include <string>
 #include <string_view>
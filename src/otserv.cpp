@@ -5,21 +5,30 @@
 
 #include "otserv.h"
 
+#include "ban.h"
 #include "configmanager.h"
 #include "databasemanager.h"
 #include "databasetasks.h"
 #include "game.h"
+#include "handover.h"
+#include "jobsystem.h"
+#include "logger.h"
+#include "outputmessage.h"
 #include "protocollogin.h"
+#include "protocolmetrics.h"
 #include "protocolold.h"
 #include "protocolstatus.h"
+#include "replay.h"
 #include "rsa.h"
 #include "scheduler.h"
 #include "script.h"
 #include "scriptmanager.h"
 #include "server.h"
+#include "threadregistry.h"
 
 #include <fmt/format.h>
 #include <fstream>
+#include <future>
 #if __has_include("gitmetadata.h")
 #include "gitmetadata.h"
 #endif
@@ -27,12 +36,14 @@
 DatabaseTasks g_databaseTasks;
 Dispatcher g_dispatcher;
 Scheduler g_scheduler;
+JobSystem g_jobs;
 
 Game g_game;
 ConfigManager g_config;
 Monsters g_monsters;
 Vocations g_vocations;
 extern Scripts* g_scripts;
+extern LuaEnvironment g_luaEnvironment;
 RSA g_RSA;
 
 std::mutex g_loaderLock;
@@ -47,25 +58,132 @@ void startupErrorMessage(std::string_view errorStr)
 	g_loaderSignal.notify_all();
 }
 
-void mainLoader(ServiceManager* services)
+// runs the startup stages in order, stages off the main thread start as soon as the ones they come after are loaded
+class StartupLoader
 {
-	// dispatcher thread
-	g_game.setGameState(GAME_STATE_STARTUP);
+public:
+	using LoadFunction = std::function<bool()>;
+
+	void add(std::string_view name, std::string_view errorMessage, std::initializer_list<std::string_view> after,
+	         LoadFunction load, bool mainThread = true)
+	{
+		Stage& stage = stages.emplace_back();
+		stage.name = name;
+		stage.errorMessage = errorMessage;
+		stage.load = std::move(load);
+		stage.mainThread = mainThread;
+		for (std::string_view dependency : after) {
+			// stages can only come after earlier ones, so a main thread stage never waits for a later one
+			auto it = std::find_if(stages.begin(), stages.end() - 1,
+			                       [dependency](const Stage& other) { return other.name == dependency; });
+			assert(it != stages.end() - 1);
+			stage.after.push_back(std::distance(stages.begin(), it));
+		}
+	}
 
-	srand(static_cast<unsigned int>(OTSYS_TIME()));
-#ifdef _WIN32
-	SetConsoleTitle(STATUS_SERVER_NAME);
+	// returns the error message of the first stage that failed
+	std::optional<std::string_view> run()
+	{
+		int64_t start = OTSYS_NANOTIME();
+		for (size_t i = 0; i < stages.size(); ++i) {
+			if (stages[i].mainThread) {
+				std::promise<bool> loaded;
+				loaded.set_value(runStage(i, start));
+				stages[i].loaded = loaded.get_future().share();
+			} else {
+				stages[i].loaded = std::async(std::launch::async, [this, i, start]() { return runStage(i, start); });
+			}
+		}
 
-	// fixes a problem with escape characters not being processed in Windows consoles
-	HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-	DWORD dwMode = 0;
-	GetConsoleMode(hOut, &dwMode);
-	dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
-	SetConsoleMode(hOut, dwMode);
-#endif
+		std::optional<std::string_view> error;
+		for (Stage& stage : stages) {
+			if (!stage.loaded.get() && stage.ran && !error) {
+				error = stage.errorMessage;
+			}
+		}
+		return error;
+	}
 
-	printServerVersion();
+	void printTimeline() const
+	{
+		// walk back from the stage that finished last through whatever it had to wait for
+		std::vector<bool> critical(stages.size());
+		auto last = std::max_element(stages.begin(), stages.end(),
+		                             [](const Stage& a, const Stage& b) { return a.end < b.end; });
+		for (size_t i = std::distance(stages.begin(), last); last != stages.end() && !critical[i];) {
+			critical[i] = true;
+
+			std::vector<size_t> waitedFor = stages[i].after;
+			if (stages[i].mainThread) {
+				for (size_t j = i; j-- > 0;) {
+					if (stages[j].mainThread) {
+						waitedFor.push_back(j);
+						break;
+					}
+				}
+			}
+
+			if (waitedFor.empty()) {
+				break;
+			}
+			i = *std::max_element(waitedFor.begin(), waitedFor.end(),
+			                      [this](size_t a, size_t b) { return stages[a].end < stages[b].end; });
+		}
+
+		std::cout << ">> Startup timeline (* is the critical path):" << std::endl;
+		for (size_t i = 0; i < stages.size(); ++i) {
+			const Stage& stage = stages[i];
+			std::cout << fmt::format("{:s} {:>6d} ms {:>6d} ms  {:s}", critical[i] ? ">*" : "> ", stage.begin,
+			                         stage.end - stage.begin, stage.name)
+			          << std::endl;
+		}
+	}
+
+private:
+	struct Stage
+	{
+		std::string_view name;
+		std::string_view errorMessage;
+		std::vector<size_t> after;
+		LoadFunction load;
+		std::shared_future<bool> loaded;
+		// milliseconds since the loader started
+		int64_t begin = 0;
+		int64_t end = 0;
+		bool mainThread = true;
+		bool ran = false;
+	};
+
+	bool runStage(size_t index, int64_t start)
+	{
+		Stage& stage = stages[index];
+		for (size_t dependency : stage.after) {
+			if (!stages[dependency].loaded.get()) {
+				return false;
+			}
+		}
+
+		stage.ran = true;
+		stage.begin = (OTSYS_NANOTIME() - start) / 1000000;
+		bool loaded = stage.load();
+		stage.end = (OTSYS_NANOTIME() - start) / 1000000;
+		return loaded;
+	}
+
+	std::vector<Stage> stages;
+};
+
+void addLoginProtocols(ServiceManager* services)
+{
+	services->add<ProtocolLogin>(static_cast<uint16_t>(g_config[ConfigKeysInteger::LOGIN_PORT]));
+
+	// Legacy login protocol
+	services->add<ProtocolOld>(static_cast<uint16_t>(g_config[ConfigKeysInteger::LOGIN_PORT]));
+}
 
+// config, RSA key and database, what both the game and the login server start with
+bool loadConfigAndDatabase()
+{
 	// check if config.lua or config.lua.dist exist
 	auto configFile = g_config[ConfigKeysString::CONFIG_FILE];
 	std::ifstream c_test(fmt::format("./{}", configFile));
@@ -86,7 +204,7 @@ void mainLoader(ServiceManager* services)
 	std::cout << ">> Loading config" << std::endl;
 	if (!g_config.load()) {
 		startupErrorMessage(fmt::format("Unable to load {}!", configFile));
-		return;
+		return false;
 	}
 
 #ifdef _WIN32
@@ -103,14 +221,14 @@ void mainLoader(ServiceManager* services)
 		g_RSA.loadPEM("key.pem");
 	} catch (const std::exception& e) {
 		startupErrorMessage(e.what());
-		return;
+		return false;
 	}
 
 	std::cout << ">> Establishing database connection..." << std::flush;
 
 	if (!Database::getInstance().connect()) {
 		startupErrorMessage("Failed to connect to database.");
-		return;
+		return false;
 	}
 
 	std::cout << " MySQL " << Database::getClientVersion() << std::endl;
@@ -121,66 +239,51 @@ void mainLoader(ServiceManager* services)
 	if (!DatabaseManager::isDatabaseSetup()) {
 		startupErrorMessage(
 		    "The database you have specified in config.lua is empty, please import the schema.sql to your database.");
-		return;
+		return false;
 	}
 	g_databaseTasks.start();
 
-	DatabaseManager::updateDatabase();
+	// the dispatcher and the scheduler were started before the config was loaded
+	applyThreadAffinity();
+	return true;
+}
 
-	if (g_config[ConfigKeysBoolean::OPTIMIZE_DATABASE] && !DatabaseManager::optimizeTables()) {
-		std::cout << "> No tables were optimized." << std::endl;
-	}
+void mainLoader(ServiceManager* services)
+{
+	// dispatcher thread
+	g_game.setGameState(GAME_STATE_STARTUP);
 
-	// load vocations
-	std::cout << ">> Loading vocations" << std::endl;
-	if (!g_vocations.loadFromXml()) {
-		startupErrorMessage("Unable to load vocations!");
-		return;
-	}
+	srand(static_cast<unsigned int>(OTSYS_TIME()));
+#ifdef _WIN32
+	SetConsoleTitle(STATUS_SERVER_NAME);
 
-	// load item data
-	std::cout << ">> Loading items... ";
-	if (!Item::items.loadFromOtb("data/items/items.otb")) {
-		startupErrorMessage("Unable to load items (OTB)!");
-		return;
-	}
-	std::cout << fmt::format("OTB v{:d}.{:d}.{:d}", Item::items.majorVersion, Item::items.minorVersion,
-	                         Item::items.buildNumber)
-	          << std::endl;
+	// fixes a problem with escape characters not being processed in Windows consoles
+	HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+	DWORD dwMode = 0;
+	GetConsoleMode(hOut, &dwMode);
+	dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+	SetConsoleMode(hOut, dwMode);
+#endif
 
-	if (!Item::items.loadFromXml()) {
-		startupErrorMessage("Unable to load items (XML)!");
-		return;
-	}
+	printServerVersion();
 
-	std::cout << ">> Loading script systems" << std::endl;
-	if (!ScriptingManager::getInstance().loadScriptSystems()) {
-		startupErrorMessage("Failed to load script systems");
+	if (!loadConfigAndDatabase()) {
 		return;
 	}
 
-	std::cout << ">> Loading lua scripts" << std::endl;
-	if (!g_scripts->loadScripts("scripts", false, false)) {
-		startupErrorMessage("Failed to load lua scripts");
-		return;
+	if (g_config[ConfigKeysInteger::JOB_THREADS] > 0) {
+		g_jobs.start(static_cast<size_t>(g_config[ConfigKeysInteger::JOB_THREADS]));
 	}
 
-	std::cout << ">> Loading monsters" << std::endl;
-	if (!g_monsters.loadFromXml()) {
-		startupErrorMessage("Unable to load monsters!");
-		return;
-	}
+	DatabaseManager::updateDatabase();
 
-	std::cout << ">> Loading lua monsters" << std::endl;
-	if (!g_scripts->loadScripts("monster", false, false)) {
-		startupErrorMessage("Failed to load lua monsters");
+	if (!IOBan::loadIpBans(Database::getInstance())) {
+		startupErrorMessage("Failed to load ip bans.");
 		return;
 	}
 
-	std::cout << ">> Loading outfits" << std::endl;
-	if (!Outfits::getInstance().loadFromXml()) {
-		startupErrorMessage("Unable to load outfits!");
-		return;
+	if (g_config[ConfigKeysBoolean::OPTIMIZE_DATABASE] && !DatabaseManager::optimizeTables()) {
+		std::cout << "> No tables were optimized." << std::endl;
 	}
 
 	std::cout << ">> Checking world type... " << std::flush;
@@ -200,24 +303,116 @@ void mainLoader(ServiceManager* services)
 	}
 	std::cout << boost::algorithm::to_upper_copy(worldType) << std::endl;
 
-	std::cout << ">> Loading map" << std::endl;
-	if (!g_game.loadMainMap(std::string{g_config[ConfigKeysString::MAP_NAME]})) {
-		startupErrorMessage("Failed to load map");
+	// the xml only stages load side by side, everything touching lua stays on this thread
+	StartupLoader loader;
+	loader.add(
+	    "vocations", "Unable to load vocations!", {},
+	    []() {
+		    std::cout << ">> Loading vocations" << std::endl;
+		    return g_vocations.loadFromXml();
+	    },
+	    false);
+
+	loader.add(
+	    "items", "Unable to load items!", {},
+	    []() {
+		    std::cout << ">> Loading items" << std::endl;
+		    if (!Item::items.loadFromOtb("data/items/items.otb")) {
+			    std::cout << "> ERROR: Unable to load items (OTB)!" << std::endl;
+			    return false;
+		    }
+		    std::cout << fmt::format("> Items OTB v{:d}.{:d}.{:d}", Item::items.majorVersion, Item::items.minorVersion,
+		                             Item::items.buildNumber)
+		              << std::endl;
+
+		    if (!Item::items.loadFromXml()) {
+			    std::cout << "> ERROR: Unable to load items (XML)!" << std::endl;
+			    return false;
+		    }
+		    return true;
+	    },
+	    false);
+
+	loader.add(
+	    "outfits", "Unable to load outfits!", {},
+	    []() {
+		    std::cout << ">> Loading outfits" << std::endl;
+		    return Outfits::getInstance().loadFromXml();
+	    },
+	    false);
+
+	loader.add(
+	    "mounts", "Unable to load mounts!", {},
+	    []() {
+		    std::cout << ">> Loading mounts" << std::endl;
+		    if (!g_game.mounts.loadFromXml()) {
+			    std::cout << "> WARNING: Unable to load mounts!" << std::endl;
+		    }
+		    return true;
+	    },
+	    false);
+
+	loader.add("script systems", "Failed to load script systems", {"vocations", "items", "outfits", "mounts"}, []() {
+		std::cout << ">> Loading script systems" << std::endl;
+		return ScriptingManager::getInstance().loadScriptSystems();
+	});
+
+	loader.add("lua scripts", "Failed to load lua scripts", {"script systems"}, []() {
+		std::cout << ">> Loading lua scripts" << std::endl;
+		return g_scripts->loadScripts("scripts", false, false);
+	});
+
+	loader.add("monsters", "Unable to load monsters!", {"lua scripts"}, []() {
+		std::cout << ">> Loading monsters" << std::endl;
+		return g_monsters.loadFromXml();
+	});
+
+	loader.add("lua monsters", "Failed to load lua monsters", {"monsters"}, []() {
+		std::cout << ">> Loading lua monsters" << std::endl;
+		return g_scripts->loadScripts("monster", false, false);
+	});
+
+	// while taking over, the running server still changes what it saves until it hands over
+	const auto handoverSocket = std::string{g_config[ConfigKeysString::HANDOVER_SOCKET]};
+	const bool handover = g_config[ConfigKeysBoolean::HANDOVER] && !handoverSocket.empty();
+	loader.add("map", "Failed to load map", {"items", "lua monsters"}, [handover]() {
+		std::cout << ">> Loading map" << std::endl;
+		return g_game.loadMainMap(std::string{g_config[ConfigKeysString::MAP_NAME]}, !handover);
+	});
+
+	auto error = loader.run();
+	loader.printTimeline();
+	if (error) {
+		startupErrorMessage(*error);
 		return;
 	}
 
+	if (handover) {
+		std::cout << ">> Taking over from the server listening on " << handoverSocket << std::endl;
+		services->adoptListeningSockets(Handover::request(handoverSocket));
+
+		std::cout << ">> Loading house state" << std::endl;
+		g_game.map.loadHouseState();
+	}
+
 	std::cout << ">> Initializing gamestate" << std::endl;
 	g_game.setGameState(GAME_STATE_INIT);
 
-	// Game client protocols
-	services->add<ProtocolGame>(static_cast<uint16_t>(g_config[ConfigKeysInteger::GAME_PORT]));
-	services->add<ProtocolLogin>(static_cast<uint16_t>(g_config[ConfigKeysInteger::LOGIN_PORT]));
+	// a replay is the only client of the game world, the status and metrics ports stay open
+	const auto replayFile = g_config[ConfigKeysString::REPLAY_FILE];
+	if (replayFile.empty()) {
+		// Game client protocols
+		services->add<ProtocolGame>(static_cast<uint16_t>(g_config[ConfigKeysInteger::GAME_PORT]));
+		if (g_config[ConfigKeysBoolean::SERVE_LOGIN]) {
+			addLoginProtocols(services);
+		}
+	}
 
 	// OT protocols
 	services->add<ProtocolStatus>(static_cast<uint16_t>(g_config[ConfigKeysInteger::STATUS_PORT]));
-
-	// Legacy login protocol
-	services->add<ProtocolOld>(static_cast<uint16_t>(g_config[ConfigKeysInteger::LOGIN_PORT]));
+	if (g_config[ConfigKeysInteger::METRICS_PORT] != 0) {
+		services->add<ProtocolMetrics>(static_cast<uint16_t>(g_config[ConfigKeysInteger::METRICS_PORT]));
+	}
 
 	RentPeriod_t rentPeriod;
 	auto strRentPeriod =
@@ -248,6 +443,63 @@ void mainLoader(ServiceManager* services)
 
 	g_game.start(services);
 	g_game.setGameState(GAME_STATE_NORMAL);
+
+	if (!handoverSocket.empty() && replayFile.empty()) {
+		services->listenForHandover(handoverSocket, []() {
+			g_dispatcher.addTask([]() { g_game.setGameState(GAME_STATE_SHUTDOWN); });
+		});
+	}
+
+	if (!replayFile.empty() &&
+	    !startReplay(std::string{replayFile}, static_cast<uint32_t>(g_config[ConfigKeysInteger::REPLAY_SPEED]))) {
+		g_game.setGameState(GAME_STATE_SHUTDOWN);
+	}
+	g_loaderSignal.notify_all();
+}
+
+// the game server bans and unbans while the login server runs, this picks those up
+constexpr uint32_t LOGIN_BAN_RELOAD_INTERVAL = 60 * 1000;
+
+void reloadLoginBans()
+{
+	IOBan::clearCache();
+	g_scheduler.addEvent(createSchedulerTask(LOGIN_BAN_RELOAD_INTERVAL, reloadLoginBans, SCHEDULER_EVENT_SERVER));
+}
+
+void loginLoader(ServiceManager* services)
+{
+	// dispatcher thread
+	printServerVersion();
+
+	if (!loadConfigAndDatabase()) {
+		return;
+	}
+
+	if (!IOBan::loadIpBans(Database::getInstance())) {
+		startupErrorMessage("Failed to load ip bans.");
+		return;
+	}
+
+	g_game.loadMotdNum();
+
+	addLoginProtocols(services);
+	g_scheduler.addEvent(createSchedulerTask(LOGIN_BAN_RELOAD_INTERVAL, reloadLoginBans, SCHEDULER_EVENT_SERVER));
+
+	// there is no game to shut down, the services and threads are all there is
+	Signals::setShutdownHandler([services]() {
+		std::cout << "Shutting login server down..." << std::flush;
+
+		g_scheduler.shutdown();
+		g_databaseTasks.shutdown();
+		g_dispatcher.shutdown();
+		services->stop();
+
+		ConnectionManager::getInstance().closeAll();
+
+		std::cout << " done!" << std::endl;
+	});
+
+	std::cout << ">> Login server starting up..." << std::endl;
 	g_loaderSignal.notify_all();
 }
 
@@ -268,6 +520,10 @@ void startServer()
 
 	ServiceManager serviceManager;
 
+	g_dispatcher.setFlushHandler([]() {
+		OutputMessagePool::getInstance().sendAll();
+		g_luaEnvironment.stepGarbageCollector(g_config[ConfigKeysInteger::LUA_GC_STEP_BUDGET]);
+	});
 	g_dispatcher.start();
 	g_scheduler.start();
 
@@ -277,11 +533,49 @@ void startServer()
 
 	if (serviceManager.is_running()) {
 		std::cout << ">> " << g_config[ConfigKeysString::SERVER_NAME] << " Server Online!" << std::endl << std::endl;
+		// from here on the game threads leave the console to the log writer
+		Logger::start();
 		serviceManager.run();
 	} else {
 		std::cout << ">> No services running. The server is NOT online." << std::endl;
 		g_scheduler.shutdown();
 		g_databaseTasks.shutdown();
+		g_jobs.shutdown();
+		g_dispatcher.shutdown();
+	}
+
+	g_scheduler.join();
+	g_databaseTasks.join();
+	g_jobs.join();
+	g_dispatcher.join();
+	Logger::stop();
+
+	// everything is saved now, the replacement can start accepting
+	Handover::complete();
+}
+
+void startLoginServer()
+{
+	std::set_new_handler(badAllocationHandler);
+
+	ServiceManager serviceManager;
+
+	g_dispatcher.setFlushHandler([]() { OutputMessagePool::getInstance().sendAll(); });
+	g_dispatcher.start();
+	g_scheduler.start();
+
+	g_dispatcher.addTask([services = &serviceManager]() { loginLoader(services); });
+
+	g_loaderSignal.wait(g_loaderUniqueLock);
+
+	if (serviceManager.is_running()) {
+		std::cout << ">> " << g_config[ConfigKeysString::SERVER_NAME] << " Login Server Online!" << std::endl
+		          << std::endl;
+		serviceManager.run();
+	} else {
+		std::cout << ">> No services running. The login server is NOT online." << std::endl;
+		g_scheduler.shutdown();
+		g_databaseTasks.shutdown();
 		g_dispatcher.shutdown();
 	}
 
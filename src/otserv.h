@@ -6,5 +6,7 @@
 
 void printServerVersion();
 void startServer();
+// only the login protocols, for a game server started with serveLogin = false
+void startLoginServer();
 
 #endif
@@ -40,32 +40,35 @@ bool Outfits::loadFromXml()
 			continue;
 		}
 
+		// the first outfit with a look type wins
 		const auto lookType = pugi::cast<uint16_t>(lookTypeAttribute.value());
-		outfits.emplace(std::piecewise_construct, std::forward_as_tuple(lookType),
-		                std::forward_as_tuple(outfitNode.attribute("name").as_string(), lookType,
-		                                      static_cast<PlayerSex_t>(type), outfitNode.attribute("premium").as_bool(),
-		                                      outfitNode.attribute("unlocked").as_bool(true)));
+		if (std::any_of(outfits.begin(), outfits.end(),
+		                [lookType](const Outfit& outfit) { return outfit.lookType == lookType; })) {
+			continue;
+		}
+
+		outfits.emplace_back(outfitNode.attribute("name").as_string(), lookType, static_cast<PlayerSex_t>(type),
+		                     outfitNode.attribute("premium").as_bool(), outfitNode.attribute("unlocked").as_bool(true));
+	}
+
+	for (const Outfit& outfit : outfits) {
+		if (outfit.lookType >= outfitsByLookType.size()) {
+			outfitsByLookType.resize(outfit.lookType + 1);
+		}
+
+		outfitsByLookType[outfit.lookType] = &outfit;
+		outfitsBySex[outfit.sex].push_back(&outfit);
 	}
 	return true;
 }
 
 const Outfit* Outfits::getOutfitByLookType(uint16_t lookType) const
 {
-	auto it = outfits.find(lookType);
-	if (it != outfits.end()) {
-		return &it->second;
-	}
-	return nullptr;
+	return lookType < outfitsByLookType.size() ? outfitsByLookType[lookType] : nullptr;
 }
 
-const std::vector<const Outfit*> Outfits::getOutfits(PlayerSex_t sex) const
+const std::vector<const Outfit*>& Outfits::getOutfits(PlayerSex_t sex) const
 {
-	std::vector<const Outfit*> sexOutfits;
-	for (const auto& it : outfits) {
-		if (it.second.sex == sex) {
-			sexOutfits.push_back(&it.second);
-		}
-	}
-
-	return sexOutfits;
+	static const std::vector<const Outfit*> noOutfits;
+	return sex <= PLAYERSEX_LAST ? outfitsBySex[sex] : noOutfits;
 }
@@ -48,10 +48,13 @@ public:
 	bool loadFromXml();
 
 	const Outfit* getOutfitByLookType(uint16_t lookType) const;
-	const std::vector<const Outfit*> getOutfits(PlayerSex_t sex) const;
+	const std::vector<const Outfit*>& getOutfits(PlayerSex_t sex) const;
 
 private:
-	std::unordered_map<uint16_t, Outfit> outfits;
+	std::vector<Outfit> outfits;
+	// built once all outfits are loaded, indexed by look type and by sex
+	std::vector<const Outfit*> outfitsByLookType;
+	std::array<std::vector<const Outfit*>, PLAYERSEX_LAST + 1> outfitsBySex;
 };
 
 #endif
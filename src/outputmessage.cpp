@@ -6,25 +6,16 @@
 #include "outputmessage.h"
 
 #include "lockfree.h"
+#include "memorystats.h"
 #include "protocol.h"
-#include "scheduler.h"
-
-extern Scheduler g_scheduler;
 
 namespace {
 
 const uint16_t OUTPUTMESSAGE_FREE_LIST_CAPACITY = 2048;
-const std::chrono::milliseconds OUTPUTMESSAGE_AUTOSEND_DELAY{10};
-
-void sendAll(const std::vector<Protocol_ptr>& bufferedProtocols);
 
-void scheduleSendAll(const std::vector<Protocol_ptr>& bufferedProtocols)
-{
-	g_scheduler.addEvent(
-	    createSchedulerTask(OUTPUTMESSAGE_AUTOSEND_DELAY.count(), [&]() { sendAll(bufferedProtocols); }));
-}
+} // namespace
 
-void sendAll(const std::vector<Protocol_ptr>& bufferedProtocols)
+void OutputMessagePool::sendAll()
 {
 	// dispatcher thread
 	for (auto& protocol : bufferedProtocols) {
@@ -33,21 +24,13 @@ void sendAll(const std::vector<Protocol_ptr>& bufferedProtocols)
 			protocol->send(std::move(msg));
 		}
 	}
-
-	if (!bufferedProtocols.empty()) {
-		scheduleSendAll(bufferedProtocols);
-	}
+	bufferedProtocols.clear();
 }
 
-} // namespace
-
 void OutputMessagePool::addProtocolToAutosend(Protocol_ptr protocol)
 {
 	// dispatcher thread
-	if (bufferedProtocols.empty()) {
-		scheduleSendAll(bufferedProtocols);
-	}
-	bufferedProtocols.emplace_back(protocol);
+	bufferedProtocols.emplace_back(std::move(protocol));
 }
 
 void OutputMessagePool::removeProtocolFromAutosend(const Protocol_ptr& protocol)
@@ -60,9 +43,32 @@ void OutputMessagePool::removeProtocolFromAutosend(const Protocol_ptr& protocol)
 	}
 }
 
-OutputMessage_ptr OutputMessagePool::getOutputMessage()
+void* OutputMessage::operator new(size_t size)
 {
-	// LockfreePoolingAllocator<void,...> will leave (void* allocate) ill-formed because of sizeof(T), so this
-	// guarantees that only one list will be initialized
-	return std::allocate_shared<OutputMessage>(LockfreePoolingAllocator<void, OUTPUTMESSAGE_FREE_LIST_CAPACITY>());
+	MemoryStats::allocated(MEMORY_NETWORK_BUFFERS, size);
+	if (size != sizeof(OutputMessage)) {
+		return ::operator new(size);
+	}
+	return lockfreeAllocate<sizeof(OutputMessage), OUTPUTMESSAGE_FREE_LIST_CAPACITY>();
 }
+
+void OutputMessage::operator delete(void* p, size_t size)
+{
+	MemoryStats::freed(MEMORY_NETWORK_BUFFERS, size);
+	if (size != sizeof(OutputMessage)) {
+		::operator delete(p);
+		return;
+	}
+	lockfreeDeallocate<sizeof(OutputMessage), OUTPUTMESSAGE_FREE_LIST_CAPACITY>(p);
+}
+
+void intrusive_ptr_add_ref(OutputMessage* msg) { msg->references.fetch_add(1, std::memory_order_relaxed); }
+
+void intrusive_ptr_release(OutputMessage* msg)
+{
+	if (msg->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete msg;
+	}
+}
+
+OutputMessage_ptr OutputMessagePool::getOutputMessage() { return OutputMessage_ptr{new OutputMessage}; }
@@ -17,6 +17,10 @@ public:
 	OutputMessage(const OutputMessage&) = delete;
 	OutputMessage& operator=(const OutputMessage&) = delete;
 
+	// messages are recycled through a lock-free free list, see lockfree.h
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	uint8_t* getOutputBuffer() { return &buffer[outputBufferStart]; }
 
 	void writeMessageLength() { add_header(info.length); }
@@ -33,7 +37,8 @@ public:
 	void append(const NetworkMessage& msg)
 	{
 		auto msgLen = msg.getLength();
-		std::memcpy(buffer.data() + info.position, msg.getBuffer() + 8, msgLen);
+		reserve(info.position + msgLen);
+		std::memcpy(buffer + info.position, msg.getBuffer() + 8, msgLen);
 		info.length += msgLen;
 		info.position += msgLen;
 	}
@@ -41,7 +46,8 @@ public:
 	void append(const OutputMessage_ptr& msg)
 	{
 		auto msgLen = msg->getLength();
-		std::memcpy(buffer.data() + info.position, msg->getBuffer() + 8, msgLen);
+		reserve(info.position + msgLen);
+		std::memcpy(buffer + info.position, msg->getBuffer() + 8, msgLen);
 		info.length += msgLen;
 		info.position += msgLen;
 	}
@@ -52,12 +58,18 @@ private:
 	{
 		assert(outputBufferStart >= sizeof(T));
 		outputBufferStart -= sizeof(T);
-		std::memcpy(buffer.data() + outputBufferStart, &add, sizeof(T));
+		std::memcpy(buffer + outputBufferStart, &add, sizeof(T));
 		// added header size to the message size
 		info.length += sizeof(T);
 	}
 
 	MsgSize_t outputBufferStart = INITIAL_BUFFER_POSITION;
+
+	// no weak references and no control block, a message is shared by the protocol and the connection queue only
+	std::atomic<uint32_t> references{0};
+
+	friend void intrusive_ptr_add_ref(OutputMessage* msg);
+	friend void intrusive_ptr_release(OutputMessage* msg);
 };
 
 class OutputMessagePool
@@ -75,13 +87,17 @@ public:
 
 	static OutputMessage_ptr getOutputMessage();
 
+	// sends the current buffer of every protocol that wrote to it since the last call, run by the dispatcher after
+	// each batch of tasks
+	void sendAll();
+
+	// called by a protocol once it starts filling a new output buffer
 	void addProtocolToAutosend(Protocol_ptr protocol);
 	void removeProtocolFromAutosend(const Protocol_ptr& protocol);
 
 private:
 	OutputMessagePool() = default;
-	// NOTE: A vector is used here because this container is mostly read and relatively rarely modified (only when a
-	// client connects/disconnects)
+	// only protocols with pending output, so an idle server does no work at all
 	std::vector<Protocol_ptr> bufferedProtocols;
 };
 
@@ -356,15 +356,22 @@ bool Party::canUseSharedExperience(const Player* player) const
 	if (memberList.empty()) {
 		return false;
 	}
+	return canUseSharedExperience(player, sharedExpMinLevel);
+}
 
+uint32_t Party::getSharedExperienceMinLevel() const
+{
 	uint32_t highestLevel = leader->getLevel();
 	for (Player* member : memberList) {
 		if (member->getLevel() > highestLevel) {
 			highestLevel = member->getLevel();
 		}
 	}
+	return static_cast<uint32_t>(std::ceil((static_cast<float>(highestLevel) * 2) / 3));
+}
 
-	uint32_t minLevel = static_cast<uint32_t>(std::ceil((static_cast<float>(highestLevel) * 2) / 3));
+bool Party::canUseSharedExperience(const Player* player, uint32_t minLevel) const
+{
 	if (player->getLevel() < minLevel) {
 		return false;
 	}
@@ -391,12 +398,18 @@ bool Party::canUseSharedExperience(const Player* player) const
 
 bool Party::canEnableSharedExperience()
 {
-	if (!canUseSharedExperience(leader)) {
+	if (memberList.empty()) {
+		return false;
+	}
+
+	// also cached for the party shields sent after this
+	sharedExpMinLevel = getSharedExperienceMinLevel();
+	if (!canUseSharedExperience(leader, sharedExpMinLevel)) {
 		return false;
 	}
 
 	for (Player* member : memberList) {
-		if (!canUseSharedExperience(member)) {
+		if (!canUseSharedExperience(member, sharedExpMinLevel)) {
 			return false;
 		}
 	}
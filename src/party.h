@@ -45,6 +45,7 @@ public:
 	bool setSharedExperience(Player* player, bool sharedExpActive);
 	bool isSharedExperienceActive() const { return sharedExpActive; }
 	bool isSharedExperienceEnabled() const { return sharedExpEnabled; }
+	// uses the level requirement of the last shared experience update
 	bool canUseSharedExperience(const Player* player) const;
 	void updateSharedExperience();
 
@@ -53,6 +54,8 @@ public:
 
 private:
 	bool canEnableSharedExperience();
+	bool canUseSharedExperience(const Player* player, uint32_t minLevel) const;
+	uint32_t getSharedExperienceMinLevel() const;
 
 	std::map<uint32_t, int64_t> ticksMap;
 
@@ -63,6 +66,7 @@ private:
 
 	bool sharedExpActive = false;
 	bool sharedExpEnabled = false;
+	uint32_t sharedExpMinLevel = 0;
 };
 
 #endif
@@ -27,7 +27,7 @@ extern Events* g_events;
 
 MuteCountMap Player::muteCountMap;
 
-uint32_t Player::playerAutoID = 0x10000000;
+SlotMap<Player> Player::playerIds{0x10000000, 0x40000000};
 std::forward_list<Condition*> Player::storedConditionList;
 
 Player::Player(ProtocolGame_ptr p) : Creature(), lastPing(OTSYS_TIME()), lastPong(lastPing), client(std::move(p))
@@ -46,6 +46,7 @@ Player::~Player()
 
 	setWriteItem(nullptr);
 	setEditHouse(nullptr);
+	playerIds.release(id);
 }
 
 bool Player::setVocation(uint16_t vocId)
@@ -55,6 +56,7 @@ bool Player::setVocation(uint16_t vocId)
 		return false;
 	}
 	vocation = voc;
+	equipmentStats.reset();
 
 	updateRegeneration();
 	return true;
@@ -70,88 +72,81 @@ bool Player::isPushable() const
 
 std::string Player::getDescription(int32_t lookDistance) const
 {
-	std::ostringstream s;
+	// built on the stack, the only allocation is the returned string
+	fmt::memory_buffer buffer;
+	auto out = std::back_inserter(buffer);
 
+	const std::string_view pronoun = sex == PLAYERSEX_FEMALE ? "She" : "He";
 	if (lookDistance == -1) {
-		s << "yourself.";
+		fmt::format_to(out, "yourself.");
 
 		if (group->access) {
-			s << " You are " << group->name << '.';
+			fmt::format_to(out, " You are {:s}.", group->name);
 		} else if (vocation->getId() != VOCATION_NONE) {
-			s << " You are " << vocation->getVocDescription() << '.';
+			fmt::format_to(out, " You are {:s}.", vocation->getVocDescription());
 		} else {
-			s << " You have no vocation.";
+			fmt::format_to(out, " You have no vocation.");
 		}
 	} else {
-		s << name;
+		fmt::format_to(out, "{:s}", name);
 		if (!group->access) {
-			s << " (Level " << level << ')';
-		}
-		s << '.';
-
-		if (sex == PLAYERSEX_FEMALE) {
-			s << " She";
-		} else {
-			s << " He";
+			fmt::format_to(out, " (Level {:d})", level);
 		}
 
 		if (group->access) {
-			s << " is " << group->name << '.';
+			fmt::format_to(out, ". {:s} is {:s}.", pronoun, group->name);
 		} else if (vocation->getId() != VOCATION_NONE) {
-			s << " is " << vocation->getVocDescription() << '.';
+			fmt::format_to(out, ". {:s} is {:s}.", pronoun, vocation->getVocDescription());
 		} else {
-			s << " has no vocation.";
+			fmt::format_to(out, ". {:s} has no vocation.", pronoun);
 		}
 	}
 
 	if (party) {
 		if (lookDistance == -1) {
-			s << " Your party has ";
-		} else if (sex == PLAYERSEX_FEMALE) {
-			s << " She is in a party with ";
+			fmt::format_to(out, " Your party has ");
 		} else {
-			s << " He is in a party with ";
+			fmt::format_to(out, " {:s} is in a party with ", pronoun);
 		}
 
 		size_t memberCount = party->getMemberCount() + 1;
 		if (memberCount == 1) {
-			s << "1 member and ";
+			fmt::format_to(out, "1 member and ");
 		} else {
-			s << memberCount << " members and ";
+			fmt::format_to(out, "{:d} members and ", memberCount);
 		}
 
 		size_t invitationCount = party->getInvitationCount();
 		if (invitationCount == 1) {
-			s << "1 pending invitation.";
+			fmt::format_to(out, "1 pending invitation.");
 		} else {
-			s << invitationCount << " pending invitations.";
+			fmt::format_to(out, "{:d} pending invitations.", invitationCount);
 		}
 	}
 
 	if (!guild || !guildRank) {
-		return s.str();
+		return fmt::to_string(buffer);
 	}
 
 	if (lookDistance == -1) {
-		s << " You are ";
-	} else if (sex == PLAYERSEX_FEMALE) {
-		s << " She is ";
+		fmt::format_to(out, " You are ");
 	} else {
-		s << " He is ";
+		fmt::format_to(out, " {:s} is ", pronoun);
 	}
 
-	s << guildRank->name << " of the " << guild->getName();
+	fmt::format_to(out, "{:s} of the {:s}", guildRank->name, guild->getName());
 	if (!guildNick.empty()) {
-		s << " (" << guildNick << ')';
+		fmt::format_to(out, " ({:s})", guildNick);
 	}
 
 	size_t memberCount = guild->getMemberCount();
 	if (memberCount == 1) {
-		s << ", which has 1 member, " << guild->getMembersOnline().size() << " of them online.";
+		fmt::format_to(out, ", which has 1 member, {:d} of them online.", guild->getMembersOnline().size());
 	} else {
-		s << ", which has " << memberCount << " members, " << guild->getMembersOnline().size() << " of them online.";
+		fmt::format_to(out, ", which has {:d} members, {:d} of them online.", memberCount,
+		               guild->getMembersOnline().size());
 	}
-	return s.str();
+	return fmt::to_string(buffer);
 }
 
 Item* Player::getInventoryItem(slots_t slot) const
@@ -252,10 +247,15 @@ int32_t Player::getWeaponSkill(const Item* item) const
 	return attackSkill;
 }
 
-int32_t Player::getArmor() const
+const Player::EquipmentStats& Player::getEquipmentStats() const
 {
-	int32_t armor = 0;
+	if (equipmentStats) {
+		return *equipmentStats;
+	}
+
+	EquipmentStats& stats = equipmentStats.emplace();
 
+	int32_t armor = 0;
 	static const slots_t armorSlots[] = {CONST_SLOT_HEAD, CONST_SLOT_NECKLACE, CONST_SLOT_ARMOR,
 	                                     CONST_SLOT_LEGS, CONST_SLOT_FEET,     CONST_SLOT_RING};
 	for (slots_t slot : armorSlots) {
@@ -264,13 +264,7 @@ int32_t Player::getArmor() const
 			armor += inventoryItem->getArmor();
 		}
 	}
-	return static_cast<int32_t>(armor * vocation->armorMultiplier);
-}
-
-void Player::getShieldAndWeapon(const Item*& shield, const Item*& weapon) const
-{
-	shield = nullptr;
-	weapon = nullptr;
+	stats.armor = static_cast<int32_t>(armor * vocation->armorMultiplier);
 
 	for (uint32_t slot = CONST_SLOT_RIGHT; slot <= CONST_SLOT_LEFT; slot++) {
 		Item* item = inventory[slot];
@@ -283,18 +277,28 @@ void Player::getShieldAndWeapon(const Item*& shield, const Item*& weapon) const
 				break;
 
 			case WEAPON_SHIELD: {
-				if (!shield || item->getDefense() > shield->getDefense()) {
-					shield = item;
+				if (!stats.shield || item->getDefense() > stats.shield->getDefense()) {
+					stats.shield = item;
 				}
 				break;
 			}
 
 			default: { // weapons that are not shields
-				weapon = item;
+				stats.weapon = item;
 				break;
 			}
 		}
 	}
+	return stats;
+}
+
+int32_t Player::getArmor() const { return getEquipmentStats().armor; }
+
+void Player::getShieldAndWeapon(const Item*& shield, const Item*& weapon) const
+{
+	const EquipmentStats& stats = getEquipmentStats();
+	shield = stats.shield;
+	weapon = stats.weapon;
 }
 
 int32_t Player::getDefense() const
@@ -650,7 +654,7 @@ bool Player::canSeeCreature(const Creature* creature) const
 		return false;
 	}
 
-	if (!creature->getPlayer() && !canSeeInvisibility() && creature->isInvisible()) {
+	if (creature->isInvisible() && !creature->getPlayer() && !canSeeInvisibility()) {
 		return false;
 	}
 	return true;
@@ -738,6 +742,8 @@ bool Player::isNearDepotBox() const
 
 DepotChest* Player::getDepotChest(uint32_t depotId, bool autoCreate)
 {
+	loadDepots();
+
 	auto it = depotChests.find(depotId);
 	if (it != depotChests.end()) {
 		return it->second;
@@ -754,6 +760,8 @@ DepotChest* Player::getDepotChest(uint32_t depotId, bool autoCreate)
 
 DepotLocker* Player::getDepotLocker(uint32_t depotId)
 {
+	loadDepots();
+
 	auto it = depotLockerMap.find(depotId);
 	if (it != depotLockerMap.end()) {
 		return it->second.get();
@@ -765,13 +773,48 @@ DepotLocker* Player::getDepotLocker(uint32_t depotId)
 	return it->second.get();
 }
 
+void Player::loadDepots()
+{
+	if (depotsLoaded || guid == 0) {
+		return;
+	}
+
+	// set first, loading adds the items through getDepotLocker and getDepotChest
+	depotsLoaded = true;
+	IOLoginData::loadDepots(this);
+}
+
 void Player::sendCancelMessage(ReturnValue message) const { sendCancelMessage(getReturnMessage(message)); }
 
-void Player::sendStats()
+void Player::addPendingUpdate(PendingUpdate update)
 {
-	if (client) {
+	if (!client) {
+		return;
+	}
+
+	if (pendingUpdates == 0) {
+		g_dispatcher.addTask([id = getID()]() {
+			if (Player* player = g_game.getPlayerByID(id)) {
+				player->sendPendingUpdates();
+			}
+		});
+	}
+	pendingUpdates |= update;
+}
+
+void Player::sendPendingUpdates()
+{
+	const uint8_t updates = std::exchange(pendingUpdates, 0);
+	if (!client) {
+		return;
+	}
+
+	if (updates & PENDING_UPDATE_STATS) {
 		client->sendStats();
 	}
+	if (updates & PENDING_UPDATE_SKILLS) {
+		client->sendSkills();
+	}
 }
 
 void Player::sendPing()
@@ -2087,15 +2130,17 @@ void Player::removeList()
 {
 	g_game.removePlayer(this);
 
-	for (const auto& it : g_game.getPlayers()) {
-		it.second->notifyStatusChange(this, VIPSTATUS_OFFLINE);
+	for (const auto& it : VIPList) {
+		g_game.removeVIPWatcher(it.first, this);
 	}
+	g_game.notifyVIPWatchers(this, VIPSTATUS_OFFLINE);
 }
 
 void Player::addList()
 {
-	for (const auto& it : g_game.getPlayers()) {
-		it.second->notifyStatusChange(this, VIPSTATUS_ONLINE);
+	g_game.notifyVIPWatchers(this, VIPSTATUS_ONLINE);
+	for (const auto& it : VIPList) {
+		g_game.addVIPWatcher(it.first, this);
 	}
 
 	g_game.addPlayer(this);
@@ -2113,12 +2158,7 @@ void Player::kickPlayer(bool displayEffect)
 
 void Player::notifyStatusChange(Player* loginPlayer, VipStatus_t status)
 {
-	if (!client) {
-		return;
-	}
-
-	auto it = VIPList.find(loginPlayer->guid);
-	if (it == VIPList.end()) {
+	if (!client || !VIPList.contains(loginPlayer->guid)) {
 		return;
 	}
 
@@ -2131,6 +2171,7 @@ bool Player::removeVIP(uint32_t vipGuid)
 		return false;
 	}
 
+	g_game.removeVIPWatcher(vipGuid, this);
 	IOLoginData::removeVIPEntry(accountNumber, vipGuid);
 	return true;
 }
@@ -2142,12 +2183,12 @@ bool Player::addVIP(uint32_t vipGuid, std::string_view vipName, VipStatus_t stat
 		return false;
 	}
 
-	auto result = VIPList.insert(vipGuid);
-	if (!result.second) {
+	if (!VIPList.try_emplace(vipGuid, vipName).second) {
 		sendTextMessage(MESSAGE_STATUS_SMALL, "This player is already in your list.");
 		return false;
 	}
 
+	g_game.addVIPWatcher(vipGuid, this);
 	IOLoginData::addVIPEntry(accountNumber, vipGuid);
 	if (client) {
 		client->sendVIP(vipGuid, vipName, status);
@@ -2155,13 +2196,13 @@ bool Player::addVIP(uint32_t vipGuid, std::string_view vipName, VipStatus_t stat
 	return true;
 }
 
-bool Player::addVIPInternal(uint32_t vipGuid)
+bool Player::addVIPInternal(uint32_t vipGuid, std::string_view vipName)
 {
 	if (VIPList.size() >= getMaxVIPEntries()) {
 		return false;
 	}
 
-	return VIPList.insert(vipGuid).second;
+	return VIPList.try_emplace(vipGuid, vipName).second;
 }
 
 // close container and its child containers
@@ -2664,6 +2705,8 @@ void Player::addThing(int32_t index, Thing* thing)
 
 	item->setParent(this);
 	inventory[index] = item;
+	equipmentStats.reset();
+	itemTypeCounts.reset();
 
 	// send to client
 	sendInventoryItem(static_cast<slots_t>(index), item);
@@ -2683,6 +2726,8 @@ void Player::updateThing(Thing* thing, uint16_t itemId, uint32_t count)
 
 	item->setID(itemId);
 	item->setSubType(static_cast<uint16_t>(count));
+	equipmentStats.reset();
+	itemTypeCounts.reset();
 
 	// send to client
 	sendInventoryItem(static_cast<slots_t>(index), item);
@@ -2716,6 +2761,8 @@ void Player::replaceThing(uint32_t index, Thing* thing)
 	item->setParent(this);
 
 	inventory[index] = item;
+	equipmentStats.reset();
+	itemTypeCounts.reset();
 }
 
 void Player::removeThing(Thing* thing, uint32_t count)
@@ -2740,9 +2787,12 @@ void Player::removeThing(Thing* thing, uint32_t count)
 
 			item->setParent(nullptr);
 			inventory[index] = nullptr;
+			equipmentStats.reset();
+			itemTypeCounts.reset();
 		} else {
 			uint8_t newCount = static_cast<uint8_t>(std::max<int32_t>(0, item->getItemCount() - count));
 			item->setItemCount(newCount);
+			itemTypeCounts.reset();
 
 			// send change to client
 			sendInventoryItem(static_cast<slots_t>(index), item);
@@ -2759,6 +2809,8 @@ void Player::removeThing(Thing* thing, uint32_t count)
 
 		item->setParent(nullptr);
 		inventory[index] = nullptr;
+		equipmentStats.reset();
+		itemTypeCounts.reset();
 	}
 }
 
@@ -2778,6 +2830,12 @@ size_t Player::getLastIndex() const { return CONST_SLOT_LAST + 1; }
 
 uint32_t Player::getItemTypeCount(uint16_t itemId, int32_t subType /*= -1*/) const
 {
+	if (subType == -1) {
+		const auto& counts = getItemTypeCounts();
+		auto it = counts.find(itemId);
+		return it != counts.end() ? it->second : 0;
+	}
+
 	uint32_t count = 0;
 	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; i++) {
 		Item* item = inventory[i];
@@ -2853,21 +2911,34 @@ bool Player::removeItemOfType(uint16_t itemId, uint32_t amount, int32_t subType,
 
 std::map<uint32_t, uint32_t>& Player::getAllItemTypeCount(std::map<uint32_t, uint32_t>& countMap) const
 {
+	for (const auto& [itemId, count] : getItemTypeCounts()) {
+		countMap[itemId] += count;
+	}
+	return countMap;
+}
+
+const Player::ItemTypeCounts& Player::getItemTypeCounts() const
+{
+	if (itemTypeCounts) {
+		return *itemTypeCounts;
+	}
+
+	ItemTypeCounts& counts = itemTypeCounts.emplace();
 	for (int32_t i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; i++) {
 		Item* item = inventory[i];
 		if (!item) {
 			continue;
 		}
 
-		countMap[item->getID()] += Item::countByType(item, -1);
+		counts[item->getID()] += item->getItemCount();
 
 		if (Container* container = item->getContainer()) {
 			for (ContainerIterator it = container->iterator(); it.hasNext(); it.advance()) {
-				countMap[(*it)->getID()] += Item::countByType(*it, -1);
+				counts[(*it)->getID()] += (*it)->getItemCount();
 			}
 		}
 	}
-	return countMap;
+	return counts;
 }
 
 Thing* Player::getThing(size_t index) const
@@ -2881,6 +2952,9 @@ Thing* Player::getThing(size_t index) const
 void Player::postAddNotification(Thing* thing, const Cylinder* oldParent, int32_t index,
                                  cylinderlink_t link /*= LINK_OWNER*/)
 {
+	// also reached for changes inside carried containers
+	itemTypeCounts.reset();
+
 	if (link == LINK_OWNER) {
 		// calling movement scripts
 		g_moveEvents->onPlayerEquip(this, thing->getItem(), static_cast<slots_t>(index), false);
@@ -2937,6 +3011,8 @@ void Player::postAddNotification(Thing* thing, const Cylinder* oldParent, int32_
 void Player::postRemoveNotification(Thing* thing, const Cylinder* newParent, int32_t index,
                                     cylinderlink_t link /*= LINK_OWNER*/)
 {
+	itemTypeCounts.reset();
+
 	if (link == LINK_OWNER) {
 		// calling movement scripts
 		g_moveEvents->onPlayerDeEquip(this, thing->getItem(), static_cast<slots_t>(index));
@@ -3056,6 +3132,8 @@ void Player::internalAddThing(uint32_t index, Thing* thing)
 
 		inventory[index] = item;
 		item->setParent(this);
+		equipmentStats.reset();
+		itemTypeCounts.reset();
 	}
 }
 
@@ -3146,8 +3224,9 @@ void Player::doAttacking(uint32_t)
 			result = Weapon::useFist(this, attackedCreature);
 		}
 
-		SchedulerTask* task = createSchedulerTask(std::max<uint32_t>(SCHEDULER_MINTICKS, delay),
-		                                          [id = getID()]() { g_game.checkCreatureAttack(id); });
+		SchedulerTask* task =
+		    createSchedulerTask(std::max<uint32_t>(SCHEDULER_MINTICKS, delay),
+		                        [id = getID()]() { g_game.checkCreatureAttack(id); }, SCHEDULER_EVENT_PLAYER_ACTION);
 
 		if (!classicSpeed) {
 			setNextActionTask(task, false);
@@ -3602,15 +3681,12 @@ bool Player::canWear(uint32_t lookType, uint8_t addons) const
 		return true;
 	}
 
-	for (const auto& [outfitLookType, addon] : outfits) {
-		if (outfitLookType == lookType) {
-			if (addon == addons || addon == 3 || addons == 0) {
-				return true;
-			}
-			return false; // have lookType on list and addons don't match
-		}
+	auto it = outfits.find(static_cast<uint16_t>(lookType));
+	if (it == outfits.end()) {
+		return false;
 	}
-	return false;
+
+	return it->second == addons || it->second == 3 || addons == 0;
 }
 
 bool Player::hasOutfit(uint32_t lookType, uint8_t addons)
@@ -3624,48 +3700,33 @@ bool Player::hasOutfit(uint32_t lookType, uint8_t addons)
 		return true;
 	}
 
-	for (const auto& [outfitLookType, addon] : outfits) {
-		if (outfitLookType == lookType) {
-			if (addon == addons || addon == 3 || addons == 0) {
-				return true;
-			}
-			return false; // have lookType on list and addons don't match
-		}
+	auto it = outfits.find(static_cast<uint16_t>(lookType));
+	if (it == outfits.end()) {
+		return false;
 	}
-	return false;
+
+	return it->second == addons || it->second == 3 || addons == 0;
 }
 
 void Player::addOutfit(uint16_t lookType, uint8_t addons)
 {
-	for (auto& [outfit, addon] : outfits) {
-		if (outfit == lookType) {
-			addon |= addons;
-			return;
-		}
-	}
-	outfits.emplace(lookType, addons);
+	outfits[lookType] |= addons;
 }
 
 bool Player::removeOutfit(uint16_t lookType)
 {
-	for (const auto& [outfit, _] : outfits) {
-		if (outfit == lookType) {
-			outfits.erase(outfit);
-			return true;
-		}
-	}
-	return false;
+	return outfits.erase(lookType) != 0;
 }
 
 bool Player::removeOutfitAddon(uint16_t lookType, uint8_t addons)
 {
-	for (auto& [outfit, addon] : outfits) {
-		if (outfit == lookType) {
-			addon &= ~addons;
-			return true;
-		}
+	auto it = outfits.find(lookType);
+	if (it == outfits.end()) {
+		return false;
 	}
-	return false;
+
+	it->second &= ~addons;
+	return true;
 }
 
 bool Player::getOutfitAddons(const Outfit& outfit, uint8_t& addons) const
@@ -3679,12 +3740,9 @@ bool Player::getOutfitAddons(const Outfit& outfit, uint8_t& addons) const
 		return false;
 	}
 
-	for (const auto& [lookType, addon] : outfits) {
-		if (lookType != outfit.lookType) {
-			continue;
-		}
-
-		addons = addon;
+	auto it = outfits.find(outfit.lookType);
+	if (it != outfits.end()) {
+		addons = it->second;
 		return true;
 	}
 
@@ -3868,12 +3926,7 @@ bool Player::isInWar(const Player* player) const
 		return false;
 	}
 
-	return isInWarList(playerGuild->getId()) && player->isInWarList(guild->getId());
-}
-
-bool Player::isInWarList(uint32_t guildId) const
-{
-	return std::find(guildWarVector.begin(), guildWarVector.end(), guildId) != guildWarVector.end();
+	return guild->isAtWarWith(playerGuild->getId()) && playerGuild->isAtWarWith(guild->getId());
 }
 
 bool Player::isPremium() const
@@ -3994,19 +4047,7 @@ GuildEmblems_t Player::getGuildEmblem(const Player* player) const
 	if (!player) {
 		return GUILDEMBLEM_NONE;
 	}
-
-	const Guild* playerGuild = player->getGuild();
-	if (!playerGuild || player->getGuildWarVector().empty()) {
-		return GUILDEMBLEM_NONE;
-	}
-
-	if (guild == playerGuild) {
-		return GUILDEMBLEM_ALLY;
-	} else if (isInWar(player)) {
-		return GUILDEMBLEM_ENEMY;
-	}
-
-	return GUILDEMBLEM_NEUTRAL;
+	return Guild::getEmblem(guild, player->getGuild());
 }
 
 uint16_t Player::getRandomMount() const
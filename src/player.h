@@ -53,14 +53,6 @@ enum tradestate_t : uint8_t
 	TRADE_TRANSFER,
 };
 
-struct VIPEntry
-{
-	VIPEntry(uint32_t guid, std::string_view name) : guid{guid}, name{name} {}
-
-	uint32_t guid;
-	std::string name;
-};
-
 struct OpenContainer
 {
 	Container* container;
@@ -104,7 +96,7 @@ public:
 	void setID() override
 	{
 		if (id == 0) {
-			id = playerAutoID++;
+			id = playerIds.acquire();
 		}
 	}
 
@@ -158,6 +150,8 @@ public:
 	void setGuild(Guild* guild);
 
 	GuildRank_ptr getGuildRank() const { return guildRank; }
+	// 0 without a rank, saves the reference count of getGuildRank on hot checks
+	uint32_t getGuildRankId() const { return guildRank ? guildRank->id : 0; }
 	void setGuildRank(GuildRank_ptr newGuildRank) { guildRank = newGuildRank; }
 
 	bool isGuildMate(const Player* player) const;
@@ -166,14 +160,12 @@ public:
 	void setGuildNick(std::string nick) { guildNick = nick; }
 
 	bool isInWar(const Player* player) const;
-	bool isInWarList(uint32_t guildId) const;
 
 	void setLastWalkthroughAttempt(int64_t walkthroughAttempt) { lastWalkthroughAttempt = walkthroughAttempt; }
 	void setLastWalkthroughPosition(Position walkthroughPosition) { lastWalkthroughPosition = walkthroughPosition; }
 
 	uint16_t getClientIcons() const;
 
-	const GuildWarVector& getGuildWarVector() const { return guildWarVector; }
 
 	Vocation* getVocation() const { return vocation; }
 
@@ -189,6 +181,10 @@ public:
 		return client->getVersion();
 	}
 
+	// nullptr while the player has no client
+	const ClientPacketStats* getPacketStats() const { return client ? &client->packetStats : nullptr; }
+	const ClientSentStats* getSentStats() const { return client ? &client->sentStats : nullptr; }
+
 	bool hasSecureMode() const { return secureMode; }
 
 	void setParty(Party* party) { this->party = party; }
@@ -275,6 +271,8 @@ public:
 	uint64_t getExperience() const { return experience; }
 
 	time_t getLastLoginSaved() const { return lastLoginSaved; }
+	// OTSYS_TIME of the last save or of the login, when the database had what the player has
+	int64_t getLastSaveTime() const { return lastSaveTime; }
 
 	time_t getLastLogout() const { return lastLogout; }
 
@@ -387,7 +385,9 @@ public:
 	void notifyStatusChange(Player* loginPlayer, VipStatus_t status);
 	bool removeVIP(uint32_t vipGuid);
 	bool addVIP(uint32_t vipGuid, std::string_view vipName, VipStatus_t status);
-	bool addVIPInternal(uint32_t vipGuid);
+	bool addVIPInternal(uint32_t vipGuid, std::string_view vipName);
+	// guid to the name the entry was loaded or added with
+	const std::unordered_map<uint32_t, std::string>& getVIPList() const { return VIPList; }
 
 	// follow functions
 	bool setFollowCreature(Creature* creature) override;
@@ -454,6 +454,10 @@ public:
 	WeaponType_t getWeaponType() const;
 	int32_t getWeaponSkill(const Item* item) const;
 	void getShieldAndWeapon(const Item*& shield, const Item*& weapon) const;
+	// to be called when the armor or defense of an equipped item changes in place
+	void invalidateEquipmentStats() const { equipmentStats.reset(); }
+	// to be called when the count of a carried item changes in place
+	void invalidateItemTypeCounts() const { itemTypeCounts.reset(); }
 
 	void drainHealth(Creature* attacker, int32_t damage) override;
 	void drainMana(Creature* attacker, int32_t manaLoss);
@@ -599,6 +603,34 @@ public:
 			client->sendCreatureSay(creature, type, text, pos);
 		}
 	}
+	// msg was built once by one of the ProtocolGame::build* functions for all spectators
+	void sendSharedMessage(const NetworkMessage& msg) const
+	{
+		if (client) {
+			client->sendSharedMessage(msg);
+		}
+	}
+	// same, but only if the client can see pos
+	void sendSharedMessage(const NetworkMessage& msg, const Position& pos) const
+	{
+		if (client) {
+			client->sendSharedMessage(msg, pos);
+		}
+	}
+	// same, but only if the client can see creature
+	void sendSharedMessage(const NetworkMessage& msg, const Creature* creature) const
+	{
+		if (client) {
+			client->sendSharedMessage(msg, creature);
+		}
+	}
+	// same as the pos one, for effects the client can miss while it has too much waiting to be sent
+	void sendSharedEffect(const NetworkMessage& msg, const Position& pos) const
+	{
+		if (client) {
+			client->sendSharedEffect(msg, pos);
+		}
+	}
 	void sendPrivateMessage(const Player* speaker, SpeakClasses type, std::string_view text)
 	{
 		if (client) {
@@ -775,13 +807,10 @@ public:
 		}
 	}
 	void sendPing();
-	void sendStats();
-	void sendSkills() const
-	{
-		if (client) {
-			client->sendSkills();
-		}
-	}
+	// stats and skills are sent once per dispatcher cycle, however often they change in it
+	void sendStats() { addPendingUpdate(PENDING_UPDATE_STATS); }
+	void sendSkills() { addPendingUpdate(PENDING_UPDATE_SKILLS); }
+	void sendPendingUpdates();
 	void sendTextMessage(MessageClasses mclass, std::string_view message) const
 	{
 		if (client) {
@@ -974,7 +1003,7 @@ public:
 	bool hasDebugAssertSent() const { return client ? client->debugAssertSent : false; }
 	bool isOTCv8() const { return client ? client->isOTCv8 : false; }
 
-	static uint32_t playerAutoID;
+	static SlotMap<Player> playerIds;
 
 private:
 	std::forward_list<Condition*> getMuteConditions() const;
@@ -986,6 +1015,8 @@ private:
 
 	void updateInventoryWeight();
 
+	void loadDepots();
+
 	void setNextWalkActionTask(SchedulerTask* task);
 	void setNextWalkTask(SchedulerTask* task);
 	void setNextActionTask(SchedulerTask* task, bool resetIdleTime = true);
@@ -1021,15 +1052,16 @@ private:
 	void internalAddThing(uint32_t index, Thing* thing) override;
 
 	std::unordered_set<uint32_t> attackedSet;
-	std::unordered_set<uint32_t> VIPList;
+	std::unordered_map<uint32_t, std::string> VIPList;
 
 	std::map<uint8_t, OpenContainer> openContainers;
 	std::map<uint32_t, DepotLocker_ptr> depotLockerMap;
 	std::map<uint32_t, DepotChest*> depotChests;
+	// the depot rows are only read the first time a depot is used
+	bool depotsLoaded = false;
 
-	std::unordered_map<uint16_t, uint8_t> outfits;
+	boost::container::flat_map<uint16_t, uint8_t> outfits;
 	std::unordered_set<uint16_t> mounts;
-	GuildWarVector guildWarVector;
 
 	std::list<ShopInfo> shopItemList;
 
@@ -1050,6 +1082,7 @@ private:
 
 	time_t lastLoginSaved = 0;
 	time_t lastLogout = 0;
+	int64_t lastSaveTime = 0;
 	time_t premiumEndsAt = 0;
 
 	uint64_t experience = 0;
@@ -1071,6 +1104,22 @@ private:
 	Group* group = nullptr;
 	Item* tradeItem = nullptr;
 	Item* inventory[CONST_SLOT_LAST + 1] = {};
+
+	struct EquipmentStats
+	{
+		const Item* shield = nullptr;
+		const Item* weapon = nullptr;
+		int32_t armor = 0;
+	};
+	// derived from the inventory and vocation, rebuilt on first use after either changes
+	mutable std::optional<EquipmentStats> equipmentStats;
+	const EquipmentStats& getEquipmentStats() const;
+
+	// count of every item id carried, inside containers too, rebuilt by the first count after a change
+	using ItemTypeCounts = std::unordered_map<uint16_t, uint32_t>;
+	mutable std::optional<ItemTypeCounts> itemTypeCounts;
+	const ItemTypeCounts& getItemTypeCounts() const;
+
 	Item* writeItem = nullptr;
 	House* editHouse = nullptr;
 	Npc* shopOwner = nullptr;
@@ -1136,6 +1185,14 @@ private:
 	bool randomizeMount = false;
 	bool inventoryAbilities[CONST_SLOT_LAST + 1] = {};
 
+	enum PendingUpdate : uint8_t
+	{
+		PENDING_UPDATE_STATS = 1 << 0,
+		PENDING_UPDATE_SKILLS = 1 << 1,
+	};
+	uint8_t pendingUpdates = 0;
+	void addPendingUpdate(PendingUpdate update);
+
 	void updateItemsLight(bool internal = false);
 	int32_t getStepSpeed() const override
 	{
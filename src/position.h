@@ -63,6 +63,24 @@ struct Position
 	constexpr int16_t getZ() const { return z; }
 };
 
+// x:16 y:16 z:8 in one integer, offset by one so that no position packs to 0, the empty key of a FlatHashMap
+using PositionKey = uint64_t;
+
+constexpr PositionKey getPositionKey(const Position& pos)
+{
+	return ((static_cast<uint64_t>(pos.x) << 24) | (static_cast<uint64_t>(pos.y) << 8) | pos.z) + 1;
+}
+
 std::ostream& operator<<(std::ostream&, const Position&);
 
+// the same as operator<<, ( 00100 / 00200 / 007 )
+template <>
+struct fmt::formatter<Position> : fmt::formatter<std::string_view>
+{
+	auto format(const Position& pos, fmt::format_context& ctx) const
+	{
+		return fmt::format_to(ctx.out(), "( {:05d} / {:05d} / {:03d} )", pos.x, pos.y, pos.getZ());
+	}
+};
+
 #endif // FS_POSITION_H
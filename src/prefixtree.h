@@ -0,0 +1,88 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_PREFIXTREE_H
+#define FS_PREFIXTREE_H
+
+/*
+ * Case-insensitive trie mapping words to values, built when scripts are loaded so that finding every registered word
+ * a chat line starts with costs one walk over the line instead of a scan over all words.
+ * Words differing only in case share a node and keep their values in insertion order.
+ */
+template <typename Value>
+class PrefixTree
+{
+	struct Node
+	{
+		boost::container::flat_map<char, uint32_t> children;
+		std::vector<Value> values;
+	};
+
+public:
+	PrefixTree() { clear(); }
+
+	void clear()
+	{
+		nodes.clear();
+		nodes.emplace_back();
+	}
+
+	void insert(std::string_view word, Value value)
+	{
+		uint32_t index = 0;
+		for (char ch : word) {
+			auto it = nodes[index].children.find(fold(ch));
+			if (it != nodes[index].children.end()) {
+				index = it->second;
+				continue;
+			}
+
+			const auto child = static_cast<uint32_t>(nodes.size());
+			nodes[index].children.emplace(fold(ch), child);
+			nodes.emplace_back();
+			index = child;
+		}
+		nodes[index].values.push_back(std::move(value));
+	}
+
+	// calls f(length, values) for every word that text starts with, shortest first
+	template <typename F>
+	void forEachPrefix(std::string_view text, F&& f) const
+	{
+		uint32_t index = 0;
+		for (size_t length = 0;; ++length) {
+			const Node& node = nodes[index];
+			if (!node.values.empty()) {
+				f(length, static_cast<const std::vector<Value>&>(node.values));
+			}
+
+			if (length == text.size()) {
+				return;
+			}
+
+			auto it = node.children.find(fold(text[length]));
+			if (it == node.children.end()) {
+				return;
+			}
+			index = it->second;
+		}
+	}
+
+	// values of the longest word text starts with, or nullptr
+	const std::vector<Value>* findLongestPrefix(std::string_view text, size_t& length) const
+	{
+		const std::vector<Value>* result = nullptr;
+		forEachPrefix(text, [&](size_t prefixLength, const std::vector<Value>& values) {
+			result = &values;
+			length = prefixLength;
+		});
+		return result;
+	}
+
+private:
+	static char fold(char ch) { return static_cast<char>(tolower(static_cast<unsigned char>(ch))); }
+
+	std::vector<Node> nodes;
+};
+
+#endif // FS_PREFIXTREE_H
@@ -24,10 +24,18 @@ public:
 	virtual void onRecvFirstMessage(NetworkMessage& msg) = 0;
 	virtual void onConnect() {}
 
+	// raw streams skip the packet framing and the dispatcher, the bytes read are handed to onRecvRaw on the
+	// network thread as they arrive
+	virtual bool isRawStream() const { return false; }
+	virtual void onRecvRaw(std::string_view) {}
+
 	bool isConnectionExpired() const { return connection.expired(); }
 
 	Connection_ptr getConnection() const { return connection.lock(); }
 
+	// the connection has more than sendQueueSoftLimit waiting to be written, updates the client can miss are skipped
+	bool isSendCongested() const { return sendCongested.load(std::memory_order_relaxed); }
+
 	uint32_t getIP() const;
 	uint32_t getIP(std::string_view s) const;
 
@@ -67,6 +75,8 @@ private:
 
 	const ConnectionWeak_ptr connection;
 	xtea::round_keys key;
+	// set by the connection on a network thread, read by the dispatcher
+	std::atomic<bool> sendCongested{false};
 	bool encryptionEnabled = false;
 	bool checksumEnabled = true;
 	bool rawMessages = false;
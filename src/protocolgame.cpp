@@ -8,10 +8,13 @@
 #include "actions.h"
 #include "ban.h"
 #include "configmanager.h"
+#include "flathashmap.h"
 #include "game.h"
 #include "iologindata.h"
+#include "metrics.h"
 #include "outputmessage.h"
 #include "player.h"
+#include "replay.h"
 #include "scheduler.h"
 
 extern ConfigManager g_config;
@@ -24,6 +27,33 @@ using WaitList = std::deque<std::pair<int64_t, uint32_t>>; // (timeout, player g
 
 WaitList priorityWaitList, waitList;
 
+std::deque<MetricCounter> createMessageByteCounters()
+{
+	std::deque<MetricCounter> counters;
+	for (uint32_t opcode = 0; opcode <= std::numeric_limits<uint8_t>::max(); ++opcode) {
+		counters.emplace_back(
+		    "tfs_message_sent_bytes_total", "Bytes of server messages queued for clients by opcode.",
+		    fmt::format("opcode=\"0x{:02X}\",type=\"{:s}\"", opcode,
+		                getOutboundMessageTypeName(getOutboundMessageType(static_cast<uint8_t>(opcode)))));
+	}
+	return counters;
+}
+
+std::deque<MetricHistogram> createMessageSizeHistograms()
+{
+	std::deque<MetricHistogram> histograms;
+	for (uint8_t type = 0; type < OUTBOUND_MESSAGE_LAST; ++type) {
+		histograms.emplace_back("tfs_message_size_bytes", "Size of server messages queued for clients by type.",
+		                        std::vector<uint64_t>{8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384},
+		                        fmt::format("type=\"{:s}\"",
+		                                    getOutboundMessageTypeName(static_cast<OutboundMessageType>(type))));
+	}
+	return histograms;
+}
+
+std::deque<MetricCounter> messageBytesSent = createMessageByteCounters();
+std::deque<MetricHistogram> messageSizes = createMessageSizeHistograms();
+
 std::tuple<WaitList&, WaitList::iterator, WaitList::size_type> findClient(const Player& player)
 {
 	const auto fn = [&](const WaitList::value_type& it) { return it.second == player.getGUID(); };
@@ -115,12 +145,101 @@ std::size_t clientLogin(const Player& player)
 	return currentSlot;
 }
 
+constexpr size_t TILE_DESCRIPTION_CACHE_SIZE = 1 << 15;
+
+// the item part of a tile description, which is the same for every player not standing on the tile
+struct TileDescription
+{
+	uint32_t version = 0; // tile versions start at 1
+	// ground and top items come first, the down items follow and end at downItemEnds
+	std::vector<uint8_t> bytes;
+	uint16_t topItemsLength = 0;
+	uint8_t topItemsCount = 0;
+	uint8_t downItemsCount = 0;
+	std::array<uint16_t, MAX_STACKPOS_THINGS> downItemEnds;
+};
+
+/**
+ * LRU cache of TileDescriptions keyed by tile and client flavour, an entry is rebuilt once its tile's version moves on.
+ * Dispatcher thread only.
+ */
+class TileDescriptionCache
+{
+public:
+	const TileDescription& get(const Tile* tile, bool isOTCv8)
+	{
+		const uint64_t key = reinterpret_cast<uintptr_t>(tile) | (isOTCv8 ? 1 : 0);
+		if (auto* it = entries.find(key)) {
+			lru.splice(lru.begin(), lru, *it);
+		} else {
+			if (lru.size() >= TILE_DESCRIPTION_CACHE_SIZE) {
+				entries.erase(lru.back().first);
+				lru.pop_back();
+			}
+			lru.emplace_front(key, TileDescription{});
+			entries[key] = lru.begin();
+		}
+
+		TileDescription& description = lru.front().second;
+		if (description.version != tile->getVersion()) {
+			build(description, tile, isOTCv8);
+		}
+		return description;
+	}
+
+private:
+	void build(TileDescription& description, const Tile* tile, bool isOTCv8)
+	{
+		scratch.reset();
+		int32_t count = 0;
+		if (const auto ground = tile->getGround()) {
+			scratch.addItem(ground, isOTCv8);
+			++count;
+		}
+
+		const TileItemVector* items = tile->getItemList();
+		if (items) {
+			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
+				scratch.addItem(*it, isOTCv8);
+				if (++count == MAX_STACKPOS_THINGS) {
+					break;
+				}
+			}
+		}
+
+		description.topItemsLength = scratch.getLength();
+		description.topItemsCount = static_cast<uint8_t>(count);
+
+		// at most this many down items fit when no creature is visible
+		description.downItemsCount = 0;
+		if (items) {
+			for (auto it = items->getBeginDownItem(), end = items->getEndDownItem();
+			     it != end && count < MAX_STACKPOS_THINGS; ++it, ++count) {
+				scratch.addItem(*it, isOTCv8);
+				description.downItemEnds[description.downItemsCount++] = scratch.getLength();
+			}
+		}
+
+		const uint8_t* first = scratch.getBuffer() + NetworkMessage::INITIAL_BUFFER_POSITION;
+		description.bytes.assign(first, first + scratch.getLength());
+		description.version = tile->getVersion();
+	}
+
+	using LruList = std::list<std::pair<uint64_t, TileDescription>>;
+	LruList lru;
+	FlatHashMap<uint64_t, LruList::iterator> entries{TILE_DESCRIPTION_CACHE_SIZE * 2};
+	NetworkMessage scratch;
+};
+
+TileDescriptionCache tileDescriptionCache;
+
 } // namespace
 
 void ProtocolGame::release()
 {
 	// dispatcher thread
 	if (player && player->client == shared_from_this()) {
+		g_replayRecorder.recordLogout(player->getGUID());
 		player->client.reset();
 		player->decrementReferenceCounter();
 		player = nullptr;
@@ -201,31 +320,11 @@ void ProtocolGame::login(uint32_t characterId, uint32_t accountId, OperatingSyst
 			return;
 		}
 
-		if (!IOLoginData::loadPlayerById(player, player->getGUID())) {
-			disconnectClient("Your character could not be loaded.");
-			return;
-		}
-
-		player->setOperatingSystem(operatingSystem);
-
-		if (isAccountManager) {
-			player->accountNumber = accountId;
-		}
-
-		if (!g_game.placeCreature(player, player->getLoginPosition())) {
-			if (!g_game.placeCreature(player, player->getTemplePosition(), false, true)) {
-				disconnectClient("Temple position is wrong. Contact the administrator.");
-				return;
-			}
-		}
-
-		if (operatingSystem >= CLIENTOS_OTCLIENT_LINUX) {
-			player->registerCreatureEvent("ExtendedOpcode");
-		}
-
-		player->lastIP = player->getIP();
-		player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
-		acceptPackets = true;
+		// the game keeps running while the rows are fetched
+		IOLoginData::loadPlayerAsync(
+		    player->getGUID(), [=, thisPtr = getThis(), loadingPlayer = player](PlayerLoadData* data) {
+			    thisPtr->finishLogin(loadingPlayer, data, accountId, isAccountManager, operatingSystem);
+		    });
 	} else {
 		if (eventConnect != 0 || !g_config[ConfigKeysBoolean::REPLACE_KICK_ON_LOGIN]) {
 			// Already trying to connect
@@ -245,7 +344,55 @@ void ProtocolGame::login(uint32_t characterId, uint32_t accountId, OperatingSyst
 			connect(foundPlayer->getID(), operatingSystem);
 		}
 	}
-	OutputMessagePool::getInstance().addProtocolToAutosend(shared_from_this());
+}
+
+void ProtocolGame::finishLogin(Player* loadingPlayer, PlayerLoadData* data, uint32_t accountId, bool isAccountManager,
+                               OperatingSystem_t operatingSystem)
+{
+	// dispatcher thread
+	if (player != loadingPlayer || (isConnectionExpired() && !replaying)) {
+		// the client went away while the player was loading
+		return;
+	}
+
+	if (!data || !IOLoginData::loadPlayer(player, *data)) {
+		disconnectClient("Your character could not be loaded.");
+		return;
+	}
+
+	// someone else may have logged in while the rows were fetched
+	if (!g_config[ConfigKeysBoolean::ALLOW_CLONES] && !isAccountManager && g_game.getPlayerByGUID(player->getGUID())) {
+		disconnectClient("You are already logged in.");
+		return;
+	}
+
+	if (g_config[ConfigKeysBoolean::ONE_PLAYER_ON_ACCOUNT] && !isAccountManager &&
+	    player->getAccountType() < ACCOUNT_TYPE_GAMEMASTER && g_game.getPlayerByAccount(player->getAccount())) {
+		disconnectClient("You may only login with one character\nof your account at the same time.");
+		return;
+	}
+
+	player->setOperatingSystem(operatingSystem);
+
+	if (isAccountManager) {
+		player->accountNumber = accountId;
+	}
+
+	if (!g_game.placeCreature(player, player->getLoginPosition())) {
+		if (!g_game.placeCreature(player, player->getTemplePosition(), false, true)) {
+			disconnectClient("Temple position is wrong. Contact the administrator.");
+			return;
+		}
+	}
+
+	if (operatingSystem >= CLIENTOS_OTCLIENT_LINUX) {
+		player->registerCreatureEvent("ExtendedOpcode");
+	}
+
+	player->lastIP = player->getIP();
+	player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
+	g_replayRecorder.recordLogin(player->getGUID(), accountId, operatingSystem);
+	acceptPackets = true;
 }
 
 void ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem)
@@ -258,7 +405,7 @@ void ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem)
 		return;
 	}
 
-	if (isConnectionExpired()) {
+	if (isConnectionExpired() && !replaying) {
 		// ProtocolGame::release() has been called at this point and the Connection object
 		// no longer exists, so we return to prevent leakage of the Player.
 		return;
@@ -277,6 +424,7 @@ void ProtocolGame::connect(uint32_t playerId, OperatingSystem_t operatingSystem)
 	player->lastIP = player->getIP();
 	player->lastLoginSaved = std::max<time_t>(time(nullptr), player->lastLoginSaved + 1);
 	player->resetIdleTime();
+	g_replayRecorder.recordLogin(player->getGUID(), player->getAccount(), operatingSystem);
 	acceptPackets = true;
 }
 
@@ -463,6 +611,140 @@ void ProtocolGame::writeToOutputBuffer(const NetworkMessage& msg)
 {
 	auto out = getOutputBuffer(msg.getLength());
 	out->append(msg);
+
+	// messages are tagged by their first opcode, a move followed by the tiles it revealed counts as a move
+	const uint32_t size = msg.getLength();
+	if (size != 0) {
+		const uint8_t opcode = msg.getBuffer()[NetworkMessage::INITIAL_BUFFER_POSITION];
+		const OutboundMessageType type = getOutboundMessageType(opcode);
+		messageBytesSent[opcode].add(size);
+		messageSizes[type].observe(size);
+		sentStats.bytes[type] += size;
+		sentStats.rate.record(size, OTSYS_TIME());
+	}
+}
+
+void ClientRateHistory::record(uint32_t amount, int64_t now)
+{
+	// clear the seconds skipped since the last record before adding to this one
+	const int64_t second = now / 1000;
+	const int64_t last = lastSecond.load(std::memory_order_relaxed);
+	if (second != last) {
+		for (int64_t skipped = std::max(last + 1, second - static_cast<int64_t>(CLIENT_RATE_HISTORY) + 1);
+		     skipped <= second; ++skipped) {
+			seconds[skipped % CLIENT_RATE_HISTORY].store(0, std::memory_order_relaxed);
+		}
+		lastSecond.store(second, std::memory_order_relaxed);
+	}
+	seconds[second % CLIENT_RATE_HISTORY].fetch_add(amount, std::memory_order_relaxed);
+}
+
+std::array<uint32_t, CLIENT_RATE_HISTORY> ClientRateHistory::get(int64_t now) const
+{
+	std::array<uint32_t, CLIENT_RATE_HISTORY> history = {};
+	const int64_t second = now / 1000;
+	const int64_t last = lastSecond.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < CLIENT_RATE_HISTORY; ++i) {
+		// seconds nothing was recorded in were never cleared
+		const int64_t historySecond = second - static_cast<int64_t>(CLIENT_RATE_HISTORY) + static_cast<int64_t>(i);
+		if (historySecond <= last && historySecond > last - static_cast<int64_t>(CLIENT_RATE_HISTORY)) {
+			history[i] = seconds[historySecond % CLIENT_RATE_HISTORY].load(std::memory_order_relaxed);
+		}
+	}
+	return history;
+}
+
+OutboundMessageType getOutboundMessageType(uint8_t opcode)
+{
+	switch (opcode) {
+		case 0x64: // map description
+		case 0x65:
+		case 0x66:
+		case 0x67:
+		case 0x68: // map slices
+		case 0x69: // tile
+		case 0x6A:
+		case 0x6B:
+		case 0x6C: // tile things
+		case 0xBE:
+		case 0xBF: // floor changes
+			return OUTBOUND_MESSAGE_MAP;
+
+		case 0x6D: // move creature
+		case 0x86: // square
+		case 0x8C: // health
+		case 0x8D: // light
+		case 0x8E: // outfit
+		case 0x8F: // speed
+		case 0x90: // skull
+		case 0x91: // shield
+		case 0x92: // walkthrough
+		case 0xA3: // cancel target
+		case 0xB5: // cancel walk
+			return OUTBOUND_MESSAGE_CREATURES;
+
+		case 0x82: // world light
+		case 0x83: // magic effect
+		case 0x84: // animated text
+		case 0x85: // distance shoot
+			return OUTBOUND_MESSAGE_EFFECTS;
+
+		case 0x15: // fyi box
+		case 0x96:
+		case 0x97: // text windows
+		case 0xAA: // creature say
+		case 0xAB:
+		case 0xAC:
+		case 0xAD:
+		case 0xB2:
+		case 0xB3: // channels
+		case 0xB4: // text message
+			return OUTBOUND_MESSAGE_TEXT;
+
+		case 0xA0: // stats
+		case 0xA1: // skills
+		case 0xA2: // icons
+		case 0xA7: // fight modes
+			return OUTBOUND_MESSAGE_STATS;
+
+		case 0x6E:
+		case 0x6F:
+		case 0x70:
+		case 0x71:
+		case 0x72: // containers
+		case 0x78:
+		case 0x79: // inventory
+		case 0x7A:
+		case 0x7B:
+		case 0x7C: // shop
+		case 0x7D:
+		case 0x7E:
+		case 0x7F: // trade
+			return OUTBOUND_MESSAGE_ITEMS;
+
+		default:
+			return OUTBOUND_MESSAGE_OTHER;
+	}
+}
+
+const char* getOutboundMessageTypeName(OutboundMessageType type)
+{
+	switch (type) {
+		case OUTBOUND_MESSAGE_MAP:
+			return "map";
+		case OUTBOUND_MESSAGE_CREATURES:
+			return "creatures";
+		case OUTBOUND_MESSAGE_EFFECTS:
+			return "effects";
+		case OUTBOUND_MESSAGE_TEXT:
+			return "text";
+		case OUTBOUND_MESSAGE_STATS:
+			return "stats";
+		case OUTBOUND_MESSAGE_ITEMS:
+			return "items";
+		default:
+			return "other";
+	}
 }
 
 void ProtocolGame::parsePacket(NetworkMessage& msg)
@@ -471,7 +753,17 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 		return;
 	}
 
+	if (player && g_replayRecorder.isRecording()) {
+		g_replayRecorder.recordPacket(player->getGUID(), msg);
+	}
+
 	uint8_t recvbyte = msg.getByte();
+	metrics::packetsReceived(recvbyte).add();
+	metrics::packetBytes(recvbyte).add(msg.getLength());
+	packetStats.record(recvbyte, msg.getLength(), OTSYS_TIME());
+
+	// every task posted while handling this packet is attributed to its opcode
+	TaskOriginScope originScope{makeTaskOrigin(TASK_ORIGIN_PACKET, recvbyte)};
 
 	if (!player) {
 		if (recvbyte == 0x0F) {
@@ -760,14 +1052,18 @@ void ProtocolGame::parsePacket(NetworkMessage& msg)
 
 void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage& msg)
 {
+	const bool isStacked = player->getPosition() == tile->getPosition();
+	if (!isStacked) {
+		GetCachedTileDescription(tile, msg);
+		return;
+	}
+
 	int32_t count = 0;
 	if (const auto ground = tile->getGround()) {
 		msg.addItem(ground, isOTCv8);
 		++count;
 	}
 
-	const bool isStacked = player->getPosition() == tile->getPosition();
-
 	const TileItemVector* items = tile->getItemList();
 	if (items) {
 		for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
@@ -818,6 +1114,40 @@ void ProtocolGame::GetTileDescription(const Tile* tile, NetworkMessage& msg)
 	}
 }
 
+void ProtocolGame::GetCachedTileDescription(const Tile* tile, NetworkMessage& msg)
+{
+	const TileDescription& description = tileDescriptionCache.get(tile, isOTCv8);
+	msg.addBytes(reinterpret_cast<const char*>(description.bytes.data()), description.topItemsLength);
+
+	int32_t count = description.topItemsCount;
+	if (count == MAX_STACKPOS_THINGS && !isOTCv8) {
+		return;
+	}
+
+	if (const CreatureVector* creatures = tile->getCreatures()) {
+		for (auto it = creatures->rbegin(), end = creatures->rend(); it != end; ++it) {
+			const Creature* creature = (*it);
+			if (!player->canSeeCreature(creature)) {
+				continue;
+			}
+
+			auto [known, removedKnown] = isKnownCreature(creature->getID());
+			AddCreature(msg, creature, known, removedKnown);
+
+			if (++count == MAX_STACKPOS_THINGS && !isOTCv8) {
+				return;
+			}
+		}
+	}
+
+	if (count < MAX_STACKPOS_THINGS && description.downItemsCount > 0) {
+		size_t downItems = std::min<size_t>(description.downItemsCount, MAX_STACKPOS_THINGS - count);
+		const uint16_t end = description.downItemEnds[downItems - 1];
+		msg.addBytes(reinterpret_cast<const char*>(description.bytes.data()) + description.topItemsLength,
+		             end - description.topItemsLength);
+	}
+}
+
 void ProtocolGame::GetMapDescription(int32_t x, int32_t y, int32_t z, int32_t width, int32_t height,
                                      NetworkMessage& msg)
 {
@@ -847,11 +1177,14 @@ void ProtocolGame::GetMapDescription(int32_t x, int32_t y, int32_t z, int32_t wi
 void ProtocolGame::GetFloorDescription(NetworkMessage& msg, int32_t x, int32_t y, int32_t z, int32_t width,
                                        int32_t height, int32_t offset, int32_t& skip)
 {
+	thread_local std::vector<Tile*> tiles;
+	tiles.resize(width * height);
+	g_game.map.getTiles(static_cast<uint16_t>(x + offset), static_cast<uint16_t>(y + offset), static_cast<uint8_t>(z),
+	                    static_cast<uint16_t>(width), static_cast<uint16_t>(height), tiles.data());
+
 	for (int32_t nx = 0; nx < width; nx++) {
 		for (int32_t ny = 0; ny < height; ny++) {
-			Tile* tile = g_game.map.getTile(static_cast<uint16_t>(x + nx + offset),
-			                                static_cast<uint16_t>(y + ny + offset), static_cast<uint8_t>(z));
-			if (tile) {
+			if (Tile* tile = tiles[ny * width + nx]) {
 				if (skip >= 0) {
 					msg.addByte(static_cast<uint8_t>(skip));
 					msg.addByte(0xFF);
@@ -872,31 +1205,39 @@ void ProtocolGame::GetFloorDescription(NetworkMessage& msg, int32_t x, int32_t y
 
 std::pair<bool, uint32_t> ProtocolGame::isKnownCreature(uint32_t id)
 {
-	auto result = knownCreatureSet.insert(id);
-	if (!result.second) {
+	uint64_t& stamp = knownCreatures[id];
+	const bool known = stamp != 0;
+	stamp = ++knownCreatureStamp;
+	if (known) {
 		return std::make_pair(true, 0);
 	}
 
-	if (knownCreatureSet.size() > 250) {
-		// Look for a creature to remove
-		for (const uint32_t& creatureId : knownCreatureSet) {
-			Creature* creature = g_game.getCreatureByID(creatureId);
-			if (!canSee(creature)) {
-				knownCreatureSet.erase(creatureId);
-				return std::make_pair(false, creatureId);
-			}
+	if (knownCreatures.size() <= maxKnownCreatures) {
+		return {};
+	}
+
+	// the least recently used creature out of sight goes, or the least recently used one if all can be seen
+	uint32_t removedId = 0, hiddenId = 0;
+	uint64_t removedStamp = std::numeric_limits<uint64_t>::max(), hiddenStamp = removedStamp;
+	knownCreatures.forEach([&, this](uint32_t creatureId, uint64_t used) {
+		if (creatureId == id || (used >= removedStamp && used >= hiddenStamp)) {
+			return;
 		}
 
-		// Bad situation. Let's just remove anyone.
-		auto creatureId = knownCreatureSet.begin();
-		if (*creatureId == id) {
-			++creatureId;
+		if (used < hiddenStamp && !canSee(g_game.getCreatureByID(creatureId))) {
+			hiddenId = creatureId;
+			hiddenStamp = used;
+		} else if (used < removedStamp) {
+			removedId = creatureId;
+			removedStamp = used;
 		}
+	});
 
-		knownCreatureSet.erase(creatureId);
-		return std::make_pair(false, *creatureId);
+	if (hiddenId != 0) {
+		removedId = hiddenId;
 	}
-	return {};
+	knownCreatures.erase(removedId);
+	return std::make_pair(false, removedId);
 }
 
 bool ProtocolGame::canSee(const Creature* c) const
@@ -1159,8 +1500,10 @@ void ProtocolGame::parseSay(NetworkMessage& msg)
 		return;
 	}
 
-	g_dispatcher.addTask([=, playerID = player->getID(), receiver = std::string{receiver}, text = std::string{text}]() {
-		g_game.playerSay(playerID, channelId, type, receiver, text);
+	// two strings do not fit inline in the task
+	auto strings = std::make_unique<std::pair<std::string, std::string>>(receiver, text);
+	g_dispatcher.addTask([=, playerID = player->getID(), strings = std::move(strings)]() {
+		g_game.playerSay(playerID, channelId, type, strings->first, strings->second);
 	});
 }
 
@@ -1304,9 +1647,16 @@ void ProtocolGame::parseRuleViolationReport(NetworkMessage& msg)
 		msg.get<uint32_t>(); // statement id, used to get whatever player have said, we don't log that.
 	}
 
-	g_dispatcher.addTask([=, playerID = player->getID(), targetName = std::string{targetName},
-	                      comment = std::string{comment}, translation = std::string{translation}]() {
-		g_game.playerReportRuleViolation(playerID, targetName, reportType, reportReason, comment, translation);
+	struct Report
+	{
+		std::string targetName, comment, translation;
+	};
+
+	// the strings do not fit inline in the task
+	auto report = std::make_unique<Report>(std::string{targetName}, std::string{comment}, std::string{translation});
+	g_dispatcher.addTask([=, playerID = player->getID(), report = std::move(report)]() {
+		g_game.playerReportRuleViolation(playerID, report->targetName, reportType, reportReason, report->comment,
+		                                 report->translation);
 	});
 }
 
@@ -1572,8 +1922,8 @@ void ProtocolGame::sendContainer(uint8_t cid, const Container* container, bool h
 	msg.addByte(static_cast<uint8_t>(std::min<uint32_t>(0xFF, container->size())));
 
 	uint32_t i = 0;
-	const ItemDeque& itemList = container->getItemList();
-	for (ItemDeque::const_iterator cit = itemList.begin() + firstIndex, end = itemList.end(); i < 0xFF && cit != end;
+	const ItemVector& itemList = container->getItemList();
+	for (ItemVector::const_iterator cit = itemList.begin() + firstIndex, end = itemList.end(); i < 0xFF && cit != end;
 	     ++cit, ++i) {
 		msg.addItem(*cit, isOTCv8);
 	}
@@ -1763,6 +2113,13 @@ void ProtocolGame::sendCreatureSay(const Creature* creature, SpeakClasses type,
 	}
 
 	NetworkMessage msg;
+	buildCreatureSay(msg, creature, type, text, pos);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::buildCreatureSay(NetworkMessage& msg, const Creature* creature, SpeakClasses type,
+                                    std::string_view text, const Position* pos /* = nullptr*/)
+{
 	msg.addByte(0xAA);
 	msg.add<uint32_t>(0x00);
 
@@ -1787,7 +2144,6 @@ void ProtocolGame::sendCreatureSay(const Creature* creature, SpeakClasses type,
 	}
 
 	msg.addString(text);
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendToChannel(const Creature* creature, SpeakClasses type, std::string_view text, uint16_t channelId)
@@ -1797,6 +2153,13 @@ void ProtocolGame::sendToChannel(const Creature* creature, SpeakClasses type, st
 	}
 
 	NetworkMessage msg;
+	buildToChannel(msg, creature, type, text, channelId);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::buildToChannel(NetworkMessage& msg, const Creature* creature, SpeakClasses type,
+                                  std::string_view text, uint16_t channelId)
+{
 	msg.addByte(0xAA);
 	msg.add<uint32_t>(0x00);
 
@@ -1820,7 +2183,6 @@ void ProtocolGame::sendToChannel(const Creature* creature, SpeakClasses type, st
 	msg.addByte(type);
 	msg.add<uint16_t>(channelId);
 	msg.addString(text);
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendPrivateMessage(const Player* speaker, SpeakClasses type, std::string_view text)
@@ -1885,6 +2247,10 @@ void ProtocolGame::sendPing()
 
 void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, uint8_t type)
 {
+	if (isSendCongested()) {
+		return;
+	}
+
 	NetworkMessage msg;
 	msg.addByte(0x85);
 	msg.addPosition(from);
@@ -1895,7 +2261,7 @@ void ProtocolGame::sendDistanceShoot(const Position& from, const Position& to, u
 
 void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 {
-	if (!canSee(pos)) {
+	if (isSendCongested() || !canSee(pos)) {
 		return;
 	}
 
@@ -1909,6 +2275,12 @@ void ProtocolGame::sendMagicEffect(const Position& pos, uint8_t type)
 void ProtocolGame::sendCreatureHealth(const Creature* creature)
 {
 	NetworkMessage msg;
+	buildCreatureHealth(msg, creature);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::buildCreatureHealth(NetworkMessage& msg, const Creature* creature)
+{
 	msg.addByte(0x8C);
 	msg.add<uint32_t>(creature->getID());
 
@@ -1918,7 +2290,6 @@ void ProtocolGame::sendCreatureHealth(const Creature* creature)
 		msg.addByte(std::ceil(
 		    (static_cast<double>(creature->getHealth()) / std::max<int32_t>(creature->getMaxHealth(), 1)) * 100));
 	}
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendFYIBox(std::string_view message)
@@ -2053,6 +2424,7 @@ void ProtocolGame::sendAddCreature(const Creature* creature, const Position& pos
 		return;
 	}
 
+	// the login is written as the map and the player state around it instead of a message for every part of it
 	NetworkMessage msg;
 	msg.addByte(0x0A);
 
@@ -2066,40 +2438,54 @@ void ProtocolGame::sendAddCreature(const Creature* creature, const Position& pos
 		msg.addByte(0x00);
 	}
 
-	writeToOutputBuffer(msg);
-
-	sendMapDescription(pos);
+	msg.addByte(0x64);
+	msg.addPosition(player->getPosition());
+	GetMapDescription(pos.x - Map::maxClientViewportX, pos.y - Map::maxClientViewportY, pos.z,
+	                  (Map::maxClientViewportX * 2) + 2, (Map::maxClientViewportY * 2) + 2, msg);
 
 	if (magicEffect != CONST_ME_NONE) {
-		sendMagicEffect(pos, magicEffect);
+		msg.addByte(0x83);
+		msg.addPosition(pos);
+		msg.addByte(magicEffect);
 	}
+	writeToOutputBuffer(msg);
 
+	msg.reset();
 	for (int i = CONST_SLOT_FIRST; i <= CONST_SLOT_LAST; ++i) {
-		sendInventoryItem(static_cast<slots_t>(i), player->getInventoryItem(static_cast<slots_t>(i)));
+		AddInventoryItem(msg, static_cast<slots_t>(i), player->getInventoryItem(static_cast<slots_t>(i)));
 	}
 
-	sendStats();
-	sendSkills();
+	AddPlayerStats(msg);
+	AddPlayerSkills(msg);
 
 	// player light level
-	sendCreatureLight(creature);
+	AddCreatureLight(msg, creature);
 
-	const std::forward_list<VIPEntry>& vipEntries = IOLoginData::getVIPEntries(player->getAccount());
-	for (const VIPEntry& entry : vipEntries) {
-		Player* vipPlayer = g_game.getPlayerByGUID(entry.guid);
+	for (const auto& [vipGuid, vipName] : player->getVIPList()) {
+		// a long vip list does not fit in one message
+		if (msg.getLength() + vipName.size() + 16 > NetworkMessage::MAX_PROTOCOL_BODY_LENGTH) {
+			writeToOutputBuffer(msg);
+			msg.reset();
+		}
 
-		sendVIP(entry.guid, entry.name,
-		        static_cast<VipStatus_t>((vipPlayer && (!vipPlayer->isInGhostMode() || player->isAccessPlayer()))));
+		Player* vipPlayer = g_game.getPlayerByGUID(vipGuid);
+		AddVIP(msg, vipGuid, vipName,
+		       static_cast<VipStatus_t>((vipPlayer && (!vipPlayer->isInGhostMode() || player->isAccessPlayer()))));
 	}
 
-	player->sendIcons();
+	msg.addByte(0xA2);
+	msg.add<uint16_t>(player->getClientIcons());
+	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& newPos, int32_t newStackPos,
                                     const Position& oldPos, int32_t oldStackPos, bool teleport)
 {
 	if (creature == player) {
-		if (teleport || oldStackPos >= MAX_STACKPOS_THINGS) {
+		// a teleport next to the old position, like a ladder or a rope spot, shifts the view the client already has
+		// the way a step does, so only the floor and the strips it did not know are sent
+		const bool viewShift = !teleport || (oldPos != newPos && newPos.isInRange(oldPos, 1, 1, 1));
+		if (!viewShift || oldStackPos >= MAX_STACKPOS_THINGS) {
 			sendRemoveTileThing(oldPos, oldStackPos);
 			sendMapDescription(newPos);
 		} else {
@@ -2169,6 +2555,12 @@ void ProtocolGame::sendMoveCreature(const Creature* creature, const Position& ne
 void ProtocolGame::sendInventoryItem(slots_t slot, const Item* item)
 {
 	NetworkMessage msg;
+	AddInventoryItem(msg, slot, item);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::AddInventoryItem(NetworkMessage& msg, slots_t slot, const Item* item)
+{
 	if (item) {
 		msg.addByte(0x78);
 		msg.addByte(slot);
@@ -2177,7 +2569,6 @@ void ProtocolGame::sendInventoryItem(slots_t slot, const Item* item)
 		msg.addByte(0x79);
 		msg.addByte(slot);
 	}
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendModalWindow(const ModalWindow& modalWindow)
@@ -2385,25 +2776,36 @@ void ProtocolGame::sendUpdatedVIPStatus(uint32_t guid, VipStatus_t newStatus)
 void ProtocolGame::sendVIP(uint32_t guid, std::string_view name, VipStatus_t status)
 {
 	NetworkMessage msg;
+	AddVIP(msg, guid, name, status);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::AddVIP(NetworkMessage& msg, uint32_t guid, std::string_view name, VipStatus_t status)
+{
 	msg.addByte(0xD2);
 	msg.add<uint32_t>(guid);
 	msg.addString(name);
 	msg.addByte(status);
-	writeToOutputBuffer(msg);
 }
 
 void ProtocolGame::sendAnimatedText(std::string_view message, const Position& pos, TextColor_t color)
 {
-	if (!canSee(pos)) {
+	if (isSendCongested() || !canSee(pos)) {
 		return;
 	}
 
 	NetworkMessage msg;
+	buildAnimatedText(msg, message, pos, color);
+	writeToOutputBuffer(msg);
+}
+
+void ProtocolGame::buildAnimatedText(NetworkMessage& msg, std::string_view message, const Position& pos,
+                                     TextColor_t color)
+{
 	msg.addByte(0x84);
 	msg.addPosition(pos);
 	msg.addByte(color);
 	msg.addString(message);
-	writeToOutputBuffer(msg);
 }
 
 ////////////// Add common messages
@@ -2556,12 +2958,17 @@ void ProtocolGame::AddWorldLight(NetworkMessage& msg, LightInfo lightInfo)
 }
 
 void ProtocolGame::AddCreatureLight(NetworkMessage& msg, const Creature* creature)
+{
+	buildCreatureLight(msg, creature, player->isAccessPlayer());
+}
+
+void ProtocolGame::buildCreatureLight(NetworkMessage& msg, const Creature* creature, bool fullLight)
 {
 	LightInfo lightInfo = creature->getCreatureLight();
 
 	msg.addByte(0x8D);
 	msg.add<uint32_t>(creature->getID());
-	msg.addByte((player->isAccessPlayer() ? 0xFF : lightInfo.level));
+	msg.addByte(fullLight ? 0xFF : lightInfo.level);
 	msg.addByte(lightInfo.color);
 }
 
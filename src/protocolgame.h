@@ -6,11 +6,13 @@
 
 #include "chat.h"
 #include "creature.h"
+#include "flathashmap.h"
 #include "protocol.h"
 #include "tasks.h"
 
 class NetworkMessage;
 class Player;
+struct PlayerLoadData;
 class Game;
 class House;
 class Container;
@@ -40,6 +42,68 @@ struct TextMessage
 inline constexpr auto OTCV8_NAME = "OTCv8";
 inline constexpr auto OTCV8_LENGTH = 5;
 
+// seconds of traffic history kept per client
+inline constexpr size_t CLIENT_RATE_HISTORY = 16;
+
+// amounts summed per second over the last CLIENT_RATE_HISTORY seconds, one thread records and any thread may read
+class ClientRateHistory
+{
+public:
+	void record(uint32_t amount, int64_t now);
+	// the last full seconds, oldest first
+	std::array<uint32_t, CLIENT_RATE_HISTORY> get(int64_t now) const;
+
+private:
+	std::array<std::atomic<uint32_t>, CLIENT_RATE_HISTORY> seconds = {};
+	std::atomic<int64_t> lastSecond{0};
+};
+
+// packets a client sent, written by the network thread and read from the dispatcher
+class ClientPacketStats
+{
+public:
+	void record(uint8_t opcode, uint32_t size, int64_t now)
+	{
+		counts[opcode].fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(size, std::memory_order_relaxed);
+		rate.record(1, now);
+	}
+
+	uint32_t getCount(uint8_t opcode) const { return counts[opcode].load(std::memory_order_relaxed); }
+	uint64_t getBytes() const { return bytes.load(std::memory_order_relaxed); }
+	// packets received in each of the last full seconds, oldest first
+	std::array<uint32_t, CLIENT_RATE_HISTORY> getRateHistory(int64_t now) const { return rate.get(now); }
+
+private:
+	std::array<std::atomic<uint32_t>, 256> counts = {};
+	std::atomic<uint64_t> bytes{0};
+	ClientRateHistory rate;
+};
+
+// what a server message carries, taken from its opcode
+enum OutboundMessageType : uint8_t
+{
+	OUTBOUND_MESSAGE_MAP,       // map descriptions and tile updates
+	OUTBOUND_MESSAGE_CREATURES, // creature moves, health, outfits, light...
+	OUTBOUND_MESSAGE_EFFECTS,   // magic effects, missiles and animated text
+	OUTBOUND_MESSAGE_TEXT,      // speech, channels and text messages
+	OUTBOUND_MESSAGE_STATS,     // stats, skills and icons
+	OUTBOUND_MESSAGE_ITEMS,     // inventory, containers, trade and shops
+	OUTBOUND_MESSAGE_OTHER,
+
+	OUTBOUND_MESSAGE_LAST /* this must be the last one */
+};
+
+OutboundMessageType getOutboundMessageType(uint8_t opcode);
+const char* getOutboundMessageTypeName(OutboundMessageType type);
+
+// bytes queued for a client, dispatcher thread only
+struct ClientSentStats
+{
+	std::array<uint64_t, OUTBOUND_MESSAGE_LAST> bytes = {};
+	ClientRateHistory rate;
+};
+
 class ProtocolGame final : public Protocol
 {
 public:
@@ -61,10 +125,23 @@ public:
 	explicit ProtocolGame(Connection_ptr connection) : Protocol(connection) {}
 
 	void login(uint32_t characterId, uint32_t accountId, OperatingSystem_t operatingSystem);
+	void finishLogin(Player* loadingPlayer, PlayerLoadData* data, uint32_t accountId, bool isAccountManager,
+	                 OperatingSystem_t operatingSystem);
 	void logout(bool displayEffect, bool forced);
 
 	uint16_t getVersion() const { return version; }
 
+	// packets that are identical for every receiver, built once and then appended to each spectator's output
+	static void buildCreatureSay(NetworkMessage& msg, const Creature* creature, SpeakClasses type,
+	                             std::string_view text, const Position* pos = nullptr);
+	static void buildToChannel(NetworkMessage& msg, const Creature* creature, SpeakClasses type, std::string_view text,
+	                           uint16_t channelId);
+	static void buildCreatureHealth(NetworkMessage& msg, const Creature* creature);
+	// fullLight for the receivers that see every creature at full light level
+	static void buildCreatureLight(NetworkMessage& msg, const Creature* creature, bool fullLight);
+	static void buildAnimatedText(NetworkMessage& msg, std::string_view message, const Position& pos,
+	                              TextColor_t color);
+
 private:
 	ProtocolGame_ptr getThis() { return std::static_pointer_cast<ProtocolGame>(shared_from_this()); }
 	void connect(uint32_t playerId, OperatingSystem_t operatingSystem);
@@ -189,6 +266,25 @@ private:
 	void sendFightModes();
 
 	void sendAnimatedText(std::string_view message, const Position& pos, TextColor_t color);
+	void sendSharedMessage(const NetworkMessage& msg) { writeToOutputBuffer(msg); }
+	void sendSharedMessage(const NetworkMessage& msg, const Position& pos)
+	{
+		if (canSee(pos)) {
+			writeToOutputBuffer(msg);
+		}
+	}
+	void sendSharedMessage(const NetworkMessage& msg, const Creature* creature)
+	{
+		if (canSee(creature)) {
+			writeToOutputBuffer(msg);
+		}
+	}
+	void sendSharedEffect(const NetworkMessage& msg, const Position& pos)
+	{
+		if (!isSendCongested()) {
+			sendSharedMessage(msg, pos);
+		}
+	}
 
 	void sendCreatureLight(const Creature* creature);
 
@@ -226,6 +322,8 @@ private:
 
 	// translate a tile to client-readable format
 	void GetTileDescription(const Tile* tile, NetworkMessage& msg);
+	// GetTileDescription for a tile the player is not standing on
+	void GetCachedTileDescription(const Tile* tile, NetworkMessage& msg);
 
 	// translate a floor to client-readable format
 	void GetFloorDescription(NetworkMessage& msg, int32_t x, int32_t y, int32_t z, int32_t width, int32_t height,
@@ -240,6 +338,8 @@ private:
 	void AddPlayerSkills(NetworkMessage& msg);
 	void AddWorldLight(NetworkMessage& msg, LightInfo lightInfo);
 	void AddCreatureLight(NetworkMessage& msg, const Creature* creature);
+	void AddInventoryItem(NetworkMessage& msg, slots_t slot, const Item* item);
+	static void AddVIP(NetworkMessage& msg, uint32_t guid, std::string_view name, VipStatus_t status);
 
 	// tiles
 	static void RemoveTileThing(NetworkMessage& msg, const Position& pos, uint32_t stackpos);
@@ -257,10 +357,18 @@ private:
 	void sendOTCv8Features();
 
 	friend class Player;
+	friend class ReplayPlayer;
 
-	std::unordered_set<uint32_t> knownCreatureSet;
+	// as many creatures as the client keeps, it drops the one named in the packet that adds a new one
+	static constexpr size_t maxKnownCreatures = 250;
+	// the creatures the client knows with the lookup that last used each one, sized to never grow
+	FlatHashMap<uint32_t, uint64_t> knownCreatures{maxKnownCreatures * 2 + 2};
+	uint64_t knownCreatureStamp = 0;
 	Player* player = nullptr;
 
+	ClientPacketStats packetStats;
+	ClientSentStats sentStats;
+
 	uint32_t eventConnect = 0;
 	uint32_t challengeTimestamp = 0;
 	uint16_t version = CLIENT_VERSION_MIN;
@@ -270,6 +378,8 @@ private:
 	bool isOTCv8 = false;
 	bool debugAssertSent = false;
 	bool acceptPackets = false;
+	// fed by a replay, there is no connection to lose
+	bool replaying = false;
 };
 
 #endif
@@ -7,16 +7,17 @@
 
 #include "ban.h"
 #include "configmanager.h"
+#include "databasetasks.h"
 #include "game.h"
 #include "iologindata.h"
 #include "outputmessage.h"
-#include "tasks.h"
 #include "tools.h"
 
 #include <iomanip>
 
 extern ConfigManager g_config;
 extern Game g_game;
+extern DatabaseTasks g_databaseTasks;
 
 void ProtocolLogin::disconnectClient(std::string_view message)
 {
@@ -28,9 +29,22 @@ void ProtocolLogin::disconnectClient(std::string_view message)
 }
 
 void ProtocolLogin::getCharacterList(std::string_view accountName, std::string_view password)
+{
+	// the account queries run on a database thread so a burst of logins does not stall the dispatcher, the reply only
+	// reads configuration and is sent from there as well
+	auto job = [thisPtr = std::static_pointer_cast<ProtocolLogin>(shared_from_this()),
+	            accountName = std::string{accountName}, password = std::string{password}](Database& db) {
+		thisPtr->sendCharacterList(db, accountName, password);
+	};
+	if (!g_databaseTasks.addJob(std::move(job), DATABASE_KEY_LOGINS)) {
+		disconnectClient("Server is shutting down.");
+	}
+}
+
+void ProtocolLogin::sendCharacterList(Database& db, std::string_view accountName, std::string_view password)
 {
 	Account account;
-	if (!IOLoginData::loginserverAuthentication(accountName, password, account)) {
+	if (!IOLoginData::loginserverAuthentication(db, accountName, password, account)) {
 		disconnectClient("Account name or password is not correct.");
 		return;
 	}
@@ -150,9 +164,7 @@ void ProtocolLogin::onRecvFirstMessage(NetworkMessage& msg)
 	const bool passwordEmpty = password.empty();
 
 	if (g_config[ConfigKeysBoolean::ACCOUNT_MANAGER] && accountNameEmpty && passwordEmpty) {
-		g_dispatcher.addTask([=, thisPtr = std::static_pointer_cast<ProtocolLogin>(shared_from_this())]() {
-			thisPtr->getCharacterList(ACCOUNT_MANAGER_ACCOUNT_NAME, ACCOUNT_MANAGER_ACCOUNT_PASSWORD);
-		});
+		getCharacterList(ACCOUNT_MANAGER_ACCOUNT_NAME, ACCOUNT_MANAGER_ACCOUNT_PASSWORD);
 		return;
 	}
 
@@ -166,7 +178,5 @@ void ProtocolLogin::onRecvFirstMessage(NetworkMessage& msg)
 		return;
 	}
 
-	g_dispatcher.addTask([=, thisPtr = std::static_pointer_cast<ProtocolLogin>(shared_from_this()),
-	                      accountName = std::string{accountName},
-	                      password = std::string{password}]() { thisPtr->getCharacterList(accountName, password); });
+	getCharacterList(accountName, password);
 }
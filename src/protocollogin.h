@@ -6,6 +6,7 @@
 
 #include "protocol.h"
 
+class Database;
 class NetworkMessage;
 class OutputMessage;
 
@@ -35,6 +36,7 @@ private:
 	void disconnectClient(std::string_view message);
 
 	void getCharacterList(std::string_view accountName, std::string_view password);
+	void sendCharacterList(Database& db, std::string_view accountName, std::string_view password);
 };
 
 #endif
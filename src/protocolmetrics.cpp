@@ -0,0 +1,85 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "protocolmetrics.h"
+
+#include "metrics.h"
+#include "outputmessage.h"
+
+namespace {
+
+// requests are a single line and a few headers, anything longer is not a scraper
+constexpr size_t MAX_REQUEST_SIZE = 8192;
+
+// most bytes NetworkMessage::addBytes takes at once
+constexpr size_t MAX_CHUNK_SIZE = 8192;
+
+} // namespace
+
+void ProtocolMetrics::onRecvRaw(std::string_view data)
+{
+	request += data;
+	if (request.size() > MAX_REQUEST_SIZE) {
+		disconnect();
+		return;
+	}
+
+	if (request.find("\r\n\r\n") == std::string::npos) {
+		// wait for the rest of the headers
+		return;
+	}
+
+	// request line: method, target and version separated by single spaces
+	const std::string_view line = std::string_view{request}.substr(0, request.find("\r\n"));
+	const size_t methodEnd = line.find(' ');
+	const size_t targetEnd = line.find(' ', methodEnd + 1);
+	if (methodEnd == std::string_view::npos || targetEnd == std::string_view::npos) {
+		sendResponse("400 Bad Request", {});
+		return;
+	}
+
+	if (line.substr(0, methodEnd) != "GET") {
+		sendResponse("405 Method Not Allowed", {});
+		return;
+	}
+
+	std::string_view target = line.substr(methodEnd + 1, targetEnd - methodEnd - 1);
+	target = target.substr(0, target.find('?'));
+	if (target != "/metrics" && target != "/") {
+		sendResponse("404 Not Found", {});
+		return;
+	}
+
+	sendResponse("200 OK", Metrics::getInstance().serialize());
+}
+
+void ProtocolMetrics::sendResponse(std::string_view status, std::string_view body)
+{
+	setRawMessages(true);
+
+	const std::string header = fmt::format(
+	    "HTTP/1.1 {:s}\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: {:d}\r\nConnection: close\r\n\r\n",
+	    status, body.size());
+
+	auto output = OutputMessagePool::getOutputMessage();
+	output->addBytes(header.data(), header.size());
+
+	// the exposition easily outgrows a single message, the rest follows in as many as it takes
+	while (!body.empty()) {
+		size_t room = NetworkMessage::MAX_BODY_LENGTH - 1u - output->getBufferPosition();
+		if (room == 0) {
+			send(output);
+			output = OutputMessagePool::getOutputMessage();
+			room = NetworkMessage::MAX_BODY_LENGTH - 1u - output->getBufferPosition();
+		}
+
+		const size_t size = std::min({body.size(), MAX_CHUNK_SIZE, room});
+		output->addBytes(body.data(), size);
+		body.remove_prefix(size);
+	}
+
+	send(output);
+	disconnect();
+}
@@ -0,0 +1,41 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_PROTOCOLMETRICS_H
+#define FS_PROTOCOLMETRICS_H
+
+#include "protocol.h"
+
+// Answers HTTP GET /metrics with the metrics registry in the prometheus text format. Runs on the network thread
+// only, a scrape never waits for or adds work to the dispatcher.
+class ProtocolMetrics final : public Protocol
+{
+public:
+	// static protocol information
+	enum
+	{
+		server_sends_first = true
+	};
+	enum
+	{
+		protocol_identifier = 0
+	};
+	enum
+	{
+		use_checksum = false
+	};
+	static const char* protocol_name() { return "metrics protocol"; }
+
+	explicit ProtocolMetrics(Connection_ptr connection) : Protocol(connection) {}
+
+	bool isRawStream() const override { return true; }
+	void onRecvRaw(std::string_view data) override;
+	void onRecvFirstMessage(NetworkMessage&) override {}
+
+private:
+	void sendResponse(std::string_view status, std::string_view body);
+
+	std::string request;
+};
+
+#endif // FS_PROTOCOLMETRICS_H
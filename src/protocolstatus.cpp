@@ -12,9 +12,31 @@
 extern ConfigManager g_config;
 extern Game g_game;
 
-std::map<uint32_t, int64_t> ProtocolStatus::ipConnectMap;
+std::unordered_map<uint32_t, int64_t> ProtocolStatus::ipConnectMap;
+std::mutex ProtocolStatus::ipConnectLock;
+std::string ProtocolStatus::statusString;
+int64_t ProtocolStatus::statusStringTime = 0;
+std::mutex ProtocolStatus::statusStringLock;
 const uint64_t ProtocolStatus::start = OTSYS_TIME();
 
+namespace {
+
+constexpr size_t MAX_TRACKED_IPS = 4096;
+
+// how long (ms) a built status string is served to other requests
+constexpr int64_t STATUS_STRING_CACHE_TIME = 1000;
+
+struct StringWriter final : pugi::xml_writer
+{
+	explicit StringWriter(std::string& out) : out(out) {}
+
+	void write(const void* data, size_t size) override { out.append(static_cast<const char*>(data), size); }
+
+	std::string& out;
+};
+
+} // namespace
+
 enum RequestedInfo_t : uint16_t
 {
 	REQUEST_BASIC_SERVER_INFO = 1 << 0,
@@ -30,24 +52,36 @@ enum RequestedInfo_t : uint16_t
 void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 {
 	uint32_t ip = getIP();
-	if (ip != 0x0100007F) {
-		std::string ipStr = convertIPToString(ip);
-		if (ipStr != g_config[ConfigKeysString::IP]) {
-			std::map<uint32_t, int64_t>::const_iterator it = ipConnectMap.find(ip);
-			if (it != ipConnectMap.end() &&
-			    (OTSYS_TIME() < (it->second + g_config[ConfigKeysInteger::STATUSQUERY_TIMEOUT]))) {
-				disconnect();
-				return;
+	{
+		// connections may be served by several network threads
+		std::lock_guard<std::mutex> lockGuard(ipConnectLock);
+		const int64_t now = OTSYS_TIME();
+		const int64_t timeout = g_config[ConfigKeysInteger::STATUSQUERY_TIMEOUT];
+		if (ip != 0x0100007F) {
+			std::string ipStr = convertIPToString(ip);
+			if (ipStr != g_config[ConfigKeysString::IP]) {
+				auto it = ipConnectMap.find(ip);
+				if (it != ipConnectMap.end() && (now < (it->second + timeout))) {
+					disconnect();
+					return;
+				}
 			}
 		}
-	}
 
-	ipConnectMap[ip] = OTSYS_TIME();
+		if (ipConnectMap.size() >= MAX_TRACKED_IPS) {
+			std::erase_if(ipConnectMap, [=](const auto& it) { return now >= it.second + timeout; });
+		}
+		ipConnectMap[ip] = now;
+	}
 
 	switch (msg.getByte()) {
 		// XML info protocol
 		case 0xFF: {
 			if (msg.getString(4) == "info") {
+				if (sendCachedStatusString()) {
+					return;
+				}
+
 				g_dispatcher.addTask([thisPtr = std::static_pointer_cast<ProtocolStatus>(shared_from_this())]() {
 					thisPtr->sendStatusString();
 				});
@@ -75,6 +109,25 @@ void ProtocolStatus::onRecvFirstMessage(NetworkMessage& msg)
 	disconnect();
 }
 
+bool ProtocolStatus::sendCachedStatusString()
+{
+	std::string data;
+	{
+		std::lock_guard<std::mutex> lockGuard(statusStringLock);
+		if (statusStringTime == 0 || OTSYS_TIME() - statusStringTime >= STATUS_STRING_CACHE_TIME) {
+			return false;
+		}
+		data = statusString;
+	}
+
+	auto output = OutputMessagePool::getOutputMessage();
+	setRawMessages(true);
+	output->addBytes(data.data(), data.size());
+	send(output);
+	disconnect();
+	return true;
+}
+
 void ProtocolStatus::sendStatusString()
 {
 	auto output = OutputMessagePool::getOutputMessage();
@@ -135,13 +188,17 @@ void ProtocolStatus::sendStatusString()
 	pugi::xml_node motd = tsqp.append_child("motd");
 	motd.text() = g_config[ConfigKeysString::MOTD].data();
 
-	std::ostringstream ss;
-	doc.save(ss, "", pugi::format_raw);
+	std::string data;
+	StringWriter writer{data};
+	doc.save(writer, "", pugi::format_raw);
 
-	std::string data = ss.str();
-	output->addBytes(data.c_str(), data.size());
+	output->addBytes(data.data(), data.size());
 	send(output);
 	disconnect();
+
+	std::lock_guard<std::mutex> lockGuard(statusStringLock);
+	statusString = std::move(data);
+	statusStringTime = OTSYS_TIME();
 }
 
 void ProtocolStatus::sendInfo(uint16_t requestedInfo, std::string_view characterName)
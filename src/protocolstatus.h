@@ -35,7 +35,16 @@ public:
 	static const uint64_t start;
 
 private:
-	static std::map<uint32_t, int64_t> ipConnectMap;
+	// answers from the status string built by the last request within the cache time, on the network thread
+	bool sendCachedStatusString();
+
+	// time of the last request per ip, expired entries are dropped once it grows past MAX_TRACKED_IPS
+	static std::unordered_map<uint32_t, int64_t> ipConnectMap;
+	static std::mutex ipConnectLock;
+
+	static std::string statusString;
+	static int64_t statusStringTime;
+	static std::mutex statusStringLock;
 };
 
 #endif
@@ -0,0 +1,178 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "querystats.h"
+
+#include "configmanager.h"
+#include "metrics.h"
+
+extern ConfigManager g_config;
+
+namespace {
+
+constexpr size_t MAX_FINGERPRINT_LENGTH = 256;
+// distinct fingerprints kept, later ones are counted as other
+constexpr size_t MAX_FINGERPRINTS = 512;
+constexpr std::array<uint64_t, 12> QUERY_TIME_BOUNDS = {100,   250,   500,   1000,   2500,   5000,
+                                                        10000, 25000, 50000, 100000, 250000, 1000000};
+
+bool isIdentifierChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$'; }
+
+struct QueryTimes
+{
+	std::array<uint64_t, QUERY_TIME_BOUNDS.size() + 1> buckets = {};
+	uint64_t sum = 0;
+};
+
+std::string escapeLabel(std::string_view value)
+{
+	std::string escaped;
+	escaped.reserve(value.size());
+	for (char c : value) {
+		if (c == '\\' || c == '"') {
+			escaped.push_back('\\');
+		} else if (c == '\n') {
+			escaped += "\\n";
+			continue;
+		}
+		escaped.push_back(c);
+	}
+	return escaped;
+}
+
+class QueryTimeMetric final : public Metric
+{
+public:
+	QueryTimeMetric() :
+	    Metric(METRIC_HISTOGRAM, "tfs_database_query_duration_microseconds",
+	           "Execution time of database queries by fingerprint and whether the dispatcher waited for them.")
+	{}
+
+	void observe(std::string fingerprint, bool dispatcher, uint64_t microseconds)
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		auto it = times.find(std::make_pair(fingerprint, dispatcher));
+		if (it == times.end()) {
+			if (times.size() >= MAX_FINGERPRINTS) {
+				fingerprint = "other";
+			}
+			it = times.try_emplace(std::make_pair(std::move(fingerprint), dispatcher)).first;
+		}
+
+		QueryTimes& queryTimes = it->second;
+		++queryTimes.buckets[std::lower_bound(QUERY_TIME_BOUNDS.begin(), QUERY_TIME_BOUNDS.end(), microseconds) -
+		                     QUERY_TIME_BOUNDS.begin()];
+		queryTimes.sum += microseconds;
+	}
+
+	void serialize(std::string& out) const override
+	{
+		std::lock_guard<std::mutex> lockGuard(lock);
+		for (const auto& [key, queryTimes] : times) {
+			const std::string labels =
+			    fmt::format("query=\"{:s}\",dispatcher=\"{:s}\"", escapeLabel(key.first), key.second ? "true" : "false");
+
+			uint64_t count = 0;
+			for (size_t bucket = 0; bucket < queryTimes.buckets.size(); ++bucket) {
+				count += queryTimes.buckets[bucket];
+				const std::string bound =
+				    bucket < QUERY_TIME_BOUNDS.size() ? std::to_string(QUERY_TIME_BOUNDS[bucket]) : "+Inf";
+				writeSample(out, "_bucket", fmt::format("{:s},le=\"{:s}\"", labels, bound), std::to_string(count));
+			}
+			writeSample(out, "_sum", labels, std::to_string(queryTimes.sum));
+			writeSample(out, "_count", labels, std::to_string(count));
+		}
+	}
+
+private:
+	mutable std::mutex lock;
+	std::map<std::pair<std::string, bool>, QueryTimes> times;
+};
+
+QueryTimeMetric queryTimes;
+MetricCounter dispatcherQueryTime{"tfs_database_dispatcher_wait_microseconds_total",
+                                  "Time the dispatcher spent waiting for database queries."};
+
+} // namespace
+
+std::string QueryStats::fingerprint(std::string_view query)
+{
+	std::string out;
+	out.reserve(std::min(query.size(), MAX_FINGERPRINT_LENGTH));
+
+	auto placeholder = [&out]() {
+		// a list of values collapses into one
+		size_t end = out.size();
+		while (end > 0 && out[end - 1] == ' ') {
+			--end;
+		}
+		if (end >= 2 && out[end - 1] == ',' && out[end - 2] == '?') {
+			out.resize(end - 1);
+			return;
+		}
+		out.push_back('?');
+	};
+
+	for (size_t i = 0; i < query.size() && out.size() < MAX_FINGERPRINT_LENGTH; ++i) {
+		const char c = query[i];
+		if (c == '\'' || c == '"') {
+			// strings, with backslash escapes and doubled quotes
+			for (++i; i < query.size(); ++i) {
+				if (query[i] == '\\') {
+					++i;
+				} else if (query[i] == c) {
+					if (i + 1 < query.size() && query[i + 1] == c) {
+						++i;
+					} else {
+						break;
+					}
+				}
+			}
+			placeholder();
+		} else if (c == '`') {
+			const size_t end = std::min(query.find('`', i + 1), query.size() - 1);
+			out.append(query.substr(i, end - i + 1));
+			i = end;
+		} else if (std::isdigit(static_cast<unsigned char>(c)) && (out.empty() || !isIdentifierChar(out.back()))) {
+			while (i + 1 < query.size() && (isIdentifierChar(query[i + 1]) || query[i + 1] == '.')) {
+				++i;
+			}
+			placeholder();
+		} else if (std::isspace(static_cast<unsigned char>(c))) {
+			if (!out.empty() && out.back() != ' ') {
+				out.push_back(' ');
+			}
+		} else {
+			out.push_back(c);
+		}
+	}
+
+	while (!out.empty() && out.back() == ' ') {
+		out.pop_back();
+	}
+	if (out.size() >= MAX_FINGERPRINT_LENGTH) {
+		out.resize(MAX_FINGERPRINT_LENGTH);
+		out += "...";
+	}
+	return out;
+}
+
+void QueryStats::record(std::string_view query, std::string_view caller, std::chrono::steady_clock::duration duration,
+                        bool dispatcher)
+{
+	const auto microseconds =
+	    static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+	queryTimes.observe(fingerprint(query), dispatcher, microseconds);
+	if (dispatcher) {
+		dispatcherQueryTime.add(microseconds);
+	}
+
+	const auto slowQueryTime = g_config[ConfigKeysInteger::SLOW_QUERY_TIME];
+	if (slowQueryTime > 0 && microseconds >= static_cast<uint64_t>(slowQueryTime) * 1000) {
+		std::cout << fmt::format("[Slow query] {:d} ms{:s}, {:s}: {:s}", microseconds / 1000,
+		                         dispatcher ? " on the dispatcher" : "", caller, query.substr(0, 512))
+		          << std::endl;
+	}
+}
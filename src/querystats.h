@@ -0,0 +1,22 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_QUERYSTATS_H
+#define FS_QUERYSTATS_H
+
+/*
+ * Query times by fingerprint, the query with its literals replaced, exported as the
+ * tfs_database_query_duration_microseconds histogram with a series for the queries the dispatcher waited for.
+ * Queries slower than slowQueryTime are printed with their caller.
+ */
+namespace QueryStats {
+
+// strings and numbers become ?, lists of them a single ? and the result is cut after the first 256 characters
+std::string fingerprint(std::string_view query);
+
+void record(std::string_view query, std::string_view caller, std::chrono::steady_clock::duration duration,
+            bool dispatcher);
+
+} // namespace QueryStats
+
+#endif // FS_QUERYSTATS_H
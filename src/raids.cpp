@@ -8,11 +8,13 @@
 #include "configmanager.h"
 #include "game.h"
 #include "monster.h"
+#include "monsters.h"
 #include "pugicast.h"
 #include "scheduler.h"
 
 extern Game g_game;
 extern ConfigManager g_config;
+extern Monsters g_monsters;
 
 Raids::Raids() { scriptInterface.initState(); }
 
@@ -101,7 +103,7 @@ bool Raids::startup()
 	setLastRaidEnd(OTSYS_TIME());
 
 	checkRaidsEvent =
-	    g_scheduler.addEvent(createSchedulerTask(CHECK_RAIDS_INTERVAL * 1000, [this]() { checkRaids(); }));
+	    g_scheduler.addEvent(createSchedulerTask(CHECK_RAIDS_INTERVAL * 1000, [this]() { checkRaids(); }, SCHEDULER_EVENT_RAID));
 
 	started = true;
 	return started;
@@ -130,7 +132,7 @@ void Raids::checkRaids()
 	}
 
 	checkRaidsEvent =
-	    g_scheduler.addEvent(createSchedulerTask(CHECK_RAIDS_INTERVAL * 1000, [this]() { checkRaids(); }));
+	    g_scheduler.addEvent(createSchedulerTask(CHECK_RAIDS_INTERVAL * 1000, [this]() { checkRaids(); }, SCHEDULER_EVENT_RAID));
 }
 
 void Raids::clear()
@@ -225,7 +227,7 @@ void Raid::startRaid()
 	if (raidEvent) {
 		state = RAIDSTATE_EXECUTING;
 		nextEventEvent = g_scheduler.addEvent(
-		    createSchedulerTask(raidEvent->getDelay(), [=, this]() { executeRaidEvent(raidEvent); }));
+		    createSchedulerTask(raidEvent->getDelay(), [=, this]() { executeRaidEvent(raidEvent); }, SCHEDULER_EVENT_RAID));
 	}
 }
 
@@ -239,7 +241,8 @@ void Raid::executeRaidEvent(RaidEvent* raidEvent)
 			uint32_t ticks = static_cast<uint32_t>(
 			    std::max<int32_t>(RAID_MINTICKS, newRaidEvent->getDelay() - raidEvent->getDelay()));
 			nextEventEvent =
-			    g_scheduler.addEvent(createSchedulerTask(ticks, [=, this]() { executeRaidEvent(newRaidEvent); }));
+			    g_scheduler.addEvent(createSchedulerTask(
+			        ticks, [=, this]() { executeRaidEvent(newRaidEvent); }, SCHEDULER_EVENT_RAID));
 		} else {
 			resetRaid();
 		}
@@ -371,12 +374,16 @@ bool SingleSpawnEvent::configureRaidEvent(const pugi::xml_node& eventNode)
 
 bool SingleSpawnEvent::executeEvent()
 {
-	Monster* monster = Monster::createMonster(monsterName);
-	if (!monster) {
-		std::cout << "[Error] Raids: Cant create monster " << monsterName << std::endl;
-		return false;
+	if (!monsterType) {
+		monsterType = g_monsters.getMonsterType(monsterName);
+		if (!monsterType) {
+			std::cout << "[Error] Raids: Cant create monster " << monsterName << std::endl;
+			return false;
+		}
 	}
 
+	Monster* monster = new Monster(monsterType);
+
 	if (!g_game.placeCreature(monster, position, false, true)) {
 		delete monster;
 		std::cout << "[Error] Raids: Cant place monster " << monsterName << std::endl;
@@ -509,23 +516,39 @@ bool AreaSpawnEvent::configureRaidEvent(const pugi::xml_node& eventNode)
 
 bool AreaSpawnEvent::executeEvent()
 {
-	for (const MonsterSpawn& spawn : spawnList) {
-		uint32_t amount = uniform_random(spawn.minAmount, spawn.maxAmount);
-		for (uint32_t i = 0; i < amount; ++i) {
-			Monster* monster = Monster::createMonster(spawn.name);
-			if (!monster) {
+	// the monsters are put on the map one by one and announced together, a tile taken by one is seen by the next
+	std::vector<Creature*> placed;
+	for (MonsterSpawn& spawn : spawnList) {
+		if (!spawn.mType) {
+			spawn.mType = g_monsters.getMonsterType(spawn.name);
+			if (!spawn.mType) {
 				std::cout << "[Error - AreaSpawnEvent::executeEvent] Can't create monster " << spawn.name << std::endl;
+				g_game.announcePlacedCreatures(placed);
 				return false;
 			}
+		}
+
+		uint32_t amount = uniform_random(spawn.minAmount, spawn.maxAmount);
+		for (uint32_t i = 0; i < amount; ++i) {
+			Monster* monster = new Monster(spawn.mType);
 
 			bool success = false;
 			for (int32_t tries = 0; tries < MAXIMUM_TRIES_PER_MONSTER; tries++) {
-				Tile* tile = g_game.map.getTile(static_cast<uint16_t>(uniform_random(fromPos.x, toPos.x)),
-				                                static_cast<uint16_t>(uniform_random(fromPos.y, toPos.y)),
-				                                static_cast<uint16_t>(uniform_random(fromPos.z, toPos.z)));
+				const auto x = static_cast<uint16_t>(uniform_random(fromPos.x, toPos.x));
+				const auto y = static_cast<uint16_t>(uniform_random(fromPos.y, toPos.y));
+				const auto z = static_cast<uint8_t>(uniform_random(fromPos.z, toPos.z));
+
+				// the walk flags rule out missing and occupied tiles without looking at the tile
+				const uint8_t walkFlags = g_game.map.getTileWalkFlags(x, y, z);
+				if (!(walkFlags & TILEWALK_GROUND) || (walkFlags & TILEWALK_CREATURE)) {
+					continue;
+				}
+
+				Tile* tile = g_game.map.getTile(x, y, z);
 				if (tile && !tile->isMoveableBlocking() && !tile->hasFlag(TILESTATE_PROTECTIONZONE) &&
 				    tile->getTopCreature() == nullptr &&
-				    g_game.placeCreature(monster, tile->getPosition(), false, true)) {
+				    g_game.internalPlaceCreature(monster, tile->getPosition(), false, true)) {
+					placed.push_back(monster);
 					success = true;
 					break;
 				}
@@ -536,6 +559,8 @@ bool AreaSpawnEvent::executeEvent()
 			}
 		}
 	}
+
+	g_game.announcePlacedCreatures(placed);
 	return true;
 }
 
@@ -8,6 +8,8 @@
 #include "const.h"
 #include "position.h"
 
+class MonsterType;
+
 enum RaidState_t
 {
 	RAIDSTATE_IDLE,
@@ -21,6 +23,8 @@ struct MonsterSpawn
 	{}
 
 	std::string name;
+	// resolved from name on first use
+	MonsterType* mType = nullptr;
 	uint32_t minAmount;
 	uint32_t maxAmount;
 };
@@ -154,6 +158,8 @@ public:
 
 private:
 	std::string monsterName;
+	// resolved from monsterName on first use
+	MonsterType* monsterType = nullptr;
 	Position position;
 };
 
@@ -0,0 +1,369 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "replay.h"
+
+#include "fileloader.h"
+#include "game.h"
+#include "networkmessage.h"
+#include "protocolgame.h"
+#include "scheduler.h"
+#include "tickprofiler.h"
+#include "tools.h"
+
+extern Game g_game;
+
+ReplayRecorder g_replayRecorder;
+
+namespace {
+
+constexpr uint32_t REPLAY_MAGIC = 0x52534654; // "TFSR"
+constexpr uint16_t REPLAY_VERSION = 1;
+
+// bytes buffered before they are written out
+constexpr size_t REPLAY_FLUSH_SIZE = 64 * 1024;
+// records fed per dispatcher task, so the ticks keep running in between
+constexpr size_t REPLAY_BATCH_SIZE = 256;
+// milliseconds between two feeds at the recorded pace
+constexpr uint32_t REPLAY_STEP_INTERVAL = 10;
+// milliseconds a packet waits for its player to finish logging in before it is dropped
+constexpr int64_t REPLAY_LOGIN_TIMEOUT = 5000;
+
+template <typename T>
+void append(std::string& buffer, T value)
+{
+	buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+} // namespace
+
+// a friend of ProtocolGame, it drives the protocols of the replayed clients
+class ReplayPlayer
+{
+public:
+	bool load(const std::string& path);
+	void start(uint32_t speed);
+
+private:
+	struct Record
+	{
+		std::string packet;
+		uint32_t time;
+		uint32_t guid;
+		uint32_t accountId = 0;
+		OperatingSystem_t operatingSystem = CLIENTOS_NONE;
+		ReplayRecordType type;
+	};
+
+	void step();
+	// false when the record has to wait for its player to log in
+	bool feed(const Record& record);
+	void finish();
+
+	std::vector<Record> records;
+	std::unordered_map<uint32_t, ProtocolGame_ptr> clients;
+	uint64_t seed = 0;
+
+	size_t next = 0;
+	int64_t startTime = 0;
+	int64_t stalledSince = 0;
+	uint32_t speed = 1;
+
+	uint64_t logins = 0;
+	uint64_t packets = 0;
+	uint64_t dropped = 0;
+};
+
+namespace {
+
+std::unique_ptr<ReplayPlayer> replayPlayer;
+
+} // namespace
+
+bool ReplayRecorder::start(const std::string& path)
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	if (recording) {
+		return false;
+	}
+
+	file.open(path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	const uint64_t seed = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+	getRandomGenerator().seed(seed);
+
+	startTime = OTSYS_TIME();
+	records = 0;
+	buffer.clear();
+	append(buffer, REPLAY_MAGIC);
+	append(buffer, REPLAY_VERSION);
+	append(buffer, seed);
+	append<int64_t>(buffer, time(nullptr));
+	recording = true;
+	return true;
+}
+
+uint64_t ReplayRecorder::stop()
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	if (!recording) {
+		return 0;
+	}
+
+	recording = false;
+	flush();
+	file.close();
+	return records;
+}
+
+void ReplayRecorder::recordLogin(uint32_t guid, uint32_t accountId, OperatingSystem_t operatingSystem)
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	if (!recording) {
+		return;
+	}
+
+	writeHeader(REPLAY_RECORD_LOGIN, guid);
+	append(buffer, accountId);
+	append<uint16_t>(buffer, operatingSystem);
+}
+
+void ReplayRecorder::recordPacket(uint32_t guid, const NetworkMessage& msg)
+{
+	const size_t position = msg.getBufferPosition();
+	const size_t end = msg.getLength() + NetworkMessage::INITIAL_BUFFER_POSITION;
+	if (position >= end) {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lockGuard(lock);
+	if (!recording) {
+		return;
+	}
+
+	writeHeader(REPLAY_RECORD_PACKET, guid);
+	append<uint16_t>(buffer, end - position);
+	buffer.append(reinterpret_cast<const char*>(msg.getBuffer() + position), end - position);
+}
+
+void ReplayRecorder::recordLogout(uint32_t guid)
+{
+	std::lock_guard<std::mutex> lockGuard(lock);
+	if (recording) {
+		writeHeader(REPLAY_RECORD_LOGOUT, guid);
+	}
+}
+
+void ReplayRecorder::writeHeader(ReplayRecordType type, uint32_t guid)
+{
+	append(buffer, type);
+	append<uint32_t>(buffer, OTSYS_TIME() - startTime);
+	append(buffer, guid);
+	++records;
+
+	if (buffer.size() >= REPLAY_FLUSH_SIZE) {
+		flush();
+	}
+}
+
+void ReplayRecorder::flush()
+{
+	file.write(buffer.data(), buffer.size());
+	buffer.clear();
+}
+
+bool ReplayPlayer::load(const std::string& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		std::cout << "> Could not open replay " << path << std::endl;
+		return false;
+	}
+
+	const std::string data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+	PropStream stream;
+	stream.init(data.data(), data.size());
+
+	uint32_t magic;
+	uint16_t version;
+	int64_t recorded;
+	if (!stream.read(magic) || magic != REPLAY_MAGIC || !stream.read(version) || version != REPLAY_VERSION ||
+	    !stream.read(seed) || !stream.read(recorded)) {
+		std::cout << "> " << path << " is not a replay of this version" << std::endl;
+		return false;
+	}
+
+	while (stream.size() != 0) {
+		Record& record = records.emplace_back();
+		if (!stream.read(record.type) || !stream.read(record.time) || !stream.read(record.guid)) {
+			std::cout << "> Replay " << path << " is truncated" << std::endl;
+			return false;
+		}
+
+		bool valid = true;
+		if (record.type == REPLAY_RECORD_LOGIN) {
+			uint16_t operatingSystem;
+			valid = stream.read(record.accountId) && stream.read(operatingSystem);
+			record.operatingSystem = static_cast<OperatingSystem_t>(operatingSystem);
+		} else if (record.type == REPLAY_RECORD_PACKET) {
+			auto [packet, ok] = stream.readString();
+			record.packet = packet;
+			valid = ok;
+		} else if (record.type != REPLAY_RECORD_LOGOUT) {
+			valid = false;
+		}
+
+		if (!valid) {
+			std::cout << "> Replay " << path << " is truncated" << std::endl;
+			return false;
+		}
+	}
+
+	std::cout << fmt::format(">> Loaded replay of {:s}: {:d} records over {:d} s", formatDateShort(recorded),
+	                         records.size(), records.empty() ? 0 : records.back().time / 1000)
+	          << std::endl;
+	return true;
+}
+
+void ReplayPlayer::start(uint32_t speed)
+{
+	this->speed = speed;
+	getRandomGenerator().seed(seed);
+	g_tickProfiler.resetTotals();
+	startTime = OTSYS_TIME();
+	step();
+}
+
+void ReplayPlayer::step()
+{
+	const int64_t now = OTSYS_TIME();
+	const int64_t elapsed = (now - startTime) * speed;
+	for (size_t fed = 0; next < records.size() && fed < REPLAY_BATCH_SIZE; ++fed) {
+		const Record& record = records[next];
+		if (speed != 0 && record.time > elapsed) {
+			break;
+		}
+
+		if (!feed(record)) {
+			if (stalledSince == 0) {
+				stalledSince = now;
+			}
+
+			if (now - stalledSince < REPLAY_LOGIN_TIMEOUT) {
+				break;
+			}
+
+			// the login failed, the rest of its packets go as well
+			clients.erase(record.guid);
+			++dropped;
+		}
+
+		stalledSince = 0;
+		++next;
+	}
+
+	if (next == records.size()) {
+		finish();
+	} else if (speed == 0 && stalledSince == 0) {
+		g_dispatcher.addTask([this]() { step(); });
+	} else {
+		g_scheduler.addEvent(createSchedulerTask(REPLAY_STEP_INTERVAL, [this]() { step(); }, SCHEDULER_EVENT_SERVER));
+	}
+}
+
+bool ReplayPlayer::feed(const Record& record)
+{
+	switch (record.type) {
+		case REPLAY_RECORD_LOGIN: {
+			auto it = clients.find(record.guid);
+			if (it != clients.end()) {
+				it->second->release();
+			}
+
+			auto client = std::make_shared<ProtocolGame>(nullptr);
+			client->replaying = true;
+			clients[record.guid] = client;
+			client->login(record.guid, record.accountId, record.operatingSystem);
+			++logins;
+			return true;
+		}
+
+		case REPLAY_RECORD_PACKET: {
+			auto it = clients.find(record.guid);
+			if (it == clients.end()) {
+				// logged in before the recording started or failed to log in now
+				++dropped;
+				return true;
+			}
+
+			ProtocolGame_ptr& client = it->second;
+			if (!client->acceptPackets) {
+				return false;
+			}
+
+			NetworkMessage msg;
+			msg.addBytes(record.packet.data(), record.packet.size());
+			msg.setBufferPosition(0);
+			client->parsePacket(msg);
+			++packets;
+			return true;
+		}
+
+		case REPLAY_RECORD_LOGOUT: {
+			auto it = clients.find(record.guid);
+			if (it != clients.end()) {
+				it->second->release();
+				clients.erase(it);
+			}
+			return true;
+		}
+	}
+	return true;
+}
+
+void ReplayPlayer::finish()
+{
+	const TickTotals& totals = g_tickProfiler.getTotals();
+	const double seconds = (OTSYS_TIME() - startTime) / 1000.0;
+	std::cout << fmt::format("> Replay finished after {:.1f} s: {:d} logins, {:d} packets, {:d} dropped", seconds,
+	                         logins, packets, dropped)
+	          << std::endl;
+
+	if (totals.ticks != 0) {
+		std::cout << fmt::format("  {:d} ticks, {:.1f} ticks per second, busy {:d} us and {:d} tasks per tick, lua "
+		                         "{:d} us per tick",
+		                         totals.ticks, totals.ticks / std::max(seconds, 0.001), totals.busy / totals.ticks,
+		                         totals.tasks / totals.ticks, totals.luaTime / totals.ticks)
+		          << std::endl;
+		for (uint8_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+			std::cout << fmt::format("  {:<10s} {:>12d} us, {:>8d} us per tick",
+			                         getTickPhaseName(static_cast<TickPhase>(phase)), totals.phases[phase],
+			                         totals.phases[phase] / totals.ticks)
+			          << std::endl;
+		}
+	}
+
+	for (auto& it : clients) {
+		it.second->release();
+	}
+	clients.clear();
+
+	g_dispatcher.addTask([]() { g_game.setGameState(GAME_STATE_SHUTDOWN); });
+}
+
+bool startReplay(const std::string& path, uint32_t speed)
+{
+	replayPlayer = std::make_unique<ReplayPlayer>();
+	if (!replayPlayer->load(path)) {
+		replayPlayer.reset();
+		return false;
+	}
+
+	replayPlayer->start(speed);
+	return true;
+}
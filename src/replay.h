@@ -0,0 +1,60 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_REPLAY_H
+#define FS_REPLAY_H
+
+#include "enums.h"
+
+#include <fstream>
+
+class NetworkMessage;
+
+enum ReplayRecordType : uint8_t
+{
+	REPLAY_RECORD_LOGIN,
+	REPLAY_RECORD_PACKET,
+	REPLAY_RECORD_LOGOUT,
+};
+
+// Writes the client input of the game world to a capture file: logins, the decrypted client packets and the
+// connections going away, each with the milliseconds since the recording started. The dispatcher thread random
+// generator is reseeded when a recording starts and the seed is kept in the capture. Any thread.
+class ReplayRecorder
+{
+public:
+	~ReplayRecorder() { stop(); }
+
+	// dispatcher thread, the random generator that is reseeded is its own
+	bool start(const std::string& path);
+	// returns the records written, 0 if none was running
+	uint64_t stop();
+
+	bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+	void recordLogin(uint32_t guid, uint32_t accountId, OperatingSystem_t operatingSystem);
+	// from the read position to the end of the message
+	void recordPacket(uint32_t guid, const NetworkMessage& msg);
+	void recordLogout(uint32_t guid);
+
+private:
+	void writeHeader(ReplayRecordType type, uint32_t guid);
+	void flush();
+
+	std::mutex lock;
+	std::ofstream file;
+	// records are buffered and written in blocks
+	std::string buffer;
+	int64_t startTime = 0;
+	uint64_t records = 0;
+	std::atomic<bool> recording{false};
+};
+
+extern ReplayRecorder g_replayRecorder;
+
+// Loads a capture and feeds it to the game as if its clients were connected, then reports the ticks it took with their
+// phases and shuts the server down. speed scales the recorded pace, 0 feeds the records as fast as the dispatcher
+// takes them. Dispatcher thread.
+bool startReplay(const std::string& path, uint32_t speed);
+
+#endif // FS_REPLAY_H
@@ -18,6 +18,8 @@ public:
 
 	void loadPEM(const std::string& filename);
 	void decrypt(char* msg) const;
+	// with the public half of the key, what a client does with the login block
+	void encrypt(char* msg) const;
 
 private:
 	CryptoPP::RSA::PrivateKey pk;
@@ -5,6 +5,42 @@
 
 #include "scheduler.h"
 
+#include "lockfree.h"
+#include "metrics.h"
+#include "threadregistry.h"
+
+namespace {
+
+const size_t SCHEDULER_TASK_FREE_LIST_CAPACITY = 8192;
+
+// number of ticks covered by every level below the given one
+constexpr uint64_t levelSpan(uint32_t level) { return uint64_t{1} << (SCHEDULER_WHEEL_BITS * level); }
+
+} // namespace
+
+void* SchedulerTask::operator new(size_t size)
+{
+	if (size != sizeof(SchedulerTask)) {
+		return ::operator new(size);
+	}
+	return lockfreeAllocate<sizeof(SchedulerTask), SCHEDULER_TASK_FREE_LIST_CAPACITY>();
+}
+
+void SchedulerTask::operator delete(void* p, size_t size)
+{
+	if (size != sizeof(SchedulerTask)) {
+		::operator delete(p);
+		return;
+	}
+	lockfreeDeallocate<sizeof(SchedulerTask), SCHEDULER_TASK_FREE_LIST_CAPACITY>(p);
+}
+
+int64_t Scheduler::now() const
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime)
+	    .count();
+}
+
 uint32_t Scheduler::addEvent(SchedulerTask* task)
 {
 	// check if the event has a valid id
@@ -12,26 +48,35 @@ uint32_t Scheduler::addEvent(SchedulerTask* task)
 		task->setEventId(++lastEventId);
 	}
 
-	boost::asio::post(io_context, [this, task]() {
-		// insert the event id in the list of active events
-		auto it = eventIdTimerMap.emplace(task->getEventId(), boost::asio::steady_timer{io_context});
-		auto& timer = it.first->second;
+	const uint32_t eventId = task->getEventId();
 
-		timer.expires_from_now(std::chrono::milliseconds(task->getDelay()));
-		timer.async_wait([this, task](const boost::system::error_code& error) {
-			eventIdTimerMap.erase(task->getEventId());
+	std::unique_lock<std::mutex> eventLockUnique(eventLock);
+	if (getState() == THREAD_STATE_TERMINATED) {
+		delete task;
+		return eventId;
+	}
 
-			if (error == boost::asio::error::operation_aborted || getState() == THREAD_STATE_TERMINATED) {
-				// the timer has been manually canceled(timer->cancel()) or Scheduler::shutdown has been called
-				delete task;
-				return;
-			}
+	task->deadline = now() + task->getDelay();
+
+	// the scheduler thread only sleeps indefinitely when nothing is pending, and otherwise wakes up on each tick,
+	// so it only has to be woken up when nothing was pending or the task can already be due
+	bool wakeUp = wheelSize == 0 && dueTasks.empty();
+
+	const size_t events = activeEvents.size();
+	activeEvents[eventId] = task;
+	metrics::schedulerEvents.add(activeEvents.size() - events);
+	insert(task);
 
-			g_dispatcher.addTask(task);
-		});
-	});
+	if (task->wheelSlot == SchedulerTask::NOT_IN_WHEEL) {
+		wakeUp = true;
+	}
+
+	eventLockUnique.unlock();
 
-	return task->getEventId();
+	if (wakeUp) {
+		eventSignal.notify_one();
+	}
+	return eventId;
 }
 
 void Scheduler::stopEvent(uint32_t eventId)
@@ -40,26 +85,211 @@ void Scheduler::stopEvent(uint32_t eventId)
 		return;
 	}
 
-	boost::asio::post(io_context, [this, eventId]() {
-		// search the event id
-		auto it = eventIdTimerMap.find(eventId);
-		if (it != eventIdTimerMap.end()) {
-			it->second.cancel();
+	std::lock_guard<std::mutex> lockClass(eventLock);
+
+	// search the event id
+	SchedulerTask** it = activeEvents.find(eventId);
+	if (!it) {
+		return;
+	}
+
+	SchedulerTask* task = *it;
+	activeEvents.erase(eventId);
+	metrics::schedulerEvents.sub();
+
+	if (task->wheelSlot != SchedulerTask::NOT_IN_WHEEL) {
+		unlink(task);
+		delete task;
+	} else {
+		// already in the due heap, it is released when it pops
+		task->cancelled = true;
+	}
+}
+
+void Scheduler::insert(SchedulerTask* task)
+{
+	const uint64_t tick = static_cast<uint64_t>(std::max<int64_t>(task->deadline, 0)) / SCHEDULER_MINTICKS;
+	if (tick <= currentTick) {
+		task->wheelSlot = SchedulerTask::NOT_IN_WHEEL;
+		dueTasks.push(task);
+		return;
+	}
+
+	// events beyond the range of the top level are parked in its furthest slot and placed again when it cascades
+	const uint64_t diff = std::min(tick - currentTick, levelSpan(SCHEDULER_WHEEL_LEVELS) - 1);
+	const uint64_t slotTick = currentTick + diff;
+
+	uint32_t level = 0;
+	while (diff >= levelSpan(level + 1)) {
+		++level;
+	}
+
+	const uint32_t slot = (slotTick >> (SCHEDULER_WHEEL_BITS * level)) & (SCHEDULER_WHEEL_SLOTS - 1);
+	task->wheelSlot = static_cast<uint16_t>(level * SCHEDULER_WHEEL_SLOTS + slot);
+
+	SchedulerTask*& head = wheel[task->wheelSlot];
+	task->prev = nullptr;
+	task->next = head;
+	if (head) {
+		head->prev = task;
+	}
+	head = task;
+	++wheelSize;
+}
+
+void Scheduler::unlink(SchedulerTask* task)
+{
+	if (task->prev) {
+		task->prev->next = task->next;
+	} else {
+		wheel[task->wheelSlot] = task->next;
+	}
+
+	if (task->next) {
+		task->next->prev = task->prev;
+	}
+
+	task->prev = nullptr;
+	task->next = nullptr;
+	task->wheelSlot = SchedulerTask::NOT_IN_WHEEL;
+	--wheelSize;
+}
+
+void Scheduler::advance()
+{
+	++currentTick;
+
+	// cascade the higher levels whose slot boundary was just crossed, highest first so tasks can fall through
+	// several levels in one go
+	uint32_t cascadeLevels = 0;
+	while (cascadeLevels + 1 < SCHEDULER_WHEEL_LEVELS && (currentTick & (levelSpan(cascadeLevels + 1) - 1)) == 0) {
+		++cascadeLevels;
+	}
+
+	for (uint32_t level = cascadeLevels; level > 0; --level) {
+		const uint32_t slot = (currentTick >> (SCHEDULER_WHEEL_BITS * level)) & (SCHEDULER_WHEEL_SLOTS - 1);
+		SchedulerTask* task = std::exchange(wheel[level * SCHEDULER_WHEEL_SLOTS + slot], nullptr);
+		while (task) {
+			SchedulerTask* next = task->next;
+			--wheelSize;
+			insert(task);
+			task = next;
 		}
-	});
+	}
+
+	SchedulerTask* task = std::exchange(wheel[currentTick & (SCHEDULER_WHEEL_SLOTS - 1)], nullptr);
+	while (task) {
+		SchedulerTask* next = task->next;
+		--wheelSize;
+		task->wheelSlot = SchedulerTask::NOT_IN_WHEEL;
+		dueTasks.push(task);
+		task = next;
+	}
 }
 
-void Scheduler::shutdown()
+void Scheduler::threadMain()
 {
-	setState(THREAD_STATE_TERMINATED);
-	boost::asio::post(io_context, [this]() {
-		// cancel all active timers
-		for (auto& it : eventIdTimerMap) {
-			it.second.cancel();
+	ThreadRegistration registration{THREAD_ROLE_SCHEDULER};
+	std::vector<SchedulerTask*> expired;
+	std::unique_lock<std::mutex> eventLockUnique(eventLock);
+
+	while (getState() != THREAD_STATE_TERMINATED) {
+		const int64_t currentTime = now();
+		const uint64_t targetTick = static_cast<uint64_t>(currentTime) / SCHEDULER_MINTICKS;
+		while (currentTick < targetTick) {
+			advance();
+		}
+
+		while (!dueTasks.empty() && dueTasks.top()->deadline <= currentTime) {
+			SchedulerTask* task = dueTasks.top();
+			dueTasks.pop();
+
+			if (task->cancelled) {
+				delete task;
+				continue;
+			}
+
+			activeEvents.erase(task->getEventId());
+			metrics::schedulerEvents.sub();
+			expired.push_back(task);
 		}
 
-		io_context.stop();
-	});
+		if (!expired.empty()) {
+			eventLockUnique.unlock();
+			for (SchedulerTask* task : expired) {
+				g_dispatcher.addTask(task);
+			}
+			expired.clear();
+			eventLockUnique.lock();
+			continue;
+		}
+
+		if (!dueTasks.empty()) {
+			eventSignal.wait_for(eventLockUnique, std::chrono::milliseconds(dueTasks.top()->deadline - currentTime));
+		} else if (wheelSize != 0) {
+			eventSignal.wait_for(eventLockUnique,
+			                     std::chrono::milliseconds((currentTick + 1) * SCHEDULER_MINTICKS - currentTime));
+		} else {
+			eventSignal.wait(eventLockUnique);
+		}
+	}
+
+	// Scheduler::shutdown has been called, release every pending task
+	for (SchedulerTask*& head : wheel) {
+		SchedulerTask* task = std::exchange(head, nullptr);
+		while (task) {
+			delete std::exchange(task, task->next);
+		}
+	}
+
+	while (!dueTasks.empty()) {
+		delete dueTasks.top();
+		dueTasks.pop();
+	}
+
+	metrics::schedulerEvents.sub(activeEvents.size());
+	activeEvents.clear();
+	wheelSize = 0;
 }
 
-SchedulerTask* createSchedulerTask(uint32_t delay, TaskFunc&& f) { return new SchedulerTask(delay, std::move(f)); }
+void Scheduler::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lockClass(eventLock);
+		setState(THREAD_STATE_TERMINATED);
+	}
+	eventSignal.notify_one();
+}
+
+SchedulerTask* createSchedulerTask(uint32_t delay, TaskFunc&& f, SchedulerEventType type /* = SCHEDULER_EVENT_GENERIC*/)
+{
+	return new SchedulerTask(delay, std::move(f), type);
+}
+
+const char* getSchedulerEventName(SchedulerEventType type)
+{
+	switch (type) {
+		case SCHEDULER_EVENT_GENERIC:
+			return "generic";
+		case SCHEDULER_EVENT_CREATURE_THINK:
+			return "creature think";
+		case SCHEDULER_EVENT_CREATURE_WALK:
+			return "creature walk";
+		case SCHEDULER_EVENT_CREATURE_CONDITION:
+			return "creature condition";
+		case SCHEDULER_EVENT_PLAYER_ACTION:
+			return "player action";
+		case SCHEDULER_EVENT_DECAY:
+			return "decay";
+		case SCHEDULER_EVENT_SPAWN:
+			return "spawn";
+		case SCHEDULER_EVENT_GLOBALEVENT:
+			return "globalevent";
+		case SCHEDULER_EVENT_RAID:
+			return "raid";
+		case SCHEDULER_EVENT_SERVER:
+			return "server";
+		default:
+			return "unknown";
+	}
+}
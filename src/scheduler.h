@@ -4,11 +4,36 @@
 #ifndef FS_SCHEDULER_H
 #define FS_SCHEDULER_H
 
+#include "flathashmap.h"
 #include "tasks.h"
 #include "thread_holder_base.h"
 
 inline constexpr int32_t SCHEDULER_MINTICKS = 50;
 
+// each wheel level has 64 slots, a slot of level N spans 64^N ticks of SCHEDULER_MINTICKS
+inline constexpr uint32_t SCHEDULER_WHEEL_BITS = 6;
+inline constexpr uint32_t SCHEDULER_WHEEL_SLOTS = 1 << SCHEDULER_WHEEL_BITS;
+inline constexpr uint32_t SCHEDULER_WHEEL_LEVELS = 4;
+
+// detail of TASK_ORIGIN_SCHEDULER task origins
+enum SchedulerEventType : uint8_t
+{
+	SCHEDULER_EVENT_GENERIC,
+	SCHEDULER_EVENT_CREATURE_THINK,
+	SCHEDULER_EVENT_CREATURE_WALK,
+	SCHEDULER_EVENT_CREATURE_CONDITION,
+	SCHEDULER_EVENT_PLAYER_ACTION,
+	SCHEDULER_EVENT_DECAY,
+	SCHEDULER_EVENT_SPAWN,
+	SCHEDULER_EVENT_GLOBALEVENT,
+	SCHEDULER_EVENT_RAID,
+	SCHEDULER_EVENT_SERVER,
+
+	SCHEDULER_EVENT_LAST /* this must be the last one */
+};
+
+const char* getSchedulerEventName(SchedulerEventType type);
+
 class SchedulerTask : public Task
 {
 public:
@@ -17,16 +42,31 @@ public:
 
 	uint32_t getDelay() const { return delay; }
 
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 private:
-	SchedulerTask(uint32_t delay, TaskFunc&& f) : Task(std::move(f)), delay(delay) {}
+	SchedulerTask(uint32_t delay, TaskFunc&& f, SchedulerEventType type) :
+	    Task(makeTaskOrigin(TASK_ORIGIN_SCHEDULER, type), std::move(f)), delay(delay)
+	{}
 
 	uint32_t eventId = 0;
 	uint32_t delay = 0;
 
-	friend SchedulerTask* createSchedulerTask(uint32_t, TaskFunc&&);
+	// timing wheel bookkeeping, only touched by the scheduler under its lock
+	static constexpr uint16_t NOT_IN_WHEEL = std::numeric_limits<uint16_t>::max();
+
+	int64_t deadline = 0;
+	SchedulerTask* prev = nullptr;
+	SchedulerTask* next = nullptr;
+	uint16_t wheelSlot = NOT_IN_WHEEL;
+	bool cancelled = false;
+
+	friend SchedulerTask* createSchedulerTask(uint32_t, TaskFunc&&, SchedulerEventType);
+	friend class Scheduler;
 };
 
-SchedulerTask* createSchedulerTask(uint32_t delay, TaskFunc&& f);
+SchedulerTask* createSchedulerTask(uint32_t delay, TaskFunc&& f, SchedulerEventType type = SCHEDULER_EVENT_GENERIC);
 
 class Scheduler : public ThreadHolder<Scheduler>
 {
@@ -36,13 +76,36 @@ public:
 
 	void shutdown();
 
-	void threadMain() { io_context.run(); }
+	void threadMain();
 
 private:
+	struct DeadlineCompare
+	{
+		bool operator()(const SchedulerTask* lhs, const SchedulerTask* rhs) const
+		{
+			return lhs->deadline > rhs->deadline;
+		}
+	};
+
+	int64_t now() const;
+
+	void insert(SchedulerTask* task);
+	void unlink(SchedulerTask* task);
+	void advance();
+
+	std::mutex eventLock;
+	std::condition_variable eventSignal;
+
+	const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	uint64_t currentTick = 0;
+	size_t wheelSize = 0;
+
+	std::array<SchedulerTask*, SCHEDULER_WHEEL_SLOTS * SCHEDULER_WHEEL_LEVELS> wheel = {};
+	// tasks whose slot came due, ordered by their exact deadline
+	std::priority_queue<SchedulerTask*, std::vector<SchedulerTask*>, DeadlineCompare> dueTasks;
+
 	std::atomic<uint32_t> lastEventId{0};
-	std::unordered_map<uint32_t, boost::asio::steady_timer> eventIdTimerMap;
-	boost::asio::io_context io_context;
-	boost::asio::io_context::work work{io_context};
+	FlatHashMap<uint32_t, SchedulerTask*> activeEvents{4096};
 };
 
 extern Scheduler g_scheduler;
@@ -5,29 +5,43 @@
 
 #include "script.h"
 
+#include "actions.h"
 #include "configmanager.h"
+#include "creatureevent.h"
+#include "globalevent.h"
+#include "movement.h"
+#include "spells.h"
+#include "talkaction.h"
+#include "weapons.h"
 
 #include <fmt/color.h>
+#include <fstream>
 
 extern LuaEnvironment g_luaEnvironment;
 extern ConfigManager g_config;
+extern Actions* g_actions;
+extern CreatureEvents* g_creatureEvents;
+extern GlobalEvents* g_globalEvents;
+extern MoveEvents* g_moveEvents;
+extern Spells* g_spells;
+extern TalkActions* g_talkActions;
+extern Weapons* g_weapons;
 
-Scripts::Scripts() : scriptInterface("Scripts Interface") { scriptInterface.initState(); }
+namespace {
 
-Scripts::~Scripts() { scriptInterface.reInitState(); }
+std::string scriptName(const std::filesystem::path& path, fmt::color color)
+{
+	const auto& name = path.filename().string();
+	return fmt::format("\"{}\"", fmt::format(fg(color), "{}", std::string_view(name.data(), name.size() - 4)));
+}
 
-bool Scripts::loadScripts(const std::string& folderName, bool isLib, bool reload)
+// the lua files of dir in the order they run, files starting with # are disabled
+std::vector<std::filesystem::path> listScripts(const std::filesystem::path& dir, bool isLib,
+                                               std::vector<std::string>& disabled)
 {
 	namespace fs = std::filesystem;
 
-	const auto dir = fs::current_path() / "data" / folderName;
-	if (!fs::exists(dir) || !fs::is_directory(dir)) {
-		std::cout << "[Warning - Scripts::loadScripts] Can not load folder '" << folderName << "'." << std::endl;
-		return false;
-	}
-
 	const bool& scriptsConsoleLogs = g_config[ConfigKeysBoolean::SCRIPTS_CONSOLE_LOGS];
-	std::vector<std::string> disabled = {}, loaded = {}, reloaded = {};
 
 	fs::recursive_directory_iterator endit;
 	std::vector<fs::path> v;
@@ -41,10 +55,7 @@ bool Scripts::loadScripts(const std::string& folderName, bool isLib, bool reload
 			size_t found = it->path().filename().string().find(disable);
 			if (found != std::string::npos) {
 				if (scriptsConsoleLogs) {
-					const auto& scrName = it->path().filename().string();
-					disabled.push_back(
-					    fmt::format("\"{}\"", fmt::format(fg(fmt::color::yellow), "{}",
-					                                      std::string_view(scrName.data(), scrName.size() - 4))));
+					disabled.push_back(scriptName(it->path(), fmt::color::yellow));
 				}
 				continue;
 			}
@@ -52,41 +63,166 @@ bool Scripts::loadScripts(const std::string& folderName, bool isLib, bool reload
 		}
 	}
 	sort(v.begin(), v.end());
-	for (auto it = v.begin(); it != v.end(); ++it) {
-		const std::string scriptFile = it->string();
-		if (scriptInterface.loadFile(scriptFile) == -1) {
-			std::cout << "> " << it->filename().string() << " [error]" << std::endl;
-			std::cout << "^ " << scriptInterface.getLastLuaError() << std::endl;
+	return v;
+}
+
+std::optional<size_t> hashScript(const std::filesystem::path& path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return std::nullopt;
+	}
+
+	std::ostringstream content;
+	content << file.rdbuf();
+	return std::hash<std::string_view>{}(content.view());
+}
+
+void printScripts(const std::vector<std::string>& names)
+{
+	if (!names.empty()) {
+		std::cout << fmt::format("{{{}}}", fmt::join(names, ", ")) << std::endl;
+	}
+}
+
+} // namespace
+
+Scripts::Scripts() : scriptInterface("Scripts Interface") { scriptInterface.initState(); }
+
+Scripts::~Scripts() { scriptInterface.reInitState(); }
+
+bool Scripts::loadScripts(const std::string& folderName, bool isLib, bool reload)
+{
+	namespace fs = std::filesystem;
+
+	const auto dir = fs::current_path() / "data" / folderName;
+	if (!fs::exists(dir) || !fs::is_directory(dir)) {
+		std::cout << "[Warning - Scripts::loadScripts] Can not load folder '" << folderName << "'." << std::endl;
+		return false;
+	}
+
+	const bool& scriptsConsoleLogs = g_config[ConfigKeysBoolean::SCRIPTS_CONSOLE_LOGS];
+	std::vector<std::string> disabled = {}, loaded = {}, reloaded = {};
+
+	for (const auto& path : listScripts(dir, isLib, disabled)) {
+		if (isLib) {
+			if (scriptInterface.loadFile(path.string()) == -1) {
+				std::cout << "> " << path.filename().string() << " [error]" << std::endl;
+				std::cout << "^ " << scriptInterface.getLastLuaError() << std::endl;
+				continue;
+			}
+		} else if (!runScript(path, hashScript(path).value_or(0))) {
 			continue;
 		}
 
 		if (scriptsConsoleLogs) {
-			const auto& scrName = it->filename().string();
-			if (!reload) {
-				loaded.push_back(fmt::format(
-				    "\"{}\"",
-				    fmt::format(fg(fmt::color::green), "{}", std::string_view(scrName.data(), scrName.size() - 4))));
-			} else {
-				reloaded.push_back(fmt::format(
-				    "\"{}\"",
-				    fmt::format(fg(fmt::color::green), "{}", std::string_view(scrName.data(), scrName.size() - 4))));
-			}
+			(reload ? reloaded : loaded).push_back(scriptName(path, fmt::color::green));
 		}
 	}
 
 	if (scriptsConsoleLogs) {
-		if (!disabled.empty()) {
-			std::cout << fmt::format("{{{}}}", fmt::join(disabled, ", ")) << std::endl;
+		printScripts(disabled);
+		printScripts(loaded);
+		printScripts(reloaded);
+	}
+
+	return true;
+}
+
+bool Scripts::reloadChangedScripts(const std::string& folderName)
+{
+	namespace fs = std::filesystem;
+
+	const auto dir = fs::current_path() / "data" / folderName;
+	if (!fs::exists(dir) || !fs::is_directory(dir)) {
+		std::cout << "[Warning - Scripts::reloadChangedScripts] Can not load folder '" << folderName << "'."
+		          << std::endl;
+		return false;
+	}
+
+	std::vector<std::string> disabled, reloaded, removed;
+	const std::vector<fs::path> paths = listScripts(dir, false, disabled);
+
+	std::unordered_set<std::string> present;
+	std::vector<std::pair<fs::path, size_t>> changed;
+	for (const auto& path : paths) {
+		std::string file = path.string();
+		const size_t contentHash = hashScript(path).value_or(0);
+		auto it = scriptHashes.find(file);
+		if (it == scriptHashes.end() || it->second != contentHash) {
+			changed.emplace_back(path, contentHash);
 		}
+		present.insert(std::move(file));
+	}
 
-		if (!loaded.empty()) {
-			std::cout << fmt::format("{{{}}}", fmt::join(loaded, ", ")) << std::endl;
+	const std::string prefix = (dir / "").string();
+	for (auto it = scriptHashes.begin(); it != scriptHashes.end();) {
+		if (it->first.starts_with(prefix) && !present.contains(it->first)) {
+			unloadScript(it->first);
+			removed.push_back(scriptName(it->first, fmt::color::yellow));
+			it = scriptHashes.erase(it);
+		} else {
+			++it;
 		}
+	}
 
-		if (!reloaded.empty()) {
-			std::cout << fmt::format("{{{}}}", fmt::join(reloaded, ", ")) << std::endl;
+	for (const auto& [path, contentHash] : changed) {
+		unloadScript(path.string());
+		if (runScript(path, contentHash)) {
+			reloaded.push_back(scriptName(path, fmt::color::green));
 		}
 	}
 
+	if (g_config[ConfigKeysBoolean::SCRIPTS_CONSOLE_LOGS]) {
+		printScripts(removed);
+		printScripts(reloaded);
+	}
 	return true;
 }
+
+bool Scripts::runScript(const std::filesystem::path& path, size_t contentHash)
+{
+	loadingFile = path.string();
+	const bool success = scriptInterface.loadFile(loadingFile) != -1;
+	if (success) {
+		scriptHashes.insert_or_assign(loadingFile, contentHash);
+	} else {
+		// the file runs again on the next reload, whatever it registered before failing stays until then
+		scriptHashes.erase(loadingFile);
+		std::cout << "> " << path.filename().string() << " [error]" << std::endl;
+		std::cout << "^ " << scriptInterface.getLastLuaError() << std::endl;
+	}
+	loadingFile.clear();
+	return success;
+}
+
+void Scripts::unloadScript(const std::string& file)
+{
+	g_actions->clearScriptFile(file);
+	g_creatureEvents->clearScriptFile(file);
+	g_globalEvents->clearScriptFile(file);
+	g_moveEvents->clearScriptFile(file);
+	g_spells->clearScriptFile(file);
+	g_talkActions->clearScriptFile(file);
+	g_weapons->clearScriptFile(file);
+
+	// what the libraries keep per file, such as event callbacks, is dropped by onUnloadScriptFile(file)
+	lua_State* L = scriptInterface.getLuaState();
+	lua_getglobal(L, "onUnloadScriptFile");
+	if (!Lua::isFunction(L, -1)) {
+		lua_pop(L, 1);
+		return;
+	}
+
+	if (!LuaScriptInterface::reserveScriptEnv()) {
+		lua_pop(L, 1);
+		return;
+	}
+
+	LuaScriptInterface::getScriptEnv()->setScriptId(EVENT_ID_LOADING, &scriptInterface);
+	Lua::pushString(L, file);
+	if (LuaScriptInterface::protectedCall(L, 1, 0) != 0) {
+		LuaScriptInterface::reportError(nullptr, Lua::popString(L));
+	}
+	LuaScriptInterface::resetScriptEnv();
+}
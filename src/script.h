@@ -14,10 +14,22 @@ public:
 	~Scripts();
 
 	bool loadScripts(const std::string& folderName, bool isLib, bool reload);
+	// runs only the files whose content changed since they ran, the events of changed and removed files are
+	// unregistered first
+	bool reloadChangedScripts(const std::string& folderName);
 	LuaScriptInterface& getScriptInterface() { return scriptInterface; }
 
+	// the file loadScripts is running, empty outside of it
+	const std::string& getLoadingFile() const { return loadingFile; }
+
 private:
+	bool runScript(const std::filesystem::path& path, size_t contentHash);
+	void unloadScript(const std::string& file);
+
 	LuaScriptInterface scriptInterface;
+	// content hash by path of the files that ran, libraries are always loaded whole and not kept
+	std::map<std::string, size_t> scriptHashes;
+	std::string loadingFile;
 };
 
 #endif
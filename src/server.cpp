@@ -9,21 +9,149 @@
 #include "configmanager.h"
 #include "outputmessage.h"
 #include "scheduler.h"
+#include "threadregistry.h"
 
 extern ConfigManager g_config;
 Ban g_bans;
 
-ServiceManager::~ServiceManager() { stop(); }
+ServiceManager::~ServiceManager()
+{
+	stop();
+	// the network threads must be joined even if io_service stopped without die
+	die();
+}
+
+void ServiceManager::die()
+{
+	io_service.stop();
 
-void ServiceManager::die() { io_service.stop(); }
+	connectionWork.clear();
+	for (auto& connectionService : connectionServices) {
+		connectionService->stop();
+	}
+	for (std::thread& thread : connectionThreads) {
+		thread.join();
+	}
+	connectionThreads.clear();
+}
 
 void ServiceManager::run()
 {
 	assert(!running);
 	running = true;
+
+	// handed over for ports this server no longer serves
+	Handover::release({handedOverSockets.begin(), handedOverSockets.end()});
+	handedOverSockets.clear();
+
+	int64_t threads = g_config[ConfigKeysInteger::NETWORK_THREADS];
+	if (threads == 0) {
+		threads = std::max<int64_t>(1, std::thread::hardware_concurrency());
+	}
+
+	if (threads > 1) {
+		for (int64_t i = 0; i < threads; ++i) {
+			auto& connectionService = connectionServices.emplace_back(std::make_unique<boost::asio::io_service>());
+			connectionWork.emplace_back(boost::asio::make_work_guard(*connectionService));
+			ConnectionManager::getInstance().addShard(*connectionService);
+			startIdleSweep(*connectionService);
+			connectionThreads.emplace_back([&connectionService = *connectionService]() {
+				ThreadRegistration registration{THREAD_ROLE_NETWORK};
+				connectionService.run();
+			});
+		}
+		std::cout << ">> Network running on " << threads << " threads." << std::endl;
+	} else {
+		ConnectionManager::getInstance().addShard(io_service);
+		startIdleSweep(io_service);
+	}
+
+	// acceptors and signals, and every connection with a single network thread
+	ThreadRegistration registration{THREAD_ROLE_NETWORK};
 	io_service.run();
 }
 
+void ServiceManager::startIdleSweep(boost::asio::io_service& service)
+{
+	auto& timer = idleSweepTimers.emplace_back(std::make_unique<boost::asio::steady_timer>(service));
+	scheduleIdleSweep(*timer, service);
+}
+
+void ServiceManager::scheduleIdleSweep(boost::asio::steady_timer& timer, boost::asio::io_service& service)
+{
+	timer.expires_from_now(std::chrono::seconds(CONNECTION_IDLE_SWEEP_INTERVAL));
+	timer.async_wait([&timer, &service](const boost::system::error_code& error) {
+		if (error == boost::asio::error::operation_aborted) {
+			return;
+		}
+
+		ConnectionManager::getInstance().closeIdleConnections(service);
+		scheduleIdleSweep(timer, service);
+	});
+}
+
+boost::asio::io_service& ServiceManager::getConnectionService()
+{
+	if (connectionServices.empty()) {
+		return io_service;
+	}
+	return *connectionServices[nextConnectionService++ % connectionServices.size()];
+}
+
+void ServiceManager::adoptListeningSockets(Handover::Sockets sockets)
+{
+	for (const auto& [port, socket] : sockets) {
+		if (!handedOverSockets.emplace(port, socket).second) {
+			Handover::release({{port, socket}});
+		}
+	}
+}
+
+Handover::Sockets ServiceManager::getListeningSockets() const
+{
+	Handover::Sockets sockets;
+	for (const auto& [port, servicePort] : acceptors) {
+		int socket = servicePort->get_native_handle();
+		if (socket != -1) {
+			sockets.emplace_back(port, socket);
+		}
+	}
+	return sockets;
+}
+
+void ServiceManager::listenForHandover(const std::string& path, std::function<void()> onRequest)
+{
+#ifndef _WIN32
+	using boost::asio::local::stream_protocol;
+
+	// a socket file left over from the server being replaced
+	std::error_code ec;
+	std::filesystem::remove(path, ec);
+
+	try {
+		handoverAcceptor = std::make_unique<stream_protocol::acceptor>(io_service, stream_protocol::endpoint(path));
+	} catch (boost::system::system_error& e) {
+		std::cout << "[ServiceManager::listenForHandover] Error: " << e.what() << std::endl;
+		return;
+	}
+
+	auto peer = std::make_shared<stream_protocol::socket>(io_service);
+	handoverAcceptor->async_accept(
+	    *peer, [this, peer, onRequest = std::move(onRequest)](const boost::system::error_code& error) {
+		    if (error) {
+			    return;
+		    }
+
+		    std::cout << ">> A replacement server asked for the listening sockets, shutting down..." << std::endl;
+		    Handover::hold(peer->native_handle(), getListeningSockets());
+		    handoverAcceptor->close();
+		    onRequest();
+	    });
+#else
+	std::cout << "[ServiceManager::listenForHandover] Handing over is not supported on Windows." << std::endl;
+#endif
+}
+
 void ServiceManager::stop()
 {
 	if (!running) {
@@ -71,7 +199,8 @@ void ServicePort::accept()
 		return;
 	}
 
-	auto connection = ConnectionManager::getInstance().createConnection(io_service, shared_from_this());
+	auto connection =
+	    ConnectionManager::getInstance().createConnection(manager.getConnectionService(), shared_from_this());
 	acceptor->async_accept(connection->getSocket(),
 	                       [=, thisPtr = shared_from_this()](const boost::system::error_code& error) {
 		                       thisPtr->onAccept(connection, error);
@@ -167,6 +296,31 @@ void ServicePort::open(uint16_t port)
 	}
 }
 
+void ServicePort::adopt(uint16_t port, int socket)
+{
+	close();
+
+	serverPort = port;
+	pendingStart = false;
+
+	try {
+		acceptor.reset(new boost::asio::ip::tcp::acceptor(io_service, boost::asio::ip::tcp::v4(), socket));
+		accept();
+	} catch (boost::system::system_error& e) {
+		std::cout << "[ServicePort::adopt] Error: " << e.what() << std::endl;
+		Handover::release({{port, socket}});
+		open(port);
+	}
+}
+
+int ServicePort::get_native_handle() const
+{
+	if (!acceptor || !acceptor->is_open()) {
+		return -1;
+	}
+	return static_cast<int>(acceptor->native_handle());
+}
+
 void ServicePort::close()
 {
 	if (acceptor && acceptor->is_open()) {
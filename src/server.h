@@ -5,11 +5,13 @@
 #define FS_SERVER_H
 
 #include "connection.h"
+#include "handover.h"
 #include "signals.h"
 
 #include <memory>
 
 class Protocol;
+class ServiceManager;
 
 class ServiceBase
 {
@@ -39,7 +41,8 @@ public:
 class ServicePort : public std::enable_shared_from_this<ServicePort>
 {
 public:
-	explicit ServicePort(boost::asio::io_service& io_service) : io_service(io_service) {}
+	ServicePort(boost::asio::io_service& io_service, ServiceManager& manager) : io_service(io_service), manager(manager)
+	{}
 	~ServicePort();
 
 	// non-copyable
@@ -48,9 +51,13 @@ public:
 
 	static void openAcceptor(std::weak_ptr<ServicePort> weak_service, uint16_t port);
 	void open(uint16_t port);
+	// accepts on a socket another server was listening on, see Handover
+	void adopt(uint16_t port, int socket);
 	void close();
 	bool is_single_socket() const;
 	std::string get_protocol_names() const;
+	// -1 while no acceptor is open
+	int get_native_handle() const;
 
 	bool add_service(const Service_ptr& new_svc);
 	Protocol_ptr make_protocol(bool checksummed, NetworkMessage& msg, const Connection_ptr& connection) const;
@@ -62,6 +69,7 @@ private:
 	void accept();
 
 	boost::asio::io_service& io_service;
+	ServiceManager& manager;
 	std::unique_ptr<boost::asio::ip::tcp::acceptor> acceptor;
 	std::vector<Service_ptr> services;
 
@@ -87,12 +95,37 @@ public:
 
 	bool is_running() const { return acceptors.empty() == false; }
 
+	// ports added after this accept on the sockets a replaced server handed over instead of binding again
+	void adoptListeningSockets(Handover::Sockets sockets);
+	// calls onRequest once when a replacement connects to path, it should shut the server down
+	void listenForHandover(const std::string& path, std::function<void()> onRequest);
+
+	// io_service new connections run on, handed out round-robin when networkThreads is above 1
+	boost::asio::io_service& getConnectionService();
+
 private:
 	void die();
+	// closes the idle connections of service every CONNECTION_IDLE_SWEEP_INTERVAL seconds
+	void startIdleSweep(boost::asio::io_service& service);
+	static void scheduleIdleSweep(boost::asio::steady_timer& timer, boost::asio::io_service& service);
+	Handover::Sockets getListeningSockets() const;
 
 	std::unordered_map<uint16_t, ServicePort_ptr> acceptors;
+	std::unordered_map<uint16_t, int> handedOverSockets;
+#ifndef _WIN32
+	std::unique_ptr<boost::asio::local::stream_protocol::acceptor> handoverAcceptor;
+#endif
 
 	boost::asio::io_service io_service;
+
+	// acceptors, signals and the death timer stay on io_service, only connections are spread over these
+	using WorkGuard = boost::asio::executor_work_guard<boost::asio::io_service::executor_type>;
+	std::vector<std::unique_ptr<boost::asio::io_service>> connectionServices;
+	std::vector<WorkGuard> connectionWork;
+	std::vector<std::thread> connectionThreads;
+	std::atomic<size_t> nextConnectionService{0};
+	std::vector<std::unique_ptr<boost::asio::steady_timer>> idleSweepTimers;
+
 	Signals signals{io_service};
 	boost::asio::steady_timer death_timer{io_service};
 	bool running = false;
@@ -112,8 +145,12 @@ bool ServiceManager::add(uint16_t port)
 	auto foundServicePort = acceptors.find(port);
 
 	if (foundServicePort == acceptors.end()) {
-		service_port = std::make_shared<ServicePort>(io_service);
-		service_port->open(port);
+		service_port = std::make_shared<ServicePort>(io_service, *this);
+		if (auto socket = handedOverSockets.extract(port)) {
+			service_port->adopt(port, socket.mapped());
+		} else {
+			service_port->open(port);
+		}
 		acceptors[port] = service_port;
 	} else {
 		service_port = foundServicePort->second;
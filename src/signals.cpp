@@ -11,6 +11,7 @@
 #include "events.h"
 #include "game.h"
 #include "globalevent.h"
+#include "memorystats.h"
 #include "monster.h"
 #include "movement.h"
 #include "raids.h"
@@ -18,6 +19,7 @@
 #include "spells.h"
 #include "talkaction.h"
 #include "tasks.h"
+#include "tickprofiler.h"
 #include "weapons.h"
 
 #include <csignal>
@@ -42,6 +44,8 @@ extern LuaEnvironment g_luaEnvironment;
 
 namespace {
 
+std::function<void()> shutdownHandler;
+
 void sigbreakHandler()
 {
 	// Dispatcher thread
@@ -63,6 +67,14 @@ void sigusr1Handler()
 	g_game.saveGameState();
 }
 
+void sigusr2Handler()
+{
+	// Dispatcher thread
+	std::cout << "SIGUSR2 received, printing the slow ticks and memory stats..." << std::endl;
+	g_tickProfiler.logSlowTicks();
+	MemoryStats::print();
+}
+
 void sighupHandler()
 {
 	// Dispatcher thread
@@ -130,6 +142,22 @@ void sigintHandler()
 // https://github.com/otland/forgottenserver/pull/2473
 void dispatchSignalHandler(int signal)
 {
+	if (shutdownHandler) {
+#ifndef _WIN32
+		if (signal == SIGINT || signal == SIGTERM) {
+			g_dispatcher.addTask([]() { shutdownHandler(); });
+		}
+#else
+		if (signal == SIGINT || signal == SIGTERM || signal == SIGBREAK) {
+			g_dispatcher.addTask([]() { shutdownHandler(); });
+			if (signal == SIGBREAK) {
+				g_dispatcher.join();
+			}
+		}
+#endif
+		return;
+	}
+
 	switch (signal) {
 		case SIGINT: // Shuts the server down
 			g_dispatcher.addTask(sigintHandler);
@@ -144,6 +172,9 @@ void dispatchSignalHandler(int signal)
 		case SIGUSR1: // Saves game state
 			g_dispatcher.addTask(sigusr1Handler);
 			break;
+		case SIGUSR2: // Prints the slow ticks
+			g_dispatcher.addTask(sigusr2Handler);
+			break;
 #else
 		case SIGBREAK: // Shuts the server down
 			g_dispatcher.addTask(sigbreakHandler);
@@ -166,6 +197,7 @@ Signals::Signals(boost::asio::io_service& service) : set(service)
 	set.add(SIGTERM);
 #ifndef _WIN32
 	set.add(SIGUSR1);
+	set.add(SIGUSR2);
 	set.add(SIGHUP);
 #else
 	// This must be a blocking call as Windows calls it in a new thread and terminates
@@ -177,6 +209,8 @@ Signals::Signals(boost::asio::io_service& service) : set(service)
 	asyncWait();
 }
 
+void Signals::setShutdownHandler(std::function<void()> handler) { shutdownHandler = std::move(handler); }
+
 void Signals::asyncWait()
 {
 	set.async_wait([this](const boost::system::error_code& err, int signal) {
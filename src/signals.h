@@ -13,6 +13,9 @@ class Signals
 public:
 	explicit Signals(boost::asio::io_service& service);
 
+	// runs on the dispatcher thread instead of shutting the game down, the other signals are ignored once it is set
+	static void setShutdownHandler(std::function<void()> handler);
+
 private:
 	void asyncWait();
 };
@@ -0,0 +1,115 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_SLOTMAP_H
+#define FS_SLOTMAP_H
+
+/*
+ * Hands out 32 bit ids from a range, an id is a slot index and the slot generation above the first id of the range.
+ * Lookup is an index and a generation compare. A slot whose generations run out is retired, so an id is not handed
+ * out twice until the whole range was used up, the same as with an increasing counter.
+ */
+template <typename T>
+class SlotMap
+{
+	static constexpr uint32_t GenerationBits = 12;
+	static constexpr uint32_t GenerationMask = (1 << GenerationBits) - 1;
+
+	struct Slot
+	{
+		T* value = nullptr;
+		uint32_t generation = 0;
+		bool used = false;
+	};
+
+public:
+	SlotMap(uint32_t firstId, uint64_t endId) :
+	    firstId{firstId}, capacity{static_cast<uint32_t>((endId - firstId) >> GenerationBits)}
+	{}
+
+	bool isInRange(uint32_t id) const { return id >= firstId && ((id - firstId) >> GenerationBits) < capacity; }
+
+	// reserves an id, nothing is found by it until a value is set, 0 if every slot is in use
+	uint32_t acquire()
+	{
+		if (freeSlots.empty()) {
+			if (slots.size() < capacity) {
+				freeSlots.push_back(static_cast<uint32_t>(slots.size()));
+				slots.emplace_back();
+			} else {
+				// every id of the range was handed out, the retired slots start over
+				for (size_t index = 0; index < slots.size(); ++index) {
+					if (slots[index].generation > GenerationMask) {
+						slots[index].generation = 0;
+						freeSlots.push_back(static_cast<uint32_t>(index));
+					}
+				}
+
+				if (freeSlots.empty()) {
+					return 0;
+				}
+			}
+		}
+
+		const uint32_t index = freeSlots.back();
+		freeSlots.pop_back();
+
+		Slot& slot = slots[index];
+		slot.used = true;
+		return firstId + (index << GenerationBits) + slot.generation;
+	}
+
+	void release(uint32_t id)
+	{
+		Slot* slot = getSlot(id);
+		if (!slot) {
+			return;
+		}
+
+		slot->value = nullptr;
+		slot->used = false;
+		if (++slot->generation <= GenerationMask) {
+			freeSlots.push_back((id - firstId) >> GenerationBits);
+		}
+	}
+
+	void set(uint32_t id, T* value)
+	{
+		if (Slot* slot = getSlot(id)) {
+			slot->value = value;
+		}
+	}
+
+	T* find(uint32_t id) const
+	{
+		const Slot* slot = const_cast<SlotMap*>(this)->getSlot(id);
+		return slot ? slot->value : nullptr;
+	}
+
+private:
+	Slot* getSlot(uint32_t id)
+	{
+		if (id < firstId) {
+			return nullptr;
+		}
+
+		const uint32_t offset = id - firstId;
+		const uint32_t index = offset >> GenerationBits;
+		if (index >= slots.size()) {
+			return nullptr;
+		}
+
+		Slot& slot = slots[index];
+		if (!slot.used || slot.generation != (offset & GenerationMask)) {
+			return nullptr;
+		}
+		return &slot;
+	}
+
+	std::vector<Slot> slots;
+	std::vector<uint32_t> freeSlots;
+	uint32_t firstId;
+	uint32_t capacity;
+};
+
+#endif // FS_SLOTMAP_H
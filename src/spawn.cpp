@@ -8,6 +8,7 @@
 #include "configmanager.h"
 #include "events.h"
 #include "game.h"
+#include "logger.h"
 #include "monster.h"
 #include "pugicast.h"
 #include "scheduler.h"
@@ -50,13 +51,13 @@ bool Spawns::loadFromXml(std::string_view filename)
 		}
 
 		if (radius > 30) {
-			std::cout << "[Warning - Spawns::loadFromXml] Radius size bigger than 30 at position: " << centerPos
-			          << ", consider lowering it." << std::endl;
+			Logger::log(LOG_WARNING, "Spawns::loadFromXml",
+			            "Radius size bigger than 30 at position: {}, consider lowering it.", centerPos);
 		}
 
 		if (!spawnNode.first_child()) {
-			std::cout << "[Warning - Spawns::loadFromXml] Empty spawn at position: " << centerPos
-			          << " with radius: " << radius << '.' << std::endl;
+			Logger::log(LOG_WARNING, "Spawns::loadFromXml", "Empty spawn at position: {} with radius: {}.", centerPos,
+			            radius);
 			continue;
 		}
 
@@ -70,18 +71,18 @@ bool Spawns::loadFromXml(std::string_view filename)
 
 				int32_t interval = pugi::cast<int32_t>(childNode.attribute("spawntime").value()) * 1000;
 				if (interval < MINSPAWN_INTERVAL) {
-					std::cout << "[Warning - Spawns::loadFromXml] " << pos << " spawntime can not be less than "
-					          << MINSPAWN_INTERVAL / 1000 << " seconds." << std::endl;
+					Logger::log(LOG_WARNING, "Spawns::loadFromXml", "{} spawntime can not be less than {} seconds.",
+					            pos, MINSPAWN_INTERVAL / 1000);
 					continue;
 				} else if (interval > MAXSPAWN_INTERVAL) {
-					std::cout << "[Warning - Spawns::loadFromXml] " << pos << " spawntime can not be more than "
-					          << MAXSPAWN_INTERVAL / 1000 << " seconds." << std::endl;
+					Logger::log(LOG_WARNING, "Spawns::loadFromXml", "{} spawntime can not be more than {} seconds.",
+					            pos, MAXSPAWN_INTERVAL / 1000);
 					continue;
 				}
 
 				size_t monstersCount = std::distance(childNode.children().begin(), childNode.children().end());
 				if (monstersCount == 0) {
-					std::cout << "[Warning - Spawns::loadFromXml] " << pos << " empty monsters set." << std::endl;
+					Logger::log(LOG_WARNING, "Spawns::loadFromXml", "{} empty monsters set.", pos);
 					continue;
 				}
 
@@ -100,8 +101,8 @@ bool Spawns::loadFromXml(std::string_view filename)
 
 					MonsterType* mType = g_monsters.getMonsterType(nameAttribute.as_string());
 					if (!mType) {
-						std::cout << "[Warning - Spawn::loadFromXml] " << pos << " can not find "
-						          << nameAttribute.as_string() << std::endl;
+						Logger::log(LOG_WARNING, "Spawn::loadFromXml", "{} can not find {}", pos,
+						            nameAttribute.as_string());
 						continue;
 					}
 
@@ -114,8 +115,8 @@ bool Spawns::loadFromXml(std::string_view filename)
 					if (chance + totalChance > 100) {
 						chance = 100 - totalChance;
 						totalChance = 100;
-						std::cout << "[Warning - Spawns::loadFromXml] " << mType->name << ' ' << pos
-						          << " total chance for set can not be higher than 100." << std::endl;
+						Logger::log(LOG_WARNING, "Spawns::loadFromXml",
+						            "{} {} total chance for set can not be higher than 100.", mType->name, pos);
 					} else {
 						totalChance += chance;
 					}
@@ -124,7 +125,7 @@ bool Spawns::loadFromXml(std::string_view filename)
 				}
 
 				if (sb.mTypes.empty()) {
-					std::cout << "[Warning - Spawns::loadFromXml] " << pos << " empty monsters set." << std::endl;
+					Logger::log(LOG_WARNING, "Spawns::loadFromXml", "{} empty monsters set.", pos);
 					continue;
 				}
 
@@ -159,13 +160,13 @@ bool Spawns::loadFromXml(std::string_view filename)
 					spawn.addMonster(nameAttribute.as_string(), pos, dir, static_cast<uint32_t>(interval));
 				} else {
 					if (interval < MINSPAWN_INTERVAL) {
-						std::cout << "[Warning - Spawns::loadFromXml] " << nameAttribute.as_string() << ' ' << pos
-						          << " spawntime can not be less than " << MINSPAWN_INTERVAL / 1000 << " seconds."
-						          << std::endl;
+						Logger::log(LOG_WARNING, "Spawns::loadFromXml",
+						            "{} {} spawntime can not be less than {} seconds.", nameAttribute.as_string(), pos,
+						            MINSPAWN_INTERVAL / 1000);
 					} else {
-						std::cout << "[Warning - Spawns::loadFromXml] " << nameAttribute.as_string() << ' ' << pos
-						          << " spawntime can not be more than " << MAXSPAWN_INTERVAL / 1000 << " seconds."
-						          << std::endl;
+						Logger::log(LOG_WARNING, "Spawns::loadFromXml",
+						            "{} {} spawntime can not be more than {} seconds.", nameAttribute.as_string(), pos,
+						            MAXSPAWN_INTERVAL / 1000);
 					}
 				}
 			} else if (caseInsensitiveEqual(childNode.name(), "npc")) {
@@ -201,24 +202,38 @@ void Spawns::startup()
 		return;
 	}
 
+	// nobody is online yet, so nothing is told about the placed creatures
+	const int64_t start = OTSYS_NANOTIME();
+	size_t npcCount = 0, monsterCount = 0;
 	for (Npc* npc : npcList) {
-		if (!g_game.placeCreature(npc, npc->getMasterPos(), false, true)) {
-			std::cout << "[Warning - Spawns::startup] Couldn't spawn npc \"" << npc->getName()
-			          << "\" on position: " << npc->getMasterPos() << '.' << std::endl;
+		if (!g_game.placeStartupCreature(npc, npc->getMasterPos())) {
+			Logger::log(LOG_WARNING, "Spawns::startup", "Couldn't spawn npc \"{}\" on position: {}.", npc->getName(),
+			            npc->getMasterPos());
 			delete npc;
+			continue;
 		}
+		++npcCount;
 	}
 	npcList.clear();
 
 	for (Spawn& spawn : spawnList) {
-		spawn.startup();
+		monsterCount += spawn.startup();
 	}
 
 	started = true;
+	Logger::log(LOG_INFO, "Spawns::startup",
+	            "Placed {} monsters and {} npcs from {} in {:.2f} ms, skipping {} spectator notifications.",
+	            monsterCount, npcCount, filename, (OTSYS_NANOTIME() - start) / 1e6, monsterCount + npcCount);
 }
 
 void Spawns::clear()
 {
+	if (checkEvent != 0) {
+		g_scheduler.stopEvent(checkEvent);
+		checkEvent = 0;
+	}
+	checkQueue = {};
+
 	for (Spawn& spawn : spawnList) {
 		spawn.stopEvent();
 	}
@@ -229,6 +244,60 @@ void Spawns::clear()
 	filename.clear();
 }
 
+void Spawns::scheduleCheck(Spawn& spawn, int64_t due)
+{
+	// an earlier entry stays live and the spawn requeues itself from there
+	if (spawn.queuedCheck != 0 && spawn.queuedCheck <= due) {
+		return;
+	}
+
+	spawn.queuedCheck = due;
+	checkQueue.push({due, &spawn});
+	scheduleEvent(due);
+}
+
+void Spawns::scheduleEvent(int64_t due)
+{
+	if (checkEvent != 0) {
+		if (checkEventDue <= due) {
+			return;
+		}
+		g_scheduler.stopEvent(checkEvent);
+	}
+
+	checkEventDue = due;
+	const int64_t delay = std::max<int64_t>(0, due - OTSYS_TIME());
+	checkEvent = g_scheduler.addEvent(
+	    createSchedulerTask(static_cast<uint32_t>(delay), [this]() { checkSpawns(); }, SCHEDULER_EVENT_SPAWN));
+}
+
+void Spawns::checkSpawns()
+{
+	checkEvent = 0;
+
+	const int64_t now = OTSYS_TIME();
+	while (!checkQueue.empty() && checkQueue.top().due <= now) {
+		auto [due, spawn] = checkQueue.top();
+		checkQueue.pop();
+
+		// superseded by an earlier entry or stopped
+		if (due != spawn->queuedCheck) {
+			continue;
+		}
+		spawn->queuedCheck = 0;
+		spawn->checkSpawn();
+	}
+
+	// drop stale entries so they do not keep the event alive
+	while (!checkQueue.empty() && checkQueue.top().due != checkQueue.top().spawn->queuedCheck) {
+		checkQueue.pop();
+	}
+
+	if (!checkQueue.empty()) {
+		scheduleEvent(checkQueue.top().due);
+	}
+}
+
 bool Spawns::isInZone(const Position& centerPos, int32_t radius, const Position& pos)
 {
 	if (radius == -1) {
@@ -239,12 +308,7 @@ bool Spawns::isInZone(const Position& centerPos, int32_t radius, const Position&
 	        (pos.getY() >= centerPos.getY() - radius) && (pos.getY() <= centerPos.getY() + radius));
 }
 
-void Spawn::startSpawnCheck()
-{
-	if (checkSpawnEvent == 0) {
-		checkSpawnEvent = g_scheduler.addEvent(createSchedulerTask(getInterval(), [this]() { checkSpawn(); }));
-	}
-}
+void Spawn::startSpawnCheck() { g_game.map.spawns.scheduleCheck(*this, OTSYS_TIME() + getInterval()); }
 
 Spawn::~Spawn()
 {
@@ -257,15 +321,37 @@ Spawn::~Spawn()
 
 bool Spawn::findPlayer(const Position& pos)
 {
-	SpectatorVec spectators;
-	g_game.map.getSpectators(spectators, pos, false, true);
-	for (Creature* spectator : spectators) {
-		assert(dynamic_cast<Player*>(spectator) != nullptr);
-		if (!static_cast<Player*>(spectator)->hasFlag(PlayerFlag_IgnoredByMonsters)) {
-			return true;
-		}
+	// same area as a single floor getSpectators, read straight from the grid buckets
+	const SpectatorGrid& grid = g_game.map.getSpectatorGrid();
+	if (!grid.hasPlayers(pos.z)) {
+		return false;
 	}
-	return false;
+
+	const uint16_t x1 = static_cast<uint16_t>(std::max<int32_t>(0, pos.x - Map::maxViewportX));
+	const uint16_t y1 = static_cast<uint16_t>(std::max<int32_t>(0, pos.y - Map::maxViewportY));
+	const uint16_t x2 = static_cast<uint16_t>(std::min<int32_t>(0xFFFF, pos.x + Map::maxViewportX));
+	const uint16_t y2 = static_cast<uint16_t>(std::min<int32_t>(0xFFFF, pos.y + Map::maxViewportY));
+
+	bool found = false;
+	grid.forEachBucket(x1, y1, x2, y2, pos.z, true, [&](const CreatureVector& bucket) {
+		if (found) {
+			return;
+		}
+
+		for (Creature* creature : bucket) {
+			const Position& cpos = creature->getPosition();
+			if (cpos.x < x1 || cpos.x > x2 || cpos.y < y1 || cpos.y > y2) {
+				continue;
+			}
+
+			assert(dynamic_cast<Player*>(creature) != nullptr);
+			if (!static_cast<Player*>(creature)->hasFlag(PlayerFlag_IgnoredByMonsters)) {
+				found = true;
+				return;
+			}
+		}
+	});
+	return found;
 }
 
 bool Spawn::isInSpawnZone(const Position& pos) { return Spawns::isInZone(centerPos, radius, pos); }
@@ -320,8 +406,8 @@ bool Spawn::spawnMonster(uint32_t spawnId, MonsterType* mType, const Position& p
 	if (startup) {
 		// No need to send out events to the surrounding since there is no one out there to listen!
 		if (!g_game.internalPlaceCreature(monster_ptr.get(), pos, true)) {
-			std::cout << "[Warning - Spawns::startup] Couldn't spawn monster \"" << monster_ptr->getName()
-			          << "\" on position: " << pos << '.' << std::endl;
+			Logger::log(LOG_WARNING, "Spawns::startup", "Couldn't spawn monster \"{}\" on position: {}.",
+			            monster_ptr->getName(), pos);
 			return false;
 		}
 	} else {
@@ -341,22 +427,27 @@ bool Spawn::spawnMonster(uint32_t spawnId, MonsterType* mType, const Position& p
 	return true;
 }
 
-void Spawn::startup()
+size_t Spawn::startup()
 {
+	size_t placed = 0;
 	for (const auto& it : spawnMap) {
 		uint32_t spawnId = it.first;
 		const spawnBlock_t& sb = it.second;
-		spawnMonster(spawnId, sb, true);
+		if (spawnMonster(spawnId, sb, true)) {
+			++placed;
+		}
 	}
+	return placed;
 }
 
 void Spawn::checkSpawn()
 {
-	checkSpawnEvent = 0;
-
 	cleanup();
 
+	const int64_t now = OTSYS_TIME();
 	uint32_t spawnCount = 0;
+	// earliest time an empty block is due again
+	int64_t nextCheck = std::numeric_limits<int64_t>::max();
 
 	for (auto& it : spawnMap) {
 		uint32_t spawnId = it.first;
@@ -365,20 +456,27 @@ void Spawn::checkSpawn()
 		}
 
 		spawnBlock_t& sb = it.second;
-		if (OTSYS_TIME() >= sb.lastSpawn + sb.interval) {
-			if (!spawnMonster(spawnId, sb)) {
-				sb.lastSpawn = OTSYS_TIME();
-				continue;
-			}
+		if (now < sb.lastSpawn + sb.interval) {
+			nextCheck = std::min(nextCheck, sb.lastSpawn + sb.interval);
+			continue;
+		}
 
-			if (++spawnCount >= g_config[ConfigKeysInteger::RATE_SPAWN]) {
-				break;
-			}
+		// over the spawn rate for this pass
+		if (spawnCount != 0 && spawnCount >= static_cast<uint32_t>(g_config[ConfigKeysInteger::RATE_SPAWN])) {
+			nextCheck = std::min<int64_t>(nextCheck, now + getInterval());
+			continue;
 		}
+
+		if (!spawnMonster(spawnId, sb)) {
+			sb.lastSpawn = now;
+			nextCheck = std::min<int64_t>(nextCheck, now + sb.interval);
+			continue;
+		}
+		++spawnCount;
 	}
 
-	if (spawnedMap.size() < spawnMap.size()) {
-		checkSpawnEvent = g_scheduler.addEvent(createSchedulerTask(getInterval(), [this]() { checkSpawn(); }));
+	if (nextCheck != std::numeric_limits<int64_t>::max()) {
+		g_game.map.spawns.scheduleCheck(*this, nextCheck);
 	}
 }
 
@@ -416,7 +514,7 @@ bool Spawn::addMonster(const std::string& name, const Position& pos, Direction d
 {
 	MonsterType* mType = g_monsters.getMonsterType(name);
 	if (!mType) {
-		std::cout << "[Warning - Spawn::addMonster] Can not find " << name << std::endl;
+		Logger::log(LOG_WARNING, "Spawn::addMonster", "Can not find {}", name);
 		return false;
 	}
 
@@ -440,11 +538,3 @@ void Spawn::removeMonster(Monster* monster)
 		}
 	}
 }
-
-void Spawn::stopEvent()
-{
-	if (checkSpawnEvent != 0) {
-		g_scheduler.stopEvent(checkSpawnEvent);
-		checkSpawnEvent = 0;
-	}
-}
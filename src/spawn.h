@@ -38,10 +38,11 @@ public:
 	void removeMonster(Monster* monster);
 
 	uint32_t getInterval() const { return interval; }
-	void startup();
+	// the number of monsters placed
+	size_t startup();
 
 	void startSpawnCheck();
-	void stopEvent();
+	void stopEvent() { queuedCheck = 0; }
 
 	bool isInSpawnZone(const Position& pos);
 	void cleanup();
@@ -58,12 +59,15 @@ private:
 	int32_t radius;
 
 	uint32_t interval = 60000;
-	uint32_t checkSpawnEvent = 0;
+	// due time of the live entry in the respawn queue, 0 if none
+	int64_t queuedCheck = 0;
 
 	static bool findPlayer(const Position& pos);
 	bool spawnMonster(uint32_t spawnId, spawnBlock_t sb, bool startup = false);
 	bool spawnMonster(uint32_t spawnId, MonsterType* mType, const Position& pos, Direction dir, bool startup = false);
 	void checkSpawn();
+
+	friend class Spawns;
 };
 
 class Spawns
@@ -77,7 +81,25 @@ public:
 
 	bool isStarted() const { return started; }
 
+	// queues a check of spawn at due, unless one at or before it is already queued
+	void scheduleCheck(Spawn& spawn, int64_t due);
+
 private:
+	void scheduleEvent(int64_t due);
+	void checkSpawns();
+
+	struct SpawnCheck
+	{
+		int64_t due;
+		Spawn* spawn;
+
+		bool operator>(const SpawnCheck& other) const { return due > other.due; }
+	};
+	// one queue and scheduler event for every spawn, a spawn is only looked at once one of its blocks is due
+	std::priority_queue<SpawnCheck, std::vector<SpawnCheck>, std::greater<>> checkQueue;
+	uint32_t checkEvent = 0;
+	int64_t checkEventDue = 0;
+
 	std::forward_list<Npc*> npcList;
 	std::forward_list<Spawn> spawnList;
 	std::string filename;
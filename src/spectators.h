@@ -8,24 +8,63 @@ class Creature;
 
 class SpectatorVec
 {
-	using Vec = std::vector<Creature*>;
+	// a crowded screen rarely holds more than this, so most queries never touch the heap
+	static constexpr size_t INLINE_CAPACITY = 32;
+	// above this many comparisons a hashed lookup beats repeated linear scans
+	static constexpr size_t LINEAR_MERGE_LIMIT = 512;
+	static constexpr size_t INLINE_MERGE_TABLE = 1024;
+
+	using Vec = boost::container::small_vector<Creature*, INLINE_CAPACITY>;
 	using Iterator = Vec::iterator;
 	using ConstIterator = Vec::const_iterator;
 
 public:
-	SpectatorVec() { vec.reserve(32); }
-
-	void addSpectators(const SpectatorVec& spectators)
+	// appends every entry of spectators not already present, spectators itself must not hold duplicates
+	void addSpectators(std::span<Creature* const> spectators)
 	{
-		for (Creature* spectator : spectators.vec) {
-			auto it = std::find(vec.begin(), vec.end(), spectator);
-			if (it != end()) {
-				continue;
+		if (vec.empty()) {
+			vec.assign(spectators.begin(), spectators.end());
+			return;
+		}
+
+		if (vec.size() * spectators.size() <= LINEAR_MERGE_LIMIT) {
+			const size_t existing = vec.size();
+			for (Creature* spectator : spectators) {
+				if (std::find(vec.begin(), vec.begin() + existing, spectator) == vec.begin() + existing) {
+					vec.emplace_back(spectator);
+				}
+			}
+			return;
+		}
+
+		// open addressing set of everything already present, kept at most half full
+		const size_t capacity = std::bit_ceil((vec.size() + spectators.size()) * 2);
+		const int shift = 64 - std::countr_zero(capacity);
+		boost::container::small_vector<Creature*, INLINE_MERGE_TABLE> table(capacity, nullptr);
+
+		auto insert = [&table, shift, mask = capacity - 1](Creature* spectator) {
+			size_t i = (reinterpret_cast<uintptr_t>(spectator) * 0x9E3779B97F4A7C15ULL) >> shift;
+			for (; table[i]; i = (i + 1) & mask) {
+				if (table[i] == spectator) {
+					return false;
+				}
+			}
+			table[i] = spectator;
+			return true;
+		};
+
+		for (Creature* spectator : vec) {
+			insert(spectator);
+		}
+		for (Creature* spectator : spectators) {
+			if (insert(spectator)) {
+				vec.emplace_back(spectator);
 			}
-			vec.emplace_back(spectator);
 		}
 	}
 
+	void addSpectators(const SpectatorVec& spectators) { addSpectators(spectators.view()); }
+
 	void erase(Creature* spectator)
 	{
 		auto it = std::find(vec.begin(), vec.end(), spectator);
@@ -43,6 +82,9 @@ public:
 	Iterator end() { return vec.end(); }
 	ConstIterator end() const { return vec.end(); }
 	void emplace_back(Creature* c) { vec.emplace_back(c); }
+	void clear() { vec.clear(); }
+	void resize(size_t size) { vec.resize(size); }
+	std::span<Creature* const> view() const { return {vec.data(), vec.size()}; }
 
 private:
 	Vec vec;
@@ -78,18 +78,23 @@ TalkActionResult Spells::playerSaySpell(Player* player, std::string& words)
 	return TalkActionResult::FAILED;
 }
 
-void Spells::clearMaps(bool fromLua)
+void Spells::clearMaps(const EventFilter& filter)
 {
 	for (auto instant = instants.begin(); instant != instants.end();) {
-		if (fromLua == instant->second.fromLua) {
+		if (filter(instant->second)) {
 			instant = instants.erase(instant);
 		} else {
 			++instant;
 		}
 	}
 
+	instantWords.clear();
+	for (auto& [words, instant] : instants) {
+		instantWords.insert(words, &instant);
+	}
+
 	for (auto rune = runes.begin(); rune != runes.end();) {
-		if (fromLua == rune->second.fromLua) {
+		if (filter(rune->second)) {
 			rune = runes.erase(rune);
 		} else {
 			++rune;
@@ -97,13 +102,6 @@ void Spells::clearMaps(bool fromLua)
 	}
 }
 
-void Spells::clear(bool fromLua)
-{
-	clearMaps(fromLua);
-
-	reInitState(fromLua);
-}
-
 LuaScriptInterface& Spells::getScriptInterface() { return scriptInterface; }
 
 std::string_view Spells::getScriptBaseName() const { return "spells"; }
@@ -123,7 +121,9 @@ bool Spells::registerEvent(Event_ptr event, const pugi::xml_node&)
 	InstantSpell* instant = dynamic_cast<InstantSpell*>(event.get());
 	if (instant) {
 		auto result = instants.emplace(instant->getWords(), std::move(*instant));
-		if (!result.second) {
+		if (result.second) {
+			instantWords.insert(result.first->first, &result.first->second);
+		} else {
 			std::cout << "[Warning - Spells::registerEvent] Duplicate registered instant spell with words: "
 			          << instant->getWords() << std::endl;
 		}
@@ -149,7 +149,9 @@ bool Spells::registerInstantLuaEvent(InstantSpell* event)
 	if (instant) {
 		std::string words{instant->getWords()};
 		auto result = instants.emplace(words, std::move(*instant));
-		if (!result.second) {
+		if (result.second) {
+			instantWords.insert(words, &result.first->second);
+		} else {
 			std::cout << "[Warning - Spells::registerInstantLuaEvent] Duplicate registered instant spell with words: "
 			          << words << std::endl;
 		}
@@ -210,37 +212,24 @@ RuneSpell* Spells::getRuneSpellByName(std::string_view name)
 
 InstantSpell* Spells::getInstantSpell(std::string_view words)
 {
-	InstantSpell* result = nullptr;
-
-	for (auto& it : instants) {
-		auto instantSpellWords = it.second.getWords();
-		size_t spellLen = instantSpellWords.length();
-		if (caseInsensitiveStartsWith(words, instantSpellWords)) {
-			if (!result || spellLen > result->getWords().size()) {
-				result = &it.second;
-				if (words.length() == spellLen) {
-					break;
-				}
-			}
-		}
+	size_t spellLen;
+	const std::vector<InstantSpell*>* matches = instantWords.findLongestPrefix(words, spellLen);
+	if (!matches) {
+		return nullptr;
 	}
 
-	if (result) {
-		auto resultWords = result->getWords();
-		if (words.length() > resultWords.length()) {
-			if (!result->getHasParam()) {
-				return nullptr;
-			}
+	InstantSpell* result = matches->front();
+	if (words.length() > spellLen) {
+		if (!result->getHasParam()) {
+			return nullptr;
+		}
 
-			size_t spellLen = resultWords.length();
-			size_t paramLen = words.length() - spellLen;
-			if (paramLen < 2 || words[spellLen] != ' ') {
-				return nullptr;
-			}
+		size_t paramLen = words.length() - spellLen;
+		if (paramLen < 2 || words[spellLen] != ' ') {
+			return nullptr;
 		}
-		return result;
 	}
-	return nullptr;
+	return result;
 }
 
 InstantSpell* Spells::getInstantSpellByName(std::string_view name)
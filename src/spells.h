@@ -43,8 +43,7 @@ public:
 
 	const std::map<std::string, InstantSpell>& getInstantSpells() const { return instants; };
 
-	void clearMaps(bool fromLua);
-	void clear(bool fromLua) override final;
+	void clearMaps(const EventFilter& filter);
 	bool registerInstantLuaEvent(InstantSpell* event);
 	bool registerRuneLuaEvent(RuneSpell* event);
 
@@ -52,9 +51,12 @@ private:
 	LuaScriptInterface& getScriptInterface() override;
 	Event_ptr getEvent(std::string_view nodeName) override;
 	bool registerEvent(Event_ptr event, const pugi::xml_node& node) override;
+	void removeEvents(const EventFilter& filter) override final { clearMaps(filter); }
 
 	std::map<uint16_t, RuneSpell> runes;
 	std::map<std::string, InstantSpell> instants;
+	// case-folded index over instants
+	PrefixTree<InstantSpell*> instantWords;
 
 	friend class CombatSpell;
 	LuaScriptInterface scriptInterface{"Spell Interface"};
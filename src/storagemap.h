@@ -0,0 +1,113 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_STORAGEMAP_H
+#define FS_STORAGEMAP_H
+
+#include "flathashmap.h"
+
+/*
+ * Storage values by integral key with a dirty bit per key, so a save only writes the keys changed since the last one.
+ * An erased key stays behind as a dirty entry without a value until the changes are taken.
+ */
+template <typename Key, typename Value>
+class StorageMap
+{
+	struct Entry
+	{
+		Value value{};
+		bool present = false;
+		bool dirty = false;
+	};
+
+	// the flat map cannot hold its empty key, that one gets an entry of its own
+	static constexpr Key ReservedKey = std::numeric_limits<Key>::max();
+
+public:
+	size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+	const Value* find(Key key) const
+	{
+		const Entry* entry = getEntry(key);
+		return entry && entry->present ? &entry->value : nullptr;
+	}
+
+	void set(Key key, Value value)
+	{
+		Entry& entry = key == ReservedKey ? reservedEntry : entries[key];
+		if (entry.present) {
+			if (entry.value == value) {
+				return;
+			}
+		} else {
+			entry.present = true;
+			++count;
+		}
+
+		entry.value = value;
+		entry.dirty = true;
+	}
+
+	bool erase(Key key)
+	{
+		Entry* entry = getEntry(key);
+		if (!entry || !entry->present) {
+			return false;
+		}
+
+		entry->present = false;
+		entry->dirty = true;
+		--count;
+		return true;
+	}
+
+	template <typename F>
+	void forEach(F&& f) const
+	{
+		entries.forEach([&f](Key key, const Entry& entry) {
+			if (entry.present) {
+				f(key, entry.value);
+			}
+		});
+
+		if (reservedEntry.present) {
+			f(ReservedKey, reservedEntry.value);
+		}
+	}
+
+	// the keys set or erased since the last call, find tells which of the two they are
+	std::vector<Key> takeChanges()
+	{
+		std::vector<Key> changes;
+		entries.forEach([&changes](Key key, Entry& entry) {
+			if (entry.dirty) {
+				entry.dirty = false;
+				changes.push_back(key);
+			}
+		});
+
+		for (Key key : changes) {
+			if (!entries.find(key)->present) {
+				entries.erase(key);
+			}
+		}
+
+		if (reservedEntry.dirty) {
+			reservedEntry.dirty = false;
+			changes.push_back(ReservedKey);
+		}
+		return changes;
+	}
+
+private:
+	Entry* getEntry(Key key) { return key == ReservedKey ? &reservedEntry : entries.find(key); }
+	const Entry* getEntry(Key key) const { return key == ReservedKey ? &reservedEntry : entries.find(key); }
+
+	// most creatures never get a storage value
+	FlatHashMap<Key, Entry, ReservedKey> entries{8};
+	Entry reservedEntry;
+	size_t count = 0;
+};
+
+#endif // FS_STORAGEMAP_H
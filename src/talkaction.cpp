@@ -12,17 +12,20 @@ TalkActions::TalkActions() : scriptInterface("TalkAction Interface") { scriptInt
 
 TalkActions::~TalkActions() { clear(false); }
 
-void TalkActions::clear(bool fromLua)
+void TalkActions::removeEvents(const EventFilter& filter)
 {
 	for (auto it = talkActions.begin(); it != talkActions.end();) {
-		if (fromLua == it->second.fromLua) {
+		if (filter(it->second)) {
 			it = talkActions.erase(it);
 		} else {
 			++it;
 		}
 	}
 
-	reInitState(fromLua);
+	talkActionWords.clear();
+	for (const auto& [words, talkAction] : talkActions) {
+		talkActionWords.insert(words, &talkAction);
+	}
 }
 
 LuaScriptInterface& TalkActions::getScriptInterface() { return scriptInterface; }
@@ -41,7 +44,10 @@ bool TalkActions::registerEvent(Event_ptr event, const pugi::xml_node&)
 	const auto& words = talkAction->stealWordsMap();
 
 	for (const auto& word : words) {
-		talkActions.emplace(word, *talkAction);
+		auto result = talkActions.emplace(word, *talkAction);
+		if (result.second) {
+			talkActionWords.insert(word, &result.first->second);
+		}
 	}
 	return true;
 }
@@ -57,55 +63,57 @@ bool TalkActions::registerLuaEvent(TalkAction* event)
 	}
 
 	for (const auto& word : words) {
-		talkActions.emplace(word, *talkAction);
+		auto result = talkActions.emplace(word, *talkAction);
+		if (result.second) {
+			talkActionWords.insert(word, &result.first->second);
+		}
 	}
 	return true;
 }
 
 TalkActionResult TalkActions::playerSaySpell(Player* player, SpeakClasses type, std::string_view words) const
 {
-	size_t wordsLength = words.length();
-	for (auto it = talkActions.begin(); it != talkActions.end();) {
-		std::string_view talkactionWords = it->first;
-		if (!caseInsensitiveStartsWith(words, talkactionWords)) {
-			++it;
-			continue;
+	// candidates ending at a word boundary, the longest one that accepts its parameter wins
+	boost::container::small_vector<std::pair<size_t, const std::vector<const TalkAction*>*>, 4> candidates;
+	talkActionWords.forEachPrefix(words, [&](size_t length, const std::vector<const TalkAction*>& matches) {
+		if (length == words.size() || words[length] == ' ') {
+			candidates.emplace_back(length, &matches);
 		}
-
-		std::string param;
-		if (wordsLength != talkactionWords.size()) {
-			param = words.substr(talkactionWords.size());
-			if (param.front() != ' ') {
-				++it;
-				continue;
-			}
-			boost::algorithm::trim_left(param);
-
-			auto separator = it->second.getSeparator();
-			if (separator != " ") {
-				if (!param.empty()) {
-					if (param != separator) {
-						++it;
-						continue;
-					} else {
-						param.erase(param.begin());
+	});
+
+	for (auto it = candidates.rbegin(); it != candidates.rend(); ++it) {
+		const size_t length = it->first;
+		for (const TalkAction* talkAction : *it->second) {
+			std::string param;
+			if (length != words.size()) {
+				param = words.substr(length);
+				boost::algorithm::trim_left(param);
+
+				auto separator = talkAction->getSeparator();
+				if (separator != " ") {
+					if (!param.empty()) {
+						if (param != separator) {
+							continue;
+						} else {
+							param.erase(param.begin());
+						}
 					}
 				}
 			}
-		}
 
-		if (it->second.getNeedAccess() && !player->isAccessPlayer()) {
-			return TalkActionResult::CONTINUE;
-		}
+			if (talkAction->getNeedAccess() && !player->isAccessPlayer()) {
+				return TalkActionResult::CONTINUE;
+			}
 
-		if (player->getAccountType() < it->second.getRequiredAccountType()) {
-			return TalkActionResult::CONTINUE;
-		}
+			if (player->getAccountType() < talkAction->getRequiredAccountType()) {
+				return TalkActionResult::CONTINUE;
+			}
 
-		if (it->second.executeSay(player, words, param, type)) {
-			return TalkActionResult::CONTINUE;
-		} else {
-			return TalkActionResult::BREAK;
+			if (talkAction->executeSay(player, words, param, type)) {
+				return TalkActionResult::CONTINUE;
+			} else {
+				return TalkActionResult::BREAK;
+			}
 		}
 	}
 	return TalkActionResult::CONTINUE;
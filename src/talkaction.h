@@ -7,6 +7,7 @@
 #include "baseevents.h"
 #include "const.h"
 #include "luascript.h"
+#include "prefixtree.h"
 
 class TalkAction;
 using TalkAction_ptr = std::unique_ptr<TalkAction>;
@@ -74,7 +75,6 @@ public:
 	TalkActionResult playerSaySpell(Player* player, SpeakClasses type, std::string_view words) const;
 
 	bool registerLuaEvent(TalkAction* event);
-	void clear(bool fromLua) override final;
 
 	const auto& getTalkactions() const { return talkActions; }
 
@@ -83,8 +83,11 @@ private:
 	std::string_view getScriptBaseName() const override { return "talkactions"; }
 	Event_ptr getEvent(std::string_view nodeName) override;
 	bool registerEvent(Event_ptr event, const pugi::xml_node& node) override;
+	void removeEvents(const EventFilter& filter) override final;
 
 	std::map<std::string, TalkAction> talkActions;
+	// case-folded index over talkActions
+	PrefixTree<const TalkAction*> talkActionWords;
 
 	LuaScriptInterface scriptInterface;
 };
@@ -0,0 +1,88 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_TASKFUNC_H
+#define FS_TASKFUNC_H
+
+/*
+ * Move-only void() callable that always keeps the callable inline, so creating a task never allocates for it.
+ * A callable larger than the buffer does not compile, capture a pointer or a shared_ptr to the bulky state instead.
+ */
+class TaskFunc
+{
+	struct Operations
+	{
+		void (*invoke)(void* callable);
+		void (*move)(void* from, void* to);
+		void (*destroy)(void* callable);
+	};
+
+	template <typename F>
+	static constexpr Operations operationsFor = {
+	    [](void* callable) { (*static_cast<F*>(callable))(); },
+	    [](void* from, void* to) {
+		    new (to) F(std::move(*static_cast<F*>(from)));
+		    static_cast<F*>(from)->~F();
+	    },
+	    [](void* callable) { static_cast<F*>(callable)->~F(); },
+	};
+
+public:
+	static constexpr size_t BUFFER_SIZE = 64;
+
+	TaskFunc() = default;
+	TaskFunc(std::nullptr_t) {}
+
+	template <typename F, typename Callable = std::decay_t<F>>
+	requires(!std::is_same_v<Callable, TaskFunc> && std::is_invocable_v<Callable&>)
+	TaskFunc(F&& f)
+	{
+		static_assert(sizeof(Callable) <= BUFFER_SIZE, "the task captures too much to be stored inline");
+		static_assert(alignof(Callable) <= alignof(std::max_align_t), "the task captures over-aligned state");
+		new (buffer) Callable(std::forward<F>(f));
+		operations = &operationsFor<Callable>;
+	}
+
+	TaskFunc(TaskFunc&& other) noexcept { moveFrom(other); }
+
+	TaskFunc& operator=(TaskFunc&& other) noexcept
+	{
+		if (this != &other) {
+			reset();
+			moveFrom(other);
+		}
+		return *this;
+	}
+
+	// non-copyable
+	TaskFunc(const TaskFunc&) = delete;
+	TaskFunc& operator=(const TaskFunc&) = delete;
+
+	~TaskFunc() { reset(); }
+
+	explicit operator bool() const { return operations != nullptr; }
+
+	void operator()() { operations->invoke(buffer); }
+
+private:
+	void moveFrom(TaskFunc& other)
+	{
+		if (other.operations) {
+			other.operations->move(other.buffer, buffer);
+			operations = std::exchange(other.operations, nullptr);
+		}
+	}
+
+	void reset()
+	{
+		if (operations) {
+			operations->destroy(buffer);
+			operations = nullptr;
+		}
+	}
+
+	alignas(std::max_align_t) unsigned char buffer[BUFFER_SIZE];
+	const Operations* operations = nullptr;
+};
+
+#endif // FS_TASKFUNC_H
@@ -7,71 +7,335 @@
 
 #include "enums.h"
 #include "game.h"
+#include "tickprofiler.h"
+#include "lockfree.h"
+#include "metrics.h"
+#include "scheduler.h"
+#include "threadregistry.h"
+#include "tools.h"
 
 extern Game g_game;
 
+thread_local TaskOrigin currentTaskOrigin = makeTaskOrigin(TASK_ORIGIN_DISPATCHER);
+
+namespace {
+
+const size_t TASK_FREE_LIST_CAPACITY = 8192;
+const size_t TASK_STATS_LOG_ENTRIES = 15;
+
+uint64_t microsecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+size_t getHistogramBucket(uint64_t microseconds)
+{
+	if (microseconds == 0) {
+		return 0;
+	}
+	return std::min<size_t>(std::bit_width(microseconds) - 1, DispatcherTaskStats::HISTOGRAM_BUCKETS - 1);
+}
+
+} // namespace
+
+std::string getTaskOriginName(TaskOrigin origin)
+{
+	const uint8_t detail = getTaskOriginDetail(origin);
+	switch (getTaskOriginKind(origin)) {
+		case TASK_ORIGIN_DISPATCHER:
+			return "dispatcher";
+		case TASK_ORIGIN_PACKET:
+			return fmt::format("packet 0x{:02X}", detail);
+		case TASK_ORIGIN_SCHEDULER:
+			return fmt::format("scheduler {:s}", getSchedulerEventName(static_cast<SchedulerEventType>(detail)));
+		case TASK_ORIGIN_DATABASE:
+			return "database callback";
+		case TASK_ORIGIN_LUA_EVENT:
+			return "lua addEvent";
+		case TASK_ORIGIN_NETWORK:
+			return "network";
+		default:
+			return fmt::format("unknown {:d}:{:d}", origin >> 8, detail);
+	}
+}
+
+DispatcherLane getDispatcherLane(TaskOrigin origin)
+{
+	switch (getTaskOriginKind(origin)) {
+		case TASK_ORIGIN_PACKET:
+		case TASK_ORIGIN_NETWORK:
+			return DISPATCHER_LANE_INTERACTIVE;
+		case TASK_ORIGIN_DATABASE:
+			return DISPATCHER_LANE_BACKGROUND;
+		case TASK_ORIGIN_SCHEDULER:
+			if (getTaskOriginDetail(origin) == SCHEDULER_EVENT_SERVER) {
+				return DISPATCHER_LANE_BACKGROUND;
+			}
+			return DISPATCHER_LANE_TICK;
+		default:
+			return DISPATCHER_LANE_TICK;
+	}
+}
+
+const char* getDispatcherLaneName(DispatcherLane lane)
+{
+	switch (lane) {
+		case DISPATCHER_LANE_INTERACTIVE:
+			return "interactive";
+		case DISPATCHER_LANE_TICK:
+			return "tick";
+		case DISPATCHER_LANE_BACKGROUND:
+			return "background";
+		default:
+			return "unknown";
+	}
+}
+
+void DispatcherTaskStats::record(uint64_t executionTime, uint64_t waitTime)
+{
+	++count;
+	totalExecutionTime += executionTime;
+	maxExecutionTime = std::max(maxExecutionTime, executionTime);
+	totalWaitTime += waitTime;
+	++executionHistogram[getHistogramBucket(executionTime)];
+	++waitHistogram[getHistogramBucket(waitTime)];
+}
+
+uint64_t DispatcherTaskStats::getPercentile(const Histogram& histogram, double percentile) const
+{
+	const uint64_t target = static_cast<uint64_t>(std::ceil(count * percentile));
+	uint64_t seen = 0;
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		seen += histogram[i];
+		if (seen >= target) {
+			return uint64_t{1} << (i + 1);
+		}
+	}
+	return uint64_t{1} << HISTOGRAM_BUCKETS;
+}
+
+void* Task::operator new(size_t size)
+{
+	if (size != sizeof(Task)) {
+		return ::operator new(size);
+	}
+	return lockfreeAllocate<sizeof(Task), TASK_FREE_LIST_CAPACITY>();
+}
+
+void Task::operator delete(void* p, size_t size)
+{
+	if (size != sizeof(Task)) {
+		::operator delete(p);
+		return;
+	}
+	lockfreeDeallocate<sizeof(Task), TASK_FREE_LIST_CAPACITY>(p);
+}
+
 Task* createTask(TaskFunc&& f) { return new Task(std::move(f)); }
 
 Task* createTask(uint32_t expiration, TaskFunc&& f) { return new Task(expiration, std::move(f)); }
 
 void Dispatcher::threadMain()
 {
-	std::vector<Task*> tmpTaskList;
+	ThreadRegistration registration{THREAD_ROLE_DISPATCHER};
+
 	// NOTE: second argument defer_lock is to prevent from immediate locking
 	std::unique_lock<std::mutex> taskLockUnique(taskLock, std::defer_lock);
 
+	Task* task;
 	while (getState() != THREAD_STATE_TERMINATED) {
-		// check if there are tasks waiting
-		taskLockUnique.lock();
-		if (taskList.empty()) {
-			// if the list is empty wait for signal
-			taskSignal.wait(taskLockUnique);
+		if (!(task = popTask())) {
+			flush();
+			if (hasTasks()) {
+				continue;
+			}
+
+			// publish that we are about to sleep before checking the queue one last time, a producer either sees
+			// the flag and wakes us up or its task is already visible to the check below
+			taskLockUnique.lock();
+			sleeping.store(true);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!hasTasks()) {
+				taskSignal.wait(taskLockUnique, [this]() { return !sleeping.load(); });
+			}
+			sleeping.store(false);
+			taskLockUnique.unlock();
+			continue;
 		}
-		tmpTaskList.swap(taskList);
-		taskLockUnique.unlock();
-
-		for (Task* task : tmpTaskList) {
-			if (!task->hasExpired()) {
-				++dispatcherCycle;
-				// execute it
-				(*task)();
+
+		auto now = runTask(task);
+
+		// a queue that never runs empty must not hold back output forever
+		if (now - lastFlush >= DISPATCHER_MAX_FLUSH_DELAY) {
+			// busy higher lanes still leave the background lane one task per flush
+			if (backgroundTime == std::chrono::steady_clock::duration::zero() &&
+			    taskLists[DISPATCHER_LANE_BACKGROUND].pop(task)) {
+				runTask(task);
 			}
+			flush();
+		}
+	}
+
+	// release whatever was queued after the shutdown task
+	for (TaskQueue& taskList : taskLists) {
+		while (taskList.pop(task)) {
+			metrics::dispatcherQueueDepth.sub();
 			delete task;
 		}
-		tmpTaskList.clear();
 	}
 }
 
-void Dispatcher::addTask(Task* task)
+bool Dispatcher::hasTasks() const
 {
-	bool do_signal = false;
+	return std::any_of(std::begin(taskLists), std::end(taskLists),
+	                   [](const TaskQueue& taskList) { return !taskList.empty(); });
+}
 
-	taskLock.lock();
+Task* Dispatcher::popTask()
+{
+	Task* task;
+	if (taskLists[DISPATCHER_LANE_INTERACTIVE].pop(task) || taskLists[DISPATCHER_LANE_TICK].pop(task)) {
+		return task;
+	}
 
-	if (getState() == THREAD_STATE_RUNNING) {
-		do_signal = taskList.empty();
-		taskList.push_back(task);
-	} else {
-		delete task;
+	// past its budget the background lane waits for the next flush, which starts a new budget
+	if (backgroundTime < DISPATCHER_BACKGROUND_BUDGET && taskLists[DISPATCHER_LANE_BACKGROUND].pop(task)) {
+		return task;
 	}
+	return nullptr;
+}
 
-	taskLock.unlock();
+std::chrono::steady_clock::time_point Dispatcher::runTask(Task* task)
+{
+	metrics::dispatcherQueueDepth.sub();
 
-	// send a signal if the list was empty
-	if (do_signal) {
-		taskSignal.notify_one();
+	// the one clock read per task, OTSYS_TIME on this thread returns it until the next task
+	auto now = std::chrono::steady_clock::now();
+	setCachedTime(now);
+	if (!task->hasExpired(now)) {
+		now = executeTask(task, now);
 	}
+	delete task;
+	return now;
 }
 
-void Dispatcher::shutdown()
+void Dispatcher::flush()
 {
-	Task* task = createTask([this]() {
-		setState(THREAD_STATE_TERMINATED);
-		taskSignal.notify_one();
+	lastFlush = std::chrono::steady_clock::now();
+	backgroundTime = {};
+	setCachedTime(lastFlush);
+	if (flushHandler) {
+		flushHandler();
+		g_tickProfiler.addPhaseTime(TICK_PHASE_NETWORK,
+		                            microsecondsBetween(lastFlush, std::chrono::steady_clock::now()));
+	}
+}
+
+std::chrono::steady_clock::time_point Dispatcher::executeTask(Task* task,
+                                                              std::chrono::steady_clock::time_point start)
+{
+	++dispatcherCycle;
+
+	{
+		TaskOriginScope originScope{task->origin};
+		// execute it
+		(*task)();
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const uint64_t executionTime = microsecondsBetween(start, end);
+	const uint64_t waitTime = microsecondsBetween(task->enqueueTime, start);
+	taskStats[task->origin].record(executionTime, waitTime);
+	laneStats[task->lane].record(executionTime, waitTime);
+	metrics::dispatcherWaitTime(task->lane).observe(waitTime);
+	if (task->lane == DISPATCHER_LANE_BACKGROUND) {
+		backgroundTime += end - start;
+	}
+	g_tickProfiler.addTaskTime(task->origin, executionTime);
+	metrics::dispatcherTaskTime.observe(executionTime);
+	if (getTaskOriginKind(task->origin) == TASK_ORIGIN_PACKET) {
+		const uint8_t opcode = getTaskOriginDetail(task->origin);
+		metrics::packetExecutionTime(opcode).add(executionTime);
+		metrics::packetWaitTime(opcode).add(waitTime);
+	}
+	return end;
+}
+
+void Dispatcher::logTaskStats()
+{
+	std::vector<std::pair<TaskOrigin, const DispatcherTaskStats*>> entries;
+	entries.reserve(taskStats.size());
+	taskStats.forEach([&](TaskOrigin origin, const DispatcherTaskStats& stats) { entries.emplace_back(origin, &stats); });
+
+	std::sort(entries.begin(), entries.end(), [](const auto& lhs, const auto& rhs) {
+		return lhs.second->totalExecutionTime > rhs.second->totalExecutionTime;
 	});
 
-	std::lock_guard<std::mutex> lockClass(taskLock);
-	taskList.push_back(task);
+	uint64_t totalTasks = 0, totalTime = 0;
+	for (const auto& entry : entries) {
+		totalTasks += entry.second->count;
+		totalTime += entry.second->totalExecutionTime;
+	}
+
+	std::cout << fmt::format("> Dispatcher: {:d} tasks in {:d} ms across {:d} origins", totalTasks, totalTime / 1000,
+	                         entries.size())
+	          << std::endl;
+
+	for (size_t lane = 0; lane < DISPATCHER_LANE_COUNT; ++lane) {
+		const DispatcherTaskStats& stats = laneStats[lane];
+		if (stats.count == 0) {
+			continue;
+		}
+
+		std::cout << fmt::format("  lane {:<23s} count {:>8d} | total {:>7d} ms | wait avg {:>6d} us, p99 {:>7d} us",
+		                         getDispatcherLaneName(static_cast<DispatcherLane>(lane)), stats.count,
+		                         stats.totalExecutionTime / 1000, stats.totalWaitTime / stats.count,
+		                         stats.getWaitPercentile(0.99))
+		          << std::endl;
+	}
+
+	for (size_t i = 0, size = std::min(entries.size(), TASK_STATS_LOG_ENTRIES); i < size; ++i) {
+		const DispatcherTaskStats& stats = *entries[i].second;
+		std::cout << fmt::format("  {:<28s} count {:>8d} | total {:>7d} ms | avg {:>6d} us | p99 {:>7d} us | max "
+		                         "{:>7d} us | wait avg {:>6d} us, p99 {:>7d} us",
+		                         getTaskOriginName(entries[i].first), stats.count, stats.totalExecutionTime / 1000,
+		                         stats.totalExecutionTime / stats.count, stats.getExecutionPercentile(0.99),
+		                         stats.maxExecutionTime, stats.totalWaitTime / stats.count,
+		                         stats.getWaitPercentile(0.99))
+		          << std::endl;
+	}
+
+	resetTaskStats();
+}
+
+void Dispatcher::pushTask(Task* task, DispatcherLane lane)
+{
+	task->lane = lane;
+	task->enqueueTime = std::chrono::steady_clock::now();
+	taskLists[lane].push(task);
+	metrics::dispatcherQueueDepth.add();
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	// send a signal if the dispatcher is waiting for tasks
+	if (sleeping.load()) {
+		std::lock_guard<std::mutex> lockClass(taskLock);
+		sleeping.store(false);
+		taskSignal.notify_one();
+	}
+}
+
+void Dispatcher::addTask(Task* task)
+{
+	if (getState() != THREAD_STATE_RUNNING) {
+		delete task;
+		return;
+	}
+
+	pushTask(task, getDispatcherLane(task->origin));
+}
 
-	taskSignal.notify_one();
+void Dispatcher::shutdown()
+{
+	// queued last, the tasks of the other lanes run before it
+	pushTask(createTask([this]() { setState(THREAD_STATE_TERMINATED); }), DISPATCHER_LANE_BACKGROUND);
 }
@@ -4,11 +4,71 @@
 #ifndef FS_TASKS_H
 #define FS_TASKS_H
 
+#include "flathashmap.h"
+#include "taskfunc.h"
 #include "thread_holder_base.h"
 
-using TaskFunc = std::function<void(void)>;
 const int DISPATCHER_TASK_EXPIRATION = 2000;
-const auto SYSTEM_TIME_ZERO = std::chrono::system_clock::time_point(std::chrono::milliseconds(0));
+const size_t DISPATCHER_TASK_QUEUE_RESERVE = 4096;
+// longest a busy dispatcher runs tasks without calling the flush handler
+const std::chrono::milliseconds DISPATCHER_MAX_FLUSH_DELAY{10};
+// background tasks run for at most this long before the output of the others is flushed
+const std::chrono::milliseconds DISPATCHER_BACKGROUND_BUDGET{2};
+const auto TASK_NO_EXPIRATION = std::chrono::steady_clock::time_point{};
+
+enum TaskOriginKind : uint8_t
+{
+	TASK_ORIGIN_DISPATCHER, // plain dispatcher task without a more specific origin
+	TASK_ORIGIN_PACKET,     // detail: client packet opcode
+	TASK_ORIGIN_SCHEDULER,  // detail: SchedulerEventType
+	TASK_ORIGIN_DATABASE,   // DatabaseTasks result callback
+	TASK_ORIGIN_LUA_EVENT,  // Lua addEvent timer
+	TASK_ORIGIN_NETWORK,    // connection accept/release
+};
+
+// origin tag of a task, kind in the high byte and a kind specific detail in the low byte
+using TaskOrigin = uint16_t;
+
+constexpr TaskOrigin makeTaskOrigin(TaskOriginKind kind, uint8_t detail = 0)
+{
+	return static_cast<TaskOrigin>(kind << 8 | detail);
+}
+
+constexpr TaskOriginKind getTaskOriginKind(TaskOrigin origin) { return static_cast<TaskOriginKind>(origin >> 8); }
+constexpr uint8_t getTaskOriginDetail(TaskOrigin origin) { return static_cast<uint8_t>(origin & 0xFF); }
+
+std::string getTaskOriginName(TaskOrigin origin);
+
+// the dispatcher runs the tasks of a lane only while the lanes above it are empty
+enum DispatcherLane : uint8_t
+{
+	DISPATCHER_LANE_INTERACTIVE, // client packets and connections
+	DISPATCHER_LANE_TICK,        // scheduler events, lua timers and everything without a background origin
+	DISPATCHER_LANE_BACKGROUND,  // database callbacks and server maintenance
+
+	DISPATCHER_LANE_COUNT
+};
+
+DispatcherLane getDispatcherLane(TaskOrigin origin);
+const char* getDispatcherLaneName(DispatcherLane lane);
+
+// origin given to tasks created on this thread, the dispatcher sets it to the origin of the task being executed so
+// follow-up tasks are attributed to what caused them
+extern thread_local TaskOrigin currentTaskOrigin;
+
+class TaskOriginScope
+{
+public:
+	explicit TaskOriginScope(TaskOrigin origin) : previous(std::exchange(currentTaskOrigin, origin)) {}
+	~TaskOriginScope() { currentTaskOrigin = previous; }
+
+	// non-copyable
+	TaskOriginScope(const TaskOriginScope&) = delete;
+	TaskOriginScope& operator=(const TaskOriginScope&) = delete;
+
+private:
+	TaskOrigin previous;
+};
 
 class Task
 {
@@ -16,31 +76,68 @@ public:
 	// DO NOT allocate this class on the stack
 	explicit Task(TaskFunc&& f) : func(std::move(f)) {}
 	Task(uint32_t ms, TaskFunc&& f) :
-	    expiration(std::chrono::system_clock::now() + std::chrono::milliseconds(ms)), func(std::move(f))
+	    expiration(std::chrono::steady_clock::now() + std::chrono::milliseconds(ms)), func(std::move(f))
 	{}
+	Task(TaskOrigin origin, TaskFunc&& f) : func(std::move(f)), origin(origin) {}
 
 	virtual ~Task() = default;
 	void operator()() { func(); }
 
-	void setDontExpire() { expiration = SYSTEM_TIME_ZERO; }
+	// tasks are recycled through a lock-free free list, see lockfree.h
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
 
-	bool hasExpired() const
+	void setDontExpire() { expiration = TASK_NO_EXPIRATION; }
+
+	bool hasExpired(std::chrono::steady_clock::time_point now) const
 	{
-		if (expiration == SYSTEM_TIME_ZERO) {
-			return false;
-		}
-		return expiration < std::chrono::system_clock::now();
+		return expiration != TASK_NO_EXPIRATION && expiration < now;
 	}
 
+	TaskOrigin getOrigin() const { return origin; }
+	void setOrigin(TaskOrigin newOrigin) { origin = newOrigin; }
+
 protected:
-	std::chrono::system_clock::time_point expiration = SYSTEM_TIME_ZERO;
+	std::chrono::steady_clock::time_point expiration = TASK_NO_EXPIRATION;
 
 private:
 	// Expiration has another meaning for scheduler tasks, then it is the time the task should be added to the
 	// dispatcher
 	TaskFunc func;
+
+	TaskOrigin origin = currentTaskOrigin;
+	DispatcherLane lane = DISPATCHER_LANE_TICK;
+	std::chrono::steady_clock::time_point enqueueTime;
+
+	friend class Dispatcher;
+};
+
+struct DispatcherTaskStats
+{
+	// bucket N counts samples in [2^N, 2^(N+1)) microseconds, the first one also holds everything below
+	static constexpr size_t HISTOGRAM_BUCKETS = 32;
+	using Histogram = std::array<uint32_t, HISTOGRAM_BUCKETS>;
+
+	void record(uint64_t executionTime, uint64_t waitTime);
+
+	// upper bound of the bucket holding the given percentile, in microseconds
+	uint64_t getExecutionPercentile(double percentile) const { return getPercentile(executionHistogram, percentile); }
+	uint64_t getWaitPercentile(double percentile) const { return getPercentile(waitHistogram, percentile); }
+
+	uint64_t count = 0;
+	uint64_t totalExecutionTime = 0;
+	uint64_t maxExecutionTime = 0;
+	uint64_t totalWaitTime = 0;
+
+private:
+	uint64_t getPercentile(const Histogram& histogram, double percentile) const;
+
+	Histogram executionHistogram = {};
+	Histogram waitHistogram = {};
 };
 
+using DispatcherStatsMap = FlatHashMap<TaskOrigin, DispatcherTaskStats, std::numeric_limits<TaskOrigin>::max()>;
+
 Task* createTask(TaskFunc&& f);
 Task* createTask(uint32_t expiration, TaskFunc&& f);
 
@@ -57,14 +154,49 @@ public:
 
 	uint64_t getDispatcherCycle() const { return dispatcherCycle; }
 
+	// runs on the dispatcher thread whenever the queue runs empty, must be set before start
+	void setFlushHandler(std::function<void()> handler) { flushHandler = std::move(handler); }
+
+	// dispatcher thread only
+	const DispatcherStatsMap& getTaskStats() const { return taskStats; }
+	const DispatcherTaskStats& getLaneStats(DispatcherLane lane) const { return laneStats[lane]; }
+	void resetTaskStats()
+	{
+		taskStats.clear();
+		laneStats = {};
+	}
+	void logTaskStats();
+
 	void threadMain();
 
 private:
+	void pushTask(Task* task, DispatcherLane lane);
+	bool hasTasks() const;
+	Task* popTask();
+	// returns the time the task finished or was dropped
+	std::chrono::steady_clock::time_point runTask(Task* task);
+	std::chrono::steady_clock::time_point executeTask(Task* task, std::chrono::steady_clock::time_point start);
+	void flush();
+
+	// taskLock and taskSignal are only used to park the dispatcher thread while the queue is empty, producers never
+	// take the lock unless the dispatcher is sleeping
 	std::mutex taskLock;
 	std::condition_variable taskSignal;
+	std::atomic<bool> sleeping{false};
 
-	std::vector<Task*> taskList;
+	using TaskQueue = boost::lockfree::queue<Task*>;
+	TaskQueue taskLists[DISPATCHER_LANE_COUNT]{TaskQueue{DISPATCHER_TASK_QUEUE_RESERVE},
+	                                           TaskQueue{DISPATCHER_TASK_QUEUE_RESERVE},
+	                                           TaskQueue{DISPATCHER_TASK_QUEUE_RESERVE}};
 	uint64_t dispatcherCycle = 0;
+
+	std::function<void()> flushHandler;
+	std::chrono::steady_clock::time_point lastFlush;
+	// background time spent since the last flush
+	std::chrono::steady_clock::duration backgroundTime{};
+
+	DispatcherStatsMap taskStats{64};
+	std::array<DispatcherTaskStats, DISPATCHER_LANE_COUNT> laneStats;
 };
 
 extern Dispatcher g_dispatcher;
@@ -0,0 +1,81 @@
+#define BOOST_TEST_MODULE adler32
+
+#include "../otpch.h"
+
+#include "../adler32.h"
+#include "../const.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+// the byte at a time loop the vectorized versions replace
+uint32_t referenceChecksum(const uint8_t* data, size_t length)
+{
+	uint32_t a = 1, b = 0;
+	for (size_t i = 0; i < length; ++i) {
+		a = (a + data[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+	return (b << 16) | a;
+}
+
+constexpr adler32::backend backends[] = {adler32::backend::scalar, adler32::backend::ssse3,
+                                         adler32::backend::avx2, adler32::backend::neon};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_adler32_known_value)
+{
+	const std::string_view text = "Wikipedia";
+	for (adler32::backend b : backends) {
+		if (adler32::is_supported(b)) {
+			BOOST_TEST(adler32::checksum(b, reinterpret_cast<const uint8_t*>(text.data()), text.size()) ==
+			           0x11E60398u);
+			BOOST_TEST(adler32::checksum(b, nullptr, 0) == 1u);
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_adler32_matches_reference)
+{
+	std::mt19937 generator{42};
+	std::vector<uint8_t> data(NETWORKMESSAGE_MAXSIZE + 64);
+	for (uint8_t& byte : data) {
+		byte = static_cast<uint8_t>(generator());
+	}
+
+	// every tail length, the block boundary and the largest packet, also from unaligned starts
+	std::vector<size_t> lengths;
+	for (size_t length = 0; length <= 129; ++length) {
+		lengths.push_back(length);
+	}
+	lengths.insert(lengths.end(), {5551, 5552, 5553, 11104, NETWORKMESSAGE_MAXSIZE});
+
+	for (adler32::backend b : backends) {
+		if (!adler32::is_supported(b)) {
+			continue;
+		}
+
+		for (size_t offset : {0, 1, 7}) {
+			for (size_t length : lengths) {
+				BOOST_TEST(adler32::checksum(b, data.data() + offset, length) ==
+				               referenceChecksum(data.data() + offset, length),
+				           "backend " << static_cast<int>(b) << " length " << length << " offset " << offset);
+			}
+		}
+	}
+}
+
+BOOST_AUTO_TEST_CASE(test_adler32_largest_sums)
+{
+	// all bytes at 255 push the sums closest to overflowing before each reduction
+	const std::vector<uint8_t> data(NETWORKMESSAGE_MAXSIZE, 0xFF);
+	for (adler32::backend b : backends) {
+		if (adler32::is_supported(b)) {
+			BOOST_TEST(adler32::checksum(b, data.data(), data.size()) ==
+			           referenceChecksum(data.data(), data.size()));
+		}
+	}
+	BOOST_TEST(adler32::checksum(data.data(), data.size()) == referenceChecksum(data.data(), data.size()));
+}
@@ -0,0 +1,110 @@
+#define BOOST_TEST_MODULE fileloader
+
+#include "../otpch.h"
+
+#include "../fileloader.h"
+
+#include <boost/test/unit_test.hpp>
+#include <fstream>
+
+namespace {
+
+constexpr char START = static_cast<char>(OTB::Node::START);
+constexpr char END = static_cast<char>(OTB::Node::END);
+constexpr char ESCAPE = static_cast<char>(OTB::Node::ESCAPE);
+
+std::string writeFile(const std::string& contents)
+{
+	auto path = (std::filesystem::temp_directory_path() / "test_fileloader.otb").string();
+	std::ofstream file{path, std::ios::binary};
+	file.write("OTBM", 4);
+	file.write(contents.data(), contents.size());
+	return path;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_fileloader_walks_children_in_order)
+{
+	// root(1) { a(2) { b(3) } c(4) { d(5) e(6) } f(7) }
+	std::string tree{START, 1, 'r', START, 2, 'a', START, 3, 'b', END, END,
+	                 START, 4, START, 5, END, START, 6, 'e', END, END, START, 7, END, END};
+	OTB::Loader loader{writeFile(tree), OTB::Identifier{{'O', 'T', 'B', 'M'}}};
+	auto& root = loader.parseTree();
+
+	BOOST_TEST(root.type == 1);
+	BOOST_TEST(root.children().size() == 3u);
+
+	std::vector<uint8_t> types;
+	for (auto& child : root.children()) {
+		types.push_back(child.type);
+		for (auto& grandChild : child.children()) {
+			types.push_back(grandChild.type);
+		}
+	}
+	BOOST_TEST(types == (std::vector<uint8_t>{2, 3, 4, 5, 6, 7}));
+
+	PropStream props;
+	BOOST_TEST(loader.getProps(root, props));
+	char value;
+	BOOST_TEST(props.read(value));
+	BOOST_TEST(value == 'r');
+
+	// d(5) has no props
+	auto it = root.children().begin();
+	++it;
+	BOOST_TEST(it->type == 4);
+	BOOST_TEST(!loader.getProps(it->children().front(), props));
+}
+
+BOOST_AUTO_TEST_CASE(test_fileloader_unescapes_props)
+{
+	std::string tree{START, 1, 'x', ESCAPE, START, ESCAPE, ESCAPE, 'y', END};
+	OTB::Loader loader{writeFile(tree), OTB::Identifier{{'O', 'T', 'B', 'M'}}};
+	auto& root = loader.parseTree();
+
+	BOOST_TEST(root.children().empty());
+
+	PropStream props;
+	BOOST_TEST_REQUIRE(loader.getProps(root, props));
+	BOOST_TEST(props.size() == 4u);
+
+	std::string bytes(4, '\0');
+	for (auto& byte : bytes) {
+		BOOST_TEST_REQUIRE(props.read(byte));
+	}
+	BOOST_TEST(bytes == (std::string{'x', START, ESCAPE, 'y'}));
+}
+
+BOOST_AUTO_TEST_CASE(test_fileloader_index_round_trip)
+{
+	std::string tree{START, 1, 'r', START, 2, ESCAPE, END, 'a', END, START, 3, END, END};
+	auto fileName = writeFile(tree);
+	auto indexName = fileName + ".index";
+	constexpr OTB::Identifier identifier{{'O', 'T', 'B', 'M'}};
+
+	{
+		OTB::Loader loader{fileName, identifier};
+		loader.parseTree();
+		BOOST_TEST_REQUIRE(loader.writeIndex(indexName, fileName));
+	}
+
+	auto loader = OTB::Loader::openIndex(indexName, fileName, identifier);
+	BOOST_TEST_REQUIRE(loader);
+
+	auto& root = loader->parseTree();
+	BOOST_TEST(root.children().size() == 2u);
+
+	PropStream props;
+	BOOST_TEST_REQUIRE(loader->getProps(root.children().front(), props));
+	BOOST_TEST(props.size() == 2u);
+
+	char value;
+	BOOST_TEST(props.read(value));
+	BOOST_TEST(value == END);
+
+	// a changed source invalidates the index
+	std::string changed{START, 1, 'x', END};
+	writeFile(changed);
+	BOOST_TEST(!OTB::Loader::openIndex(indexName, fileName, identifier));
+}
@@ -0,0 +1,41 @@
+#define BOOST_TEST_MODULE flathashmap
+
+#include "../otpch.h"
+
+#include "../flathashmap.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_flathashmap_insert_find)
+{
+	FlatHashMap<uint32_t, uint32_t> map;
+	for (uint32_t i = 1; i <= 1000; ++i) {
+		map[i] = i * 2;
+	}
+
+	BOOST_TEST(map.size() == 1000);
+	for (uint32_t i = 1; i <= 1000; ++i) {
+		const uint32_t* value = map.find(i);
+		BOOST_TEST_REQUIRE(value);
+		BOOST_TEST(*value == i * 2);
+	}
+	BOOST_TEST(!map.find(1001));
+}
+
+BOOST_AUTO_TEST_CASE(test_flathashmap_erase)
+{
+	FlatHashMap<uint64_t, int> map{8};
+	for (uint64_t i = 1; i <= 500; ++i) {
+		map[i << 32 | i] = static_cast<int>(i);
+	}
+
+	for (uint64_t i = 1; i <= 500; i += 2) {
+		BOOST_TEST(map.erase(i << 32 | i));
+	}
+	BOOST_TEST(!map.erase(1ULL << 32 | 1));
+
+	BOOST_TEST(map.size() == 250);
+	for (uint64_t i = 1; i <= 500; ++i) {
+		BOOST_TEST(map.contains(i << 32 | i) == (i % 2 == 0));
+	}
+}
@@ -0,0 +1,47 @@
+#define BOOST_TEST_MODULE idmap
+
+#include "../otpch.h"
+
+#include "../idmap.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_idmap_emplace_find)
+{
+	IdMap<int> map;
+	BOOST_TEST(map.emplace(100, 1).second);
+	BOOST_TEST(map.emplace(7, 2).second);
+	BOOST_TEST(!map.emplace(100, 3).second);
+
+	BOOST_TEST_REQUIRE(map.find(100));
+	BOOST_TEST(*map.find(100) == 1);
+	BOOST_TEST(*map.find(7) == 2);
+	BOOST_TEST(!map.find(8));
+	BOOST_TEST(!map.find(65535));
+	BOOST_TEST(map.size() == 2u);
+
+	map[65535] = 4;
+	BOOST_TEST(*map.find(65535) == 4);
+}
+
+BOOST_AUTO_TEST_CASE(test_idmap_erase_keeps_other_values)
+{
+	IdMap<int> map;
+	for (uint16_t id = 1; id <= 100; ++id) {
+		map.emplace(id, id);
+	}
+
+	const int* kept = map.find(51);
+	map.eraseIf([](int value) { return value % 2 == 0; });
+	BOOST_TEST(map.size() == 50u);
+	BOOST_TEST(!map.find(50));
+	BOOST_TEST(map.find(51) == kept);
+
+	// freed slots are reused
+	BOOST_TEST(map.emplace(50, -50).second);
+	BOOST_TEST(*map.find(50) == -50);
+
+	int sum = 0;
+	map.forEach([&](uint16_t id, int value) { sum += value == id ? 1 : 0; });
+	BOOST_TEST(sum == 50);
+}
@@ -0,0 +1,52 @@
+#define BOOST_TEST_MODULE jobsystem
+
+#include "../otpch.h"
+
+#include "../jobsystem.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_jobsystem_parallel_for)
+{
+	JobSystem jobs;
+	jobs.start(4);
+
+	std::vector<std::atomic<int>> runs(1000);
+	jobs.parallelFor(runs.size(), [&runs](size_t i) { ++runs[i]; });
+	BOOST_TEST(std::all_of(runs.begin(), runs.end(), [](const std::atomic<int>& count) { return count == 1; }));
+
+	// without workers the calling thread runs every index
+	JobSystem disabled;
+	std::vector<size_t> order;
+	disabled.parallelFor(3, [&order](size_t i) { order.push_back(i); });
+	BOOST_TEST(order == (std::vector<size_t>{0, 1, 2}));
+
+	jobs.shutdown();
+	jobs.join();
+}
+
+BOOST_AUTO_TEST_CASE(test_jobsystem_nested_jobs)
+{
+	JobSystem jobs;
+	jobs.start(4);
+
+	// jobs added from a worker go to its own queue, the idle workers steal them
+	constexpr int JOBS = 64;
+	std::atomic<int> done{0};
+	std::promise<void> finished;
+	BOOST_TEST(jobs.addJob([&]() {
+		for (int i = 0; i < JOBS; ++i) {
+			jobs.addJob([&]() {
+				if (++done == JOBS) {
+					finished.set_value();
+				}
+			});
+		}
+	}));
+	finished.get_future().wait();
+	BOOST_TEST(done == JOBS);
+
+	jobs.shutdown();
+	BOOST_TEST(!jobs.addJob([]() {}));
+	jobs.join();
+}
@@ -0,0 +1,69 @@
+#define BOOST_TEST_MODULE luaallocator
+
+#include "../otpch.h"
+
+#include "../luaallocator.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_luaallocator_reuses_freed_blocks)
+{
+	LuaAllocator allocator;
+	void* first = LuaAllocator::allocate(&allocator, nullptr, 0, 24);
+	BOOST_TEST_REQUIRE(first);
+	BOOST_TEST(allocator.getStats().liveBytes == 24u);
+
+	LuaAllocator::allocate(&allocator, first, 24, 0);
+	BOOST_TEST(allocator.getStats().liveBytes == 0u);
+
+	// same size class
+	void* second = LuaAllocator::allocate(&allocator, nullptr, 0, 32);
+	BOOST_TEST(second == first);
+	BOOST_TEST(allocator.getStats().sizeClasses[1].live == 1u);
+	BOOST_TEST(allocator.getStats().sizeClasses[1].allocations == 2u);
+
+	LuaAllocator::allocate(&allocator, second, 32, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_luaallocator_reallocate_keeps_contents)
+{
+	LuaAllocator allocator;
+	auto block = static_cast<char*>(LuaAllocator::allocate(&allocator, nullptr, 0, 10));
+	std::fill(block, block + 10, 'a');
+
+	// within the size class, then into another one and out of the pool
+	BOOST_TEST(LuaAllocator::allocate(&allocator, block, 10, 16) == block);
+	block = static_cast<char*>(LuaAllocator::allocate(&allocator, block, 16, 200));
+	BOOST_TEST(std::count(block, block + 10, 'a') == 10);
+	block = static_cast<char*>(LuaAllocator::allocate(&allocator, block, 200, 4096));
+	BOOST_TEST(std::count(block, block + 10, 'a') == 10);
+	BOOST_TEST(allocator.getStats().largeLive == 1u);
+	BOOST_TEST(allocator.getStats().liveBytes == 4096u);
+
+	block = static_cast<char*>(LuaAllocator::allocate(&allocator, block, 4096, 8));
+	BOOST_TEST(std::count(block, block + 8, 'a') == 8);
+	BOOST_TEST(allocator.getStats().largeLive == 0u);
+
+	LuaAllocator::allocate(&allocator, block, 8, 0);
+	BOOST_TEST(allocator.getStats().liveBytes == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_luaallocator_grows_arenas)
+{
+	LuaAllocator allocator;
+	std::vector<void*> blocks;
+	const size_t count = 2 * LuaAllocator::ARENA_SIZE / LuaAllocator::MAX_POOLED_SIZE + 1;
+	for (size_t i = 0; i < count; ++i) {
+		blocks.push_back(LuaAllocator::allocate(&allocator, nullptr, 0, LuaAllocator::MAX_POOLED_SIZE));
+	}
+
+	BOOST_TEST(allocator.getStats().arenaBytes == 3 * LuaAllocator::ARENA_SIZE);
+	std::sort(blocks.begin(), blocks.end());
+	BOOST_TEST((std::adjacent_find(blocks.begin(), blocks.end()) == blocks.end()));
+
+	for (void* block : blocks) {
+		LuaAllocator::allocate(&allocator, block, LuaAllocator::MAX_POOLED_SIZE, 0);
+	}
+	allocator.release();
+	BOOST_TEST(allocator.getStats().arenaBytes == 0u);
+}
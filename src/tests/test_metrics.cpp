@@ -0,0 +1,65 @@
+#define BOOST_TEST_MODULE metrics
+
+#include "../otpch.h"
+
+#include "../metrics.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_counter_sums_threads)
+{
+	MetricCounter counter{"test_counter_total", "Counter."};
+
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i) {
+		threads.emplace_back([&]() {
+			for (int j = 0; j < 10000; ++j) {
+				counter.add();
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	BOOST_TEST(counter.value() == 40000u);
+}
+
+BOOST_AUTO_TEST_CASE(test_gauge_goes_down)
+{
+	MetricGauge gauge{"test_gauge", "Gauge."};
+	gauge.add(5);
+	std::thread([&]() { gauge.sub(3); }).join();
+	BOOST_TEST(gauge.value() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_histogram_exposition)
+{
+	MetricHistogram histogram{"test_histogram", "Histogram.", {10, 100}, "kind=\"a\""};
+	histogram.observe(5);
+	histogram.observe(10);
+	histogram.observe(50);
+	histogram.observe(1000);
+
+	std::string out;
+	histogram.serialize(out);
+	BOOST_TEST(out == "test_histogram_bucket{kind=\"a\",le=\"10\"} 2\n"
+	                  "test_histogram_bucket{kind=\"a\",le=\"100\"} 3\n"
+	                  "test_histogram_bucket{kind=\"a\",le=\"+Inf\"} 4\n"
+	                  "test_histogram_sum{kind=\"a\"} 1065\n"
+	                  "test_histogram_count{kind=\"a\"} 4\n");
+}
+
+BOOST_AUTO_TEST_CASE(test_registry_lists_metric_once)
+{
+	MetricCounter first{"test_labelled_total", "Labelled.", "id=\"1\""};
+	MetricCounter second{"test_labelled_total", "Labelled.", "id=\"2\""};
+	MetricCounter unused{"test_labelled_total", "Labelled.", "id=\"3\""};
+	first.add(2);
+	second.add();
+
+	const std::string out = Metrics::getInstance().serialize();
+	BOOST_TEST(out.find("# HELP test_labelled_total Labelled.\n# TYPE test_labelled_total counter\n"
+	                    "test_labelled_total{id=\"1\"} 2\ntest_labelled_total{id=\"2\"} 1\n") != std::string::npos);
+	BOOST_TEST(out.find("id=\"3\"") == std::string::npos);
+}
@@ -0,0 +1,49 @@
+#define BOOST_TEST_MODULE networkmessage
+
+#include "../otpch.h"
+
+#include "../networkmessage.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_networkmessage_grows_across_size_classes)
+{
+	NetworkMessage msg;
+	for (uint32_t i = 0; i < 5000; ++i) {
+		msg.add<uint32_t>(i);
+	}
+
+	BOOST_TEST(msg.getLength() == 5000 * sizeof(uint32_t));
+
+	msg.setBufferPosition(0);
+	for (uint32_t i = 0; i < 5000; ++i) {
+		BOOST_TEST_REQUIRE(msg.get<uint32_t>() == i);
+	}
+	BOOST_TEST(!msg.isOverrun());
+}
+
+BOOST_AUTO_TEST_CASE(test_networkmessage_stops_at_max_body_length)
+{
+	NetworkMessage msg;
+	std::string chunk(4000, 'x');
+	for (int i = 0; i < 10; ++i) {
+		msg.addString(chunk);
+	}
+
+	BOOST_TEST(msg.getLength() < NetworkMessage::MAX_BODY_LENGTH);
+	BOOST_TEST(msg.getLength() % (chunk.size() + 2) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_networkmessage_copy)
+{
+	NetworkMessage msg;
+	msg.addString(std::string(1000, 'a'));
+
+	NetworkMessage copy = msg;
+	msg.reset();
+	msg.addByte(0x01);
+
+	BOOST_TEST(copy.getLength() == 1002);
+	copy.setBufferPosition(0);
+	BOOST_TEST(copy.getString() == std::string(1000, 'a'));
+}
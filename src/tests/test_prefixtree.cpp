@@ -0,0 +1,45 @@
+#define BOOST_TEST_MODULE prefixtree
+
+#include "../otpch.h"
+
+#include "../prefixtree.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_prefixtree_visits_prefixes_shortest_first)
+{
+	PrefixTree<int> tree;
+	tree.insert("exura", 1);
+	tree.insert("exura gran", 2);
+	tree.insert("exori", 3);
+	tree.insert("EXURA", 4);
+
+	std::vector<std::pair<size_t, std::vector<int>>> visited;
+	tree.forEachPrefix("Exura Gran Mas Res",
+	                   [&](size_t length, const std::vector<int>& values) { visited.emplace_back(length, values); });
+
+	BOOST_TEST_REQUIRE(visited.size() == 2u);
+	BOOST_TEST(visited[0].first == 5u);
+	BOOST_TEST(visited[0].second == (std::vector<int>{1, 4}));
+	BOOST_TEST(visited[1].first == 10u);
+	BOOST_TEST(visited[1].second == (std::vector<int>{2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_prefixtree_longest_prefix)
+{
+	PrefixTree<int> tree;
+	tree.insert("/a", 1);
+	tree.insert("/attr", 2);
+
+	size_t length = 0;
+	const std::vector<int>* values = tree.findLongestPrefix("/attribute", length);
+	BOOST_TEST_REQUIRE(values);
+	BOOST_TEST(values->front() == 2);
+	BOOST_TEST(length == 5u);
+
+	BOOST_TEST(!tree.findLongestPrefix("/b", length));
+	BOOST_TEST(!tree.findLongestPrefix("", length));
+
+	tree.clear();
+	BOOST_TEST(!tree.findLongestPrefix("/attr", length));
+}
@@ -0,0 +1,33 @@
+#define BOOST_TEST_MODULE querystats
+
+#include "../otpch.h"
+
+#include "../querystats.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_querystats_fingerprint_literals)
+{
+	BOOST_TEST(QueryStats::fingerprint("SELECT `id` FROM `players` WHERE `name` = 'G\\'od' AND `level` > 100") ==
+	           "SELECT `id` FROM `players` WHERE `name` = ? AND `level` > ?");
+	BOOST_TEST(QueryStats::fingerprint("DELETE FROM `player_items` WHERE `player_id` = 12") ==
+	           "DELETE FROM `player_items` WHERE `player_id` = ?");
+	// numbers inside identifiers are kept
+	BOOST_TEST(QueryStats::fingerprint("SELECT `skill_fist2` FROM t1 WHERE x = -1.5") ==
+	           "SELECT `skill_fist2` FROM t1 WHERE x = -?");
+}
+
+BOOST_AUTO_TEST_CASE(test_querystats_fingerprint_lists)
+{
+	BOOST_TEST(QueryStats::fingerprint("INSERT INTO `t` (`a`, `b`) VALUES (1, 'x'),\n  (2, 'y')") ==
+	           "INSERT INTO `t` (`a`, `b`) VALUES (?), (?)");
+	BOOST_TEST(QueryStats::fingerprint("SELECT * FROM `t` WHERE `id` IN (1,2,3,4)") ==
+	           "SELECT * FROM `t` WHERE `id` IN (?)");
+}
+
+BOOST_AUTO_TEST_CASE(test_querystats_fingerprint_length)
+{
+	const std::string fingerprint = QueryStats::fingerprint("SELECT " + std::string(1000, 'a'));
+	BOOST_TEST(fingerprint.size() == 259);
+	BOOST_TEST(fingerprint.ends_with("..."));
+}
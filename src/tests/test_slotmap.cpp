@@ -0,0 +1,50 @@
+#define BOOST_TEST_MODULE slotmap
+
+#include "../otpch.h"
+
+#include "../slotmap.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_slotmap_acquire_find)
+{
+	SlotMap<int> map{0x40000000, 0x80000000};
+	int first = 1, second = 2;
+
+	const uint32_t firstId = map.acquire();
+	const uint32_t secondId = map.acquire();
+	BOOST_TEST(firstId != secondId);
+	BOOST_TEST(map.isInRange(firstId));
+	BOOST_TEST(map.isInRange(secondId));
+	BOOST_TEST(!map.isInRange(0x3FFFFFFF));
+	BOOST_TEST(!map.isInRange(0x80000000));
+
+	// an id finds nothing until its value is set
+	BOOST_TEST(!map.find(firstId));
+	map.set(firstId, &first);
+	map.set(secondId, &second);
+	BOOST_TEST(map.find(firstId) == &first);
+	BOOST_TEST(map.find(secondId) == &second);
+	BOOST_TEST(!map.find(0));
+	BOOST_TEST(!map.find(0xFFFFFFFF));
+
+	map.set(firstId, nullptr);
+	BOOST_TEST(!map.find(firstId));
+}
+
+BOOST_AUTO_TEST_CASE(test_slotmap_released_ids_stay_unique)
+{
+	SlotMap<int> map{0x10000000, 0x40000000};
+	int value = 1;
+
+	std::set<uint32_t> issued;
+	uint32_t id = map.acquire();
+	for (int i = 0; i < 10000; ++i) {
+		BOOST_TEST_REQUIRE(issued.insert(id).second);
+		map.set(id, &value);
+		map.release(id);
+		BOOST_TEST(!map.find(id));
+		id = map.acquire();
+	}
+	BOOST_TEST(!map.find(*issued.begin()));
+}
@@ -0,0 +1,57 @@
+#define BOOST_TEST_MODULE storagemap
+
+#include "../otpch.h"
+
+#include "../storagemap.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_storagemap_set_find)
+{
+	StorageMap<uint32_t, int64_t> map;
+	map.set(0, 1);
+	map.set(std::numeric_limits<uint32_t>::max(), 2);
+	map.set(500, 3);
+
+	BOOST_TEST(map.size() == 3);
+	BOOST_TEST(*map.find(0) == 1);
+	BOOST_TEST(*map.find(std::numeric_limits<uint32_t>::max()) == 2);
+	BOOST_TEST(*map.find(500) == 3);
+	BOOST_TEST(!map.find(501));
+
+	BOOST_TEST(map.erase(std::numeric_limits<uint32_t>::max()));
+	BOOST_TEST(!map.erase(std::numeric_limits<uint32_t>::max()));
+	BOOST_TEST(!map.find(std::numeric_limits<uint32_t>::max()));
+	BOOST_TEST(map.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_storagemap_changes)
+{
+	StorageMap<uint32_t, int64_t> map;
+	for (uint32_t i = 1; i <= 100; ++i) {
+		map.set(i, i);
+	}
+	BOOST_TEST(map.takeChanges().size() == 100);
+	BOOST_TEST(map.takeChanges().empty());
+
+	// an unchanged value is not a change
+	map.set(1, 1);
+	map.set(2, 20);
+	map.erase(3);
+	map.erase(1000);
+	map.erase(4);
+	map.set(4, 40);
+
+	std::vector<uint32_t> changes = map.takeChanges();
+	std::sort(changes.begin(), changes.end());
+	BOOST_TEST(changes == (std::vector<uint32_t>{2, 3, 4}));
+	BOOST_TEST(*map.find(2) == 20);
+	BOOST_TEST(!map.find(3));
+	BOOST_TEST(*map.find(4) == 40);
+	BOOST_TEST(map.size() == 99);
+
+	size_t visited = 0;
+	map.forEach([&visited](uint32_t, int64_t) { ++visited; });
+	BOOST_TEST(visited == 99);
+	BOOST_TEST(map.takeChanges().empty());
+}
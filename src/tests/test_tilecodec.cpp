@@ -0,0 +1,94 @@
+#define BOOST_TEST_MODULE tilecodec
+
+#include "../otpch.h"
+
+#include "../tilecodec.h"
+
+#include "../fileloader.h"
+#include "../item.h"
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+void writeItem(PropWriteStream& stream, uint16_t id, uint8_t count)
+{
+	stream.write<uint16_t>(id);
+	stream.write<uint8_t>(ATTR_COUNT);
+	stream.write<uint8_t>(count);
+	stream.write<uint8_t>(0);
+}
+
+// a house tile as IOMapSerialize::saveTile writes it, a bag with letters and two stacks of coins
+std::string makeTile()
+{
+	PropWriteStream stream;
+	stream.write<uint16_t>(1000);
+	stream.write<uint16_t>(1001);
+	stream.write<uint8_t>(7);
+	stream.write<uint32_t>(2);
+
+	stream.write<uint16_t>(1987);
+	stream.write<uint8_t>(ATTR_ACTION_ID);
+	stream.write<uint16_t>(2500);
+	stream.write<uint8_t>(ATTR_CONTAINER_ITEMS);
+	stream.write<uint32_t>(3);
+	for (int i = 0; i < 2; ++i) {
+		stream.write<uint16_t>(2597);
+		stream.write<uint8_t>(ATTR_TEXT);
+		stream.writeString("Dear diary,");
+		stream.write<uint8_t>(ATTR_WRITTENDATE);
+		stream.write<uint32_t>(1700000000 + i);
+		stream.write<uint8_t>(ATTR_WRITTENBY);
+		stream.writeString("Knight");
+		stream.write<uint8_t>(0);
+	}
+	writeItem(stream, 2148, 100);
+	stream.write<uint8_t>(0);
+
+	writeItem(stream, 2152, 37);
+	return std::string{stream.getStream()};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(test_tilecodec_round_trips_a_house_tile)
+{
+	const std::string tile = makeTile();
+	const auto compact = TileCodec::compact(tile);
+	BOOST_TEST_REQUIRE(compact.has_value());
+	BOOST_TEST(TileCodec::isCompact(*compact));
+	BOOST_TEST(!TileCodec::isCompact(tile));
+	BOOST_TEST(compact->size() < tile.size());
+
+	PropWriteStream expanded;
+	BOOST_TEST_REQUIRE(TileCodec::expand(*compact, expanded));
+	BOOST_TEST(expanded.getStream() == tile);
+}
+
+BOOST_AUTO_TEST_CASE(test_tilecodec_keeps_unknown_attributes_out)
+{
+	PropWriteStream stream;
+	stream.write<uint16_t>(1000);
+	stream.write<uint16_t>(1000);
+	stream.write<uint8_t>(7);
+	stream.write<uint32_t>(1);
+	stream.write<uint16_t>(2160);
+	stream.write<uint8_t>(ATTR_PODIUMOUTFIT);
+	for (int i = 0; i < 15; ++i) {
+		stream.write<uint8_t>(0);
+	}
+	stream.write<uint8_t>(0);
+
+	BOOST_TEST(!TileCodec::compact(stream.getStream()).has_value());
+}
+
+BOOST_AUTO_TEST_CASE(test_tilecodec_rejects_truncated_tiles)
+{
+	const std::string tile = makeTile();
+	BOOST_TEST(!TileCodec::compact(std::string_view{tile}.substr(0, tile.size() - 1)).has_value());
+
+	const std::string compact = TileCodec::compact(tile).value();
+	PropWriteStream expanded;
+	BOOST_TEST(!TileCodec::expand(std::string_view{compact}.substr(0, compact.size() - 1), expanded));
+}
@@ -0,0 +1,40 @@
+#define BOOST_TEST_MODULE wildcardtree
+
+#include "../otpch.h"
+
+#include "../wildcardtree.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_wildcardtree_completes_unique_prefix)
+{
+	WildcardTreeNode tree{false};
+	tree.insert("Gamemaster Tom");
+	tree.insert("Goblin");
+
+	std::string result;
+	BOOST_TEST(tree.findOne("GAME", result) == RETURNVALUE_NOERROR);
+	BOOST_TEST(result == "gamemaster tom");
+
+	BOOST_TEST(tree.findOne("g", result) == RETURNVALUE_NAMEISTOOAMBIGUOUS);
+	BOOST_TEST(tree.findOne("gob", result) == RETURNVALUE_NOERROR);
+	BOOST_TEST(result == "goblin");
+	BOOST_TEST(tree.findOne("orc", result) == RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE);
+}
+
+BOOST_AUTO_TEST_CASE(test_wildcardtree_name_prefix_of_another_is_ambiguous)
+{
+	WildcardTreeNode tree{false};
+	tree.insert("Bob");
+	tree.insert("Bobby");
+
+	std::string result;
+	BOOST_TEST(tree.findOne("bo", result) == RETURNVALUE_NAMEISTOOAMBIGUOUS);
+
+	tree.remove("BOBBY");
+	BOOST_TEST(tree.findOne("bo", result) == RETURNVALUE_NOERROR);
+	BOOST_TEST(result == "bob");
+
+	tree.remove("Bob");
+	BOOST_TEST(tree.findOne("b", result) == RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE);
+}
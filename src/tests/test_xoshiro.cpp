@@ -0,0 +1,48 @@
+#define BOOST_TEST_MODULE xoshiro
+
+#include "../otpch.h"
+
+#include "../xoshiro.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_CASE(test_xoshiro_same_seed_same_stream)
+{
+	Xoshiro256 first(42), second(42), other(43);
+	bool differs = false;
+	for (int i = 0; i < 100; ++i) {
+		const uint64_t value = first();
+		BOOST_TEST(value == second());
+		differs |= value != other();
+	}
+	BOOST_TEST(differs);
+}
+
+BOOST_AUTO_TEST_CASE(test_xoshiro_bounded_stays_in_range)
+{
+	Xoshiro256 generator(7);
+	std::array<uint32_t, 7> counts = {};
+	for (int i = 0; i < 70000; ++i) {
+		const uint32_t value = generator.bounded(7);
+		BOOST_TEST_REQUIRE(value < 7u);
+		++counts[value];
+	}
+
+	// every value turns up about as often as the others
+	for (uint32_t count : counts) {
+		BOOST_TEST(count > 9000u);
+		BOOST_TEST(count < 11000u);
+	}
+
+	BOOST_TEST(generator.bounded(1) == 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_xoshiro_real_in_unit_interval)
+{
+	Xoshiro256 generator(1);
+	for (int i = 0; i < 10000; ++i) {
+		const double value = generator.real();
+		BOOST_TEST_REQUIRE(value >= 0.0);
+		BOOST_TEST_REQUIRE(value < 1.0);
+	}
+}
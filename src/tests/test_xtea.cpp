@@ -41,4 +41,33 @@ BOOST_AUTO_TEST_CASE(test_xtea_decrypt)
 	xtea::decrypt(data.data(), data.size(), xtea::expand_key({0xdeadbeef, 0xdeadbeef, 0xdeadbeef, 0xdeadbeef}));
 
 	BOOST_TEST(data == expected);
-}
\ No newline at end of file
+}
+BOOST_AUTO_TEST_CASE(test_xtea_backends_match_scalar)
+{
+	const auto k = xtea::expand_key({0x01234567, 0x89abcdef, 0xfedcba98, 0x76543210});
+
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> byte(0, 255);
+
+	for (auto b : {xtea::backend::sse2, xtea::backend::avx2, xtea::backend::neon}) {
+		if (!xtea::is_supported(b)) {
+			continue;
+		}
+
+		// sizes around every group width, so both the vector loop and the scalar tail get exercised
+		for (size_t blocks = 0; blocks <= 67; ++blocks) {
+			std::vector<uint8_t> plain(blocks * 8);
+			std::generate(plain.begin(), plain.end(), [&]() { return static_cast<uint8_t>(byte(rng)); });
+
+			auto expected = plain;
+			xtea::encrypt(xtea::backend::scalar, expected.data(), expected.size(), k);
+
+			auto actual = plain;
+			xtea::encrypt(b, actual.data(), actual.size(), k);
+			BOOST_TEST(actual == expected);
+
+			xtea::decrypt(b, actual.data(), actual.size(), k);
+			BOOST_TEST(actual == plain);
+		}
+	}
+}
@@ -29,6 +29,10 @@ public:
 		}
 	}
 
+	// whether the caller runs on this thread, also true while it is not running, as startup and shutdown code owns
+	// the state then
+	bool isCurrentThread() const { return !thread.joinable() || thread.get_id() == std::this_thread::get_id(); }
+
 protected:
 	void setState(ThreadState newState) { threadState.store(newState, std::memory_order_relaxed); }
 
@@ -0,0 +1,155 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "threadregistry.h"
+
+#include "configmanager.h"
+#include "metrics.h"
+#include "tools.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#endif
+
+extern ConfigManager g_config;
+
+namespace {
+
+constexpr std::array<std::string_view, THREAD_ROLE_LAST> roleNames = {"dispatcher", "scheduler", "database",
+                                                                        "network", "job"};
+constexpr std::array<ConfigKeysString, THREAD_ROLE_LAST> roleCpus = {
+    ConfigKeysString::DISPATCHER_CPUS, ConfigKeysString::SCHEDULER_CPUS, ConfigKeysString::DATABASE_CPUS,
+    ConfigKeysString::NETWORK_CPUS, ConfigKeysString::JOB_CPUS};
+
+struct RegisteredThread
+{
+	std::thread::id id;
+#ifdef __linux__
+	pthread_t handle;
+#endif
+	ThreadRole role;
+	uint32_t index;
+};
+
+std::mutex registryLock;
+std::vector<RegisteredThread> registry;
+std::array<uint32_t, THREAD_ROLE_LAST> registeredCount = {};
+
+#ifdef __linux__
+// a cpu list the way taskset takes it, e.g. "0-3,8"
+std::optional<cpu_set_t> parseCpuList(std::string_view list)
+{
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	for (std::string_view range : explodeString(list, ",")) {
+		const size_t dash = range.find('-');
+		uint32_t first, last;
+		try {
+			first = std::stoul(std::string{range.substr(0, dash)});
+			last = dash == std::string_view::npos ? first : std::stoul(std::string{range.substr(dash + 1)});
+		} catch (const std::exception&) {
+			return std::nullopt;
+		}
+
+		if (first > last || last >= CPU_SETSIZE) {
+			return std::nullopt;
+		}
+
+		for (uint32_t cpu = first; cpu <= last; ++cpu) {
+			CPU_SET(cpu, &cpus);
+		}
+	}
+	return cpus;
+}
+#endif
+
+void pin(const RegisteredThread& thread)
+{
+#ifdef __linux__
+	const std::string_view list = g_config[roleCpus[thread.role]];
+	if (list.empty()) {
+		return;
+	}
+
+	auto cpus = parseCpuList(list);
+	if (!cpus) {
+		std::cout << "[Warning - ThreadRegistration] Invalid cpu list for the " << roleNames[thread.role]
+		          << " threads: " << list << std::endl;
+		return;
+	}
+
+	if (int error = pthread_setaffinity_np(thread.handle, sizeof(cpu_set_t), &*cpus); error != 0) {
+		std::cout << "[Warning - ThreadRegistration] Failed to pin a " << roleNames[thread.role]
+		          << " thread: " << std::strerror(error) << std::endl;
+	}
+#else
+	(void)thread;
+#endif
+}
+
+class ThreadCpuTimeMetric final : public Metric
+{
+public:
+	ThreadCpuTimeMetric() :
+	    Metric(METRIC_COUNTER, "tfs_thread_cpu_microseconds_total", "Cpu time used by each server thread.")
+	{}
+
+	void serialize(std::string& out) const override
+	{
+#ifdef __linux__
+		// a thread only leaves the registry while holding the lock, so none of them exits while it is read here
+		std::lock_guard<std::mutex> lockGuard(registryLock);
+		for (const RegisteredThread& thread : registry) {
+			clockid_t clock;
+			timespec time;
+			if (pthread_getcpuclockid(thread.handle, &clock) != 0 || clock_gettime(clock, &time) != 0) {
+				continue;
+			}
+
+			const uint64_t microseconds = static_cast<uint64_t>(time.tv_sec) * 1000000 + time.tv_nsec / 1000;
+			writeSample(out, {}, fmt::format("thread=\"{:s}\",index=\"{:d}\"", roleNames[thread.role], thread.index),
+			            std::to_string(microseconds));
+		}
+#else
+		(void)out;
+#endif
+	}
+};
+
+ThreadCpuTimeMetric threadCpuTime;
+
+} // namespace
+
+ThreadRegistration::ThreadRegistration(ThreadRole role)
+{
+	std::lock_guard<std::mutex> lockGuard(registryLock);
+	RegisteredThread& thread = registry.emplace_back();
+	thread.id = std::this_thread::get_id();
+	thread.role = role;
+	thread.index = registeredCount[role]++;
+#ifdef __linux__
+	thread.handle = pthread_self();
+
+	// names are cut to 15 characters
+	const std::string name = fmt::format("tfs-{:s}.{:d}", roleNames[role], thread.index).substr(0, 15);
+	pthread_setname_np(thread.handle, name.c_str());
+#endif
+	pin(thread);
+}
+
+ThreadRegistration::~ThreadRegistration()
+{
+	std::lock_guard<std::mutex> lockGuard(registryLock);
+	std::erase_if(registry,
+	              [id = std::this_thread::get_id()](const RegisteredThread& thread) { return thread.id == id; });
+}
+
+void applyThreadAffinity()
+{
+	std::lock_guard<std::mutex> lockGuard(registryLock);
+	for (const RegisteredThread& thread : registry) {
+		pin(thread);
+	}
+}
@@ -0,0 +1,37 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_THREADREGISTRY_H
+#define FS_THREADREGISTRY_H
+
+enum ThreadRole : uint8_t
+{
+	THREAD_ROLE_DISPATCHER,
+	THREAD_ROLE_SCHEDULER,
+	THREAD_ROLE_DATABASE,
+	THREAD_ROLE_NETWORK,
+	THREAD_ROLE_JOB,
+
+	THREAD_ROLE_LAST,
+};
+
+/*
+ * Registers the calling thread for as long as it lives: names it, pins it to the cores config.lua lists for its
+ * role (dispatcherCpus, jobCpus, ...) and reports its cpu time in tfs_thread_cpu_microseconds_total. Pinning and
+ * cpu time are Linux only.
+ */
+class ThreadRegistration
+{
+public:
+	explicit ThreadRegistration(ThreadRole role);
+	~ThreadRegistration();
+
+	// non-copyable
+	ThreadRegistration(const ThreadRegistration&) = delete;
+	ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+};
+
+// pins the threads that registered before the config was loaded
+void applyThreadAffinity();
+
+#endif // FS_THREADREGISTRY_H
@@ -0,0 +1,156 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "tickprofiler.h"
+
+#include "metrics.h"
+#include "scheduler.h"
+#include "tools.h"
+
+#include <fmt/format.h>
+
+TickProfiler g_tickProfiler;
+
+namespace {
+
+uint64_t microsecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(to - from).count();
+}
+
+} // namespace
+
+TickPhase getTickPhase(TaskOrigin origin)
+{
+	switch (getTaskOriginKind(origin)) {
+		case TASK_ORIGIN_PACKET:
+			return TICK_PHASE_PACKETS;
+		case TASK_ORIGIN_DATABASE:
+			return TICK_PHASE_DATABASE;
+		case TASK_ORIGIN_LUA_EVENT:
+			return TICK_PHASE_SCRIPTS;
+		case TASK_ORIGIN_NETWORK:
+			return TICK_PHASE_NETWORK;
+		case TASK_ORIGIN_SCHEDULER:
+			break;
+		default:
+			return TICK_PHASE_OTHER;
+	}
+
+	switch (getTaskOriginDetail(origin)) {
+		case SCHEDULER_EVENT_CREATURE_THINK:
+		case SCHEDULER_EVENT_CREATURE_WALK:
+		case SCHEDULER_EVENT_CREATURE_CONDITION:
+			return TICK_PHASE_CREATURES;
+		case SCHEDULER_EVENT_PLAYER_ACTION:
+			return TICK_PHASE_PACKETS;
+		case SCHEDULER_EVENT_DECAY:
+			return TICK_PHASE_DECAY;
+		case SCHEDULER_EVENT_SPAWN:
+			return TICK_PHASE_SPAWNS;
+		case SCHEDULER_EVENT_GLOBALEVENT:
+			return TICK_PHASE_SCRIPTS;
+		case SCHEDULER_EVENT_RAID:
+			return TICK_PHASE_RAIDS;
+		default:
+			return TICK_PHASE_OTHER;
+	}
+}
+
+const char* getTickPhaseName(TickPhase phase)
+{
+	switch (phase) {
+		case TICK_PHASE_CREATURES:
+			return "creatures";
+		case TICK_PHASE_DECAY:
+			return "decay";
+		case TICK_PHASE_SPAWNS:
+			return "spawns";
+		case TICK_PHASE_RAIDS:
+			return "raids";
+		case TICK_PHASE_PACKETS:
+			return "packets";
+		case TICK_PHASE_NETWORK:
+			return "network";
+		case TICK_PHASE_DATABASE:
+			return "database";
+		case TICK_PHASE_SCRIPTS:
+			return "scripts";
+		default:
+			return "other";
+	}
+}
+
+TickProfiler::TickProfiler() { current.start = OTSYS_TIME(); }
+
+TickProfiler::LuaScope::~LuaScope()
+{
+	if (--depth == 0) {
+		const uint64_t time = microsecondsBetween(start, std::chrono::steady_clock::now());
+		g_tickProfiler.current.luaTime += time;
+		metrics::luaTime.add(time);
+	}
+}
+
+void TickProfiler::endTick(uint32_t threshold)
+{
+	const auto now = std::chrono::steady_clock::now();
+	current.duration = microsecondsBetween(currentStart, now);
+	current.busy = 0;
+	for (uint64_t time : current.phases) {
+		current.busy += time;
+	}
+	metrics::tickBusyTime.observe(current.busy);
+
+	++totals.ticks;
+	totals.duration += current.duration;
+	totals.busy += current.busy;
+	totals.luaTime += current.luaTime;
+	totals.tasks += current.tasks;
+	for (size_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+		totals.phases[phase] += current.phases[phase];
+	}
+
+	if (threshold != 0 && current.busy >= threshold * 1000ull) {
+		slowTicks[nextSlowTick] = current;
+		nextSlowTick = (nextSlowTick + 1) % SLOW_TICK_HISTORY;
+		slowTickCount = std::min(slowTickCount + 1, SLOW_TICK_HISTORY);
+	}
+
+	current = {};
+	current.start = OTSYS_TIME();
+	currentStart = now;
+}
+
+std::vector<TickRecord> TickProfiler::getSlowTicks() const
+{
+	std::vector<TickRecord> ticks;
+	ticks.reserve(slowTickCount);
+	for (size_t i = SLOW_TICK_HISTORY - slowTickCount; i < SLOW_TICK_HISTORY; ++i) {
+		ticks.push_back(slowTicks[(nextSlowTick + i) % SLOW_TICK_HISTORY]);
+	}
+	return ticks;
+}
+
+void TickProfiler::logSlowTicks() const
+{
+	const std::vector<TickRecord> ticks = getSlowTicks();
+	std::cout << fmt::format("> Slow ticks: {:d} recorded", ticks.size()) << std::endl;
+
+	const int64_t now = OTSYS_TIME();
+	for (const TickRecord& tick : ticks) {
+		std::string phases;
+		for (uint8_t phase = 0; phase < TICK_PHASE_COUNT; ++phase) {
+			if (tick.phases[phase] != 0) {
+				phases += fmt::format(" | {:s} {:d} us", getTickPhaseName(static_cast<TickPhase>(phase)),
+				                      tick.phases[phase]);
+			}
+		}
+
+		std::cout << fmt::format("  {:>6d} ms ago: busy {:>6d} us of {:>6d} us, {:d} tasks, lua {:d} us{:s}",
+		                         now - tick.start, tick.busy, tick.duration, tick.tasks, tick.luaTime, phases)
+		          << std::endl;
+	}
+}
@@ -0,0 +1,108 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_TICKPROFILER_H
+#define FS_TICKPROFILER_H
+
+#include "tasks.h"
+
+enum TickPhase : uint8_t
+{
+	TICK_PHASE_CREATURES, // creature think, walk and condition events
+	TICK_PHASE_DECAY,
+	TICK_PHASE_SPAWNS,
+	TICK_PHASE_RAIDS,
+	TICK_PHASE_PACKETS,  // client packets
+	TICK_PHASE_NETWORK,  // output flushes and connection accept/release
+	TICK_PHASE_DATABASE, // database result callbacks
+	TICK_PHASE_SCRIPTS,  // addEvent timers and global events
+	TICK_PHASE_OTHER,
+
+	TICK_PHASE_COUNT
+};
+
+TickPhase getTickPhase(TaskOrigin origin);
+const char* getTickPhaseName(TickPhase phase);
+
+struct TickRecord
+{
+	// OTSYS_TIME at the start of the tick
+	int64_t start = 0;
+	// microseconds, duration is wall time and busy the sum of the phases
+	uint64_t duration = 0;
+	uint64_t busy = 0;
+	// time spent inside lua, whatever phase called it
+	uint64_t luaTime = 0;
+	uint32_t tasks = 0;
+	std::array<uint64_t, TICK_PHASE_COUNT> phases = {};
+};
+
+// every tick since the totals were last reset, in microseconds
+struct TickTotals
+{
+	uint64_t ticks = 0;
+	uint64_t duration = 0;
+	uint64_t busy = 0;
+	uint64_t luaTime = 0;
+	uint64_t tasks = 0;
+	std::array<uint64_t, TICK_PHASE_COUNT> phases = {};
+};
+
+// Splits the dispatcher time between two creature checks into phases and keeps the last ticks that were busy for
+// longer than a threshold. Dispatcher thread only.
+class TickProfiler
+{
+public:
+	static constexpr size_t SLOW_TICK_HISTORY = 32;
+
+	TickProfiler();
+
+	void addTaskTime(TaskOrigin origin, uint64_t time)
+	{
+		current.phases[getTickPhase(origin)] += time;
+		++current.tasks;
+	}
+	void addPhaseTime(TickPhase phase, uint64_t time) { current.phases[phase] += time; }
+
+	// closes the running tick, it is kept if it was busy for at least threshold milliseconds, 0 keeps none
+	void endTick(uint32_t threshold);
+
+	// oldest first
+	std::vector<TickRecord> getSlowTicks() const;
+	void clearSlowTicks() { slowTickCount = 0; }
+	void logSlowTicks() const;
+
+	const TickTotals& getTotals() const { return totals; }
+	void resetTotals() { totals = {}; }
+
+	// measures the outermost lua call on the stack
+	class LuaScope
+	{
+	public:
+		LuaScope() : start(depth++ == 0 ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{})
+		{}
+		~LuaScope();
+
+		// non-copyable
+		LuaScope(const LuaScope&) = delete;
+		LuaScope& operator=(const LuaScope&) = delete;
+
+	private:
+		static inline uint32_t depth = 0;
+		std::chrono::steady_clock::time_point start;
+	};
+
+private:
+	TickRecord current;
+	std::chrono::steady_clock::time_point currentStart = std::chrono::steady_clock::now();
+
+	TickTotals totals;
+
+	std::array<TickRecord, SLOW_TICK_HISTORY> slowTicks;
+	size_t nextSlowTick = 0;
+	size_t slowTickCount = 0;
+};
+
+extern TickProfiler g_tickProfiler;
+
+#endif // FS_TICKPROFILER_H
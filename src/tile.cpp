@@ -9,7 +9,9 @@
 #include "configmanager.h"
 #include "creature.h"
 #include "game.h"
+#include "housetile.h"
 #include "mailbox.h"
+#include "memorystats.h"
 #include "monster.h"
 #include "movement.h"
 #include "teleport.h"
@@ -22,6 +24,35 @@ extern ConfigManager g_config;
 StaticTile real_nullptr_tile(0xFFFF, 0xFFFF, 0xFF);
 Tile& Tile::nullptr_tile = real_nullptr_tile;
 
+void* Tile::operator new(size_t size)
+{
+	MemoryStats::allocated(MEMORY_TILES, size);
+	return ::operator new(size);
+}
+
+void Tile::operator delete(void* p, size_t size)
+{
+	MemoryStats::freed(MEMORY_TILES, size);
+	::operator delete(p);
+}
+
+namespace {
+
+// tile versions are never reused, so a version and an item identify one stack layout
+struct StackIndexEntry
+{
+	const Item* item = nullptr;
+	uint32_t version = 0;
+	int32_t index = -1;
+	bool belowCreatures = false;
+};
+
+constexpr size_t STACK_INDEX_CACHE_SIZE = 256;
+
+thread_local std::array<StackIndexEntry, STACK_INDEX_CACHE_SIZE> stackIndexCache;
+
+} // namespace
+
 bool Tile::hasProperty(ITEMPROPERTY prop) const
 {
 	if (ground && ground->hasProperty(prop)) {
@@ -305,8 +336,8 @@ Item* Tile::getItemByTopOrder(int32_t topOrder)
 	// 3: doors etc
 	// 4: creatures
 	if (TileItemVector* items = getItemList()) {
-		for (auto it = ItemVector::const_reverse_iterator(items->getEndTopItem()),
-		          end = ItemVector::const_reverse_iterator(items->getBeginTopItem());
+		for (auto it = TileItemVector::const_reverse_iterator(items->getEndTopItem()),
+		          end = TileItemVector::const_reverse_iterator(items->getBeginTopItem());
 		     it != end; ++it) {
 			if (Item::items[(*it)->getID()].alwaysOnTopOrder == topOrder) {
 				return (*it);
@@ -325,7 +356,7 @@ Thing* Tile::getTopVisibleThing(const Creature* creature)
 
 	TileItemVector* items = getItemList();
 	if (items) {
-		for (ItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end;
+		for (TileItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end;
 		     ++it) {
 			const ItemType& iit = Item::items[(*it)->getID()];
 			if (!iit.lookThrough) {
@@ -333,8 +364,8 @@ Thing* Tile::getTopVisibleThing(const Creature* creature)
 			}
 		}
 
-		for (auto it = ItemVector::const_reverse_iterator(items->getEndTopItem()),
-		          end = ItemVector::const_reverse_iterator(items->getBeginTopItem());
+		for (auto it = TileItemVector::const_reverse_iterator(items->getEndTopItem()),
+		          end = TileItemVector::const_reverse_iterator(items->getBeginTopItem());
 		     it != end; ++it) {
 			const ItemType& iit = Item::items[(*it)->getID()];
 			if (!iit.lookThrough) {
@@ -349,6 +380,7 @@ Thing* Tile::getTopVisibleThing(const Creature* creature)
 void Tile::onAddTileItem(Item* item)
 {
 	setTileFlags(item);
+	bumpVersion();
 
 	const Position& cylinderMapPos = getPosition();
 
@@ -377,6 +409,8 @@ void Tile::onAddTileItem(Item* item)
 
 void Tile::onUpdateTileItem(Item* oldItem, const ItemType& oldType, Item* newItem, const ItemType& newType)
 {
+	bumpVersion();
+
 	const Position& cylinderMapPos = getPosition();
 
 	SpectatorVec spectators;
@@ -398,6 +432,7 @@ void Tile::onUpdateTileItem(Item* oldItem, const ItemType& oldType, Item* newIte
 void Tile::onRemoveTileItem(const SpectatorVec& spectators, const std::vector<int32_t>& oldStackPosVector, Item* item)
 {
 	resetTileFlags(item);
+	bumpVersion();
 
 	const Position& cylinderMapPos = getPosition();
 	const ItemType& iType = Item::items[item->getID()];
@@ -447,160 +482,160 @@ void Tile::onUpdateTile(const SpectatorVec& spectators)
 	}
 }
 
-ReturnValue Tile::queryAdd(int32_t, const Thing& thing, uint32_t, uint32_t flags, Creature*) const
+ReturnValue Tile::queryAddCreature(const Creature& creature, uint32_t flags) const
 {
-	if (const Creature* creature = thing.getCreature()) {
-		if (hasBitSet(FLAG_NOLIMIT, flags)) {
-			return RETURNVALUE_NOERROR;
-		}
+	if (hasBitSet(FLAG_NOLIMIT, flags)) {
+		return RETURNVALUE_NOERROR;
+	}
 
-		if (hasBitSet(FLAG_PATHFINDING, flags) && hasFlag(TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT)) {
-			return RETURNVALUE_NOTPOSSIBLE;
+	if (hasFlag(TILESTATE_HOUSE)) {
+		if (ReturnValue ret = static_cast<const HouseTile*>(this)->queryInvited(creature); ret != RETURNVALUE_NOERROR) {
+			return ret;
 		}
+	}
 
-		if (ground == nullptr) {
+	if (hasBitSet(FLAG_PATHFINDING, flags) && hasFlag(TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT)) {
+		return RETURNVALUE_NOTPOSSIBLE;
+	}
+
+	if (ground == nullptr) {
+		return RETURNVALUE_NOTPOSSIBLE;
+	}
+
+	if (const Monster* monster = creature.getMonster()) {
+		if (hasFlag(TILESTATE_PROTECTIONZONE | TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT)) {
 			return RETURNVALUE_NOTPOSSIBLE;
 		}
 
-		if (const Monster* monster = creature->getMonster()) {
-			if (hasFlag(TILESTATE_PROTECTIONZONE | TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT)) {
-				return RETURNVALUE_NOTPOSSIBLE;
-			}
-
-			const CreatureVector* creatures = getCreatures();
-			if (monster->canPushCreatures() && !monster->isSummon()) {
-				if (creatures) {
-					for (Creature* tileCreature : *creatures) {
-						if (tileCreature->getPlayer() && tileCreature->getPlayer()->isInGhostMode()) {
-							continue;
-						}
+		const CreatureVector* creatures = getCreatures();
+		if (monster->canPushCreatures() && !monster->isSummon()) {
+			if (creatures) {
+				for (Creature* tileCreature : *creatures) {
+					if (tileCreature->getPlayer() && tileCreature->getPlayer()->isInGhostMode()) {
+						continue;
+					}
 
-						const Monster* creatureMonster = tileCreature->getMonster();
-						if (!creatureMonster || !tileCreature->isPushable() ||
-						    (creatureMonster->isSummon() && creatureMonster->getMaster()->getPlayer())) {
-							return RETURNVALUE_NOTPOSSIBLE;
-						}
+					const Monster* creatureMonster = tileCreature->getMonster();
+					if (!creatureMonster || !tileCreature->isPushable() ||
+					    (creatureMonster->isSummon() && creatureMonster->getMaster()->getPlayer())) {
+						return RETURNVALUE_NOTPOSSIBLE;
 					}
 				}
-			} else if (creatures && !creatures->empty()) {
-				for (const Creature* tileCreature : *creatures) {
-					if (!tileCreature->isInGhostMode()) {
-						return RETURNVALUE_NOTENOUGHROOM;
-					}
+			}
+		} else if (creatures && !creatures->empty()) {
+			for (const Creature* tileCreature : *creatures) {
+				if (!tileCreature->isInGhostMode()) {
+					return RETURNVALUE_NOTENOUGHROOM;
 				}
 			}
+		}
 
-			if (hasFlag(TILESTATE_IMMOVABLEBLOCKSOLID)) {
-				return RETURNVALUE_NOTPOSSIBLE;
-			}
+		if (hasFlag(TILESTATE_IMMOVABLEBLOCKSOLID)) {
+			return RETURNVALUE_NOTPOSSIBLE;
+		}
 
-			if (hasBitSet(FLAG_PATHFINDING, flags) && hasFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH)) {
-				return RETURNVALUE_NOTPOSSIBLE;
-			}
+		if (hasBitSet(FLAG_PATHFINDING, flags) && hasFlag(TILESTATE_IMMOVABLENOFIELDBLOCKPATH)) {
+			return RETURNVALUE_NOTPOSSIBLE;
+		}
 
-			if (hasFlag(TILESTATE_BLOCKSOLID) ||
-			    (hasBitSet(FLAG_PATHFINDING, flags) && hasFlag(TILESTATE_NOFIELDBLOCKPATH))) {
-				if (!(monster->canPushItems() || hasBitSet(FLAG_IGNOREBLOCKITEM, flags))) {
-					return RETURNVALUE_NOTPOSSIBLE;
-				}
+		if (hasFlag(TILESTATE_BLOCKSOLID) ||
+		    (hasBitSet(FLAG_PATHFINDING, flags) && hasFlag(TILESTATE_NOFIELDBLOCKPATH))) {
+			if (!(monster->canPushItems() || hasBitSet(FLAG_IGNOREBLOCKITEM, flags))) {
+				return RETURNVALUE_NOTPOSSIBLE;
 			}
+		}
 
-			MagicField* field = getFieldItem();
-			if (!field || field->isBlocking() || field->getDamage() == 0) {
-				return RETURNVALUE_NOERROR;
-			}
+		MagicField* field = getFieldItem();
+		if (!field || field->isBlocking() || field->getDamage() == 0) {
+			return RETURNVALUE_NOERROR;
+		}
 
-			CombatType_t combatType = field->getCombatType();
+		CombatType_t combatType = field->getCombatType();
 
-			// There is 3 options for a monster to enter a magic field
-			// 1) Monster is immune
-			if (!monster->isImmune(combatType)) {
-				// 1) Monster is able to walk over field type
-				// 2) Being attacked while random stepping will make it ignore field damages
-				if (hasBitSet(FLAG_IGNOREFIELDDAMAGE, flags)) {
-					if (!(monster->canWalkOnFieldType(combatType) || monster->isIgnoringFieldDamage())) {
-						return RETURNVALUE_NOTPOSSIBLE;
-					}
-				} else {
+		// There is 3 options for a monster to enter a magic field
+		// 1) Monster is immune
+		if (!monster->isImmune(combatType)) {
+			// 1) Monster is able to walk over field type
+			// 2) Being attacked while random stepping will make it ignore field damages
+			if (hasBitSet(FLAG_IGNOREFIELDDAMAGE, flags)) {
+				if (!(monster->canWalkOnFieldType(combatType) || monster->isIgnoringFieldDamage())) {
 					return RETURNVALUE_NOTPOSSIBLE;
 				}
+			} else {
+				return RETURNVALUE_NOTPOSSIBLE;
 			}
-
-			return RETURNVALUE_NOERROR;
 		}
 
-		const CreatureVector* creatures = getCreatures();
-		if (const Player* player = creature->getPlayer()) {
-			if (creatures && !creatures->empty() && !hasBitSet(FLAG_IGNOREBLOCKCREATURE, flags) &&
-			    !player->isAccessPlayer()) {
-				for (const Creature* tileCreature : *creatures) {
-					if (!player->canWalkthrough(tileCreature)) {
-						return RETURNVALUE_NOTPOSSIBLE;
-					}
-				}
-			}
+		return RETURNVALUE_NOERROR;
+	}
 
-			if (MagicField* field = getFieldItem()) {
-				if (field->getDamage() != 0 && hasBitSet(FLAG_PATHFINDING, flags) &&
-				    !hasBitSet(FLAG_IGNOREFIELDDAMAGE, flags)) {
+	const CreatureVector* creatures = getCreatures();
+	if (const Player* player = creature.getPlayer()) {
+		if (creatures && !creatures->empty() && !hasBitSet(FLAG_IGNOREBLOCKCREATURE, flags) &&
+		    !player->isAccessPlayer()) {
+			for (const Creature* tileCreature : *creatures) {
+				if (!player->canWalkthrough(tileCreature)) {
 					return RETURNVALUE_NOTPOSSIBLE;
 				}
 			}
+		}
 
-			if (!player->getParent() && hasFlag(TILESTATE_NOLOGOUT)) {
-				// player is trying to login to a "no logout" tile
+		if (MagicField* field = getFieldItem()) {
+			if (field->getDamage() != 0 && hasBitSet(FLAG_PATHFINDING, flags) &&
+			    !hasBitSet(FLAG_IGNOREFIELDDAMAGE, flags)) {
 				return RETURNVALUE_NOTPOSSIBLE;
 			}
+		}
 
-			const Tile* playerTile = player->getTile();
-			if (playerTile && player->isPzLocked()) {
-				if (!playerTile->hasFlag(TILESTATE_PVPZONE)) {
-					// player is trying to enter a pvp zone while being pz-locked
-					if (hasFlag(TILESTATE_PVPZONE)) {
-						return RETURNVALUE_PLAYERISPZLOCKEDENTERPVPZONE;
-					}
-				} else if (!hasFlag(TILESTATE_PVPZONE)) {
-					// player is trying to leave a pvp zone while being pz-locked
-					return RETURNVALUE_PLAYERISPZLOCKEDLEAVEPVPZONE;
-				}
+		if (!player->getParent() && hasFlag(TILESTATE_NOLOGOUT)) {
+			// player is trying to login to a "no logout" tile
+			return RETURNVALUE_NOTPOSSIBLE;
+		}
 
-				if ((!playerTile->hasFlag(TILESTATE_NOPVPZONE) && hasFlag(TILESTATE_NOPVPZONE)) ||
-				    (!playerTile->hasFlag(TILESTATE_PROTECTIONZONE) && hasFlag(TILESTATE_PROTECTIONZONE))) {
-					// player is trying to enter a non-pvp/protection zone while being pz-locked
-					return RETURNVALUE_PLAYERISPZLOCKED;
+		const Tile* playerTile = player->getTile();
+		if (playerTile && player->isPzLocked()) {
+			if (!playerTile->hasFlag(TILESTATE_PVPZONE)) {
+				// player is trying to enter a pvp zone while being pz-locked
+				if (hasFlag(TILESTATE_PVPZONE)) {
+					return RETURNVALUE_PLAYERISPZLOCKEDENTERPVPZONE;
 				}
+			} else if (!hasFlag(TILESTATE_PVPZONE)) {
+				// player is trying to leave a pvp zone while being pz-locked
+				return RETURNVALUE_PLAYERISPZLOCKEDLEAVEPVPZONE;
 			}
-		} else if (creatures && !creatures->empty() && !hasBitSet(FLAG_IGNOREBLOCKCREATURE, flags)) {
-			for (const Creature* tileCreature : *creatures) {
-				if (!tileCreature->isInGhostMode()) {
-					return RETURNVALUE_NOTENOUGHROOM;
-				}
+
+			if ((!playerTile->hasFlag(TILESTATE_NOPVPZONE) && hasFlag(TILESTATE_NOPVPZONE)) ||
+			    (!playerTile->hasFlag(TILESTATE_PROTECTIONZONE) && hasFlag(TILESTATE_PROTECTIONZONE))) {
+				// player is trying to enter a non-pvp/protection zone while being pz-locked
+				return RETURNVALUE_PLAYERISPZLOCKED;
 			}
 		}
-
-		if (!hasBitSet(FLAG_IGNOREBLOCKITEM, flags)) {
-			// If the FLAG_IGNOREBLOCKITEM bit isn't set we dont have to iterate every single item
-			if (hasFlag(TILESTATE_BLOCKSOLID)) {
+	} else if (creatures && !creatures->empty() && !hasBitSet(FLAG_IGNOREBLOCKCREATURE, flags)) {
+		for (const Creature* tileCreature : *creatures) {
+			if (!tileCreature->isInGhostMode()) {
 				return RETURNVALUE_NOTENOUGHROOM;
 			}
-		} else {
-			// FLAG_IGNOREBLOCKITEM is set
-			if (ground) {
-				const ItemType& iiType = Item::items[ground->getID()];
-				if (iiType.blockSolid && (!iiType.moveable || ground->hasAttribute(ITEM_ATTRIBUTE_UNIQUEID))) {
-					return RETURNVALUE_NOTPOSSIBLE;
-				}
-			}
+		}
+	}
 
-			if (const auto items = getItemList()) {
-				for (const Item* item : *items) {
-					const ItemType& iiType = Item::items[item->getID()];
-					if (iiType.blockSolid && (!iiType.moveable || item->hasAttribute(ITEM_ATTRIBUTE_UNIQUEID))) {
-						return RETURNVALUE_NOTPOSSIBLE;
-					}
-				}
-			}
+	if (!hasBitSet(FLAG_IGNOREBLOCKITEM, flags)) {
+		// If the FLAG_IGNOREBLOCKITEM bit isn't set we dont have to iterate every single item
+		if (hasFlag(TILESTATE_BLOCKSOLID)) {
+			return RETURNVALUE_NOTENOUGHROOM;
 		}
+	} else {
+		// FLAG_IGNOREBLOCKITEM is set, only immovable solid items block
+		if (hasFlag(TILESTATE_IMMOVABLEBLOCKSOLID)) {
+			return RETURNVALUE_NOTPOSSIBLE;
+		}
+	}
+	return RETURNVALUE_NOERROR;
+}
+
+ReturnValue Tile::queryAdd(int32_t, const Thing& thing, uint32_t, uint32_t flags, Creature*) const
+{
+	if (const Creature* creature = thing.getCreature()) {
+		return queryAddCreature(*creature, flags);
 	} else if (const Item* item = thing.getItem()) {
 		const TileItemVector* items = getItemList();
 		if (items && items->size() >= 0xFFFF) {
@@ -806,14 +841,15 @@ void Tile::addThing(int32_t, Thing* thing)
 {
 	Creature* creature = thing->getCreature();
 	if (creature) {
-		g_game.map.clearSpectatorCache();
+		g_game.map.clearSpectatorCache(tilePos);
 		if (creature->getPlayer()) {
-			g_game.map.clearPlayersSpectatorCache();
+			g_game.map.clearPlayersSpectatorCache(tilePos);
 		}
 
 		creature->setParent(this);
 		CreatureVector* creatures = makeCreatures();
 		creatures->insert(creatures->begin(), creature);
+		updateWalkFlags();
 	} else {
 		Item* item = thing->getItem();
 		if (item == nullptr) {
@@ -847,8 +883,8 @@ void Tile::addThing(int32_t, Thing* thing)
 		} else if (itemType.alwaysOnTop) {
 			if (itemType.isSplash() && items) {
 				// remove old splash if exists
-				for (ItemVector::const_iterator it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end;
-				     ++it) {
+				for (TileItemVector::const_iterator it = items->getBeginTopItem(), end = items->getEndTopItem();
+				     it != end; ++it) {
 					Item* oldSplash = *it;
 					if (!Item::items[oldSplash->getID()].isSplash()) {
 						continue;
@@ -886,7 +922,7 @@ void Tile::addThing(int32_t, Thing* thing)
 			if (itemType.isMagicField()) {
 				// remove old field item if exists
 				if (items) {
-					for (ItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem();
+					for (TileItemVector::const_iterator it = items->getBeginDownItem(), end = items->getEndDownItem();
 					     it != end; ++it) {
 						MagicField* oldField = (*it)->getMagicField();
 						if (oldField) {
@@ -1017,12 +1053,13 @@ void Tile::removeThing(Thing* thing, uint32_t count)
 		if (creatures) {
 			auto it = std::find(creatures->begin(), creatures->end(), thing);
 			if (it != creatures->end()) {
-				g_game.map.clearSpectatorCache();
+				g_game.map.clearSpectatorCache(tilePos);
 				if (creature->getPlayer()) {
-					g_game.map.clearPlayersSpectatorCache();
+					g_game.map.clearPlayersSpectatorCache(tilePos);
 				}
 
 				creatures->erase(it);
+				updateWalkFlags();
 			}
 		}
 		return;
@@ -1113,56 +1150,75 @@ bool Tile::hasCreature(Creature* creature) const
 
 void Tile::removeCreature(Creature* creature)
 {
-	g_game.map.getQTNode(tilePos.x, tilePos.y)->removeCreature(creature);
+	g_game.map.removeCreatureFromGrid(creature, tilePos);
 	removeThing(creature, 0);
 }
 
-int32_t Tile::getThingIndex(const Thing* thing) const
+std::pair<int32_t, bool> Tile::getItemStackIndex(const Item* item) const
 {
-	int32_t n = -1;
+	const size_t slot =
+	    ((reinterpret_cast<uintptr_t>(item) >> 4) ^ (version * 0x9E3779B1u)) & (STACK_INDEX_CACHE_SIZE - 1);
+	StackIndexEntry& entry = stackIndexCache[slot];
+	if (entry.version == version && entry.item == item) {
+		return {entry.index, entry.belowCreatures};
+	}
+
+	entry = {item, version, -1, false};
+	int32_t n = 0;
 	if (ground) {
-		if (ground == thing) {
-			return 0;
+		if (ground == item) {
+			entry.index = n;
+			return {entry.index, entry.belowCreatures};
 		}
 		++n;
 	}
 
-	const TileItemVector* items = getItemList();
-	if (items) {
-		const Item* item = thing->getItem();
-		if (item && item->isAlwaysOnTop()) {
-			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
-				++n;
+	if (const TileItemVector* items = getItemList()) {
+		if (item->isAlwaysOnTop()) {
+			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it, ++n) {
 				if (*it == item) {
-					return n;
+					entry.index = n;
+					break;
 				}
 			}
 		} else {
 			n += items->getTopItemCount();
+			for (auto it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it, ++n) {
+				if (*it == item) {
+					entry.index = n;
+					entry.belowCreatures = true;
+					break;
+				}
+			}
 		}
 	}
+	return {entry.index, entry.belowCreatures};
+}
 
-	if (const CreatureVector* creatures = getCreatures()) {
-		if (thing->getCreature()) {
-			for (Creature* creature : *creatures) {
-				++n;
-				if (creature == thing) {
-					return n;
-				}
-			}
-		} else {
-			n += creatures->size();
+int32_t Tile::getThingIndex(const Thing* thing) const
+{
+	if (const Item* item = thing->getItem()) {
+		auto [index, belowCreatures] = getItemStackIndex(item);
+		if (index != -1 && belowCreatures) {
+			index += getCreatureCount();
 		}
+		return index;
 	}
 
-	if (items) {
-		const Item* item = thing->getItem();
-		if (item && !item->isAlwaysOnTop()) {
-			for (auto it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
-				++n;
-				if (*it == item) {
-					return n;
-				}
+	int32_t n = -1;
+	if (ground) {
+		++n;
+	}
+
+	if (const TileItemVector* items = getItemList()) {
+		n += items->getTopItemCount();
+	}
+
+	if (const CreatureVector* creatures = getCreatures()) {
+		for (Creature* creature : *creatures) {
+			++n;
+			if (creature == thing) {
+				return n;
 			}
 		}
 	}
@@ -1198,28 +1254,12 @@ int32_t Tile::getClientIndexOfCreature(const Player* player, const Creature* cre
 
 int32_t Tile::getStackposOfItem(const Player* player, const Item* item) const
 {
-	int32_t n = 0;
-	if (ground) {
-		if (ground == item) {
-			return n;
-		}
-		++n;
-	}
-
-	const TileItemVector* items = getItemList();
-	if (items) {
-		if (item->isAlwaysOnTop()) {
-			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
-				if (*it == item) {
-					return n;
-				}
-				++n;
-			}
-		} else {
-			n += items->getTopItemCount();
-		}
+	auto [n, belowCreatures] = getItemStackIndex(item);
+	if (n == -1 || !belowCreatures) {
+		return n;
 	}
 
+	// only the creatures this player can see take a place in its stack
 	if (const CreatureVector* creatures = getCreatures()) {
 		for (const Creature* creature : *creatures) {
 			if (player->canSeeCreature(creature)) {
@@ -1227,16 +1267,7 @@ int32_t Tile::getStackposOfItem(const Player* player, const Item* item) const
 			}
 		}
 	}
-
-	if (items && !item->isAlwaysOnTop()) {
-		for (auto it = items->getBeginDownItem(), end = items->getEndDownItem(); it != end; ++it) {
-			if (*it == item) {
-				return n;
-			}
-			++n;
-		}
-	}
-	return -1;
+	return n;
 }
 
 size_t Tile::getFirstIndex() const { return 0; }
@@ -1384,13 +1415,14 @@ void Tile::internalAddThing(uint32_t, Thing* thing)
 
 	Creature* creature = thing->getCreature();
 	if (creature) {
-		g_game.map.clearSpectatorCache();
+		g_game.map.clearSpectatorCache(tilePos);
 		if (creature->getPlayer()) {
-			g_game.map.clearPlayersSpectatorCache();
+			g_game.map.clearPlayersSpectatorCache(tilePos);
 		}
 
 		CreatureVector* creatures = makeCreatures();
 		creatures->insert(creatures->begin(), creature);
+		updateWalkFlags();
 	} else {
 		Item* item = thing->getItem();
 		if (item == nullptr) {
@@ -1402,6 +1434,7 @@ void Tile::internalAddThing(uint32_t, Thing* thing)
 			if (ground == nullptr) {
 				ground = item;
 				setTileFlags(item);
+				bumpVersion();
 			}
 			return;
 		}
@@ -1411,6 +1444,8 @@ void Tile::internalAddThing(uint32_t, Thing* thing)
 			return /*RETURNVALUE_NOTPOSSIBLE*/;
 		}
 
+		bumpVersion();
+
 		if (itemType.alwaysOnTop) {
 			bool isInserted = false;
 			for (auto it = items->getBeginTopItem(), end = items->getEndTopItem(); it != end; ++it) {
@@ -1450,6 +1485,10 @@ void Tile::setTileFlags(const Item* item)
 		setFlag(TILESTATE_BLOCKPATH);
 	}
 
+	if (item->hasProperty(CONST_PROP_IMMOVABLEBLOCKPATH)) {
+		setFlag(TILESTATE_IMMOVABLEBLOCKPATH);
+	}
+
 	if (item->hasProperty(CONST_PROP_NOFIELDBLOCKPATH)) {
 		setFlag(TILESTATE_NOFIELDBLOCKPATH);
 	}
@@ -1490,6 +1529,12 @@ void Tile::setTileFlags(const Item* item)
 	if (item->hasProperty(CONST_PROP_SUPPORTHANGABLE)) {
 		setFlag(TILESTATE_SUPPORTS_HANGABLE);
 	}
+
+	if (item->hasProperty(CONST_PROP_BLOCKPROJECTILE)) {
+		setFlag(TILESTATE_BLOCKPROJECTILE);
+	}
+
+	updateWalkFlags();
 }
 
 void Tile::resetTileFlags(const Item* item)
@@ -1552,8 +1597,49 @@ void Tile::resetTileFlags(const Item* item)
 	if (item->hasProperty(CONST_PROP_SUPPORTHANGABLE)) {
 		resetFlag(TILESTATE_SUPPORTS_HANGABLE);
 	}
+
+	if (item->hasProperty(CONST_PROP_BLOCKPROJECTILE) && !hasProperty(item, CONST_PROP_BLOCKPROJECTILE)) {
+		resetFlag(TILESTATE_BLOCKPROJECTILE);
+	}
+
+	updateWalkFlags();
+}
+
+uint8_t Tile::getWalkFlags() const
+{
+	uint8_t walkFlags = TILEWALK_NONE;
+	if (ground) {
+		walkFlags |= TILEWALK_GROUND;
+	}
+
+	if (hasFlag(TILESTATE_FLOORCHANGE | TILESTATE_TELEPORT | TILESTATE_IMMOVABLEBLOCKSOLID)) {
+		walkFlags |= TILEWALK_BLOCKED;
+	}
+
+	if (hasFlag(TILESTATE_BLOCKSOLID | TILESTATE_NOFIELDBLOCKPATH | TILESTATE_IMMOVABLENOFIELDBLOCKPATH)) {
+		walkFlags |= TILEWALK_SOLID;
+	}
+
+	if (getCreatureCount() != 0) {
+		walkFlags |= TILEWALK_CREATURE;
+	}
+
+	if (hasFlag(TILESTATE_MAGICFIELD)) {
+		walkFlags |= TILEWALK_FIELD;
+	}
+
+	if (hasFlag(TILESTATE_PROTECTIONZONE | TILESTATE_NOPVPZONE | TILESTATE_PVPZONE | TILESTATE_NOLOGOUT)) {
+		walkFlags |= TILEWALK_ZONE;
+	}
+
+	if (hasFlag(TILESTATE_BLOCKPROJECTILE)) {
+		walkFlags |= TILEWALK_BLOCKPROJECTILE;
+	}
+	return walkFlags;
 }
 
+void Tile::updateWalkFlags() const { g_game.map.setTileWalkFlags(tilePos, getWalkFlags()); }
+
 bool Tile::isMoveableBlocking() const { return !ground || hasFlag(TILESTATE_BLOCKSOLID); }
 
 Item* Tile::getUseItem(int32_t index) const
@@ -1569,3 +1655,54 @@ Item* Tile::getUseItem(int32_t index) const
 
 	return nullptr;
 }
+
+namespace {
+
+// the stacks shared by the static tiles, they are only added to while the map loads
+std::set<SharedTileItems> sharedTileItems;
+
+} // namespace
+
+const SharedTileItems* SharedTileItems::get(SharedTileItems&& items)
+{
+	return &*sharedTileItems.insert(std::move(items)).first;
+}
+
+size_t SharedTileItems::getCount() { return sharedTileItems.size(); }
+
+bool StaticTile::shareItems()
+{
+	if (!items || items->empty()) {
+		return false;
+	}
+
+	// a plain item with no attributes is recreated exactly from its id and count
+	SharedTileItems shared;
+	shared.downItemCount = items->getDownItemCount();
+	for (const Item* item : *items) {
+		if (typeid(*item) != typeid(Item) || item->hasAttributes() || !item->isLoadedFromMap()) {
+			return false;
+		}
+		shared.items.emplace_back(item->getID(), item->getItemCount());
+	}
+
+	for (Item* item : *items) {
+		item->decrementReferenceCounter();
+	}
+	items.reset();
+	sharedItems = SharedTileItems::get(std::move(shared));
+	return true;
+}
+
+void StaticTile::unshareItems() const
+{
+	const SharedTileItems* shared = std::exchange(sharedItems, nullptr);
+	items.reset(new TileItemVector);
+	for (const auto& [id, count] : shared->items) {
+		Item* item = Item::CreateItem(id, count);
+		item->setParent(const_cast<StaticTile*>(this));
+		item->setLoadedFromMap(true);
+		items->push_back(item);
+	}
+	items->addDownItemCount(shared->downItemCount);
+}
@@ -50,12 +50,32 @@ enum tileflags_t : uint32_t
 	TILESTATE_IMMOVABLENOFIELDBLOCKPATH = 1 << 21,
 	TILESTATE_NOFIELDBLOCKPATH = 1 << 22,
 	TILESTATE_SUPPORTS_HANGABLE = 1 << 23,
+	TILESTATE_BLOCKPROJECTILE = 1 << 24,
+	TILESTATE_MOVEEVENT = 1 << 25,
+	TILESTATE_HOUSE = 1 << 26,
 
 	TILESTATE_FLOORCHANGE = TILESTATE_FLOORCHANGE_DOWN | TILESTATE_FLOORCHANGE_NORTH | TILESTATE_FLOORCHANGE_SOUTH |
 	                        TILESTATE_FLOORCHANGE_EAST | TILESTATE_FLOORCHANGE_WEST | TILESTATE_FLOORCHANGE_SOUTH_ALT |
 	                        TILESTATE_FLOORCHANGE_EAST_ALT,
 };
 
+// summary of a tile kept by the map so pathfinding and sight checks can skip the tile itself
+enum TileWalkFlags : uint8_t
+{
+	TILEWALK_NONE = 0,
+
+	TILEWALK_GROUND = 1 << 0,
+	// floor change, teleport or immovable solid item, nothing paths through it
+	TILEWALK_BLOCKED = 1 << 1,
+	// solid or field-blocking items, passable only for some creatures
+	TILEWALK_SOLID = 1 << 2,
+	TILEWALK_CREATURE = 1 << 3,
+	TILEWALK_FIELD = 1 << 4,
+	// protection, pvp, no-pvp or no-logout zone
+	TILEWALK_ZONE = 1 << 5,
+	TILEWALK_BLOCKPROJECTILE = 1 << 6,
+};
+
 enum ZoneType_t
 {
 	ZONE_PROTECTION,
@@ -65,25 +85,29 @@ enum ZoneType_t
 	ZONE_NORMAL,
 };
 
-class TileItemVector : private ItemVector
+// most tiles hold only a few items besides the ground, those are stored without an allocation of their own
+inline constexpr size_t TILE_INLINE_ITEMS = 3;
+using TileItemStorage = boost::container::small_vector<Item*, TILE_INLINE_ITEMS>;
+
+class TileItemVector : private TileItemStorage
 {
 public:
-	using ItemVector::at;
-	using ItemVector::begin;
-	using ItemVector::clear;
-	using ItemVector::const_iterator;
-	using ItemVector::const_reverse_iterator;
-	using ItemVector::empty;
-	using ItemVector::end;
-	using ItemVector::erase;
-	using ItemVector::insert;
-	using ItemVector::iterator;
-	using ItemVector::push_back;
-	using ItemVector::rbegin;
-	using ItemVector::rend;
-	using ItemVector::reverse_iterator;
-	using ItemVector::size;
-	using ItemVector::value_type;
+	using TileItemStorage::at;
+	using TileItemStorage::begin;
+	using TileItemStorage::clear;
+	using TileItemStorage::const_iterator;
+	using TileItemStorage::const_reverse_iterator;
+	using TileItemStorage::empty;
+	using TileItemStorage::end;
+	using TileItemStorage::erase;
+	using TileItemStorage::insert;
+	using TileItemStorage::iterator;
+	using TileItemStorage::push_back;
+	using TileItemStorage::rbegin;
+	using TileItemStorage::rend;
+	using TileItemStorage::reverse_iterator;
+	using TileItemStorage::size;
+	using TileItemStorage::value_type;
 
 	iterator getBeginDownItem() { return begin(); }
 	const_iterator getBeginDownItem() const { return begin(); }
@@ -120,13 +144,17 @@ class Tile : public Cylinder
 {
 public:
 	static Tile& nullptr_tile;
-	Tile(uint16_t x, uint16_t y, uint8_t z) : tilePos(x, y, z) {}
+	Tile(uint16_t x, uint16_t y, uint8_t z) : tilePos(x, y, z), version(++versionCounter) {}
 	virtual ~Tile() { delete ground; };
 
 	// non-copyable
 	Tile(const Tile&) = delete;
 	Tile& operator=(const Tile&) = delete;
 
+	// accounted in the memory stats
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	virtual TileItemVector* getItemList() = 0;
 	virtual const TileItemVector* getItemList() const = 0;
 	virtual TileItemVector* makeItemList() = 0;
@@ -172,6 +200,9 @@ public:
 	bool hasProperty(const Item* exclude, ITEMPROPERTY prop) const;
 
 	bool hasFlag(uint32_t flag) const { return hasBitSet(flag, this->flags); }
+	uint8_t getWalkFlags() const;
+	// pushes the current walk flags to the map, must follow any change of flags, ground or creatures
+	void updateWalkFlags() const;
 	void setFlag(uint32_t flag) { this->flags |= flag; }
 	void resetFlag(uint32_t flag) { this->flags &= ~flag; }
 
@@ -194,6 +225,9 @@ public:
 	int32_t getClientIndexOfCreature(const Player* player, const Creature* creature) const;
 	int32_t getStackposOfItem(const Player* player, const Item* item) const;
 
+	// the creature half of queryAdd, for callers that already know they are moving a creature
+	ReturnValue queryAddCreature(const Creature& creature, uint32_t flags) const;
+
 	// cylinder implementations
 	ReturnValue queryAdd(int32_t index, const Thing& thing, uint32_t count, uint32_t flags,
 	                     Creature* actor = nullptr) const override;
@@ -235,7 +269,14 @@ public:
 	Item* getUseItem(int32_t index) const;
 
 	Item* getGround() const { return ground; }
-	void setGround(Item* item) { ground = item; }
+	void setGround(Item* item)
+	{
+		ground = item;
+		bumpVersion();
+	}
+
+	// changes whenever an item is added, updated or removed, values are never reused even by other tiles
+	uint32_t getVersion() const { return version; }
 
 private:
 	void onAddTileItem(Item* item);
@@ -246,9 +287,18 @@ private:
 	void setTileFlags(const Item* item);
 	void resetTileFlags(const Item* item);
 
+	// index of the item as if the tile had no creatures, and whether it sits below them, -1 if it is not here
+	std::pair<int32_t, bool> getItemStackIndex(const Item* item) const;
+
+	void bumpVersion() { version = ++versionCounter; }
+
 	Item* ground = nullptr;
 	Position tilePos;
 	uint32_t flags = 0;
+	uint32_t version;
+
+	// dispatcher thread only
+	inline static uint32_t versionCounter = 0;
 };
 
 // Used for walkable tiles, where there is high likeliness of
@@ -283,12 +333,29 @@ public:
 	CreatureVector* makeCreatures() override { return &creatures; }
 };
 
+// Plain map items of a static tile, id and count in TileItemVector order. Every tile with the same stack points to
+// the one instance, it is kept until shutdown.
+struct SharedTileItems
+{
+	static const SharedTileItems* get(SharedTileItems&& items);
+	static size_t getCount();
+
+	auto operator<=>(const SharedTileItems&) const = default;
+
+	std::vector<std::pair<uint16_t, uint8_t>> items;
+	uint32_t downItemCount = 0;
+};
+
 // For blocking tiles, where we very rarely actually have items
 class StaticTile final : public Tile
 {
 	// We very rarely even need the vectors, so don't keep them in memory
-	std::unique_ptr<TileItemVector> items;
+	mutable std::unique_ptr<TileItemVector> items;
 	std::unique_ptr<CreatureVector> creatures;
+	// set while the items are only described by the stack the tile shares, they are created on the first access
+	mutable const SharedTileItems* sharedItems = nullptr;
+
+	void unshareItems() const;
 
 public:
 	StaticTile(uint16_t x, uint16_t y, uint8_t z) : Tile(x, y, z) {}
@@ -307,16 +374,33 @@ public:
 	StaticTile(const StaticTile&) = delete;
 	StaticTile& operator=(const StaticTile&) = delete;
 
-	TileItemVector* getItemList() override { return items.get(); }
-	const TileItemVector* getItemList() const override { return items.get(); }
+	TileItemVector* getItemList() override
+	{
+		if (sharedItems) {
+			unshareItems();
+		}
+		return items.get();
+	}
+	const TileItemVector* getItemList() const override
+	{
+		if (sharedItems) {
+			unshareItems();
+		}
+		return items.get();
+	}
 	TileItemVector* makeItemList() override
 	{
-		if (!items) {
+		if (sharedItems) {
+			unshareItems();
+		} else if (!items) {
 			items.reset(new TileItemVector);
 		}
 		return items.get();
 	}
 
+	// drops the items for the shared stack of the same ones if they are all plain map items, loading only
+	bool shareItems();
+
 	CreatureVector* getCreatures() override { return creatures.get(); }
 	const CreatureVector* getCreatures() const override { return creatures.get(); }
 	CreatureVector* makeCreatures() override
@@ -0,0 +1,575 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#include "otpch.h"
+
+#include "tilecodec.h"
+
+#include "fileloader.h"
+#include "item.h"
+
+namespace {
+
+constexpr uint16_t COMPACT_TILE_MARKER = 0xFFFF;
+constexpr uint8_t COMPACT_TILE_VERSION = 2;
+
+// containers nest at most this deep in a tile
+constexpr uint32_t MAX_CONTAINER_DEPTH = 64;
+
+enum FieldType : uint8_t
+{
+	// kept as the byte it is
+	FIELD_BYTE,
+	FIELD_U16,
+	FIELD_U32,
+	FIELD_I32,
+	FIELD_STRING,
+};
+
+struct AttributeLayout
+{
+	uint8_t count = 0;
+	std::array<FieldType, 3> fields = {};
+};
+
+// the fields of an attribute as Item::readAttr reads them, no fields for the ones the compact form does not know
+constexpr AttributeLayout getLayout(uint8_t attr)
+{
+	switch (attr) {
+		case ATTR_COUNT:
+		case ATTR_RUNE_CHARGES:
+		case ATTR_DECAYING_STATE:
+		case ATTR_HITCHANCE:
+		case ATTR_SHOOTRANGE:
+		case ATTR_HOUSEDOORID:
+		case ATTR_STOREITEM:
+		case ATTR_OPENCONTAINER:
+			return {1, {FIELD_BYTE}};
+
+		case ATTR_ACTION_ID:
+		case ATTR_UNIQUE_ID:
+		case ATTR_CHARGES:
+		case ATTR_DEPOT_ID:
+		case ATTR_WRAPID:
+			return {1, {FIELD_U16}};
+
+		case ATTR_WRITTENDATE:
+		case ATTR_DURATION:
+		case ATTR_WEIGHT:
+		case ATTR_ATTACK_SPEED:
+		case ATTR_SLEEPERGUID:
+		case ATTR_SLEEPSTART:
+			return {1, {FIELD_U32}};
+
+		case ATTR_ATTACK:
+		case ATTR_DEFENSE:
+		case ATTR_EXTRADEFENSE:
+		case ATTR_ARMOR:
+		case ATTR_DECAYTO:
+			return {1, {FIELD_I32}};
+
+		case ATTR_TEXT:
+		case ATTR_WRITTENBY:
+		case ATTR_DESC:
+		case ATTR_NAME:
+		case ATTR_ARTICLE:
+		case ATTR_PLURALNAME:
+			return {1, {FIELD_STRING}};
+
+		case ATTR_TELE_DEST:
+			return {3, {FIELD_U16, FIELD_U16, FIELD_BYTE}};
+
+		default:
+			return {};
+	}
+}
+
+// value types of a custom attribute, as ItemAttributes::CustomAttribute writes them
+enum CustomValueType : uint8_t
+{
+	CUSTOM_STRING = 1,
+	CUSTOM_INTEGER = 2,
+	CUSTOM_DOUBLE = 3,
+	CUSTOM_BOOLEAN = 4,
+};
+
+uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+void writeVarint(PropWriteStream& stream, uint64_t value)
+{
+	while (value >= 0x80) {
+		stream.write<uint8_t>(static_cast<uint8_t>(value | 0x80));
+		value >>= 7;
+	}
+	stream.write<uint8_t>(static_cast<uint8_t>(value));
+}
+
+bool readVarint(PropStream& stream, uint64_t& value)
+{
+	value = 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		uint8_t byte;
+		if (!stream.read<uint8_t>(byte)) {
+			return false;
+		}
+
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template <typename T>
+bool readVarint(PropStream& stream, T& value)
+{
+	uint64_t read;
+	if (!readVarint(stream, read) || read > std::numeric_limits<std::make_unsigned_t<T>>::max()) {
+		return false;
+	}
+	value = static_cast<T>(read);
+	return true;
+}
+
+class Compactor
+{
+public:
+	explicit Compactor(std::string_view tile) { in.init(tile.data(), tile.size()); }
+
+	std::optional<std::string> compact()
+	{
+		uint16_t x, y;
+		uint8_t z;
+		uint32_t count;
+		if (!in.read(x) || x == COMPACT_TILE_MARKER || !in.read(y) || !in.read(z) || !in.read(count)) {
+			return std::nullopt;
+		}
+
+		out.write(COMPACT_TILE_MARKER);
+		out.write(COMPACT_TILE_VERSION);
+		writeVarint(out, x);
+		writeVarint(out, y);
+		out.write(z);
+		writeVarint(out, count);
+
+		while (count--) {
+			if (!compactItem(0)) {
+				return std::nullopt;
+			}
+		}
+
+		if (in.size() != 0) {
+			return std::nullopt;
+		}
+		return std::string{out.getStream()};
+	}
+
+private:
+	bool compactItem(uint32_t depth)
+	{
+		uint16_t id;
+		if (depth > MAX_CONTAINER_DEPTH || !in.read(id)) {
+			return false;
+		}
+
+		writeVarint(out, zigzag(static_cast<int32_t>(id) - previousId));
+		previousId = id;
+
+		while (true) {
+			uint8_t attr;
+			if (!in.read(attr)) {
+				return false;
+			}
+
+			out.write(attr);
+			if (attr == 0) {
+				return true;
+			}
+
+			if (attr == ATTR_CONTAINER_ITEMS) {
+				uint32_t count;
+				if (!in.read(count)) {
+					return false;
+				}
+
+				writeVarint(out, count);
+				while (count--) {
+					if (!compactItem(depth + 1)) {
+						return false;
+					}
+				}
+			} else if (attr == ATTR_CUSTOM_ATTRIBUTES) {
+				if (!compactCustomAttributes()) {
+					return false;
+				}
+			} else {
+				const AttributeLayout layout = getLayout(attr);
+				if (layout.count == 0) {
+					return false;
+				}
+
+				for (uint8_t i = 0; i < layout.count; ++i) {
+					if (!compactField(layout.fields[i])) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	bool compactField(FieldType type)
+	{
+		switch (type) {
+			case FIELD_BYTE: {
+				uint8_t value;
+				if (!in.read(value)) {
+					return false;
+				}
+				out.write(value);
+				return true;
+			}
+
+			case FIELD_U16: {
+				uint16_t value;
+				if (!in.read(value)) {
+					return false;
+				}
+				writeVarint(out, value);
+				return true;
+			}
+
+			case FIELD_U32: {
+				uint32_t value;
+				if (!in.read(value)) {
+					return false;
+				}
+				writeVarint(out, value);
+				return true;
+			}
+
+			case FIELD_I32: {
+				int32_t value;
+				if (!in.read(value)) {
+					return false;
+				}
+				writeVarint(out, zigzag(value));
+				return true;
+			}
+
+			case FIELD_STRING:
+				return compactString();
+		}
+		return false;
+	}
+
+	bool compactCustomAttributes()
+	{
+		uint64_t count;
+		if (!in.read(count)) {
+			return false;
+		}
+
+		writeVarint(out, count);
+		while (count--) {
+			uint8_t type;
+			if (!compactString() || !in.read(type)) {
+				return false;
+			}
+
+			out.write(type);
+			switch (type) {
+				case CUSTOM_STRING:
+					if (!compactString()) {
+						return false;
+					}
+					break;
+
+				case CUSTOM_INTEGER: {
+					int64_t value;
+					if (!in.read(value)) {
+						return false;
+					}
+					writeVarint(out, zigzag(value));
+					break;
+				}
+
+				case CUSTOM_DOUBLE: {
+					double value;
+					if (!in.read(value)) {
+						return false;
+					}
+					out.write(value);
+					break;
+				}
+
+				case CUSTOM_BOOLEAN:
+					if (!compactField(FIELD_BYTE)) {
+						return false;
+					}
+					break;
+
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	// the index of a string seen before, or one past the last index followed by the new string
+	bool compactString()
+	{
+		auto [str, ok] = in.readString();
+		if (!ok) {
+			return false;
+		}
+
+		auto [it, inserted] = strings.try_emplace(str, static_cast<uint32_t>(strings.size()));
+		writeVarint(out, it->second);
+		if (inserted) {
+			writeVarint(out, str.size());
+			out.writeBytes(str.data(), str.size());
+		}
+		return true;
+	}
+
+	PropStream in;
+	PropWriteStream out;
+	std::unordered_map<std::string_view, uint32_t> strings;
+	int32_t previousId = 0;
+};
+
+class Expander
+{
+public:
+	Expander(std::string_view blob, PropWriteStream& out) : out{out} { in.init(blob.data(), blob.size()); }
+
+	bool expand()
+	{
+		uint16_t marker, x, y;
+		uint8_t version, z;
+		uint32_t count;
+		if (!in.read(marker) || marker != COMPACT_TILE_MARKER || !in.read(version) ||
+		    version != COMPACT_TILE_VERSION || !readVarint(in, x) || !readVarint(in, y) || !in.read(z) ||
+		    !readVarint(in, count)) {
+			return false;
+		}
+
+		out.write(x);
+		out.write(y);
+		out.write(z);
+		out.write(count);
+
+		while (count--) {
+			if (!expandItem(0)) {
+				return false;
+			}
+		}
+		return in.size() == 0;
+	}
+
+private:
+	bool expandItem(uint32_t depth)
+	{
+		uint64_t delta;
+		if (depth > MAX_CONTAINER_DEPTH || !readVarint(in, delta)) {
+			return false;
+		}
+
+		const int64_t id = previousId + unzigzag(delta);
+		if (id < 0 || id > std::numeric_limits<uint16_t>::max()) {
+			return false;
+		}
+
+		out.write(static_cast<uint16_t>(id));
+		previousId = static_cast<int32_t>(id);
+
+		while (true) {
+			uint8_t attr;
+			if (!in.read(attr)) {
+				return false;
+			}
+
+			out.write(attr);
+			if (attr == 0) {
+				return true;
+			}
+
+			if (attr == ATTR_CONTAINER_ITEMS) {
+				uint32_t count;
+				if (!readVarint(in, count)) {
+					return false;
+				}
+
+				out.write(count);
+				while (count--) {
+					if (!expandItem(depth + 1)) {
+						return false;
+					}
+				}
+			} else if (attr == ATTR_CUSTOM_ATTRIBUTES) {
+				if (!expandCustomAttributes()) {
+					return false;
+				}
+			} else {
+				const AttributeLayout layout = getLayout(attr);
+				if (layout.count == 0) {
+					return false;
+				}
+
+				for (uint8_t i = 0; i < layout.count; ++i) {
+					if (!expandField(layout.fields[i])) {
+						return false;
+					}
+				}
+			}
+		}
+	}
+
+	bool expandField(FieldType type)
+	{
+		switch (type) {
+			case FIELD_BYTE: {
+				uint8_t value;
+				if (!in.read(value)) {
+					return false;
+				}
+				out.write(value);
+				return true;
+			}
+
+			case FIELD_U16: {
+				uint16_t value;
+				if (!readVarint(in, value)) {
+					return false;
+				}
+				out.write(value);
+				return true;
+			}
+
+			case FIELD_U32: {
+				uint32_t value;
+				if (!readVarint(in, value)) {
+					return false;
+				}
+				out.write(value);
+				return true;
+			}
+
+			case FIELD_I32: {
+				uint64_t value;
+				if (!readVarint(in, value)) {
+					return false;
+				}
+
+				const int64_t signedValue = unzigzag(value);
+				if (signedValue < std::numeric_limits<int32_t>::min() ||
+				    signedValue > std::numeric_limits<int32_t>::max()) {
+					return false;
+				}
+				out.write(static_cast<int32_t>(signedValue));
+				return true;
+			}
+
+			case FIELD_STRING:
+				return expandString();
+		}
+		return false;
+	}
+
+	bool expandCustomAttributes()
+	{
+		uint64_t count;
+		if (!readVarint(in, count)) {
+			return false;
+		}
+
+		out.write(count);
+		while (count--) {
+			uint8_t type;
+			if (!expandString() || !in.read(type)) {
+				return false;
+			}
+
+			out.write(type);
+			switch (type) {
+				case CUSTOM_STRING:
+					if (!expandString()) {
+						return false;
+					}
+					break;
+
+				case CUSTOM_INTEGER: {
+					uint64_t value;
+					if (!readVarint(in, value)) {
+						return false;
+					}
+					out.write(unzigzag(value));
+					break;
+				}
+
+				case CUSTOM_DOUBLE: {
+					double value;
+					if (!in.read(value)) {
+						return false;
+					}
+					out.write(value);
+					break;
+				}
+
+				case CUSTOM_BOOLEAN:
+					if (!expandField(FIELD_BYTE)) {
+						return false;
+					}
+					break;
+
+				default:
+					return false;
+			}
+		}
+		return true;
+	}
+
+	bool expandString()
+	{
+		uint64_t index;
+		if (!readVarint(in, index) || index > strings.size()) {
+			return false;
+		}
+
+		if (index == strings.size()) {
+			uint16_t length;
+			if (!readVarint(in, length)) {
+				return false;
+			}
+
+			auto [str, ok] = in.readBytes(length);
+			if (!ok) {
+				return false;
+			}
+			strings.push_back(str);
+		}
+
+		const std::string_view str = strings[index];
+		out.writeString(str);
+		return true;
+	}
+
+	PropStream in;
+	PropWriteStream& out;
+	std::vector<std::string_view> strings;
+	int32_t previousId = 0;
+};
+
+} // namespace
+
+bool TileCodec::isCompact(std::string_view blob)
+{
+	return blob.size() >= sizeof(COMPACT_TILE_MARKER) &&
+	       std::memcmp(blob.data(), &COMPACT_TILE_MARKER, sizeof(COMPACT_TILE_MARKER)) == 0;
+}
+
+std::optional<std::string> TileCodec::compact(std::string_view tile) { return Compactor{tile}.compact(); }
+
+bool TileCodec::expand(std::string_view blob, PropWriteStream& tile) { return Expander{blob, tile}.expand(); }
@@ -0,0 +1,25 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_TILECODEC_H
+#define FS_TILECODEC_H
+
+class PropWriteStream;
+
+/**
+ * Compact form of a house tile as IOMapSerialize::saveTile writes it. Numbers are varints, item ids are stored as
+ * the difference to the item before and every string after its first use in the tile as an index into the ones
+ * before. Compact tiles start with an x of 0xFFFF, which no map tile has, so both forms can be told apart.
+ */
+class TileCodec
+{
+public:
+	static bool isCompact(std::string_view blob);
+
+	// nullopt if the tile holds an attribute the compact form does not know, it is then stored as it is
+	static std::optional<std::string> compact(std::string_view tile);
+	// writes the tile back in the form IOMapSerialize::loadHouseItems reads
+	static bool expand(std::string_view blob, PropWriteStream& tile);
+};
+
+#endif // FS_TILECODEC_H
@@ -5,6 +5,7 @@
 
 #include "tools.h"
 
+#include "adler32.h"
 #include "configmanager.h"
 
 extern ConfigManager g_config;
@@ -237,6 +238,17 @@ bool caseInsensitiveStartsWith(std::string_view str, std::string_view prefix)
 	                                                 [](char a, char b) { return tolower(a) == tolower(b); });
 }
 
+size_t CaseInsensitiveHash::operator()(std::string_view str) const
+{
+	// FNV-1a
+	size_t hash = 14695981039346656037ULL;
+	for (char ch : str) {
+		hash ^= static_cast<unsigned char>(tolower(static_cast<unsigned char>(ch)));
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
 std::vector<std::string_view> explodeString(std::string_view inString, const std::string& separator,
                                             int32_t limit /* = -1*/)
 {
@@ -261,27 +273,42 @@ IntegerVector vectorAtoi(const std::vector<std::string_view>& stringVector)
 	return returnVector;
 }
 
-std::mt19937& getRandomGenerator()
+Xoshiro256& getRandomGenerator()
 {
-	static std::random_device rd;
-	static std::mt19937 generator(rd());
+	// one per thread, the map loader creates items on several threads
+	thread_local Xoshiro256 generator((static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}());
 	return generator;
 }
 
 int32_t uniform_random(int32_t minNumber, int32_t maxNumber)
 {
-	static std::uniform_int_distribution<int32_t> uniformRand;
 	if (minNumber == maxNumber) {
 		return minNumber;
 	} else if (minNumber > maxNumber) {
 		std::swap(minNumber, maxNumber);
 	}
-	return uniformRand(getRandomGenerator(), std::uniform_int_distribution<int32_t>::param_type(minNumber, maxNumber));
+
+	// wraps to 0 for the full int32 range, which bounded takes as 2^32
+	const uint32_t range = static_cast<uint32_t>(maxNumber) - static_cast<uint32_t>(minNumber) + 1;
+	return static_cast<int32_t>(static_cast<uint32_t>(minNumber) + getRandomGenerator().bounded(range));
+}
+
+void uniform_random(int32_t minNumber, int32_t maxNumber, std::span<int32_t> out)
+{
+	if (minNumber > maxNumber) {
+		std::swap(minNumber, maxNumber);
+	}
+
+	Xoshiro256& generator = getRandomGenerator();
+	const uint32_t range = static_cast<uint32_t>(maxNumber) - static_cast<uint32_t>(minNumber) + 1;
+	for (int32_t& value : out) {
+		value = static_cast<int32_t>(static_cast<uint32_t>(minNumber) + generator.bounded(range));
+	}
 }
 
 int32_t normal_random(int32_t minNumber, int32_t maxNumber)
 {
-	static std::normal_distribution<float> normalRand(0.5f, 0.25f);
+	thread_local std::normal_distribution<float> normalRand(0.5f, 0.25f);
 
 	float v;
 	do {
@@ -292,11 +319,7 @@ int32_t normal_random(int32_t minNumber, int32_t maxNumber)
 	return a + std::lround(v * (b - a));
 }
 
-bool boolean_random(double probability /* = 0.5*/)
-{
-	static std::bernoulli_distribution booleanRand;
-	return booleanRand(getRandomGenerator(), std::bernoulli_distribution::param_type(probability));
-}
+bool boolean_random(double probability /* = 0.5*/) { return getRandomGenerator().real() < probability; }
 
 std::string convertIPToString(uint32_t ip)
 {
@@ -693,24 +716,7 @@ uint32_t adlerChecksum(const uint8_t* data, size_t length)
 		return 0;
 	}
 
-	const uint16_t adler = 65521;
-
-	uint32_t a = 1, b = 0;
-
-	while (length > 0) {
-		size_t tmp = length > 5552 ? 5552 : length;
-		length -= tmp;
-
-		do {
-			a += *data++;
-			b += a;
-		} while (--tmp);
-
-		a %= adler;
-		b %= adler;
-	}
-
-	return (b << 16) | a;
+	return adler32::checksum(data, length);
 }
 
 std::string ucfirst(std::string str)
@@ -1130,16 +1136,35 @@ std::string_view getReturnMessage(ReturnValue value)
 	}
 }
 
+namespace {
+
+thread_local int64_t cachedTime = 0;
+
+int64_t toSystemTime(std::chrono::steady_clock::time_point time)
+{
+	// taken on first use, OTSYS_TIME is called from static initializers
+	static const auto steadyStart = std::chrono::steady_clock::now();
+	static const int64_t systemStart =
+	    std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
+	        .count();
+	return systemStart + std::chrono::duration_cast<std::chrono::milliseconds>(time - steadyStart).count();
+}
+
+} // namespace
+
 int64_t OTSYS_TIME()
 {
-	return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch())
-	    .count();
+	if (cachedTime != 0) {
+		return cachedTime;
+	}
+	return toSystemTime(std::chrono::steady_clock::now());
 }
 
+void setCachedTime(std::chrono::steady_clock::time_point time) { cachedTime = toSystemTime(time); }
+
 int64_t OTSYS_NANOTIME()
 {
-	return std::chrono::duration_cast<std::chrono::nanoseconds>(
-	           std::chrono::high_resolution_clock::now().time_since_epoch())
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
 	    .count();
 }
 
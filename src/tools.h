@@ -7,6 +7,7 @@
 #include "const.h"
 #include "enums.h"
 #include "position.h"
+#include "xoshiro.h"
 
 #include <random>
 #include <string_view>
@@ -22,6 +23,19 @@ bool caseInsensitiveEqual(std::string_view str1, std::string_view str2);
 // checks that str1 starts with str2 ignoring letter case
 bool caseInsensitiveStartsWith(std::string_view str, std::string_view prefix);
 
+// hash and equality ignoring letter case for unordered containers, lookups take any string_view without a copy
+struct CaseInsensitiveHash
+{
+	using is_transparent = void;
+	size_t operator()(std::string_view str) const;
+};
+
+struct CaseInsensitiveEqual
+{
+	using is_transparent = void;
+	bool operator()(std::string_view str1, std::string_view str2) const { return caseInsensitiveEqual(str1, str2); }
+};
+
 using StringVector = std::vector<std::string>;
 using IntegerVector = std::vector<int32_t>;
 
@@ -30,8 +44,11 @@ std::vector<std::string_view> explodeString(std::string_view inString, const std
 IntegerVector vectorAtoi(const std::vector<std::string_view>& stringVector);
 constexpr bool hasBitSet(uint32_t flag, uint32_t flags) { return (flags & flag) != 0; }
 
-std::mt19937& getRandomGenerator();
+// one per thread, no locking
+Xoshiro256& getRandomGenerator();
 int32_t uniform_random(int32_t minNumber, int32_t maxNumber);
+// fills out with values from [minNumber, maxNumber]
+void uniform_random(int32_t minNumber, int32_t maxNumber, std::span<int32_t> out);
 int32_t normal_random(int32_t minNumber, int32_t maxNumber);
 bool boolean_random(double probability = 0.5);
 
@@ -72,8 +89,13 @@ itemAttrTypes stringToItemAttribute(std::string_view str);
 
 std::string_view getReturnMessage(ReturnValue value);
 
+// milliseconds since the epoch, advancing monotonically from the wall clock time at startup; the dispatcher thread
+// reads the time its current task started instead of the clock
 int64_t OTSYS_TIME();
+// monotonic nanoseconds read on every call, for measuring time spent
 int64_t OTSYS_NANOTIME();
+// makes OTSYS_TIME on this thread return the given time until the next call
+void setCachedTime(std::chrono::steady_clock::time_point time);
 
 SpellGroup_t stringToSpellGroup(std::string_view value);
 
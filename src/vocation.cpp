@@ -111,17 +111,21 @@ bool Vocations::loadFromXml()
 			}
 		}
 	}
+
+	vocationsById.assign(vocationsMap.empty() ? 0 : vocationsMap.rbegin()->first + 1, nullptr);
+	for (auto& [id, vocation] : vocationsMap) {
+		vocationsById[id] = &vocation;
+	}
 	return true;
 }
 
 Vocation* Vocations::getVocation(uint16_t id)
 {
-	auto it = vocationsMap.find(id);
-	if (it == vocationsMap.end()) {
+	if (id >= vocationsById.size() || !vocationsById[id]) {
 		std::cout << "[Warning - Vocations::getVocation] Vocation " << id << " not found." << std::endl;
 		return nullptr;
 	}
-	return &it->second;
+	return vocationsById[id];
 }
 
 std::optional<uint16_t> Vocations::getVocationId(std::string_view name) const
@@ -92,6 +92,8 @@ public:
 
 private:
 	VocationMap vocationsMap;
+	// indexed by vocation id, the ids are small and dense
+	std::vector<Vocation*> vocationsById;
 };
 
 #endif
@@ -26,24 +26,20 @@ const Weapon* Weapons::getWeapon(const Item* item) const
 		return nullptr;
 	}
 
-	auto it = weapons.find(item->getID());
-	if (it == weapons.end()) {
+	const uint16_t id = item->getID();
+	if (id >= weapons.size()) {
 		return nullptr;
 	}
-	return it->second;
+	return weapons[id];
 }
 
-void Weapons::clear(bool fromLua)
+void Weapons::removeEvents(const EventFilter& filter)
 {
-	for (auto it = weapons.begin(); it != weapons.end();) {
-		if (fromLua == it->second->fromLua) {
-			it = weapons.erase(it);
-		} else {
-			++it;
+	for (Weapon*& weapon : weapons) {
+		if (weapon && filter(*weapon)) {
+			weapon = nullptr;
 		}
 	}
-
-	reInitState(fromLua);
 }
 
 LuaScriptInterface& Weapons::getScriptInterface() { return scriptInterface; }
@@ -54,7 +50,7 @@ void Weapons::loadDefaults()
 {
 	for (size_t i = 100, size = Item::items.size(); i < size; ++i) {
 		const ItemType& it = Item::items.getItemType(i);
-		if (it.id == 0 || weapons.find(i) != weapons.end()) {
+		if (it.id == 0 || (i < weapons.size() && weapons[i])) {
 			continue;
 		}
 
@@ -64,7 +60,7 @@ void Weapons::loadDefaults()
 			case WEAPON_CLUB: {
 				WeaponMelee* weapon = new WeaponMelee(&scriptInterface);
 				weapon->configureWeapon(it);
-				weapons[i] = weapon;
+				setWeapon(i, weapon);
 				break;
 			}
 
@@ -76,7 +72,7 @@ void Weapons::loadDefaults()
 
 				WeaponDistance* weapon = new WeaponDistance(&scriptInterface);
 				weapon->configureWeapon(it);
-				weapons[i] = weapon;
+				setWeapon(i, weapon);
 				break;
 			}
 
@@ -102,20 +98,30 @@ bool Weapons::registerEvent(Event_ptr event, const pugi::xml_node&)
 {
 	Weapon* weapon = static_cast<Weapon*>(event.release()); // event is guaranteed to be a Weapon
 
-	auto result = weapons.emplace(weapon->getID(), weapon);
-	if (!result.second) {
-		std::cout << "[Warning - Weapons::registerEvent] Duplicate registered item with id: " << weapon->getID()
-		          << std::endl;
+	const uint16_t id = weapon->getID();
+	if (id < weapons.size() && weapons[id]) {
+		std::cout << "[Warning - Weapons::registerEvent] Duplicate registered item with id: " << id << std::endl;
+		return false;
 	}
-	return result.second;
+
+	setWeapon(id, weapon);
+	return true;
 }
 
 bool Weapons::registerLuaEvent(Weapon* weapon)
 {
-	weapons[weapon->getID()] = weapon;
+	setWeapon(weapon->getID(), weapon);
 	return true;
 }
 
+void Weapons::setWeapon(uint16_t id, Weapon* weapon)
+{
+	if (id >= weapons.size()) {
+		weapons.resize(std::max<size_t>(id + 1, Item::items.size()));
+	}
+	weapons[id] = weapon;
+}
+
 // monsters
 int32_t Weapons::getMaxMeleeDamage(int32_t attackSkill, int32_t attackValue)
 {
@@ -36,15 +36,18 @@ public:
 	static int32_t getMaxWeaponDamage(uint32_t level, int32_t attackSkill, int32_t attackValue, float attackFactor);
 
 	bool registerLuaEvent(Weapon* event);
-	void clear(bool fromLua) override final;
 
 private:
 	LuaScriptInterface& getScriptInterface() override;
 	std::string_view getScriptBaseName() const override;
 	Event_ptr getEvent(std::string_view nodeName) override;
 	bool registerEvent(Event_ptr event, const pugi::xml_node& node) override;
+	void removeEvents(const EventFilter& filter) override final;
 
-	std::map<uint32_t, Weapon*> weapons;
+	void setWeapon(uint16_t id, Weapon* weapon);
+
+	// indexed by item id
+	std::vector<Weapon*> weapons;
 
 	LuaScriptInterface scriptInterface{"Weapon Interface"};
 };
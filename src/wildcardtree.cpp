@@ -46,10 +46,10 @@ void WildcardTreeNode::insert(std::string_view str)
 
 	size_t length = str.length() - 1;
 	for (size_t pos = 0; pos < length; ++pos) {
-		cur = cur->addChild(str[pos], false);
+		cur = cur->addChild(fold(str[pos]), false);
 	}
 
-	cur->addChild(str[length], true);
+	cur->addChild(fold(str[length]), true);
 }
 
 void WildcardTreeNode::remove(std::string_view str)
@@ -60,7 +60,7 @@ void WildcardTreeNode::remove(std::string_view str)
 	path.push(cur);
 	size_t len = str.length();
 	for (size_t pos = 0; pos < len; ++pos) {
-		cur = cur->getChild(str[pos]);
+		cur = cur->getChild(fold(str[pos]));
 		if (!cur) {
 			return;
 		}
@@ -79,7 +79,7 @@ void WildcardTreeNode::remove(std::string_view str)
 
 		cur = path.top();
 
-		auto it = cur->children.find(str[--len]);
+		auto it = cur->children.find(fold(str[--len]));
 		if (it != cur->children.end()) {
 			cur->children.erase(it);
 		}
@@ -89,15 +89,15 @@ void WildcardTreeNode::remove(std::string_view str)
 ReturnValue WildcardTreeNode::findOne(std::string_view query, std::string& result) const
 {
 	const WildcardTreeNode* cur = this;
+	result.clear();
 	for (auto pos : query) {
-		cur = cur->getChild(pos);
+		cur = cur->getChild(fold(pos));
 		if (!cur) {
 			return RETURNVALUE_PLAYERWITHTHISNAMEISNOTONLINE;
 		}
+		result += fold(pos);
 	}
 
-	result = query;
-
 	do {
 		size_t size = cur->children.size();
 		if (size == 0) {
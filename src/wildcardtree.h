@@ -11,6 +11,7 @@ class WildcardTreeNode
 public:
 	explicit WildcardTreeNode(bool breakpoint) : breakpoint(breakpoint) {}
 	WildcardTreeNode(WildcardTreeNode&& other) = default;
+	WildcardTreeNode& operator=(WildcardTreeNode&& other) = default;
 
 	// non-copyable
 	WildcardTreeNode(const WildcardTreeNode&) = delete;
@@ -20,13 +21,17 @@ public:
 	const WildcardTreeNode* getChild(char ch) const;
 	WildcardTreeNode* addChild(char ch, bool breakpoint);
 
+	// strings are stored and looked up in lower case
 	void insert(std::string_view str);
 	void remove(std::string_view str);
 
 	ReturnValue findOne(std::string_view query, std::string& result) const;
 
 private:
-	std::map<char, WildcardTreeNode> children;
+	static char fold(char ch) { return static_cast<char>(tolower(static_cast<unsigned char>(ch))); }
+
+	// sorted in one block, a node rarely has more than a handful of children
+	boost::container::flat_map<char, WildcardTreeNode> children;
 	bool breakpoint;
 };
 
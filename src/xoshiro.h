@@ -0,0 +1,72 @@
+// Copyright 2023 The Forgotten Server Authors. All rights reserved.
+// Use of this source code is governed by the GPL-2.0 License that can be found in the LICENSE file.
+
+#ifndef FS_XOSHIRO_H
+#define FS_XOSHIRO_H
+
+/*
+ * xoshiro256** generator, a few cycles per 64 bit value and 32 bytes of state, so every thread can keep its own.
+ * Satisfies UniformRandomBitGenerator for use with std::shuffle and the standard distributions.
+ */
+class Xoshiro256
+{
+public:
+	using result_type = uint64_t;
+
+	explicit Xoshiro256(uint64_t seed) { this->seed(seed); }
+
+	// expands seed through splitmix64, so nearby seeds still give unrelated streams
+	void seed(uint64_t seed)
+	{
+		for (uint64_t& word : state) {
+			seed += 0x9E3779B97F4A7C15;
+			uint64_t z = seed;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+			word = z ^ (z >> 31);
+		}
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()()
+	{
+		const uint64_t result = std::rotl(state[1] * 5, 7) * 9;
+		const uint64_t t = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+
+		state[2] ^= t;
+		state[3] = std::rotl(state[3], 45);
+		return result;
+	}
+
+	// uniform in [0, range), range 0 stands for the full 2^32 (Lemire's multiply and reject)
+	uint32_t bounded(uint32_t range)
+	{
+		if (range == 0) {
+			return static_cast<uint32_t>(operator()() >> 32);
+		}
+
+		uint64_t m = (operator()() >> 32) * range;
+		if (static_cast<uint32_t>(m) < range) {
+			const uint32_t threshold = -range % range;
+			while (static_cast<uint32_t>(m) < threshold) {
+				m = (operator()() >> 32) * range;
+			}
+		}
+		return static_cast<uint32_t>(m >> 32);
+	}
+
+	// uniform in [0, 1)
+	double real() { return static_cast<double>(operator()() >> 11) * 0x1.0p-53; }
+
+private:
+	std::array<uint64_t, 4> state;
+};
+
+#endif // FS_XOSHIRO_H
@@ -7,23 +7,30 @@
 
 #include <cstring>
 
-namespace xtea {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define XTEA_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define XTEA_NEON
+#include <arm_neon.h>
+#endif
 
-round_keys expand_key(const key& k)
-{
-	constexpr uint32_t delta = 0x9E3779B9;
-	round_keys expanded;
+#if defined(XTEA_X86) && (defined(__GNUC__) || defined(__clang__))
+#define XTEA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define XTEA_TARGET_AVX2
+#endif
 
-	for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < expanded.size();
-	     i += 2, sum = next_sum, next_sum += delta) {
-		expanded[i] = sum + k[sum & 3];
-		expanded[i + 1] = next_sum + k[(next_sum >> 11) & 3];
-	}
+namespace xtea {
 
-	return expanded;
-}
+namespace {
 
-void encrypt(uint8_t* data, size_t length, const round_keys& k)
+// the blocks are independent, so every implementation runs all rounds over a group of them and leaves what does not
+// fill a whole group to encryptBlocks/decryptBlocks
+void encryptBlocks(uint8_t* data, size_t length, const round_keys& k)
 {
 	for (auto i = 0u; i < k.size(); i += 2) {
 		for (auto it = data, last = data + length; it < last; it += 8) {
@@ -40,7 +47,7 @@ void encrypt(uint8_t* data, size_t length, const round_keys& k)
 	}
 }
 
-void decrypt(uint8_t* data, size_t length, const round_keys& k)
+void decryptBlocks(uint8_t* data, size_t length, const round_keys& k)
 {
 	for (auto i = k.size(); i > 0; i -= 2) {
 		for (auto it = data, last = data + length; it < last; it += 8) {
@@ -57,4 +64,251 @@ void decrypt(uint8_t* data, size_t length, const round_keys& k)
 	}
 }
 
+#ifdef XTEA_X86
+// 4 blocks per group: the shuffles split 2 vectors of [left, right] pairs into one vector of lefts and one of rights
+inline __m128i mix(__m128i v) { return _mm_add_epi32(_mm_xor_si128(_mm_slli_epi32(v, 4), _mm_srli_epi32(v, 5)), v); }
+
+void encryptSse2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t groups = length / 32;
+	for (size_t group = 0; group < groups; ++group) {
+		uint8_t* it = data + group * 32;
+		__m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)));
+		__m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 16)));
+		__m128i left = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i right = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		for (auto i = 0u; i < k.size(); i += 2) {
+			left = _mm_add_epi32(left, _mm_xor_si128(mix(right), _mm_set1_epi32(static_cast<int>(k[i]))));
+			right = _mm_add_epi32(right, _mm_xor_si128(mix(left), _mm_set1_epi32(static_cast<int>(k[i + 1]))));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it), _mm_unpacklo_epi32(left, right));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it + 16), _mm_unpackhi_epi32(left, right));
+	}
+	encryptBlocks(data + groups * 32, length - groups * 32, k);
+}
+
+void decryptSse2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t groups = length / 32;
+	for (size_t group = 0; group < groups; ++group) {
+		uint8_t* it = data + group * 32;
+		__m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it)));
+		__m128 b = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(it + 16)));
+		__m128i left = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m128i right = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		for (auto i = k.size(); i > 0; i -= 2) {
+			right = _mm_sub_epi32(right, _mm_xor_si128(mix(left), _mm_set1_epi32(static_cast<int>(k[i - 1]))));
+			left = _mm_sub_epi32(left, _mm_xor_si128(mix(right), _mm_set1_epi32(static_cast<int>(k[i - 2]))));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it), _mm_unpacklo_epi32(left, right));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(it + 16), _mm_unpackhi_epi32(left, right));
+	}
+	decryptBlocks(data + groups * 32, length - groups * 32, k);
+}
+
+// 8 blocks per group, the shuffles and unpacks work within each 128-bit lane so they undo each other just the same
+XTEA_TARGET_AVX2 inline __m256i mix(__m256i v)
+{
+	return _mm256_add_epi32(_mm256_xor_si256(_mm256_slli_epi32(v, 4), _mm256_srli_epi32(v, 5)), v);
+}
+
+XTEA_TARGET_AVX2 void encryptAvx2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t groups = length / 64;
+	for (size_t group = 0; group < groups; ++group) {
+		uint8_t* it = data + group * 64;
+		__m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)));
+		__m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 32)));
+		__m256i left = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m256i right = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		for (auto i = 0u; i < k.size(); i += 2) {
+			left = _mm256_add_epi32(left, _mm256_xor_si256(mix(right), _mm256_set1_epi32(static_cast<int>(k[i]))));
+			right =
+			    _mm256_add_epi32(right, _mm256_xor_si256(mix(left), _mm256_set1_epi32(static_cast<int>(k[i + 1]))));
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it), _mm256_unpacklo_epi32(left, right));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it + 32), _mm256_unpackhi_epi32(left, right));
+	}
+	encryptSse2(data + groups * 64, length - groups * 64, k);
+}
+
+XTEA_TARGET_AVX2 void decryptAvx2(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t groups = length / 64;
+	for (size_t group = 0; group < groups; ++group) {
+		uint8_t* it = data + group * 64;
+		__m256 a = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it)));
+		__m256 b = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(it + 32)));
+		__m256i left = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		__m256i right = _mm256_castps_si256(_mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		for (auto i = k.size(); i > 0; i -= 2) {
+			right = _mm256_sub_epi32(right,
+			                         _mm256_xor_si256(mix(left), _mm256_set1_epi32(static_cast<int>(k[i - 1]))));
+			left = _mm256_sub_epi32(left,
+			                        _mm256_xor_si256(mix(right), _mm256_set1_epi32(static_cast<int>(k[i - 2]))));
+		}
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it), _mm256_unpacklo_epi32(left, right));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(it + 32), _mm256_unpackhi_epi32(left, right));
+	}
+	decryptSse2(data + groups * 64, length - groups * 64, k);
+}
+
+bool hasAvx2()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	bool avx2 = (info[1] & (1 << 5)) != 0;
+	__cpuid(info, 1);
+	// the os has to save the ymm registers too
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	return avx2 && osxsave && (_xgetbv(0) & 6) == 6;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#ifdef XTEA_NEON
+// 4 blocks per group, vld2q/vst2q split and join the [left, right] pairs on their own
+inline uint32x4_t mix(uint32x4_t v) { return vaddq_u32(veorq_u32(vshlq_n_u32(v, 4), vshrq_n_u32(v, 5)), v); }
+
+void encryptNeon(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t groups = length / 32;
+	for (size_t group = 0; group < groups; ++group) {
+		uint8_t* it = data + group * 32;
+		uint32x4x2_t block = vld2q_u32(reinterpret_cast<const uint32_t*>(it));
+		for (auto i = 0u; i < k.size(); i += 2) {
+			block.val[0] = vaddq_u32(block.val[0], veorq_u32(mix(block.val[1]), vdupq_n_u32(k[i])));
+			block.val[1] = vaddq_u32(block.val[1], veorq_u32(mix(block.val[0]), vdupq_n_u32(k[i + 1])));
+		}
+		vst2q_u32(reinterpret_cast<uint32_t*>(it), block);
+	}
+	encryptBlocks(data + groups * 32, length - groups * 32, k);
+}
+
+void decryptNeon(uint8_t* data, size_t length, const round_keys& k)
+{
+	size_t groups = length / 32;
+	for (size_t group = 0; group < groups; ++group) {
+		uint8_t* it = data + group * 32;
+		uint32x4x2_t block = vld2q_u32(reinterpret_cast<const uint32_t*>(it));
+		for (auto i = k.size(); i > 0; i -= 2) {
+			block.val[1] = vsubq_u32(block.val[1], veorq_u32(mix(block.val[0]), vdupq_n_u32(k[i - 1])));
+			block.val[0] = vsubq_u32(block.val[0], veorq_u32(mix(block.val[1]), vdupq_n_u32(k[i - 2])));
+		}
+		vst2q_u32(reinterpret_cast<uint32_t*>(it), block);
+	}
+	decryptBlocks(data + groups * 32, length - groups * 32, k);
+}
+#endif
+
+backend getBestBackend()
+{
+#ifdef XTEA_X86
+	return hasAvx2() ? backend::avx2 : backend::sse2;
+#elif defined(XTEA_NEON)
+	return backend::neon;
+#else
+	return backend::scalar;
+#endif
+}
+
+} // namespace
+
+round_keys expand_key(const key& k)
+{
+	constexpr uint32_t delta = 0x9E3779B9;
+	round_keys expanded;
+
+	for (uint32_t i = 0, sum = 0, next_sum = sum + delta; i < expanded.size();
+	     i += 2, sum = next_sum, next_sum += delta) {
+		expanded[i] = sum + k[sum & 3];
+		expanded[i + 1] = next_sum + k[(next_sum >> 11) & 3];
+	}
+
+	return expanded;
+}
+
+void encrypt(uint8_t* data, size_t length, const round_keys& k)
+{
+	static const backend best = getBestBackend();
+	encrypt(best, data, length, k);
+}
+
+void decrypt(uint8_t* data, size_t length, const round_keys& k)
+{
+	static const backend best = getBestBackend();
+	decrypt(best, data, length, k);
+}
+
+bool is_supported(backend b)
+{
+	switch (b) {
+		case backend::scalar:
+			return true;
+#ifdef XTEA_X86
+		case backend::sse2:
+			return true;
+		case backend::avx2:
+			return hasAvx2();
+#endif
+#ifdef XTEA_NEON
+		case backend::neon:
+			return true;
+#endif
+		default:
+			return false;
+	}
+}
+
+void encrypt(backend b, uint8_t* data, size_t length, const round_keys& k)
+{
+	switch (b) {
+#ifdef XTEA_X86
+		case backend::sse2:
+			return encryptSse2(data, length, k);
+		case backend::avx2:
+			return encryptAvx2(data, length, k);
+#endif
+#ifdef XTEA_NEON
+		case backend::neon:
+			return encryptNeon(data, length, k);
+#endif
+		default:
+			return encryptBlocks(data, length, k);
+	}
+}
+
+void decrypt(backend b, uint8_t* data, size_t length, const round_keys& k)
+{
+	switch (b) {
+#ifdef XTEA_X86
+		case backend::sse2:
+			return decryptSse2(data, length, k);
+		case backend::avx2:
+			return decryptAvx2(data, length, k);
+#endif
+#ifdef XTEA_NEON
+		case backend::neon:
+			return decryptNeon(data, length, k);
+#endif
+		default:
+			return decryptBlocks(data, length, k);
+	}
+}
+
 } // namespace xtea
@@ -10,9 +10,23 @@ using key = std::array<uint32_t, 4>;
 using round_keys = std::array<uint32_t, 64>;
 
 round_keys expand_key(const key& k);
+// use the fastest implementation the cpu supports, picked on first use
 void encrypt(uint8_t* data, size_t length, const round_keys& k);
 void decrypt(uint8_t* data, size_t length, const round_keys& k);
 
+// explicit implementations, for tests and benchmarks
+enum class backend
+{
+	scalar,
+	sse2,
+	avx2,
+	neon,
+};
+
+bool is_supported(backend b);
+void encrypt(backend b, uint8_t* data, size_t length, const round_keys& k);
+void decrypt(backend b, uint8_t* data, size_t length, const round_keys& k);
+
 } // namespace xtea
 
 #endif // FS_XTEA_H